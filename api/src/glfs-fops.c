@@ -246,6 +246,51 @@ out:
 }
 
 
+#ifdef SEEK_DATA
+/* Where the bricks cannot tell, all of the file is data and the only hole
+   is the one at its end, as lseek(2) has it for such filesystems. */
+static off_t
+glfs_seek_data_hole (struct glfs_fd *glfd, off_t offset, int whence)
+{
+	xlator_t       *subvol = NULL;
+	struct stat     sb = {0, };
+	gf_seek_what_t  what = GF_SEEK_DATA;
+	off_t           off = 0;
+	int             ret = -1;
+
+	subvol = glfs_fd_subvol (glfd);
+	if (!subvol) {
+		errno = EIO;
+		return -1;
+	}
+
+	if (whence == SEEK_HOLE)
+		what = GF_SEEK_HOLE;
+
+	ret = syncop_seek (subvol, glfd->fd, offset, what, &off);
+	if (ret == 0) {
+		glfd->offset = off;
+		return off;
+	}
+
+	if (errno == ENXIO)
+		return -1;
+
+	ret = glfs_fstat (glfd, &sb);
+	if (ret)
+		return -1;
+
+	if (offset < 0 || offset >= sb.st_size) {
+		errno = ENXIO;
+		return -1;
+	}
+
+	glfd->offset = (whence == SEEK_DATA) ? offset : sb.st_size;
+	return glfd->offset;
+}
+#endif
+
+
 off_t
 glfs_lseek (struct glfs_fd *glfd, off_t offset, int whence)
 {
@@ -269,6 +314,11 @@ glfs_lseek (struct glfs_fd *glfd, off_t offset, int whence)
 		}
 		glfd->offset = sb.st_size + offset;
 		break;
+#ifdef SEEK_DATA
+	case SEEK_DATA:
+	case SEEK_HOLE:
+		return glfs_seek_data_hole (glfd, offset, whence);
+#endif
 	}
 
 	return glfd->offset;
@@ -362,6 +412,7 @@ struct glfs_io {
 	struct iovec        *iov;
 	int                  count;
 	int                  flags;
+	off_t                len;
 	glfs_io_cbk          fn;
 	void                *data;
 };
@@ -399,6 +450,16 @@ glfs_io_async_task (void *data)
 	case GF_FOP_FTRUNCATE:
 		ret = glfs_ftruncate (gio->glfd, gio->offset);
 		break;
+	case GF_FOP_FALLOCATE:
+		ret = glfs_fallocate (gio->glfd, gio->flags, gio->offset,
+				      gio->len);
+		break;
+	case GF_FOP_DISCARD:
+		ret = glfs_discard (gio->glfd, gio->offset, gio->len);
+		break;
+	case GF_FOP_ZEROFILL:
+		ret = glfs_zerofill (gio->glfd, gio->offset, gio->len);
+		break;
 	case GF_FOP_FSYNC:
 		if (gio->flags)
 			ret = glfs_fdatasync (gio->glfd);
@@ -825,3 +886,127 @@ glfs_ftruncate_async (struct glfs_fd *glfd, off_t offset,
 	return ret;
 }
 
+
+int
+glfs_fallocate (struct glfs_fd *glfd, int keep_size, off_t offset, size_t len)
+{
+	int              ret = -1;
+	xlator_t        *subvol = NULL;
+
+	__glfs_entry_fd (glfd);
+
+	subvol = glfs_fd_subvol (glfd);
+	if (!subvol) {
+		ret = -1;
+		errno = EIO;
+		goto out;
+	}
+
+	ret = syncop_fallocate (subvol, glfd->fd, keep_size, offset, len);
+out:
+	return ret;
+}
+
+
+int
+glfs_discard (struct glfs_fd *glfd, off_t offset, size_t len)
+{
+	int              ret = -1;
+	xlator_t        *subvol = NULL;
+
+	__glfs_entry_fd (glfd);
+
+	subvol = glfs_fd_subvol (glfd);
+	if (!subvol) {
+		ret = -1;
+		errno = EIO;
+		goto out;
+	}
+
+	ret = syncop_discard (subvol, glfd->fd, offset, len);
+out:
+	return ret;
+}
+
+
+int
+glfs_zerofill (struct glfs_fd *glfd, off_t offset, off_t len)
+{
+	int              ret = -1;
+	xlator_t        *subvol = NULL;
+
+	__glfs_entry_fd (glfd);
+
+	subvol = glfs_fd_subvol (glfd);
+	if (!subvol) {
+		ret = -1;
+		errno = EIO;
+		goto out;
+	}
+
+	ret = syncop_zerofill (subvol, glfd->fd, offset, len);
+out:
+	return ret;
+}
+
+
+static int
+glfs_range_async_common (struct glfs_fd *glfd, int op, int flags,
+			 off_t offset, off_t len, glfs_io_cbk fn, void *data)
+{
+	struct glfs_io *gio = NULL;
+	int             ret = 0;
+
+	gio = GF_CALLOC (1, sizeof (*gio), glfs_mt_glfs_io_t);
+	if (!gio) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	gio->op     = op;
+	gio->glfd   = glfd;
+	gio->flags  = flags;
+	gio->offset = offset;
+	gio->len    = len;
+	gio->fn     = fn;
+	gio->data   = data;
+
+	ret = synctask_new (glfs_from_glfd (glfd)->ctx->env,
+			    glfs_io_async_task, glfs_io_async_cbk,
+			    NULL, gio);
+
+	if (ret) {
+		GF_FREE (gio->iov);
+		GF_FREE (gio);
+	}
+
+	return ret;
+}
+
+
+int
+glfs_fallocate_async (struct glfs_fd *glfd, int keep_size, off_t offset,
+		      size_t len, glfs_io_cbk fn, void *data)
+{
+	return glfs_range_async_common (glfd, GF_FOP_FALLOCATE, keep_size,
+					offset, len, fn, data);
+}
+
+
+int
+glfs_discard_async (struct glfs_fd *glfd, off_t offset, size_t len,
+		    glfs_io_cbk fn, void *data)
+{
+	return glfs_range_async_common (glfd, GF_FOP_DISCARD, 0, offset, len,
+					fn, data);
+}
+
+
+int
+glfs_zerofill_async (struct glfs_fd *glfd, off_t offset, off_t len,
+		     glfs_io_cbk fn, void *data)
+{
+	return glfs_range_async_common (glfd, GF_FOP_ZEROFILL, 0, offset, len,
+					fn, data);
+}
+
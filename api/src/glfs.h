@@ -352,6 +352,23 @@ int glfs_ftruncate (glfs_fd_t *fd, off_t length);
 int glfs_ftruncate_async (glfs_fd_t *fd, off_t length, glfs_io_cbk fn,
 			  void *data);
 
+/* glfs_lseek() also takes SEEK_DATA and SEEK_HOLE, and treats the whole
+   file as data where the bricks cannot tell. With fallocate, discard
+   (punch a hole) and zerofill below, sparse images can be copied without
+   reading or writing their holes. */
+
+int glfs_fallocate (glfs_fd_t *fd, int keep_size, off_t offset, size_t len);
+int glfs_fallocate_async (glfs_fd_t *fd, int keep_size, off_t offset,
+			  size_t len, glfs_io_cbk fn, void *data);
+
+int glfs_discard (glfs_fd_t *fd, off_t offset, size_t len);
+int glfs_discard_async (glfs_fd_t *fd, off_t offset, size_t len,
+			glfs_io_cbk fn, void *data);
+
+int glfs_zerofill (glfs_fd_t *fd, off_t offset, off_t len);
+int glfs_zerofill_async (glfs_fd_t *fd, off_t offset, off_t len,
+			 glfs_io_cbk fn, void *data);
+
 int glfs_lstat (glfs_t *fs, const char *path, struct stat *buf);
 int glfs_fstat (glfs_fd_t *fd, struct stat *buf);
 
@@ -3506,6 +3506,9 @@ cmd_profile_volume_brick_out (dict_t *dict, int count, int interval)
         uint64_t                w_count = 0;
         uint64_t                rb_counts[32] = {0};
         uint64_t                wb_counts[32] = {0};
+        uint64_t                fb_counts[32] = {0};
+        uint64_t                fb_window = 0;
+        uint64_t                nr_batched = 0;
         cli_profile_info_t      profile_info[GF_FOP_MAXVALUE] = {{0}};
         char                    output[128] = {0};
         int                     per_line = 0;
@@ -3530,6 +3533,19 @@ cmd_profile_volume_brick_out (dict_t *dict, int count, int interval)
                 ret = dict_get_uint64 (dict, key, &wb_counts[i]);
         }
 
+        for (i = 0; i < 32; i++) {
+                memset (key, 0, sizeof (key));
+                snprintf (key, sizeof (key), "%d-%d-fsync-batch-%d", count,
+                          interval, (1<<i));
+                ret = dict_get_uint64 (dict, key, &fb_counts[i]);
+                nr_batched += fb_counts[i];
+        }
+
+        memset (key, 0, sizeof (key));
+        snprintf (key, sizeof (key), "%d-%d-fsync-batch-window", count,
+                  interval);
+        ret = dict_get_uint64 (dict, key, &fb_window);
+
         for (i = 0; i < GF_FOP_MAXVALUE; i++) {
                 memset (key, 0, sizeof (key));
                 snprintf (key, sizeof (key), "%d-%d-%d-hits", count,
@@ -3631,6 +3647,47 @@ cmd_profile_volume_brick_out (dict_t *dict, int count, int interval)
                 cli_out ("%s", read_blocks);
                 cli_out ("%s", write_blocks);
         }
+
+        if (nr_batched) {
+                memset (output, 0, sizeof (output));
+                memset (read_blocks, 0, sizeof (read_blocks));
+                snprintf (output, sizeof (output), "%14s", "Fsync Batch:");
+                snprintf (read_blocks, sizeof (read_blocks), "%14s",
+                          "No. of Fsyncs:");
+                index = 14;
+                per_line = 0;
+                for (i = 0; i < 32; i++) {
+                        if (fb_counts[i] == 0)
+                                continue;
+                        per_line++;
+                        snprintf (output+index, sizeof (output)-index,
+                                  "%20d+ ", (1<<i));
+                        snprintf (read_blocks+index, sizeof (read_blocks)-index,
+                                  "%21"PRId64" ", fb_counts[i]);
+                        index += 22;
+                        if (per_line == 3) {
+                                cli_out ("%s", output);
+                                cli_out ("%s", read_blocks);
+                                cli_out (" ");
+                                per_line = 0;
+                                memset (output, 0, sizeof (output));
+                                memset (read_blocks, 0, sizeof (read_blocks));
+                                snprintf (output, sizeof (output), "%14s",
+                                          "Fsync Batch:");
+                                snprintf (read_blocks, sizeof (read_blocks),
+                                          "%14s", "No. of Fsyncs:");
+                                index = 14;
+                        }
+                }
+
+                if (per_line != 0) {
+                        cli_out ("%s", output);
+                        cli_out ("%s", read_blocks);
+                }
+                cli_out ("%14s %"PRId64" us", "Avg Window:",
+                         fb_window / nr_batched);
+                cli_out (" ");
+        }
         for (i = 0; i < GF_FOP_MAXVALUE; i++) {
                 if (profile_info[i].fop_hits == 0)
                         continue;
@@ -5591,6 +5648,46 @@ gf_cli_umount (call_frame_t *frame, xlator_t *this, void *data)
         return ret;
 }
 
+/* counters of the last heal crawl of the brick by the self-heal daemon */
+static void
+cmd_heal_progress_out (dict_t *dict, int brick)
+{
+        char            key[256] = {0};
+        char            timestr[32] = {0};
+        uint32_t        start = 0;
+        uint32_t        end = 0;
+        uint64_t        crawled = 0;
+        uint64_t        healed = 0;
+        uint64_t        failed = 0;
+        uint64_t        rate = 0;
+        int             ret = 0;
+
+        snprintf (key, sizeof key, "%d-progress-start", brick);
+        ret = dict_get_uint32 (dict, key, &start);
+        if (ret || !start)
+                return;
+        snprintf (key, sizeof key, "%d-progress-end", brick);
+        ret = dict_get_uint32 (dict, key, &end);
+        snprintf (key, sizeof key, "%d-progress-crawled", brick);
+        ret = dict_get_uint64 (dict, key, &crawled);
+        snprintf (key, sizeof key, "%d-progress-healed", brick);
+        ret = dict_get_uint64 (dict, key, &healed);
+        snprintf (key, sizeof key, "%d-progress-failed", brick);
+        ret = dict_get_uint64 (dict, key, &failed);
+        snprintf (key, sizeof key, "%d-progress-rate", brick);
+        ret = dict_get_uint64 (dict, key, &rate);
+
+        gf_time_fmt (timestr, sizeof timestr, start, gf_timefmt_FT);
+        if (end)
+                cli_out ("Last crawl: started at %s, finished after %u "
+                         "seconds", timestr, end - start);
+        else
+                cli_out ("Crawl in progress since %s", timestr);
+        cli_out ("Entries crawled: %"PRIu64", healed: %"PRIu64", failed: "
+                 "%"PRIu64" (%"PRIu64" per minute)", crawled, healed, failed,
+                 rate);
+}
+
 void
 cmd_heal_volume_brick_out (dict_t *dict, int brick)
 {
@@ -5620,6 +5717,7 @@ cmd_heal_volume_brick_out (dict_t *dict, int brick)
         ret = dict_get_str (dict, key, &status);
         if (status && strlen (status))
                 cli_out ("Status: %s", status);
+        cmd_heal_progress_out (dict, brick);
         for (i = 0; i < num_entries; i++) {
                 snprintf (key, sizeof key, "%d-%"PRIu64, brick, i);
                 ret = dict_get_str (dict, key, &path);
@@ -0,0 +1,71 @@
+#!/bin/sh
+
+# Times the data self-heal of one large file after a brick was down while a
+# small part of the file was rewritten, once with
+# cluster.self-heal-dirty-regions on and once with it off.
+#
+# usage: afr-dirty-heal-bm.sh <volume> <mountpoint> <host:/brick/path> \
+#                             [size-in-MB] [dirty-percent]
+#
+# The volume must be a replica volume mounted at <mountpoint>, the brick is
+# the one taken down during the writes. Run it as root on a server node.
+
+volume=$1
+mount=$2
+brick=$3
+size=${4:-102400}
+percent=${5:-1}
+
+if [ -z "${volume}" -o -z "${mount}" -o -z "${brick}" ]; then
+    echo "usage: $0 <volume> <mountpoint> <host:/brick/path> [size-in-MB] [dirty-percent]"
+    exit 1
+fi
+
+file=${mount}/afr-dirty-heal-bm.$$
+regions=$((size * percent / 100))
+[ ${regions} -lt 1 ] && regions=1
+
+brick_pid ()
+{
+    gluster volume status ${volume} ${brick} | awk '/^Brick/ { print $NF }'
+}
+
+heal_pending ()
+{
+    gluster volume heal ${volume} info | awk '/^Number of entries:/ { n += $NF } END { print n + 0 }'
+}
+
+run ()
+{
+    gluster volume set ${volume} cluster.self-heal-dirty-regions $1 > /dev/null
+    gluster volume set ${volume} cluster.data-self-heal-algorithm diff > /dev/null
+
+    dd if=/dev/urandom of=${file} bs=1M count=${size} 2> /dev/null
+    sync
+
+    kill -KILL $(brick_pid)
+
+    # rewrite ${regions} random 1MB regions while the brick is down
+    for i in $(seq 1 ${regions}); do
+        dd if=/dev/urandom of=${file} bs=1M count=1 conv=notrunc \
+           seek=$(awk -v s=${size} 'BEGIN { srand(); print int(rand() * s) }') \
+           2> /dev/null
+    done
+    sync
+
+    gluster volume start ${volume} force > /dev/null
+    sleep 5
+
+    start=$(date +%s)
+    gluster volume heal ${volume} > /dev/null
+    while [ $(heal_pending) -ne 0 ]; do
+        sleep 1
+    done
+    end=$(date +%s)
+
+    echo "self-heal-dirty-regions $1: ${regions} of ${size} MB dirty, healed in $((end - start)) s"
+    rm -f ${file}
+}
+
+run on
+run off
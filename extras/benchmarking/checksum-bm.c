@@ -0,0 +1,206 @@
+/*
+  Copyright (c) 2012 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/*
+ * checksum-bm: single core throughput of the checksums of rchecksum.
+ *
+ * Checksums a buffer of random data block by block, the way posix_rchecksum
+ * does for self-heal, with the byte loop the weak checksum used to be, the
+ * weak checksum of libglusterfs (vectorized where SSE2 is available), MD5
+ * and the 128 bit MurmurHash3 digest, and prints GB/s for each. The weak
+ * checksums are compared against the byte loop and MurmurHash3 against
+ * reference digests before timing anything.
+ *
+ * gcc -O2 -I../../libglusterfs/src checksum-bm.c \
+ *     ../../libglusterfs/src/checksum.c -lcrypto -o checksum-bm
+ * ./checksum-bm [-b block-size] [-s buffer-size-MB] [-r rounds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "checksum.h"
+
+static double
+now (void)
+{
+        struct timespec ts;
+
+        clock_gettime (CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/* the weak checksum before it was vectorized */
+static uint32_t
+weak_checksum_bytes (unsigned char *buf, size_t len)
+{
+        uint32_t s1 = 0, s2 = 0;
+        size_t   i  = 0;
+
+        for (i = 0; i < len; i++) {
+                s1 += buf[i];
+                s2 += s1;
+        }
+
+        return (s1 & 0xffff) + (s2 << 16);
+}
+
+
+static int
+verify (unsigned char *buf, size_t size)
+{
+        static const struct {
+                const char *data;
+                const char *digest;
+        } vectors[] = {
+                { "", "00000000000000000000000000000000" },
+                { "a", "897859f6655555855a890e51483ab5e6" },
+                { "The quick brown fox jumps over the lazy dog",
+                  "6c1b07bc7bbc4be347939ac4a93c437a" },
+        };
+        unsigned char sum[GF_CHECKSUM_LENGTH];
+        char          hex[2 * GF_CHECKSUM_LENGTH + 1];
+        size_t        len = 0;
+        size_t        off = 0;
+        int           i   = 0;
+        int           j   = 0;
+
+        for (len = 0; len < 300 && len < size; len++)
+                for (off = 0; off < 16 && off + len <= size; off++)
+                        if (gf_rsync_weak_checksum (buf + off, len) !=
+                            weak_checksum_bytes (buf + off, len)) {
+                                fprintf (stderr, "weak checksum mismatch "
+                                         "len=%zu off=%zu\n", len, off);
+                                return -1;
+                        }
+
+        if (gf_rsync_weak_checksum (buf, size) !=
+            weak_checksum_bytes (buf, size)) {
+                fprintf (stderr, "weak checksum mismatch len=%zu\n", size);
+                return -1;
+        }
+
+        for (i = 0; i < sizeof (vectors) / sizeof (vectors[0]); i++) {
+                gf_rsync_fast_checksum ((unsigned char *) vectors[i].data,
+                                        strlen (vectors[i].data), sum);
+                for (j = 0; j < GF_CHECKSUM_LENGTH; j++)
+                        sprintf (hex + 2 * j, "%02x", sum[j]);
+                if (strcmp (hex, vectors[i].digest)) {
+                        fprintf (stderr, "murmur3 of \"%s\": %s, "
+                                 "expected %s\n", vectors[i].data, hex,
+                                 vectors[i].digest);
+                        return -1;
+                }
+        }
+
+        return 0;
+}
+
+
+static volatile uint32_t sink;
+
+static void
+run (const char *name, int type, unsigned char *buf, size_t size,
+     size_t block, int rounds)
+{
+        unsigned char sum[GF_CHECKSUM_LENGTH];
+        double        start = 0;
+        double        secs  = 0;
+        size_t        off   = 0;
+        int           r     = 0;
+
+        start = now ();
+        for (r = 0; r < rounds; r++) {
+                for (off = 0; off + block <= size; off += block) {
+                        switch (type) {
+                        case -2:
+                                sink += weak_checksum_bytes (buf + off, block);
+                                break;
+                        case -1:
+                                sink += gf_rsync_weak_checksum (buf + off,
+                                                                block);
+                                break;
+                        default:
+                                gf_rsync_checksum_by_type (type, buf + off,
+                                                           block, sum);
+                                sink += sum[0];
+                        }
+                }
+        }
+        secs = now () - start;
+
+        printf ("%-16s %8.2f GB/s\n", name,
+                (double) (size / block) * block * rounds / secs / 1e9);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+        unsigned char *buf    = NULL;
+        size_t         block  = 131072;
+        size_t         size   = 64;
+        size_t         i      = 0;
+        int            rounds = 8;
+        int            opt    = 0;
+
+        while ((opt = getopt (argc, argv, "b:s:r:")) != -1) {
+                switch (opt) {
+                case 'b':
+                        block = strtoul (optarg, NULL, 0);
+                        break;
+                case 's':
+                        size = strtoul (optarg, NULL, 0);
+                        break;
+                case 'r':
+                        rounds = atoi (optarg);
+                        break;
+                default:
+                        goto usage;
+                }
+        }
+
+        size *= 1024 * 1024;
+        if (!block || block > size || rounds < 1)
+                goto usage;
+
+        buf = malloc (size);
+        if (!buf) {
+                perror ("malloc");
+                return 1;
+        }
+
+        srandom (time (NULL));
+        for (i = 0; i < size; i++)
+                buf[i] = random ();
+
+        if (verify (buf, size))
+                return 1;
+
+        printf ("block %zu bytes, %zu MB x %d rounds, one core\n",
+                block, size / (1024 * 1024), rounds);
+        run ("weak (bytes)", -2, buf, size, block, rounds);
+        run ("weak", -1, buf, size, block, rounds);
+        run ("md5", GF_CHECKSUM_MD5, buf, size, block, rounds);
+        run ("murmur3", GF_CHECKSUM_MURMUR3, buf, size, block, rounds);
+
+        free (buf);
+        return 0;
+
+usage:
+        fprintf (stderr, "usage: %s [-b block-size] [-s buffer-size-MB] "
+                 "[-r rounds]\n", argv[0]);
+        return 1;
+}
@@ -0,0 +1,195 @@
+/*
+  Copyright (c) 2012 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/*
+ * dht-layout-bm: microbenchmark of the name to subvolume lookup of
+ * cluster/distribute on synthetic layouts.
+ *
+ * For layouts of 10 to 1000 subvolumes, split the hash space the way a
+ * fresh directory gets it, then time the Davies-Meyer hash alone, the hash
+ * followed by the linear range scan and the hash followed by bisection.
+ *
+ * gcc -O2 dht-layout-bm.c -lglusterfs -o dht-layout-bm
+ * ./dht-layout-bm [-n names] [-r rounds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+/* libglusterfs */
+uint32_t gf_dm_hashfn (const char *msg, int len);
+
+struct range {
+        uint32_t  start;
+        uint32_t  stop;
+        int       subvol;
+};
+
+static int subvol_counts[] = {10, 20, 50, 100, 200, 500, 1000};
+
+
+static double
+now (void)
+{
+        struct timespec ts;
+
+        clock_gettime (CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void
+layout_fill (struct range *list, int cnt)
+{
+        uint32_t  chunk = 0xffffffff / cnt;
+        uint32_t  start = 0;
+        int       i     = 0;
+
+        for (i = 0; i < cnt; i++) {
+                list[i].start  = start;
+                list[i].stop   = (i == cnt - 1) ? 0xffffffff
+                                                : start + chunk - 1;
+                list[i].subvol = i;
+                start += chunk;
+        }
+}
+
+
+static int
+search_linear (struct range *list, int cnt, uint32_t hash)
+{
+        int i = 0;
+
+        for (i = 0; i < cnt; i++)
+                if (list[i].start <= hash && list[i].stop >= hash)
+                        return list[i].subvol;
+
+        return -1;
+}
+
+
+static int
+search_bisect (struct range *list, int cnt, uint32_t hash)
+{
+        int lo  = 0;
+        int hi  = cnt - 1;
+        int mid = 0;
+
+        while (lo <= hi) {
+                mid = lo + (hi - lo) / 2;
+                if (hash < list[mid].start)
+                        hi = mid - 1;
+                else if (hash > list[mid].stop)
+                        lo = mid + 1;
+                else
+                        return list[mid].subvol;
+        }
+
+        return -1;
+}
+
+
+int
+main (int argc, char *argv[])
+{
+        struct range  *list    = NULL;
+        char         **names   = NULL;
+        int           *lens    = NULL;
+        uint32_t      *hashes  = NULL;
+        int            count   = 100000;
+        int            rounds  = 10;
+        int            opt     = 0;
+        int            i       = 0;
+        int            r       = 0;
+        int            s       = 0;
+        int            cnt     = 0;
+        long           check   = 0;
+        double         t       = 0;
+        double         hash_ns = 0;
+        double         lin_ns  = 0;
+        double         bis_ns  = 0;
+        char           buf[64];
+
+        while ((opt = getopt (argc, argv, "n:r:")) != -1) {
+                switch (opt) {
+                case 'n':
+                        count = atoi (optarg);
+                        break;
+                case 'r':
+                        rounds = atoi (optarg);
+                        break;
+                default:
+                        fprintf (stderr, "usage: %s [-n names] [-r rounds]\n",
+                                 argv[0]);
+                        return 1;
+                }
+        }
+
+        if (count <= 0 || rounds <= 0)
+                return 1;
+
+        names  = calloc (count, sizeof (*names));
+        lens   = calloc (count, sizeof (*lens));
+        hashes = calloc (count, sizeof (*hashes));
+        list   = calloc (1000, sizeof (*list));
+        if (!names || !lens || !hashes || !list)
+                return 1;
+
+        for (i = 0; i < count; i++) {
+                snprintf (buf, sizeof (buf), "file-%08d.%s", rand (),
+                          (i % 4) ? "dat" : "log");
+                names[i] = strdup (buf);
+                lens[i]  = strlen (buf);
+        }
+
+        t = now ();
+        for (r = 0; r < rounds; r++)
+                for (i = 0; i < count; i++)
+                        hashes[i] = gf_dm_hashfn (names[i], lens[i]);
+        hash_ns = (now () - t) * 1e9 / ((double) rounds * count);
+
+        printf ("%8s %12s %12s %12s %10s\n", "subvols", "hash ns",
+                "linear ns", "bisect ns", "speedup");
+
+        for (s = 0; s < sizeof (subvol_counts) / sizeof (int); s++) {
+                cnt = subvol_counts[s];
+                layout_fill (list, cnt);
+
+                t = now ();
+                for (r = 0; r < rounds; r++)
+                        for (i = 0; i < count; i++)
+                                check += search_linear (list, cnt,
+                                                        hashes[i]);
+                lin_ns = (now () - t) * 1e9 / ((double) rounds * count);
+
+                t = now ();
+                for (r = 0; r < rounds; r++)
+                        for (i = 0; i < count; i++)
+                                check -= search_bisect (list, cnt,
+                                                        hashes[i]);
+                bis_ns = (now () - t) * 1e9 / ((double) rounds * count);
+
+                printf ("%8d %12.1f %12.1f %12.1f %9.1fx\n", cnt, hash_ns,
+                        hash_ns + lin_ns, hash_ns + bis_ns,
+                        (hash_ns + lin_ns) / (hash_ns + bis_ns));
+        }
+
+        /* both searches must have found the same subvolumes */
+        if (check) {
+                fprintf (stderr, "linear and bisect disagree\n");
+                return 1;
+        }
+
+        return 0;
+}
@@ -23,10 +23,13 @@
 #include <libgen.h>
 #include <errno.h>
 #include <sys/time.h>
+#include <dirent.h>
 
 struct state {
         char need_op_write:1;
         char need_op_read:1;
+        char need_op_listread:1;
+        char need_op_create:1;
 
         char need_iface_fileio:1;
         char need_iface_xattr:1;
@@ -35,6 +38,7 @@ struct state {
 
         char prefix[512];
         long int count;
+        long int repeat;
 
         size_t block_size;
 
@@ -76,9 +80,11 @@ measure (int (*func)(struct state *state),
 
         tv_difference (&tv_stop, &tv_start, &tv_diff);
 
-        fprintf (stdout, "%s: count=%ld, size=%ld, time=%ld:%ld\n",
-                 func_name, count, state->io_size,
-                 tv_diff.tv_sec, tv_diff.tv_usec);
+        fprintf (stdout, "%s: count=%ld, size=%ld, time=%ld:%ld, "
+                 "avg_usec=%ld\n", func_name, count, state->io_size,
+                 tv_diff.tv_sec, tv_diff.tv_usec,
+                 count ? (tv_diff.tv_sec * 1000000 + tv_diff.tv_usec) / count
+                 : 0);
 }
 
 
@@ -100,6 +106,14 @@ parse_opts (int key, char *arg,
                 } else if (strcasecmp (arg, "both") == 0) {
                         state->need_op_write = 1;
                         state->need_op_read = 1;
+                } else if (strcasecmp (arg, "listread") == 0) {
+                        state->need_op_write = 1;
+                        state->need_op_read = 0;
+                        state->need_op_listread = 1;
+                } else if (strcasecmp (arg, "create") == 0) {
+                        state->need_op_write = 0;
+                        state->need_op_read = 0;
+                        state->need_op_create = 1;
                 } else {
                         fprintf (stderr, "unknown op: %s\n", arg);
                         return -1;
@@ -147,6 +161,16 @@ parse_opts (int key, char *arg,
                 state->count = count;
         }
         break;
+        case 'r':
+        {
+                long repeat = atol (arg);
+                if (!repeat) {
+                        fprintf (stderr, "incorrect repeat: %s\n", arg);
+                        return -1;
+                }
+                state->repeat = repeat;
+        }
+        break;
         case ARGP_KEY_NO_ARGS:
                 break;
         case ARGP_KEY_ARG:
@@ -189,6 +213,30 @@ do_mode_posix_iface_fileio_write (struct state *state)
 }
 
 
+/* empty files, exclusively created: the rate of the create path alone */
+int
+do_mode_posix_iface_fileio_create (struct state *state)
+{
+        long int i;
+
+        for (i=0; i<state->count; i++) {
+                int fd = -1;
+                char filename[512];
+
+                sprintf (filename, "%s.%06ld", state->prefix, i);
+
+                fd = open (filename, O_CREAT|O_EXCL|O_WRONLY, 00600);
+                if (fd == -1) {
+                        fprintf (stderr, "open(%s) => %s\n", filename, strerror (errno));
+                        break;
+                }
+                close (fd);
+        }
+
+        return i;
+}
+
+
 int
 do_mode_posix_iface_fileio_read (struct state *state)
 {
@@ -221,14 +269,86 @@ do_mode_posix_iface_fileio_read (struct state *state)
 }
 
 
+/* read the files in the order the directory lists them, the way an
+ * application walking a tree of small files does */
+int
+do_mode_posix_iface_fileio_listread (struct state *state)
+{
+        long int i = 0;
+        int ret = -1;
+        char block[state->block_size];
+        char *dname = NULL, *dirc = NULL;
+        char *bname = NULL, *basec = NULL;
+        size_t blen = 0;
+        DIR *dir = NULL;
+        struct dirent *entry = NULL;
+
+        dirc = strdup (state->prefix);
+        basec = strdup (state->prefix);
+        dname = dirname (dirc);
+        bname = basename (basec);
+        blen = strlen (bname);
+
+        dir = opendir (dname);
+        if (!dir) {
+                fprintf (stderr, "opendir(%s) => %s\n", dname, strerror (errno));
+                goto out;
+        }
+
+        while ((entry = readdir (dir)) != NULL) {
+                int fd = -1;
+                char filename[1024];
+
+                if (strncmp (entry->d_name, bname, blen) != 0)
+                        continue;
+
+                snprintf (filename, sizeof (filename), "%s/%s", dname,
+                          entry->d_name);
+
+                fd = open (filename, O_RDONLY);
+                if (fd == -1) {
+                        fprintf (stderr, "open(%s) => %s\n", filename, strerror (errno));
+                        break;
+                }
+                ret = read (fd, block, state->block_size);
+                if (ret == -1) {
+                        fprintf (stderr, "read(%s) => %d/%s\n", filename, ret, strerror (errno));
+                        close (fd);
+                        break;
+                }
+                close (fd);
+                state->io_size += ret;
+                i++;
+        }
+
+        closedir (dir);
+out:
+        free (dirc);
+        free (basec);
+
+        return i;
+}
+
+
 int
 do_mode_posix_iface_fileio (struct state *state)
 {
+        long int pass;
+
+        if (state->need_op_create)
+                MEASURE (do_mode_posix_iface_fileio_create, state);
+
         if (state->need_op_write)
                 MEASURE (do_mode_posix_iface_fileio_write, state);
 
+        /* the first pass runs against a cold cache, later ones warm */
         if (state->need_op_read)
-                MEASURE (do_mode_posix_iface_fileio_read, state);
+                for (pass = 0; pass < state->repeat; pass++)
+                        MEASURE (do_mode_posix_iface_fileio_read, state);
+
+        if (state->need_op_listread)
+                for (pass = 0; pass < state->repeat; pass++)
+                        MEASURE (do_mode_posix_iface_fileio_listread, state);
 
         return 0;
 }
@@ -339,7 +459,7 @@ do_actions (struct state *state)
 
 static struct argp_option options[] = {
         {"op", 'o', "OPERATIONS", 0,
-         "WRITE|READ|BOTH - defaults to BOTH"},
+         "WRITE|READ|BOTH|LISTREAD|CREATE - defaults to BOTH"},
         {"iface", 'i', "INTERFACE", 0,
          "FILEIO|XATTR|BOTH - defaults to FILEIO"},
         {"block", 'b', "BLOCKSIZE", 0,
@@ -350,6 +470,8 @@ static struct argp_option options[] = {
          "filename prefix"},
         {"count", 'c', "COUNT", 0,
          "number of files"},
+        {"repeat", 'r', "REPEAT", 0,
+         "number of READ and LISTREAD passes - defaults to 1"},
         {0, 0, 0, 0, 0}
 };
 
@@ -377,6 +499,7 @@ main (int argc, char *argv[])
 
         strcpy (state.prefix, "tmpfile");
         state.count = 1048576;
+        state.repeat = 1;
 
         if (argp_parse (&argp, argc, argv, 0, 0, &state) != 0) {
                 fprintf (stderr, "argp_parse() failed\n");
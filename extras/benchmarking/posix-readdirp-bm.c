@@ -0,0 +1,300 @@
+/*
+  Copyright (c) 2012 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/*
+ * posix-readdirp-bm: brick-side benchmark of the per-entry work of
+ * storage/posix readdirp.
+ *
+ * Creates a directory of files carrying a gfid xattr and a few more xattrs,
+ * then lists it in readdirp sized batches and fills every entry the way
+ * posix_readdirp_fill does, once by absolute path (lstat and lgetxattr per
+ * entry) and once relative to the directory fd (fstatat, then one openat
+ * and fgetxattr on the entry), the latter also split across worker threads.
+ * Each pass is run without and with the xattr fill and reports entries per
+ * second.  Drop the caches between runs for cold numbers.
+ *
+ * gcc -O2 posix-readdirp-bm.c -lpthread -o posix-readdirp-bm
+ * ./posix-readdirp-bm [-n entries] [-x xattrs] [-b batch] [-t threads] dir
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+
+#define GFID_KEY   "user.bm.gfid"
+#define XATTR_FMT  "user.bm.xattr%d"
+
+struct batch {
+        int          dirfd;
+        const char  *dirpath;
+        char       **names;
+        int          start;
+        int          end;
+        int          nxattrs;
+        int          at;
+};
+
+static int nxattrs_max = 4;
+
+
+static double
+now (void)
+{
+        struct timespec ts;
+
+        clock_gettime (CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void
+populate (const char *dir, int entries)
+{
+        char     path[4096];
+        char     key[64];
+        char     value[32];
+        int      fd = -1;
+        int      i  = 0;
+        int      j  = 0;
+
+        mkdir (dir, 0755);
+
+        for (i = 0; i < entries; i++) {
+                snprintf (path, sizeof (path), "%s/file.%08d", dir, i);
+                fd = open (path, O_CREAT | O_WRONLY, 0644);
+                if (fd == -1) {
+                        perror (path);
+                        exit (1);
+                }
+
+                memset (value, i & 0xff, 16);
+                if (fsetxattr (fd, GFID_KEY, value, 16, 0) == -1) {
+                        perror ("fsetxattr");
+                        exit (1);
+                }
+
+                for (j = 0; j < nxattrs_max; j++) {
+                        snprintf (key, sizeof (key), XATTR_FMT, j);
+                        fsetxattr (fd, key, value, 12, 0);
+                }
+
+                close (fd);
+        }
+}
+
+
+static void
+fill_path (struct batch *b, int i, char *path)
+{
+        struct stat  st;
+        char         key[64];
+        char         value[64];
+        int          j = 0;
+
+        sprintf (path, "%s/%s", b->dirpath, b->names[i]);
+
+        if (lstat (path, &st) == -1)
+                return;
+
+        lgetxattr (path, GFID_KEY, value, sizeof (value));
+
+        for (j = 0; j < b->nxattrs; j++) {
+                snprintf (key, sizeof (key), XATTR_FMT, j);
+                /* size probe, then fetch, as _posix_xattr_get_set does */
+                if (lgetxattr (path, key, NULL, 0) > 0)
+                        lgetxattr (path, key, value, sizeof (value));
+        }
+}
+
+
+static void
+fill_at (struct batch *b, int i)
+{
+        struct stat  st;
+        char         key[64];
+        char         value[64];
+        int          fd = -1;
+        int          j  = 0;
+
+        if (fstatat (b->dirfd, b->names[i], &st, AT_SYMLINK_NOFOLLOW) == -1)
+                return;
+
+        fd = openat (b->dirfd, b->names[i], O_RDONLY | O_NOFOLLOW | O_NONBLOCK);
+        if (fd == -1)
+                return;
+
+        fgetxattr (fd, GFID_KEY, value, sizeof (value));
+
+        for (j = 0; j < b->nxattrs; j++) {
+                snprintf (key, sizeof (key), XATTR_FMT, j);
+                if (fgetxattr (fd, key, NULL, 0) > 0)
+                        fgetxattr (fd, key, value, sizeof (value));
+        }
+
+        close (fd);
+}
+
+
+static void *
+fill_slice (void *data)
+{
+        struct batch *b = data;
+        char          path[4096];
+        int           i = 0;
+
+        for (i = b->start; i < b->end; i++) {
+                if (b->at)
+                        fill_at (b, i);
+                else
+                        fill_path (b, i, path);
+        }
+
+        return NULL;
+}
+
+
+static double
+run (const char *dir, int batch, int threads, int nxattrs, int at,
+     int *entries)
+{
+        struct batch    b[threads];
+        pthread_t       tid[threads];
+        char          **names = NULL;
+        struct dirent  *d     = NULL;
+        DIR            *dp    = NULL;
+        double          start = 0;
+        int             count = 0;
+        int             total = 0;
+        int             i     = 0;
+
+        names = calloc (batch, sizeof (*names));
+        dp = opendir (dir);
+        if (!names || !dp) {
+                perror (dir);
+                exit (1);
+        }
+
+        start = now ();
+
+        for (;;) {
+                count = 0;
+                while (count < batch && (d = readdir (dp))) {
+                        if (d->d_name[0] == '.')
+                                continue;
+                        /* readdir reuses its buffer, keep our own copy */
+                        names[count++] = strdup (d->d_name);
+                }
+                if (!count)
+                        break;
+
+                for (i = 0; i < threads; i++) {
+                        b[i].dirfd   = dirfd (dp);
+                        b[i].dirpath = dir;
+                        b[i].names   = names;
+                        b[i].start   = (count * i) / threads;
+                        b[i].end     = (count * (i + 1)) / threads;
+                        b[i].nxattrs = nxattrs;
+                        b[i].at      = at;
+                }
+
+                for (i = 1; i < threads; i++)
+                        pthread_create (&tid[i], NULL, fill_slice, &b[i]);
+                fill_slice (&b[0]);
+                for (i = 1; i < threads; i++)
+                        pthread_join (tid[i], NULL);
+
+                for (i = 0; i < count; i++)
+                        free (names[i]);
+                total += count;
+        }
+
+        closedir (dp);
+        free (names);
+
+        *entries = total;
+        return now () - start;
+}
+
+
+int
+main (int argc, char *argv[])
+{
+        const char *dir     = NULL;
+        double      elapsed = 0;
+        int         entries = 100000;
+        int         batch   = 512;
+        int         threads = 4;
+        int         total   = 0;
+        int         opt     = 0;
+        int         x       = 0;
+
+        while ((opt = getopt (argc, argv, "n:x:b:t:")) != -1) {
+                switch (opt) {
+                case 'n':
+                        entries = atoi (optarg);
+                        break;
+                case 'x':
+                        nxattrs_max = atoi (optarg);
+                        break;
+                case 'b':
+                        batch = atoi (optarg);
+                        break;
+                case 't':
+                        threads = atoi (optarg);
+                        break;
+                default:
+                        goto usage;
+                }
+        }
+
+        if (optind >= argc || entries <= 0 || batch <= 0 || threads <= 0)
+                goto usage;
+
+        dir = argv[optind];
+        populate (dir, entries);
+
+        printf ("%-8s %-8s %-8s %12s %14s\n",
+                "fill", "threads", "xattrs", "seconds", "entries/sec");
+
+        for (x = 0; x <= nxattrs_max; x += nxattrs_max) {
+                elapsed = run (dir, batch, 1, x, 0, &total);
+                printf ("%-8s %-8d %-8d %12.3f %14.0f\n",
+                        "path", 1, x, elapsed, total / elapsed);
+
+                elapsed = run (dir, batch, 1, x, 1, &total);
+                printf ("%-8s %-8d %-8d %12.3f %14.0f\n",
+                        "at", 1, x, elapsed, total / elapsed);
+
+                if (threads > 1) {
+                        elapsed = run (dir, batch, threads, x, 1, &total);
+                        printf ("%-8s %-8d %-8d %12.3f %14.0f\n",
+                                "at", threads, x, elapsed, total / elapsed);
+                }
+
+                if (!nxattrs_max)
+                        break;
+        }
+
+        return 0;
+
+usage:
+        fprintf (stderr, "usage: %s [-n entries] [-x xattrs] [-b batch] "
+                 "[-t threads] dir\n", argv[0]);
+        return 1;
+}
@@ -0,0 +1,384 @@
+/*
+  Copyright (c) 2012 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/*
+ * dht-layout-sim.c
+ *
+ * Simulates how cluster/distribute spreads files over bricks of different
+ * sizes, with the equal hash ranges it gives by default and with the ranges
+ * weighted by brick size (cluster.weighted-rebalance, optionally
+ * cluster.weighted-rebalance-latency), before a fix-layout is run.
+ *
+ * A synthetic data set of directories and files is hashed the way DHT does
+ * (Davies-Meyer hash, per-directory rotation of the ranges) and placed on
+ * the bricks. The program prints, per brick, its share of the hash space
+ * and how full it would end up under both layouts, and how much of the data
+ * a fix-layout plus rebalance would move from the current layout to the
+ * new one.
+ *
+ * gcc -O2 -o dht-layout-sim dht-layout-sim.c -lglusterfs -lm
+ *
+ * ./dht-layout-sim [-w] [-l] [-c current] [-d dirs] [-f files] [-s size] \
+ *                  [-g size] size[:used[:latency-ms]] ...
+ *
+ *   -w          new layout weighted by brick size (default: equal)
+ *   -l          weight by latency too (implies -w)
+ *   -c N        only the first N bricks are in the current layout, the
+ *               others were just added (default: all)
+ *   -d N        directories in the data set (default 100)
+ *   -f N        files per directory (default 1000)
+ *   -s SIZE     average file size (default 1M)
+ *   -g SIZE     new data the data set stands for when projecting how full
+ *               the bricks get (default: half of the free space)
+ *
+ * Sizes take K, M, G, T and P suffixes (powers of 1024). For example, the
+ * effect of weighting on three 4TB bricks at 80% and two new 12TB bricks:
+ *
+ * ./dht-layout-sim -w -c 3 4T:3.2T 4T:3.2T 4T:3.2T 12T 12T
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#define MAX_BRICKS 1024
+
+/* libglusterfs */
+uint32_t gf_dm_hashfn (const char *msg, int len);
+
+struct brick {
+        uint64_t  size;
+        uint64_t  used;
+        double    latency;
+        uint64_t  weight;
+
+        /* simulated placement */
+        uint64_t  equal_bytes;
+        uint64_t  weighted_bytes;
+};
+
+struct range {
+        uint32_t  start;
+        uint32_t  stop;
+};
+
+static struct brick bricks[MAX_BRICKS];
+static int          brick_cnt;
+
+
+static uint64_t
+parse_size (const char *str)
+{
+        char      *end  = NULL;
+        double     val  = 0;
+        uint64_t   mult = 1;
+
+        val = strtod (str, &end);
+        switch (*end) {
+        case 'P': case 'p':
+                mult <<= 10;
+        case 'T': case 't':
+                mult <<= 10;
+        case 'G': case 'g':
+                mult <<= 10;
+        case 'M': case 'm':
+                mult <<= 10;
+        case 'K': case 'k':
+                mult <<= 10;
+        }
+
+        return (uint64_t) (val * mult);
+}
+
+
+static void
+parse_brick (const char *spec, struct brick *brick)
+{
+        const char *p = NULL;
+
+        brick->size = parse_size (spec);
+
+        p = strchr (spec, ':');
+        if (!p)
+                return;
+        brick->used = parse_size (p + 1);
+
+        p = strchr (p + 1, ':');
+        if (!p)
+                return;
+        brick->latency = strtod (p + 1, NULL);
+}
+
+
+/* the weight dht_subvol_weight () would give: size in MB, times the
+   latency of the fastest brick over this one's, no less than a quarter */
+static void
+compute_weights (int use_latency)
+{
+        double  fastest = 0;
+        double  factor  = 0;
+        int     i       = 0;
+
+        for (i = 0; i < brick_cnt; i++)
+                if (bricks[i].latency > 0 &&
+                    (!fastest || bricks[i].latency < fastest))
+                        fastest = bricks[i].latency;
+
+        for (i = 0; i < brick_cnt; i++) {
+                bricks[i].weight = bricks[i].size >> 20;
+                if (!bricks[i].weight)
+                        bricks[i].weight = 1;
+
+                if (!use_latency || !fastest || bricks[i].latency <= 0)
+                        continue;
+
+                factor = fastest / bricks[i].latency;
+                if (factor < 0.25)
+                        factor = 0.25;
+                bricks[i].weight = (uint64_t) (bricks[i].weight * factor);
+                if (!bricks[i].weight)
+                        bricks[i].weight = 1;
+        }
+}
+
+
+/* ranges of the first @cnt bricks for a directory whose ranges start at
+   brick @rot, as dht_selfheal_layout_new_directory () hands them out */
+static void
+layout_build (struct range *list, int cnt, int rot, int weighted)
+{
+        uint64_t  total = 0;
+        uint64_t  sofar = 0;
+        uint32_t  chunk = 0;
+        uint32_t  start = 0;
+        uint32_t  stop  = 0;
+        int       i     = 0;
+        int       k     = 0;
+
+        if (!weighted) {
+                chunk = 0xffffffff / cnt;
+                for (k = 0; k < cnt; k++) {
+                        i = (rot + k) % cnt;
+                        list[i].start = start;
+                        list[i].stop  = (k == cnt - 1) ? 0xffffffff
+                                                       : start + chunk - 1;
+                        start += chunk;
+                }
+                return;
+        }
+
+        for (i = 0; i < cnt; i++)
+                total += bricks[i].weight;
+
+        for (k = 0; k < cnt; k++) {
+                i = (rot + k) % cnt;
+                sofar += bricks[i].weight;
+                if (k == cnt - 1)
+                        stop = 0xffffffff;
+                else
+                        stop = (uint32_t) (((double) 0xffffffff) * sofar
+                                           / total);
+                if (stop < start)
+                        stop = start;
+
+                list[i].start = start;
+                list[i].stop  = stop;
+                start = stop + 1;
+        }
+}
+
+
+static int
+layout_search (struct range *list, int cnt, uint32_t hash)
+{
+        int i = 0;
+
+        for (i = 0; i < cnt; i++)
+                if (list[i].start <= hash && list[i].stop >= hash)
+                        return i;
+
+        return 0;
+}
+
+
+static double
+fill (double used, uint64_t size)
+{
+        return size ? (100.0 * used / size) : 0;
+}
+
+
+static void
+usage (const char *prog)
+{
+        fprintf (stderr, "usage: %s [-w] [-l] [-c current] [-d dirs] "
+                 "[-f files] [-s size] [-g size] size[:used[:latency-ms]] "
+                 "...\n", prog);
+        exit (1);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+        struct range  equal[MAX_BRICKS];
+        struct range  weighted[MAX_BRICKS];
+        struct range  current[MAX_BRICKS];
+        char          name[256];
+        int           weigh       = 0;
+        int           use_latency = 0;
+        int           cur_cnt     = 0;
+        int           dirs        = 100;
+        int           files       = 1000;
+        uint64_t      avg         = 1 << 20;
+        uint64_t      total_bytes = 0;
+        uint64_t      total_used  = 0;
+        uint64_t      total_free  = 0;
+        uint64_t      grow        = 0;
+        double        scale       = 0;
+        uint64_t      moved_bytes = 0;
+        uint64_t      moved_files = 0;
+        uint64_t      size        = 0;
+        uint64_t      hash_total  = 0;
+        uint32_t      hash        = 0;
+        int           opt         = 0;
+        int           d           = 0;
+        int           f           = 0;
+        int           i           = 0;
+        int           rot         = 0;
+        int           from        = 0;
+        int           to          = 0;
+
+        while ((opt = getopt (argc, argv, "wlc:d:f:s:g:")) != -1) {
+                switch (opt) {
+                case 'w':
+                        weigh = 1;
+                        break;
+                case 'l':
+                        weigh = use_latency = 1;
+                        break;
+                case 'c':
+                        cur_cnt = atoi (optarg);
+                        break;
+                case 'd':
+                        dirs = atoi (optarg);
+                        break;
+                case 'f':
+                        files = atoi (optarg);
+                        break;
+                case 's':
+                        avg = parse_size (optarg);
+                        break;
+                case 'g':
+                        grow = parse_size (optarg);
+                        break;
+                default:
+                        usage (argv[0]);
+                }
+        }
+
+        for (; optind < argc && brick_cnt < MAX_BRICKS; optind++)
+                parse_brick (argv[optind], &bricks[brick_cnt++]);
+
+        if (!brick_cnt || dirs <= 0 || files <= 0 || !avg)
+                usage (argv[0]);
+
+        if (cur_cnt <= 0 || cur_cnt > brick_cnt)
+                cur_cnt = brick_cnt;
+
+        compute_weights (use_latency);
+        srandom (0);
+
+        for (d = 0; d < dirs; d++) {
+                snprintf (name, sizeof (name), "/dir%d", d);
+                hash = gf_dm_hashfn (name, strlen (name));
+
+                /* the current layout was built when only the first
+                   cur_cnt bricks existed, always with equal ranges */
+                layout_build (current, cur_cnt, hash % cur_cnt, 0);
+                rot = hash % brick_cnt;
+                layout_build (equal, brick_cnt, rot, 0);
+                layout_build (weighted, brick_cnt, rot, 1);
+
+                for (f = 0; f < files; f++) {
+                        snprintf (name, sizeof (name), "file-%d", f);
+                        hash = gf_dm_hashfn (name, strlen (name));
+
+                        /* exponentially distributed sizes */
+                        size = (uint64_t) (-log ((random () + 1.0) /
+                                                 (RAND_MAX + 2.0)) * avg);
+                        total_bytes += size;
+
+                        i = layout_search (equal, brick_cnt, hash);
+                        bricks[i].equal_bytes += size;
+                        i = layout_search (weighted, brick_cnt, hash);
+                        bricks[i].weighted_bytes += size;
+
+                        from = layout_search (current, cur_cnt, hash);
+                        to = weigh ? i : layout_search (equal, brick_cnt,
+                                                        hash);
+                        if (from != to) {
+                                moved_files++;
+                                moved_bytes += size;
+                        }
+                }
+        }
+
+        for (i = 0; i < brick_cnt; i++) {
+                total_used += bricks[i].used;
+                hash_total += bricks[i].weight;
+                if (bricks[i].size > bricks[i].used)
+                        total_free += bricks[i].size - bricks[i].used;
+        }
+
+        if (!grow)
+                grow = total_free / 2;
+        scale = (double) grow / total_bytes;
+
+        printf ("data set: %d directories x %d files, %.1f GB, projected "
+                "as %.1f GB of new data\n\n", dirs, files,
+                total_bytes / 1073741824.0, grow / 1073741824.0);
+
+        printf ("%5s %12s %8s %14s %14s %14s %14s\n", "brick", "size (GB)",
+                "used %", "equal range %", "equal fill %", "weight range %",
+                "weight fill %");
+        for (i = 0; i < brick_cnt; i++) {
+                /* the data set lands on top of what is already used */
+                printf ("%5d %12.1f %8.1f %14.2f %14.1f %14.2f %14.1f\n", i,
+                        bricks[i].size / 1073741824.0,
+                        fill (bricks[i].used, bricks[i].size),
+                        100.0 / brick_cnt,
+                        fill (bricks[i].used + bricks[i].equal_bytes * scale,
+                              bricks[i].size),
+                        100.0 * bricks[i].weight / hash_total,
+                        fill (bricks[i].used +
+                              bricks[i].weighted_bytes * scale,
+                              bricks[i].size));
+        }
+
+        printf ("\nfix-layout from %s over %d bricks to %s over %d bricks:\n",
+                "equal ranges", cur_cnt, weigh ? "weighted ranges" :
+                "equal ranges", brick_cnt);
+        printf ("  %"PRIu64" of %d files (%.1f%%) change brick, %.1f GB of "
+                "the data set\n", moved_files, dirs * files,
+                100.0 * moved_files / ((uint64_t) dirs * files),
+                moved_bytes / 1073741824.0);
+        if (total_used)
+                printf ("  about %.1f GB of the %.1f GB already used would be "
+                        "migrated\n", total_used * ((double) moved_bytes /
+                                                    total_bytes) /
+                        1073741824.0, total_used / 1073741824.0);
+
+        return 0;
+}
@@ -27,6 +27,7 @@ typedef struct {
 	glusterfs_fop_t fop;
         struct mem_pool *stub_mem_pool; /* pointer to stub mempool in ctx_t */
         dict_t *xdata;                  /* common accross all the fops */
+        struct timeval queued;          /* when a scheduler queued it */
 
 	union {
 		/* lookup */
@@ -585,6 +586,66 @@ typedef struct {
                         struct iatt statpost;
                 } fsetattr_cbk;
 
+                /* fallocate */
+                struct {
+                        fop_fallocate_t fn;
+                        fd_t *fd;
+                        int32_t keep_size;
+                        off_t offset;
+                        size_t len;
+                } fallocate;
+                struct {
+                        fop_fallocate_cbk_t fn;
+                        int32_t op_ret;
+                        int32_t op_errno;
+                        struct iatt prebuf;
+                        struct iatt postbuf;
+                } fallocate_cbk;
+
+                /* discard */
+                struct {
+                        fop_discard_t fn;
+                        fd_t *fd;
+                        off_t offset;
+                        size_t len;
+                } discard;
+                struct {
+                        fop_discard_cbk_t fn;
+                        int32_t op_ret;
+                        int32_t op_errno;
+                        struct iatt prebuf;
+                        struct iatt postbuf;
+                } discard_cbk;
+
+                /* zerofill */
+                struct {
+                        fop_zerofill_t fn;
+                        fd_t *fd;
+                        off_t offset;
+                        off_t len;
+                } zerofill;
+                struct {
+                        fop_zerofill_cbk_t fn;
+                        int32_t op_ret;
+                        int32_t op_errno;
+                        struct iatt prebuf;
+                        struct iatt postbuf;
+                } zerofill_cbk;
+
+                /* seek */
+                struct {
+                        fop_seek_t fn;
+                        fd_t *fd;
+                        off_t offset;
+                        gf_seek_what_t what;
+                } seek;
+                struct {
+                        fop_seek_cbk_t fn;
+                        int32_t op_ret;
+                        int32_t op_errno;
+                        off_t offset;
+                } seek_cbk;
+
 	} args;
 } call_stub_t;
 
@@ -1129,6 +1190,66 @@ fop_fsetattr_cbk_stub (call_frame_t *frame,
                        struct iatt *statpre,
                        struct iatt *statpost, dict_t *xdata);
 
+call_stub_t *
+fop_fallocate_stub (call_frame_t *frame,
+                    fop_fallocate_t fn,
+                    fd_t *fd,
+                    int32_t keep_size,
+                    off_t offset,
+                    size_t len, dict_t *xdata);
+
+call_stub_t *
+fop_fallocate_cbk_stub (call_frame_t *frame,
+                        fop_fallocate_cbk_t fn,
+                        int32_t op_ret,
+                        int32_t op_errno,
+                        struct iatt *prebuf,
+                        struct iatt *postbuf, dict_t *xdata);
+
+call_stub_t *
+fop_discard_stub (call_frame_t *frame,
+                  fop_discard_t fn,
+                  fd_t *fd,
+                  off_t offset,
+                  size_t len, dict_t *xdata);
+
+call_stub_t *
+fop_discard_cbk_stub (call_frame_t *frame,
+                      fop_discard_cbk_t fn,
+                      int32_t op_ret,
+                      int32_t op_errno,
+                      struct iatt *prebuf,
+                      struct iatt *postbuf, dict_t *xdata);
+
+call_stub_t *
+fop_zerofill_stub (call_frame_t *frame,
+                   fop_zerofill_t fn,
+                   fd_t *fd,
+                   off_t offset,
+                   off_t len, dict_t *xdata);
+
+call_stub_t *
+fop_zerofill_cbk_stub (call_frame_t *frame,
+                       fop_zerofill_cbk_t fn,
+                       int32_t op_ret,
+                       int32_t op_errno,
+                       struct iatt *prebuf,
+                       struct iatt *postbuf, dict_t *xdata);
+
+call_stub_t *
+fop_seek_stub (call_frame_t *frame,
+               fop_seek_t fn,
+               fd_t *fd,
+               off_t offset,
+               gf_seek_what_t what, dict_t *xdata);
+
+call_stub_t *
+fop_seek_cbk_stub (call_frame_t *frame,
+                   fop_seek_cbk_t fn,
+                   int32_t op_ret,
+                   int32_t op_errno,
+                   off_t offset, dict_t *xdata);
+
 void call_resume (call_stub_t *stub);
 void call_stub_destroy (call_stub_t *stub);
 #endif
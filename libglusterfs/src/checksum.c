@@ -10,8 +10,13 @@
 
 #include <openssl/md5.h>
 #include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
-#include "glusterfs.h"
+#include "checksum.h"
 
 /*
  * The "weak" checksum required for the rsync algorithm,
@@ -21,26 +26,76 @@
  * "a simple 32 bit checksum that can be upadted from either end
  *  (inspired by Mark Adler's Adler-32 checksum)"
  *
- * Note: these functions are only called to compute checksums on
- * pathnames; they don't need to handle arbitrarily long strings of
- * data. Thus int32_t and uint32_t are sufficient
+ * Also used on the blocks of rchecksum: the sums wrap modulo 2^32
+ * whatever the length, which the vectorized loop relies on.
  */
 
+#if defined(__SSE2__)
+/*
+ * Sixteen bytes at a time: over a run of n blocks s1 grows by the sum of
+ * the bytes, and s2 by 16 times the s1 at the start of each block plus the
+ * bytes weighted 16..1 by their distance to the end of their block. All of
+ * it is modulo 2^32, like the byte loop, so the result is the same.
+ */
+static uint32_t
+gf_rsync_weak_checksum_sse2 (unsigned char *buf, size_t len, uint32_t *s1_p,
+                             uint32_t *s2_p)
+{
+        const __m128i  zero = _mm_setzero_si128 ();
+        const __m128i  w_lo = _mm_setr_epi16 (16, 15, 14, 13, 12, 11, 10, 9);
+        const __m128i  w_hi = _mm_setr_epi16 (8, 7, 6, 5, 4, 3, 2, 1);
+        __m128i        v_s1 = zero;
+        __m128i        v_ps = zero;
+        __m128i        v_w  = zero;
+        __m128i        x    = zero;
+        uint32_t       lanes[4];
+        size_t         blocks = len / 16;
+        size_t         i      = 0;
+        uint32_t       ps     = 0;
+
+        for (i = 0; i < blocks; i++) {
+                x = _mm_loadu_si128 ((const __m128i *)(buf + i * 16));
+                v_ps = _mm_add_epi32 (v_ps, v_s1);
+                v_s1 = _mm_add_epi32 (v_s1, _mm_sad_epu8 (x, zero));
+                v_w  = _mm_add_epi32 (v_w, _mm_madd_epi16 (
+                                      _mm_unpacklo_epi8 (x, zero), w_lo));
+                v_w  = _mm_add_epi32 (v_w, _mm_madd_epi16 (
+                                      _mm_unpackhi_epi8 (x, zero), w_hi));
+        }
+
+        _mm_storeu_si128 ((__m128i *)lanes, v_ps);
+        ps = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        ps += (uint32_t) blocks * *s1_p;
+
+        _mm_storeu_si128 ((__m128i *)lanes, v_w);
+        *s2_p += 16 * ps + lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+        _mm_storeu_si128 ((__m128i *)lanes, v_s1);
+        *s1_p += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+        return blocks * 16;
+}
+#endif
+
 uint32_t
 gf_rsync_weak_checksum (unsigned char *buf, size_t len)
 {
-        int32_t i = 0;
+        size_t i = 0;
         uint32_t s1, s2;
 
         uint32_t csum;
 
         s1 = s2 = 0;
+#if defined(__SSE2__)
+        i = gf_rsync_weak_checksum_sse2 (buf, len, &s1, &s2);
+#else
         if (len >= 4) {
                 for (; i < (len-4); i+=4) {
                         s2 += 4*(s1 + buf[i]) + 3*buf[i+1] + 2*buf[i+2] + buf[i+3];
                         s1 += buf[i+0] + buf[i+1] + buf[i+2] + buf[i+3];
                 }
         }
+#endif
 
         for (; i < len; i++) {
                 s1 += buf[i];
@@ -63,3 +118,129 @@ gf_rsync_strong_checksum (unsigned char *data, size_t len, unsigned char *md5)
 {
         MD5(data, len, md5);
 }
+
+
+/*
+ * The 128 bit MurmurHash3 (x64 variant) of Austin Appleby, in the public
+ * domain. Several times faster than MD5 and as good at telling blocks
+ * apart, which is all self-heal needs: it is not meant to resist forgery.
+ * The blocks are read and the digest written little endian, so that
+ * bricks of either byte order agree.
+ */
+
+static inline uint64_t
+gf_murmur3_rotl64 (uint64_t x, int8_t r)
+{
+        return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t
+gf_murmur3_fmix64 (uint64_t k)
+{
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        k *= 0xc4ceb9fe1a85ec53ULL;
+        k ^= k >> 33;
+
+        return k;
+}
+
+static inline uint64_t
+gf_murmur3_getblock (const unsigned char *p)
+{
+        uint64_t k;
+
+        memcpy (&k, p, sizeof (k));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        k = __builtin_bswap64 (k);
+#endif
+        return k;
+}
+
+static inline void
+gf_murmur3_putblock (unsigned char *p, uint64_t k)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        k = __builtin_bswap64 (k);
+#endif
+        memcpy (p, &k, sizeof (k));
+}
+
+void
+gf_rsync_fast_checksum (unsigned char *data, size_t len, unsigned char *sum)
+{
+        const uint64_t  c1     = 0x87c37b91114253d5ULL;
+        const uint64_t  c2     = 0x4cf5ad432745937fULL;
+        const unsigned char *tail = NULL;
+        size_t          blocks = len / 16;
+        size_t          i      = 0;
+        uint64_t        h1     = 0;
+        uint64_t        h2     = 0;
+        uint64_t        k1     = 0;
+        uint64_t        k2     = 0;
+
+        for (i = 0; i < blocks; i++) {
+                k1 = gf_murmur3_getblock (data + i * 16);
+                k2 = gf_murmur3_getblock (data + i * 16 + 8);
+
+                k1 *= c1; k1 = gf_murmur3_rotl64 (k1, 31); k1 *= c2; h1 ^= k1;
+                h1 = gf_murmur3_rotl64 (h1, 27); h1 += h2;
+                h1 = h1 * 5 + 0x52dce729;
+
+                k2 *= c2; k2 = gf_murmur3_rotl64 (k2, 33); k2 *= c1; h2 ^= k2;
+                h2 = gf_murmur3_rotl64 (h2, 31); h2 += h1;
+                h2 = h2 * 5 + 0x38495ab5;
+        }
+
+        tail = data + blocks * 16;
+        k1 = k2 = 0;
+
+        switch (len & 15) {
+        case 15: k2 ^= ((uint64_t) tail[14]) << 48;
+        case 14: k2 ^= ((uint64_t) tail[13]) << 40;
+        case 13: k2 ^= ((uint64_t) tail[12]) << 32;
+        case 12: k2 ^= ((uint64_t) tail[11]) << 24;
+        case 11: k2 ^= ((uint64_t) tail[10]) << 16;
+        case 10: k2 ^= ((uint64_t) tail[9]) << 8;
+        case  9: k2 ^= ((uint64_t) tail[8]);
+                 k2 *= c2; k2 = gf_murmur3_rotl64 (k2, 33); k2 *= c1;
+                 h2 ^= k2;
+        case  8: k1 ^= ((uint64_t) tail[7]) << 56;
+        case  7: k1 ^= ((uint64_t) tail[6]) << 48;
+        case  6: k1 ^= ((uint64_t) tail[5]) << 40;
+        case  5: k1 ^= ((uint64_t) tail[4]) << 32;
+        case  4: k1 ^= ((uint64_t) tail[3]) << 24;
+        case  3: k1 ^= ((uint64_t) tail[2]) << 16;
+        case  2: k1 ^= ((uint64_t) tail[1]) << 8;
+        case  1: k1 ^= ((uint64_t) tail[0]);
+                 k1 *= c1; k1 = gf_murmur3_rotl64 (k1, 31); k1 *= c2;
+                 h1 ^= k1;
+        }
+
+        h1 ^= (uint64_t) len;
+        h2 ^= (uint64_t) len;
+
+        h1 += h2;
+        h2 += h1;
+
+        h1 = gf_murmur3_fmix64 (h1);
+        h2 = gf_murmur3_fmix64 (h2);
+
+        h1 += h2;
+        h2 += h1;
+
+        gf_murmur3_putblock (sum, h1);
+        gf_murmur3_putblock (sum + 8, h2);
+}
+
+
+void
+gf_rsync_checksum_by_type (int type, unsigned char *data, size_t len,
+                           unsigned char *sum)
+{
+        if (type == GF_CHECKSUM_MURMUR3)
+                gf_rsync_fast_checksum (data, len, sum);
+        else
+                gf_rsync_strong_checksum (data, len, sum);
+}
@@ -11,10 +11,26 @@
 #ifndef __CHECKSUM_H__
 #define __CHECKSUM_H__
 
+#include <stdint.h>
+#include <sys/types.h>
+
+/* strong checksums of rchecksum, all GF_CHECKSUM_LENGTH bytes long */
+#define GF_CHECKSUM_MD5      0
+#define GF_CHECKSUM_MURMUR3  1
+
+#define GF_CHECKSUM_LENGTH   16
+
 uint32_t
 gf_rsync_weak_checksum (unsigned char *buf, size_t len);
 
 void
 gf_rsync_strong_checksum (unsigned char *buf, size_t len, unsigned char *sum);
 
+void
+gf_rsync_fast_checksum (unsigned char *buf, size_t len, unsigned char *sum);
+
+void
+gf_rsync_checksum_by_type (int type, unsigned char *buf, size_t len,
+                           unsigned char *sum);
+
 #endif /* __CHECKSUM_H__ */
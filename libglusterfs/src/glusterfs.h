@@ -100,14 +100,32 @@
 
 #define GLUSTERFS_OPEN_FD_COUNT "glusterfs.open-fd-count"
 #define GLUSTERFS_INODELK_COUNT "glusterfs.inodelk-count"
+#define GLUSTERFS_INODELK_CONTENTION "glusterfs.inodelk-contention"
 #define GLUSTERFS_ENTRYLK_COUNT "glusterfs.entrylk-count"
 #define GLUSTERFS_POSIXLK_COUNT "glusterfs.posixlk-count"
 #define GLUSTERFS_PARENT_ENTRYLK "glusterfs.parent-entrylk"
 #define QUOTA_SIZE_KEY "trusted.glusterfs.quota.size"
 #define GFID_TO_PATH_KEY "glusterfs.gfid2path"
 
+/* fsync group commit: size and window (usec) of the batch which synced it */
+#define GLUSTERFS_FSYNC_BATCH_SIZE   "glusterfs.fsync-batch-size"
+#define GLUSTERFS_FSYNC_BATCH_WINDOW "glusterfs.fsync-batch-window"
+
 /* Index xlator related */
 #define GF_XATTROP_INDEX_GFID "glusterfs.xattrop_index_gfid"
+#define GF_XATTROP_DIRTY_REGIONS "glusterfs.xattrop_dirty_regions"
+
+/* rchecksum: digest each block of the range separately */
+#define GF_RCHECKSUM_BLOCK_SIZE    "glusterfs.rchecksum.block-size"
+#define GF_RCHECKSUM_BLOCK_DIGESTS "glusterfs.rchecksum.block-digests"
+/* strong checksum asked for, and in the reply the one computed; bricks
+   which do not know the key reply MD5 without it */
+#define GF_RCHECKSUM_STRONG_TYPE   "glusterfs.rchecksum.strong-type"
+
+/* checksum of a file kept by the brick scrubber, and the mark of a copy
+   which failed its verification */
+#define GF_SCRUB_SIGN_KEY          "trusted.glusterfs.scrub.sign"
+#define GF_SCRUB_BAD_KEY           "trusted.glusterfs.scrub.bad"
 
 #define GF_GFIDLESS_LOOKUP "gfidless-lookup"
 /* replace-brick and pump related internal xattrs */
@@ -187,10 +205,22 @@ typedef enum {
         GF_FOP_RELEASEDIR,
         GF_FOP_GETSPEC,
         GF_FOP_FREMOVEXATTR,
+        GF_FOP_FALLOCATE,
+        GF_FOP_DISCARD,
+        GF_FOP_ZEROFILL,
+        GF_FOP_SEEK,
         GF_FOP_MAXVALUE,
 } glusterfs_fop_t;
 
 
+/* whence of the seek fop: like lseek SEEK_DATA and SEEK_HOLE, sent on the
+   wire, so independent of the values of the host */
+typedef enum {
+        GF_SEEK_DATA = 0,
+        GF_SEEK_HOLE,
+} gf_seek_what_t;
+
+
 typedef enum {
         GF_MGMT_NULL = 0,
         GF_MGMT_MAXVALUE,
@@ -417,6 +447,7 @@ typedef enum {
         GF_EVENT_AUTH_FAILED,
         GF_EVENT_VOLUME_DEFRAG,
         GF_EVENT_PARENT_DOWN,
+        GF_EVENT_SCRUB_BAD,
         GF_EVENT_MAXVAL,
 } glusterfs_event_t;
 
@@ -10,6 +10,7 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #ifndef _CONFIG_H
 #define _CONFIG_H
@@ -90,33 +91,33 @@ uint32_t SuperFastHash (const char * data, int32_t len) {
 
 /* Davies-Meyer hashing function implementation
  */
-static int
-dm_round (int rounds, uint32_t *array, uint32_t *h0, uint32_t *h1)
+static inline void
+dm_round (int rounds, const uint32_t *array, uint32_t *h0, uint32_t *h1)
 {
         uint32_t sum = 0;
         int      n = 0;
         uint32_t b0  = 0;
         uint32_t b1  = 0;
+        uint32_t a0  = array[0];
+        uint32_t a1  = array[1];
+        uint32_t a2  = array[2];
+        uint32_t a3  = array[3];
 
         b0 = *h0;
         b1 = *h1;
 
         n = rounds;
 
+        /* every round depends on the previous one, keep it all in
+           registers */
         do {
                 sum += DM_DELTA;
-                b0  += ((b1 << 4) + array[0])
-                        ^ (b1 + sum)
-                        ^ ((b1 >> 5) + array[1]);
-                b1  += ((b0 << 4) + array[2])
-                        ^ (b0 + sum)
-                        ^ ((b0 >> 5) + array[3]);
+                b0  += ((b1 << 4) + a0) ^ (b1 + sum) ^ ((b1 >> 5) + a1);
+                b1  += ((b0 << 4) + a2) ^ (b0 + sum) ^ ((b0 >> 5) + a3);
         } while (--n);
 
         *h0 += b0;
         *h1 += b1;
-
-        return 0;
 }
 
 
@@ -131,6 +132,10 @@ __pad (int len)
         return pad;
 }
 
+/* The message is loaded 16 bytes at a time with memcpy (), names are not
+   word aligned. The result must never change, the hash ranges are stored
+   on disk in the directory layouts.
+ */
 uint32_t
 gf_dm_hashfn (const char *msg, int len)
 {
@@ -143,43 +148,30 @@ gf_dm_hashfn (const char *msg, int len)
         int       full_quads = 0;
         int       full_words = 0;
         int       full_bytes = 0;
-        uint32_t *intmsg = NULL;
-        int       word = 0;
-
 
-        intmsg = (uint32_t *) msg;
         pad = __pad (len);
 
-        full_bytes   = len;
-        full_words   = len / 4;
         full_quads   = len / 16;
+        full_words   = (len % 16) / 4;
+        full_bytes   = len % 4;
 
         for (i = 0; i < full_quads; i++) {
-                for (j = 0; j < 4; j++) {
-                        word     = *intmsg;
-                        array[j] = word;
-                        intmsg++;
-                        full_words--;
-                        full_bytes -= 4;
-                }
-                dm_round (DM_PARTROUNDS, &array[0], &h0, &h1);
+                memcpy (array, msg, sizeof (array));
+                msg += sizeof (array);
+                dm_round (DM_PARTROUNDS, array, &h0, &h1);
         }
 
-        for (j = 0; j < 4; j++) {
-                if (full_words) {
-                        word     = *intmsg;
-                        array[j] = word;
-                        intmsg++;
-                        full_words--;
-                        full_bytes -= 4;
-                } else {
-                        array[j] = pad;
-                        while (full_bytes) {
-                                array[j] <<= 8;
-                                array[j] |= msg[len - full_bytes];
-                                full_bytes--;
-                        }
+        memcpy (array, msg, full_words * sizeof (uint32_t));
+        msg += full_words * sizeof (uint32_t);
+
+        for (j = full_words; j < 4; j++) {
+                array[j] = pad;
+                /* plain char, the sign extension is part of the hash */
+                for (i = 0; i < full_bytes; i++) {
+                        array[j] <<= 8;
+                        array[j] |= msg[i];
                 }
+                full_bytes = 0;
         }
         dm_round (DM_FULLROUNDS, &array[0], &h0, &h1);
 
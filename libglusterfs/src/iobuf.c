@@ -391,6 +391,9 @@ __iobuf_arena_prune (struct iobuf_pool *iobuf_pool,
         if (list_empty (&iobuf_pool->arenas[index]))
                 goto out;
 
+        if (iobuf_arena->pin_count)
+                goto out;
+
         /* All cases matched, destroy */
         list_del_init (&iobuf_arena->list);
         iobuf_pool->arena_cnt--;
@@ -402,6 +405,70 @@ out:
 }
 
 
+/* Offers every arena of @iobuf_pool to @fn, under the pool lock, and pins
+ * those @fn returns 0 for: a pinned arena is never pruned, so its memory can
+ * stay registered with the kernel (io_uring fixed buffers) until
+ * iobuf_arena_unpin ().  Returns the number of arenas pinned.
+ */
+int
+iobuf_pool_pin_arenas (struct iobuf_pool *iobuf_pool,
+                       iobuf_arena_pin_fn_t fn, void *data)
+{
+        struct iobuf_arena *iobuf_arena = NULL;
+        struct list_head   *lists[3]    = {NULL, };
+        int                 pinned      = 0;
+        int                 i           = 0;
+        int                 j           = 0;
+
+        GF_VALIDATE_OR_GOTO ("iobuf", iobuf_pool, out);
+        GF_VALIDATE_OR_GOTO ("iobuf", fn, out);
+
+        pthread_mutex_lock (&iobuf_pool->mutex);
+        {
+                for (i = 0; i < IOBUF_ARENA_MAX_INDEX; i++) {
+                        lists[0] = &iobuf_pool->arenas[i];
+                        lists[1] = &iobuf_pool->filled[i];
+                        lists[2] = &iobuf_pool->purge[i];
+
+                        for (j = 0; j < 3; j++) {
+                                list_for_each_entry (iobuf_arena, lists[j],
+                                                     list) {
+                                        if (fn (iobuf_arena, data) != 0)
+                                                continue;
+                                        iobuf_arena->pin_count++;
+                                        pinned++;
+                                }
+                        }
+                }
+        }
+        pthread_mutex_unlock (&iobuf_pool->mutex);
+
+out:
+        return pinned;
+}
+
+
+void
+iobuf_arena_unpin (struct iobuf_arena *iobuf_arena)
+{
+        struct iobuf_pool *iobuf_pool = NULL;
+
+        GF_VALIDATE_OR_GOTO ("iobuf", iobuf_arena, out);
+
+        iobuf_pool = iobuf_arena->iobuf_pool;
+
+        /* an idle arena gets pruned on its next iobuf_put or pool prune */
+        pthread_mutex_lock (&iobuf_pool->mutex);
+        {
+                iobuf_arena->pin_count--;
+        }
+        pthread_mutex_unlock (&iobuf_pool->mutex);
+
+out:
+        return;
+}
+
+
 void
 iobuf_pool_prune (struct iobuf_pool *iobuf_pool)
 {
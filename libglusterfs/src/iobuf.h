@@ -101,6 +101,8 @@ struct iobuf_arena {
                                            (unused by itself) */
         uint64_t            alloc_cnt;  /* total allocs in this pool */
         int                 max_active; /* max active buffers at a given time */
+        int                 pin_count;  /* users who handed mem_base to the
+                                           kernel, never pruned while > 0 */
 };
 
 
@@ -158,4 +160,10 @@ void   iobuf_stats_dump (struct iobuf_pool *iobuf_pool);
 
 struct iobuf *
 iobuf_get2 (struct iobuf_pool *iobuf_pool, size_t page_size);
+
+typedef int (*iobuf_arena_pin_fn_t) (struct iobuf_arena *iobuf_arena,
+                                     void *data);
+int iobuf_pool_pin_arenas (struct iobuf_pool *iobuf_pool,
+                           iobuf_arena_pin_fn_t fn, void *data);
+void iobuf_arena_unpin (struct iobuf_arena *iobuf_arena);
 #endif /* !_IOBUF_H_ */
@@ -105,6 +105,7 @@ struct syncargs {
         struct iobref      *iobref;
         char               *buffer;
         dict_t             *xdata;
+        off_t               offset;
 
         /* some more _cbk needs */
         uuid_t              uuid;
@@ -259,4 +260,11 @@ int syncop_mknod (xlator_t *subvol, loc_t *loc, mode_t mode, dev_t rdev,
 int syncop_link (xlator_t *subvol, loc_t *oldloc, loc_t *newloc);
 int syncop_fsyncdir (xlator_t *subvol, fd_t *fd, int datasync);
 int syncop_access (xlator_t *subvol, loc_t *loc, int32_t mask);
+
+int syncop_fallocate (xlator_t *subvol, fd_t *fd, int32_t keep_size,
+                      off_t offset, size_t len);
+int syncop_discard (xlator_t *subvol, fd_t *fd, off_t offset, size_t len);
+int syncop_zerofill (xlator_t *subvol, fd_t *fd, off_t offset, off_t len);
+int syncop_seek (xlator_t *subvol, fd_t *fd, off_t offset,
+                 gf_seek_what_t what, off_t *off);
 #endif /* _SYNCOP_H */
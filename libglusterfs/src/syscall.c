@@ -19,6 +19,7 @@
 #include <sys/types.h>
 #include <utime.h>
 #include <sys/time.h>
+#include <fcntl.h>
 
 int
 sys_lstat (const char *path, struct stat *buf)
@@ -458,3 +459,15 @@ sys_access (const char *pathname, int mode)
 {
         return access (pathname, mode);
 }
+
+
+int
+sys_fallocate (int fd, int mode, off_t offset, off_t len)
+{
+#ifdef HAVE_FALLOCATE
+        return fallocate (fd, mode, offset, len);
+#else
+        errno = ENOSYS;
+        return -1;
+#endif
+}
@@ -694,3 +694,67 @@ struct gf_event_notify_rsp {
 	int op_errno;
 	opaque dict<>;
 };
+
+struct gfs3_fallocate_req {
+	opaque gfid[16];
+	hyper fd;
+	unsigned int flags;
+	unsigned hyper offset;
+	unsigned hyper size;
+	opaque xdata<>; /* Extra data */
+};
+
+struct gfs3_fallocate_rsp {
+	int op_ret;
+	int op_errno;
+	struct gf_iatt statpre;
+	struct gf_iatt statpost;
+	opaque xdata<>; /* Extra data */
+};
+
+struct gfs3_discard_req {
+	opaque gfid[16];
+	hyper fd;
+	unsigned hyper offset;
+	unsigned hyper size;
+	opaque xdata<>; /* Extra data */
+};
+
+struct gfs3_discard_rsp {
+	int op_ret;
+	int op_errno;
+	struct gf_iatt statpre;
+	struct gf_iatt statpost;
+	opaque xdata<>; /* Extra data */
+};
+
+struct gfs3_zerofill_req {
+	opaque gfid[16];
+	hyper fd;
+	unsigned hyper offset;
+	unsigned hyper size;
+	opaque xdata<>; /* Extra data */
+};
+
+struct gfs3_zerofill_rsp {
+	int op_ret;
+	int op_errno;
+	struct gf_iatt statpre;
+	struct gf_iatt statpost;
+	opaque xdata<>; /* Extra data */
+};
+
+struct gfs3_seek_req {
+	opaque gfid[16];
+	hyper fd;
+	unsigned hyper offset;
+	int what;
+	opaque xdata<>; /* Extra data */
+};
+
+struct gfs3_seek_rsp {
+	int op_ret;
+	int op_errno;
+	unsigned hyper offset;
+	opaque xdata<>; /* Extra data */
+};
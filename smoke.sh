@@ -14,6 +14,7 @@ function cleanup()
     killall -15 glusterfs glusterfsd glusterd glusterd 2>&1 || true;
     killall -9 glusterfs glusterfsd glusterd glusterd 2>&1 || true;
     umount -l $M 2>&1 || true;
+    umount -l $P/eager1 $P/eager2 2>&1 || true;
     rm -rf /var/lib/glusterd /etc/glusterd $P/export;
 }
 
@@ -47,6 +48,46 @@ function run_tests()
 }
 
 
+function run_eager_lock_test()
+{
+    # writes from a second client turn the eager lock of the first one
+    # off; once they stop, eager locking has to come back on
+    local log=$P/eager1.log;
+
+    mkdir -p $P/eager1 $P/eager2;
+    rm -f $log;
+    glusterfs -s $H --volfile-id $V --log-level=DEBUG --log-file=$log \
+        $P/eager1;
+    glusterfs -s $H --volfile-id $V $P/eager2;
+
+    dd if=/dev/zero of=$P/eager1/eager bs=128k count=8 conv=fsync;
+
+    (for i in $(seq 1 200); do
+         dd if=/dev/zero of=$P/eager2/eager bs=4k count=1 seek=$i \
+            conv=notrunc 2>/dev/null;
+     done) &
+    for i in $(seq 1 400); do
+        dd if=/dev/zero of=$P/eager1/eager bs=4k count=1 seek=$i \
+           conv=notrunc 2>/dev/null;
+    done
+    wait $!;
+
+    grep -q "eager lock contended" $log;
+
+    # the second client is gone: its locks no longer show up in the
+    # replies of the bricks
+    umount $P/eager2;
+    for i in $(seq 1 50); do
+        dd if=/dev/zero of=$P/eager1/eager bs=4k count=1 seek=$i \
+           conv=notrunc 2>/dev/null;
+    done
+
+    grep "eager lock" $log | tail -n 1 | grep -q "uncontended";
+
+    umount $P/eager1;
+}
+
+
 function watchdog ()
 {
     # insurance against hangs during the test
@@ -78,6 +119,8 @@ function main ()
     start_fs;
 
     run_tests;
+
+    run_eager_lock_test;
 }
 
 main "$@";
@@ -88,6 +88,10 @@ afr_xattr_req_prepare (xlator_t *this, dict_t *xattr_req, const char *path)
                 gf_log (this->name, GF_LOG_DEBUG, "%s: failed to set gfidless "
                         "lookup", path);
         }
+        ret = dict_set_uint64 (xattr_req, GF_SCRUB_BAD_KEY, 0);
+        if (ret)
+                gf_log (this->name, GF_LOG_DEBUG, "%s: Unable to set dict "
+                        "value for %s", path, GF_SCRUB_BAD_KEY);
 }
 
 int
@@ -321,6 +325,146 @@ afr_inode_get_read_ctx (xlator_t *this, inode_t *inode, int32_t *fresh_children)
         return params.u.read_ctx.read_child;
 }
 
+static void
+afr_inode_lock_destroy (afr_inode_lock_t *lock)
+{
+        if (!lock)
+                return;
+
+        GF_FREE (lock->pre_op_done);
+        GF_FREE (lock->pre_op_piggyback);
+        GF_FREE (lock->lock_piggyback);
+        GF_FREE (lock->lock_acquired);
+        LOCK_DESTROY (&lock->lock);
+        pthread_mutex_destroy (&lock->delay_lock);
+        GF_FREE (lock);
+}
+
+static afr_inode_lock_t *
+afr_inode_lock_new (int32_t child_count)
+{
+        afr_inode_lock_t *lock = NULL;
+        int               ret  = -1;
+
+        lock = GF_CALLOC (1, sizeof (*lock), gf_afr_mt_inode_lock_t);
+        if (!lock)
+                goto out;
+
+        LOCK_INIT (&lock->lock);
+        pthread_mutex_init (&lock->delay_lock, NULL);
+
+        lock->pre_op_done = GF_CALLOC (sizeof (*lock->pre_op_done),
+                                       child_count, gf_afr_mt_char);
+        if (!lock->pre_op_done)
+                goto out;
+
+        lock->pre_op_piggyback = GF_CALLOC (sizeof (*lock->pre_op_piggyback),
+                                            child_count, gf_afr_mt_char);
+        if (!lock->pre_op_piggyback)
+                goto out;
+
+        lock->lock_piggyback = GF_CALLOC (sizeof (*lock->lock_piggyback),
+                                          child_count, gf_afr_mt_char);
+        if (!lock->lock_piggyback)
+                goto out;
+
+        lock->lock_acquired = GF_CALLOC (sizeof (*lock->lock_acquired),
+                                         child_count, gf_afr_mt_char);
+        if (!lock->lock_acquired)
+                goto out;
+
+        ret = 0;
+out:
+        if (ret) {
+                afr_inode_lock_destroy (lock);
+                lock = NULL;
+        }
+        return lock;
+}
+
+/* The eager-lock state is created on first use and lives as long as the
+   inode ctx, so that every fd opened on the inode finds the same one */
+afr_inode_lock_t *
+afr_inode_lock_get (xlator_t *this, inode_t *inode)
+{
+        afr_private_t    *priv     = NULL;
+        afr_inode_ctx_t  *ctx      = NULL;
+        afr_inode_lock_t *lock     = NULL;
+        uint64_t          ctx_addr = 0;
+        int               ret      = 0;
+
+        priv = this->private;
+        LOCK (&inode->lock);
+        {
+                ret = __inode_ctx_get (inode, this, &ctx_addr);
+                if (ret < 0)
+                        ctx_addr = 0;
+                ctx = afr_inode_ctx_get_from_addr (ctx_addr, priv->child_count);
+                if (!ctx)
+                        goto unlock;
+
+                if (!ctx_addr) {
+                        ret = __inode_ctx_put (inode, this, (uint64_t)ctx);
+                        if (ret) {
+                                gf_log (this->name, GF_LOG_ERROR, "failed to "
+                                        "set the inode ctx (%s)",
+                                        uuid_utoa (inode->gfid));
+                                GF_FREE (ctx->fresh_children);
+                                GF_FREE (ctx);
+                                goto unlock;
+                        }
+                }
+
+                if (!ctx->lock)
+                        ctx->lock = afr_inode_lock_new (priv->child_count);
+                lock = ctx->lock;
+        }
+unlock:
+        UNLOCK (&inode->lock);
+
+        return lock;
+}
+
+gf_boolean_t
+afr_inode_lock_contended (xlator_t *this, inode_t *inode)
+{
+        afr_inode_lock_t *lock      = NULL;
+        gf_boolean_t      contended = _gf_false;
+
+        lock = afr_inode_lock_get (this, inode);
+        if (!lock)
+                goto out;
+
+        LOCK (&lock->lock);
+        {
+                contended = lock->contended;
+        }
+        UNLOCK (&lock->lock);
+out:
+        return contended;
+}
+
+void
+afr_inode_lock_set_contended (xlator_t *this, inode_t *inode,
+                              gf_boolean_t contended)
+{
+        afr_inode_lock_t *lock = NULL;
+
+        lock = afr_inode_lock_get (this, inode);
+        if (!lock)
+                return;
+
+        LOCK (&lock->lock);
+        {
+                if (lock->contended != contended)
+                        gf_log (this->name, GF_LOG_DEBUG, "%s: eager lock %s",
+                                uuid_utoa (inode->gfid), contended ?
+                                "contended, releasing early" : "uncontended");
+                lock->contended = contended;
+        }
+        UNLOCK (&lock->lock);
+}
+
 void
 afr_inode_ctx_set_read_child (afr_inode_ctx_t *ctx, int32_t read_child)
 {
@@ -749,6 +893,141 @@ out:
         return ret;
 }
 
+/* cost of a read on a child: its latency, times the reads already queued */
+static uint64_t
+afr_read_cost (afr_read_stats_t *stats)
+{
+        return (stats->latency + 1) * (stats->outstanding + 1);
+}
+
+/* afr_read_balance_child ()
+ * With read-balance on, picks the child a readv at @offset on @fd goes to:
+ * the child of the previous readv on the fd if this one continues it,
+ * otherwise @read_child; unless a fresh child costs less than half as much.
+ * One read in AFR_READ_PROBE_INTERVAL goes round the fresh children, so
+ * that the latency of the ones not picked stays current.
+ */
+int32_t
+afr_read_balance_child (xlator_t *this, fd_t *fd, off_t offset, size_t size,
+                        unsigned char *child_up, int32_t *fresh_children,
+                        int32_t read_child)
+{
+        afr_private_t   *priv      = NULL;
+        afr_fd_ctx_t    *fd_ctx    = NULL;
+        int32_t         preferred  = -1;
+        int32_t         best       = -1;
+        int32_t         chosen     = -1;
+        int32_t         child      = -1;
+        uint64_t        best_cost  = 0;
+        uint64_t        cost       = 0;
+        int             up         = 0;
+        int             i          = 0;
+
+        priv = this->private;
+        if (!priv->read_balance || !priv->read_stats || (read_child < 0))
+                return read_child;
+
+        fd_ctx = afr_fd_ctx_get (fd, this);
+
+        LOCK (&priv->read_child_lock);
+        {
+                preferred = read_child;
+                if (fd_ctx && (fd_ctx->read_child >= 0) &&
+                    (fd_ctx->read_offset == offset) &&
+                    afr_is_child_present (fresh_children, priv->child_count,
+                                          fd_ctx->read_child))
+                        preferred = fd_ctx->read_child;
+
+                for (i = 0; i < priv->child_count; i++) {
+                        child = fresh_children[i];
+                        if (child < 0)
+                                break;
+                        if (!child_up[child])
+                                continue;
+                        up++;
+                        cost = afr_read_cost (&priv->read_stats[child]);
+                        if ((best < 0) || (cost < best_cost)) {
+                                best = child;
+                                best_cost = cost;
+                        }
+                }
+
+                chosen = preferred;
+                if ((best >= 0) && (!child_up[preferred] ||
+                    (best_cost * 2 <
+                     afr_read_cost (&priv->read_stats[preferred]))))
+                        chosen = best;
+
+                if (fd_ctx) {
+                        fd_ctx->read_child = chosen;
+                        fd_ctx->read_offset = offset + size;
+                }
+
+                if ((up > 1) &&
+                    !(++priv->read_probe % AFR_READ_PROBE_INTERVAL)) {
+                        up = (priv->read_probe / AFR_READ_PROBE_INTERVAL) % up;
+                        for (i = 0; i < priv->child_count; i++) {
+                                child = fresh_children[i];
+                                if ((child < 0) || !child_up[child])
+                                        continue;
+                                if (!up--) {
+                                        chosen = child;
+                                        break;
+                                }
+                        }
+                }
+        }
+        UNLOCK (&priv->read_child_lock);
+
+        return chosen;
+}
+
+void
+afr_read_stats_start (xlator_t *this, int32_t child, struct timeval *start)
+{
+        afr_private_t   *priv = NULL;
+
+        priv = this->private;
+        if (!priv->read_stats || (child < 0))
+                return;
+
+        gettimeofday (start, NULL);
+        LOCK (&priv->read_child_lock);
+        {
+                priv->read_stats[child].reads++;
+                priv->read_stats[child].outstanding++;
+        }
+        UNLOCK (&priv->read_child_lock);
+}
+
+void
+afr_read_stats_end (xlator_t *this, int32_t child, struct timeval *start)
+{
+        afr_private_t   *priv    = NULL;
+        afr_read_stats_t *stats  = NULL;
+        struct timeval  now      = {0,};
+        uint64_t        elapsed  = 0;
+
+        priv = this->private;
+        if (!priv->read_stats || (child < 0))
+                return;
+
+        gettimeofday (&now, NULL);
+        elapsed = (now.tv_sec - start->tv_sec) * 1000000 +
+                  (now.tv_usec - start->tv_usec);
+
+        LOCK (&priv->read_child_lock);
+        {
+                stats = &priv->read_stats[child];
+                stats->outstanding--;
+                if (stats->latency)
+                        stats->latency = (stats->latency * 7 + elapsed) / 8;
+                else
+                        stats->latency = elapsed;
+        }
+        UNLOCK (&priv->read_child_lock);
+}
+
 void
 afr_reset_xattr (dict_t **xattr, unsigned int child_count)
 {
@@ -817,6 +1096,8 @@ afr_local_sh_cleanup (afr_local_t *local, xlator_t *this)
         GF_FREE (sh->checksum);
 
         GF_FREE (sh->write_needed);
+
+        GF_FREE (sh->block_diff);
         if (sh->healing_fd)
                 fd_unref (sh->healing_fd);
 }
@@ -1588,6 +1869,14 @@ afr_lookup_set_self_heal_params (afr_local_t *local, xlator_t *this)
                 child1 = local->cont.lookup.success_children[i];
                 afr_lookup_set_self_heal_params_by_xattr (local, this,
                                                           xattr[child1]);
+                if (xattr[child1] &&
+                    dict_get (xattr[child1], GF_SCRUB_BAD_KEY)) {
+                        gf_log (this->name, GF_LOG_DEBUG, "%s: copy on %s "
+                                "failed scrubbing", local->loc.path,
+                                priv->children[child1]->name);
+                        sh->scrub_bad |= 1ULL << child1;
+                        sh->do_data_self_heal = _gf_true;
+                }
         }
         if (afr_open_only_data_self_heal (priv->data_self_heal))
                 sh->do_data_self_heal = _gf_false;
@@ -2369,22 +2658,6 @@ __afr_fd_ctx_set (xlator_t *this, fd_t *fd)
                 goto out;
         }
 
-        fd_ctx->pre_op_done = GF_CALLOC (sizeof (*fd_ctx->pre_op_done),
-                                         priv->child_count,
-                                         gf_afr_mt_char);
-        if (!fd_ctx->pre_op_done) {
-                ret = -ENOMEM;
-                goto out;
-        }
-
-        fd_ctx->pre_op_piggyback = GF_CALLOC (sizeof (*fd_ctx->pre_op_piggyback),
-                                              priv->child_count,
-                                              gf_afr_mt_char);
-        if (!fd_ctx->pre_op_piggyback) {
-                ret = -ENOMEM;
-                goto out;
-        }
-
         fd_ctx->opened_on = GF_CALLOC (sizeof (*fd_ctx->opened_on),
                                        priv->child_count,
                                        gf_afr_mt_int32_t);
@@ -2393,22 +2666,6 @@ __afr_fd_ctx_set (xlator_t *this, fd_t *fd)
                 goto out;
         }
 
-        fd_ctx->lock_piggyback = GF_CALLOC (sizeof (*fd_ctx->lock_piggyback),
-                                            priv->child_count,
-                                            gf_afr_mt_char);
-        if (!fd_ctx->lock_piggyback) {
-                ret = -ENOMEM;
-                goto out;
-        }
-
-        fd_ctx->lock_acquired = GF_CALLOC (sizeof (*fd_ctx->lock_acquired),
-                                           priv->child_count,
-                                           gf_afr_mt_char);
-        if (!fd_ctx->lock_acquired) {
-                ret = -ENOMEM;
-                goto out;
-        }
-
         fd_ctx->up_count   = priv->up_count;
         fd_ctx->down_count = priv->down_count;
 
@@ -2420,7 +2677,8 @@ __afr_fd_ctx_set (xlator_t *this, fd_t *fd)
                 goto out;
         }
 
-	pthread_mutex_init (&fd_ctx->delay_lock, NULL);
+        fd_ctx->read_child = -1;
+
         INIT_LIST_HEAD (&fd_ctx->paused_calls);
         INIT_LIST_HEAD (&fd_ctx->entries);
 
@@ -2652,25 +2910,16 @@ afr_cleanup_fd_ctx (xlator_t *this, fd_t *fd)
         fd_ctx = (afr_fd_ctx_t *)(long) ctx;
 
         if (fd_ctx) {
-                GF_FREE (fd_ctx->pre_op_done);
-
                 GF_FREE (fd_ctx->opened_on);
 
                 GF_FREE (fd_ctx->locked_on);
 
-                GF_FREE (fd_ctx->pre_op_piggyback);
                 list_for_each_entry_safe (paused_call, tmp, &fd_ctx->paused_calls,
                                           call_list) {
                         list_del_init (&paused_call->call_list);
                         GF_FREE (paused_call);
                 }
 
-                GF_FREE (fd_ctx->lock_piggyback);
-
-                GF_FREE (fd_ctx->lock_acquired);
-
-		pthread_mutex_destroy (&fd_ctx->delay_lock);
-
                 GF_FREE (fd_ctx);
         }
 
@@ -3629,6 +3878,7 @@ afr_forget (xlator_t *this, inode_t *inode)
                 goto out;
 
         ctx = (afr_inode_ctx_t *)(long)ctx_addr;
+        afr_inode_lock_destroy (ctx->lock);
         GF_FREE (ctx->fresh_children);
         GF_FREE (ctx);
 out:
@@ -3667,6 +3917,25 @@ afr_priv_dump (xlator_t *this)
         gf_proc_dump_write("read_child", "%d", priv->read_child);
         gf_proc_dump_write("favorite_child", "%d", priv->favorite_child);
         gf_proc_dump_write("wait_count", "%u", priv->wait_count);
+        gf_proc_dump_write("data_self_heal_window_size", "%u",
+                           priv->data_self_heal_window_size);
+        gf_proc_dump_write("data_self_heal_checksum_batch", "%u",
+                           priv->data_self_heal_checksum_batch);
+        gf_proc_dump_write("data_self_heal_latency_target", "%u",
+                           priv->data_self_heal_latency_target);
+        gf_proc_dump_write("data_self_heal_dirty_regions", "%d",
+                           priv->data_self_heal_dirty_regions);
+        gf_proc_dump_write("read_balance", "%d", priv->read_balance);
+        for (i = 0; priv->read_stats && (i < priv->child_count); i++) {
+                sprintf (key, "reads[%d]", i);
+                gf_proc_dump_write(key, "%"PRIu64, priv->read_stats[i].reads);
+                sprintf (key, "read_latency_usec[%d]", i);
+                gf_proc_dump_write(key, "%"PRIu64,
+                                   priv->read_stats[i].latency);
+                sprintf (key, "outstanding_reads[%d]", i);
+                gf_proc_dump_write(key, "%d",
+                                   priv->read_stats[i].outstanding);
+        }
 
         return 0;
 }
@@ -4256,6 +4525,7 @@ afr_priv_destroy (afr_private_t *priv)
 //                if (priv->shd.timer && priv->shd.timer[i])
 //                        gf_timer_call_cancel (this->ctx, priv->shd.timer[i]);
         GF_FREE (priv->shd.timer);
+        GF_FREE (priv->shd.progress);
 
         if (priv->shd.healed)
                 eh_destroy (priv->shd.healed);
@@ -4267,6 +4537,7 @@ afr_priv_destroy (afr_private_t *priv)
                 eh_destroy (priv->shd.split_brain);
 
         GF_FREE (priv->last_event);
+        GF_FREE (priv->read_stats);
         if (priv->pending_key) {
                 for (i = 0; i < priv->child_count; i++)
                         GF_FREE (priv->pending_key[i]);
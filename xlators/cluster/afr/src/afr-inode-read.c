@@ -397,6 +397,136 @@ out:
 
 /* }}} */
 
+/* {{{ seek */
+
+int32_t
+afr_seek_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, off_t offset, dict_t *xdata)
+{
+        afr_private_t   *priv           = NULL;
+        afr_local_t     *local          = NULL;
+        xlator_t        **children      = NULL;
+        int             unwind          = 1;
+        int32_t         *last_index     = NULL;
+        int32_t         next_call_child = -1;
+        int32_t         read_child      = -1;
+        int32_t         *fresh_children  = NULL;
+
+        priv     = this->private;
+        children = priv->children;
+
+        local = frame->local;
+
+        read_child = (long) cookie;
+
+        /* ENXIO is the answer for an offset past the end of the file,
+           not a failure of the subvolume */
+        if ((op_ret == -1) && (op_errno != ENXIO)) {
+                last_index = &local->cont.seek.last_index;
+                fresh_children = local->fresh_children;
+                next_call_child = afr_next_call_child (fresh_children,
+                                                       local->child_up,
+                                                       priv->child_count,
+                                                       last_index, read_child);
+                if (next_call_child < 0)
+                        goto out;
+
+                unwind = 0;
+
+                STACK_WIND_COOKIE (frame, afr_seek_cbk,
+                                   (void *) (long) read_child,
+                                   children[next_call_child],
+                                   children[next_call_child]->fops->seek,
+                                   local->fd, local->cont.seek.offset,
+                                   local->cont.seek.what, NULL);
+        }
+
+out:
+        if (unwind) {
+                AFR_STACK_UNWIND (seek, frame, op_ret, op_errno, offset,
+                                  xdata);
+        }
+
+        return 0;
+}
+
+
+/* Holes are not replicated as such: a self-healed copy may have the zeroes
+   of the source written out. Whatever the read child answers covers all
+   the data of the file, which is what the callers skipping holes need. */
+int32_t
+afr_seek (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+          gf_seek_what_t what, dict_t *xdata)
+{
+        afr_private_t   *priv      = NULL;
+        afr_local_t     *local     = NULL;
+        xlator_t        **children = NULL;
+        int             call_child = 0;
+        int32_t         op_errno   = 0;
+        int32_t         read_child = 0;
+        int             ret        = -1;
+
+        VALIDATE_OR_GOTO (frame, out);
+        VALIDATE_OR_GOTO (this, out);
+        VALIDATE_OR_GOTO (fd, out);
+        VALIDATE_OR_GOTO (this->private, out);
+
+        priv     = this->private;
+        VALIDATE_OR_GOTO (priv->children, out);
+
+        children = priv->children;
+
+        VALIDATE_OR_GOTO (fd->inode, out);
+
+        AFR_LOCAL_ALLOC_OR_GOTO (frame->local, out);
+        local = frame->local;
+
+        ret = afr_local_init (local, priv, &op_errno);
+        if (ret < 0)
+                goto out;
+
+        local->fresh_children = afr_children_create (priv->child_count);
+        if (!local->fresh_children) {
+                op_errno = ENOMEM;
+                goto out;
+        }
+
+        read_child = afr_inode_get_read_ctx (this, fd->inode,
+                                             local->fresh_children);
+
+        ret = afr_get_call_child (this, local->child_up, read_child,
+                                  local->fresh_children,
+                                  &call_child,
+                                  &local->cont.seek.last_index);
+        if (ret < 0) {
+                op_errno = -ret;
+                goto out;
+        }
+
+        local->fd = fd_ref (fd);
+        local->cont.seek.offset = offset;
+        local->cont.seek.what = what;
+
+        ret = afr_open_fd_fix (frame, this, _gf_false);
+        if (ret) {
+                op_errno = -ret;
+                goto out;
+        }
+        STACK_WIND_COOKIE (frame, afr_seek_cbk, (void *) (long) call_child,
+                           children[call_child],
+                           children[call_child]->fops->seek,
+                           fd, offset, what, xdata);
+
+        ret = 0;
+out:
+        if (ret < 0)
+                AFR_STACK_UNWIND (seek, frame, -1, op_errno, 0, NULL);
+
+        return 0;
+}
+
+/* }}} */
+
 /* {{{ readlink */
 
 int32_t
@@ -1263,9 +1393,15 @@ afr_readv_cbk (call_frame_t *frame, void *cookie,
 
         read_child = (long) cookie;
 
+        last_index = &local->cont.readv.last_index;
+        fresh_children = local->fresh_children;
+        /* the child that answered: the first one tried, or the one the
+           last failover went to */
+        afr_read_stats_end (this, (*last_index < 0) ? read_child :
+                            fresh_children[*last_index],
+                            &local->cont.readv.start);
+
         if (op_ret == -1) {
-                last_index = &local->cont.readv.last_index;
-                fresh_children = local->fresh_children;
                 next_call_child = afr_next_call_child (fresh_children,
                                                        local->child_up,
                                                        priv->child_count,
@@ -1275,6 +1411,9 @@ afr_readv_cbk (call_frame_t *frame, void *cookie,
 
                 unwind = 0;
 
+                afr_read_stats_start (this, next_call_child,
+                                      &local->cont.readv.start);
+
                 STACK_WIND_COOKIE (frame, afr_readv_cbk,
                                    (void *) (long) read_child,
                                    children[next_call_child],
@@ -1329,6 +1468,10 @@ afr_readv (call_frame_t *frame, xlator_t *this,
         }
 
         read_child = afr_inode_get_read_ctx (this, fd->inode, local->fresh_children);
+        read_child = afr_read_balance_child (this, fd, offset, size,
+                                             local->child_up,
+                                             local->fresh_children,
+                                             read_child);
         ret = afr_get_call_child (this, local->child_up, read_child,
                                      local->fresh_children,
                                      &call_child,
@@ -1349,6 +1492,7 @@ afr_readv (call_frame_t *frame, xlator_t *this,
                 op_errno = -ret;
                 goto out;
         }
+        afr_read_stats_start (this, call_child, &local->cont.readv.start);
         STACK_WIND_COOKIE (frame, afr_readv_cbk,
                            (void *) (long) call_child,
                            children[call_child],
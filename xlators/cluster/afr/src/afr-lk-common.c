@@ -588,7 +588,7 @@ afr_unlock_inodelk (call_frame_t *frame, xlator_t *this)
         int call_count = 0;
         int i = 0;
         int piggyback = 0;
-        afr_fd_ctx_t        *fd_ctx      = NULL;
+        afr_inode_lock_t    *inode_lk    = NULL;
 
 
         local    = frame->local;
@@ -613,7 +613,7 @@ afr_unlock_inodelk (call_frame_t *frame, xlator_t *this)
         }
 
         if (local->fd)
-                fd_ctx = afr_fd_ctx_get (local->fd, this);
+                inode_lk = afr_inode_lock_get (this, local->fd->inode);
 
         for (i = 0; i < priv->child_count; i++) {
                 if ((int_lock->inode_locked_nodes[i] & LOCKED_YES)
@@ -622,22 +622,22 @@ afr_unlock_inodelk (call_frame_t *frame, xlator_t *this)
 
                 if (local->fd) {
                         flock_use = &flock;
-                        if (!local->transaction.eager_lock[i]) {
+                        if (!local->transaction.eager_lock[i] || !inode_lk) {
                                 goto wind;
                         }
 
                         piggyback = 0;
 
-                        LOCK (&local->fd->lock);
+                        LOCK (&inode_lk->lock);
                         {
-                                if (fd_ctx->lock_piggyback[i]) {
-                                        fd_ctx->lock_piggyback[i]--;
+                                if (inode_lk->lock_piggyback[i]) {
+                                        inode_lk->lock_piggyback[i]--;
                                         piggyback = 1;
                                 } else {
-                                        fd_ctx->lock_acquired[i]--;
+                                        inode_lk->lock_acquired[i]--;
                                 }
                         }
-                        UNLOCK (&local->fd->lock);
+                        UNLOCK (&inode_lk->lock);
 
                         if (piggyback) {
                                 afr_unlock_inodelk_cbk (frame, (void *) (long) i,
@@ -1332,7 +1332,7 @@ afr_nonblocking_inodelk_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         afr_local_t         *local    = NULL;
         int call_count  = 0;
         int child_index = (long) cookie;
-        afr_fd_ctx_t        *fd_ctx = NULL;
+        afr_inode_lock_t    *inode_lk = NULL;
 
 
         local    = frame->local;
@@ -1362,18 +1362,18 @@ afr_nonblocking_inodelk_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 
                 if (local->transaction.eager_lock &&
                     local->transaction.eager_lock[child_index] && local->fd) {
-                        fd_ctx = afr_fd_ctx_get (local->fd, this);
+                        inode_lk = afr_inode_lock_get (this, local->fd->inode);
                         /* piggybacked */
 
                         if (op_ret == 1) {
                                 /* piggybacked */
                         } else if (op_ret == 0) {
                                 /* lock acquired from server */
-                                LOCK (&local->fd->lock);
+                                LOCK (&inode_lk->lock);
                                 {
-                                        fd_ctx->lock_acquired[child_index]++;
+                                        inode_lk->lock_acquired[child_index]++;
                                 }
-                                UNLOCK (&local->fd->lock);
+                                UNLOCK (&inode_lk->lock);
                         }
                 }
         }
@@ -1415,6 +1415,7 @@ afr_nonblocking_inodelk (call_frame_t *frame, xlator_t *this)
         afr_local_t         *local    = NULL;
         afr_private_t       *priv     = NULL;
         afr_fd_ctx_t        *fd_ctx   = NULL;
+        afr_inode_lock_t    *inode_lk = NULL;
         int32_t             call_count = 0;
         int                 i          = 0;
         int                 ret        = 0;
@@ -1452,6 +1453,9 @@ afr_nonblocking_inodelk (call_frame_t *frame, xlator_t *this)
                 }
 
                 afr_mark_fd_open_on (local, fd_ctx, priv->child_count);
+                if (local->transaction.eager_lock_on)
+                        inode_lk = afr_inode_lock_get (this, local->fd->inode);
+
                 call_count = internal_lock_count (frame, this);
                 int_lock->lk_call_count = call_count;
                 int_lock->lk_expected_count = call_count;
@@ -1470,7 +1474,7 @@ afr_nonblocking_inodelk (call_frame_t *frame, xlator_t *this)
                                 continue;
 
                         flock_use = &flock;
-                        if (!priv->eager_lock) {
+                        if (!inode_lk) {
                                 goto wind;
                         }
 
@@ -1479,14 +1483,14 @@ afr_nonblocking_inodelk (call_frame_t *frame, xlator_t *this)
 
 			afr_set_delayed_post_op (frame, this);
 
-                        LOCK (&local->fd->lock);
+                        LOCK (&inode_lk->lock);
                         {
-                                if (fd_ctx->lock_acquired[i]) {
-                                        fd_ctx->lock_piggyback[i]++;
+                                if (inode_lk->lock_acquired[i]) {
+                                        inode_lk->lock_piggyback[i]++;
                                         piggyback = 1;
                                 }
                         }
-                        UNLOCK (&local->fd->lock);
+                        UNLOCK (&inode_lk->lock);
 
                         if (piggyback) {
                                 /* (op_ret == 1) => indicate piggybacked lock */
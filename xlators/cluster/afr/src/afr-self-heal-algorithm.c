@@ -25,6 +25,7 @@
 #include "compat-errno.h"
 #include "compat.h"
 #include "byte-order.h"
+#include "checksum.h"
 
 #include "afr-transaction.h"
 #include "afr-self-heal.h"
@@ -42,6 +43,8 @@ static int
 sh_loop_return (call_frame_t *sh_frame, xlator_t *this, call_frame_t *loop_frame,
                 int32_t op_ret, int32_t op_errno);
 static int
+sh_loop_read (call_frame_t *loop_frame, xlator_t *this);
+static int
 sh_destroy_frame (call_frame_t *frame, xlator_t *this)
 {
         if (!frame)
@@ -63,6 +66,8 @@ sh_private_cleanup (call_frame_t *frame, xlator_t *this)
         sh    = &local->self_heal;
 
         sh_priv = sh->private;
+        if (sh_priv)
+                GF_FREE (sh_priv->dirty);
         GF_FREE (sh_priv);
 }
 
@@ -80,6 +85,79 @@ sh_number_of_writes_needed (unsigned char *write_needed, int child_count)
         return writes;
 }
 
+/* without a map from every brick taking part, everything is dirty */
+static gf_boolean_t
+sh_range_is_dirty (afr_sh_algo_private_t *sh_priv, off_t offset, off_t len)
+{
+        uint64_t        r    = 0;
+        uint64_t        last = 0;
+
+        if (!sh_priv->dirty_valid)
+                return _gf_true;
+
+        if (offset + len > sh_priv->dirty_tail)
+                return _gf_true;
+
+        last = (offset + len - 1) / sh_priv->dirty_region_size;
+        for (r = offset / sh_priv->dirty_region_size; r <= last; r++) {
+                if (r / 8 >= sh_priv->dirty_size)
+                        break;
+                if (sh_priv->dirty[r / 8] & (1 << (r % 8)))
+                        return _gf_true;
+        }
+
+        return _gf_false;
+}
+
+/* AIMD on the number of loops in flight: per-block latency of heal reads
+   and checksums above data-self-heal-latency-target means the bricks are
+   busy, so halve the window; below it, grow the window by one. Adjusted at
+   most once per window's worth of samples. */
+static void
+sh_throttle_sample (xlator_t *this, afr_sh_algo_private_t *sh_priv,
+                    struct timeval *issued, int blocks)
+{
+        afr_private_t  *priv    = NULL;
+        struct timeval  now     = {0,};
+        uint64_t        elapsed = 0;
+        uint64_t        target  = 0;
+
+        priv = this->private;
+        target = priv->data_self_heal_latency_target * 1000ULL;
+        if (!target)
+                return;
+
+        gettimeofday (&now, NULL);
+        elapsed = ((now.tv_sec - issued->tv_sec) * 1000000ULL) +
+                  now.tv_usec - issued->tv_usec;
+        if (blocks > 1)
+                elapsed /= blocks;
+
+        LOCK (&sh_priv->lock);
+        {
+                if (sh_priv->latency)
+                        sh_priv->latency = (sh_priv->latency * 7 +
+                                            elapsed) / 8;
+                else
+                        sh_priv->latency = elapsed;
+
+                if (++sh_priv->samples >= sh_priv->window) {
+                        sh_priv->samples = 0;
+                        if (sh_priv->latency > target) {
+                                if (sh_priv->window > 1)
+                                        sh_priv->window /= 2;
+                        } else if (sh_priv->window <
+                                   priv->data_self_heal_window_size) {
+                                sh_priv->window++;
+                        }
+                }
+
+                if (sh_priv->window > priv->data_self_heal_window_size)
+                        sh_priv->window = priv->data_self_heal_window_size;
+        }
+        UNLOCK (&sh_priv->lock);
+}
+
 
 static int
 sh_loop_driver_done (call_frame_t *sh_frame, xlator_t *this,
@@ -90,6 +168,7 @@ sh_loop_driver_done (call_frame_t *sh_frame, xlator_t *this,
         afr_sh_algo_private_t   *sh_priv      = NULL;
         int32_t                 total_blocks = 0;
         int32_t                 diff_blocks  = 0;
+        int32_t                 hole_blocks  = 0;
 
         local        = sh_frame->local;
         sh           = &local->self_heal;
@@ -97,6 +176,7 @@ sh_loop_driver_done (call_frame_t *sh_frame, xlator_t *this,
         if (sh_priv) {
                 total_blocks = sh_priv->total_blocks;
                 diff_blocks  = sh_priv->diff_blocks;
+                hole_blocks  = sh_priv->hole_blocks;
         }
 
         sh_private_cleanup (sh_frame, this);
@@ -112,7 +192,8 @@ sh_loop_driver_done (call_frame_t *sh_frame, xlator_t *this,
                 GF_ASSERT (last_loop_frame);
                 if (diff_blocks == total_blocks) {
                         gf_log (this->name, GF_LOG_DEBUG, "full self-heal "
-                                "completed on %s",local->loc.path);
+                                "completed on %s (%d blocks in holes not "
+                                "read)", local->loc.path, hole_blocks);
                 } else {
                         gf_log (this->name, GF_LOG_DEBUG,
                                 "diff self-heal on %s: completed. "
@@ -165,7 +246,7 @@ sh_loop_lock_success (call_frame_t *loop_frame, xlator_t *this)
         loop_sh->old_loop_frame = NULL;
 
         gf_log (this->name, GF_LOG_DEBUG, "Acquired lock for range %"PRIu64
-                " %"PRIu64, loop_sh->offset, loop_sh->block_size);
+                " %"PRIu64, loop_sh->loop_offset, loop_sh->loop_size);
         loop_sh->data_lock_held = _gf_true;
         loop_sh->sh_data_algo_start (loop_frame, this);
         return 0;
@@ -183,7 +264,7 @@ sh_loop_lock_failure (call_frame_t *loop_frame, xlator_t *this)
         sh_frame = loop_sh->sh_frame;
 
         gf_log (this->name, GF_LOG_ERROR, "failed lock for range %"PRIu64
-                " %"PRIu64, loop_sh->offset, loop_sh->block_size);
+                " %"PRIu64, loop_sh->loop_offset, loop_sh->loop_size);
         sh_loop_finish (loop_sh->old_loop_frame, this);
         loop_sh->old_loop_frame = NULL;
         sh_loop_return (sh_frame, this, loop_frame, -1, ENOTCONN);
@@ -200,6 +281,7 @@ sh_loop_frame_create (call_frame_t *sh_frame, xlator_t *this,
         afr_local_t                 *new_loop_local = NULL;
         afr_self_heal_t             *new_loop_sh    = NULL;
         afr_private_t               *priv           = NULL;
+        afr_sh_algo_private_t       *sh_priv        = NULL;
 
         GF_ASSERT (sh_frame);
         GF_ASSERT (loop_frame);
@@ -208,6 +290,7 @@ sh_loop_frame_create (call_frame_t *sh_frame, xlator_t *this,
         local   = sh_frame->local;
         sh      = &local->self_heal;
         priv    = this->private;
+        sh_priv = sh->private;
 
         new_loop_frame = copy_frame (sh_frame);
         if (!new_loop_frame)
@@ -229,10 +312,16 @@ sh_loop_frame_create (call_frame_t *sh_frame, xlator_t *this,
                                                gf_afr_mt_char);
         if (!new_loop_sh->write_needed)
                 goto out;
-        new_loop_sh->checksum = GF_CALLOC (priv->child_count, MD5_DIGEST_LENGTH,
+        new_loop_sh->checksum = GF_CALLOC (priv->child_count * sh_priv->batch,
+                                           MD5_DIGEST_LENGTH,
                                            gf_afr_mt_uint8_t);
         if (!new_loop_sh->checksum)
                 goto out;
+        new_loop_sh->block_diff = GF_CALLOC (priv->child_count * sh_priv->batch,
+                                             sizeof (*new_loop_sh->block_diff),
+                                             gf_afr_mt_char);
+        if (!new_loop_sh->block_diff)
+                goto out;
         new_loop_sh->inode      = inode_ref (sh->inode);
         new_loop_sh->sh_data_algo_start = sh->sh_data_algo_start;
         new_loop_sh->source = sh->source;
@@ -257,12 +346,14 @@ sh_loop_start (call_frame_t *sh_frame, xlator_t *this, off_t offset,
         afr_self_heal_t             *sh             = NULL;
         afr_local_t                 *new_loop_local = NULL;
         afr_self_heal_t             *new_loop_sh    = NULL;
+        afr_sh_algo_private_t       *sh_priv        = NULL;
         int                         ret             = 0;
 
         GF_ASSERT (sh_frame);
 
         local   = sh_frame->local;
         sh      = &local->self_heal;
+        sh_priv = sh->private;
 
         ret = sh_loop_frame_create (sh_frame, this, old_loop_frame,
                                     &new_loop_frame);
@@ -272,7 +363,9 @@ sh_loop_start (call_frame_t *sh_frame, xlator_t *this, off_t offset,
         new_loop_sh = &new_loop_local->self_heal;
         new_loop_sh->offset = offset;
         new_loop_sh->block_size = sh->block_size;
-        afr_sh_data_lock (new_loop_frame, this, offset, new_loop_sh->block_size,
+        new_loop_sh->loop_offset = offset;
+        new_loop_sh->loop_size = sh_priv->loop_size;
+        afr_sh_data_lock (new_loop_frame, this, offset, new_loop_sh->loop_size,
                           sh_loop_lock_success, sh_loop_lock_failure);
         return 0;
 out:
@@ -291,7 +384,8 @@ sh_loop_driver (call_frame_t *sh_frame, xlator_t *this,
         afr_self_heal_t *           sh             = NULL;
         afr_sh_algo_private_t       *sh_priv        = NULL;
         gf_boolean_t                is_driver_done = _gf_false;
-        blksize_t                   block_size     = 0;
+        off_t                       block_size     = 0;
+        unsigned int                window         = 0;
         int                         loop           = 0;
         off_t                       offset         = 0;
         afr_private_t               *priv          = NULL;
@@ -306,17 +400,33 @@ sh_loop_driver (call_frame_t *sh_frame, xlator_t *this,
                 if (!is_first_call)
                         sh_priv->loops_running--;
                 offset = sh_priv->offset;
-                block_size = sh->block_size;
+                block_size = sh_priv->loop_size;
+                window = priv->data_self_heal_window_size;
+                if (priv->data_self_heal_latency_target &&
+                    sh_priv->window < window)
+                        window = sh_priv->window;
                 while ((!sh->eof_reached) && (0 == sh->op_failed) &&
-                       (sh_priv->loops_running < priv->data_self_heal_window_size)
+                       (sh_priv->loops_running < window)
                        && (sh_priv->offset < sh->file_size)) {
 
+                        if (!sh_range_is_dirty (sh_priv, sh_priv->offset,
+                                                block_size)) {
+                                /* the loops spawned below take consecutive
+                                   ranges, the next call goes on from here */
+                                if (loop)
+                                        break;
+                                sh_priv->total_blocks +=
+                                        (min (block_size, sh->file_size -
+                                              sh_priv->offset) +
+                                         sh->block_size - 1) / sh->block_size;
+                                sh_priv->offset += block_size;
+                                offset = sh_priv->offset;
+                                continue;
+                        }
+
                         loop++;
                         sh_priv->offset += block_size;
                         sh_priv->loops_running++;
-
-                        if (!is_first_call)
-                                break;
                 }
                 if (0 == sh_priv->loops_running) {
                         is_driver_done = _gf_true;
@@ -397,6 +507,51 @@ sh_loop_return (call_frame_t *sh_frame, xlator_t *this, call_frame_t *loop_frame
         return 0;
 }
 
+/* copy the next block of the loop that differs on some sink; the full
+   algorithm has a single block and finds no next one */
+static int
+sh_loop_next_block (call_frame_t *loop_frame, xlator_t *this)
+{
+        afr_private_t           *priv       = NULL;
+        afr_local_t             *loop_local = NULL;
+        afr_self_heal_t         *loop_sh    = NULL;
+        call_frame_t            *sh_frame   = NULL;
+        afr_local_t             *sh_local   = NULL;
+        afr_self_heal_t         *sh         = NULL;
+        unsigned char           *diff       = NULL;
+
+        priv       = this->private;
+        loop_local = loop_frame->local;
+        loop_sh    = &loop_local->self_heal;
+
+        sh_frame = loop_sh->sh_frame;
+        sh_local = sh_frame->local;
+        sh       = &sh_local->self_heal;
+
+        for (; loop_sh->block_index < loop_sh->block_count;
+             loop_sh->block_index++) {
+                diff = loop_sh->block_diff +
+                       loop_sh->block_index * priv->child_count;
+                if (sh_number_of_writes_needed (diff, priv->child_count))
+                        break;
+        }
+
+        if (sh->op_failed || loop_sh->block_index >= loop_sh->block_count) {
+                sh_loop_return (sh_frame, this, loop_frame,
+                                loop_sh->op_ret, loop_sh->op_errno);
+                goto out;
+        }
+
+        memcpy (loop_sh->write_needed, diff, priv->child_count);
+        loop_sh->offset = loop_sh->loop_offset +
+                          loop_sh->block_index * loop_sh->block_size;
+        loop_sh->block_index++;
+
+        sh_loop_read (loop_frame, this);
+out:
+        return 0;
+}
+
 static int
 sh_loop_write_cbk (call_frame_t *loop_frame, void *cookie, xlator_t *this,
                    int32_t op_ret, int32_t op_errno, struct iatt *buf,
@@ -438,10 +593,8 @@ sh_loop_write_cbk (call_frame_t *loop_frame, void *cookie, xlator_t *this,
 
         call_count = afr_frame_return (loop_frame);
 
-        if (call_count == 0) {
-                sh_loop_return (sh_frame, this, loop_frame,
-                                loop_sh->op_ret, loop_sh->op_errno);
-        }
+        if (call_count == 0)
+                sh_loop_next_block (loop_frame, this);
 
         return 0;
 }
@@ -499,6 +652,8 @@ sh_loop_read_cbk (call_frame_t *loop_frame, void *cookie,
         sh_local = sh_frame->local;
         sh       = &sh_local->self_heal;
 
+        sh_throttle_sample (this, sh->private, &loop_sh->issued, 1);
+
         gf_log (this->name, GF_LOG_TRACE,
                 "read %d bytes of data from %s, offset %"PRId64"",
                 op_ret, loop_local->loc.path, loop_sh->offset);
@@ -559,6 +714,7 @@ sh_loop_read (call_frame_t *loop_frame, xlator_t *this)
         loop_local = loop_frame->local;
         loop_sh    = &loop_local->self_heal;
 
+        gettimeofday (&loop_sh->issued, NULL);
         STACK_WIND_COOKIE (loop_frame, sh_loop_read_cbk,
                            (void *) (long) loop_sh->source,
                            priv->children[loop_sh->source],
@@ -583,10 +739,17 @@ sh_diff_checksum_cbk (call_frame_t *loop_frame, void *cookie, xlator_t *this,
         afr_local_t                   *sh_local     = NULL;
         afr_self_heal_t               *sh           = NULL;
         afr_sh_algo_private_t         *sh_priv      = NULL;
+        data_t                        *digests      = NULL;
+        uint8_t                       *checksum     = NULL;
+        uint8_t                       *source_sum   = NULL;
         int                           child_index  = 0;
         int                           call_count   = 0;
         int                           i            = 0;
+        int                           b            = 0;
         int                           write_needed = 0;
+        int                           diff_blocks  = 0;
+        int32_t                       type         = GF_CHECKSUM_MD5;
+        gf_boolean_t                  mixed        = _gf_false;
 
         priv  = this->private;
 
@@ -600,6 +763,8 @@ sh_diff_checksum_cbk (call_frame_t *loop_frame, void *cookie, xlator_t *this,
         sh_priv = sh->private;
 
         child_index = (long) cookie;
+        checksum = loop_sh->checksum +
+                   child_index * sh_priv->batch * MD5_DIGEST_LENGTH;
 
         if (op_ret < 0) {
                 gf_log (this->name, GF_LOG_ERROR,
@@ -608,20 +773,68 @@ sh_diff_checksum_cbk (call_frame_t *loop_frame, void *cookie, xlator_t *this,
                         strerror (op_errno));
                 sh->op_failed = 1;
         } else {
-                memcpy (loop_sh->checksum + child_index * MD5_DIGEST_LENGTH,
-                        strong_checksum, MD5_DIGEST_LENGTH);
+                if (xdata && dict_get_int32 (xdata, GF_RCHECKSUM_STRONG_TYPE,
+                                             &type))
+                        type = GF_CHECKSUM_MD5;
+                LOCK (&loop_frame->lock);
+                {
+                        loop_sh->sum_types |= 1 << type;
+                }
+                UNLOCK (&loop_frame->lock);
+
+                if (xdata)
+                        digests = dict_get (xdata, GF_RCHECKSUM_BLOCK_DIGESTS);
+                if (digests && digests->len ==
+                    loop_sh->block_count * MD5_DIGEST_LENGTH) {
+                        memcpy (checksum, digests->data, digests->len);
+                } else {
+                        /* no per-block digests (older brick): every block
+                           gets the digest of the whole range, so the range
+                           is copied as a whole if it differs anywhere */
+                        for (b = 0; b < loop_sh->block_count; b++)
+                                memcpy (checksum + b * MD5_DIGEST_LENGTH,
+                                        strong_checksum, MD5_DIGEST_LENGTH);
+                }
         }
 
         call_count = afr_frame_return (loop_frame);
 
         if (call_count == 0) {
-                for (i = 0; i < priv->child_count; i++) {
-                        if (sh->sources[i] || !sh_local->child_up[i])
-                                continue;
+                sh_throttle_sample (this, sh_priv, &loop_sh->issued,
+                                    loop_sh->block_count);
+
+                source_sum = loop_sh->checksum + sh->source *
+                             sh_priv->batch * MD5_DIGEST_LENGTH;
+
+                /* a brick which does not know the faster checksum replied
+                   MD5: nothing compares, and the next loops ask for MD5 */
+                if (loop_sh->sum_types & (loop_sh->sum_types - 1)) {
+                        gf_log (this->name, GF_LOG_DEBUG,
+                                "bricks of %s replied different checksum "
+                                "types, falling back to md5",
+                                sh_local->loc.path);
+                        mixed = _gf_true;
+                        LOCK (&sh_priv->lock);
+                        {
+                                sh_priv->strong_type = GF_CHECKSUM_MD5;
+                        }
+                        UNLOCK (&sh_priv->lock);
+                }
 
-                        if (memcmp (loop_sh->checksum + (i * MD5_DIGEST_LENGTH),
-                                    loop_sh->checksum + (sh->source * MD5_DIGEST_LENGTH),
-                                    MD5_DIGEST_LENGTH)) {
+                for (b = 0; b < loop_sh->block_count; b++) {
+                        write_needed = 0;
+                        for (i = 0; i < priv->child_count; i++) {
+                                if (sh->sources[i] || !sh_local->child_up[i])
+                                        continue;
+
+                                checksum = loop_sh->checksum +
+                                           i * sh_priv->batch *
+                                           MD5_DIGEST_LENGTH;
+                                if (!mixed &&
+                                    !memcmp (checksum + b * MD5_DIGEST_LENGTH,
+                                             source_sum + b * MD5_DIGEST_LENGTH,
+                                             MD5_DIGEST_LENGTH))
+                                        continue;
                                 /*
                                   Checksums differ, so this block
                                   must be written to this sink
@@ -630,22 +843,27 @@ sh_diff_checksum_cbk (call_frame_t *loop_frame, void *cookie, xlator_t *this,
                                 gf_log (this->name, GF_LOG_DEBUG,
                                         "checksum on subvolume %s at offset %"
                                         PRId64" differs from that on source",
-                                        priv->children[i]->name, loop_sh->offset);
+                                        priv->children[i]->name,
+                                        loop_sh->loop_offset +
+                                        b * loop_sh->block_size);
 
-                                write_needed = loop_sh->write_needed[i] = 1;
+                                loop_sh->block_diff[b * priv->child_count + i] = 1;
+                                write_needed = 1;
                         }
+                        if (write_needed)
+                                diff_blocks++;
                 }
 
                 LOCK (&sh_priv->lock);
                 {
-                        sh_priv->total_blocks++;
-                        if (write_needed)
-                                sh_priv->diff_blocks++;
+                        sh_priv->total_blocks += loop_sh->block_count;
+                        sh_priv->diff_blocks += diff_blocks;
                 }
                 UNLOCK (&sh_priv->lock);
 
-                if (write_needed && !sh->op_failed) {
-                        sh_loop_read (loop_frame, this);
+                if (diff_blocks && !sh->op_failed) {
+                        loop_sh->block_index = 0;
+                        sh_loop_next_block (loop_frame, this);
                 } else {
                         sh_loop_return (sh_frame, this, loop_frame,
                                         op_ret, op_errno);
@@ -661,6 +879,12 @@ sh_diff_checksum (call_frame_t *loop_frame, xlator_t *this)
         afr_private_t           *priv         = NULL;
         afr_local_t             *loop_local   = NULL;
         afr_self_heal_t         *loop_sh      = NULL;
+        call_frame_t            *sh_frame     = NULL;
+        afr_local_t             *sh_local     = NULL;
+        afr_self_heal_t         *sh           = NULL;
+        afr_sh_algo_private_t   *sh_priv      = NULL;
+        dict_t                  *xdata        = NULL;
+        off_t                   len           = 0;
         int                     call_count    = 0;
         int                     i             = 0;
 
@@ -668,16 +892,43 @@ sh_diff_checksum (call_frame_t *loop_frame, xlator_t *this)
         loop_local   = loop_frame->local;
         loop_sh      = &loop_local->self_heal;
 
+        sh_frame = loop_sh->sh_frame;
+        sh_local = sh_frame->local;
+        sh       = &sh_local->self_heal;
+        sh_priv  = sh->private;
+
+        /* the blocks of this loop's range that are before eof, checksummed
+           with one rchecksum per subvolume */
+        len = min (loop_sh->loop_size, sh->file_size - loop_sh->loop_offset);
+        loop_sh->block_count = (len + loop_sh->block_size - 1) /
+                               loop_sh->block_size;
+        if (loop_sh->block_count < 1)
+                loop_sh->block_count = 1;
+        len = loop_sh->block_count * loop_sh->block_size;
+
+        /* without xdata every brick replies MD5 of the whole range */
+        xdata = dict_new ();
+        if (xdata && ((loop_sh->block_count > 1 &&
+                       dict_set_int32 (xdata, GF_RCHECKSUM_BLOCK_SIZE,
+                                       loop_sh->block_size)) ||
+                      dict_set_int32 (xdata, GF_RCHECKSUM_STRONG_TYPE,
+                                      sh_priv->strong_type))) {
+                dict_unref (xdata);
+                xdata = NULL;
+        }
+        loop_sh->sum_types = 0;
+
         call_count = loop_sh->active_sinks + 1;  /* sinks and source */
 
         loop_local->call_count = call_count;
 
+        gettimeofday (&loop_sh->issued, NULL);
         STACK_WIND_COOKIE (loop_frame, sh_diff_checksum_cbk,
                            (void *) (long) loop_sh->source,
                            priv->children[loop_sh->source],
                            priv->children[loop_sh->source]->fops->rchecksum,
                            loop_sh->healing_fd,
-                           loop_sh->offset, loop_sh->block_size, NULL);
+                           loop_sh->loop_offset, len, xdata);
 
         for (i = 0; i < priv->child_count; i++) {
                 if (loop_sh->sources[i] || !loop_local->child_up[i])
@@ -688,12 +939,139 @@ sh_diff_checksum (call_frame_t *loop_frame, xlator_t *this)
                                    priv->children[i],
                                    priv->children[i]->fops->rchecksum,
                                    loop_sh->healing_fd,
-                                   loop_sh->offset, loop_sh->block_size, NULL);
+                                   loop_sh->loop_offset, len, xdata);
 
                 if (!--call_count)
                         break;
         }
 
+        if (xdata)
+                dict_unref (xdata);
+
+        return 0;
+}
+
+/* 1 when the block at offset is in a hole of the source, 0 in data, -1 when
+   the extent known does not cover it */
+static int
+sh_full_block_in_hole (afr_sh_algo_private_t *sh_priv, off_t offset,
+                       off_t len)
+{
+        int     ret = -1;
+
+        LOCK (&sh_priv->lock);
+        {
+                if ((offset >= sh_priv->extent_start) &&
+                    (offset + len <= sh_priv->extent_end))
+                        ret = sh_priv->extent_is_hole;
+        }
+        UNLOCK (&sh_priv->lock);
+
+        return ret;
+}
+
+static int
+sh_full_copy_block (call_frame_t *loop_frame, xlator_t *this)
+{
+        afr_private_t           *priv         = NULL;
+        afr_local_t             *loop_local   = NULL;
+        afr_self_heal_t         *loop_sh      = NULL;
+        call_frame_t            *sh_frame     = NULL;
+        afr_local_t             *sh_local     = NULL;
+        afr_self_heal_t         *sh           = NULL;
+        afr_sh_algo_private_t   *sh_priv      = NULL;
+        off_t                   len           = 0;
+
+        priv         = this->private;
+        loop_local   = loop_frame->local;
+        loop_sh      = &loop_local->self_heal;
+        sh_frame     = loop_sh->sh_frame;
+        sh_local     = sh_frame->local;
+        sh           = &sh_local->self_heal;
+        sh_priv      = sh->private;
+
+        len = min (loop_sh->block_size, sh->file_size - loop_sh->offset);
+
+        /* the zeroes of a hole need no reading, and no writing to the sinks
+           trimmed up past it: they read zeroes there already */
+        if (sh_full_block_in_hole (sh_priv, loop_sh->offset, len) == 1) {
+                sh_prune_writes_needed (sh_frame, loop_frame, priv);
+                if (!sh_number_of_writes_needed (loop_sh->write_needed,
+                                                 priv->child_count)) {
+                        LOCK (&sh_priv->lock);
+                        {
+                                sh_priv->hole_blocks++;
+                        }
+                        UNLOCK (&sh_priv->lock);
+                        sh_loop_return (sh_frame, this, loop_frame, 0, 0);
+                        return 0;
+                }
+        }
+
+        sh_loop_read (loop_frame, this);
+        return 0;
+}
+
+static int
+sh_full_seek_cbk (call_frame_t *loop_frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, off_t offset,
+                  dict_t *xdata)
+{
+        afr_private_t           *priv         = NULL;
+        afr_local_t             *loop_local   = NULL;
+        afr_self_heal_t         *loop_sh      = NULL;
+        afr_local_t             *sh_local     = NULL;
+        afr_self_heal_t         *sh           = NULL;
+        afr_sh_algo_private_t   *sh_priv      = NULL;
+        gf_seek_what_t          what          = (long) cookie;
+        gf_boolean_t            seek_hole     = _gf_false;
+
+        priv         = this->private;
+        loop_local   = loop_frame->local;
+        loop_sh      = &loop_local->self_heal;
+        sh_local     = loop_sh->sh_frame->local;
+        sh           = &sh_local->self_heal;
+        sh_priv      = sh->private;
+
+        LOCK (&sh_priv->lock);
+        {
+                if ((op_ret == -1) && (op_errno == ENXIO)) {
+                        /* no data past the offset */
+                        sh_priv->extent_is_hole = _gf_true;
+                        sh_priv->extent_start = loop_sh->offset;
+                        sh_priv->extent_end = sh->file_size;
+                } else if (op_ret == -1) {
+                        /* old bricks, or a backend without SEEK_DATA */
+                        gf_log (this->name, GF_LOG_DEBUG, "seek on %s "
+                                "failed (%s), reading the holes",
+                                sh_local->loc.path, strerror (op_errno));
+                        sh_priv->no_seek = _gf_true;
+                } else if (what == GF_SEEK_HOLE) {
+                        sh_priv->extent_is_hole = _gf_false;
+                        sh_priv->extent_start = loop_sh->offset;
+                        sh_priv->extent_end = offset;
+                } else if (offset > loop_sh->offset) {
+                        sh_priv->extent_is_hole = _gf_true;
+                        sh_priv->extent_start = loop_sh->offset;
+                        sh_priv->extent_end = offset;
+                } else {
+                        /* in data: find where it ends */
+                        seek_hole = _gf_true;
+                }
+        }
+        UNLOCK (&sh_priv->lock);
+
+        if (seek_hole) {
+                STACK_WIND_COOKIE (loop_frame, sh_full_seek_cbk,
+                                   (void *) (long) GF_SEEK_HOLE,
+                                   priv->children[loop_sh->source],
+                                   priv->children[loop_sh->source]->fops->seek,
+                                   loop_sh->healing_fd, loop_sh->offset,
+                                   GF_SEEK_HOLE, NULL);
+                return 0;
+        }
+
+        sh_full_copy_block (loop_frame, this);
         return 0;
 }
 
@@ -703,18 +1081,37 @@ sh_full_read_write_to_sinks (call_frame_t *loop_frame, xlator_t *this)
         afr_private_t           *priv         = NULL;
         afr_local_t             *loop_local   = NULL;
         afr_self_heal_t         *loop_sh      = NULL;
+        afr_local_t             *sh_local     = NULL;
+        afr_sh_algo_private_t   *sh_priv      = NULL;
+        off_t                   len           = 0;
         int                     i             = 0;
 
         priv         = this->private;
         loop_local   = loop_frame->local;
         loop_sh      = &loop_local->self_heal;
+        sh_local     = loop_sh->sh_frame->local;
+        sh_priv      = sh_local->self_heal.private;
 
         for (i = 0; i < priv->child_count; i++) {
                 if (loop_sh->sources[i] || !loop_local->child_up[i])
                         continue;
                 loop_sh->write_needed[i] = 1;
         }
-        sh_loop_read (loop_frame, this);
+
+        len = min (loop_sh->block_size,
+                   sh_local->self_heal.file_size - loop_sh->offset);
+        if (!loop_sh->file_has_holes || sh_priv->no_seek ||
+            (sh_full_block_in_hole (sh_priv, loop_sh->offset, len) != -1)) {
+                sh_full_copy_block (loop_frame, this);
+                return 0;
+        }
+
+        STACK_WIND_COOKIE (loop_frame, sh_full_seek_cbk,
+                           (void *) (long) GF_SEEK_DATA,
+                           priv->children[loop_sh->source],
+                           priv->children[loop_sh->source]->fops->seek,
+                           loop_sh->healing_fd, loop_sh->offset,
+                           GF_SEEK_DATA, NULL);
         return 0;
 }
 
@@ -760,6 +1157,7 @@ afr_sh_start_loops (call_frame_t *sh_frame, xlator_t *this,
         call_frame_t            *first_loop_frame = NULL;
         afr_local_t             *local   = NULL;
         afr_self_heal_t         *sh      = NULL;
+        afr_sh_algo_private_t   *sh_priv = NULL;
         int                     ret      = 0;
         afr_private_t           *priv    = NULL;
 
@@ -769,15 +1167,25 @@ afr_sh_start_loops (call_frame_t *sh_frame, xlator_t *this,
 
         sh->sh_data_algo_start = sh_data_algo_start;
         local->call_count = 0;
-        ret = sh_loop_frame_create (sh_frame, this, NULL, &first_loop_frame);
-        if (ret)
-                goto out;
-        afr_sh_transfer_lock (first_loop_frame, sh_frame, priv->child_count);
-        sh->private = afr_sh_priv_init ();
+        if (!sh->private)
+                sh->private = afr_sh_priv_init ();
         if (!sh->private) {
                 ret = -1;
                 goto out;
         }
+        sh_priv = sh->private;
+        sh_priv->batch = 1;
+        sh_priv->strong_type = GF_CHECKSUM_MURMUR3;
+        if ((sh_data_algo_start == sh_diff_checksum) &&
+            priv->data_self_heal_checksum_batch)
+                sh_priv->batch = priv->data_self_heal_checksum_batch;
+        sh_priv->loop_size = sh_priv->batch * sh->block_size;
+        sh_priv->window = priv->data_self_heal_window_size;
+
+        ret = sh_loop_frame_create (sh_frame, this, NULL, &first_loop_frame);
+        if (ret)
+                goto out;
+        afr_sh_transfer_lock (first_loop_frame, sh_frame, priv->child_count);
         sh_loop_driver (sh_frame, this, _gf_true, first_loop_frame);
         ret = 0;
 out:
@@ -788,10 +1196,158 @@ out:
         return 0;
 }
 
+static int
+sh_diff_dirty_regions_cbk (call_frame_t *sh_frame, void *cookie,
+                           xlator_t *this, int32_t op_ret, int32_t op_errno,
+                           dict_t *dict, dict_t *xdata)
+{
+        afr_private_t           *priv        = NULL;
+        afr_local_t             *local       = NULL;
+        afr_self_heal_t         *sh          = NULL;
+        afr_sh_algo_private_t   *sh_priv     = NULL;
+        data_t                  *data        = NULL;
+        unsigned char           *dirty       = NULL;
+        uint64_t                 region_size = 0;
+        uint64_t                 tail        = 0;
+        size_t                   size        = 0;
+        size_t                   i           = 0;
+        int                      child_index = 0;
+        int                      call_count  = 0;
+
+        priv    = this->private;
+        local   = sh_frame->local;
+        sh      = &local->self_heal;
+        sh_priv = sh->private;
+        child_index = (long) cookie;
+
+        if (op_ret == 0 && dict)
+                data = dict_get (dict, GF_XATTROP_DIRTY_REGIONS);
+
+        LOCK (&sh_frame->lock);
+        {
+                if (!data || (data->len < 2 * sizeof (uint64_t))) {
+                        gf_log (this->name, GF_LOG_DEBUG, "%s: no dirty "
+                                "region map from %s (%s)", local->loc.path,
+                                priv->children[child_index]->name,
+                                strerror (op_ret ? op_errno : ENODATA));
+                        sh_priv->dirty_valid = _gf_false;
+                        goto unlock;
+                }
+
+                memcpy (&region_size, data->data, sizeof (region_size));
+                memcpy (&tail, data->data + sizeof (region_size),
+                        sizeof (tail));
+                region_size = ntoh64 (region_size);
+                tail = ntoh64 (tail);
+                size = data->len - 2 * sizeof (uint64_t);
+
+                /* a sink out of the index missed writes but took none;
+                   the source has to have tracked what it took */
+                if (!region_size && child_index != sh->source)
+                        goto unlock;
+
+                if (!region_size || (sh_priv->dirty_region_size &&
+                                     sh_priv->dirty_region_size != region_size)) {
+                        sh_priv->dirty_valid = _gf_false;
+                        goto unlock;
+                }
+                sh_priv->dirty_region_size = region_size;
+                sh_priv->dirty_tail = min (sh_priv->dirty_tail, tail);
+
+                if (size > sh_priv->dirty_size) {
+                        dirty = GF_REALLOC (sh_priv->dirty, size);
+                        if (!dirty) {
+                                sh_priv->dirty_valid = _gf_false;
+                                goto unlock;
+                        }
+                        memset (dirty + sh_priv->dirty_size, 0,
+                                size - sh_priv->dirty_size);
+                        sh_priv->dirty = dirty;
+                        sh_priv->dirty_size = size;
+                }
+                for (i = 0; i < size; i++)
+                        sh_priv->dirty[i] |= data->data[2 * sizeof (uint64_t)
+                                                        + i];
+        }
+unlock:
+        call_count = --local->call_count;
+        UNLOCK (&sh_frame->lock);
+
+        if (call_count)
+                return 0;
+
+        if (sh_priv->dirty_valid)
+                gf_log (this->name, GF_LOG_DEBUG, "%s: healing only the "
+                        "regions in the dirty region maps", local->loc.path);
+
+        afr_sh_start_loops (sh_frame, this, sh_diff_checksum);
+        return 0;
+}
+
+/* the bricks that track writes to files needing heal tell which regions
+   can differ; ask the source and every sink */
+static int
+sh_diff_dirty_regions (call_frame_t *sh_frame, xlator_t *this)
+{
+        afr_private_t           *priv       = NULL;
+        afr_local_t             *local      = NULL;
+        afr_self_heal_t         *sh         = NULL;
+        afr_sh_algo_private_t   *sh_priv    = NULL;
+        int                     call_count  = 0;
+        int                     i           = 0;
+
+        priv  = this->private;
+        local = sh_frame->local;
+        sh    = &local->self_heal;
+
+        sh->private = afr_sh_priv_init ();
+        if (!sh->private)
+                goto out;
+        sh_priv = sh->private;
+        sh_priv->dirty_valid = _gf_true;
+        sh_priv->dirty_tail = UINT64_MAX;
+
+        call_count = sh->active_sinks + 1;
+        local->call_count = call_count;
+
+        STACK_WIND_COOKIE (sh_frame, sh_diff_dirty_regions_cbk,
+                           (void *) (long) sh->source,
+                           priv->children[sh->source],
+                           priv->children[sh->source]->fops->getxattr,
+                           &local->loc, GF_XATTROP_DIRTY_REGIONS, NULL);
+
+        for (i = 0; i < priv->child_count; i++) {
+                if (sh->sources[i] || !local->child_up[i])
+                        continue;
+
+                STACK_WIND_COOKIE (sh_frame, sh_diff_dirty_regions_cbk,
+                                   (void *) (long) i,
+                                   priv->children[i],
+                                   priv->children[i]->fops->getxattr,
+                                   &local->loc, GF_XATTROP_DIRTY_REGIONS,
+                                   NULL);
+
+                if (!--call_count)
+                        break;
+        }
+
+        return 0;
+out:
+        afr_sh_start_loops (sh_frame, this, sh_diff_checksum);
+        return 0;
+}
+
 int
 afr_sh_algo_diff (call_frame_t *sh_frame, xlator_t *this)
 {
-        afr_sh_start_loops (sh_frame, this, sh_diff_checksum);
+        afr_private_t   *priv = NULL;
+
+        priv = this->private;
+
+        if (priv->data_self_heal_dirty_regions)
+                sh_diff_dirty_regions (sh_frame, this);
+        else
+                afr_sh_start_loops (sh_frame, this, sh_diff_checksum);
         return 0;
 }
 
@@ -24,9 +24,35 @@ typedef struct {
         gf_lock_t lock;
         unsigned int loops_running;
         off_t offset;
+        off_t loop_size;
+        unsigned int batch;
+
+        /* loops allowed in flight, shrunk while heal i/o is slower than
+           data-self-heal-latency-target */
+        unsigned int window;
+        uint64_t latency;
+        unsigned int samples;
+
+        /* union of the dirty region maps of source and sinks */
+        gf_boolean_t dirty_valid;
+        uint64_t dirty_region_size;
+        uint64_t dirty_tail;
+        unsigned char *dirty;
+        size_t dirty_size;
 
         int32_t total_blocks;
         int32_t diff_blocks;
+
+        /* strong checksum asked of the bricks, MD5 once they disagreed */
+        int32_t strong_type;
+
+        /* last extent of the source found by seek, hole or data; the full
+           algorithm does not read the blocks of its holes */
+        gf_boolean_t no_seek;
+        gf_boolean_t extent_is_hole;
+        off_t extent_start;
+        off_t extent_end;
+        int32_t hole_blocks;
 } afr_sh_algo_private_t;
 
 #endif /* __AFR_SELF_HEAL_ALGORITHM_H__ */
@@ -2098,6 +2098,7 @@ afr_local_t *afr_local_copy (afr_local_t *l, xlator_t *this)
         shc->force_confirm_spb = sh->force_confirm_spb;
         shc->forced_merge = sh->forced_merge;
         shc->background = sh->background;
+        shc->scrub_bad = sh->scrub_bad;
         shc->type = sh->type;
 
         uuid_copy (shc->sh_gfid_req, sh->sh_gfid_req);
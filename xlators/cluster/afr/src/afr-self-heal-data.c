@@ -458,6 +458,11 @@ afr_sh_data_pick_algo (call_frame_t *frame, xlator_t *this)
         sh    = &local->self_heal;
         algo  = sh_algo_from_name (this, priv->data_self_heal_algorithm);
 
+        /* a corrupted copy may differ anywhere, even where its checksums
+           happen to agree: rewrite all of it */
+        if (sh->scrub_bad)
+                algo = sh_algo_from_name (this, "full");
+
         if (algo == NULL) {
                 /* option not set, so fall back on heuristics */
 
@@ -669,6 +674,56 @@ afr_sh_data_fix (call_frame_t *frame, xlator_t *this)
         afr_sh_data_trim_sinks (frame, this);
 }
 
+/* copies the brick scrubber found corrupted are never sources: heal them
+   from the others even when the changelog has nothing pending */
+static int
+afr_sh_data_exclude_scrub_bad (xlator_t *this, afr_local_t *local,
+                               int nsources)
+{
+        afr_self_heal_t *sh    = NULL;
+        afr_private_t   *priv  = NULL;
+        int              child = -1;
+        int              good  = 0;
+        int              i     = 0;
+
+        sh = &local->self_heal;
+        priv = this->private;
+
+        for (i = 0; i < priv->child_count; i++) {
+                child = sh->success_children[i];
+                if (child == -1)
+                        break;
+                if (!(sh->scrub_bad & (1ULL << child)))
+                        good++;
+        }
+
+        if (good == 0) {
+                gf_log (this->name, GF_LOG_ERROR, "%s: no copy left which "
+                        "passed scrubbing", local->loc.path);
+                return nsources;
+        }
+
+        for (i = 0; i < priv->child_count; i++)
+                if (sh->scrub_bad & (1ULL << i))
+                        sh->sources[i] = 0;
+
+        if (afr_sh_source_count (sh->sources, priv->child_count) == 0) {
+                for (i = 0; i < priv->child_count; i++) {
+                        child = sh->success_children[i];
+                        if (child == -1)
+                                break;
+                        if (!(sh->scrub_bad & (1ULL << child)))
+                                sh->sources[child] = 1;
+                }
+        }
+
+        gf_log (this->name, GF_LOG_INFO, "%s: healing copies which failed "
+                "scrubbing", local->loc.path);
+
+        return afr_sh_source_count (sh->sources, priv->child_count);
+}
+
+
 int
 afr_sh_data_fxattrop_fstat_done (call_frame_t *frame, xlator_t *this)
 {
@@ -716,6 +771,10 @@ afr_sh_data_fxattrop_fstat_done (call_frame_t *frame, xlator_t *this)
         }
 
         sh->data_spb = _gf_false;
+        if (sh->scrub_bad)
+                nsources = afr_sh_data_exclude_scrub_bad (this, local,
+                                                          nsources);
+
         ret = afr_sh_inode_set_read_ctx (sh, this);
         if (ret) {
                 gf_log (this->name, GF_LOG_DEBUG,
@@ -305,6 +305,9 @@ afr_sh_metadata_getxattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                 for (i = 0; i < priv->child_count; i++) {
                         dict_del (xattr, priv->pending_key[i]);
                 }
+                /* per copy, kept by the brick of each */
+                dict_del (xattr, GF_SCRUB_SIGN_KEY);
+                dict_del (xattr, GF_SCRUB_BAD_KEY);
 
                 afr_sh_metadata_sync (frame, this, xattr);
         }
@@ -20,7 +20,10 @@
 #include "event-history.h"
 
 typedef enum {
-        STOP_CRAWL_ON_SINGLE_SUBVOL = 1
+        STOP_CRAWL_ON_SINGLE_SUBVOL = 1,
+        /* entries are healed, the index heal-concurrency at a time, and
+           counted in shd->progress */
+        SHD_HEAL_CRAWL = 2,
 } afr_crawl_flags_t;
 
 typedef enum {
@@ -45,6 +48,24 @@ typedef struct shd_pos_ {
         afr_child_pos_t pos;
 } shd_pos_t;
 
+/* one readdir worth of index entries, healed concurrently by the crawl */
+typedef struct shd_heal_batch_ {
+        xlator_t          *this;
+        gf_lock_t         lock;
+        afr_crawl_data_t  *crawl_data;
+        loc_t             *parent;
+        struct synctask   *crawler;
+        int               inflight;
+        gf_boolean_t      waiting;
+} shd_heal_batch_t;
+
+typedef struct shd_heal_ {
+        loc_t             loc;
+        struct iatt       iattr;
+        gf_dirent_t       *entry;
+        shd_heal_batch_t  *batch;
+} shd_heal_t;
+
 typedef int
 (*afr_crawl_done_cbk_t)  (int ret, call_frame_t *sync_frame, void *crawl_data);
 
@@ -332,6 +353,15 @@ _crawl_post_sh_action (xlator_t *this, loc_t *parent, loc_t *child,
                 eh = shd->heal_failed;
         else
                 eh = shd->healed;
+
+        LOCK (&priv->lock);
+        {
+                if (eh == shd->healed)
+                        shd->progress[crawl_data->child].healed++;
+                else
+                        shd->progress[crawl_data->child].failed++;
+        }
+        UNLOCK (&priv->lock);
         ret = -1;
         event = GF_CALLOC (1, sizeof (*event), gf_afr_mt_shd_event_t);
         if (!event)
@@ -382,7 +412,8 @@ void
 _do_self_heal_on_subvol (xlator_t *this, int child, afr_crawl_type_t crawl)
 {
         afr_start_crawl (this, child, crawl, _self_heal_entry,
-                         NULL, _gf_true, STOP_CRAWL_ON_SINGLE_SUBVOL,
+                         NULL, _gf_true,
+                         STOP_CRAWL_ON_SINGLE_SUBVOL | SHD_HEAL_CRAWL,
                          afr_crawl_done);
 }
 
@@ -424,6 +455,78 @@ out:
         return proceed;
 }
 
+static void
+_shd_progress_add (xlator_t *this, int child, uint64_t crawled)
+{
+        afr_private_t           *priv = NULL;
+
+        priv = this->private;
+        LOCK (&priv->lock);
+        {
+                priv->shd.progress[child].crawled += crawled;
+        }
+        UNLOCK (&priv->lock);
+}
+
+int
+_add_progress_to_dict (xlator_t *this, dict_t *output, int child)
+{
+        afr_private_t           *priv = NULL;
+        afr_shd_progress_t      progress = {0};
+        char                    key[256] = {0};
+        time_t                  elapsed = 0;
+        int                     xl_id = 0;
+        int                     ret = 0;
+
+        priv = this->private;
+        LOCK (&priv->lock);
+        {
+                progress = priv->shd.progress[child];
+        }
+        UNLOCK (&priv->lock);
+
+        if (!progress.start)
+                goto out;
+
+        ret = dict_get_int32 (output, this->name, &xl_id);
+        if (ret)
+                goto out;
+
+        elapsed = (progress.end ? progress.end : time (NULL)) - progress.start;
+        if (elapsed < 1)
+                elapsed = 1;
+
+        snprintf (key, sizeof (key), "%d-%d-progress-start", xl_id, child);
+        ret = dict_set_uint32 (output, key, progress.start);
+        if (ret)
+                goto out;
+        snprintf (key, sizeof (key), "%d-%d-progress-end", xl_id, child);
+        ret = dict_set_uint32 (output, key, progress.end);
+        if (ret)
+                goto out;
+        snprintf (key, sizeof (key), "%d-%d-progress-crawled", xl_id, child);
+        ret = dict_set_uint64 (output, key, progress.crawled);
+        if (ret)
+                goto out;
+        snprintf (key, sizeof (key), "%d-%d-progress-healed", xl_id, child);
+        ret = dict_set_uint64 (output, key, progress.healed);
+        if (ret)
+                goto out;
+        snprintf (key, sizeof (key), "%d-%d-progress-failed", xl_id, child);
+        ret = dict_set_uint64 (output, key, progress.failed);
+        if (ret)
+                goto out;
+        /* entries per minute */
+        snprintf (key, sizeof (key), "%d-%d-progress-rate", xl_id, child);
+        ret = dict_set_uint64 (output, key, (progress.healed +
+                                             progress.failed) * 60 / elapsed);
+out:
+        if (ret)
+                gf_log (this->name, GF_LOG_ERROR, "Could not add heal "
+                        "progress of %s", priv->children[child]->name);
+        return ret;
+}
+
 int
 _do_crawl_op_on_local_subvols (xlator_t *this, afr_crawl_type_t crawl,
                                shd_crawl_op op, dict_t *output)
@@ -473,6 +576,8 @@ _do_crawl_op_on_local_subvols (xlator_t *this, afr_crawl_type_t crawl,
                                                          _add_summary_to_dict,
                                                          output, _gf_false, 0,
                                                          NULL);
+                                        _add_progress_to_dict (this, output,
+                                                               i);
                                 }
                         }
                         snprintf (key, sizeof (key), "%d-%d-%s", xl_id,
@@ -905,6 +1010,9 @@ _process_entries (xlator_t *this, loc_t *parentloc, gf_dirent_t *entries,
                 if (ret)
                         goto out;
 
+                if (crawl_data->crawl_flags & SHD_HEAL_CRAWL)
+                        _shd_progress_add (this, crawl_data->child, 1);
+
                 ret = crawl_data->process_entry (this, crawl_data, entry,
                                                  &entry_loc, parentloc, &iattr);
 
@@ -933,6 +1041,188 @@ out:
         return ret;
 }
 
+/* directories first, their entry heal creates the files that the data
+   heals below need; then small files before large ones, so that most of
+   the backlog drains early */
+static int
+_shd_heal_cmp (const void *a, const void *b)
+{
+        const shd_heal_t        *h1 = a;
+        const shd_heal_t        *h2 = b;
+        gf_boolean_t            dir1 = IA_ISDIR (h1->iattr.ia_type);
+        gf_boolean_t            dir2 = IA_ISDIR (h2->iattr.ia_type);
+
+        if (dir1 != dir2)
+                return dir1 ? -1 : 1;
+        if (h1->iattr.ia_size != h2->iattr.ia_size)
+                return (h1->iattr.ia_size < h2->iattr.ia_size) ? -1 : 1;
+        return 0;
+}
+
+static int
+_shd_heal_task (void *data)
+{
+        shd_heal_t              *heal = data;
+        shd_heal_batch_t        *batch = heal->batch;
+
+        return batch->crawl_data->process_entry (batch->this,
+                                                 batch->crawl_data,
+                                                 heal->entry, &heal->loc,
+                                                 batch->parent, &heal->iattr);
+}
+
+static int
+_shd_heal_done (int ret, call_frame_t *sync_frame, void *data)
+{
+        shd_heal_t              *heal = data;
+        shd_heal_batch_t        *batch = heal->batch;
+        struct synctask         *crawler = NULL;
+
+        /* the crawler may free the batch as soon as the lock is dropped */
+        LOCK (&batch->lock);
+        {
+                batch->inflight--;
+                if (batch->waiting) {
+                        batch->waiting = _gf_false;
+                        crawler = batch->crawler;
+                }
+        }
+        UNLOCK (&batch->lock);
+
+        STACK_DESTROY (sync_frame->root);
+        if (crawler)
+                synctask_wake (crawler);
+        return 0;
+}
+
+/* suspend the crawl task until no more than @limit heals are in flight */
+static void
+_shd_heal_wait (shd_heal_batch_t *batch, int limit)
+{
+        LOCK (&batch->lock);
+        while (batch->inflight > limit) {
+                batch->waiting = _gf_true;
+                UNLOCK (&batch->lock);
+
+                batch->crawler->state = SYNCTASK_SUSPEND;
+                synctask_yield (batch->crawler);
+
+                LOCK (&batch->lock);
+        }
+        UNLOCK (&batch->lock);
+}
+
+static int
+_process_index_entries (xlator_t *this, loc_t *parentloc,
+                        gf_dirent_t *entries, off_t *offset,
+                        afr_crawl_data_t *crawl_data)
+{
+        afr_private_t           *priv = NULL;
+        gf_dirent_t             *entry = NULL;
+        shd_heal_t              *heals = NULL;
+        shd_heal_batch_t        batch = {0};
+        call_frame_t            *frame = NULL;
+        struct iatt             parent = {0};
+        int                     total = 0;
+        int                     count = 0;
+        int                     limit = 0;
+        int                     i = 0;
+        int                     ret = 0;
+
+        priv = this->private;
+
+        list_for_each_entry (entry, &entries->list, list)
+                total++;
+        heals = GF_CALLOC (total, sizeof (*heals), gf_afr_mt_shd_heal_t);
+        if (!heals) {
+                ret = -1;
+                goto out;
+        }
+
+        LOCK_INIT (&batch.lock);
+        batch.this = this;
+        batch.crawl_data = crawl_data;
+        batch.parent = parentloc;
+        batch.crawler = synctask_get ();
+
+        list_for_each_entry (entry, &entries->list, list) {
+                *offset = entry->d_off;
+                if (IS_ENTRY_CWD (entry->d_name) ||
+                    IS_ENTRY_PARENT (entry->d_name))
+                        continue;
+
+                ret = afr_crawl_build_child_loc (this, &heals[count].loc,
+                                                 parentloc, entry, crawl_data);
+                if (ret)
+                        goto out;
+                heals[count].entry = entry;
+                heals[count].batch = &batch;
+
+                /* type and size on the local brick give the order of the
+                   heals; stale entries fail here, sort first and get
+                   removed by the heal */
+                syncop_lookup (crawl_data->readdir_xl, &heals[count].loc,
+                               NULL, &heals[count].iattr, NULL, &parent);
+                count++;
+        }
+
+        qsort (heals, count, sizeof (*heals), _shd_heal_cmp);
+
+        for (i = 0; i < count; i++) {
+                if (!_crawl_proceed (this, crawl_data->child,
+                                     crawl_data->crawl_flags, NULL)) {
+                        ret = -1;
+                        break;
+                }
+                _shd_progress_add (this, crawl_data->child, 1);
+
+                limit = priv->shd.concurrency;
+                if (!batch.crawler || (limit <= 1)) {
+                        _shd_heal_task (&heals[i]);
+                        continue;
+                }
+
+                _shd_heal_wait (&batch, limit - 1);
+
+                frame = create_frame (this, this->ctx->pool);
+                if (!frame) {
+                        ret = -1;
+                        break;
+                }
+                afr_set_lk_owner (frame, this, frame->root);
+                afr_set_low_priority (frame);
+
+                LOCK (&batch.lock);
+                {
+                        batch.inflight++;
+                }
+                UNLOCK (&batch.lock);
+
+                ret = synctask_new (this->ctx->env, _shd_heal_task,
+                                    _shd_heal_done, frame, &heals[i]);
+                if (ret) {
+                        gf_log (this->name, GF_LOG_ERROR, "Could not create "
+                                "the heal task for %s", heals[i].loc.path);
+                        LOCK (&batch.lock);
+                        {
+                                batch.inflight--;
+                        }
+                        UNLOCK (&batch.lock);
+                        STACK_DESTROY (frame->root);
+                        break;
+                }
+        }
+
+        if (batch.crawler)
+                _shd_heal_wait (&batch, 0);
+        LOCK_DESTROY (&batch.lock);
+out:
+        for (i = 0; heals && (i < total); i++)
+                loc_wipe (&heals[i].loc);
+        GF_FREE (heals);
+        return ret;
+}
+
 static int
 _crawl_directory (fd_t *fd, loc_t *loc, afr_crawl_data_t *crawl_data)
 {
@@ -974,8 +1264,13 @@ _crawl_directory (fd_t *fd, loc_t *loc, afr_crawl_data_t *crawl_data)
                 if (list_empty (&entries.list))
                         goto out;
 
-                ret = _process_entries (this, loc, &entries, &offset,
-                                        crawl_data);
+                if ((crawl_data->crawl == INDEX) &&
+                    (crawl_data->crawl_flags & SHD_HEAL_CRAWL))
+                        ret = _process_index_entries (this, loc, &entries,
+                                                      &offset, crawl_data);
+                else
+                        ret = _process_entries (this, loc, &entries, &offset,
+                                                crawl_data);
                 gf_dirent_free (&entries);
                 free_entries = _gf_false;
         }
@@ -1137,9 +1432,19 @@ afr_dir_exclusive_crawl (void *data)
         }
 
         do {
+                LOCK (&priv->lock);
+                {
+                        memset (&shd->progress[child], 0,
+                                sizeof (shd->progress[child]));
+                        shd->progress[child].start = time (NULL);
+                }
+                UNLOCK (&priv->lock);
+
                 afr_dir_crawl (data);
+
                 LOCK (&priv->lock);
                 {
+                        shd->progress[child].end = time (NULL);
                         if (shd->pending[child] != NONE) {
                                 crawl_data->crawl = shd->pending[child];
                                 shd->pending[child] = NONE;
@@ -123,25 +123,25 @@ __mark_child_dead (int32_t *pending[], int child_count, int child,
 static void
 __mark_pre_op_done_on_fd (call_frame_t *frame, xlator_t *this, int child_index)
 {
-        afr_local_t   *local = NULL;
-        afr_fd_ctx_t  *fd_ctx = NULL;
+        afr_local_t      *local = NULL;
+        afr_inode_lock_t *inode_lk = NULL;
 
         local = frame->local;
 
         if (!local->fd)
                 return;
 
-        fd_ctx = afr_fd_ctx_get (local->fd, this);
+        inode_lk = afr_inode_lock_get (this, local->fd->inode);
 
-        if (!fd_ctx)
+        if (!inode_lk)
                 goto out;
 
-        LOCK (&local->fd->lock);
+        LOCK (&inode_lk->lock);
         {
                 if (local->transaction.type == AFR_DATA_TRANSACTION)
-                        fd_ctx->pre_op_done[child_index]++;
+                        inode_lk->pre_op_done[child_index]++;
         }
-        UNLOCK (&local->fd->lock);
+        UNLOCK (&inode_lk->lock);
 out:
         return;
 }
@@ -150,25 +150,25 @@ out:
 static void
 __mark_pre_op_undone_on_fd (call_frame_t *frame, xlator_t *this, int child_index)
 {
-        afr_local_t   *local = NULL;
-        afr_fd_ctx_t  *fd_ctx = NULL;
+        afr_local_t      *local = NULL;
+        afr_inode_lock_t *inode_lk = NULL;
 
         local = frame->local;
 
         if (!local->fd)
                 return;
 
-        fd_ctx = afr_fd_ctx_get (local->fd, this);
+        inode_lk = afr_inode_lock_get (this, local->fd->inode);
 
-        if (!fd_ctx)
+        if (!inode_lk)
                 goto out;
 
-        LOCK (&local->fd->lock);
+        LOCK (&inode_lk->lock);
         {
                 if (local->transaction.type == AFR_DATA_TRANSACTION)
-                        fd_ctx->pre_op_done[child_index]--;
+                        inode_lk->pre_op_done[child_index]--;
         }
-        UNLOCK (&local->fd->lock);
+        UNLOCK (&inode_lk->lock);
 out:
         return;
 }
@@ -531,7 +531,7 @@ afr_changelog_post_op_now (call_frame_t *frame, xlator_t *this)
         int call_count = 0;
 
         afr_local_t *  local = NULL;
-        afr_fd_ctx_t  *fdctx = NULL;
+        afr_inode_lock_t *inode_lk = NULL;
         dict_t        **xattr = NULL;
         int            piggyback = 0;
         int            index = 0;
@@ -561,7 +561,7 @@ afr_changelog_post_op_now (call_frame_t *frame, xlator_t *this)
         local->call_count = call_count;
 
         if (local->fd)
-                fdctx = afr_fd_ctx_get (local->fd, this);
+                inode_lk = afr_inode_lock_get (this, local->fd->inode);
 
         if (call_count == 0) {
                 /* no child is up */
@@ -592,7 +592,7 @@ afr_changelog_post_op_now (call_frame_t *frame, xlator_t *this)
                 switch (local->transaction.type) {
                 case AFR_DATA_TRANSACTION:
                 {
-                        if (!fdctx) {
+                        if (!inode_lk) {
                                 afr_set_postop_dict (local, this, xattr[i],
                                                      0, i);
                                 STACK_WIND (frame, afr_changelog_post_op_cbk,
@@ -604,15 +604,15 @@ afr_changelog_post_op_now (call_frame_t *frame, xlator_t *this)
                                 break;
                         }
 
-                        LOCK (&local->fd->lock);
+                        LOCK (&inode_lk->lock);
                         {
                                 piggyback = 0;
-                                if (fdctx->pre_op_piggyback[i]) {
-                                        fdctx->pre_op_piggyback[i]--;
+                                if (inode_lk->pre_op_piggyback[i]) {
+                                        inode_lk->pre_op_piggyback[i]--;
                                         piggyback = 1;
                                 }
                         }
-                        UNLOCK (&local->fd->lock);
+                        UNLOCK (&inode_lk->lock);
 
                         afr_set_postop_dict (local, this, xattr[i],
                                              piggyback, i);
@@ -804,7 +804,7 @@ afr_changelog_pre_op (call_frame_t *frame, xlator_t *this)
         int ret = 0;
         int call_count = 0;
         dict_t **xattr = NULL;
-        afr_fd_ctx_t *fdctx = NULL;
+        afr_inode_lock_t *inode_lk = NULL;
         afr_local_t *local = NULL;
         int          piggyback = 0;
         afr_internal_lock_t *int_lock = NULL;
@@ -836,7 +836,7 @@ afr_changelog_pre_op (call_frame_t *frame, xlator_t *this)
                             local->transaction.type);
 
         if (local->fd)
-                fdctx = afr_fd_ctx_get (local->fd, this);
+                inode_lk = afr_inode_lock_get (this, local->fd->inode);
 
         locked_nodes = afr_locked_nodes_get (local->transaction.type, int_lock);
         for (i = 0; i < priv->child_count; i++) {
@@ -853,7 +853,7 @@ afr_changelog_pre_op (call_frame_t *frame, xlator_t *this)
                 switch (local->transaction.type) {
                 case AFR_DATA_TRANSACTION:
                 {
-                        if (!fdctx) {
+                        if (!inode_lk) {
                                 STACK_WIND_COOKIE (frame,
                                                    afr_changelog_pre_op_cbk,
                                                    (void *) (long) i,
@@ -865,18 +865,18 @@ afr_changelog_pre_op (call_frame_t *frame, xlator_t *this)
                                 break;
                         }
 
-                        LOCK (&local->fd->lock);
+                        LOCK (&inode_lk->lock);
                         {
                                 piggyback = 0;
-                                if (fdctx->pre_op_done[i]) {
-                                        fdctx->pre_op_piggyback[i]++;
+                                if (inode_lk->pre_op_done[i]) {
+                                        inode_lk->pre_op_piggyback[i]++;
                                         piggyback = 1;
-                                        fdctx->hit++;
+                                        inode_lk->hit++;
                                 } else {
-                                        fdctx->miss++;
+                                        inode_lk->miss++;
                                 }
                         }
-                        UNLOCK (&local->fd->lock);
+                        UNLOCK (&inode_lk->lock);
 
 			afr_set_delayed_post_op (frame, this);
 
@@ -1291,6 +1291,11 @@ is_afr_delayed_changelog_post_op_needed (call_frame_t *frame, xlator_t *this)
 	if (!local->delayed_post_op)
 		goto out;
 
+	/* another client is waiting for the lock, let it go as soon as
+	   the writes in flight are done */
+	if (afr_inode_lock_contended (this, local->fd->inode))
+		goto out;
+
 	res = _gf_true;
 out:
 	return res;
@@ -1298,55 +1303,61 @@ out:
 
 
 void
-afr_delayed_changelog_post_op (xlator_t *this, call_frame_t *frame, fd_t *fd);
-
-void
-afr_delayed_changelog_wake_up (xlator_t *this, fd_t *fd);
+afr_delayed_changelog_post_op (xlator_t *this, call_frame_t *frame,
+                               inode_t *inode);
 
 void
 afr_delayed_changelog_wake_up_cbk (void *data)
 {
-	fd_t           *fd = NULL;
+	inode_t        *inode = NULL;
 
-	fd = data;
+	inode = data;
 
-	afr_delayed_changelog_wake_up (THIS, fd);
+	afr_delayed_changelog_post_op (THIS, NULL, inode);
 }
 
 
+/* The delayed frame is kept per inode, not per fd: a write through any fd
+   of the file flushes the post-op of the write before it, and the inode
+   stays referenced through the fd of the delayed frame while the timer
+   is armed. */
 void
-afr_delayed_changelog_post_op (xlator_t *this, call_frame_t *frame, fd_t *fd)
+afr_delayed_changelog_post_op (xlator_t *this, call_frame_t *frame,
+                               inode_t *inode)
 {
-	afr_fd_ctx_t      *fd_ctx = NULL;
+	afr_inode_lock_t  *inode_lk = NULL;
 	call_frame_t      *prev_frame = NULL;
 	struct timeval     delta = {0, };
 	afr_private_t     *priv = NULL;
 
 	priv = this->private;
 
-	fd_ctx = afr_fd_ctx_get (fd, this);
-	if (!fd_ctx)
+	inode_lk = afr_inode_lock_get (this, inode);
+	if (!inode_lk) {
+		if (frame)
+			afr_changelog_post_op_now (frame, this);
 		return;
+	}
 
 	delta.tv_sec = priv->post_op_delay_secs;
 	delta.tv_usec = 0;
 
-	pthread_mutex_lock (&fd_ctx->delay_lock);
+	pthread_mutex_lock (&inode_lk->delay_lock);
 	{
-		prev_frame = fd_ctx->delay_frame;
-		fd_ctx->delay_frame = NULL;
-		if (fd_ctx->delay_timer)
-			gf_timer_call_cancel (this->ctx, fd_ctx->delay_timer);
-		fd_ctx->delay_timer = NULL;
+		prev_frame = inode_lk->delay_frame;
+		inode_lk->delay_frame = NULL;
+		if (inode_lk->delay_timer)
+			gf_timer_call_cancel (this->ctx, inode_lk->delay_timer);
+		inode_lk->delay_timer = NULL;
 		if (!frame)
 			goto unlock;
-		fd_ctx->delay_timer = gf_timer_call_after (this->ctx, delta,
-							   afr_delayed_changelog_wake_up_cbk,
-							   fd);
-		fd_ctx->delay_frame = frame;
+		inode_lk->delay_timer = gf_timer_call_after (this->ctx, delta,
+							     afr_delayed_changelog_wake_up_cbk,
+							     inode);
+		inode_lk->delay_frame = frame;
 	}
 unlock:
-	pthread_mutex_unlock (&fd_ctx->delay_lock);
+	pthread_mutex_unlock (&inode_lk->delay_lock);
 
 	if (prev_frame) {
 		afr_changelog_post_op_now (prev_frame, this);
@@ -1362,7 +1373,7 @@ afr_changelog_post_op (call_frame_t *frame, xlator_t *this)
 	local = frame->local;
 
 	if (is_afr_delayed_changelog_post_op_needed (frame, this))
-		afr_delayed_changelog_post_op (this, frame, local->fd);
+		afr_delayed_changelog_post_op (this, frame, local->fd->inode);
 	else
 		afr_changelog_post_op_now (frame, this);
 }
@@ -1371,7 +1382,7 @@ afr_changelog_post_op (call_frame_t *frame, xlator_t *this)
 void
 afr_delayed_changelog_wake_up (xlator_t *this, fd_t *fd)
 {
-	afr_delayed_changelog_post_op (this, NULL, fd);
+	afr_delayed_changelog_post_op (this, NULL, fd->inode);
 }
 
 
@@ -1442,11 +1453,18 @@ afr_transaction (call_frame_t *frame, xlator_t *this, afr_transaction_type type)
         local = frame->local;
         priv  = this->private;
 
+	/* the inode is the lk-owner of eager locks, so that the lock taken
+	   through one fd is reused by writes through every other fd of the
+	   file. While another client waits for the lock, transactions take
+	   their own locks and queue behind it. */
 	if (local->fd && priv->eager_lock &&
-	    local->transaction.type == AFR_DATA_TRANSACTION)
-		afr_set_lk_owner (frame, this, local->fd);
-	else
+	    local->transaction.type == AFR_DATA_TRANSACTION &&
+	    !afr_inode_lock_contended (this, local->fd->inode)) {
+		local->transaction.eager_lock_on = _gf_true;
+		afr_set_lk_owner (frame, this, local->fd->inode);
+	} else {
 		afr_set_lk_owner (frame, this, frame->root);
+	}
 
         afr_transaction_local_init (local, this);
 
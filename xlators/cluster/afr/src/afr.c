@@ -134,6 +134,18 @@ reconfigure (xlator_t *this, dict_t *options)
                           priv->data_self_heal_window_size, options,
                           uint32, out);
 
+        GF_OPTION_RECONF ("data-self-heal-checksum-batch",
+                          priv->data_self_heal_checksum_batch, options,
+                          uint32, out);
+
+        GF_OPTION_RECONF ("data-self-heal-latency-target",
+                          priv->data_self_heal_latency_target, options,
+                          uint32, out);
+
+        GF_OPTION_RECONF ("data-self-heal-dirty-regions",
+                          priv->data_self_heal_dirty_regions, options,
+                          bool, out);
+
         GF_OPTION_RECONF ("data-change-log", priv->data_change_log, options,
                           bool, out);
 
@@ -153,6 +165,9 @@ reconfigure (xlator_t *this, dict_t *options)
         GF_OPTION_RECONF ("read-hash-mode", priv->hash_mode,
                           options, uint32, out);
 
+        GF_OPTION_RECONF ("read-balance", priv->read_balance, options, bool,
+                          out);
+
         if (read_subvol) {
                 index = xlator_subvolume_index (this, read_subvol);
                 if (index == -1) {
@@ -182,6 +197,8 @@ reconfigure (xlator_t *this, dict_t *options)
         fix_quorum_options(this,priv,qtype);
         GF_OPTION_RECONF ("heal-timeout", priv->shd.timeout, options,
                           int32, out);
+        GF_OPTION_RECONF ("heal-concurrency", priv->shd.concurrency, options,
+                          int32, out);
 
 	GF_OPTION_RECONF ("post-op-delay-secs", priv->post_op_delay_secs, options,
 			  uint32, out);
@@ -271,6 +288,8 @@ init (xlator_t *this)
 
         GF_OPTION_INIT ("read-hash-mode", priv->hash_mode, uint32, out);
 
+        GF_OPTION_INIT ("read-balance", priv->read_balance, bool, out);
+
         priv->favorite_child = -1;
         GF_OPTION_INIT ("favorite-child", fav_child, xlator, out);
         if (fav_child) {
@@ -297,6 +316,15 @@ init (xlator_t *this)
         GF_OPTION_INIT ("data-self-heal-window-size",
                         priv->data_self_heal_window_size, uint32, out);
 
+        GF_OPTION_INIT ("data-self-heal-checksum-batch",
+                        priv->data_self_heal_checksum_batch, uint32, out);
+
+        GF_OPTION_INIT ("data-self-heal-latency-target",
+                        priv->data_self_heal_latency_target, uint32, out);
+
+        GF_OPTION_INIT ("data-self-heal-dirty-regions",
+                        priv->data_self_heal_dirty_regions, bool, out);
+
         GF_OPTION_INIT ("metadata-self-heal", priv->metadata_self_heal, bool,
                         out);
 
@@ -386,6 +414,13 @@ init (xlator_t *this)
                 goto out;
         }
 
+        priv->read_stats = GF_CALLOC (child_count, sizeof (*priv->read_stats),
+                                      gf_afr_mt_read_stats_t);
+        if (!priv->read_stats) {
+                ret = -ENOMEM;
+                goto out;
+        }
+
         /* keep more local here as we may need them for self-heal etc */
         this->local_pool = mem_pool_new (afr_local_t, 512);
         if (!this->local_pool) {
@@ -435,12 +470,19 @@ init (xlator_t *this)
         if (!priv->shd.split_brain)
                 goto out;
 
+        priv->shd.progress = GF_CALLOC (sizeof (*priv->shd.progress),
+                                        child_count, gf_afr_mt_shd_progress_t);
+        if (!priv->shd.progress)
+                goto out;
+
         this->itable = inode_table_new (SHD_INODE_LRU_LIMIT, this);
         if (!this->itable)
                 goto out;
         priv->root_inode = inode_ref (this->itable->root);
         GF_OPTION_INIT ("node-uuid", priv->shd.node_uuid, str, out);
         GF_OPTION_INIT ("heal-timeout", priv->shd.timeout, int32, out);
+        GF_OPTION_INIT ("heal-concurrency", priv->shd.concurrency, int32,
+                        out);
 
         ret = 0;
 out:
@@ -485,11 +527,15 @@ struct xlator_fops fops = {
         .getxattr    = afr_getxattr,
         .fgetxattr   = afr_fgetxattr,
         .readv       = afr_readv,
+        .seek        = afr_seek,
 
         /* inode write */
         .writev      = afr_writev,
         .truncate    = afr_truncate,
         .ftruncate   = afr_ftruncate,
+        .fallocate   = afr_fallocate,
+        .discard     = afr_discard,
+        .zerofill    = afr_zerofill,
         .setxattr    = afr_setxattr,
         .fsetxattr   = afr_fsetxattr,
         .setattr     = afr_setattr,
@@ -543,6 +589,15 @@ struct volume_options options[] = {
                          "1 = hash by GFID (all clients use same subvolume), "
                          "2 = hash by GFID and client PID",
         },
+        { .key  = {"read-balance" },
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Send each read to the up to date subvolume with the "
+                         "lowest latency times outstanding reads, instead of "
+                         "the read subvolume, when it is at least twice as "
+                         "good. Sequential reads on an fd stay on one "
+                         "subvolume.",
+        },
         { .key  = {"choose-local" },
           .type = GF_OPTION_TYPE_BOOL,
           .default_value = "true",
@@ -585,6 +640,37 @@ struct volume_options options[] = {
           .description = "Maximum number blocks per file for which self-heal "
                          "process would be applied simultaneously."
         },
+        { .key  = {"data-self-heal-checksum-batch"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 1,
+          .max  = 256,
+          .default_value = "16",
+          .description = "Number of blocks the \"diff\" algorithm locks "
+                         "and checksums with one request per subvolume. Only "
+                         "the blocks whose checksums differ are copied."
+        },
+        { .key  = {"data-self-heal-latency-target"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 0,
+          .max  = 60000,
+          .default_value = "0",
+          .description = "Time in milliseconds self-heal should take to "
+                         "read or checksum one block. When it takes longer, "
+                         "the bricks are busy with other I/O and the number "
+                         "of ranges healed in parallel is halved, down to "
+                         "one; it grows back by one, up to "
+                         "data-self-heal-window-size, while heal is faster. "
+                         "0 disables throttling."
+        },
+        { .key  = {"data-self-heal-dirty-regions"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "on",
+          .description = "Have the \"diff\" algorithm ask the bricks which "
+                         "regions of the file were written since the "
+                         "replicas last agreed, and checksum only those. "
+                         "Falls back to the whole file when a brick keeps "
+                         "no such map for it."
+        },
         { .key  = {"metadata-self-heal"},
           .type = GF_OPTION_TYPE_BOOL,
           .default_value = "on",
@@ -663,6 +749,16 @@ struct volume_options options[] = {
           .default_value = "600",
           .description = "Poll timeout for checking the need to self-heal"
         },
+        { .key  = {"heal-concurrency"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 1,
+          .max  = 64,
+          .default_value = "1",
+          .description = "Number of entries of the index of a brick the "
+                         "self-heal daemon heals at the same time. "
+                         "Directories are healed before files, small files "
+                         "before large ones."
+        },
         { .key  = {"post-op-delay-secs"},
           .type = GF_OPTION_TYPE_INT,
           .min  = 0,
@@ -27,6 +27,7 @@
 
 #define AFR_XATTR_PREFIX "trusted.afr"
 #define AFR_PATHINFO_HEADER "REPLICATE:"
+#define AFR_READ_PROBE_INTERVAL 64 /* reads per read-balance probe */
 
 struct _pump_private;
 
@@ -74,9 +75,35 @@ typedef struct afr_inode_params_ {
         } u;
 } afr_inode_params_t;
 
+/* reads sent to a child, for read-balance and the statedump */
+typedef struct afr_read_stats_ {
+        uint64_t         reads;
+        uint64_t         latency;       /* usec, moving average */
+        int32_t          outstanding;
+} afr_read_stats_t;
+
+/* eager-lock and delayed post-op state. It hangs off the inode so that
+   writes through any fd of the file in this client share one inodelk and
+   one changelog pre-op */
+typedef struct afr_inode_lock_ {
+        gf_lock_t          lock;
+        unsigned int      *pre_op_done;
+        unsigned int      *pre_op_piggyback;
+        unsigned int      *lock_piggyback;
+        unsigned int      *lock_acquired;
+        int                hit, miss;
+        gf_boolean_t       contended; /* another client wants the lock */
+
+	/* used for delayed-post-op optimization */
+	pthread_mutex_t    delay_lock;
+	gf_timer_t        *delay_timer;
+	call_frame_t      *delay_frame;
+} afr_inode_lock_t;
+
 typedef struct afr_inode_ctx_ {
         uint64_t masks;
         int32_t  *fresh_children;//increasing order of latency
+        afr_inode_lock_t *lock;
 } afr_inode_ctx_t;
 
 typedef enum {
@@ -85,6 +112,15 @@ typedef enum {
         FULL,
 } afr_crawl_type_t;
 
+/* counters of the last heal crawl of a brick, shown by heal info */
+typedef struct afr_shd_progress_ {
+        uint64_t         crawled;
+        uint64_t         healed;
+        uint64_t         failed;
+        time_t           start;
+        time_t           end;           /* 0 while the crawl runs */
+} afr_shd_progress_t;
+
 typedef struct afr_self_heald_ {
         gf_boolean_t     enabled;
         gf_boolean_t     iamshd;
@@ -97,6 +133,8 @@ typedef struct afr_self_heald_ {
         eh_t             *split_brain;
         char             *node_uuid;
         int              timeout;
+        int              concurrency;   /* heals in flight per brick */
+        afr_shd_progress_t *progress;
 } afr_self_heald_t;
 
 typedef struct _afr_private {
@@ -119,6 +157,12 @@ typedef struct _afr_private {
         char *       data_self_heal_algorithm;    /* name of algorithm */
         unsigned int data_self_heal_window_size;  /* max number of pipelined
                                                      read/writes */
+        unsigned int data_self_heal_checksum_batch; /* blocks checksummed
+                                                       per diff loop */
+        uint32_t     data_self_heal_latency_target; /* msec, 0 = no
+                                                       throttling */
+        gf_boolean_t data_self_heal_dirty_regions;  /* skip regions no
+                                                       brick wrote to */
 
         unsigned int background_self_heal_count;
         unsigned int background_self_heals_started;
@@ -131,6 +175,9 @@ typedef struct _afr_private {
 
         int read_child;               /* read-subvolume */
         unsigned int hash_mode;       /* for when read_child is not set */
+        gf_boolean_t read_balance;    /* steer reads to the fastest child */
+        afr_read_stats_t *read_stats; /* per child, read_child_lock */
+        uint64_t read_probe;          /* reads balanced so far */
         int favorite_child;  /* subvolume to be preferred in resolving
                                          split-brain cases */
 
@@ -178,6 +225,8 @@ typedef struct {
 
         gf_boolean_t background;          /* do self-heal in background
                                              if possible */
+        uint64_t     scrub_bad;           /* bit per child whose copy the
+                                             brick scrubber found corrupted */
         ia_type_t type;                   /* st_mode of the entry we're doing
                                              self-heal on */
         inode_t   *inode;                 /* inode on which the self-heal is
@@ -250,6 +299,14 @@ typedef struct {
         off_t offset;
         unsigned char *write_needed;
         uint8_t *checksum;
+        /* diff loops: range under lock, and which of its blocks differ */
+        off_t loop_offset;
+        off_t loop_size;
+        int   block_count;
+        int   block_index;
+        unsigned char *block_diff;
+        int   sum_types;   /* bit per strong checksum type replied */
+        struct timeval issued;
         afr_post_remove_call_t post_remove_call;
 
         loc_t parent_loc;
@@ -479,6 +536,12 @@ typedef struct _afr_local {
                         int last_index;
                 } fstat;
 
+                struct {
+                        int last_index;
+                        off_t offset;
+                        gf_seek_what_t what;
+                } seek;
+
                 struct {
                         size_t size;
                         int last_index;
@@ -495,6 +558,7 @@ typedef struct _afr_local {
                         off_t offset;
                         int last_index;
                         uint32_t flags;
+                        struct timeval start;
                 } readv;
 
                 /* dir read */
@@ -529,6 +593,10 @@ typedef struct _afr_local {
                         int32_t count;
                         off_t offset;
                         uint32_t flags;
+
+                        /* inodelks of other clients seen by the bricks */
+                        int32_t contention;
+                        gf_boolean_t contention_asked;
                 } writev;
 
                 struct {
@@ -548,6 +616,28 @@ typedef struct _afr_local {
                         struct iatt postbuf;
                 } ftruncate;
 
+                struct {
+                        int32_t keep_size;
+                        off_t offset;
+                        size_t len;
+                        struct iatt prebuf;
+                        struct iatt postbuf;
+                } fallocate;
+
+                struct {
+                        off_t offset;
+                        size_t len;
+                        struct iatt prebuf;
+                        struct iatt postbuf;
+                } discard;
+
+                struct {
+                        off_t offset;
+                        off_t len;
+                        struct iatt prebuf;
+                        struct iatt postbuf;
+                } zerofill;
+
                 struct {
                         struct iatt in_buf;
                         int32_t valid;
@@ -627,6 +717,7 @@ typedef struct _afr_local {
                 off_t start, len;
 
                 int *eager_lock;
+                gf_boolean_t eager_lock_on;
 
                 char *basename;
                 char *new_basename;
@@ -677,12 +768,7 @@ typedef struct {
 } afr_fd_paused_call_t;
 
 typedef struct {
-        unsigned int *pre_op_done;
         afr_fd_open_status_t *opened_on; /* which subvolumes the fd is open on */
-        unsigned int *pre_op_piggyback;
-
-        unsigned int *lock_piggyback;
-        unsigned int *lock_acquired;
 
         int flags;
         uint64_t up_count;   /* number of CHILD_UPs this fd has seen */
@@ -690,17 +776,16 @@ typedef struct {
 
         int32_t last_tried;
 
-        int  hit, miss;
+        /* child the last readv went to and where it ended, so that a
+           sequential stream stays on one child */
+        int32_t read_child;
+        off_t   read_offset;
+
         gf_boolean_t failed_over;
         struct list_head entries; /* needed for readdir failover */
 
         unsigned char *locked_on; /* which subvolumes locks have been successful */
 	struct list_head  paused_calls; /* queued calls while fix_open happens  */
-
-	/* used for delayed-post-op optimization */
-	pthread_mutex_t    delay_lock;
-	gf_timer_t        *delay_timer;
-	call_frame_t      *delay_frame;
 } afr_fd_ctx_t;
 
 
@@ -921,6 +1006,17 @@ afr_get_call_child (xlator_t *this, unsigned char *child_up, int32_t read_child,
                     int32_t *fresh_children,
                     int32_t *call_child, int32_t *last_index);
 
+int32_t
+afr_read_balance_child (xlator_t *this, fd_t *fd, off_t offset, size_t size,
+                        unsigned char *child_up, int32_t *fresh_children,
+                        int32_t read_child);
+
+void
+afr_read_stats_start (xlator_t *this, int32_t child, struct timeval *start);
+
+void
+afr_read_stats_end (xlator_t *this, int32_t child, struct timeval *start);
+
 int32_t
 afr_next_call_child (int32_t *fresh_children, unsigned char *child_up,
                      size_t child_count, int32_t *last_index,
@@ -991,6 +1087,16 @@ afr_set_elem_count_get (unsigned char *elems, int child_count);
 afr_fd_ctx_t *
 afr_fd_ctx_get (fd_t *fd, xlator_t *this);
 
+afr_inode_lock_t *
+afr_inode_lock_get (xlator_t *this, inode_t *inode);
+
+gf_boolean_t
+afr_inode_lock_contended (xlator_t *this, inode_t *inode);
+
+void
+afr_inode_lock_set_contended (xlator_t *this, inode_t *inode,
+                              gf_boolean_t contended);
+
 gf_boolean_t
 afr_open_only_data_self_heal (char *data_self_heal);
 
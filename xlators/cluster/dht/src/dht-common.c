@@ -728,6 +728,8 @@ dht_lookup_everywhere_done (call_frame_t *frame, xlator_t *this)
         hashed_subvol = local->hashed_subvol;
         cached_subvol = local->cached_subvol;
 
+        dht_everywhere_finish (frame, this);
+
         if (local->file_count && local->dir_count) {
                 gf_log (this->name, GF_LOG_ERROR,
                         "path %s exists as a file on one subvolume "
@@ -750,6 +752,10 @@ dht_lookup_everywhere_done (call_frame_t *frame, xlator_t *this)
                 return 0;
         }
 
+        if (cached_subvol != hashed_subvol)
+                dht_hint_set_loc (this, &local->loc, local->gfid,
+                                  cached_subvol);
+
         if (local->need_lookup_everywhere) {
                 if (uuid_compare (local->gfid, local->inode->gfid)) {
                         /* GFID different, return error */
@@ -969,28 +975,19 @@ out:
 
 
 int
-dht_lookup_everywhere (call_frame_t *frame, xlator_t *this, loc_t *loc)
+dht_lookup_everywhere_wind (call_frame_t *frame, xlator_t *this, loc_t *loc)
 {
         dht_conf_t     *conf = NULL;
         dht_local_t    *local = NULL;
         int             i = 0;
         int             call_cnt = 0;
 
-        GF_VALIDATE_OR_GOTO ("dht", frame, err);
-        GF_VALIDATE_OR_GOTO ("dht", this, out);
-        GF_VALIDATE_OR_GOTO ("dht", frame->local, out);
-        GF_VALIDATE_OR_GOTO ("dht", this->private, out);
-        GF_VALIDATE_OR_GOTO ("dht", loc, out);
-
         conf = this->private;
         local = frame->local;
 
         call_cnt = conf->subvolume_cnt;
         local->call_cnt = call_cnt;
 
-        if (!local->inode)
-                local->inode = inode_ref (loc->inode);
-
         for (i = 0; i < call_cnt; i++) {
                 STACK_WIND (frame, dht_lookup_everywhere_cbk,
                             conf->subvolumes[i],
@@ -999,6 +996,30 @@ dht_lookup_everywhere (call_frame_t *frame, xlator_t *this, loc_t *loc)
         }
 
         return 0;
+}
+
+
+int
+dht_lookup_everywhere (call_frame_t *frame, xlator_t *this, loc_t *loc)
+{
+        dht_local_t    *local = NULL;
+
+        GF_VALIDATE_OR_GOTO ("dht", frame, err);
+        GF_VALIDATE_OR_GOTO ("dht", this, out);
+        GF_VALIDATE_OR_GOTO ("dht", frame->local, out);
+        GF_VALIDATE_OR_GOTO ("dht", this->private, out);
+        GF_VALIDATE_OR_GOTO ("dht", loc, out);
+
+        local = frame->local;
+
+        if (!local->inode)
+                local->inode = inode_ref (loc->inode);
+
+        /* parked behind a fan-out of the same name, or for a free slot */
+        if (dht_everywhere_admit (frame, this, loc))
+                return 0;
+
+        return dht_lookup_everywhere_wind (frame, this, loc);
 out:
         DHT_STACK_UNWIND (lookup, frame, -1, EINVAL, NULL, NULL, NULL, NULL);
 err:
@@ -1006,6 +1027,21 @@ err:
 }
 
 
+static int
+dht_lookup_missing (call_frame_t *frame, xlator_t *this, loc_t *loc)
+{
+        dht_local_t    *local = NULL;
+
+        local = frame->local;
+
+        if (!local->everywhere.hint_tried &&
+            !dht_lookup_hinted (frame, this, loc, DHT_HINT_PROBE_MISSING))
+                return 0;
+
+        return dht_lookup_everywhere (frame, this, loc);
+}
+
+
 int
 dht_lookup_linkfile_cbk (call_frame_t *frame, void *cookie,
                          xlator_t *this, int op_ret, int op_errno,
@@ -1073,6 +1109,9 @@ dht_lookup_linkfile_cbk (call_frame_t *frame, void *cookie,
                 op_errno = EINVAL;
         }
 
+        /* next time skip the linkfile */
+        dht_hint_set_loc (this, loc, stbuf->ia_gfid, prev->this);
+
 unwind:
         WIPE (postparent);
 
@@ -1083,7 +1122,7 @@ unwind:
         return 0;
 
 err:
-        dht_lookup_everywhere (frame, this, loc);
+        dht_lookup_missing (frame, this, loc);
 out:
         return 0;
 }
@@ -1183,7 +1222,7 @@ dht_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                         " %s", loc->path, prev->this->name);
                 if (conf->search_unhashed == GF_DHT_LOOKUP_UNHASHED_ON) {
                         local->op_errno = ENOENT;
-                        dht_lookup_everywhere (frame, this, loc);
+                        dht_lookup_missing (frame, this, loc);
                         return 0;
                 }
                 if ((conf->search_unhashed == GF_DHT_LOOKUP_UNHASHED_AUTO) &&
@@ -1192,7 +1231,7 @@ dht_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                         parent_layout = (dht_layout_t *)(long)tmp_layout;
                         if (parent_layout->search_unhashed) {
                                 local->op_errno = ENOENT;
-                                dht_lookup_everywhere (frame, this, loc);
+                                dht_lookup_missing (frame, this, loc);
                                 return 0;
                         }
                 }
@@ -1240,7 +1279,7 @@ dht_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                 gf_log (this->name, GF_LOG_DEBUG,
                         "linkfile not having link subvolume. path=%s",
                         loc->path);
-                dht_lookup_everywhere (frame, this, loc);
+                dht_lookup_missing (frame, this, loc);
                 return 0;
         }
 
@@ -1475,6 +1514,12 @@ dht_lookup (call_frame_t *frame, xlator_t *this,
                         return 0;
                 }
 
+                /* a name known to live off its hashed subvolume is
+                   looked up there directly, without the linkfile hop */
+                if (!dht_lookup_hinted (frame, this, loc,
+                                        DHT_HINT_PROBE_FIRST))
+                        return 0;
+
                 STACK_WIND (frame, dht_lookup_cbk,
                             hashed_subvol, hashed_subvol->fops->lookup,
                             loc, local->xattr_req);
@@ -2714,6 +2759,7 @@ dht_opendir (call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd,
         dht_conf_t   *conf = NULL;
         int           op_errno = -1;
         int           i = -1;
+        int           ret = 0;
 
         VALIDATE_OR_GOTO (frame, err);
         VALIDATE_OR_GOTO (this, err);
@@ -2729,13 +2775,28 @@ dht_opendir (call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd,
                 goto err;
         }
 
+        /* translators prefetching directory entries beneath us
+           (readdir-ahead) need the linkto key to let us filter linkfiles */
+        if (xdata)
+                local->xattr_req = dict_copy_with_ref (xdata, NULL);
+        else
+                local->xattr_req = dict_new ();
+
+        if (local->xattr_req) {
+                ret = dict_set_uint32 (local->xattr_req, DHT_LINKFILE_KEY,
+                                       256);
+                if (ret)
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "failed to set '%s' key", DHT_LINKFILE_KEY);
+        }
+
         local->call_cnt = conf->subvolume_cnt;
 
         for (i = 0; i < conf->subvolume_cnt; i++) {
                 STACK_WIND (frame, dht_fd_cbk,
                             conf->subvolumes[i],
                             conf->subvolumes[i]->fops->opendir,
-                            loc, fd, xdata);
+                            loc, fd, local->xattr_req);
         }
 
         return 0;
@@ -2793,14 +2854,26 @@ dht_readdirp_cbk (call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
                         goto unwind;
                 }
 
-                /* Do this if conf->search_unhashed is set to "auto" */
-                if (conf->search_unhashed == GF_DHT_LOOKUP_UNHASHED_AUTO) {
+                /* Do this if conf->search_unhashed is set to "auto", and
+                   to learn where names off their hashed subvolume live */
+                if (layout &&
+                    ((conf->search_unhashed == GF_DHT_LOOKUP_UNHASHED_AUTO) ||
+                     dht_hints_active (conf))) {
                         subvol = dht_layout_search (this, layout,
                                                     orig_entry->d_name);
                         if (!subvol || (subvol != prev->this)) {
                                 /* TODO: Count the number of entries which need
                                    linkfile to prove its existence in fs */
-                                layout->search_unhashed++;
+                                if (conf->search_unhashed ==
+                                    GF_DHT_LOOKUP_UNHASHED_AUTO)
+                                        layout->search_unhashed++;
+
+                                if (!IA_ISDIR (orig_entry->d_stat.ia_type))
+                                        dht_hint_set (this,
+                                                      local->fd->inode->gfid,
+                                                      orig_entry->d_name,
+                                                      orig_entry->d_stat.ia_gfid,
+                                                      prev->this);
                         }
                 }
 
@@ -3265,6 +3338,8 @@ dht_mknod (call_frame_t *frame, xlator_t *this,
                 goto err;
         }
 
+        dht_hint_del (this, loc);
+
         subvol = dht_subvol_get_hashed (this, loc);
         if (!subvol) {
                 gf_log (this->name, GF_LOG_DEBUG,
@@ -3392,6 +3467,8 @@ dht_unlink (call_frame_t *frame, xlator_t *this, loc_t *loc, int xflag,
                 goto err;
         }
 
+        dht_hint_del (this, loc);
+
         hashed_subvol = dht_subvol_get_hashed (this, loc);
         if (!hashed_subvol) {
                 gf_log (this->name, GF_LOG_DEBUG,
@@ -3656,6 +3733,8 @@ dht_create (call_frame_t *frame, xlator_t *this,
                 goto err;
         }
 
+        dht_hint_del (this, loc);
+
         if (dht_filter_loc_subvol_key (this, loc, &local->loc,
                                        &subvol)) {
                 gf_log (this->name, GF_LOG_INFO,
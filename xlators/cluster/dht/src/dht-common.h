@@ -45,7 +45,7 @@ struct dht_layout {
         int                type;
         int                ref; /* use with dht_conf_t->layout_lock */
         int                search_unhashed;
-        struct {
+        struct dht_layout_entry {
                 int        err;   /* 0 = normal
                                      -1 = dir exists and no xattr
                                      >0 = dir lookup failed with errno
@@ -161,6 +161,15 @@ struct dht_local {
 
         struct dht_rebalance_ rebalance;
 
+        /* hinted lookups and lookup_everywhere admission, see dht-hint.c */
+        struct {
+                struct list_head  list;     /* running, queued or waiting */
+                struct list_head  waiters;  /* same name, batched on us */
+                call_frame_t     *frame;
+                char              state;
+                char              hint_probe;
+                char              hint_tried;
+        } everywhere;
 };
 typedef struct dht_local dht_local_t;
 
@@ -170,6 +179,9 @@ struct dht_du {
 	double   avail_inodes;
         uint64_t avail_space;
         uint32_t log;
+        uint64_t total_space;    /* capacity, for weighted layouts */
+        uint64_t latency;        /* statfs round trip in usec, averaged */
+        struct timeval sent;     /* when the last statfs went out */
 };
 typedef struct dht_du dht_du_t;
 
@@ -209,11 +221,88 @@ struct gf_defrag_info_ {
         uuid_t                       node_uuid;
         struct timeval               start_time;
         gf_boolean_t                 stats;
-
+        uint64_t                     num_dirs_scanned;
+
+        /* files found by the crawler wait here for a migration worker.
+           Both sides are synctasks, a side which has to wait parks itself
+           in 'crawler' or 'idle' and is woken by the other side. */
+        struct list_head             queue;
+        uint32_t                     queue_count;
+        uint32_t                     queue_size;
+        uint32_t                     workers;
+        uint32_t                     active_workers;
+        gf_boolean_t                 crawl_done;
+        struct synctask             *crawler;
+        struct synctask            **idle;
+        uint32_t                     idle_count;
+        uint64_t                     rate_limit;   /* bytes/sec, 0 is none */
+        dict_t                      *migrate_data;
 };
 
 typedef struct gf_defrag_info_ gf_defrag_info_t;
 
+/* a file queued for migration */
+struct gf_defrag_entry_ {
+        struct list_head             list;
+        loc_t                        loc;
+};
+typedef struct gf_defrag_entry_ gf_defrag_entry_t;
+
+/* last subvolume a name was found on when it was not its hashed one */
+struct dht_hint {
+        struct list_head   hash;
+        struct list_head   lru;
+        uuid_t             pargfid;
+        uuid_t             gfid;
+        xlator_t          *subvol;
+        size_t             size;
+        char               name[0];
+};
+typedef struct dht_hint dht_hint_t;
+
+struct dht_hints {
+        gf_lock_t          lock;
+        struct list_head  *buckets;
+        uint32_t           bucket_cnt;
+        struct list_head   lru;          /* most recently used first */
+        uint64_t           size;         /* bytes held by hints */
+        uint64_t           limit;        /* 0 disables the cache */
+        uint64_t           count;
+
+        /* lookup_everywhere fan-outs in flight and lookups queued for a
+           slot; lookups of a name already being fanned out wait on the
+           running one instead */
+        uint32_t           everywhere_max;
+        uint32_t           everywhere_active;
+        struct list_head   everywhere_running;
+        struct list_head   everywhere_queue;
+
+        /* statistics */
+        uint64_t           hits;
+        uint64_t           stale;
+        uint64_t           evictions;
+        uint64_t           everywhere;         /* fan-outs wound */
+        uint64_t           everywhere_saved;   /* answered by a hint */
+        uint64_t           everywhere_batched; /* answered by another's */
+        uint64_t           everywhere_delayed; /* waited for a slot */
+};
+typedef struct dht_hints dht_hints_t;
+
+enum {
+        DHT_EVERYWHERE_NONE = 0,
+        DHT_EVERYWHERE_QUEUED,
+        DHT_EVERYWHERE_RUNNING,
+        DHT_EVERYWHERE_BATCHED,
+};
+
+enum {
+        DHT_HINT_PROBE_NONE = 0,
+        DHT_HINT_PROBE_FIRST,      /* before the hashed subvolume */
+        DHT_HINT_PROBE_MISSING,    /* instead of lookup_everywhere */
+};
+
+#define dht_hints_active(conf) ((conf)->hints && (conf)->hints->limit)
+
 struct dht_conf {
         gf_lock_t      subvolume_lock;
         int            subvolume_cnt;
@@ -253,6 +342,16 @@ struct dht_conf {
         /* Request to filter directory entries in readdir request */
 
         gf_boolean_t    readdir_optimize;
+
+        /* reads and writes in flight while migrating a file */
+        uint32_t        rebal_copy_window;
+
+        /* where names off their hashed subvolume live, NULL if unused */
+        dht_hints_t    *hints;
+
+        /* size hash ranges of new layouts by capacity (and latency) */
+        gf_boolean_t    weighted_rebalance;
+        gf_boolean_t    weighted_rebalance_latency;
 };
 typedef struct dht_conf dht_conf_t;
 
@@ -381,10 +480,31 @@ int       dht_subvol_cnt (xlator_t *this, xlator_t *subvol);
 
 int dht_hash_compute (int type, const char *name, uint32_t *hash_p);
 
+uint64_t dht_subvol_weight (xlator_t *this, xlator_t *subvol);
+
 int dht_linkfile_create (call_frame_t    *frame, fop_mknod_cbk_t linkfile_cbk,
                          xlator_t        *tovol, xlator_t *fromvol, loc_t *loc);
 int                                       dht_lookup_directory (call_frame_t *frame, xlator_t *this, loc_t *loc);
 int                                       dht_lookup_everywhere (call_frame_t *frame, xlator_t *this, loc_t *loc);
+int dht_lookup_everywhere_wind (call_frame_t *frame, xlator_t *this,
+                                loc_t *loc);
+int dht_lookup_everywhere_done (call_frame_t *frame, xlator_t *this);
+
+int dht_hints_init (xlator_t *this, dht_conf_t *conf, uint64_t limit,
+                    uint32_t everywhere_max);
+void dht_hints_reconf (xlator_t *this, dht_conf_t *conf, uint64_t limit,
+                       uint32_t everywhere_max);
+void dht_hints_fini (xlator_t *this, dht_conf_t *conf);
+void dht_hints_dump (xlator_t *this, dht_conf_t *conf);
+void dht_hint_set (xlator_t *this, uuid_t pargfid, const char *name,
+                   uuid_t gfid, xlator_t *subvol);
+void dht_hint_set_loc (xlator_t *this, loc_t *loc, uuid_t gfid,
+                       xlator_t *subvol);
+void dht_hint_del (xlator_t *this, loc_t *loc);
+int dht_lookup_hinted (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                       int probe);
+int dht_everywhere_admit (call_frame_t *frame, xlator_t *this, loc_t *loc);
+void dht_everywhere_finish (call_frame_t *frame, xlator_t *this);
 int
 dht_selfheal_directory (call_frame_t     *frame, dht_selfheal_dir_cbk_t cbk,
                         loc_t            *loc, dht_layout_t *layout);
@@ -459,6 +579,31 @@ int32_t dht_ftruncate (call_frame_t *frame,
                        fd_t     *fd,
                        off_t     offset, dict_t *xdata);
 
+int32_t dht_fallocate (call_frame_t *frame,
+                       xlator_t *this,
+                       fd_t     *fd,
+                       int32_t   keep_size,
+                       off_t     offset,
+                       size_t    len, dict_t *xdata);
+
+int32_t dht_discard (call_frame_t *frame,
+                     xlator_t *this,
+                     fd_t     *fd,
+                     off_t     offset,
+                     size_t    len, dict_t *xdata);
+
+int32_t dht_zerofill (call_frame_t *frame,
+                      xlator_t *this,
+                      fd_t     *fd,
+                      off_t     offset,
+                      off_t     len, dict_t *xdata);
+
+int32_t dht_seek (call_frame_t *frame,
+                  xlator_t *this,
+                  fd_t     *fd,
+                  off_t     offset,
+                  gf_seek_what_t what, dict_t *xdata);
+
 int32_t dht_access (call_frame_t *frame,
                     xlator_t *this,
                     loc_t    *loc,
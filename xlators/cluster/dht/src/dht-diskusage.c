@@ -36,10 +36,15 @@ dht_du_info_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 	double         percent = 0;
 	double         percent_inodes = 0;
 	uint64_t       bytes = 0;
+	uint64_t       total = 0;
+	uint64_t       elapsed = 0;
+	struct timeval now = {0,};
 
 	conf = this->private;
 	prev = cookie;
 
+	gettimeofday (&now, NULL);
+
 	if (op_ret == -1) {
 		gf_log (this->name, GF_LOG_WARNING,
 			"failed to get disk info from %s", prev->this->name);
@@ -49,6 +54,7 @@ dht_du_info_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 	if (statvfs && statvfs->f_blocks) {
 		percent = (statvfs->f_bavail * 100) / statvfs->f_blocks;
 		bytes = (statvfs->f_bavail * statvfs->f_frsize);
+		total = (statvfs->f_blocks * statvfs->f_frsize);
 	}
 
 	if (statvfs && statvfs->f_files) {
@@ -70,6 +76,19 @@ dht_du_info_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 				conf->du_stats[i].avail_percent = percent;
 				conf->du_stats[i].avail_space   = bytes;
 				conf->du_stats[i].avail_inodes  = percent_inodes;
+				conf->du_stats[i].total_space   = total;
+
+				/* moving average of the round trip */
+				elapsed = (now.tv_sec -
+					   conf->du_stats[i].sent.tv_sec) * 1e6
+					+ (now.tv_usec -
+					   conf->du_stats[i].sent.tv_usec);
+				if (!conf->du_stats[i].latency)
+					conf->du_stats[i].latency = elapsed;
+				else
+					conf->du_stats[i].latency =
+						(conf->du_stats[i].latency * 7
+						 + elapsed) / 8;
 				gf_log (this->name, GF_LOG_DEBUG,
 					"on subvolume '%s': avail_percent is: "
 					"%.2f and avail_space is: %"PRIu64" "
@@ -118,6 +137,7 @@ dht_get_du_info_for_subvol (xlator_t *this, int subvol_idx)
         tmp_loc.gfid[15] = 1;
 
 	statfs_local->call_cnt = 1;
+	gettimeofday (&conf->du_stats[subvol_idx].sent, NULL);
 	STACK_WIND (statfs_frame, dht_du_info_cbk,
 		    conf->subvolumes[subvol_idx],
 		    conf->subvolumes[subvol_idx]->fops->statfs,
@@ -166,6 +186,7 @@ dht_get_du_info (call_frame_t *frame, xlator_t *this, loc_t *loc)
 
 		statfs_local->call_cnt = conf->subvolume_cnt;
 		for (i = 0; i < conf->subvolume_cnt; i++) {
+			conf->du_stats[i].sent = tv;
 			STACK_WIND (statfs_frame, dht_du_info_cbk,
 				    conf->subvolumes[i],
 				    conf->subvolumes[i]->fops->statfs,
@@ -295,3 +316,49 @@ dht_free_disk_available_subvol (xlator_t *this, xlator_t *subvol)
 
 	return avail_subvol;
 }
+
+
+/* Share of the hash space @subvol gets in a weighted layout: its capacity
+   in MB, optionally scaled down by how much slower than the fastest
+   subvolume it answers, to no less than a quarter. 0 while not known. */
+uint64_t
+dht_subvol_weight (xlator_t *this, xlator_t *subvol)
+{
+	int         i = 0;
+	dht_conf_t *conf = NULL;
+	uint64_t    weight = 0;
+	uint64_t    latency = 0;
+	uint64_t    fastest = 0;
+	double      factor = 1.0;
+
+	conf = this->private;
+
+	LOCK (&conf->subvolume_lock);
+	{
+		for (i = 0; i < conf->subvolume_cnt; i++) {
+			if (conf->du_stats[i].latency &&
+			    (!fastest || conf->du_stats[i].latency < fastest))
+				fastest = conf->du_stats[i].latency;
+
+			if (subvol != conf->subvolumes[i])
+				continue;
+
+			weight  = conf->du_stats[i].total_space >> 20;
+			latency = conf->du_stats[i].latency;
+			if (!weight && conf->du_stats[i].total_space)
+				weight = 1;
+		}
+	}
+	UNLOCK (&conf->subvolume_lock);
+
+	if (weight && conf->weighted_rebalance_latency && latency && fastest) {
+		factor = (double) fastest / latency;
+		if (factor < 0.25)
+			factor = 0.25;
+		weight = (uint64_t) (weight * factor);
+		if (!weight)
+			weight = 1;
+	}
+
+	return weight;
+}
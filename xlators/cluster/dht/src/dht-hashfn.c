@@ -20,8 +20,9 @@
 #include "hashfn.h"
 
 
-int
-dht_hash_compute_internal (int type, const char *name, uint32_t *hash_p)
+static int
+dht_hash_compute_internal (int type, const char *name, int len,
+                           uint32_t *hash_p)
 {
         int      ret = 0;
         uint32_t hash = 0;
@@ -29,7 +30,7 @@ dht_hash_compute_internal (int type, const char *name, uint32_t *hash_p)
         switch (type) {
         case DHT_HASH_TYPE_DM:
         case DHT_HASH_TYPE_DM_USER:
-                hash = gf_dm_hashfn (name, strlen (name));
+                hash = gf_dm_hashfn (name, len);
                 break;
         default:
                 ret = -1;
@@ -44,30 +45,24 @@ dht_hash_compute_internal (int type, const char *name, uint32_t *hash_p)
 }
 
 
-#define MAKE_RSYNC_FRIENDLY_NAME(rsync_frndly_name, name) do {          \
-                rsync_frndly_name = (char *) name;                      \
-                if (name[0] == '.') {                                   \
-                        char *dot   = 0;                                \
-                        int namelen = 0;                                \
-                                                                        \
-                        dot = strrchr (name, '.');                      \
-                        if (dot && dot > (name + 1) && *(dot + 1)) {    \
-                                namelen = (dot - name);                 \
-                                rsync_frndly_name = alloca (namelen);   \
-                                strncpy (rsync_frndly_name, name + 1,   \
-                                         namelen);                      \
-                                rsync_frndly_name[namelen - 1] = 0;     \
-                        }                                               \
-                }                                                       \
-        } while (0);
-
-
+/* rsync writes ".name.XXXXXX" and renames it to "name" when done, both hash
+   as "name" so that the rename does not need a linkfile. The part of the
+   name to hash is passed by length, without copying it. */
 int
 dht_hash_compute (int type, const char *name, uint32_t *hash_p)
 {
-        char     *rsync_friendly_name = NULL;
+        const char *dot  = NULL;
+        int         len  = 0;
 
-        MAKE_RSYNC_FRIENDLY_NAME (rsync_friendly_name, name);
+        len = strlen (name);
+
+        if (name[0] == '.') {
+                dot = strrchr (name, '.');
+                if (dot && dot > (name + 1) && *(dot + 1)) {
+                        len = dot - name - 1;
+                        name++;
+                }
+        }
 
-        return dht_hash_compute_internal (type, rsync_friendly_name, hash_p);
+        return dht_hash_compute_internal (type, name, len, hash_p);
 }
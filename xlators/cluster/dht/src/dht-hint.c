@@ -0,0 +1,682 @@
+/*
+  Copyright (c) 2012 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include "glusterfs.h"
+#include "xlator.h"
+#include "hashfn.h"
+#include "statedump.h"
+#include "dht-common.h"
+
+/*
+ * Lookup hints.
+ *
+ * A file which is not on its hashed subvolume (renamed, or left behind by
+ * a layout change) costs either a linkfile hop or a lookup on every
+ * subvolume each time a client looks it up. The hint cache remembers, per
+ * (parent gfid, name), the subvolume such a file was last found on, as
+ * learnt from readdirp, from following linkfiles and from lookup_everywhere.
+ * A fresh lookup of a hinted name goes straight to that subvolume, and a
+ * lookup which missed on the hashed subvolume probes the hinted one before
+ * falling back to lookup_everywhere. A hint is only ever a guess: a probe
+ * which finds nothing, a directory, a linkfile or another gfid drops it and
+ * the lookup goes on exactly as it would have without it.
+ *
+ * The cache is bounded by the memory its hints use and evicts the least
+ * recently used ones.
+ *
+ * lookup_everywhere itself is admitted here too: at most everywhere_max
+ * fan-outs run at a time, the rest queue, and a lookup of a name which is
+ * already being fanned out waits for that fan-out and takes its result.
+ */
+
+#define DHT_HINT_BUCKET_BYTES   256
+#define DHT_HINT_BUCKETS_MIN    64
+#define DHT_HINT_BUCKETS_MAX    (1 << 20)
+
+
+static unsigned char *
+dht_hint_parent (loc_t *loc)
+{
+        if (!uuid_is_null (loc->pargfid))
+                return loc->pargfid;
+
+        if (loc->parent && !uuid_is_null (loc->parent->gfid))
+                return loc->parent->gfid;
+
+        return NULL;
+}
+
+
+static uint32_t
+dht_hint_hash (dht_hints_t *hints, uuid_t pargfid, const char *name,
+               int len)
+{
+        uint32_t  hash = 0;
+        uint32_t  salt = 0;
+
+        memcpy (&salt, pargfid + 12, sizeof (salt));
+        hash = SuperFastHash (name, len) ^ salt;
+
+        return hash & (hints->bucket_cnt - 1);
+}
+
+
+static dht_hint_t *
+__dht_hint_find (dht_hints_t *hints, uuid_t pargfid, const char *name,
+                 uint32_t bucket)
+{
+        dht_hint_t *hint = NULL;
+
+        list_for_each_entry (hint, &hints->buckets[bucket], hash) {
+                if (!strcmp (hint->name, name) &&
+                    !uuid_compare (hint->pargfid, pargfid))
+                        return hint;
+        }
+
+        return NULL;
+}
+
+
+static void
+__dht_hint_destroy (dht_hints_t *hints, dht_hint_t *hint)
+{
+        list_del (&hint->hash);
+        list_del (&hint->lru);
+
+        hints->size -= hint->size;
+        hints->count--;
+
+        GF_FREE (hint);
+}
+
+
+static void
+__dht_hints_shrink (dht_hints_t *hints)
+{
+        dht_hint_t *hint = NULL;
+
+        while (hints->size > hints->limit && !list_empty (&hints->lru)) {
+                hint = list_entry (hints->lru.prev, dht_hint_t, lru);
+                __dht_hint_destroy (hints, hint);
+                hints->evictions++;
+        }
+}
+
+
+void
+dht_hint_set (xlator_t *this, uuid_t pargfid, const char *name, uuid_t gfid,
+              xlator_t *subvol)
+{
+        dht_conf_t   *conf   = NULL;
+        dht_hints_t  *hints  = NULL;
+        dht_hint_t   *hint   = NULL;
+        uint32_t      bucket = 0;
+        int           len    = 0;
+
+        conf = this->private;
+        if (!dht_hints_active (conf) || !pargfid || !name || !subvol)
+                return;
+
+        hints = conf->hints;
+        len = strlen (name);
+        bucket = dht_hint_hash (hints, pargfid, name, len);
+
+        LOCK (&hints->lock);
+        {
+                hint = __dht_hint_find (hints, pargfid, name, bucket);
+                if (hint) {
+                        hint->subvol = subvol;
+                        uuid_copy (hint->gfid, gfid);
+                        list_move (&hint->lru, &hints->lru);
+                        goto unlock;
+                }
+
+                hint = GF_CALLOC (1, sizeof (*hint) + len + 1,
+                                  gf_dht_mt_hint_t);
+                if (!hint)
+                        goto unlock;
+
+                uuid_copy (hint->pargfid, pargfid);
+                uuid_copy (hint->gfid, gfid);
+                hint->subvol = subvol;
+                hint->size   = sizeof (*hint) + len + 1;
+                memcpy (hint->name, name, len + 1);
+
+                list_add (&hint->hash, &hints->buckets[bucket]);
+                list_add (&hint->lru, &hints->lru);
+                hints->size += hint->size;
+                hints->count++;
+
+                __dht_hints_shrink (hints);
+        }
+unlock:
+        UNLOCK (&hints->lock);
+}
+
+
+void
+dht_hint_set_loc (xlator_t *this, loc_t *loc, uuid_t gfid, xlator_t *subvol)
+{
+        dht_hint_set (this, dht_hint_parent (loc), loc->name, gfid, subvol);
+}
+
+
+void
+dht_hint_del (xlator_t *this, loc_t *loc)
+{
+        dht_conf_t    *conf    = NULL;
+        dht_hints_t   *hints   = NULL;
+        dht_hint_t    *hint    = NULL;
+        unsigned char *pargfid = NULL;
+        uint32_t       bucket  = 0;
+
+        conf = this->private;
+        if (!dht_hints_active (conf) || !loc || !loc->name)
+                return;
+
+        pargfid = dht_hint_parent (loc);
+        if (!pargfid)
+                return;
+
+        hints = conf->hints;
+        bucket = dht_hint_hash (hints, pargfid, loc->name,
+                                strlen (loc->name));
+
+        LOCK (&hints->lock);
+        {
+                hint = __dht_hint_find (hints, pargfid, loc->name, bucket);
+                if (hint)
+                        __dht_hint_destroy (hints, hint);
+        }
+        UNLOCK (&hints->lock);
+}
+
+
+static xlator_t *
+dht_hint_get (xlator_t *this, loc_t *loc)
+{
+        dht_conf_t    *conf    = NULL;
+        dht_hints_t   *hints   = NULL;
+        dht_hint_t    *hint    = NULL;
+        xlator_t      *subvol  = NULL;
+        unsigned char *pargfid = NULL;
+        uint32_t       bucket  = 0;
+
+        conf = this->private;
+        if (!dht_hints_active (conf) || !loc->name)
+                return NULL;
+
+        pargfid = dht_hint_parent (loc);
+        if (!pargfid)
+                return NULL;
+
+        hints = conf->hints;
+        bucket = dht_hint_hash (hints, pargfid, loc->name,
+                                strlen (loc->name));
+
+        LOCK (&hints->lock);
+        {
+                hint = __dht_hint_find (hints, pargfid, loc->name, bucket);
+                if (!hint)
+                        goto unlock;
+
+                /* a hint for what used to be at this name */
+                if (loc->inode && !uuid_is_null (loc->inode->gfid) &&
+                    uuid_compare (loc->inode->gfid, hint->gfid)) {
+                        __dht_hint_destroy (hints, hint);
+                        goto unlock;
+                }
+
+                list_move (&hint->lru, &hints->lru);
+                subvol = hint->subvol;
+        }
+unlock:
+        UNLOCK (&hints->lock);
+
+        return subvol;
+}
+
+
+static int
+dht_lookup_hint_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                     int op_ret, int op_errno, inode_t *inode,
+                     struct iatt *stbuf, dict_t *xattr,
+                     struct iatt *postparent)
+{
+        call_frame_t *prev   = NULL;
+        dht_local_t  *local  = NULL;
+        dht_conf_t   *conf   = NULL;
+        xlator_t     *hashed = NULL;
+        loc_t        *loc    = NULL;
+        int           ret    = 0;
+
+        prev   = cookie;
+        local  = frame->local;
+        conf   = this->private;
+        loc    = &local->loc;
+        hashed = local->hashed_subvol;
+
+        if (op_ret == -1)
+                goto stale;
+
+        if (check_is_dir (inode, stbuf, xattr) ||
+            check_is_linkfile (inode, stbuf, xattr))
+                goto stale;
+
+        if (!uuid_is_null (local->gfid) &&
+            uuid_compare (local->gfid, stbuf->ia_gfid))
+                goto stale;
+
+        ret = dht_layout_preset (this, prev->this, inode);
+        if (ret < 0) {
+                gf_log (this->name, GF_LOG_INFO,
+                        "failed to set layout for subvolume %s",
+                        prev->this->name);
+                op_ret   = -1;
+                op_errno = EINVAL;
+        }
+
+        if ((prev->this != hashed) && (stbuf->ia_nlink == 1)
+            && conf->unhashed_sticky_bit) {
+                stbuf->ia_prot.sticky = 1;
+        }
+
+        LOCK (&conf->hints->lock);
+        {
+                conf->hints->hits++;
+                if (local->everywhere.hint_probe == DHT_HINT_PROBE_MISSING)
+                        conf->hints->everywhere_saved++;
+        }
+        UNLOCK (&conf->hints->lock);
+
+        WIPE (postparent);
+
+        DHT_STRIP_PHASE1_FLAGS (stbuf);
+        DHT_STACK_UNWIND (lookup, frame, op_ret, op_errno, inode, stbuf, xattr,
+                          postparent);
+        return 0;
+
+stale:
+        gf_log (this->name, GF_LOG_TRACE, "stale hint for %s on %s",
+                loc->path, prev->this->name);
+
+        dht_hint_del (this, loc);
+
+        LOCK (&conf->hints->lock);
+        {
+                conf->hints->stale++;
+        }
+        UNLOCK (&conf->hints->lock);
+
+        if ((local->everywhere.hint_probe == DHT_HINT_PROBE_FIRST) && hashed) {
+                local->everywhere.hint_probe = DHT_HINT_PROBE_NONE;
+                STACK_WIND (frame, dht_lookup_cbk,
+                            hashed, hashed->fops->lookup,
+                            loc, local->xattr_req);
+                return 0;
+        }
+
+        local->everywhere.hint_probe = DHT_HINT_PROBE_NONE;
+        dht_lookup_everywhere (frame, this, loc);
+        return 0;
+}
+
+
+/* Send the lookup of @loc to the subvolume it is hinted on. Returns 0 when
+   the lookup was wound (and will be unwound or continued from there), -1
+   when there is no usable hint and the caller has to carry on itself. */
+int
+dht_lookup_hinted (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                   int probe)
+{
+        dht_local_t *local  = NULL;
+        xlator_t    *subvol = NULL;
+
+        local = frame->local;
+        local->everywhere.hint_tried = 1;
+
+        subvol = dht_hint_get (this, loc);
+        if (!subvol || (subvol == local->hashed_subvol))
+                return -1;
+
+        local->everywhere.hint_probe = probe;
+
+        STACK_WIND (frame, dht_lookup_hint_cbk,
+                    subvol, subvol->fops->lookup,
+                    loc, local->xattr_req);
+
+        return 0;
+}
+
+
+static gf_boolean_t
+dht_everywhere_same_name (dht_local_t *a, dht_local_t *b)
+{
+        unsigned char *pa = NULL;
+        unsigned char *pb = NULL;
+
+        if (!a->loc.name || !b->loc.name)
+                return _gf_false;
+
+        pa = dht_hint_parent (&a->loc);
+        pb = dht_hint_parent (&b->loc);
+        if (!pa || !pb)
+                return _gf_false;
+
+        return (!uuid_compare (pa, pb) && !strcmp (a->loc.name, b->loc.name));
+}
+
+
+/* Decide whether the lookup_everywhere of @frame may go out now. Returns 0
+   if the caller should wind it, 1 if it was parked and will be resumed by
+   dht_everywhere_finish () of another lookup. */
+int
+dht_everywhere_admit (call_frame_t *frame, xlator_t *this, loc_t *loc)
+{
+        dht_conf_t   *conf    = NULL;
+        dht_hints_t  *hints   = NULL;
+        dht_local_t  *local   = NULL;
+        dht_local_t  *running = NULL;
+        int           parked  = 0;
+
+        conf  = this->private;
+        local = frame->local;
+        hints = conf->hints;
+
+        if (!hints)
+                return 0;
+
+        local->everywhere.frame = frame;
+
+        LOCK (&hints->lock);
+        {
+                if (local->everywhere.state == DHT_EVERYWHERE_NONE) {
+                        list_for_each_entry (running,
+                                             &hints->everywhere_running,
+                                             everywhere.list) {
+                                if (!dht_everywhere_same_name (running,
+                                                               local))
+                                        continue;
+
+                                local->everywhere.state =
+                                        DHT_EVERYWHERE_BATCHED;
+                                list_add_tail (&local->everywhere.list,
+                                               &running->everywhere.waiters);
+                                hints->everywhere_batched++;
+                                parked = 1;
+                                goto unlock;
+                        }
+                }
+
+                if (hints->everywhere_max &&
+                    (hints->everywhere_active >= hints->everywhere_max)) {
+                        local->everywhere.state = DHT_EVERYWHERE_QUEUED;
+                        list_add_tail (&local->everywhere.list,
+                                       &hints->everywhere_queue);
+                        hints->everywhere_delayed++;
+                        parked = 1;
+                        goto unlock;
+                }
+
+                local->everywhere.state = DHT_EVERYWHERE_RUNNING;
+                INIT_LIST_HEAD (&local->everywhere.waiters);
+                list_add_tail (&local->everywhere.list,
+                               &hints->everywhere_running);
+                hints->everywhere_active++;
+                hints->everywhere++;
+        }
+unlock:
+        UNLOCK (&hints->lock);
+
+        return parked;
+}
+
+
+static void
+dht_everywhere_copy (dht_local_t *to, dht_local_t *from)
+{
+        to->file_count    = from->file_count;
+        to->dir_count     = from->dir_count;
+        to->op_errno      = from->op_errno;
+        to->cached_subvol = from->cached_subvol;
+        to->stbuf         = from->stbuf;
+        to->postparent    = from->postparent;
+
+        uuid_copy (to->gfid, from->gfid);
+
+        if (to->xattr) {
+                dict_unref (to->xattr);
+                to->xattr = NULL;
+        }
+        if (from->xattr)
+                to->xattr = dict_ref (from->xattr);
+}
+
+
+/* The fan-out of @frame has collected all its replies: hand the result to
+   the lookups batched on it and let the next queued fan-out go. */
+void
+dht_everywhere_finish (call_frame_t *frame, xlator_t *this)
+{
+        dht_conf_t       *conf   = NULL;
+        dht_hints_t      *hints  = NULL;
+        dht_local_t      *local  = NULL;
+        dht_local_t      *waiter = NULL;
+        dht_local_t      *tmp    = NULL;
+        dht_local_t      *next   = NULL;
+        struct list_head  waiters;
+
+        conf  = this->private;
+        local = frame->local;
+        hints = conf->hints;
+
+        if (!hints || (local->everywhere.state != DHT_EVERYWHERE_RUNNING))
+                return;
+
+        INIT_LIST_HEAD (&waiters);
+
+        LOCK (&hints->lock);
+        {
+                list_del_init (&local->everywhere.list);
+                list_splice_init (&local->everywhere.waiters, &waiters);
+                local->everywhere.state = DHT_EVERYWHERE_NONE;
+                hints->everywhere_active--;
+
+                if (!list_empty (&hints->everywhere_queue)) {
+                        next = list_entry (hints->everywhere_queue.next,
+                                           dht_local_t, everywhere.list);
+                        list_move_tail (&next->everywhere.list,
+                                        &hints->everywhere_running);
+                        INIT_LIST_HEAD (&next->everywhere.waiters);
+                        next->everywhere.state = DHT_EVERYWHERE_RUNNING;
+                        hints->everywhere_active++;
+                        hints->everywhere++;
+                }
+        }
+        UNLOCK (&hints->lock);
+
+        list_for_each_entry_safe (waiter, tmp, &waiters, everywhere.list) {
+                list_del_init (&waiter->everywhere.list);
+                waiter->everywhere.state = DHT_EVERYWHERE_NONE;
+
+                dht_everywhere_copy (waiter, local);
+                dht_lookup_everywhere_done (waiter->everywhere.frame, this);
+        }
+
+        if (next)
+                dht_lookup_everywhere_wind (next->everywhere.frame, this,
+                                            &next->loc);
+}
+
+
+int
+dht_hints_init (xlator_t *this, dht_conf_t *conf, uint64_t limit,
+                uint32_t everywhere_max)
+{
+        dht_hints_t *hints = NULL;
+        uint32_t     cnt   = DHT_HINT_BUCKETS_MIN;
+        uint32_t     i     = 0;
+
+        hints = GF_CALLOC (1, sizeof (*hints), gf_dht_mt_hints_t);
+        if (!hints)
+                goto err;
+
+        /* sized for the configured limit, a later increase only makes
+           the chains longer */
+        while ((cnt < DHT_HINT_BUCKETS_MAX) &&
+               ((uint64_t) cnt * DHT_HINT_BUCKET_BYTES < limit))
+                cnt <<= 1;
+
+        hints->buckets = GF_CALLOC (cnt, sizeof (*hints->buckets),
+                                    gf_dht_mt_hints_t);
+        if (!hints->buckets)
+                goto err;
+
+        for (i = 0; i < cnt; i++)
+                INIT_LIST_HEAD (&hints->buckets[i]);
+
+        hints->bucket_cnt     = cnt;
+        hints->limit          = limit;
+        hints->everywhere_max = everywhere_max;
+
+        LOCK_INIT (&hints->lock);
+        INIT_LIST_HEAD (&hints->lru);
+        INIT_LIST_HEAD (&hints->everywhere_running);
+        INIT_LIST_HEAD (&hints->everywhere_queue);
+
+        conf->hints = hints;
+
+        return 0;
+err:
+        if (hints)
+                GF_FREE (hints->buckets);
+        GF_FREE (hints);
+
+        return -1;
+}
+
+
+void
+dht_hints_reconf (xlator_t *this, dht_conf_t *conf, uint64_t limit,
+                  uint32_t everywhere_max)
+{
+        dht_hints_t *hints = NULL;
+        dht_local_t *next  = NULL;
+
+        hints = conf->hints;
+        if (!hints)
+                return;
+
+        LOCK (&hints->lock);
+        {
+                hints->limit = limit;
+                __dht_hints_shrink (hints);
+
+                hints->everywhere_max = everywhere_max;
+        }
+        UNLOCK (&hints->lock);
+
+        /* a raised limit lets queued fan-outs go right away */
+        for (;;) {
+                next = NULL;
+
+                LOCK (&hints->lock);
+                {
+                        if (!list_empty (&hints->everywhere_queue) &&
+                            (!hints->everywhere_max ||
+                             (hints->everywhere_active <
+                              hints->everywhere_max))) {
+                                next = list_entry (hints->everywhere_queue.next,
+                                                   dht_local_t,
+                                                   everywhere.list);
+                                list_move_tail (&next->everywhere.list,
+                                                &hints->everywhere_running);
+                                INIT_LIST_HEAD (&next->everywhere.waiters);
+                                next->everywhere.state =
+                                        DHT_EVERYWHERE_RUNNING;
+                                hints->everywhere_active++;
+                                hints->everywhere++;
+                        }
+                }
+                UNLOCK (&hints->lock);
+
+                if (!next)
+                        break;
+
+                dht_lookup_everywhere_wind (next->everywhere.frame, this,
+                                            &next->loc);
+        }
+}
+
+
+void
+dht_hints_fini (xlator_t *this, dht_conf_t *conf)
+{
+        dht_hints_t *hints = NULL;
+        dht_hint_t  *hint  = NULL;
+        dht_hint_t  *tmp   = NULL;
+
+        hints = conf->hints;
+        if (!hints)
+                return;
+
+        conf->hints = NULL;
+
+        list_for_each_entry_safe (hint, tmp, &hints->lru, lru) {
+                __dht_hint_destroy (hints, hint);
+        }
+
+        LOCK_DESTROY (&hints->lock);
+        GF_FREE (hints->buckets);
+        GF_FREE (hints);
+}
+
+
+void
+dht_hints_dump (xlator_t *this, dht_conf_t *conf)
+{
+        dht_hints_t *hints = NULL;
+        int          ret   = -1;
+
+        hints = conf->hints;
+        if (!hints)
+                return;
+
+        ret = TRY_LOCK (&hints->lock);
+        if (ret)
+                return;
+        {
+                gf_proc_dump_write ("hints.limit", "%"PRIu64, hints->limit);
+                gf_proc_dump_write ("hints.size", "%"PRIu64, hints->size);
+                gf_proc_dump_write ("hints.count", "%"PRIu64, hints->count);
+                gf_proc_dump_write ("hints.hits", "%"PRIu64, hints->hits);
+                gf_proc_dump_write ("hints.stale", "%"PRIu64, hints->stale);
+                gf_proc_dump_write ("hints.evictions", "%"PRIu64,
+                                    hints->evictions);
+                gf_proc_dump_write ("lookup_everywhere.max", "%u",
+                                    hints->everywhere_max);
+                gf_proc_dump_write ("lookup_everywhere.active", "%u",
+                                    hints->everywhere_active);
+                gf_proc_dump_write ("lookup_everywhere.wound", "%"PRIu64,
+                                    hints->everywhere);
+                gf_proc_dump_write ("lookup_everywhere.saved_by_hint",
+                                    "%"PRIu64, hints->everywhere_saved);
+                gf_proc_dump_write ("lookup_everywhere.batched", "%"PRIu64,
+                                    hints->everywhere_batched);
+                gf_proc_dump_write ("lookup_everywhere.delayed", "%"PRIu64,
+                                    hints->everywhere_delayed);
+        }
+        UNLOCK (&hints->lock);
+}
@@ -156,6 +156,35 @@ dht_layout_ref (xlator_t *this, dht_layout_t *layout)
 }
 
 
+/* below this many ranges the linear scan is as fast (extras/benchmarking/
+   dht-layout-bm.c) */
+#define DHT_LAYOUT_BSEARCH_MIN 64
+
+/* the entry whose range holds @hash, found by bisection. Only meaningful on
+   a layout sorted by start without overlaps, as dht_layout_normalize leaves
+   a healthy one; anything else makes it miss, never hit a wrong range. */
+static int
+dht_layout_bsearch (dht_layout_t *layout, uint32_t hash)
+{
+        int   lo  = 0;
+        int   hi  = layout->cnt - 1;
+        int   mid = 0;
+
+        while (lo <= hi) {
+                mid = lo + (hi - lo) / 2;
+
+                if (hash < layout->list[mid].start)
+                        hi = mid - 1;
+                else if (hash > layout->list[mid].stop)
+                        lo = mid + 1;
+                else
+                        return mid;
+        }
+
+        return -1;
+}
+
+
 xlator_t *
 dht_layout_search (xlator_t *this, dht_layout_t *layout, const char *name)
 {
@@ -173,6 +202,15 @@ dht_layout_search (xlator_t *this, dht_layout_t *layout, const char *name)
                 goto out;
         }
 
+        if (layout->cnt >= DHT_LAYOUT_BSEARCH_MIN) {
+                i = dht_layout_bsearch (layout, hash);
+                if ((i >= 0) && !layout->list[i].err) {
+                        subvol = layout->list[i].xlator;
+                        goto out;
+                }
+        }
+
+        /* unsorted, or in the middle of a self-heal */
         for (i = 0; i < layout->cnt; i++) {
                 if (layout->list[i].start <= hash
                     && layout->list[i].stop >= hash) {
@@ -441,42 +479,47 @@ dht_layout_entry_cmp (dht_layout_t *layout, int i, int j)
 }
 
 
-int
-dht_layout_sort (dht_layout_t *layout)
+static int
+dht_layout_entry_qsort_cmp (const void *a, const void *b)
 {
-        int       i = 0;
-        int       j = 0;
-        int64_t   ret = 0;
+        const struct dht_layout_entry *x = a;
+        const struct dht_layout_entry *y = b;
+        int64_t                        diff = 0;
 
-        /* TODO: O(n^2) -- bad bad */
+        /* same order as dht_layout_entry_cmp () */
+        if (x->err || y->err)
+                diff = x->err - y->err;
+        else
+                diff = (int64_t) x->start - (int64_t) y->start;
 
-        for (i = 0; i < layout->cnt - 1; i++) {
-                for (j = i + 1; j < layout->cnt; j++) {
-                        ret = dht_layout_entry_cmp (layout, i, j);
-                        if (ret > 0)
-                                dht_layout_entry_swap (layout, i, j);
-                }
-        }
+        return (diff > 0) - (diff < 0);
+}
 
-        return 0;
+
+static int
+dht_layout_entry_qsort_cmp_volname (const void *a, const void *b)
+{
+        const struct dht_layout_entry *x = a;
+        const struct dht_layout_entry *y = b;
+
+        return strcmp (x->xlator->name, y->xlator->name);
 }
 
+
 int
-dht_layout_sort_volname (dht_layout_t *layout)
+dht_layout_sort (dht_layout_t *layout)
 {
-        int       i = 0;
-        int       j = 0;
-        int64_t   ret = 0;
+        qsort (layout->list, layout->cnt, layout_entry_size,
+               dht_layout_entry_qsort_cmp);
 
-        /* TODO: O(n^2) -- bad bad */
+        return 0;
+}
 
-        for (i = 0; i < layout->cnt - 1; i++) {
-                for (j = i + 1; j < layout->cnt; j++) {
-                        ret = dht_layout_entry_cmp_volname (layout, i, j);
-                        if (ret > 0)
-                                dht_layout_entry_swap (layout, i, j);
-                }
-        }
+int
+dht_layout_sort_volname (dht_layout_t *layout)
+{
+        qsort (layout->list, layout->cnt, layout_entry_size,
+               dht_layout_entry_qsort_cmp_volname);
 
         return 0;
 }
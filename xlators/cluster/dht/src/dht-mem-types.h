@@ -28,6 +28,12 @@ enum gf_dht_mem_types_ {
         gf_dht_mt_subvol_time,
         gf_dht_mt_loc_t,
         gf_defrag_info_mt,
+        gf_defrag_entry_mt,
+        gf_dht_mt_copy_args_t,
+        gf_dht_mt_synctask_t,
+        gf_dht_mt_hints_t,
+        gf_dht_mt_hint_t,
+        gf_dht_mt_uint64_t,
         gf_dht_mt_end
 };
 #endif
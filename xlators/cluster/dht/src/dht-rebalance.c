@@ -16,10 +16,12 @@
 
 #include "dht-common.h"
 #include "xlator.h"
+#include "timer.h"
 
 #define GF_DISK_SECTOR_SIZE             512
 #define DHT_REBALANCE_PID               4242 /* Change it if required */
 #define DHT_REBALANCE_BLKSIZE           (128 * 1024)
+#define DHT_REBALANCE_WINDOW_MAX        16
 
 static int
 dht_write_with_holes (xlator_t *to, fd_t *fd, struct iovec *vec, int count,
@@ -382,9 +384,223 @@ out:
         return ret;
 }
 
-static inline int
-__dht_rebalance_migrate_data (xlator_t *from, xlator_t *to, fd_t *src, fd_t *dst,
-                             uint64_t ia_size, int hole_exists)
+/* one block of a file being copied with several requests in flight */
+struct dht_copy_slot {
+        struct dht_copy_args *args;
+        off_t                 offset;
+        size_t                size;
+        int32_t               op_ret;
+        int32_t               op_errno;
+        struct iovec         *vector;
+        int32_t               count;
+        struct iobref        *iobref;
+};
+
+struct dht_copy_args {
+        gf_lock_t             lock;
+        int                   pending;
+        struct synctask      *task;
+        struct dht_copy_slot  slot[DHT_REBALANCE_WINDOW_MAX];
+};
+
+
+static void
+dht_copy_slot_wipe (struct dht_copy_slot *slot)
+{
+        GF_FREE (slot->vector);
+        slot->vector = NULL;
+
+        if (slot->iobref)
+                iobref_unref (slot->iobref);
+        slot->iobref = NULL;
+}
+
+
+/* the last reply of a batch wakes the task, which always yields exactly once
+   per batch */
+static void
+dht_copy_slot_done (struct dht_copy_slot *slot)
+{
+        struct dht_copy_args *args = slot->args;
+        int                   pending = 0;
+
+        LOCK (&args->lock);
+        {
+                pending = --args->pending;
+        }
+        UNLOCK (&args->lock);
+
+        if (!pending)
+                synctask_wake (args->task);
+}
+
+
+static int
+dht_copy_readv_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                    int32_t op_ret, int32_t op_errno, struct iovec *vector,
+                    int32_t count, struct iatt *stbuf, struct iobref *iobref,
+                    dict_t *xdata)
+{
+        struct dht_copy_slot *slot = cookie;
+
+        slot->op_ret   = op_ret;
+        slot->op_errno = op_errno;
+
+        if (op_ret >= 0) {
+                if (iobref)
+                        slot->iobref = iobref_ref (iobref);
+                slot->vector = iov_dup (vector, count);
+                slot->count  = count;
+        }
+
+        dht_copy_slot_done (slot);
+        return 0;
+}
+
+
+static int
+dht_copy_writev_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                     int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                     struct iatt *postbuf, dict_t *xdata)
+{
+        struct dht_copy_slot *slot = cookie;
+
+        slot->op_ret   = op_ret;
+        slot->op_errno = op_errno;
+
+        dht_copy_slot_done (slot);
+        return 0;
+}
+
+
+/* copy [start, ia_size) with up to 'window' blocks read, then written, in
+   parallel. Must be called from a synctask. */
+static int
+__dht_rebalance_migrate_data_window (xlator_t *from, xlator_t *to, fd_t *src,
+                                     fd_t *dst, uint64_t start,
+                                     uint64_t ia_size, int hole_exists,
+                                     int window)
+{
+        struct dht_copy_args *args   = NULL;
+        struct dht_copy_slot *slot   = NULL;
+        struct synctask      *task   = NULL;
+        call_frame_t         *frame  = NULL;
+        uint64_t              total  = 0;
+        int                   count  = 0;
+        int                   i      = 0;
+        int                   ret    = 0;
+        gf_boolean_t          eof    = _gf_false;
+
+        task  = synctask_get ();
+        frame = task->opframe;
+
+        args = GF_CALLOC (1, sizeof (*args), gf_dht_mt_copy_args_t);
+        if (!args)
+                return -1;
+
+        LOCK_INIT (&args->lock);
+        args->task = task;
+        for (i = 0; i < window; i++)
+                args->slot[i].args = args;
+
+        total = start;
+
+        while (!eof && (total < ia_size)) {
+                for (count = 0; (count < window) && (total < ia_size);
+                     count++) {
+                        slot = &args->slot[count];
+                        slot->offset = total;
+                        slot->size = (((ia_size - total) >
+                                       DHT_REBALANCE_BLKSIZE) ?
+                                      DHT_REBALANCE_BLKSIZE :
+                                      (ia_size - total));
+                        total += slot->size;
+                }
+
+                args->pending = count;
+                task->state = SYNCTASK_SUSPEND;
+                for (i = 0; i < count; i++) {
+                        slot = &args->slot[i];
+                        STACK_WIND_COOKIE (frame, dht_copy_readv_cbk, slot,
+                                           from, from->fops->readv, src,
+                                           slot->size, slot->offset, 0, NULL);
+                }
+                synctask_yield (task);
+                STACK_RESET (frame->root);
+
+                /* a short read means the file shrunk, nothing after it */
+                for (i = 0; i < count; i++) {
+                        slot = &args->slot[i];
+                        if (slot->op_ret < 0) {
+                                errno = slot->op_errno;
+                                ret = -1;
+                                goto out;
+                        }
+                        if ((size_t) slot->op_ret < slot->size) {
+                                /* keep the partial block, drop the rest */
+                                eof = _gf_true;
+                                count = (slot->op_ret) ? (i + 1) : i;
+                                break;
+                        }
+                }
+
+                if (hole_exists) {
+                        for (i = 0; i < count; i++) {
+                                slot = &args->slot[i];
+                                ret = dht_write_with_holes (to, dst,
+                                                            slot->vector,
+                                                            slot->count,
+                                                            slot->op_ret,
+                                                            slot->offset,
+                                                            slot->iobref);
+                                if (ret < 0)
+                                        goto out;
+                        }
+                } else if (count) {
+                        args->pending = count;
+                        task->state = SYNCTASK_SUSPEND;
+                        for (i = 0; i < count; i++) {
+                                slot = &args->slot[i];
+                                STACK_WIND_COOKIE (frame, dht_copy_writev_cbk,
+                                                   slot, to,
+                                                   to->fops->writev, dst,
+                                                   slot->vector, slot->count,
+                                                   slot->offset, 0,
+                                                   slot->iobref, NULL);
+                        }
+                        synctask_yield (task);
+                        STACK_RESET (frame->root);
+
+                        for (i = 0; i < count; i++) {
+                                if (args->slot[i].op_ret < 0) {
+                                        errno = args->slot[i].op_errno;
+                                        ret = -1;
+                                        goto out;
+                                }
+                        }
+                }
+
+                for (i = 0; i < window; i++)
+                        dht_copy_slot_wipe (&args->slot[i]);
+        }
+
+        ret = 0;
+out:
+        for (i = 0; i < window; i++)
+                dht_copy_slot_wipe (&args->slot[i]);
+
+        LOCK_DESTROY (&args->lock);
+        GF_FREE (args);
+
+        return ret;
+}
+
+
+/* copy [start, ia_size) of the file */
+static int
+__dht_rebalance_migrate_range (xlator_t *from, xlator_t *to, fd_t *src,
+                               fd_t *dst, uint64_t start, uint64_t ia_size,
+                               int hole_exists)
 {
         int            ret    = 0;
         int            count  = 0;
@@ -393,8 +609,23 @@ __dht_rebalance_migrate_data (xlator_t *from, xlator_t *to, fd_t *src, fd_t *dst
         struct iobref *iobref = NULL;
         uint64_t       total  = 0;
         size_t         read_size = 0;
+        dht_conf_t    *conf   = NULL;
+        int            window = 1;
 
-        /* if file size is '0', no need to enter this loop */
+        conf = THIS->private;
+        if (conf && synctask_get ())
+                window = min (conf->rebal_copy_window,
+                              DHT_REBALANCE_WINDOW_MAX);
+
+        if ((window > 1) && ((ia_size - start) > DHT_REBALANCE_BLKSIZE))
+                return __dht_rebalance_migrate_data_window (from, to, src, dst,
+                                                            start, ia_size,
+                                                            hole_exists,
+                                                            window);
+
+        offset = total = start;
+
+        /* if the range is empty, no need to enter this loop */
         while (total < ia_size) {
                 read_size = (((ia_size - total) > DHT_REBALANCE_BLKSIZE) ?
                              DHT_REBALANCE_BLKSIZE : (ia_size - total));
@@ -433,6 +664,89 @@ __dht_rebalance_migrate_data (xlator_t *from, xlator_t *to, fd_t *src, fd_t *dst
 }
 
 
+/* copy only the data extents of a sparse source, found with SEEK_DATA and
+   SEEK_HOLE, then size the destination past a trailing hole. Inside an
+   extent zeroed sectors are still left as holes. Returns 1, having copied
+   nothing, when the source cannot seek. */
+static int
+__dht_rebalance_migrate_extents (xlator_t *from, xlator_t *to, fd_t *src,
+                                 fd_t *dst, uint64_t ia_size)
+{
+        int            ret    = 0;
+        off_t          data   = 0;
+        off_t          hole   = 0;
+        uint64_t       copied = 0;
+
+        while ((uint64_t) data < ia_size) {
+                ret = syncop_seek (from, src, data, GF_SEEK_DATA, &data);
+                if ((ret < 0) && (errno == ENXIO))
+                        break;
+                if (ret < 0)
+                        goto seek_failed;
+                if ((uint64_t) data >= ia_size)
+                        break;
+
+                ret = syncop_seek (from, src, data, GF_SEEK_HOLE, &hole);
+                if (ret < 0)
+                        goto seek_failed;
+                if ((uint64_t) hole > ia_size)
+                        hole = ia_size;
+
+                ret = __dht_rebalance_migrate_range (from, to, src, dst, data,
+                                                     hole, 1);
+                if (ret < 0)
+                        return ret;
+
+                copied += hole - data;
+                data = hole;
+        }
+
+        /* the destination ends at its last write, while the source may end
+           with a hole */
+        ret = syncop_ftruncate (to, dst, ia_size);
+        if (ret < 0) {
+                gf_log (THIS->name, GF_LOG_WARNING,
+                        "failed to extend the destination to %"PRIu64" (%s)",
+                        ia_size, strerror (errno));
+                return -1;
+        }
+
+        gf_log (THIS->name, GF_LOG_DEBUG, "copied %"PRIu64" bytes in data "
+                "extents of %"PRIu64, copied, ia_size);
+        return 0;
+
+seek_failed:
+        if (copied || data) {
+                gf_log (THIS->name, GF_LOG_WARNING, "failed to seek at %"
+                        PRId64" (%s)", data, strerror (errno));
+                return -1;
+        }
+
+        /* old bricks, or a backend without SEEK_DATA */
+        gf_log (THIS->name, GF_LOG_DEBUG, "seek not supported (%s), copying "
+                "the whole file", strerror (errno));
+        return 1;
+}
+
+
+static inline int
+__dht_rebalance_migrate_data (xlator_t *from, xlator_t *to, fd_t *src, fd_t *dst,
+                             uint64_t ia_size, int hole_exists)
+{
+        int ret = 0;
+
+        if (hole_exists) {
+                ret = __dht_rebalance_migrate_extents (from, to, src, dst,
+                                                       ia_size);
+                if (ret <= 0)
+                        return ret;
+        }
+
+        return __dht_rebalance_migrate_range (from, to, src, dst, 0, ia_size,
+                                              hole_exists);
+}
+
+
 static inline int
 __dht_rebalance_open_src_file (xlator_t *from, xlator_t *to, loc_t *loc,
                                struct iatt *stbuf, fd_t **src_fd)
@@ -1031,9 +1345,416 @@ gf_defrag_handle_migrate_error (int32_t op_errno, gf_defrag_info_t *defrag)
         return 0;
 }
 
-/* We do a depth first traversal of directories. But before we move into
- * subdirs, we complete the data migration of those directories whose layouts
- * have been fixed
+/* park the calling synctask. Whoever registered it for a wake up under
+   defrag->lock calls synctask_wake () on it exactly once. */
+static void
+gf_defrag_task_wait (struct synctask *task)
+{
+        task->state = SYNCTASK_SUSPEND;
+        synctask_yield (task);
+}
+
+
+static void
+gf_defrag_timer_wake (void *data)
+{
+        synctask_wake (data);
+}
+
+
+/* sleep, without holding a syncenv thread, while the data migrated so far is
+   ahead of rate-limit */
+static void
+gf_defrag_throttle (xlator_t *this, gf_defrag_info_t *defrag)
+{
+        struct synctask *task    = NULL;
+        struct timeval   now     = {0,};
+        struct timeval   delta   = {0,};
+        double           elapsed = 0;
+        double           due     = 0;
+
+        if (!defrag->rate_limit)
+                return;
+
+        gettimeofday (&now, NULL);
+        elapsed = (now.tv_sec - defrag->start_time.tv_sec) +
+                  (now.tv_usec - defrag->start_time.tv_usec) / 1e6;
+        due = (double) defrag->total_data / defrag->rate_limit;
+        if (due <= elapsed)
+                return;
+
+        /* at most a second at a time, stop is checked in between */
+        due -= elapsed;
+        if (due > 1)
+                due = 1;
+        delta.tv_sec = (time_t) due;
+        delta.tv_usec = (suseconds_t) ((due - delta.tv_sec) * 1e6);
+
+        task = synctask_get ();
+        task->state = SYNCTASK_SUSPEND;
+        if (!gf_timer_call_after (this->ctx, delta, gf_defrag_timer_wake,
+                                  task))
+                return;
+
+        synctask_yield (task);
+}
+
+
+/* migrate one file found by the crawler. Returns -1 when the whole rebalance
+   has to stop. */
+static int
+gf_defrag_migrate_entry (xlator_t *this, gf_defrag_info_t *defrag,
+                         loc_t *entry_loc)
+{
+        int                      ret            = -1;
+        dict_t                  *dict           = NULL;
+        struct iatt              iatt           = {0,};
+        int32_t                  op_errno       = 0;
+        char                    *uuid_str       = NULL;
+        uuid_t                   node_uuid      = {0,};
+        struct timeval           end            = {0,};
+        double                   elapsed        = {0,};
+        struct timeval           start          = {0,};
+
+        if (defrag->stats == _gf_true) {
+                gettimeofday (&start, NULL);
+        }
+
+        ret = syncop_lookup (this, entry_loc, NULL, &iatt, NULL, NULL);
+        if (ret) {
+                gf_log (this->name, GF_LOG_ERROR, "%s"
+                        " lookup failed", entry_loc->path);
+                ret = 0;
+                goto out;
+        }
+
+        ret = syncop_getxattr (this, entry_loc, &dict,
+                               GF_XATTR_NODE_UUID_KEY);
+        if(ret < 0) {
+                gf_log (this->name, GF_LOG_ERROR, "Failed to "
+                        "get node-uuid for %s", entry_loc->path);
+                ret = 0;
+                goto out;
+        }
+
+        ret = dict_get_str (dict, GF_XATTR_NODE_UUID_KEY, &uuid_str);
+        if(ret < 0) {
+                gf_log (this->name, GF_LOG_ERROR, "Failed to "
+                        "get node-uuid from dict for %s", entry_loc->path);
+                ret = 0;
+                goto out;
+        }
+
+        if (uuid_parse (uuid_str, node_uuid)) {
+                gf_log (this->name, GF_LOG_ERROR, "uuid_parse "
+                        "failed for %s", entry_loc->path);
+                ret = 0;
+                goto out;
+        }
+
+        /* if file belongs to different node, skip migration
+         * the other node will take responsibility of migration
+         */
+        if (uuid_compare (node_uuid, defrag->node_uuid)) {
+                gf_log (this->name, GF_LOG_TRACE, "%s does not"
+                        "belong to this node", entry_loc->path);
+                ret = 0;
+                goto out;
+        }
+
+        uuid_str = NULL;
+
+        dict_del (dict, GF_XATTR_NODE_UUID_KEY);
+
+        /* if distribute is present, it will honor this key.
+         * -1 is returned if distribute is not present or file
+         * doesn't have a link-file. If file has link-file, the
+         * path of link-file will be the value, and also that
+         * guarantees that file has to be mostly migrated */
+
+        ret = syncop_getxattr (this, entry_loc, &dict,
+                               GF_XATTR_LINKINFO_KEY);
+        if (ret < 0) {
+                gf_log (this->name, GF_LOG_TRACE, "failed to "
+                        "get link-to key for %s", entry_loc->path);
+                ret = 0;
+                goto out;
+        }
+
+        gf_defrag_throttle (this, defrag);
+
+        ret = syncop_setxattr (this, entry_loc, defrag->migrate_data, 0);
+        if (ret) {
+                gf_log (this->name, GF_LOG_ERROR, "migrate-data"
+                        " failed for %s", entry_loc->path);
+                LOCK (&defrag->lock);
+                {
+                        defrag->total_failures += 1;
+                }
+                UNLOCK (&defrag->lock);
+        }
+
+        if (ret == -1) {
+                op_errno = errno;
+                ret = gf_defrag_handle_migrate_error (op_errno, defrag);
+
+                if (!ret)
+                        gf_log (this->name, GF_LOG_DEBUG,
+                                "migrate-data on %s failed: %s",
+                                entry_loc->path, strerror (op_errno));
+                else if (ret == 1) {
+                        ret = 0;
+                        goto out;
+                } else if (ret == -1)
+                        goto out;
+        }
+
+        LOCK (&defrag->lock);
+        {
+                defrag->total_files += 1;
+                defrag->total_data += iatt.ia_size;
+        }
+        UNLOCK (&defrag->lock);
+        if (defrag->stats == _gf_true) {
+                gettimeofday (&end, NULL);
+                elapsed = (end.tv_sec - start.tv_sec) * 1e6 +
+                          (end.tv_usec - start.tv_usec);
+                gf_log (this->name, GF_LOG_INFO, "Migration of "
+                        "file:%s size:%"PRIu64" bytes took %.2f"
+                        "secs", entry_loc->path, iatt.ia_size,
+                         elapsed/1e6);
+        }
+
+        ret = 0;
+out:
+        if (dict)
+                dict_unref (dict);
+
+        return ret;
+}
+
+
+static void
+gf_defrag_entry_free (gf_defrag_entry_t *entry)
+{
+        loc_wipe (&entry->loc);
+        GF_FREE (entry);
+}
+
+
+/* hand a file over to the workers, waits while the queue is full */
+static void
+gf_defrag_enqueue (gf_defrag_info_t *defrag, gf_defrag_entry_t *entry)
+{
+        struct synctask *task   = NULL;
+        struct synctask *worker = NULL;
+
+        task = synctask_get ();
+
+        LOCK (&defrag->lock);
+        {
+                while ((defrag->queue_count >= defrag->queue_size) &&
+                       (defrag->active_workers)) {
+                        defrag->crawler = task;
+                        UNLOCK (&defrag->lock);
+                        gf_defrag_task_wait (task);
+                        LOCK (&defrag->lock);
+                }
+
+                list_add_tail (&entry->list, &defrag->queue);
+                defrag->queue_count++;
+
+                if (defrag->idle_count)
+                        worker = defrag->idle[--defrag->idle_count];
+        }
+        UNLOCK (&defrag->lock);
+
+        if (worker)
+                synctask_wake (worker);
+}
+
+
+static int
+gf_defrag_worker (void *data)
+{
+        xlator_t          *this   = NULL;
+        dht_conf_t        *conf   = NULL;
+        gf_defrag_info_t  *defrag = NULL;
+        gf_defrag_entry_t *entry  = NULL;
+        struct synctask   *task   = NULL;
+        struct synctask   *waiter = NULL;
+        int                ret    = 0;
+
+        this = data;
+        conf = this->private;
+        defrag = conf->defrag;
+        task = synctask_get ();
+
+        for (;;) {
+                entry = NULL;
+                waiter = NULL;
+
+                LOCK (&defrag->lock);
+                {
+                        while (list_empty (&defrag->queue) &&
+                               !defrag->crawl_done) {
+                                defrag->idle[defrag->idle_count++] = task;
+                                UNLOCK (&defrag->lock);
+                                gf_defrag_task_wait (task);
+                                LOCK (&defrag->lock);
+                        }
+
+                        if (!list_empty (&defrag->queue)) {
+                                entry = list_entry (defrag->queue.next,
+                                                    gf_defrag_entry_t, list);
+                                list_del_init (&entry->list);
+                                defrag->queue_count--;
+                        }
+
+                        /* the crawler waits for room */
+                        waiter = defrag->crawler;
+                        defrag->crawler = NULL;
+                }
+                UNLOCK (&defrag->lock);
+
+                if (waiter)
+                        synctask_wake (waiter);
+
+                if (!entry)
+                        break;
+
+                /* after stop or failure the queue is only drained */
+                if (defrag->defrag_status == GF_DEFRAG_STATUS_STARTED) {
+                        ret = gf_defrag_migrate_entry (this, defrag,
+                                                       &entry->loc);
+                        if (ret)
+                                defrag->defrag_status =
+                                        GF_DEFRAG_STATUS_FAILED;
+                }
+
+                gf_defrag_entry_free (entry);
+        }
+
+        return 0;
+}
+
+
+static int
+gf_defrag_worker_done (int ret, call_frame_t *sync_frame, void *data)
+{
+        xlator_t         *this   = NULL;
+        dht_conf_t       *conf   = NULL;
+        gf_defrag_info_t *defrag = NULL;
+        struct synctask  *waiter = NULL;
+
+        this = data;
+        conf = this->private;
+        defrag = conf->defrag;
+
+        LOCK (&defrag->lock);
+        {
+                defrag->active_workers--;
+                waiter = defrag->crawler;
+                defrag->crawler = NULL;
+        }
+        UNLOCK (&defrag->lock);
+
+        if (waiter)
+                synctask_wake (waiter);
+
+        return 0;
+}
+
+
+static int
+gf_defrag_workers_start (xlator_t *this, gf_defrag_info_t *defrag)
+{
+        struct synctask *crawler = NULL;
+        uint32_t         i       = 0;
+        int              ret     = -1;
+
+        crawler = synctask_get ();
+
+        defrag->idle = GF_CALLOC (defrag->workers, sizeof (*defrag->idle),
+                                  gf_dht_mt_synctask_t);
+        if (!defrag->idle)
+                goto out;
+
+        for (i = 0; i < defrag->workers; i++) {
+                LOCK (&defrag->lock);
+                {
+                        defrag->active_workers++;
+                }
+                UNLOCK (&defrag->lock);
+
+                /* the frame of the crawler, for the pid of rebalance */
+                ret = synctask_new (this->ctx->env, gf_defrag_worker,
+                                    gf_defrag_worker_done, crawler->frame,
+                                    this);
+                if (ret) {
+                        gf_log (this->name, GF_LOG_ERROR, "could not start "
+                                "migration worker %u", i);
+                        LOCK (&defrag->lock);
+                        {
+                                defrag->active_workers--;
+                        }
+                        UNLOCK (&defrag->lock);
+                        break;
+                }
+        }
+
+        gf_log (this->name, GF_LOG_INFO, "started %u migration workers",
+                defrag->active_workers);
+
+        ret = (defrag->active_workers) ? 0 : -1;
+out:
+        return ret;
+}
+
+
+/* let the workers drain the queue and wait for all of them to exit */
+static void
+gf_defrag_workers_stop (gf_defrag_info_t *defrag)
+{
+        struct synctask  *task = NULL;
+        struct synctask **idle = NULL;
+        uint32_t          count = 0;
+        uint32_t          i     = 0;
+
+        task = synctask_get ();
+
+        /* workers see crawl_done and do not park themselves again */
+        LOCK (&defrag->lock);
+        {
+                defrag->crawl_done = _gf_true;
+                idle = defrag->idle;
+                count = defrag->idle_count;
+                defrag->idle_count = 0;
+        }
+        UNLOCK (&defrag->lock);
+
+        for (i = 0; i < count; i++)
+                synctask_wake (idle[i]);
+
+        LOCK (&defrag->lock);
+        {
+                while (defrag->active_workers) {
+                        defrag->crawler = task;
+                        UNLOCK (&defrag->lock);
+                        gf_defrag_task_wait (task);
+                        LOCK (&defrag->lock);
+                }
+        }
+        UNLOCK (&defrag->lock);
+
+        GF_FREE (defrag->idle);
+        defrag->idle = NULL;
+}
+
+
+/* We do a depth first traversal of directories. The files of a directory
+ * whose layout has been fixed are queued for the migration workers before
+ * we move into its subdirs.
  */
 
 int
@@ -1041,23 +1762,17 @@ gf_defrag_migrate_data (xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                         dict_t *migrate_data)
 {
         int                      ret            = -1;
-        loc_t                    entry_loc      = {0,};
+        gf_defrag_entry_t       *defrag_entry   = NULL;
         fd_t                    *fd             = NULL;
         gf_dirent_t              entries;
         gf_dirent_t             *tmp            = NULL;
         gf_dirent_t             *entry          = NULL;
         gf_boolean_t             free_entries   = _gf_false;
         off_t                    offset         = 0;
-        dict_t                  *dict           = NULL;
-        struct iatt              iatt           = {0,};
-        int32_t                  op_errno       = 0;
-        char                    *uuid_str       = NULL;
-        uuid_t                   node_uuid      = {0,};
         int                      readdir_operrno = 0;
         struct timeval           dir_start      = {0,};
         struct timeval           end            = {0,};
         double                   elapsed        = {0,};
-        struct timeval           start          = {0,};
 
         gf_log (this->name, GF_LOG_INFO, "migrate data called on %s",
                 loc->path);
@@ -1107,17 +1822,6 @@ gf_defrag_migrate_data (xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                                 continue;
 
                         defrag->num_files_lookedup++;
-                        if (defrag->stats == _gf_true) {
-                                gettimeofday (&start, NULL);
-                        }
-                        loc_wipe (&entry_loc);
-                        ret =dht_build_child_loc (this, &entry_loc, loc,
-                                                  entry->d_name);
-                        if (ret) {
-                                gf_log (this->name, GF_LOG_ERROR, "Child loc"
-                                        " build failed");
-                                goto out;
-                        }
 
                         if (uuid_is_null (entry->d_stat.ia_gfid)) {
                                 gf_log (this->name, GF_LOG_ERROR, "%s/%s"
@@ -1126,8 +1830,6 @@ gf_defrag_migrate_data (xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                                 continue;
                         }
 
-                        uuid_copy (entry_loc.gfid, entry->d_stat.ia_gfid);
-
                         if (uuid_is_null (loc->gfid)) {
                                 gf_log (this->name, GF_LOG_ERROR, "%s/%s"
                                         " gfid not present", loc->path,
@@ -1135,109 +1837,30 @@ gf_defrag_migrate_data (xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                                 continue;
                         }
 
-                        uuid_copy (entry_loc.pargfid, loc->gfid);
-
-                        entry_loc.inode->ia_type = entry->d_stat.ia_type;
-
-                        ret = syncop_lookup (this, &entry_loc, NULL, &iatt,
-                                             NULL, NULL);
-                        if (ret) {
-                                gf_log (this->name, GF_LOG_ERROR, "%s"
-                                        " lookup failed", entry_loc.path);
-                                continue;
-                        }
-
-                        ret = syncop_getxattr (this, &entry_loc, &dict,
-                                               GF_XATTR_NODE_UUID_KEY);
-                        if(ret < 0) {
-                                gf_log (this->name, GF_LOG_ERROR, "Failed to "
-                                        "get node-uuid for %s", entry_loc.path);
-                                continue;
-                        }
-
-                        ret = dict_get_str (dict, GF_XATTR_NODE_UUID_KEY,
-                                            &uuid_str);
-                        if(ret < 0) {
-                                gf_log (this->name, GF_LOG_ERROR, "Failed to "
-                                        "get node-uuid from dict for %s",
-                                        entry_loc.path);
-                                continue;
-                        }
-
-                        if (uuid_parse (uuid_str, node_uuid)) {
-                                gf_log (this->name, GF_LOG_ERROR, "uuid_parse "
-                                        "failed for %s", entry_loc.path);
-                                continue;
-                        }
-
-                        /* if file belongs to different node, skip migration
-                         * the other node will take responsibility of migration
-                         */
-                        if (uuid_compare (node_uuid, defrag->node_uuid)) {
-                                gf_log (this->name, GF_LOG_TRACE, "%s does not"
-                                        "belong to this node", entry_loc.path);
-                                continue;
-                        }
-
-                        uuid_str = NULL;
-
-                        dict_del (dict, GF_XATTR_NODE_UUID_KEY);
-
-
-                        /* if distribute is present, it will honor this key.
-                         * -1 is returned if distribute is not present or file
-                         * doesn't have a link-file. If file has link-file, the
-                         * path of link-file will be the value, and also that
-                         * guarantees that file has to be mostly migrated */
-
-                        ret = syncop_getxattr (this, &entry_loc, &dict,
-                                               GF_XATTR_LINKINFO_KEY);
-                        if (ret < 0) {
-                                gf_log (this->name, GF_LOG_TRACE, "failed to "
-                                        "get link-to key for %s",
-                                        entry_loc.path);
-                                continue;
+                        defrag_entry = GF_CALLOC (1, sizeof (*defrag_entry),
+                                                  gf_defrag_entry_mt);
+                        if (!defrag_entry) {
+                                ret = -1;
+                                goto out;
                         }
+                        INIT_LIST_HEAD (&defrag_entry->list);
 
-                        ret = syncop_setxattr (this, &entry_loc, migrate_data,
-                                               0);
+                        ret = dht_build_child_loc (this, &defrag_entry->loc,
+                                                   loc, entry->d_name);
                         if (ret) {
-                                gf_log (this->name, GF_LOG_ERROR, "migrate-data"
-                                        " failed for %s", entry_loc.path);
-                                defrag->total_failures +=1;
+                                gf_log (this->name, GF_LOG_ERROR, "Child loc"
+                                        " build failed");
+                                gf_defrag_entry_free (defrag_entry);
+                                goto out;
                         }
 
-                        if (ret == -1) {
-                                op_errno = errno;
-                                ret = gf_defrag_handle_migrate_error (op_errno,
-                                                                      defrag);
-
-                                if (!ret)
-                                        gf_log (this->name, GF_LOG_DEBUG,
-                                                "migrate-data on %s failed: %s",
-                                                entry_loc.path,
-                                                strerror (op_errno));
-                                else if (ret == 1)
-                                        continue;
-                                else if (ret == -1)
-                                        goto out;
-                        }
+                        uuid_copy (defrag_entry->loc.gfid,
+                                   entry->d_stat.ia_gfid);
+                        uuid_copy (defrag_entry->loc.pargfid, loc->gfid);
+                        defrag_entry->loc.inode->ia_type =
+                                entry->d_stat.ia_type;
 
-                        LOCK (&defrag->lock);
-                        {
-                                defrag->total_files += 1;
-                                defrag->total_data += iatt.ia_size;
-                        }
-                        UNLOCK (&defrag->lock);
-                        if (defrag->stats == _gf_true) {
-                                gettimeofday (&end, NULL);
-                                elapsed = (end.tv_sec - start.tv_sec) * 1e6 +
-                                          (end.tv_usec - start.tv_usec);
-                                gf_log (this->name, GF_LOG_INFO, "Migration of "
-                                        "file:%s size:%"PRIu64" bytes took %.2f"
-                                        "secs", entry_loc.path, iatt.ia_size,
-                                         elapsed/1e6);
-                        }
+                        gf_defrag_enqueue (defrag, defrag_entry);
                 }
 
                 gf_dirent_free (&entries);
@@ -1251,18 +1874,13 @@ gf_defrag_migrate_data (xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
         gettimeofday (&end, NULL);
         elapsed = (end.tv_sec - dir_start.tv_sec) * 1e6 +
                   (end.tv_usec - dir_start.tv_usec);
-        gf_log (this->name, GF_LOG_INFO, "Migration operation on dir %s took "
+        gf_log (this->name, GF_LOG_INFO, "Queued the files of dir %s in "
                 "%.2f secs", loc->path, elapsed/1e6);
         ret = 0;
 out:
         if (free_entries)
                 gf_dirent_free (&entries);
 
-        loc_wipe (&entry_loc);
-
-        if (dict)
-                dict_unref(dict);
-
         if (fd)
                 fd_unref (fd);
         return ret;
@@ -1298,6 +1916,8 @@ gf_defrag_fix_layout (xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                         goto out;
         }
 
+        defrag->num_dirs_scanned++;
+
         gf_log (this->name, GF_LOG_TRACE, "fix layout called on %s", loc->path);
 
         fd = fd_create (loc->inode, defrag->pid);
@@ -1499,9 +2119,18 @@ gf_defrag_start_crawl (void *data)
                                             "non-force");
                 if (ret)
                         goto out;
+
+                defrag->migrate_data = migrate_data;
+                ret = gf_defrag_workers_start (this, defrag);
+                if (ret)
+                        goto out;
         }
         ret = gf_defrag_fix_layout (this, defrag, &loc, fix_layout,
                                     migrate_data);
+
+        if (defrag->active_workers)
+                gf_defrag_workers_stop (defrag);
+
         if ((defrag->defrag_status != GF_DEFRAG_STATUS_STOPPED) &&
             (defrag->defrag_status != GF_DEFRAG_STATUS_FAILED)) {
                 defrag->defrag_status = GF_DEFRAG_STATUS_COMPLETE;
@@ -1523,6 +2152,7 @@ out:
         UNLOCK (&defrag->lock);
 
         if (defrag) {
+                GF_FREE (defrag->idle);
                 GF_FREE (defrag);
                 conf->defrag = NULL;
         }
@@ -1587,8 +2217,13 @@ gf_defrag_status_get (gf_defrag_info_t *defrag, dict_t *dict)
         uint64_t size   = 0;
         uint64_t lookup = 0;
         uint64_t failures = 0;
+        uint64_t dirs   = 0;
+        uint64_t queued = 0;
+        uint64_t workers = 0;
         char     *status = "";
         double   elapsed = 0;
+        double   file_rate = 0;
+        double   data_rate = 0;
         struct timeval end = {0,};
 
 
@@ -1603,10 +2238,17 @@ gf_defrag_status_get (gf_defrag_info_t *defrag, dict_t *dict)
         size   = defrag->total_data;
         lookup = defrag->num_files_lookedup;
         failures = defrag->total_failures;
+        dirs   = defrag->num_dirs_scanned;
+        queued = defrag->queue_count;
+        workers = defrag->active_workers;
 
         gettimeofday (&end, NULL);
 
         elapsed = end.tv_sec - defrag->start_time.tv_sec;
+        if (elapsed) {
+                file_rate = files / elapsed;
+                data_rate = size / elapsed;
+        }
 
         if (!dict)
                 goto log;
@@ -1638,6 +2280,31 @@ gf_defrag_status_get (gf_defrag_info_t *defrag, dict_t *dict)
         }
 
         ret = dict_set_uint64 (dict, "failures", failures);
+
+        ret = dict_set_uint64 (dict, "dirs", dirs);
+        if (ret)
+                gf_log (THIS->name, GF_LOG_WARNING,
+                        "failed to set scanned directory count");
+
+        ret = dict_set_uint64 (dict, "queued", queued);
+        if (ret)
+                gf_log (THIS->name, GF_LOG_WARNING,
+                        "failed to set queued file count");
+
+        ret = dict_set_uint64 (dict, "workers", workers);
+        if (ret)
+                gf_log (THIS->name, GF_LOG_WARNING,
+                        "failed to set worker count");
+
+        ret = dict_set_double (dict, "files-per-sec", file_rate);
+        if (ret)
+                gf_log (THIS->name, GF_LOG_WARNING,
+                        "failed to set file rate");
+
+        ret = dict_set_double (dict, "bytes-per-sec", data_rate);
+        if (ret)
+                gf_log (THIS->name, GF_LOG_WARNING,
+                        "failed to set data rate");
 log:
         switch (defrag->defrag_status) {
         case GF_DEFRAG_STATUS_NOT_STARTED:
@@ -1662,6 +2329,10 @@ log:
         gf_log (THIS->name, GF_LOG_INFO, "Files migrated: %"PRIu64", size: %"
                 PRIu64", lookups: %"PRIu64", failures: %"PRIu64, files, size,
                 lookup, failures);
+        gf_log (THIS->name, GF_LOG_INFO, "Directories scanned: %"PRIu64
+                ", queued files: %"PRIu64", workers: %"PRIu64", rate: %.2f "
+                "files/sec, %.2f bytes/sec", dirs, queued, workers,
+                file_rate, data_rate);
 
 
 out:
@@ -827,6 +827,9 @@ dht_rename (call_frame_t *frame, xlator_t *this,
            as the logic of handling rename is different  */
         local->cached_subvol = NULL;
 
+        dht_hint_del (this, oldloc);
+        dht_hint_del (this, newloc);
+
         ret = loc_copy (&local->loc2, newloc);
         if (ret == -1) {
                 op_errno = ENOMEM;
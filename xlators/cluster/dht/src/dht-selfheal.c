@@ -641,11 +641,85 @@ done:
 }
 
 
+/* Like the equal split below, but each of the @cnt subvolumes taking part
+   gets a range in proportion to dht_subvol_weight (). Returns -1, with the
+   layout untouched, while the weight of any of them is not known yet. */
+static int
+dht_selfheal_layout_new_directory_weighted (xlator_t *this, loc_t *loc,
+                                            dht_layout_t *layout, int cnt,
+                                            int start_subvol)
+{
+        uint64_t    *weights = NULL;
+        uint64_t     total = 0;
+        uint64_t     sofar = 0;
+        uint32_t     start = 0;
+        uint32_t     stop = 0;
+        int          picked = 0;
+        int          i = 0;
+        int          k = 0;
+        int          ret = -1;
+
+        weights = GF_CALLOC (layout->cnt, sizeof (*weights),
+                             gf_dht_mt_uint64_t);
+        if (!weights)
+                goto out;
+
+        for (k = 0; (k < layout->cnt) && (picked < cnt); k++) {
+                i = (start_subvol + k) % layout->cnt;
+                if (layout->list[i].err != -1)
+                        continue;
+
+                weights[i] = dht_subvol_weight (this, layout->list[i].xlator);
+                if (!weights[i])
+                        goto out;
+
+                total += weights[i];
+                picked++;
+        }
+
+        if (picked < cnt)
+                goto out;
+
+        picked = 0;
+        for (k = 0; (k < layout->cnt) && (picked < cnt); k++) {
+                i = (start_subvol + k) % layout->cnt;
+                if (!weights[i])
+                        continue;
+
+                sofar += weights[i];
+                if (++picked == cnt)
+                        stop = 0xffffffff;
+                else
+                        stop = (uint32_t) (((double) 0xffffffff) * sofar
+                                           / total);
+                if (stop < start)
+                        stop = start;
+
+                layout->list[i].start = start;
+                layout->list[i].stop  = stop;
+
+                gf_log (this->name, GF_LOG_TRACE,
+                        "gave weighted fix: %u - %u on %s for %s",
+                        start, stop, layout->list[i].xlator->name,
+                        loc->path);
+
+                start = stop + 1;
+        }
+
+        ret = 0;
+out:
+        GF_FREE (weights);
+
+        return ret;
+}
+
+
 void
 dht_selfheal_layout_new_directory (call_frame_t *frame, loc_t *loc,
                                    dht_layout_t *layout)
 {
         xlator_t    *this = NULL;
+        dht_conf_t  *conf = NULL;
         uint32_t     chunk = 0;
         int          i = 0;
         uint32_t     start = 0;
@@ -654,6 +728,7 @@ dht_selfheal_layout_new_directory (call_frame_t *frame, loc_t *loc,
         int          start_subvol = 0;
 
         this = frame->this;
+        conf = this->private;
 
         cnt = dht_get_layout_count (this, layout, 1);
 
@@ -661,6 +736,11 @@ dht_selfheal_layout_new_directory (call_frame_t *frame, loc_t *loc,
 
         start_subvol = dht_selfheal_layout_alloc_start (this, loc, layout);
 
+        if (conf->weighted_rebalance &&
+            !dht_selfheal_layout_new_directory_weighted (this, loc, layout,
+                                                         cnt, start_subvol))
+                goto done;
+
         for (i = start_subvol; i < layout->cnt; i++) {
                 err = layout->list[i].err;
                 if (err == -1) {
@@ -113,6 +113,14 @@ dht_priv_dump (xlator_t *this)
                         gf_proc_dump_write(key, "%d",
                                            (int)conf->subvolume_status[i]);
                 }
+                if (conf->du_stats) {
+                        sprintf (key, "du_stats[%d].total_space", i);
+                        gf_proc_dump_write(key, "%"PRIu64,
+                                           conf->du_stats[i].total_space);
+                        sprintf (key, "du_stats[%d].latency", i);
+                        gf_proc_dump_write(key, "%"PRIu64,
+                                           conf->du_stats[i].latency);
+                }
 
         }
 
@@ -137,6 +145,8 @@ dht_priv_dump (xlator_t *this)
                 gf_proc_dump_write("last_stat_fetch", "%s",
                                     ctime(&conf->last_stat_fetch.tv_sec));
 
+        dht_hints_dump (this, conf);
+
         UNLOCK(&conf->subvolume_lock);
 
 out:
@@ -214,6 +224,8 @@ fini (xlator_t *this)
 
                 GF_FREE (conf->subvolume_status);
 
+                dht_hints_fini (this, conf);
+
                 GF_FREE (conf);
         }
 out:
@@ -286,6 +298,8 @@ reconfigure (xlator_t *this, dict_t *options)
         dht_conf_t      *conf = NULL;
         char            *temp_str = NULL;
         gf_boolean_t     search_unhashed;
+        uint64_t         hint_cache_size = 0;
+        uint32_t         everywhere_max = 0;
         int              ret = -1;
 
         GF_VALIDATE_OR_GOTO ("dht", this, out);
@@ -334,11 +348,27 @@ reconfigure (xlator_t *this, dict_t *options)
 
         GF_OPTION_RECONF ("readdir-optimize", conf->readdir_optimize, options,
                           bool, out);
+        GF_OPTION_RECONF ("rebalance-copy-window", conf->rebal_copy_window,
+                          options, uint32, out);
         if (conf->defrag) {
                 GF_OPTION_RECONF ("rebalance-stats", conf->defrag->stats,
                                   options, bool, out);
+                GF_OPTION_RECONF ("rebalance-rate-limit",
+                                  conf->defrag->rate_limit, options, size,
+                                  out);
         }
 
+        GF_OPTION_RECONF ("weighted-rebalance", conf->weighted_rebalance,
+                          options, bool, out);
+        GF_OPTION_RECONF ("weighted-rebalance-latency",
+                          conf->weighted_rebalance_latency, options, bool, out);
+
+        GF_OPTION_RECONF ("lookup-hint-cache-size", hint_cache_size,
+                          options, size, out);
+        GF_OPTION_RECONF ("lookup-everywhere-limit", everywhere_max,
+                          options, uint32, out);
+        dht_hints_reconf (this, conf, hint_cache_size, everywhere_max);
+
         if (dict_get_str (options, "decommissioned-bricks", &temp_str) == 0) {
                 ret = dht_parse_decommissioned_bricks (this, conf, temp_str);
                 if (ret == -1)
@@ -361,6 +391,8 @@ init (xlator_t *this)
         gf_defrag_info_t                *defrag         = NULL;
         int                              cmd            = 0;
         char                            *node_uuid      = NULL;
+        uint64_t                         hint_cache_size = 0;
+        uint32_t                         everywhere_max = 0;
 
 
         GF_VALIDATE_OR_GOTO ("dht", this, err);
@@ -390,6 +422,7 @@ init (xlator_t *this)
                 GF_VALIDATE_OR_GOTO (this->name, defrag, err);
 
                 LOCK_INIT (&defrag->lock);
+                INIT_LIST_HEAD (&defrag->queue);
 
                 defrag->is_exiting = 0;
 
@@ -442,15 +475,39 @@ init (xlator_t *this)
 
         GF_OPTION_INIT ("readdir-optimize", conf->readdir_optimize, bool, err);
 
+        GF_OPTION_INIT ("rebalance-copy-window", conf->rebal_copy_window,
+                        uint32, err);
+
         if (defrag) {
                 GF_OPTION_INIT ("rebalance-stats", defrag->stats, bool, err);
+                GF_OPTION_INIT ("rebalance-workers", defrag->workers, uint32,
+                                err);
+                GF_OPTION_INIT ("rebalance-queue-size", defrag->queue_size,
+                                uint32, err);
+                GF_OPTION_INIT ("rebalance-rate-limit", defrag->rate_limit,
+                                size, err);
         }
 
+        GF_OPTION_INIT ("weighted-rebalance", conf->weighted_rebalance, bool,
+                        err);
+        GF_OPTION_INIT ("weighted-rebalance-latency",
+                        conf->weighted_rebalance_latency, bool, err);
+
+        GF_OPTION_INIT ("lookup-hint-cache-size", hint_cache_size, size,
+                        err);
+        GF_OPTION_INIT ("lookup-everywhere-limit", everywhere_max, uint32,
+                        err);
+
         /* option can be any one of percent or bytes */
         conf->disk_unit = 0;
         if (conf->min_free_disk < 100)
                 conf->disk_unit = 'p';
 
+        ret = dht_hints_init (this, conf, hint_cache_size, everywhere_max);
+        if (ret == -1) {
+                goto err;
+        }
+
         ret = dht_init_subvolumes (this, conf);
         if (ret == -1) {
                 goto err;
@@ -500,6 +557,8 @@ err:
 
                 GF_FREE (conf->defrag);
 
+                dht_hints_fini (this, conf);
+
                 GF_FREE (conf);
         }
 
@@ -535,6 +594,7 @@ struct xlator_fops fops = {
         .getxattr    = dht_getxattr,
         .fgetxattr    = dht_fgetxattr,
         .readv       = dht_readv,
+        .seek        = dht_seek,
         .flush       = dht_flush,
         .fsync       = dht_fsync,
         .inodelk     = dht_inodelk,
@@ -548,6 +608,9 @@ struct xlator_fops fops = {
         .fsetxattr   = dht_fsetxattr,
         .truncate    = dht_truncate,
         .ftruncate   = dht_ftruncate,
+        .fallocate   = dht_fallocate,
+        .discard     = dht_discard,
+        .zerofill    = dht_zerofill,
         .writev      = dht_writev,
         .xattrop     = dht_xattrop,
         .fxattrop    = dht_fxattrop,
@@ -619,6 +682,65 @@ struct volume_options options[] = {
           .type = GF_OPTION_TYPE_BOOL,
           .default_value = "off",
         },
+        { .key = {"rebalance-workers"},
+          .type = GF_OPTION_TYPE_INT,
+          .min = 1,
+          .max = 64,
+          .default_value = "4",
+          .description = "Number of files migrated in parallel by a "
+                         "rebalance process."
+        },
+        { .key = {"rebalance-queue-size"},
+          .type = GF_OPTION_TYPE_INT,
+          .min = 1,
+          .max = 65536,
+          .default_value = "1024",
+          .description = "Number of files the rebalance crawler may queue "
+                         "ahead of the migration workers."
+        },
+        { .key = {"rebalance-copy-window"},
+          .type = GF_OPTION_TYPE_INT,
+          .min = 1,
+          .max = 16,
+          .default_value = "4",
+          .description = "Number of 128KB reads and writes in flight while "
+                         "the data of a file is migrated."
+        },
+        { .key = {"rebalance-rate-limit"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .default_value = "0",
+          .description = "Bytes per second a rebalance process migrates at "
+                         "most, 0 for no limit."
+        },
+        { .key = {"weighted-rebalance"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Give subvolumes hash ranges in proportion to their "
+                         "size when a directory is created or its layout "
+                         "fixed, instead of equal ranges."
+        },
+        { .key = {"weighted-rebalance-latency"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "With weighted-rebalance, also shrink the ranges of "
+                         "subvolumes which answer slower than the fastest "
+                         "one, down to a quarter of their size share."
+        },
+        { .key = {"lookup-hint-cache-size"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .default_value = "8MB",
+          .description = "Memory used to remember the subvolume of files "
+                         "which are not on their hashed subvolume, so that "
+                         "lookups go there directly. 0 disables it."
+        },
+        { .key = {"lookup-everywhere-limit"},
+          .type = GF_OPTION_TYPE_INT,
+          .min = 0,
+          .max = 65536,
+          .default_value = "64",
+          .description = "Number of lookups sent to all subvolumes which may "
+                         "be in flight at once, 0 for no limit."
+        },
 
         { .key  = {NULL} },
 };
@@ -969,6 +969,9 @@ struct xlator_fops fops = {
         .fstat       = dht_fstat,
         .truncate    = dht_truncate,
         .ftruncate   = dht_ftruncate,
+        .fallocate   = dht_fallocate,
+        .discard     = dht_discard,
+        .zerofill    = dht_zerofill,
         .access      = dht_access,
         .readlink    = dht_readlink,
         .setxattr    = dht_setxattr,
@@ -976,6 +979,7 @@ struct xlator_fops fops = {
         .removexattr = dht_removexattr,
         .open        = dht_open,
         .readv       = dht_readv,
+        .seek        = dht_seek,
         .writev      = dht_writev,
         .flush       = dht_flush,
         .fsync       = dht_fsync,
@@ -24,6 +24,8 @@ enum gf_stripe_mem_types_ {
         gf_stripe_mt_stripe_private_t,
         gf_stripe_mt_stripe_options,
         gf_stripe_mt_xattr_sort_t,
+        gf_stripe_mt_int32_t,
+        gf_stripe_mt_list_head,
         gf_stripe_mt_end
 };
 #endif
@@ -29,6 +29,7 @@
 #include "libxlator.h"
 #include "byte-order.h"
 #include "statedump.h"
+#include "call-stub.h"
 
 struct volume_options options[];
 
@@ -3092,6 +3093,48 @@ err:
 }
 
 
+/* A range of the file spans blocks of every subvolume, and a hole of one
+   says nothing of the others: not supported, the callers of seek read the
+   whole file instead. */
+int32_t
+stripe_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                  int32_t keep_size, off_t offset, size_t len, dict_t *xdata)
+{
+        STRIPE_STACK_UNWIND (fallocate, frame, -1, EOPNOTSUPP, NULL, NULL,
+                             NULL);
+        return 0;
+}
+
+
+int32_t
+stripe_discard (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+                size_t len, dict_t *xdata)
+{
+        STRIPE_STACK_UNWIND (discard, frame, -1, EOPNOTSUPP, NULL, NULL,
+                             NULL);
+        return 0;
+}
+
+
+int32_t
+stripe_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+                 off_t len, dict_t *xdata)
+{
+        STRIPE_STACK_UNWIND (zerofill, frame, -1, EOPNOTSUPP, NULL, NULL,
+                             NULL);
+        return 0;
+}
+
+
+int32_t
+stripe_seek (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+             gf_seek_what_t what, dict_t *xdata)
+{
+        STRIPE_STACK_UNWIND (seek, frame, -1, EOPNOTSUPP, 0, NULL);
+        return 0;
+}
+
+
 int32_t
 stripe_fsyncdir_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                      int32_t op_ret, int32_t op_errno, dict_t *xdata)
@@ -3176,6 +3219,68 @@ err:
 }
 
 
+/*
+ * Read and write RPCs to one subvolume are limited to 'outstanding-rpcs' at
+ * a time. The ones over the limit are queued as call stubs and resumed as
+ * earlier RPCs to the subvolume return.
+ */
+static void
+stripe_rpc_submit (xlator_t *this, int32_t idx, call_stub_t *stub)
+{
+        stripe_private_t *priv = NULL;
+        stripe_local_t   *local = NULL;
+        int               queued = 0;
+
+        priv = this->private;
+        local = stub->frame->local;
+        local->rpc_slot = 1;
+
+        LOCK (&priv->lock);
+        {
+                if (priv->outstanding_rpcs &&
+                    (priv->outstanding[idx] >= priv->outstanding_rpcs)) {
+                        list_add_tail (&stub->list, &priv->rpc_queue[idx]);
+                        queued = 1;
+                } else {
+                        priv->outstanding[idx]++;
+                }
+        }
+        UNLOCK (&priv->lock);
+
+        if (!queued)
+                call_resume (stub);
+}
+
+static void
+stripe_rpc_done (xlator_t *this, stripe_local_t *local)
+{
+        stripe_private_t *priv = NULL;
+        call_stub_t      *stub = NULL;
+        int32_t           idx = 0;
+
+        if (!local->rpc_slot)
+                return;
+
+        priv = this->private;
+        idx = local->subvol;
+        local->rpc_slot = 0;
+
+        LOCK (&priv->lock);
+        {
+                if (!list_empty (&priv->rpc_queue[idx])) {
+                        stub = list_entry (priv->rpc_queue[idx].next,
+                                           call_stub_t, list);
+                        list_del_init (&stub->list);
+                } else {
+                        priv->outstanding[idx]--;
+                }
+        }
+        UNLOCK (&priv->lock);
+
+        if (stub)
+                call_resume (stub);
+}
+
 int32_t
 stripe_readv_fstat_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                         int32_t op_ret, int32_t op_errno, struct iatt *buf, dict_t *xdata)
@@ -3213,14 +3318,14 @@ stripe_readv_fstat_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                 op_ret = 0;
 
                 /* Keep extra space for filling in '\0's */
-                vec = GF_CALLOC ((local->count * 2), sizeof (struct iovec),
-                                 gf_stripe_mt_iovec);
+                vec = GF_CALLOC ((local->count + local->reply_count),
+                                 sizeof (struct iovec), gf_stripe_mt_iovec);
                 if (!vec) {
                         op_ret = -1;
                         goto done;
                 }
 
-                for (i = 0; i < local->wind_count; i++) {
+                for (i = 0; i < local->reply_count; i++) {
                         if (local->replies[i].op_ret) {
                                 memcpy ((vec + count), local->replies[i].vector,
                                         (local->replies[i].count * sizeof (struct iovec)));
@@ -3297,6 +3402,10 @@ stripe_readv_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         struct iobref  *tmp_iobref = NULL;
         stripe_fd_ctx_t  *fctx = NULL;
 	call_frame_t	*prev = NULL;
+        struct stripe_replies *reply = NULL;
+        int32_t         chunk = 0;
+        size_t          pos = 0;
+        size_t          size = 0;
 
         if (!this || !frame || !frame->local || !cookie) {
                 gf_log ("stripe", GF_LOG_DEBUG, "possible NULL deref");
@@ -3316,16 +3425,39 @@ stripe_readv_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 
         fctx = mlocal->fctx;
 
+        stripe_rpc_done (this, local);
+
         LOCK (&mframe->lock);
         {
-                mlocal->replies[index].op_ret = op_ret;
-                mlocal->replies[index].op_errno = op_errno;
-                mlocal->replies[index].requested_size = local->readv_size;
-                if (op_ret >= 0) {
-                        mlocal->replies[index].stbuf  = *stbuf;
-                        mlocal->replies[index].count  = count;
-                        mlocal->replies[index].vector = iov_dup (vector, count);
+                /* The RPC read the blocks index, index + wind_count, ...
+                   of the request back to back, hand every block its part
+                   of the reply */
+                for (chunk = index; chunk < mlocal->reply_count;
+                     chunk += mlocal->wind_count) {
+                        reply = &mlocal->replies[chunk];
+                        reply->op_ret = op_ret;
+                        reply->op_errno = op_errno;
+                        if (op_ret < 0)
+                                continue;
+
+                        size = min ((size_t) reply->requested_size,
+                                   (size_t) op_ret - pos);
+                        reply->op_ret = size;
+                        reply->stbuf  = *stbuf;
+                        reply->count  = iov_subset (vector, count, pos,
+                                                    pos + size, NULL);
+                        reply->vector = GF_CALLOC (reply->count,
+                                                   sizeof (struct iovec),
+                                                   gf_stripe_mt_iovec);
+                        if (reply->vector)
+                                iov_subset (vector, count, pos, pos + size,
+                                            reply->vector);
+                        else
+                                reply->count = 0;
+                        pos += size;
+                }
 
+                if (op_ret >= 0) {
 			correct_file_size(stbuf, fctx, prev);
 
                         if (local->stbuf_size < stbuf->ia_size)
@@ -3343,7 +3475,7 @@ stripe_readv_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         if (callcnt == mlocal->wind_count) {
                 op_ret = 0;
 
-                for (index=0; index < mlocal->wind_count; index++) {
+                for (index=0; index < mlocal->reply_count; index++) {
                         /* check whether each stripe returned
                          * 'expected' number of bytes */
                         if (mlocal->replies[index].op_ret == -1) {
@@ -3374,7 +3506,7 @@ stripe_readv_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                         goto done;
                 }
 
-                for (index = 0; index < mlocal->wind_count; index++) {
+                for (index = 0; index < mlocal->reply_count; index++) {
                         memcpy ((final_vec + final_count),
                                 mlocal->replies[index].vector,
                                 (mlocal->replies[index].count *
@@ -3424,6 +3556,24 @@ end:
 }
 
 
+int32_t
+stripe_readv_wind (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                   size_t size, off_t offset, uint32_t flags, dict_t *xdata)
+{
+        stripe_local_t   *local = NULL;
+        stripe_local_t   *mlocal = NULL;
+        xlator_t         *subvol = NULL;
+
+        local = frame->local;
+        mlocal = local->orig_frame->local;
+        subvol = mlocal->fctx->xl_array[local->subvol];
+
+        STACK_WIND (frame, stripe_readv_cbk, subvol, subvol->fops->readv,
+                    fd, size, offset, flags, xdata);
+
+        return 0;
+}
+
 int32_t
 stripe_readv (call_frame_t *frame, xlator_t *this, fd_t *fd,
               size_t size, off_t offset, uint32_t flags, dict_t *xdata)
@@ -3431,25 +3581,32 @@ stripe_readv (call_frame_t *frame, xlator_t *this, fd_t *fd,
         int32_t           op_errno = EINVAL;
         int32_t           idx = 0;
         int32_t           index = 0;
+        int32_t           chunk = 0;
         int32_t           num_stripe = 0;
-        int32_t           off_index = 0;
+        int32_t           rpc_count = 0;
         size_t            frame_size = 0;
+        size_t            chunk_size = 0;
         off_t             rounded_end = 0;
         uint64_t          tmp_fctx = 0;
         uint64_t          stripe_size = 0;
         off_t             rounded_start = 0;
         off_t             frame_offset = offset;
+        off_t             chunk_offset = 0;
 	off_t		  dest_offset = 0;
         stripe_local_t   *local = NULL;
         call_frame_t     *rframe = NULL;
         stripe_local_t   *rlocal = NULL;
         stripe_fd_ctx_t  *fctx = NULL;
+        stripe_private_t *priv = NULL;
+        call_stub_t      *stub = NULL;
 
         VALIDATE_OR_GOTO (frame, err);
         VALIDATE_OR_GOTO (this, err);
         VALIDATE_OR_GOTO (fd, err);
         VALIDATE_OR_GOTO (fd->inode, err);
 
+        priv = this->private;
+
         inode_ctx_get (fd->inode, this, &tmp_fctx);
         if (!tmp_fctx) {
                 op_errno = EBADFD;
@@ -3474,6 +3631,16 @@ stripe_readv (call_frame_t *frame, xlator_t *this, fd_t *fd,
         rounded_end = roof (offset+size, stripe_size);
         num_stripe = (rounded_end- rounded_start)/stripe_size;
 
+        /* In coalesce mode the blocks of the request that live on one
+         * subvolume are adjacent in its file, so a single read fetches all
+         * of them. Otherwise every block is a read of its own. Either way
+         * RPC 'i' covers the blocks i, i + rpc_count, ...
+         */
+        if (fctx->stripe_coalesce)
+                rpc_count = min (num_stripe, fctx->stripe_count);
+        else
+                rpc_count = num_stripe;
+
         local = mem_get0 (this->local_pool);
         if (!local) {
                 op_errno = ENOMEM;
@@ -3489,14 +3656,14 @@ stripe_readv (call_frame_t *frame, xlator_t *this, fd_t *fd,
                 goto err;
         }
 
-        off_index = (offset / stripe_size) % fctx->stripe_count;
-        local->wind_count = num_stripe;
+        local->wind_count  = rpc_count;
+        local->reply_count = num_stripe;
         local->readv_size = size;
         local->offset     = offset;
         local->fd         = fd_ref (fd);
         local->fctx       = fctx;
 
-        for (index = off_index; index < (num_stripe + off_index); index++) {
+        for (index = 0; index < rpc_count; index++) {
                 rframe = copy_frame (frame);
                 rlocal = mem_get0 (this->local_pool);
                 if (!rlocal) {
@@ -3504,14 +3671,25 @@ stripe_readv (call_frame_t *frame, xlator_t *this, fd_t *fd,
                         goto err;
                 }
 
-                frame_size = min (roof (frame_offset+1, stripe_size),
-                                  (offset + size)) - frame_offset;
+                frame_offset = max (offset, rounded_start +
+                                    (off_t) (index * stripe_size));
+                frame_size = 0;
+                for (chunk = index; chunk < num_stripe; chunk += rpc_count) {
+                        chunk_offset = max (offset, rounded_start +
+                                            (off_t) (chunk * stripe_size));
+                        chunk_size = min (roof (chunk_offset+1, stripe_size),
+                                          (offset + size)) - chunk_offset;
+                        local->replies[chunk].requested_size = chunk_size;
+                        frame_size += chunk_size;
+                }
 
-                rlocal->node_index = index - off_index;
+                idx = ((frame_offset / stripe_size) % fctx->stripe_count);
+
+                rlocal->node_index = index;
+                rlocal->subvol = idx;
                 rlocal->orig_frame = frame;
                 rlocal->readv_size = frame_size;
                 rframe->local = rlocal;
-                idx = (index % fctx->stripe_count);
 
 		if (fctx->stripe_coalesce)
 			dest_offset = coalesced_offset(frame_offset,
@@ -3519,11 +3697,19 @@ stripe_readv (call_frame_t *frame, xlator_t *this, fd_t *fd,
 		else
 			dest_offset = frame_offset;
 
-                STACK_WIND (rframe, stripe_readv_cbk, fctx->xl_array[idx],
-                            fctx->xl_array[idx]->fops->readv,
-                            fd, frame_size, dest_offset, flags, xdata);
-
-                frame_offset += frame_size;
+                if (priv->outstanding_rpcs) {
+                        stub = fop_readv_stub (rframe, stripe_readv_wind, fd,
+                                               frame_size, dest_offset, flags,
+                                               xdata);
+                        if (!stub) {
+                                op_errno = ENOMEM;
+                                goto err;
+                        }
+                        stripe_rpc_submit (this, idx, stub);
+                } else {
+                        stripe_readv_wind (rframe, this, fd, frame_size,
+                                           dest_offset, flags, xdata);
+                }
         }
 
         return 0;
@@ -3548,6 +3734,8 @@ stripe_writev_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 	call_frame_t   *mframe = NULL;
 	struct stripe_replies *reply = NULL;
 	int32_t		i = 0;
+	int32_t		chunk = 0;
+	int32_t		written = 0;
 
         if (!this || !frame || !frame->local || !cookie) {
                 gf_log ("stripe", GF_LOG_DEBUG, "possible NULL deref");
@@ -3559,12 +3747,26 @@ stripe_writev_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 	mframe = local->orig_frame;
 	mlocal = mframe->local;
 
+        stripe_rpc_done (this, local);
+
         LOCK(&frame->lock);
         {
                 callcnt = ++mlocal->call_count;
 
-		mlocal->replies[local->node_index].op_ret = op_ret;
-		mlocal->replies[local->node_index].op_errno = op_errno;
+		/* the RPC wrote the blocks node_index, node_index +
+		   wind_count, ... back to back */
+		written = op_ret;
+		for (chunk = local->node_index; chunk < mlocal->reply_count;
+		     chunk += mlocal->wind_count) {
+			reply = &mlocal->replies[chunk];
+			reply->op_ret = op_ret;
+			reply->op_errno = op_errno;
+			if (op_ret < 0)
+				continue;
+
+			reply->op_ret = min (reply->requested_size, written);
+			written -= reply->op_ret;
+		}
 
                 if (op_ret >= 0) {
                         mlocal->post_buf = *postbuf;
@@ -3598,7 +3800,7 @@ stripe_writev_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 		 * appropriate offset, at which point we'll potentially pass back
 		 * the error.
 		 */
-		for (i = 0, reply = mlocal->replies; i < mlocal->wind_count;
+		for (i = 0, reply = mlocal->replies; i < mlocal->reply_count;
 			i++, reply++) {
 			if (reply->op_ret == -1) {
 				gf_log(this->name, GF_LOG_DEBUG, "reply %d "
@@ -3628,6 +3830,25 @@ out:
         return 0;
 }
 
+int32_t
+stripe_writev_wind (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                    struct iovec *vector, int32_t count, off_t offset,
+                    uint32_t flags, struct iobref *iobref, dict_t *xdata)
+{
+        stripe_local_t   *local = NULL;
+        stripe_local_t   *mlocal = NULL;
+        xlator_t         *subvol = NULL;
+
+        local = frame->local;
+        mlocal = local->orig_frame->local;
+        subvol = mlocal->fctx->xl_array[local->subvol];
+
+        STACK_WIND (frame, stripe_writev_cbk, subvol, subvol->fops->writev,
+                    fd, vector, count, offset, flags, iobref, xdata);
+
+        return 0;
+}
+
 int32_t
 stripe_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
                struct iovec *vector, int32_t count, off_t offset,
@@ -3636,13 +3857,17 @@ stripe_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
         struct iovec     *tmp_vec = NULL;
         stripe_local_t   *local = NULL;
         stripe_fd_ctx_t  *fctx = NULL;
+        stripe_private_t *priv = NULL;
+        call_stub_t      *stub = NULL;
         int32_t           op_errno = 1;
         int32_t           idx = 0;
+        int32_t           index = 0;
+        int32_t           chunk = 0;
+        int32_t           rpc_count = 0;
         int32_t           total_size = 0;
-        int32_t           offset_offset = 0;
-        int32_t           remaining_size = 0;
-        int32_t           tmp_count = count;
-        off_t             fill_size = 0;
+        int32_t           chunk_start = 0;
+        int32_t           chunk_end = 0;
+        int32_t           tmp_count = 0;
         uint64_t          stripe_size = 0;
         uint64_t          tmp_fctx = 0;
 	off_t		  dest_offset = 0;
@@ -3657,6 +3882,8 @@ stripe_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
         VALIDATE_OR_GOTO (fd, err);
         VALIDATE_OR_GOTO (fd->inode, err);
 
+        priv = this->private;
+
         inode_ctx_get (fd->inode, this, &tmp_fctx);
         if (!tmp_fctx) {
                 op_errno = EINVAL;
@@ -3671,7 +3898,6 @@ stripe_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
         for (idx = 0; idx< count; idx ++) {
                 total_size += vector[idx].iov_len;
         }
-        remaining_size = total_size;
 
         local = mem_get0 (this->local_pool);
         if (!local) {
@@ -3699,8 +3925,34 @@ stripe_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
 		goto err;
 	}
 
-	total_chunks = 0;
-        while (1) {
+	/*
+	 * As in readv, coalesced files get one vectored write per subvolume
+	 * holding all of its blocks of the request, other files one write per
+	 * block. RPC 'i' carries the blocks i, i + rpc_count, ...
+	 */
+	if (fctx->stripe_coalesce)
+		rpc_count = min (total_chunks, fctx->stripe_count);
+	else
+		rpc_count = total_chunks;
+
+	/*
+	 * Store off the size of every block of the request. This is required
+	 * in the callback to calculate an appropriate return value in the
+	 * event of a write failure in one or more requests.
+	 */
+	for (chunk = 0; chunk < total_chunks; chunk++) {
+		chunk_start = chunk ? (rounded_start + chunk * stripe_size -
+				       offset) : 0;
+		chunk_end = min (rounded_start + (chunk + 1) * stripe_size -
+				 offset, total_size);
+		local->replies[chunk].requested_size = chunk_end - chunk_start;
+	}
+
+	local->wind_count = rpc_count;
+	local->reply_count = total_chunks;
+	local->unwind = 1;
+
+        for (index = 0; index < rpc_count; index++) {
 		wframe = copy_frame(frame);
 		wlocal = mem_get0(this->local_pool);
 		if (!wlocal) {
@@ -3710,57 +3962,65 @@ stripe_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
 		wlocal->orig_frame = frame;
 		wframe->local = wlocal;
 
-                /* Send striped chunk of the vector to child
-                   nodes appropriately. */
-                idx = (((offset + offset_offset) /
-                        local->stripe_size) % fctx->stripe_count);
-
-                fill_size = (local->stripe_size -
-                             ((offset + offset_offset) % local->stripe_size));
-                if (fill_size > remaining_size)
-                        fill_size = remaining_size;
-
-                remaining_size -= fill_size;
+                tmp_count = 0;
+                for (chunk = index; chunk < total_chunks; chunk += rpc_count) {
+                        chunk_start = chunk ? (rounded_start + chunk *
+                                               stripe_size - offset) : 0;
+                        chunk_end = chunk_start +
+                                local->replies[chunk].requested_size;
+                        tmp_count += iov_subset (vector, count, chunk_start,
+                                                 chunk_end, NULL);
+                }
 
-                tmp_count = iov_subset (vector, count, offset_offset,
-                                        offset_offset + fill_size, NULL);
                 tmp_vec = GF_CALLOC (tmp_count, sizeof (struct iovec),
                                      gf_stripe_mt_iovec);
                 if (!tmp_vec) {
                         op_errno = ENOMEM;
                         goto err;
                 }
-                tmp_count = iov_subset (vector, count, offset_offset,
-                                        offset_offset + fill_size, tmp_vec);
 
-                local->wind_count++;
-                if (remaining_size == 0)
-                        local->unwind = 1;
+                tmp_count = 0;
+                for (chunk = index; chunk < total_chunks; chunk += rpc_count) {
+                        chunk_start = chunk ? (rounded_start + chunk *
+                                               stripe_size - offset) : 0;
+                        chunk_end = chunk_start +
+                                local->replies[chunk].requested_size;
+                        tmp_count += iov_subset (vector, count, chunk_start,
+                                                 chunk_end,
+                                                 tmp_vec + tmp_count);
+                }
 
-		/*
-		 * Store off the request index (with respect to the chunk of the
-		 * initial offset) and the size of the request. This is required
-		 * in the callback to calculate an appropriate return value in
-		 * the event of a write failure in one or more requests.
-		 */
-		wlocal->node_index = total_chunks;
-		local->replies[total_chunks].requested_size = fill_size;
+                /* Send striped chunk of the vector to child
+                   nodes appropriately. */
+                dest_offset = index ? (rounded_start + index * stripe_size) :
+                        offset;
+                idx = ((dest_offset / stripe_size) % fctx->stripe_count);
+
+		wlocal->node_index = index;
+		wlocal->subvol = idx;
 
-		dest_offset = offset + offset_offset;
 		if (fctx->stripe_coalesce)
 			dest_offset = coalesced_offset(dest_offset,
 					local->stripe_size, fctx->stripe_count);
 
-                STACK_WIND (wframe, stripe_writev_cbk, fctx->xl_array[idx],
-                            fctx->xl_array[idx]->fops->writev, fd, tmp_vec,
-                            tmp_count, dest_offset, flags, iobref,
-                            xdata);
+                if (priv->outstanding_rpcs) {
+                        stub = fop_writev_stub (wframe, stripe_writev_wind, fd,
+                                                tmp_vec, tmp_count,
+                                                dest_offset, flags, iobref,
+                                                xdata);
+                        if (!stub) {
+                                GF_FREE (tmp_vec);
+                                op_errno = ENOMEM;
+                                goto err;
+                        }
+                        stripe_rpc_submit (this, idx, stub);
+                } else {
+                        stripe_writev_wind (wframe, this, fd, tmp_vec,
+                                            tmp_count, dest_offset, flags,
+                                            iobref, xdata);
+                }
 
                 GF_FREE (tmp_vec);
-                offset_offset += fill_size;
-		total_chunks++;
-                if (remaining_size == 0)
-                        break;
         }
 
         return 0;
@@ -4421,6 +4681,9 @@ reconfigure (xlator_t *this, dict_t *options)
 
 		GF_OPTION_RECONF("coalesce", priv->coalesce, options, bool,
 				unlock);
+
+                GF_OPTION_RECONF ("outstanding-rpcs", priv->outstanding_rpcs,
+                                  options, int32, unlock);
         }
  unlock:
         UNLOCK (&priv->lock);
@@ -4446,6 +4709,7 @@ init (xlator_t *this)
         xlator_list_t    *trav = NULL;
         data_t           *data = NULL;
         int32_t           count = 0;
+        int32_t           i = 0;
         int               ret = -1;
 
         if (!this)
@@ -4491,6 +4755,19 @@ init (xlator_t *this)
         if (!priv->state)
                 goto out;
 
+        priv->outstanding = GF_CALLOC (count, sizeof (int32_t),
+                                       gf_stripe_mt_int32_t);
+        if (!priv->outstanding)
+                goto out;
+
+        priv->rpc_queue = GF_CALLOC (count, sizeof (struct list_head),
+                                     gf_stripe_mt_list_head);
+        if (!priv->rpc_queue)
+                goto out;
+
+        for (i = 0; i < count; i++)
+                INIT_LIST_HEAD (&priv->rpc_queue[i]);
+
         priv->child_count = count;
         LOCK_INIT (&priv->lock);
 
@@ -4543,6 +4820,9 @@ init (xlator_t *this)
 
 	GF_OPTION_INIT("coalesce", priv->coalesce, bool, out);
 
+        GF_OPTION_INIT ("outstanding-rpcs", priv->outstanding_rpcs, int32,
+                        out);
+
         this->local_pool = mem_pool_new (stripe_local_t, 128);
         if (!this->local_pool) {
                 ret = -1;
@@ -4558,6 +4838,9 @@ out:
         if (ret) {
                 if (priv) {
                         GF_FREE (priv->xl_array);
+                        GF_FREE (priv->state);
+                        GF_FREE (priv->outstanding);
+                        GF_FREE (priv->rpc_queue);
                         GF_FREE (priv);
                 }
         }
@@ -4582,6 +4865,8 @@ fini (xlator_t *this)
         if (priv) {
                 this->private = NULL;
                 GF_FREE (priv->xl_array);
+                GF_FREE (priv->outstanding);
+                GF_FREE (priv->rpc_queue);
 
                 trav = priv->pattern;
                 while (trav) {
@@ -4966,6 +5251,12 @@ stripe_priv_dump (xlator_t *this)
         gf_proc_dump_write ("nodes-down", "%d", priv->nodes_down);
         gf_proc_dump_write ("first-child_down", "%d", priv->first_child_down);
         gf_proc_dump_write ("xattr_supported", "%d", priv->xattr_supported);
+        gf_proc_dump_write ("outstanding-rpcs", "%d", priv->outstanding_rpcs);
+
+        for (i = 0; i < priv->child_count; i++) {
+                sprintf (key, "outstanding[%d]", i);
+                gf_proc_dump_write (key, "%d", priv->outstanding[i]);
+        }
 
         UNLOCK (&priv->lock);
 
@@ -4987,6 +5278,10 @@ struct xlator_fops fops = {
         .flush          = stripe_flush,
         .fsync          = stripe_fsync,
         .ftruncate      = stripe_ftruncate,
+        .fallocate      = stripe_fallocate,
+        .discard        = stripe_discard,
+        .zerofill       = stripe_zerofill,
+        .seek           = stripe_seek,
         .fstat          = stripe_fstat,
         .mkdir          = stripe_mkdir,
         .rmdir          = stripe_rmdir,
@@ -5033,5 +5328,14 @@ struct volume_options options[] = {
 			 "stored on the server (i.e., eliminate holes caused "
 			 "by the traditional format)."
 	},
+        { .key  = {"outstanding-rpcs"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 0,
+          .max  = 1024,
+          .default_value = "0",
+          .description = "Number of read and write RPCs kept in flight to "
+                         "each subvolume, further ones wait in the stripe "
+                         "translator. 0 does not limit them."
+        },
         { .key  = {NULL} },
 };
@@ -103,6 +103,12 @@ struct stripe_private {
         gf_boolean_t            xattr_supported;  /* default yes */
 	gf_boolean_t		coalesce;
         char                    vol_uuid[UUID_SIZE + 1];
+
+        /* readv/writev RPCs in flight per subvolume, the ones over
+           outstanding_rpcs wait in rpc_queue (call stubs) */
+        int32_t                 outstanding_rpcs;
+        int32_t                *outstanding;
+        struct list_head       *rpc_queue;
 };
 
 /**
@@ -170,6 +176,11 @@ struct stripe_local {
         int32_t              call_count;
         int32_t              wind_count; /* used instead of child_cound
                                             in case of read and write */
+        int32_t              reply_count; /* entries in 'replies', one per
+                                             stripe block of the request */
+        int32_t              subvol; /* index of the subvolume a read or
+                                        write RPC goes to */
+        int8_t               rpc_slot; /* holds an outstanding_rpcs slot */
         int32_t              op_ret;
         int32_t              op_errno;
         int32_t              count;
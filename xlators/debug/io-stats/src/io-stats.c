@@ -95,6 +95,9 @@ struct ios_global_stats {
         uint64_t        data_read;
         uint64_t        block_count_write[32];
         uint64_t        block_count_read[32];
+        /* fsyncs by size of the brick batch which synced them */
+        uint64_t        fsync_batch_count[32];
+        uint64_t        fsync_batch_window;  /* usec, summed over those */
         uint64_t        fop_hits[GF_FOP_MAXVALUE];
         struct timeval  started_at;
         struct ios_lat  latency[GF_FOP_MAXVALUE];
@@ -591,6 +594,7 @@ io_stats_dump_global_to_logfp (xlator_t *this, struct ios_global_stats *stats,
         char                  str_header[128] = {0};
         char                  str_read[128] = {0};
         char                  str_write[128] = {0};
+        uint64_t              nr_batched = 0;
 
         conf = this->private;
 
@@ -657,6 +661,52 @@ io_stats_dump_global_to_logfp (xlator_t *this, struct ios_global_stats *stats,
                 ios_log (this, logfp, "%s\n", str_write);
         }
 
+        memset (str_header, 0, sizeof (str_header));
+        memset (str_read, 0, sizeof (str_read));
+        snprintf (str_header, sizeof (str_header), "%-12s %c", "Fsync Batch",
+                  ':');
+        snprintf (str_read, sizeof (str_read), "%-12s %c", "Fsync Count",
+                  ':');
+        index = 14;
+        per_line = 0;
+        for (i = 0; i < 32; i++) {
+                if (stats->fsync_batch_count[i] == 0)
+                        continue;
+                nr_batched += stats->fsync_batch_count[i];
+                per_line++;
+
+                snprintf (str_header+index, sizeof (str_header)-index,
+                          "%17d+", (1<<i));
+                snprintf (str_read+index, sizeof (str_read)-index,
+                          "%18"PRId64, stats->fsync_batch_count[i]);
+
+                index += 18;
+                if (per_line == 3) {
+                        ios_log (this, logfp, "%s", str_header);
+                        ios_log (this, logfp, "%s\n", str_read);
+
+                        memset (str_header, 0, sizeof (str_header));
+                        memset (str_read, 0, sizeof (str_read));
+
+                        snprintf (str_header, sizeof (str_header), "%-12s %c",
+                                  "Fsync Batch", ':');
+                        snprintf (str_read, sizeof (str_read), "%-12s %c",
+                                  "Fsync Count", ':');
+
+                        index = 14;
+                        per_line = 0;
+                }
+        }
+
+        if (per_line != 0) {
+                ios_log (this, logfp, "%s", str_header);
+                ios_log (this, logfp, "%s\n", str_read);
+        }
+
+        if (nr_batched)
+                ios_log (this, logfp, "Avg Fsync Batch Window : %"PRId64
+                         " us\n", stats->fsync_batch_window / nr_batched);
+
         ios_log (this, logfp, "%-13s %10s %14s %14s %14s", "Fop",
                  "Call Count", "Avg-Latency", "Min-Latency",
                  "Max-Latency");
@@ -815,6 +865,33 @@ io_stats_dump_global_to_dict (xlator_t *this, struct ios_global_stats *stats,
                 }
         }
 
+        for (i = 0; i < 32; i++) {
+                if (stats->fsync_batch_count[i]) {
+                        snprintf (key, sizeof (key), "%d-fsync-batch-%d",
+                                  interval, (1<<i));
+                        count = stats->fsync_batch_count[i];
+                        ret = dict_set_uint64 (dict, key, count);
+                        if (ret) {
+                                gf_log (this->name, GF_LOG_ERROR, "failed to "
+                                        "set fsync-batch-%d, with: %"PRId64,
+                                        (1<<i), count);
+                                goto out;
+                        }
+                }
+        }
+
+        if (stats->fsync_batch_window) {
+                snprintf (key, sizeof (key), "%d-fsync-batch-window",
+                          interval);
+                ret = dict_set_uint64 (dict, key, stats->fsync_batch_window);
+                if (ret) {
+                        gf_log (this->name, GF_LOG_ERROR, "failed to set "
+                                "fsync-batch-window, with: %"PRId64,
+                                stats->fsync_batch_window);
+                        goto out;
+                }
+        }
+
         for (i = 0; i < GF_FOP_MAXVALUE; i++) {
                 if (stats->fop_hits[i] == 0)
                         continue;
@@ -1414,6 +1491,26 @@ io_stats_fsync_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                     int32_t op_ret, int32_t op_errno,
                     struct iatt *prebuf, struct iatt *postbuf, dict_t *xdata)
 {
+        struct ios_conf *conf   = NULL;
+        uint32_t         size   = 0;
+        uint32_t         window = 0;
+        int              lb2    = 0;
+
+        conf = this->private;
+        if (conf && xdata &&
+            !dict_get_uint32 (xdata, GLUSTERFS_FSYNC_BATCH_SIZE, &size) &&
+            !dict_get_uint32 (xdata, GLUSTERFS_FSYNC_BATCH_WINDOW, &window)) {
+                lb2 = log_base2 (size);
+                LOCK (&conf->lock);
+                {
+                        conf->cumulative.fsync_batch_count[lb2]++;
+                        conf->incremental.fsync_batch_count[lb2]++;
+                        conf->cumulative.fsync_batch_window += window;
+                        conf->incremental.fsync_batch_window += window;
+                }
+                UNLOCK (&conf->lock);
+        }
+
         UPDATE_PROFILE_STATS (frame, FSYNC);
         STACK_UNWIND_STRICT (fsync, frame, op_ret, op_errno, prebuf, postbuf, xdata);
         return 0;
@@ -1713,6 +1810,54 @@ io_stats_ftruncate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 }
 
 
+int
+io_stats_fallocate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                        int32_t op_ret, int32_t op_errno,
+                        struct iatt *prebuf, struct iatt *postbuf, dict_t *xdata)
+{
+        UPDATE_PROFILE_STATS (frame, FALLOCATE);
+        STACK_UNWIND_STRICT (fallocate, frame, op_ret, op_errno,
+                             prebuf, postbuf, xdata);
+        return 0;
+}
+
+
+int
+io_stats_discard_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                      int32_t op_ret, int32_t op_errno,
+                      struct iatt *prebuf, struct iatt *postbuf, dict_t *xdata)
+{
+        UPDATE_PROFILE_STATS (frame, DISCARD);
+        STACK_UNWIND_STRICT (discard, frame, op_ret, op_errno,
+                             prebuf, postbuf, xdata);
+        return 0;
+}
+
+
+int
+io_stats_zerofill_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                       int32_t op_ret, int32_t op_errno,
+                       struct iatt *prebuf, struct iatt *postbuf, dict_t *xdata)
+{
+        UPDATE_PROFILE_STATS (frame, ZEROFILL);
+        STACK_UNWIND_STRICT (zerofill, frame, op_ret, op_errno,
+                             prebuf, postbuf, xdata);
+        return 0;
+}
+
+
+int
+io_stats_seek_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                   int32_t op_ret, int32_t op_errno,
+                   off_t offset, dict_t *xdata)
+{
+        UPDATE_PROFILE_STATS (frame, SEEK);
+        STACK_UNWIND_STRICT (seek, frame, op_ret, op_errno,
+                             offset, xdata);
+        return 0;
+}
+
+
 int
 io_stats_fstat_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                     int32_t op_ret, int32_t op_errno, struct iatt *buf, dict_t *xdata)
@@ -2364,6 +2509,64 @@ io_stats_ftruncate (call_frame_t *frame, xlator_t *this,
 }
 
 
+int
+io_stats_fallocate (call_frame_t *frame, xlator_t *this,
+                    fd_t *fd, int32_t keep_size, off_t offset, size_t len,
+                    dict_t *xdata)
+{
+        START_FOP_LATENCY (frame);
+
+        STACK_WIND (frame, io_stats_fallocate_cbk,
+                    FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->fallocate,
+                    fd, keep_size, offset, len, xdata);
+        return 0;
+}
+
+
+int
+io_stats_discard (call_frame_t *frame, xlator_t *this,
+                  fd_t *fd, off_t offset, size_t len, dict_t *xdata)
+{
+        START_FOP_LATENCY (frame);
+
+        STACK_WIND (frame, io_stats_discard_cbk,
+                    FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->discard,
+                    fd, offset, len, xdata);
+        return 0;
+}
+
+
+int
+io_stats_zerofill (call_frame_t *frame, xlator_t *this,
+                   fd_t *fd, off_t offset, off_t len, dict_t *xdata)
+{
+        START_FOP_LATENCY (frame);
+
+        STACK_WIND (frame, io_stats_zerofill_cbk,
+                    FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->zerofill,
+                    fd, offset, len, xdata);
+        return 0;
+}
+
+
+int
+io_stats_seek (call_frame_t *frame, xlator_t *this,
+               fd_t *fd, off_t offset, gf_seek_what_t what,
+               dict_t *xdata)
+{
+        START_FOP_LATENCY (frame);
+
+        STACK_WIND (frame, io_stats_seek_cbk,
+                    FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->seek,
+                    fd, offset, what, xdata);
+        return 0;
+}
+
+
 int
 io_stats_fsetattr (call_frame_t *frame, xlator_t *this,
                    fd_t *fd, struct iatt *stbuf, int32_t valid, dict_t *xdata)
@@ -2807,6 +3010,10 @@ struct xlator_fops fops = {
         .fsyncdir    = io_stats_fsyncdir,
         .access      = io_stats_access,
         .ftruncate   = io_stats_ftruncate,
+        .fallocate   = io_stats_fallocate,
+        .discard     = io_stats_discard,
+        .zerofill    = io_stats_zerofill,
+        .seek        = io_stats_seek,
         .fstat       = io_stats_fstat,
         .create      = io_stats_create,
         .lk          = io_stats_lk,
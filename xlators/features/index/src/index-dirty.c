@@ -0,0 +1,547 @@
+/*
+   Copyright (c) 2012 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include <dirent.h>
+
+#include "index.h"
+
+/*
+  Dirty region maps.
+
+  While a file is in the xattrop index (it has pending changelog counts on
+  this brick) every region written to it is recorded in a bitmap kept in
+  <index-base>/dirty/<gfid>, one bit per dirty-region-size bytes. The map
+  is created when the file enters the index and removed when it leaves it,
+  so it covers every write since the replicas last agreed. Self-heal asks
+  the source and the sinks for their maps (getxattr of
+  GF_XATTROP_DIRTY_REGIONS) and only checksums the regions set in one of
+  them.
+
+  A file found in the index without a map (written before tracking was
+  turned on, or the brick went down before the map was created) has no map
+  to offer until it leaves the index again, and gets healed in full.
+*/
+
+#define INDEX_DIRTY_MAGIC       "GFDIRTY1"
+#define INDEX_DIRTY_MAP_OFFSET  64
+
+typedef struct {
+        char     magic[8];
+        uint64_t region_size;
+        uint64_t tail;
+} index_dirty_hdr_t;
+
+static void
+make_dirty_path (index_priv_t *priv, uuid_t gfid, char *path, size_t len)
+{
+        snprintf (path, len, "%s/%s/%s", priv->index_basepath, DIRTY_SUBDIR,
+                  uuid_utoa (gfid));
+}
+
+static void
+__index_dirty_close (index_inode_ctx_t *ctx)
+{
+        if (ctx->dirty_fd >= 0)
+                close (ctx->dirty_fd);
+        ctx->dirty_fd = -1;
+
+        GF_FREE (ctx->dirty_map);
+        ctx->dirty_map = NULL;
+        ctx->dirty_map_size = 0;
+        ctx->dirty_tail = UINT64_MAX;
+}
+
+static void
+__index_dirty_remove (xlator_t *this, uuid_t gfid, index_inode_ctx_t *ctx)
+{
+        char    path[PATH_MAX] = {0};
+
+        __index_dirty_close (ctx);
+
+        make_dirty_path (this->private, gfid, path, sizeof (path));
+        if (unlink (path) && (errno != ENOENT))
+                gf_log (this->name, GF_LOG_WARNING, "%s: failed to remove "
+                        "dirty region map (%s)", path, strerror (errno));
+}
+
+static int
+__index_dirty_write_hdr (index_inode_ctx_t *ctx)
+{
+        index_dirty_hdr_t hdr = {{0},};
+
+        memcpy (hdr.magic, INDEX_DIRTY_MAGIC, sizeof (hdr.magic));
+        hdr.region_size = ctx->dirty_region_size;
+        hdr.tail = ctx->dirty_tail;
+
+        if (pwrite (ctx->dirty_fd, &hdr, sizeof (hdr), 0) != sizeof (hdr))
+                return -1;
+
+        return 0;
+}
+
+/* a map that can't be kept up to date must not survive, or it would be
+   trusted after a restart */
+static void
+__index_dirty_abandon (xlator_t *this, inode_t *inode, index_inode_ctx_t *ctx)
+{
+        gf_log (this->name, GF_LOG_WARNING, "%s: failed to update dirty "
+                "region map (%s), file will be healed in full",
+                uuid_utoa (inode->gfid), strerror (errno));
+
+        __index_dirty_remove (this, inode->gfid, ctx);
+        ctx->dirty_state = DIRTY_UNTRACKED;
+}
+
+static int
+__index_dirty_create (xlator_t *this, inode_t *inode, index_inode_ctx_t *ctx)
+{
+        index_priv_t   *priv = NULL;
+        char            path[PATH_MAX] = {0};
+        int             fd = -1;
+
+        priv = this->private;
+        make_dirty_path (priv, inode->gfid, path, sizeof (path));
+
+        fd = open (path, O_CREAT|O_TRUNC|O_RDWR, 0600);
+        if ((fd < 0) && (errno == ENOENT)) {
+                if (index_dir_create (this, DIRTY_SUBDIR))
+                        goto err;
+                fd = open (path, O_CREAT|O_TRUNC|O_RDWR, 0600);
+        }
+        if (fd < 0)
+                goto err;
+
+        ctx->dirty_fd = fd;
+        ctx->dirty_region_size = priv->dirty_region_size;
+        ctx->dirty_tail = UINT64_MAX;
+        if (__index_dirty_write_hdr (ctx))
+                goto err;
+
+        ctx->dirty_state = DIRTY_TRACKED;
+        return 0;
+err:
+        __index_dirty_abandon (this, inode, ctx);
+        return -1;
+}
+
+static int
+__index_dirty_load (xlator_t *this, inode_t *inode, index_inode_ctx_t *ctx)
+{
+        index_dirty_hdr_t  hdr = {{0},};
+        char               path[PATH_MAX] = {0};
+        struct stat        st = {0,};
+        int                fd = -1;
+
+        make_dirty_path (this->private, inode->gfid, path, sizeof (path));
+
+        fd = open (path, O_RDWR);
+        if (fd < 0)
+                goto err;
+        ctx->dirty_fd = fd;
+
+        if ((pread (fd, &hdr, sizeof (hdr), 0) != sizeof (hdr)) ||
+            memcmp (hdr.magic, INDEX_DIRTY_MAGIC, sizeof (hdr.magic)) ||
+            !hdr.region_size || fstat (fd, &st))
+                goto err;
+
+        ctx->dirty_region_size = hdr.region_size;
+        ctx->dirty_tail = hdr.tail;
+
+        if (st.st_size > INDEX_DIRTY_MAP_OFFSET) {
+                ctx->dirty_map_size = st.st_size - INDEX_DIRTY_MAP_OFFSET;
+                ctx->dirty_map = GF_CALLOC (1, ctx->dirty_map_size,
+                                            gf_index_mt_dirty_map_t);
+                if (!ctx->dirty_map)
+                        goto err;
+                if (pread (fd, ctx->dirty_map, ctx->dirty_map_size,
+                           INDEX_DIRTY_MAP_OFFSET) != ctx->dirty_map_size)
+                        goto err;
+        }
+
+        ctx->dirty_state = DIRTY_TRACKED;
+        return 0;
+err:
+        __index_dirty_close (ctx);
+        return -1;
+}
+
+/* first use of the inode since the brick started: whether the file is in
+   the index is what the index directory says */
+static void
+__index_dirty_resolve (xlator_t *this, inode_t *inode, index_inode_ctx_t *ctx)
+{
+        index_priv_t   *priv = NULL;
+        char            path[PATH_MAX] = {0};
+        struct stat     st = {0,};
+
+        if (ctx->dirty_state != DIRTY_UNKNOWN)
+                return;
+
+        priv = this->private;
+        snprintf (path, sizeof (path), "%s/%s/%s", priv->index_basepath,
+                  XATTROP_SUBDIR, uuid_utoa (inode->gfid));
+
+        if (stat (path, &st)) {
+                __index_dirty_remove (this, inode->gfid, ctx);
+                ctx->dirty_state = DIRTY_CLEAN;
+        } else if (__index_dirty_load (this, inode, ctx)) {
+                ctx->dirty_state = DIRTY_UNTRACKED;
+        }
+}
+
+void
+index_dirty_xattrop (xlator_t *this, inode_t *inode, index_inode_ctx_t *ctx,
+                     gf_boolean_t in_index)
+{
+        index_priv_t   *priv = NULL;
+
+        priv = this->private;
+        if (!priv->dirty_region_size || !IA_ISREG (inode->ia_type))
+                return;
+
+        pthread_mutex_lock (&ctx->dirty_lock);
+        {
+                /* called before the index itself is updated, so this
+                   still finds the state before the xattrop */
+                __index_dirty_resolve (this, inode, ctx);
+
+                if (!in_index) {
+                        if (ctx->dirty_state != DIRTY_CLEAN)
+                                __index_dirty_remove (this, inode->gfid, ctx);
+                        ctx->dirty_state = DIRTY_CLEAN;
+                } else if (ctx->dirty_state == DIRTY_CLEAN) {
+                        __index_dirty_create (this, inode, ctx);
+                }
+        }
+        pthread_mutex_unlock (&ctx->dirty_lock);
+}
+
+static int
+__index_dirty_grow (index_inode_ctx_t *ctx, size_t size)
+{
+        unsigned char  *map = NULL;
+
+        if (size <= ctx->dirty_map_size)
+                return 0;
+
+        map = GF_REALLOC (ctx->dirty_map, size);
+        if (!map)
+                return -1;
+
+        memset (map + ctx->dirty_map_size, 0, size - ctx->dirty_map_size);
+        ctx->dirty_map = map;
+        ctx->dirty_map_size = size;
+
+        return 0;
+}
+
+/* the checks below run in the fop path: they tell, without touching the
+   disk, whether the map needs an update that has to go to the worker */
+static gf_boolean_t
+index_dirty_ctx_get (xlator_t *this, inode_t *inode, index_inode_ctx_t **ctx)
+{
+        index_priv_t   *priv = NULL;
+
+        priv = this->private;
+        if (!priv->dirty_region_size || !IA_ISREG (inode->ia_type))
+                return _gf_false;
+
+        return !index_inode_ctx_get (inode, this, ctx);
+}
+
+gf_boolean_t
+index_dirty_mark_needed (xlator_t *this, inode_t *inode, off_t offset,
+                         size_t len)
+{
+        index_inode_ctx_t   *ctx    = NULL;
+        uint64_t             r      = 0;
+        uint64_t             last   = 0;
+        gf_boolean_t         needed = _gf_false;
+
+        if (!len || !index_dirty_ctx_get (this, inode, &ctx))
+                return _gf_false;
+
+        pthread_mutex_lock (&ctx->dirty_lock);
+        {
+                if (ctx->dirty_state == DIRTY_UNKNOWN) {
+                        needed = _gf_true;
+                } else if (ctx->dirty_state == DIRTY_TRACKED) {
+                        last = (offset + len - 1) / ctx->dirty_region_size;
+                        for (r = offset / ctx->dirty_region_size;
+                             !needed && r <= last; r++)
+                                needed = (r / 8 >= ctx->dirty_map_size) ||
+                                        !(ctx->dirty_map[r / 8] &
+                                          (1 << (r % 8)));
+                }
+        }
+        pthread_mutex_unlock (&ctx->dirty_lock);
+
+        return needed;
+}
+
+gf_boolean_t
+index_dirty_truncate_needed (xlator_t *this, inode_t *inode, off_t offset)
+{
+        index_inode_ctx_t   *ctx    = NULL;
+        gf_boolean_t         needed = _gf_false;
+
+        if (!index_dirty_ctx_get (this, inode, &ctx))
+                return _gf_false;
+
+        pthread_mutex_lock (&ctx->dirty_lock);
+        {
+                needed = (ctx->dirty_state == DIRTY_UNKNOWN) ||
+                         ((ctx->dirty_state == DIRTY_TRACKED) &&
+                          (offset < ctx->dirty_tail));
+        }
+        pthread_mutex_unlock (&ctx->dirty_lock);
+
+        return needed;
+}
+
+gf_boolean_t
+index_dirty_sync_needed (xlator_t *this, inode_t *inode)
+{
+        index_inode_ctx_t   *ctx    = NULL;
+        gf_boolean_t         needed = _gf_false;
+
+        if (!index_dirty_ctx_get (this, inode, &ctx))
+                return _gf_false;
+
+        pthread_mutex_lock (&ctx->dirty_lock);
+        {
+                needed = (ctx->dirty_state == DIRTY_TRACKED);
+        }
+        pthread_mutex_unlock (&ctx->dirty_lock);
+
+        return needed;
+}
+
+void
+index_dirty_mark (xlator_t *this, inode_t *inode, off_t offset, size_t len)
+{
+        index_priv_t        *priv  = NULL;
+        index_inode_ctx_t   *ctx   = NULL;
+        uint64_t             first = 0;
+        uint64_t             last  = 0;
+        uint64_t             r     = 0;
+        size_t               lo    = SIZE_MAX;
+        size_t               hi    = 0;
+
+        priv = this->private;
+        if (!priv->dirty_region_size || !len)
+                return;
+
+        if (index_inode_ctx_get (inode, this, &ctx))
+                return;
+
+        pthread_mutex_lock (&ctx->dirty_lock);
+        {
+                __index_dirty_resolve (this, inode, ctx);
+                if (ctx->dirty_state != DIRTY_TRACKED)
+                        goto unlock;
+
+                first = offset / ctx->dirty_region_size;
+                last = (offset + len - 1) / ctx->dirty_region_size;
+
+                if (__index_dirty_grow (ctx, last / 8 + 1)) {
+                        errno = ENOMEM;
+                        __index_dirty_abandon (this, inode, ctx);
+                        goto unlock;
+                }
+
+                for (r = first; r <= last; r++) {
+                        if (ctx->dirty_map[r / 8] & (1 << (r % 8)))
+                                continue;
+                        ctx->dirty_map[r / 8] |= (1 << (r % 8));
+                        if (r / 8 < lo)
+                                lo = r / 8;
+                        hi = r / 8;
+                }
+
+                /* only newly dirty regions cost a write, and the map is
+                   on disk before the data is */
+                if ((lo <= hi) &&
+                    (pwrite (ctx->dirty_fd, ctx->dirty_map + lo, hi - lo + 1,
+                             INDEX_DIRTY_MAP_OFFSET + lo) != hi - lo + 1))
+                        __index_dirty_abandon (this, inode, ctx);
+        }
+unlock:
+        pthread_mutex_unlock (&ctx->dirty_lock);
+}
+
+void
+index_dirty_truncate (xlator_t *this, inode_t *inode, off_t offset)
+{
+        index_priv_t        *priv  = NULL;
+        index_inode_ctx_t   *ctx   = NULL;
+
+        priv = this->private;
+        if (!priv->dirty_region_size)
+                return;
+
+        if (index_inode_ctx_get (inode, this, &ctx))
+                return;
+
+        pthread_mutex_lock (&ctx->dirty_lock);
+        {
+                __index_dirty_resolve (this, inode, ctx);
+                if ((ctx->dirty_state != DIRTY_TRACKED) ||
+                    (offset >= ctx->dirty_tail))
+                        goto unlock;
+
+                ctx->dirty_tail = offset;
+                if (__index_dirty_write_hdr (ctx))
+                        __index_dirty_abandon (this, inode, ctx);
+        }
+unlock:
+        pthread_mutex_unlock (&ctx->dirty_lock);
+}
+
+/* data the application asked to be stable must not be there without the
+   map that says it was written */
+void
+index_dirty_sync (xlator_t *this, inode_t *inode)
+{
+        index_priv_t        *priv  = NULL;
+        index_inode_ctx_t   *ctx   = NULL;
+
+        priv = this->private;
+        if (!priv->dirty_region_size)
+                return;
+
+        if (index_inode_ctx_get (inode, this, &ctx))
+                return;
+
+        pthread_mutex_lock (&ctx->dirty_lock);
+        {
+                if ((ctx->dirty_state == DIRTY_TRACKED) &&
+                    fdatasync (ctx->dirty_fd))
+                        __index_dirty_abandon (this, inode, ctx);
+        }
+        pthread_mutex_unlock (&ctx->dirty_lock);
+}
+
+/* GF_XATTROP_DIRTY_REGIONS: region size and tail as 64 bit big endian,
+   then the bitmap. A file out of the index has region size 0 and no map:
+   nothing was written to it here while it needed heal, but nothing was
+   tracked either. */
+int
+index_dirty_get (xlator_t *this, inode_t *inode, dict_t *xattr)
+{
+        index_priv_t        *priv  = NULL;
+        index_inode_ctx_t   *ctx   = NULL;
+        uint64_t            *blob  = NULL;
+        size_t               size  = 0;
+        int                  ret   = -ENODATA;
+
+        priv = this->private;
+        if (!priv->dirty_region_size)
+                goto out;
+
+        if (index_inode_ctx_get (inode, this, &ctx)) {
+                ret = -ENOMEM;
+                goto out;
+        }
+
+        pthread_mutex_lock (&ctx->dirty_lock);
+        {
+                __index_dirty_resolve (this, inode, ctx);
+                if (ctx->dirty_state == DIRTY_CLEAN) {
+                        size = 2 * sizeof (uint64_t);
+                        blob = GF_CALLOC (1, size, gf_index_mt_dirty_map_t);
+                        if (!blob)
+                                goto unlock;
+                        blob[0] = 0;
+                        blob[1] = hton64 (UINT64_MAX);
+                } else if (ctx->dirty_state == DIRTY_TRACKED) {
+                        size = 2 * sizeof (uint64_t) + ctx->dirty_map_size;
+                        blob = GF_CALLOC (1, size, gf_index_mt_dirty_map_t);
+                        if (!blob)
+                                goto unlock;
+                        blob[0] = hton64 (ctx->dirty_region_size);
+                        blob[1] = hton64 (ctx->dirty_tail);
+                        if (ctx->dirty_map_size)
+                                memcpy (blob + 2, ctx->dirty_map,
+                                        ctx->dirty_map_size);
+                }
+        }
+unlock:
+        pthread_mutex_unlock (&ctx->dirty_lock);
+
+        if (!blob) {
+                if (size)
+                        ret = -ENOMEM;
+                goto out;
+        }
+
+        ret = dict_set_bin (xattr, GF_XATTROP_DIRTY_REGIONS, blob, size);
+        if (ret) {
+                GF_FREE (blob);
+                goto out;
+        }
+        ret = 0;
+out:
+        return ret;
+}
+
+/* stale index entry of a file that is gone */
+void
+index_dirty_unlink (xlator_t *this, uuid_t gfid)
+{
+        char    path[PATH_MAX] = {0};
+
+        make_dirty_path (this->private, gfid, path, sizeof (path));
+        unlink (path);
+}
+
+void
+index_dirty_ctx_destroy (index_inode_ctx_t *ctx)
+{
+        __index_dirty_close (ctx);
+        pthread_mutex_destroy (&ctx->dirty_lock);
+}
+
+/* with tracking off, maps stop being updated; drop them so that none is
+   trusted once tracking is turned back on */
+int
+index_dirty_init (xlator_t *this)
+{
+        index_priv_t   *priv = NULL;
+        char            dir[PATH_MAX] = {0};
+        char            path[PATH_MAX] = {0};
+        DIR            *dirp = NULL;
+        struct dirent  *entry = NULL;
+
+        priv = this->private;
+        if (priv->dirty_region_size)
+                return 0;
+
+        snprintf (dir, sizeof (dir), "%s/%s", priv->index_basepath,
+                  DIRTY_SUBDIR);
+        dirp = opendir (dir);
+        if (!dirp)
+                return 0;
+
+        while ((entry = readdir (dirp))) {
+                if (!strcmp (entry->d_name, ".") ||
+                    !strcmp (entry->d_name, ".."))
+                        continue;
+                snprintf (path, sizeof (path), "%s/%s", dir, entry->d_name);
+                unlink (path);
+        }
+        closedir (dirp);
+
+        return 0;
+}
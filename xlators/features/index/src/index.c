@@ -16,8 +16,6 @@
 #include "options.h"
 #include "glusterfs3-xdr.h"
 
-#define XATTROP_SUBDIR "xattrop"
-
 call_stub_t *
 __index_dequeue (struct list_head *callstubs)
 {
@@ -100,8 +98,12 @@ __index_inode_ctx_get (inode_t *inode, xlator_t *this, index_inode_ctx_t **ctx)
         }
 
         INIT_LIST_HEAD (&ictx->callstubs);
+        pthread_mutex_init (&ictx->dirty_lock, NULL);
+        ictx->dirty_fd = -1;
+        ictx->dirty_tail = UINT64_MAX;
         ret = __inode_ctx_put (inode, this, (uint64_t)ictx);
         if (ret) {
+                index_dirty_ctx_destroy (ictx);
                 GF_FREE (ictx);
                 ictx = NULL;
                 goto out;
@@ -456,6 +458,9 @@ _xattrop_index_action (xlator_t *this, inode_t *inode,  dict_t *xattr)
                         zero_xattr?"add":"del", uuid_utoa (inode->gfid));
                 goto out;
         }
+
+        index_dirty_xattrop (this, inode, ctx, !zero_xattr);
+
         if (zero_xattr) {
                 if (ctx->state == NOTIN)
                         goto out;
@@ -753,6 +758,113 @@ done:
         return 0;
 }
 
+int32_t
+index_dirty_getxattr_wrapper (call_frame_t *frame, xlator_t *this,
+                              loc_t *loc, const char *name, dict_t *xdata)
+{
+        dict_t          *xattr = NULL;
+        int             ret = 0;
+
+        xattr = dict_new ();
+        if (!xattr) {
+                ret = -ENOMEM;
+                goto done;
+        }
+
+        ret = index_dirty_get (this, loc->inode, xattr);
+done:
+        if (ret)
+                STACK_UNWIND_STRICT (getxattr, frame, -1, -ret, NULL, xdata);
+        else
+                STACK_UNWIND_STRICT (getxattr, frame, 0, 0, xattr, xdata);
+
+        if (xattr)
+                dict_unref (xattr);
+
+        return 0;
+}
+
+int32_t
+index_writev_wrapper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                      struct iovec *vector, int32_t count, off_t off,
+                      uint32_t flags, struct iobref *iobref, dict_t *xdata)
+{
+        index_dirty_mark (this, fd->inode, off, iov_length (vector, count));
+
+        STACK_WIND (frame, default_writev_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->writev, fd, vector, count, off,
+                    flags, iobref, xdata);
+        return 0;
+}
+
+int32_t
+index_truncate_wrapper (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                        off_t offset, dict_t *xdata)
+{
+        index_dirty_truncate (this, loc->inode, offset);
+
+        STACK_WIND (frame, default_truncate_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->truncate, loc, offset, xdata);
+        return 0;
+}
+
+int32_t
+index_ftruncate_wrapper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                         off_t offset, dict_t *xdata)
+{
+        index_dirty_truncate (this, fd->inode, offset);
+
+        STACK_WIND (frame, default_ftruncate_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->ftruncate, fd, offset, xdata);
+        return 0;
+}
+
+int32_t
+index_fallocate_wrapper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                         int32_t keep_size, off_t offset, size_t len,
+                         dict_t *xdata)
+{
+        index_dirty_mark (this, fd->inode, offset, len);
+
+        STACK_WIND (frame, default_fallocate_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->fallocate, fd, keep_size, offset,
+                    len, xdata);
+        return 0;
+}
+
+int32_t
+index_discard_wrapper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                       off_t offset, size_t len, dict_t *xdata)
+{
+        index_dirty_mark (this, fd->inode, offset, len);
+
+        STACK_WIND (frame, default_discard_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->discard, fd, offset, len, xdata);
+        return 0;
+}
+
+int32_t
+index_zerofill_wrapper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                        off_t offset, off_t len, dict_t *xdata)
+{
+        index_dirty_mark (this, fd->inode, offset, len);
+
+        STACK_WIND (frame, default_zerofill_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->zerofill, fd, offset, len, xdata);
+        return 0;
+}
+
+int32_t
+index_fsync_wrapper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                     int32_t datasync, dict_t *xdata)
+{
+        index_dirty_sync (this, fd->inode);
+
+        STACK_WIND (frame, default_fsync_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->fsync, fd, datasync, xdata);
+        return 0;
+}
+
 int32_t
 index_lookup_wrapper (call_frame_t *frame, xlator_t *this,
                       loc_t *loc, dict_t *xattr_req)
@@ -889,6 +1001,7 @@ index_unlink_wrapper (call_frame_t *frame, xlator_t *this, loc_t *loc, int flag,
                 op_errno = -ret;
                 goto done;
         }
+        index_dirty_unlink (this, gfid);
         memset (&lstatbuf, 0, sizeof (lstatbuf));
         ret = lstat (index_dir, &lstatbuf);
         if (ret < 0) {
@@ -911,11 +1024,18 @@ index_getxattr (call_frame_t *frame, xlator_t *this,
 {
         call_stub_t     *stub = NULL;
 
+        if (name && !strcmp (GF_XATTROP_DIRTY_REGIONS, name)) {
+                stub = fop_getxattr_stub (frame, index_dirty_getxattr_wrapper,
+                                          loc, name, xdata);
+                goto enqueue;
+        }
+
         if (!name || strcmp (GF_XATTROP_INDEX_GFID, name))
                 goto out;
 
         stub = fop_getxattr_stub (frame, index_getxattr_wrapper, loc, name,
                                   xdata);
+enqueue:
         if (!stub) {
                 STACK_UNWIND_STRICT (getxattr, frame, -1, ENOMEM, NULL, NULL);
                 return 0;
@@ -1005,6 +1125,181 @@ out:
         return 0;
 }
 
+/* writes, truncates, fsyncs and the fops changing a range of the data that
+   have to update a dirty region map are passed on by the worker once the map
+   is on disk */
+int32_t
+index_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
+              struct iovec *vector, int32_t count, off_t off, uint32_t flags,
+              struct iobref *iobref, dict_t *xdata)
+{
+        call_stub_t     *stub = NULL;
+
+        if (!index_dirty_mark_needed (this, fd->inode, off,
+                                      iov_length (vector, count)))
+                goto out;
+
+        stub = fop_writev_stub (frame, index_writev_wrapper, fd, vector,
+                                count, off, flags, iobref, xdata);
+        if (!stub) {
+                STACK_UNWIND_STRICT (writev, frame, -1, ENOMEM, NULL, NULL,
+                                     NULL);
+                return 0;
+        }
+        worker_enqueue (this, stub);
+        return 0;
+out:
+        STACK_WIND (frame, default_writev_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->writev, fd, vector, count, off,
+                    flags, iobref, xdata);
+        return 0;
+}
+
+int32_t
+index_truncate (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                off_t offset, dict_t *xdata)
+{
+        call_stub_t     *stub = NULL;
+
+        if (!index_dirty_truncate_needed (this, loc->inode, offset))
+                goto out;
+
+        stub = fop_truncate_stub (frame, index_truncate_wrapper, loc, offset,
+                                  xdata);
+        if (!stub) {
+                STACK_UNWIND_STRICT (truncate, frame, -1, ENOMEM, NULL, NULL,
+                                     NULL);
+                return 0;
+        }
+        worker_enqueue (this, stub);
+        return 0;
+out:
+        STACK_WIND (frame, default_truncate_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->truncate, loc, offset, xdata);
+        return 0;
+}
+
+int32_t
+index_ftruncate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                 off_t offset, dict_t *xdata)
+{
+        call_stub_t     *stub = NULL;
+
+        if (!index_dirty_truncate_needed (this, fd->inode, offset))
+                goto out;
+
+        stub = fop_ftruncate_stub (frame, index_ftruncate_wrapper, fd, offset,
+                                   xdata);
+        if (!stub) {
+                STACK_UNWIND_STRICT (ftruncate, frame, -1, ENOMEM, NULL, NULL,
+                                     NULL);
+                return 0;
+        }
+        worker_enqueue (this, stub);
+        return 0;
+out:
+        STACK_WIND (frame, default_ftruncate_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->ftruncate, fd, offset, xdata);
+        return 0;
+}
+
+int32_t
+index_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                 int32_t keep_size, off_t offset, size_t len, dict_t *xdata)
+{
+        call_stub_t     *stub = NULL;
+
+        if (!index_dirty_mark_needed (this, fd->inode, offset, len))
+                goto out;
+
+        stub = fop_fallocate_stub (frame, index_fallocate_wrapper, fd,
+                                   keep_size, offset, len, xdata);
+        if (!stub) {
+                STACK_UNWIND_STRICT (fallocate, frame, -1, ENOMEM, NULL, NULL,
+                                     NULL);
+                return 0;
+        }
+        worker_enqueue (this, stub);
+        return 0;
+out:
+        STACK_WIND (frame, default_fallocate_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->fallocate, fd, keep_size, offset,
+                    len, xdata);
+        return 0;
+}
+
+int32_t
+index_discard (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+               size_t len, dict_t *xdata)
+{
+        call_stub_t     *stub = NULL;
+
+        if (!index_dirty_mark_needed (this, fd->inode, offset, len))
+                goto out;
+
+        stub = fop_discard_stub (frame, index_discard_wrapper, fd, offset, len,
+                                 xdata);
+        if (!stub) {
+                STACK_UNWIND_STRICT (discard, frame, -1, ENOMEM, NULL, NULL,
+                                     NULL);
+                return 0;
+        }
+        worker_enqueue (this, stub);
+        return 0;
+out:
+        STACK_WIND (frame, default_discard_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->discard, fd, offset, len, xdata);
+        return 0;
+}
+
+int32_t
+index_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+                off_t len, dict_t *xdata)
+{
+        call_stub_t     *stub = NULL;
+
+        if (!index_dirty_mark_needed (this, fd->inode, offset, len))
+                goto out;
+
+        stub = fop_zerofill_stub (frame, index_zerofill_wrapper, fd, offset,
+                                  len, xdata);
+        if (!stub) {
+                STACK_UNWIND_STRICT (zerofill, frame, -1, ENOMEM, NULL, NULL,
+                                     NULL);
+                return 0;
+        }
+        worker_enqueue (this, stub);
+        return 0;
+out:
+        STACK_WIND (frame, default_zerofill_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->zerofill, fd, offset, len, xdata);
+        return 0;
+}
+
+int32_t
+index_fsync (call_frame_t *frame, xlator_t *this, fd_t *fd,
+             int32_t datasync, dict_t *xdata)
+{
+        call_stub_t     *stub = NULL;
+
+        if (!index_dirty_sync_needed (this, fd->inode))
+                goto out;
+
+        stub = fop_fsync_stub (frame, index_fsync_wrapper, fd, datasync,
+                               xdata);
+        if (!stub) {
+                STACK_UNWIND_STRICT (fsync, frame, -1, ENOMEM, NULL, NULL,
+                                     NULL);
+                return 0;
+        }
+        worker_enqueue (this, stub);
+        return 0;
+out:
+        STACK_WIND (frame, default_fsync_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->fsync, fd, datasync, xdata);
+        return 0;
+}
+
 int32_t
 mem_acct_init (xlator_t *this)
 {
@@ -1069,6 +1364,9 @@ init (xlator_t *this)
                         "Using default thread stack size");
         }
         GF_OPTION_INIT ("index-base", priv->index_basepath, path, out);
+        GF_OPTION_INIT ("dirty-region-size", priv->dirty_region_size, size,
+                        out);
+        index_dirty_init (this);
         uuid_generate (priv->index);
         uuid_generate (priv->xattrop_vgfid);
         INIT_LIST_HEAD (&priv->callstubs);
@@ -1117,8 +1415,10 @@ int
 index_forget (xlator_t *this, inode_t *inode)
 {
         uint64_t tmp_cache = 0;
-        if (!inode_ctx_del (inode, this, &tmp_cache))
+        if (!inode_ctx_del (inode, this, &tmp_cache)) {
+                index_dirty_ctx_destroy ((index_inode_ctx_t*) (long)tmp_cache);
                 GF_FREE ((index_inode_ctx_t*) (long)tmp_cache);
+        }
 
         return 0;
 }
@@ -1164,6 +1464,16 @@ int
 notify (xlator_t *this, int event, void *data, ...)
 {
         int     ret = 0;
+
+        /* a copy the scrubber found corrupted is healed like one with
+           pending changelog */
+        if (event == GF_EVENT_SCRUB_BAD && data) {
+                if (index_add (this, data, XATTROP_SUBDIR))
+                        gf_log (this->name, GF_LOG_WARNING, "adding %s to "
+                                "the xattrop index failed",
+                                uuid_utoa (data));
+        }
+
         ret = default_notify (this, event, data);
         return ret;
 }
@@ -1171,6 +1481,13 @@ notify (xlator_t *this, int event, void *data, ...)
 struct xlator_fops fops = {
 	.xattrop     = index_xattrop,
 	.fxattrop    = index_fxattrop,
+        .writev      = index_writev,
+        .truncate    = index_truncate,
+        .ftruncate   = index_ftruncate,
+        .fallocate   = index_fallocate,
+        .discard     = index_discard,
+        .zerofill    = index_zerofill,
+        .fsync       = index_fsync,
 
         //interface functions follow
         .getxattr    = index_getxattr,
@@ -1193,5 +1510,14 @@ struct volume_options options[] = {
           .type = GF_OPTION_TYPE_PATH,
           .description = "path where the index files need to be stored",
         },
+        { .key  = {"dirty-region-size" },
+          .type = GF_OPTION_TYPE_SIZET,
+          .min  = 0,
+          .max  = 1 * GF_UNIT_GB,
+          .default_value = "1MB",
+          .description = "Granularity of the maps of regions written to "
+                         "files that need self-heal, which let self-heal "
+                         "skip the rest of the file. 0 turns them off.",
+        },
         { .key  = {NULL} },
 };
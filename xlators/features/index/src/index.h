@@ -20,16 +20,35 @@
 
 #define INDEX_THREAD_STACK_SIZE   ((size_t)(1024*1024))
 
+#define XATTROP_SUBDIR "xattrop"
+#define DIRTY_SUBDIR   "dirty"
+
 typedef enum {
         UNKNOWN,
         IN,
         NOTIN
 } index_state_t;
 
+typedef enum {
+        DIRTY_UNKNOWN,          /* not looked at since the brick started */
+        DIRTY_CLEAN,            /* not in the index, nothing to track */
+        DIRTY_TRACKED,          /* in the index, map covers every write */
+        DIRTY_UNTRACKED,        /* in the index, no usable map */
+} index_dirty_state_t;
+
 typedef struct index_inode_ctx {
         gf_boolean_t processing;
         struct list_head callstubs;
         index_state_t state;
+
+        pthread_mutex_t      dirty_lock;
+        index_dirty_state_t  dirty_state;
+        int                  dirty_fd;
+        uint64_t             dirty_region_size;
+        uint64_t             dirty_tail;  /* everything from here on is
+                                             dirty (truncate) */
+        unsigned char       *dirty_map;
+        size_t               dirty_map_size;
 } index_inode_ctx_t;
 
 typedef struct index_fd_ctx {
@@ -44,6 +63,7 @@ typedef struct index_priv {
         struct list_head callstubs;
         pthread_mutex_t mutex;
         pthread_cond_t  cond;
+        uint64_t dirty_region_size;  /* 0 when dirty regions aren't tracked */
 } index_priv_t;
 
 #define INDEX_STACK_UNWIND(fop, frame, params ...)      \
@@ -56,4 +76,45 @@ do {                                                    \
         STACK_UNWIND_STRICT (fop, frame, params);       \
 } while (0)
 
+int
+index_inode_ctx_get (inode_t *inode, xlator_t *this, index_inode_ctx_t **ctx);
+
+int
+index_dir_create (xlator_t *this, const char *subdir);
+
+void
+index_dirty_xattrop (xlator_t *this, inode_t *inode, index_inode_ctx_t *ctx,
+                     gf_boolean_t in_index);
+
+gf_boolean_t
+index_dirty_mark_needed (xlator_t *this, inode_t *inode, off_t offset,
+                         size_t len);
+
+gf_boolean_t
+index_dirty_truncate_needed (xlator_t *this, inode_t *inode, off_t offset);
+
+gf_boolean_t
+index_dirty_sync_needed (xlator_t *this, inode_t *inode);
+
+void
+index_dirty_mark (xlator_t *this, inode_t *inode, off_t offset, size_t len);
+
+void
+index_dirty_truncate (xlator_t *this, inode_t *inode, off_t offset);
+
+void
+index_dirty_sync (xlator_t *this, inode_t *inode);
+
+int
+index_dirty_get (xlator_t *this, inode_t *inode, dict_t *xattr);
+
+void
+index_dirty_unlink (xlator_t *this, uuid_t gfid);
+
+void
+index_dirty_ctx_destroy (index_inode_ctx_t *ctx);
+
+int
+index_dirty_init (xlator_t *this);
+
 #endif
@@ -81,6 +81,9 @@ int32_t
 __get_inodelk_count (xlator_t *this, pl_inode_t *pl_inode);
 int32_t
 get_inodelk_count (xlator_t *this, inode_t *inode);
+int32_t
+get_inodelk_contention (xlator_t *this, inode_t *inode, const char *volume,
+                        void *transport);
 
 int32_t
 __get_entrylk_count (xlator_t *this, pl_inode_t *pl_inode);
@@ -728,3 +728,47 @@ get_inodelk_count (xlator_t *this, inode_t *inode)
 out:
         return count;
 }
+
+/* Number of inodelks in @volume held or waited for by clients other than
+   the one behind @transport. Lets a client holding a lock for longer than
+   one fop see that somebody else needs it. */
+int32_t
+get_inodelk_contention (xlator_t *this, inode_t *inode, const char *volume,
+                        void *transport)
+{
+        pl_inode_t        *pl_inode     = NULL;
+        pl_dom_list_t     *dom          = NULL;
+        pl_inode_lock_t   *lock         = NULL;
+        uint64_t           tmp_pl_inode = 0;
+        int                ret          = 0;
+        int32_t            count        = 0;
+
+        ret = inode_ctx_get (inode, this, &tmp_pl_inode);
+        if (ret != 0) {
+                goto out;
+        }
+
+        pl_inode = (pl_inode_t *)(long) tmp_pl_inode;
+
+        pthread_mutex_lock (&pl_inode->mutex);
+        {
+                list_for_each_entry (dom, &pl_inode->dom_list, inode_list) {
+                        if (strcmp (dom->domain, volume) != 0)
+                                continue;
+
+                        list_for_each_entry (lock, &dom->inodelk_list, list) {
+                                if (lock->transport != transport)
+                                        count++;
+                        }
+                        list_for_each_entry (lock, &dom->blocked_inodelks,
+                                             blocked_locks) {
+                                if (lock->transport != transport)
+                                        count++;
+                        }
+                }
+        }
+        pthread_mutex_unlock (&pl_inode->mutex);
+
+out:
+        return count;
+}
@@ -157,6 +157,10 @@ typedef struct {
         gf_boolean_t   posixlk_count_req;
         gf_boolean_t   parent_entrylk_req;
 
+        /* used by writev */
+        gf_boolean_t   inodelk_contention_req;
+        int32_t        inodelk_contention;
+
         /* used by {f,}truncate */
         loc_t  loc;
         fd_t  *fd;
@@ -666,9 +666,34 @@ pl_writev_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
                struct iatt *postbuf, dict_t *xdata)
 {
+        pl_local_t *local = NULL;
+        dict_t     *rsp   = NULL;
+        int         ret   = -1;
+
+        local = frame->local;
+        frame->local = NULL;
+
+        if (local && local->inodelk_contention_req && op_ret >= 0) {
+                rsp = xdata ? dict_ref (xdata) : dict_new ();
+                if (rsp) {
+                        ret = dict_set_int32 (rsp, GLUSTERFS_INODELK_CONTENTION,
+                                              local->inodelk_contention);
+                        if (ret < 0)
+                                gf_log (this->name, GF_LOG_DEBUG,
+                                        " dict_set failed on key %s",
+                                        GLUSTERFS_INODELK_CONTENTION);
+                        xdata = rsp;
+                }
+        }
+
         STACK_UNWIND_STRICT (writev, frame, op_ret, op_errno, prebuf, postbuf,
                              xdata);
 
+        if (rsp)
+                dict_unref (rsp);
+        if (local)
+                mem_put (local);
+
         return 0;
 }
 
@@ -842,10 +867,25 @@ pl_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
         int                    op_ret = 0;
         int                    op_errno = 0;
         char                   wind_needed = 1;
+        pl_local_t            *local = NULL;
+        char                  *volume = NULL;
 
         priv = this->private;
         pl_inode = pl_inode_get (this, fd->inode);
 
+        if (xdata && !dict_get_str (xdata, GLUSTERFS_INODELK_CONTENTION,
+                                    &volume)) {
+                local = mem_get0 (this->local_pool);
+                if (local) {
+                        local->inodelk_contention_req = _gf_true;
+                        local->inodelk_contention =
+                                get_inodelk_contention (this, fd->inode,
+                                                        volume,
+                                                        frame->root->trans);
+                        frame->local = local;
+                }
+        }
+
         if (priv->mandatory && pl_inode->mandatory) {
                 region.fl_start   = offset;
                 region.fl_end     = offset + iov_length (vector, count) - 1;
@@ -902,9 +942,13 @@ pl_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
                             FIRST_CHILD (this), FIRST_CHILD (this)->fops->writev,
                             fd, vector, count, offset, flags, iobref, xdata);
 
-        if (op_ret == -1)
+        if (op_ret == -1) {
+                frame->local = NULL;
                 STACK_UNWIND_STRICT (writev, frame, -1, op_errno, NULL, NULL,
                                      NULL);
+                if (local)
+                        mem_put (local);
+        }
 
         return 0;
 }
@@ -1434,6 +1434,130 @@ quiesce_ftruncate (call_frame_t *frame,
         return 0;
 }
 
+int32_t
+quiesce_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                   int32_t keep_size, off_t offset, size_t len, dict_t *xdata)
+{
+	quiesce_priv_t *priv = NULL;
+        call_stub_t    *stub = NULL;
+
+        priv = this->private;
+
+        if (priv->pass_through) {
+                STACK_WIND (frame,
+                            default_fallocate_cbk,
+                            FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->fallocate,
+                            fd, keep_size, offset, len, xdata);
+                return 0;
+        }
+
+        stub = fop_fallocate_stub (frame, default_fallocate_resume, fd,
+                                   keep_size, offset, len, xdata);
+        if (!stub) {
+                STACK_UNWIND_STRICT (fallocate, frame, -1, ENOMEM, NULL, NULL,
+                                     NULL);
+                return 0;
+        }
+
+        gf_quiesce_enqueue (this, stub);
+
+        return 0;
+}
+
+int32_t
+quiesce_discard (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                 off_t offset, size_t len, dict_t *xdata)
+{
+	quiesce_priv_t *priv = NULL;
+        call_stub_t    *stub = NULL;
+
+        priv = this->private;
+
+        if (priv->pass_through) {
+                STACK_WIND (frame,
+                            default_discard_cbk,
+                            FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->discard,
+                            fd, offset, len, xdata);
+                return 0;
+        }
+
+        stub = fop_discard_stub (frame, default_discard_resume, fd,
+                                 offset, len, xdata);
+        if (!stub) {
+                STACK_UNWIND_STRICT (discard, frame, -1, ENOMEM, NULL, NULL,
+                                     NULL);
+                return 0;
+        }
+
+        gf_quiesce_enqueue (this, stub);
+
+        return 0;
+}
+
+int32_t
+quiesce_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                  off_t offset, off_t len, dict_t *xdata)
+{
+	quiesce_priv_t *priv = NULL;
+        call_stub_t    *stub = NULL;
+
+        priv = this->private;
+
+        if (priv->pass_through) {
+                STACK_WIND (frame,
+                            default_zerofill_cbk,
+                            FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->zerofill,
+                            fd, offset, len, xdata);
+                return 0;
+        }
+
+        stub = fop_zerofill_stub (frame, default_zerofill_resume, fd,
+                                  offset, len, xdata);
+        if (!stub) {
+                STACK_UNWIND_STRICT (zerofill, frame, -1, ENOMEM, NULL, NULL,
+                                     NULL);
+                return 0;
+        }
+
+        gf_quiesce_enqueue (this, stub);
+
+        return 0;
+}
+
+int32_t
+quiesce_seek (call_frame_t *frame, xlator_t *this, fd_t *fd,
+              off_t offset,
+              gf_seek_what_t what, dict_t *xdata)
+{
+	quiesce_priv_t *priv = NULL;
+        call_stub_t    *stub = NULL;
+
+        priv = this->private;
+
+        if (priv->pass_through) {
+                STACK_WIND (frame,
+                            default_seek_cbk,
+                            FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->seek,
+                            fd, offset, what, xdata);
+                return 0;
+        }
+
+        stub = fop_seek_stub (frame, default_seek_resume, fd,
+                              offset, what, xdata);
+        if (!stub) {
+                STACK_UNWIND_STRICT (seek, frame, -1, ENOMEM, 0, NULL);
+                return 0;
+        }
+
+        gf_quiesce_enqueue (this, stub);
+
+        return 0;
+}
+
 /* Re-transmittion */
 
 int32_t
@@ -2554,6 +2678,10 @@ struct xlator_fops fops = {
 	.create      = quiesce_create,
 	.truncate    = quiesce_truncate,
 	.ftruncate   = quiesce_ftruncate,
+        .fallocate   = quiesce_fallocate,
+        .discard     = quiesce_discard,
+        .zerofill    = quiesce_zerofill,
+        .seek        = quiesce_seek,
 	.setxattr    = quiesce_setxattr,
 	.removexattr = quiesce_removexattr,
 	.symlink     = quiesce_symlink,
@@ -103,6 +103,30 @@ ro_ftruncate (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset, dict_
 	return 0;
 }
 
+int32_t
+ro_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t keep_size,
+              off_t offset, size_t len, dict_t *xdata)
+{
+        STACK_UNWIND_STRICT (fallocate, frame, -1, EROFS, NULL, NULL, xdata);
+        return 0;
+}
+
+int32_t
+ro_discard (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+            size_t len, dict_t *xdata)
+{
+        STACK_UNWIND_STRICT (discard, frame, -1, EROFS, NULL, NULL, xdata);
+        return 0;
+}
+
+int32_t
+ro_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+             off_t len, dict_t *xdata)
+{
+        STACK_UNWIND_STRICT (zerofill, frame, -1, EROFS, NULL, NULL, xdata);
+        return 0;
+}
+
 int
 ro_mknod (call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
           dev_t rdev, mode_t umask, dict_t *xdata)
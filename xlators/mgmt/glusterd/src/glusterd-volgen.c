@@ -110,21 +110,34 @@ static struct volopt_map_entry glusterd_volopt_map[] = {
         {"cluster.min-free-disk",                "cluster/distribute", NULL, NULL, NO_DOC, 0    },
         {"cluster.min-free-inodes",              "cluster/distribute", NULL, NULL, NO_DOC, 0    },
         {"cluster.rebalance-stats",              "cluster/distribute", NULL, NULL, NO_DOC, 0    },
+        {"cluster.rebalance-workers",            "cluster/distribute", NULL, NULL, NO_DOC, 0    },
+        {"cluster.rebalance-queue-size",         "cluster/distribute", NULL, NULL, NO_DOC, 0    },
+        {"cluster.rebalance-copy-window",        "cluster/distribute", NULL, NULL, NO_DOC, 0    },
+        {"cluster.rebalance-rate-limit",         "cluster/distribute", NULL, NULL, NO_DOC, 0    },
         {"cluster.subvols-per-directory",        "cluster/distribute", "directory-layout-spread", NULL, NO_DOC, 0    },
         {"cluster.readdir-optimize",             "cluster/distribute", NULL, NULL, NO_DOC, 0    },
+        {"cluster.weighted-rebalance",           "cluster/distribute", NULL, NULL, NO_DOC, 0    },
+        {"cluster.weighted-rebalance-latency",   "cluster/distribute", NULL, NULL, NO_DOC, 0    },
+        {"cluster.lookup-hint-cache-size",       "cluster/distribute", NULL, NULL, NO_DOC, 0    },
+        {"cluster.lookup-everywhere-limit",      "cluster/distribute", NULL, NULL, NO_DOC, 0    },
 
         {"cluster.entry-change-log",             "cluster/replicate",  NULL, NULL, NO_DOC, 0     },
         {"cluster.read-subvolume",               "cluster/replicate",  NULL, NULL, NO_DOC, 0    },
         {"cluster.read-subvolume-index",               "cluster/replicate",  NULL, NULL, NO_DOC, 0    },
         {"cluster.read-hash-mode",               "cluster/replicate",  NULL, NULL, NO_DOC, 0},
+        {"cluster.read-balance",                 "cluster/replicate",  NULL, NULL, NO_DOC, 0},
         {"cluster.background-self-heal-count",   "cluster/replicate",  NULL, NULL, NO_DOC, 0    },
         {"cluster.metadata-self-heal",           "cluster/replicate",  NULL, NULL, NO_DOC, 0     },
         {"cluster.data-self-heal",               "cluster/replicate",  NULL, NULL, NO_DOC, 0     },
         {"cluster.entry-self-heal",              "cluster/replicate",  NULL, NULL, NO_DOC, 0     },
         {"cluster.self-heal-daemon",             "cluster/replicate",  "!self-heal-daemon" , NULL, NO_DOC, 0     },
         {"cluster.heal-timeout",                 "cluster/replicate",  "!heal-timeout" , NULL, NO_DOC, 0     },
+        {"cluster.heal-concurrency",             "cluster/replicate",  "!heal-concurrency" , NULL, NO_DOC, 0     },
         {"cluster.strict-readdir",               "cluster/replicate",  NULL, NULL, NO_DOC, 0     },
         {"cluster.self-heal-window-size",        "cluster/replicate",         "data-self-heal-window-size", NULL, DOC, 0},
+        {"cluster.self-heal-checksum-batch",     "cluster/replicate",         "data-self-heal-checksum-batch", NULL, NO_DOC, 0},
+        {"cluster.self-heal-latency-target",     "cluster/replicate",         "data-self-heal-latency-target", NULL, NO_DOC, 0},
+        {"cluster.self-heal-dirty-regions",      "cluster/replicate",         "data-self-heal-dirty-regions", NULL, NO_DOC, 0},
         {"cluster.data-change-log",              "cluster/replicate",  NULL, NULL, NO_DOC, 0     },
         {"cluster.metadata-change-log",          "cluster/replicate",  NULL, NULL, NO_DOC, 0     },
         {"cluster.data-self-heal-algorithm",     "cluster/replicate",         "data-self-heal-algorithm", NULL,DOC, 0},
@@ -135,6 +148,7 @@ static struct volopt_map_entry glusterd_volopt_map[] = {
 
         {"cluster.stripe-block-size",            "cluster/stripe",     "block-size", NULL, DOC, 0},
 	{"cluster.stripe-coalesce",		 "cluster/stripe",     "coalesce", NULL, DOC, 0},
+        {"cluster.stripe-outstanding-rpcs",      "cluster/stripe",     "outstanding-rpcs", NULL, NO_DOC, 0},
 
         {VKEY_DIAG_LAT_MEASUREMENT,              "debug/io-stats",     "latency-measurement", "off", NO_DOC, 0},
         {"diagnostics.dump-fd-stats",            "debug/io-stats",     NULL, NULL, NO_DOC, 0},
@@ -151,6 +165,9 @@ static struct volopt_map_entry glusterd_volopt_map[] = {
         {"performance.cache-priority",           "performance/io-cache",      "priority", NULL, DOC, 0},
         {"performance.cache-size",               "performance/io-cache",      NULL, NULL, NO_DOC, 0 },
         {"performance.cache-size",               "performance/quick-read",    NULL, NULL, NO_DOC, 0 },
+        {"performance.quick-read-cache-shards",  "performance/quick-read",    "cache-shards", NULL, DOC, 0},
+        {"performance.cache-on-readdirp",        "performance/quick-read",    "cache-on-readdirp", NULL, DOC, 0},
+        {"performance.readdirp-max-file-size",   "performance/quick-read",    "readdirp-max-file-size", NULL, DOC, 0},
         {"performance.flush-behind",             "performance/write-behind",  "flush-behind", NULL, DOC, 0},
         {"performance.md-cache-timeout",         "performance/md-cache",      "md-cache-timeout", NULL, DOC, 0},
 
@@ -160,10 +177,25 @@ static struct volopt_map_entry glusterd_volopt_map[] = {
         {"performance.low-prio-threads",         "performance/io-threads",    NULL, NULL, DOC, 0},
         {"performance.least-prio-threads",       "performance/io-threads",    NULL, NULL, DOC, 0},
         {"performance.enable-least-priority",    "performance/io-threads",    NULL, NULL, DOC, 0},
+        {"performance.io-thread-queue-count",    "performance/io-threads",    "queue-count", NULL, DOC, 0},
+        {"performance.io-thread-fairness-key",   "performance/io-threads",    "fairness-key", NULL, DOC, 0},
+        {"performance.io-thread-cpu-affinity",   "performance/io-threads",    "cpu-affinity", NULL, DOC, 0},
         {"performance.disk-usage-limit",         "performance/quota",         NULL, NULL, NO_DOC, 0},
         {"performance.min-free-disk-limit",      "performance/quota",         NULL, NULL, NO_DOC, 0},
         {"performance.write-behind-window-size", "performance/write-behind",  "cache-size", NULL, DOC},
         {"performance.read-ahead-page-count",    "performance/read-ahead",    "page-count", NULL, DOC},
+        {"performance.rda-request-size",         "performance/readdir-ahead", "rda-request-size", NULL, DOC, 0},
+        {"performance.rda-low-wmark",            "performance/readdir-ahead", "rda-low-wmark", NULL, DOC, 0},
+        {"performance.rda-high-wmark",           "performance/readdir-ahead", "rda-high-wmark", NULL, DOC, 0},
+        {"performance.rda-cache-limit",          "performance/readdir-ahead", "rda-cache-limit", NULL, DOC, 0},
+        {"performance.disk-cache-dir",           "performance/disk-cache",    "cache-dir", NULL, DOC, 0},
+        {"performance.disk-cache-size",          "performance/disk-cache",    "cache-size", NULL, DOC, 0},
+        {"performance.disk-cache-block-size",    "performance/disk-cache",    "block-size", NULL, DOC, 0},
+        {"performance.disk-cache-mode",          "performance/disk-cache",    "cache-mode", NULL, DOC, 0},
+        {"performance.disk-cache-timeout",       "performance/disk-cache",    "cache-timeout", NULL, DOC, 0},
+        {"performance.use-anonymous-fd",         "performance/open-behind",   "use-anonymous-fd", NULL, DOC, 0},
+        {"performance.lazy-open",                "performance/open-behind",   "lazy-open", NULL, DOC, 0},
+        {"performance.lazy-open-timeout",        "performance/open-behind",   "lazy-open-timeout", NULL, DOC, 0},
 
         {"network.frame-timeout",                "protocol/client",           NULL, NULL, NO_DOC, 0},
         {"network.ping-timeout",                 "protocol/client",           NULL, NULL, NO_DOC, 0},
@@ -178,12 +210,16 @@ static struct volopt_map_entry glusterd_volopt_map[] = {
         {"server.allow-insecure",                "protocol/server",           "rpc-auth-allow-insecure", NULL, NO_DOC, 0},
         { "server.ssl",                          "protocol/server",           "transport.socket.ssl-enabled", NULL, NO_DOC, 0},
 
+        /* first in the list, so it sits below the in-memory caches */
+        {"performance.disk-cache",               "performance/disk-cache",    "!perf", "off", NO_DOC, 0},
+        {"performance.open-behind",              "performance/open-behind",   "!perf", "off", NO_DOC, 0},
         {"performance.write-behind",             "performance/write-behind",  "!perf", "on", NO_DOC, 0},
         {"performance.read-ahead",               "performance/read-ahead",    "!perf", "on", NO_DOC, 0},
         {"performance.io-cache",                 "performance/io-cache",      "!perf", "on", NO_DOC, 0},
         {"performance.quick-read",               "performance/quick-read",    "!perf", "on", NO_DOC, 0},
         {VKEY_PERF_STAT_PREFETCH,                "performance/md-cache",      "!perf", "on", NO_DOC, 0},
         {"performance.client-io-threads",        "performance/io-threads",    "!perf", "off", NO_DOC, 0},
+        {VKEY_PERF_PARALLEL_READDIR,             "performance/readdir-ahead", "!parallel-readdir", "off", NO_DOC, 0},
 
         {"performance.nfs.write-behind",         "performance/write-behind",  "!nfsperf", "off", NO_DOC, 0},
         {"performance.nfs.read-ahead",           "performance/read-ahead",    "!nfsperf", "off", NO_DOC, 0},
@@ -225,6 +261,7 @@ static struct volopt_map_entry glusterd_volopt_map[] = {
         {VKEY_FEATURES_QUOTA,                    "features/marker",           "quota", "off", NO_DOC, OPT_FLAG_FORCE},
         {VKEY_FEATURES_LIMIT_USAGE,              "features/quota",            "limit-set", NULL, NO_DOC, 0},
         {"features.quota-timeout",               "features/quota",            "timeout", "0", DOC, 0},
+        {"features.dirty-region-size",           "features/index",            "dirty-region-size", NULL, NO_DOC, 0},
         {"server.statedump-path",                "protocol/server",           "statedump-path", NULL, DOC, 0},
         {"features.lock-heal",                   "protocol/client",           "lk-heal", NULL, NO_DOC, 0},
         {"features.lock-heal",                   "protocol/server",           "lk-heal", NULL, DOC, 0},
@@ -233,8 +270,25 @@ static struct volopt_map_entry glusterd_volopt_map[] = {
         {"features.read-only",                   "features/read-only",        "!read-only", "off", DOC, 0},
         {"features.worm",                        "features/worm",             "!worm", "off", DOC, 0},
         {"storage.linux-aio",                    "storage/posix",             NULL, NULL, DOC, 0},
+        {"storage.io-uring",                     "storage/posix",             NULL, NULL, NO_DOC, 0},
+        {"storage.io-uring-fixed-buffers",       "storage/posix",             NULL, NULL, NO_DOC, 0},
         {"storage.owner-uid",                    "storage/posix",             "brick-uid", NULL, DOC, 0},
         {"storage.owner-gid",                    "storage/posix",             "brick-gid", NULL, DOC, 0},
+        {"storage.readdirp-threads",             "storage/posix",             NULL, NULL, NO_DOC, 0},
+        {"storage.handle-cache-size",            "storage/posix",             NULL, NULL, NO_DOC, 0},
+        {"storage.batch-fsync-delay-usec",       "storage/posix",             NULL, NULL, NO_DOC, 0},
+        {"storage.batch-fsync-mode",             "storage/posix",             NULL, NULL, NO_DOC, 0},
+        {"storage.xattrop-cache",                "storage/posix",             NULL, NULL, NO_DOC, 0},
+        {"storage.xattrop-flush-interval",       "storage/posix",             NULL, NULL, NO_DOC, 0},
+        {"storage.create-tmpfile",               "storage/posix",             NULL, NULL, NO_DOC, 0},
+        {"storage.scrub",                        "storage/posix",             NULL, NULL, NO_DOC, 0},
+        {"storage.scrub-max-rate",               "storage/posix",             NULL, NULL, NO_DOC, 0},
+        {"storage.scrub-idle-msec",              "storage/posix",             NULL, NULL, NO_DOC, 0},
+        {"storage.scrub-interval",               "storage/posix",             NULL, NULL, NO_DOC, 0},
+        {"storage.reclaim",                      "storage/posix",             NULL, NULL, NO_DOC, 0},
+        {"storage.reclaim-threads",              "storage/posix",             NULL, NULL, NO_DOC, 0},
+        {"storage.reclaim-min-size",             "storage/posix",             NULL, NULL, NO_DOC, 0},
+        {"storage.reclaim-max-rate",             "storage/posix",             NULL, NULL, NO_DOC, 0},
         {NULL,                                                                }
 };
 
@@ -2380,6 +2434,8 @@ volume_volgen_graph_build_clusters (volgen_graph_t *graph,
                                                        "%s-replicate-%d"};
         char                    *stripe_args[]      = {"cluster/stripe",
                                                        "%s-stripe-%d"};
+        char                    *rda_args[]         = {"performance/readdir-ahead",
+                                                       "%s-readdir-ahead-%d"};
         int                     rclusters           = 0;
         int                     clusters            = 0;
         int                     dist_count          = 0;
@@ -2446,6 +2502,23 @@ build_distribute:
                 goto out;
         }
 
+        /* readdir-ahead below every distribute subvolume lets the opendir
+           fan-out of dht prefetch the directory on all of them in parallel */
+        ret = glusterd_volinfo_get_boolean (volinfo,
+                                            VKEY_PERF_PARALLEL_READDIR);
+        if (ret == -1)
+                goto out;
+        if (ret && (dist_count > 1)) {
+                clusters = volgen_graph_build_clusters (graph, volinfo,
+                                                        rda_args[0],
+                                                        rda_args[1],
+                                                        dist_count, 1);
+                if (clusters < 0) {
+                        ret = -1;
+                        goto out;
+                }
+        }
+
         ret = volgen_graph_build_dht_cluster (graph, volinfo,
                                               dist_count);
         if (ret)
@@ -2456,6 +2529,30 @@ out:
         return ret;
 }
 
+/* A sequential reader of a striped volume keeps all the stripe subvolumes
+   busy only if read-ahead covers a whole stripe row. Sized here by default,
+   performance.read-ahead-page-count still overrides it. */
+static int
+volgen_stripe_read_ahead (volgen_graph_t *graph, glusterd_volinfo_t *volinfo)
+{
+        xlator_t *trav = NULL;
+        char      page_count[16] = {0,};
+
+        if (volinfo->stripe_count < 2)
+                return 0;
+
+        for (trav = first_of (graph); trav; trav = trav->next) {
+                if (strcmp (trav->type, "performance/read-ahead") != 0)
+                        continue;
+
+                snprintf (page_count, sizeof (page_count), "%d",
+                          min (max (volinfo->stripe_count, 4), 16));
+                return xlator_set_option (trav, "page-count", page_count);
+        }
+
+        return 0;
+}
+
 static int
 client_graph_builder (volgen_graph_t *graph, glusterd_volinfo_t *volinfo,
                       dict_t *set_dict, void *param)
@@ -2499,6 +2596,10 @@ client_graph_builder (volgen_graph_t *graph, glusterd_volinfo_t *volinfo,
         if (ret)
                 goto out;
 
+        ret = volgen_stripe_read_ahead (graph, volinfo);
+        if (ret)
+                goto out;
+
         /* add debug translators depending on the options */
         ret = check_and_add_debug_xl (graph, set_dict, volname,
                                       "client");
@@ -2539,6 +2640,7 @@ build_client_graph (volgen_graph_t *graph, glusterd_volinfo_t *volinfo,
 char *gd_shd_options[] = {
         "!self-heal-daemon",
         "!heal-timeout",
+        "!heal-concurrency",
         NULL
 };
 
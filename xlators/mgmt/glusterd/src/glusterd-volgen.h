@@ -25,6 +25,7 @@
 #define VKEY_MARKER_XTIME         GEOREP".indexing"
 #define VKEY_FEATURES_QUOTA       "features.quota"
 #define VKEY_PERF_STAT_PREFETCH   "performance.stat-prefetch"
+#define VKEY_PERF_PARALLEL_READDIR "performance.parallel-readdir"
 
 typedef enum {
         GF_CLIENT_TRUSTED,
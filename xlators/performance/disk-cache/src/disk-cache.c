@@ -0,0 +1,1884 @@
+/*
+  Copyright (c) 2012 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/*
+ * performance/disk-cache: keeps the content of files read through this
+ * client in fixed size blocks below a local directory, typically on a fast
+ * local disk. Unlike io-cache the data outlives the process, so a remount
+ * finds the blocks of the previous mount again.
+ *
+ * Blocks of a file are tied to the version of the file they were read
+ * from (gfid, size, mtime and ctime). Whenever the attributes known for the
+ * file differ from that version, all its blocks are dropped. Attributes are
+ * refreshed with an fstat once they are older than cache-timeout.
+ *
+ * In write-around mode writes only change the attributes, which drops the
+ * blocks on the next read. In write-through mode the written data also
+ * updates the cached blocks, so the rest of the file stays cached.
+ */
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/file.h>
+#include <dirent.h>
+
+#include "disk-cache.h"
+#include "statedump.h"
+
+static void dc_cache_prune (xlator_t *this);
+
+static uint64_t
+dc_usec_since (struct timeval *then)
+{
+        struct timeval now = {0, };
+
+        gettimeofday (&now, NULL);
+
+        if (now.tv_sec < then->tv_sec)
+                return 0;
+
+        return ((now.tv_sec - then->tv_sec) * 1000000ULL)
+                + now.tv_usec - then->tv_usec;
+}
+
+static void
+dc_entry_path (dc_priv_t *priv, uuid_t gfid, char *path, size_t len)
+{
+        char gfid_str[64] = {0, };
+
+        uuid_utoa_r (gfid, gfid_str);
+        snprintf (path, len, "%s/%02x/%s", priv->cache_dir, gfid[0],
+                  gfid_str);
+}
+
+static void
+dc_block_path (dc_priv_t *priv, uuid_t gfid, uint64_t block, char *path,
+               size_t len)
+{
+        char gfid_str[64] = {0, };
+
+        uuid_utoa_r (gfid, gfid_str);
+        snprintf (path, len, "%s/%02x/%s/%"PRIx64, priv->cache_dir, gfid[0],
+                  gfid_str, block);
+}
+
+/* write a file atomically, readers see the old or the new content */
+static int
+dc_file_write (const char *path, const char *buf, size_t len)
+{
+        char    tmp[PATH_MAX] = {0, };
+        int     fd            = -1;
+        ssize_t ret           = -1;
+
+        snprintf (tmp, sizeof (tmp), "%s.tmp", path);
+
+        fd = open (tmp, O_CREAT|O_TRUNC|O_WRONLY, 0600);
+        if (fd == -1)
+                goto out;
+
+        ret = write (fd, buf, len);
+        close (fd);
+        if (ret != len) {
+                unlink (tmp);
+                ret = -1;
+                goto out;
+        }
+
+        ret = rename (tmp, path);
+        if (ret == -1)
+                unlink (tmp);
+out:
+        return (ret < 0) ? -1 : 0;
+}
+
+/* ----------------------------------------------------------------------
+ * versions
+ */
+
+static void
+dc_meta_fill (dc_priv_t *priv, dc_meta_t *meta, struct iatt *stbuf)
+{
+        memset (meta, 0, sizeof (*meta));
+
+        meta->magic = DC_META_MAGIC;
+        meta->block_size = priv->block_size;
+        uuid_copy (meta->gfid, stbuf->ia_gfid);
+        meta->size = stbuf->ia_size;
+        meta->mtime = stbuf->ia_mtime;
+        meta->mtime_nsec = stbuf->ia_mtime_nsec;
+        meta->ctime = stbuf->ia_ctime;
+        meta->ctime_nsec = stbuf->ia_ctime_nsec;
+}
+
+static gf_boolean_t
+dc_meta_matches (dc_priv_t *priv, dc_meta_t *meta, struct iatt *stbuf)
+{
+        return ((meta->magic == DC_META_MAGIC) &&
+                (meta->block_size == priv->block_size) &&
+                (uuid_compare (meta->gfid, stbuf->ia_gfid) == 0) &&
+                (meta->size == stbuf->ia_size) &&
+                (meta->mtime == stbuf->ia_mtime) &&
+                (meta->mtime_nsec == stbuf->ia_mtime_nsec) &&
+                (meta->ctime == stbuf->ia_ctime) &&
+                (meta->ctime_nsec == stbuf->ia_ctime_nsec));
+}
+
+static int
+dc_meta_read (dc_priv_t *priv, uuid_t gfid, dc_meta_t *meta)
+{
+        char    path[PATH_MAX] = {0, };
+        int     fd             = -1;
+        ssize_t ret            = -1;
+
+        dc_entry_path (priv, gfid, path, sizeof (path));
+        strncat (path, "/meta", sizeof (path) - strlen (path) - 1);
+
+        fd = open (path, O_RDONLY);
+        if (fd == -1)
+                return -1;
+
+        ret = read (fd, meta, sizeof (*meta));
+        close (fd);
+
+        if ((ret != sizeof (*meta)) || (meta->magic != DC_META_MAGIC) ||
+            (uuid_compare (meta->gfid, gfid) != 0))
+                return -1;
+
+        return 0;
+}
+
+/* ----------------------------------------------------------------------
+ * cached files
+ */
+
+static struct list_head *
+dc_hash_bucket (dc_priv_t *priv, uuid_t gfid)
+{
+        return &priv->hash[((gfid[14] << 8) | gfid[15]) % DC_HASH_BUCKETS];
+}
+
+static dc_entry_t *
+__dc_entry_new (dc_priv_t *priv, uuid_t gfid)
+{
+        dc_entry_t *entry = NULL;
+
+        entry = GF_CALLOC (1, sizeof (*entry), gf_dc_mt_dc_entry_t);
+        if (!entry)
+                return NULL;
+
+        uuid_copy (entry->gfid, gfid);
+        pthread_rwlock_init (&entry->rwlock, NULL);
+        INIT_LIST_HEAD (&entry->hash);
+        INIT_LIST_HEAD (&entry->lru);
+
+        list_add_tail (&entry->hash, dc_hash_bucket (priv, gfid));
+        list_add_tail (&entry->lru, &priv->lru);
+        priv->entry_count++;
+
+        return entry;
+}
+
+static dc_entry_t *
+__dc_entry_find (dc_priv_t *priv, uuid_t gfid)
+{
+        dc_entry_t *entry = NULL;
+
+        list_for_each_entry (entry, dc_hash_bucket (priv, gfid), hash) {
+                if (uuid_compare (entry->gfid, gfid) == 0)
+                        return entry;
+        }
+
+        return NULL;
+}
+
+static void
+dc_entry_free (dc_entry_t *entry)
+{
+        pthread_rwlock_destroy (&entry->rwlock);
+        GF_FREE (entry);
+}
+
+/* Returns the entry of gfid with a ref, NULL while it is being evicted */
+static dc_entry_t *
+dc_entry_get (xlator_t *this, uuid_t gfid)
+{
+        dc_priv_t  *priv  = NULL;
+        dc_entry_t *entry = NULL;
+
+        priv = this->private;
+
+        LOCK (&priv->lock);
+        {
+                entry = __dc_entry_find (priv, gfid);
+                if (!entry)
+                        entry = __dc_entry_new (priv, gfid);
+
+                if (!entry || entry->evicted) {
+                        entry = NULL;
+                        goto unlock;
+                }
+
+                entry->ref++;
+                list_move_tail (&entry->lru, &priv->lru);
+        }
+unlock:
+        UNLOCK (&priv->lock);
+
+        return entry;
+}
+
+static void
+dc_entry_put (xlator_t *this, dc_entry_t *entry)
+{
+        dc_priv_t    *priv    = NULL;
+        gf_boolean_t  destroy = _gf_false;
+
+        priv = this->private;
+
+        LOCK (&priv->lock);
+        {
+                entry->ref--;
+                if (entry->ref)
+                        goto unlock;
+
+                if (entry->evicted) {
+                        destroy = _gf_true;
+                } else if (!entry->meta_valid && !entry->bytes) {
+                        /* nothing cached, do not keep it in memory */
+                        list_del_init (&entry->hash);
+                        list_del_init (&entry->lru);
+                        priv->entry_count--;
+                        destroy = _gf_true;
+                }
+        }
+unlock:
+        UNLOCK (&priv->lock);
+
+        if (destroy)
+                dc_entry_free (entry);
+}
+
+/* Remove the files of an entry, called with its rwlock write locked */
+static void
+dc_entry_wipe (dc_priv_t *priv, dc_entry_t *entry, gf_boolean_t rmdir_too)
+{
+        char           dir[PATH_MAX]  = {0, };
+        char           path[PATH_MAX] = {0, };
+        DIR           *dirp           = NULL;
+        struct dirent *dentry         = NULL;
+
+        dc_entry_path (priv, entry->gfid, dir, sizeof (dir));
+
+        dirp = opendir (dir);
+        if (!dirp)
+                return;
+
+        while ((dentry = readdir (dirp)) != NULL) {
+                if (!strcmp (dentry->d_name, ".") ||
+                    !strcmp (dentry->d_name, ".."))
+                        continue;
+
+                snprintf (path, sizeof (path), "%s/%s", dir, dentry->d_name);
+                unlink (path);
+        }
+        closedir (dirp);
+
+        if (rmdir_too)
+                rmdir (dir);
+
+        entry->meta_valid = _gf_false;
+}
+
+/* drop all blocks of an entry, called with its rwlock write locked */
+static void
+dc_entry_reset (dc_priv_t *priv, dc_entry_t *entry)
+{
+        dc_entry_wipe (priv, entry, _gf_false);
+
+        LOCK (&priv->lock);
+        {
+                if (!entry->evicted) {
+                        priv->cache_used -= entry->bytes;
+                        entry->bytes = 0;
+                }
+        }
+        UNLOCK (&priv->lock);
+}
+
+/* account for blocks written or removed, prunes the cache if it is full */
+static void
+dc_entry_account (xlator_t *this, dc_entry_t *entry, int64_t delta)
+{
+        dc_priv_t    *priv  = NULL;
+        gf_boolean_t  prune = _gf_false;
+
+        priv = this->private;
+
+        LOCK (&priv->lock);
+        {
+                if (!entry->evicted) {
+                        entry->bytes += delta;
+                        priv->cache_used += delta;
+                }
+                prune = (priv->cache_used > priv->cache_size);
+        }
+        UNLOCK (&priv->lock);
+
+        if (prune)
+                dc_cache_prune (this);
+}
+
+/*
+ * Drop the least recently used files until the cache is 10% below its
+ * size. Evicted entries stay hashed until their files are gone, so a new
+ * entry of the same gfid cannot race with the removal.
+ */
+static void
+dc_cache_prune (xlator_t *this)
+{
+        dc_priv_t        *priv   = NULL;
+        dc_entry_t       *entry  = NULL;
+        dc_entry_t       *tmp    = NULL;
+        uint64_t          target = 0;
+        struct list_head  victims;
+
+        priv = this->private;
+        INIT_LIST_HEAD (&victims);
+
+        LOCK (&priv->lock);
+        {
+                target = priv->cache_size - (priv->cache_size / 10);
+
+                list_for_each_entry_safe (entry, tmp, &priv->lru, lru) {
+                        if (priv->cache_used <= target)
+                                break;
+
+                        entry->evicted = _gf_true;
+                        entry->ref++;
+                        priv->cache_used -= entry->bytes;
+                        entry->bytes = 0;
+                        priv->evictions++;
+                        list_move_tail (&entry->lru, &victims);
+                }
+        }
+        UNLOCK (&priv->lock);
+
+        list_for_each_entry_safe (entry, tmp, &victims, lru) {
+                list_del_init (&entry->lru);
+
+                pthread_rwlock_wrlock (&entry->rwlock);
+                {
+                        dc_entry_wipe (priv, entry, _gf_true);
+                }
+                pthread_rwlock_unlock (&entry->rwlock);
+
+                LOCK (&priv->lock);
+                {
+                        list_del_init (&entry->hash);
+                        priv->entry_count--;
+                }
+                UNLOCK (&priv->lock);
+
+                dc_entry_put (this, entry);
+        }
+}
+
+/*
+ * Make the entry describe the file version in stbuf, dropping the blocks
+ * of any other version. Called with the rwlock write locked.
+ */
+static int
+dc_entry_rekey (xlator_t *this, dc_entry_t *entry, struct iatt *stbuf)
+{
+        dc_priv_t *priv           = NULL;
+        dc_meta_t  meta           = {0, };
+        char       path[PATH_MAX] = {0, };
+        int        ret            = -1;
+
+        priv = this->private;
+
+        if (entry->meta_valid &&
+            dc_meta_matches (priv, &entry->meta, stbuf))
+                return 0;
+
+        if (entry->meta_valid) {
+                LOCK (&priv->lock);
+                {
+                        priv->invalidations++;
+                }
+                UNLOCK (&priv->lock);
+        }
+
+        dc_entry_reset (priv, entry);
+
+        dc_entry_path (priv, entry->gfid, path, sizeof (path));
+        ret = mkdir (path, 0700);
+        if ((ret == -1) && (errno != EEXIST))
+                goto out;
+
+        dc_meta_fill (priv, &meta, stbuf);
+        strncat (path, "/meta", sizeof (path) - strlen (path) - 1);
+        ret = dc_file_write (path, (char *)&meta, sizeof (meta));
+        if (ret)
+                goto out;
+
+        entry->meta = meta;
+        entry->meta_valid = _gf_true;
+out:
+        if (ret) {
+                gf_log (this->name, GF_LOG_DEBUG,
+                        "cannot create cache entry %s (%s)", path,
+                        strerror (errno));
+        }
+        return ret;
+}
+
+/* store one block, returns the change in bytes used or -1 */
+static int64_t
+dc_block_write (dc_priv_t *priv, dc_entry_t *entry, uint64_t block,
+                const char *buf, size_t len)
+{
+        char        path[PATH_MAX] = {0, };
+        struct stat st             = {0, };
+        int64_t     old            = 0;
+
+        dc_block_path (priv, entry->gfid, block, path, sizeof (path));
+
+        if (lstat (path, &st) == 0)
+                old = st.st_size;
+
+        if (dc_file_write (path, buf, len))
+                return -1;
+
+        return (int64_t)len - old;
+}
+
+/* read len bytes at offset, all of it must be cached */
+static int
+dc_blocks_read (dc_priv_t *priv, dc_entry_t *entry, off_t offset, size_t len,
+                char *buf)
+{
+        char     path[PATH_MAX] = {0, };
+        uint64_t block          = 0;
+        off_t    block_off      = 0;
+        size_t   want           = 0;
+        size_t   done           = 0;
+        ssize_t  ret            = 0;
+        int      fd             = -1;
+
+        while (done < len) {
+                block = (offset + done) / priv->block_size;
+                block_off = (offset + done) % priv->block_size;
+                want = min (len - done, priv->block_size - block_off);
+
+                dc_block_path (priv, entry->gfid, block, path, sizeof (path));
+
+                fd = open (path, O_RDONLY);
+                if (fd == -1)
+                        return -1;
+
+                ret = pread (fd, buf + done, want, block_off);
+                close (fd);
+
+                if (ret != want)
+                        return -1;
+
+                done += want;
+        }
+
+        return 0;
+}
+
+/*
+ * Store the blocks of [offset, offset + len) read from the file version
+ * in stbuf. Only whole blocks are kept, or the last block of the file.
+ */
+static void
+dc_cache_fill (xlator_t *this, struct iatt *stbuf, off_t offset,
+               const char *buf, size_t len)
+{
+        dc_priv_t  *priv    = NULL;
+        dc_entry_t *entry   = NULL;
+        uint64_t    block   = 0;
+        off_t       start   = 0;
+        size_t      blen    = 0;
+        int64_t     delta   = 0;
+        int64_t     ret     = 0;
+        uint64_t    written = 0;
+
+        priv = this->private;
+
+        if (!IA_ISREG (stbuf->ia_type) || !len)
+                return;
+
+        entry = dc_entry_get (this, stbuf->ia_gfid);
+        if (!entry)
+                return;
+
+        pthread_rwlock_wrlock (&entry->rwlock);
+        {
+                if (entry->evicted)
+                        goto unlock;
+
+                if (dc_entry_rekey (this, entry, stbuf))
+                        goto unlock;
+
+                block = (offset + priv->block_size - 1) / priv->block_size;
+                for (;; block++) {
+                        start = block * priv->block_size;
+                        if (start >= stbuf->ia_size)
+                                break;
+
+                        blen = min (priv->block_size, stbuf->ia_size - start);
+                        if (start + blen > offset + len)
+                                break;
+
+                        ret = dc_block_write (priv, entry, block,
+                                              buf + (start - offset), blen);
+                        if (ret == -1)
+                                break;
+
+                        delta += ret;
+                        written++;
+                }
+        }
+unlock:
+        pthread_rwlock_unlock (&entry->rwlock);
+
+        LOCK (&priv->lock);
+        {
+                priv->blocks_written += written;
+                if (ret == -1)
+                        priv->errors++;
+        }
+        UNLOCK (&priv->lock);
+
+        if (delta)
+                dc_entry_account (this, entry, delta);
+
+        dc_entry_put (this, entry);
+}
+
+/*
+ * write-through: apply a successful write to the cached blocks, provided
+ * the cache held the version the write was applied to.
+ */
+static void
+dc_cache_write (xlator_t *this, struct iatt *prebuf, struct iatt *postbuf,
+                off_t offset, struct iovec *vector, int32_t count,
+                size_t len)
+{
+        dc_priv_t  *priv      = NULL;
+        dc_entry_t *entry     = NULL;
+        char       *data      = NULL;
+        char       *blockbuf  = NULL;
+        char        path[PATH_MAX] = {0, };
+        dc_meta_t   meta      = {0, };
+        uint64_t    block     = 0;
+        off_t       start     = 0;
+        off_t       wstart    = 0;
+        off_t       wend      = 0;
+        size_t      valid     = 0;
+        size_t      expected  = 0;
+        ssize_t     old       = 0;
+        int64_t     delta     = 0;
+        int64_t     ret       = 0;
+        int         fd        = -1;
+        gf_boolean_t failed   = _gf_false;
+
+        priv = this->private;
+
+        entry = dc_entry_get (this, postbuf->ia_gfid);
+        if (!entry)
+                return;
+
+        data = GF_MALLOC (len, gf_dc_mt_char);
+        blockbuf = GF_MALLOC (priv->block_size, gf_dc_mt_char);
+        if (!data || !blockbuf)
+                goto out;
+
+        iov_unload (data, vector, count);
+
+        pthread_rwlock_wrlock (&entry->rwlock);
+        {
+                if (entry->evicted || !entry->meta_valid ||
+                    !dc_meta_matches (priv, &entry->meta, prebuf))
+                        goto unlock;
+
+                for (block = offset / priv->block_size;
+                     block * priv->block_size < offset + len; block++) {
+                        start = block * priv->block_size;
+                        valid = min (priv->block_size,
+                                     postbuf->ia_size - start);
+                        wstart = max (offset, start) - start;
+                        wend = min (offset + len, start + valid) - start;
+
+                        dc_block_path (priv, entry->gfid, block, path,
+                                       sizeof (path));
+
+                        if ((wstart == 0) && (wend == valid)) {
+                                ret = dc_block_write (priv, entry, block,
+                                                      data + (start - offset),
+                                                      valid);
+                                if (ret == -1)
+                                        break;
+                                delta += ret;
+                                continue;
+                        }
+
+                        /* partial write, patch the cached block if any */
+                        fd = open (path, O_RDONLY);
+                        if (fd == -1)
+                                continue;
+                        old = pread (fd, blockbuf, priv->block_size, 0);
+                        close (fd);
+
+                        expected = 0;
+                        if (prebuf->ia_size > start)
+                                expected = min (priv->block_size,
+                                                prebuf->ia_size - start);
+
+                        if ((old < 0) || (old < expected)) {
+                                unlink (path);
+                                delta -= max (old, 0);
+                                continue;
+                        }
+
+                        if (wstart > old)
+                                memset (blockbuf + old, 0, wstart - old);
+                        memcpy (blockbuf + wstart,
+                                data + (start + wstart - offset),
+                                wend - wstart);
+
+                        if (max (old, wend) != valid) {
+                                unlink (path);
+                                delta -= old;
+                                continue;
+                        }
+
+                        ret = dc_block_write (priv, entry, block, blockbuf,
+                                              valid);
+                        if (ret == -1)
+                                break;
+                        delta += ret;
+                }
+
+                if (ret != -1) {
+                        dc_entry_path (priv, entry->gfid, path,
+                                       sizeof (path));
+                        strncat (path, "/meta",
+                                 sizeof (path) - strlen (path) - 1);
+                        dc_meta_fill (priv, &meta, postbuf);
+                        ret = dc_file_write (path, (char *)&meta,
+                                             sizeof (meta));
+                }
+
+                if (ret == -1) {
+                        /* the blocks may not match any version now */
+                        dc_entry_reset (priv, entry);
+                        failed = _gf_true;
+                        goto unlock;
+                }
+                entry->meta = meta;
+        }
+unlock:
+        pthread_rwlock_unlock (&entry->rwlock);
+
+        if (failed) {
+                LOCK (&priv->lock);
+                {
+                        priv->errors++;
+                }
+                UNLOCK (&priv->lock);
+        } else if (delta) {
+                dc_entry_account (this, entry, delta);
+        }
+out:
+        GF_FREE (data);
+        GF_FREE (blockbuf);
+        dc_entry_put (this, entry);
+}
+
+/* ----------------------------------------------------------------------
+ * inode attributes
+ */
+
+static dc_inode_t *
+dc_inode_ctx_get (xlator_t *this, inode_t *inode)
+{
+        dc_inode_t *ctx   = NULL;
+        uint64_t    value = 0;
+        int         ret   = -1;
+
+        LOCK (&inode->lock);
+        {
+                ret = __inode_ctx_get (inode, this, &value);
+                if (ret == 0) {
+                        ctx = (dc_inode_t *)(long) value;
+                        goto unlock;
+                }
+
+                ctx = GF_CALLOC (1, sizeof (*ctx), gf_dc_mt_dc_inode_t);
+                if (!ctx)
+                        goto unlock;
+
+                LOCK_INIT (&ctx->lock);
+
+                ret = __inode_ctx_put (inode, this, (uint64_t)(long) ctx);
+                if (ret) {
+                        LOCK_DESTROY (&ctx->lock);
+                        GF_FREE (ctx);
+                        ctx = NULL;
+                }
+        }
+unlock:
+        UNLOCK (&inode->lock);
+
+        return ctx;
+}
+
+static void
+dc_inode_update (xlator_t *this, inode_t *inode, struct iatt *stbuf)
+{
+        dc_inode_t *ctx = NULL;
+
+        if (!inode || !stbuf || !IA_ISREG (stbuf->ia_type))
+                return;
+
+        ctx = dc_inode_ctx_get (this, inode);
+        if (!ctx)
+                return;
+
+        LOCK (&ctx->lock);
+        {
+                ctx->stbuf = *stbuf;
+                gettimeofday (&ctx->tv, NULL);
+        }
+        UNLOCK (&ctx->lock);
+}
+
+static void
+dc_inode_invalidate (xlator_t *this, inode_t *inode)
+{
+        dc_inode_t *ctx   = NULL;
+        uint64_t    value = 0;
+
+        if (inode_ctx_get (inode, this, &value) || !value)
+                return;
+
+        ctx = (dc_inode_t *)(long) value;
+
+        LOCK (&ctx->lock);
+        {
+                memset (&ctx->tv, 0, sizeof (ctx->tv));
+        }
+        UNLOCK (&ctx->lock);
+}
+
+/* copy the attributes, returns -1 when they need revalidation first */
+static int
+dc_inode_stbuf (xlator_t *this, dc_inode_t *ctx, struct iatt *stbuf)
+{
+        dc_priv_t *priv = NULL;
+        int        ret  = 0;
+
+        priv = this->private;
+
+        LOCK (&ctx->lock);
+        {
+                *stbuf = ctx->stbuf;
+                if (!ctx->tv.tv_sec ||
+                    (dc_usec_since (&ctx->tv) >=
+                     priv->cache_timeout * 1000000ULL))
+                        ret = -1;
+        }
+        UNLOCK (&ctx->lock);
+
+        return ret;
+}
+
+/* ----------------------------------------------------------------------
+ * fops
+ */
+
+static void
+dc_local_wipe (dc_local_t *local)
+{
+        if (!local)
+                return;
+
+        if (local->fd)
+                fd_unref (local->fd);
+        if (local->iobref)
+                iobref_unref (local->iobref);
+        if (local->xdata)
+                dict_unref (local->xdata);
+        GF_FREE (local->vector);
+
+        mem_put (local);
+}
+
+int32_t
+dc_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, inode_t *inode,
+               struct iatt *buf, dict_t *xdata, struct iatt *postparent)
+{
+        if (op_ret == 0)
+                dc_inode_update (this, inode, buf);
+
+        STACK_UNWIND_STRICT (lookup, frame, op_ret, op_errno, inode, buf,
+                             xdata, postparent);
+        return 0;
+}
+
+int32_t
+dc_lookup (call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
+{
+        STACK_WIND (frame, dc_lookup_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->lookup, loc, xdata);
+        return 0;
+}
+
+int32_t
+dc_readv_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, struct iovec *vector,
+              int32_t count, struct iatt *stbuf, struct iobref *iobref,
+              dict_t *xdata)
+{
+        dc_local_t    *local  = NULL;
+        struct iobuf  *iobuf  = NULL;
+        struct iobref *reply  = NULL;
+        struct iovec   vec    = {0, };
+        struct iatt    attr   = {0, };
+        off_t          skip   = 0;
+
+        local = frame->local;
+        frame->local = NULL;
+
+        if ((op_ret < 0) || !local)
+                goto unwind;
+
+        dc_inode_update (this, local->fd->inode, stbuf);
+
+        if ((local->aligned_offset == local->offset) &&
+            (op_ret <= local->size)) {
+                /* the reply fits the request, cache it on the way back */
+                iobuf = iobuf_get2 (this->ctx->iobuf_pool, op_ret);
+                if (iobuf) {
+                        iov_unload (iobuf->ptr, vector, count);
+                        attr = *stbuf;
+                }
+                goto unwind;
+        }
+
+        /* the request was widened to whole blocks, cut out the part that
+         * was asked for */
+        iobuf = iobuf_get2 (this->ctx->iobuf_pool, op_ret);
+        reply = iobref_new ();
+        if (!iobuf || !reply) {
+                STACK_UNWIND_STRICT (readv, frame, -1, ENOMEM, NULL, 0, NULL,
+                                     NULL, NULL);
+                op_ret = -1;
+                goto cache;
+        }
+
+        iov_unload (iobuf->ptr, vector, count);
+        iobref_add (reply, iobuf);
+        attr = *stbuf;
+
+        skip = local->offset - local->aligned_offset;
+        vec.iov_base = iobuf->ptr + skip;
+        vec.iov_len = (op_ret > skip) ? min (op_ret - skip, local->size) : 0;
+
+        STACK_UNWIND_STRICT (readv, frame, vec.iov_len, 0, &vec, 1, stbuf,
+                             reply, xdata);
+        goto cache;
+
+unwind:
+        STACK_UNWIND_STRICT (readv, frame, op_ret, op_errno, vector, count,
+                             stbuf, iobref, xdata);
+cache:
+        if (iobuf && (op_ret > 0))
+                dc_cache_fill (this, &attr, local->aligned_offset, iobuf->ptr,
+                               op_ret);
+
+        if (iobuf)
+                iobuf_unref (iobuf);
+        if (reply)
+                iobref_unref (reply);
+        dc_local_wipe (local);
+
+        return 0;
+}
+
+static void
+dc_readv_miss (call_frame_t *frame, xlator_t *this)
+{
+        dc_priv_t  *priv  = NULL;
+        dc_local_t *local = NULL;
+        off_t       end   = 0;
+
+        priv = this->private;
+        local = frame->local;
+
+        LOCK (&priv->lock);
+        {
+                priv->misses++;
+                priv->miss_bytes += local->size;
+        }
+        UNLOCK (&priv->lock);
+
+        /* widen to whole blocks so that they can all be cached */
+        local->aligned_offset = local->offset
+                - (local->offset % priv->block_size);
+        end = local->offset + local->size;
+        end = end + priv->block_size - 1 - ((end - 1) % priv->block_size);
+
+        if (end - local->aligned_offset > GF_UNIT_MB) {
+                local->aligned_offset = local->offset;
+                end = local->offset + local->size;
+        }
+
+        STACK_WIND (frame, dc_readv_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->readv, local->fd,
+                    end - local->aligned_offset, local->aligned_offset,
+                    local->flags, local->xdata);
+}
+
+static void
+dc_readv_cached (call_frame_t *frame, xlator_t *this, struct iatt *stbuf)
+{
+        dc_priv_t     *priv   = NULL;
+        dc_local_t    *local  = NULL;
+        dc_entry_t    *entry  = NULL;
+        struct iobuf  *iobuf  = NULL;
+        struct iobref *iobref = NULL;
+        struct iovec   vec    = {0, };
+        size_t         len    = 0;
+        gf_boolean_t   hit    = _gf_false;
+
+        priv = this->private;
+        local = frame->local;
+
+        if (!IA_ISREG (stbuf->ia_type) || (local->offset >= stbuf->ia_size))
+                goto miss;
+
+        len = min (local->size, stbuf->ia_size - local->offset);
+
+        entry = dc_entry_get (this, stbuf->ia_gfid);
+        if (!entry)
+                goto miss;
+
+        iobuf = iobuf_get2 (this->ctx->iobuf_pool, len);
+        if (!iobuf)
+                goto miss;
+
+        pthread_rwlock_rdlock (&entry->rwlock);
+        {
+                hit = (entry->meta_valid &&
+                       dc_meta_matches (priv, &entry->meta, stbuf) &&
+                       !dc_blocks_read (priv, entry, local->offset, len,
+                                        iobuf->ptr));
+        }
+        pthread_rwlock_unlock (&entry->rwlock);
+
+        if (!hit)
+                goto miss;
+
+        iobref = iobref_new ();
+        if (!iobref)
+                goto miss;
+        iobref_add (iobref, iobuf);
+
+        LOCK (&priv->lock);
+        {
+                priv->hits++;
+                priv->hit_bytes += len;
+        }
+        UNLOCK (&priv->lock);
+
+        dc_entry_put (this, entry);
+
+        vec.iov_base = iobuf->ptr;
+        vec.iov_len = len;
+
+        frame->local = NULL;
+        STACK_UNWIND_STRICT (readv, frame, len, 0, &vec, 1, stbuf, iobref,
+                             NULL);
+
+        iobuf_unref (iobuf);
+        iobref_unref (iobref);
+        dc_local_wipe (local);
+        return;
+
+miss:
+        if (iobuf)
+                iobuf_unref (iobuf);
+        if (entry)
+                dc_entry_put (this, entry);
+
+        dc_readv_miss (frame, this);
+}
+
+int32_t
+dc_readv_validate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                       int32_t op_ret, int32_t op_errno, struct iatt *buf,
+                       dict_t *xdata)
+{
+        dc_local_t *local = NULL;
+
+        local = frame->local;
+
+        if (op_ret != 0) {
+                dc_readv_miss (frame, this);
+                return 0;
+        }
+
+        dc_inode_update (this, local->fd->inode, buf);
+        dc_readv_cached (frame, this, buf);
+
+        return 0;
+}
+
+int32_t
+dc_readv (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+          off_t offset, uint32_t flags, dict_t *xdata)
+{
+        dc_priv_t   *priv   = NULL;
+        dc_inode_t  *ctx    = NULL;
+        dc_local_t  *local  = NULL;
+        struct iatt  stbuf  = {0, };
+
+        priv = this->private;
+
+        if (!priv->enabled || !size)
+                goto wind;
+
+        ctx = dc_inode_ctx_get (this, fd->inode);
+        if (!ctx)
+                goto wind;
+
+        local = mem_get0 (this->local_pool);
+        if (!local)
+                goto wind;
+
+        local->fd = fd_ref (fd);
+        local->size = size;
+        local->offset = offset;
+        local->flags = flags;
+        if (xdata)
+                local->xdata = dict_ref (xdata);
+        frame->local = local;
+
+        if (dc_inode_stbuf (this, ctx, &stbuf)) {
+                STACK_WIND (frame, dc_readv_validate_cbk, FIRST_CHILD (this),
+                            FIRST_CHILD (this)->fops->fstat, fd, NULL);
+                return 0;
+        }
+
+        dc_readv_cached (frame, this, &stbuf);
+        return 0;
+
+wind:
+        STACK_WIND (frame, default_readv_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->readv, fd, size, offset, flags,
+                    xdata);
+        return 0;
+}
+
+int32_t
+dc_writev_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+               struct iatt *postbuf, dict_t *xdata)
+{
+        dc_local_t *local = NULL;
+
+        local = frame->local;
+        frame->local = NULL;
+
+        if (op_ret < 0)
+                goto unwind;
+
+        if (local) {
+                dc_inode_update (this, local->fd->inode, postbuf);
+                if (local->vector && (op_ret > 0))
+                        dc_cache_write (this, prebuf, postbuf, local->offset,
+                                        local->vector, local->count, op_ret);
+        }
+
+unwind:
+        STACK_UNWIND_STRICT (writev, frame, op_ret, op_errno, prebuf, postbuf,
+                             xdata);
+        dc_local_wipe (local);
+        return 0;
+}
+
+int32_t
+dc_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
+           struct iovec *vector, int32_t count, off_t offset, uint32_t flags,
+           struct iobref *iobref, dict_t *xdata)
+{
+        dc_priv_t  *priv  = NULL;
+        dc_local_t *local = NULL;
+
+        priv = this->private;
+
+        if (!priv->enabled)
+                goto wind;
+
+        local = mem_get0 (this->local_pool);
+        if (!local)
+                goto wind;
+
+        local->fd = fd_ref (fd);
+        local->offset = offset;
+
+        /* the data stays valid as long as its iobref is held */
+        if ((priv->mode == DC_WRITE_THROUGH) && iobref) {
+                local->vector = iov_dup (vector, count);
+                local->count = count;
+                if (local->vector)
+                        local->iobref = iobref_ref (iobref);
+        }
+
+        frame->local = local;
+
+wind:
+        STACK_WIND (frame, dc_writev_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->writev, fd, vector, count,
+                    offset, flags, iobref, xdata);
+        return 0;
+}
+
+int32_t
+dc_fstat_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, struct iatt *buf,
+              dict_t *xdata)
+{
+        dc_local_t *local = NULL;
+
+        local = frame->local;
+        frame->local = NULL;
+
+        if ((op_ret == 0) && local)
+                dc_inode_update (this, local->fd->inode, buf);
+
+        STACK_UNWIND_STRICT (fstat, frame, op_ret, op_errno, buf, xdata);
+        dc_local_wipe (local);
+        return 0;
+}
+
+int32_t
+dc_fstat (call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
+{
+        dc_local_t *local = NULL;
+
+        local = mem_get0 (this->local_pool);
+        if (local) {
+                local->fd = fd_ref (fd);
+                frame->local = local;
+        }
+
+        STACK_WIND (frame, dc_fstat_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fstat, fd, xdata);
+        return 0;
+}
+
+/* the fops below change the file, the next read revalidates it */
+
+int32_t
+dc_truncate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                 struct iatt *postbuf, dict_t *xdata)
+{
+        inode_t *inode = cookie;
+
+        if (op_ret == 0)
+                dc_inode_update (this, inode, postbuf);
+        else
+                dc_inode_invalidate (this, inode);
+
+        STACK_UNWIND_STRICT (truncate, frame, op_ret, op_errno, prebuf,
+                             postbuf, xdata);
+        return 0;
+}
+
+int32_t
+dc_truncate (call_frame_t *frame, xlator_t *this, loc_t *loc, off_t offset,
+             dict_t *xdata)
+{
+        STACK_WIND_COOKIE (frame, dc_truncate_cbk, loc->inode,
+                           FIRST_CHILD (this),
+                           FIRST_CHILD (this)->fops->truncate, loc, offset,
+                           xdata);
+        return 0;
+}
+
+int32_t
+dc_ftruncate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                  struct iatt *postbuf, dict_t *xdata)
+{
+        inode_t *inode = cookie;
+
+        if (op_ret == 0)
+                dc_inode_update (this, inode, postbuf);
+        else
+                dc_inode_invalidate (this, inode);
+
+        STACK_UNWIND_STRICT (ftruncate, frame, op_ret, op_errno, prebuf,
+                             postbuf, xdata);
+        return 0;
+}
+
+int32_t
+dc_ftruncate (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+              dict_t *xdata)
+{
+        STACK_WIND_COOKIE (frame, dc_ftruncate_cbk, fd->inode,
+                           FIRST_CHILD (this),
+                           FIRST_CHILD (this)->fops->ftruncate, fd, offset,
+                           xdata);
+        return 0;
+}
+
+int32_t
+dc_fallocate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                  struct iatt *postbuf, dict_t *xdata)
+{
+        inode_t *inode = cookie;
+
+        /* the cached blocks of the range are stale either way */
+        dc_inode_invalidate (this, inode);
+
+        STACK_UNWIND_STRICT (fallocate, frame, op_ret, op_errno, prebuf,
+                             postbuf, xdata);
+        return 0;
+}
+
+int32_t
+dc_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t keep_size,
+              off_t offset, size_t len, dict_t *xdata)
+{
+        STACK_WIND_COOKIE (frame, dc_fallocate_cbk, fd->inode,
+                           FIRST_CHILD (this),
+                           FIRST_CHILD (this)->fops->fallocate, fd,
+                           keep_size, offset, len, xdata);
+        return 0;
+}
+
+int32_t
+dc_discard_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                struct iatt *postbuf, dict_t *xdata)
+{
+        inode_t *inode = cookie;
+
+        dc_inode_invalidate (this, inode);
+
+        STACK_UNWIND_STRICT (discard, frame, op_ret, op_errno, prebuf,
+                             postbuf, xdata);
+        return 0;
+}
+
+int32_t
+dc_discard (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+            size_t len, dict_t *xdata)
+{
+        STACK_WIND_COOKIE (frame, dc_discard_cbk, fd->inode,
+                           FIRST_CHILD (this),
+                           FIRST_CHILD (this)->fops->discard, fd, offset, len,
+                           xdata);
+        return 0;
+}
+
+int32_t
+dc_zerofill_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                 struct iatt *postbuf, dict_t *xdata)
+{
+        inode_t *inode = cookie;
+
+        dc_inode_invalidate (this, inode);
+
+        STACK_UNWIND_STRICT (zerofill, frame, op_ret, op_errno, prebuf,
+                             postbuf, xdata);
+        return 0;
+}
+
+int32_t
+dc_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+             off_t len, dict_t *xdata)
+{
+        STACK_WIND_COOKIE (frame, dc_zerofill_cbk, fd->inode,
+                           FIRST_CHILD (this),
+                           FIRST_CHILD (this)->fops->zerofill, fd, offset, len,
+                           xdata);
+        return 0;
+}
+
+int32_t
+dc_setattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, struct iatt *statpre,
+                struct iatt *statpost, dict_t *xdata)
+{
+        if (op_ret == 0)
+                dc_inode_update (this, cookie, statpost);
+
+        STACK_UNWIND_STRICT (setattr, frame, op_ret, op_errno, statpre,
+                             statpost, xdata);
+        return 0;
+}
+
+int32_t
+dc_setattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
+            struct iatt *stbuf, int32_t valid, dict_t *xdata)
+{
+        STACK_WIND_COOKIE (frame, dc_setattr_cbk, loc->inode,
+                           FIRST_CHILD (this),
+                           FIRST_CHILD (this)->fops->setattr, loc, stbuf,
+                           valid, xdata);
+        return 0;
+}
+
+int32_t
+dc_fsetattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *statpre,
+                 struct iatt *statpost, dict_t *xdata)
+{
+        if (op_ret == 0)
+                dc_inode_update (this, cookie, statpost);
+
+        STACK_UNWIND_STRICT (fsetattr, frame, op_ret, op_errno, statpre,
+                             statpost, xdata);
+        return 0;
+}
+
+int32_t
+dc_fsetattr (call_frame_t *frame, xlator_t *this, fd_t *fd,
+             struct iatt *stbuf, int32_t valid, dict_t *xdata)
+{
+        STACK_WIND_COOKIE (frame, dc_fsetattr_cbk, fd->inode,
+                           FIRST_CHILD (this),
+                           FIRST_CHILD (this)->fops->fsetattr, fd, stbuf,
+                           valid, xdata);
+        return 0;
+}
+
+int32_t
+dc_open (call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
+         fd_t *fd, dict_t *xdata)
+{
+        if (flags & O_TRUNC)
+                dc_inode_invalidate (this, loc->inode);
+
+        STACK_WIND (frame, default_open_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->open, loc, flags, fd, xdata);
+        return 0;
+}
+
+int32_t
+dc_forget (xlator_t *this, inode_t *inode)
+{
+        dc_inode_t *ctx   = NULL;
+        uint64_t    value = 0;
+
+        inode_ctx_del (inode, this, &value);
+        if (!value)
+                return 0;
+
+        ctx = (dc_inode_t *)(long) value;
+        LOCK_DESTROY (&ctx->lock);
+        GF_FREE (ctx);
+
+        return 0;
+}
+
+int32_t
+dc_priv_dump (xlator_t *this)
+{
+        dc_priv_t *priv = NULL;
+        char       key_prefix[GF_DUMP_MAX_BUF_LEN];
+
+        priv = this->private;
+        if (!priv)
+                return 0;
+
+        gf_proc_dump_build_key (key_prefix, "xlator.performance.disk-cache",
+                                "priv");
+        gf_proc_dump_add_section (key_prefix);
+
+        LOCK (&priv->lock);
+        {
+                gf_proc_dump_write ("cache_dir", "%s", priv->cache_dir);
+                gf_proc_dump_write ("enabled", "%d", priv->enabled);
+                gf_proc_dump_write ("mode", "%s",
+                                    (priv->mode == DC_WRITE_THROUGH) ?
+                                    "write-through" : "write-around");
+                gf_proc_dump_write ("block_size", "%"PRIu64,
+                                    priv->block_size);
+                gf_proc_dump_write ("cache_size", "%"PRIu64,
+                                    priv->cache_size);
+                gf_proc_dump_write ("cache_used", "%"PRIu64,
+                                    priv->cache_used);
+                gf_proc_dump_write ("files", "%"PRIu64, priv->entry_count);
+                gf_proc_dump_write ("hits", "%"PRIu64, priv->hits);
+                gf_proc_dump_write ("misses", "%"PRIu64, priv->misses);
+                gf_proc_dump_write ("hit_bytes", "%"PRIu64, priv->hit_bytes);
+                gf_proc_dump_write ("miss_bytes", "%"PRIu64,
+                                    priv->miss_bytes);
+                gf_proc_dump_write ("blocks_written", "%"PRIu64,
+                                    priv->blocks_written);
+                gf_proc_dump_write ("invalidations", "%"PRIu64,
+                                    priv->invalidations);
+                gf_proc_dump_write ("evictions", "%"PRIu64, priv->evictions);
+                gf_proc_dump_write ("errors", "%"PRIu64, priv->errors);
+        }
+        UNLOCK (&priv->lock);
+
+        return 0;
+}
+
+/* ----------------------------------------------------------------------
+ * setup
+ */
+
+struct dc_scan_item {
+        time_t      mtime;
+        dc_entry_t *entry;
+};
+
+static int
+dc_scan_cmp (const void *a, const void *b)
+{
+        const struct dc_scan_item *x = a;
+        const struct dc_scan_item *y = b;
+
+        return (x->mtime > y->mtime) - (x->mtime < y->mtime);
+}
+
+/* size of the blocks of a cached file, -1 if it has no valid meta */
+static int64_t
+dc_scan_entry (dc_priv_t *priv, const char *dir, uuid_t gfid,
+               dc_meta_t *meta, time_t *mtime)
+{
+        char           path[PATH_MAX] = {0, };
+        DIR           *dirp           = NULL;
+        struct dirent *dentry         = NULL;
+        struct stat    st             = {0, };
+        int64_t        bytes          = 0;
+
+        if (dc_meta_read (priv, gfid, meta) ||
+            (meta->block_size != priv->block_size))
+                return -1;
+
+        dirp = opendir (dir);
+        if (!dirp)
+                return -1;
+
+        while ((dentry = readdir (dirp)) != NULL) {
+                if (dentry->d_name[0] == '.')
+                        continue;
+
+                snprintf (path, sizeof (path), "%s/%s", dir, dentry->d_name);
+                if (lstat (path, &st))
+                        continue;
+
+                if (!strcmp (dentry->d_name, "meta"))
+                        *mtime = st.st_mtime;
+                else
+                        bytes += st.st_size;
+        }
+        closedir (dirp);
+
+        return bytes;
+}
+
+/* pick up the files cached by earlier mounts, oldest first in the lru */
+static int
+dc_cache_scan (xlator_t *this)
+{
+        dc_priv_t           *priv   = NULL;
+        dc_entry_t          *entry  = NULL;
+        struct dc_scan_item *items  = NULL;
+        struct dc_scan_item *tmp    = NULL;
+        DIR                 *dirp   = NULL;
+        struct dirent       *dentry = NULL;
+        char                 sub[PATH_MAX] = {0, };
+        char                 dir[PATH_MAX] = {0, };
+        dc_meta_t            meta   = {0, };
+        uuid_t               gfid   = {0, };
+        time_t               mtime  = 0;
+        int64_t              bytes  = 0;
+        size_t               count  = 0;
+        size_t               alloc  = 0;
+        size_t               i      = 0;
+        int                  n      = 0;
+
+        priv = this->private;
+
+        for (n = 0; n < 256; n++) {
+                snprintf (sub, sizeof (sub), "%s/%02x", priv->cache_dir, n);
+                if (mkdir (sub, 0700) && (errno != EEXIST))
+                        return -1;
+
+                dirp = opendir (sub);
+                if (!dirp)
+                        return -1;
+
+                while ((dentry = readdir (dirp)) != NULL) {
+                        if (dentry->d_name[0] == '.')
+                                continue;
+
+                        if (uuid_parse (dentry->d_name, gfid))
+                                continue;
+
+                        snprintf (dir, sizeof (dir), "%s/%s", sub,
+                                  dentry->d_name);
+
+                        mtime = 0;
+                        bytes = dc_scan_entry (priv, dir, gfid, &meta,
+                                               &mtime);
+
+                        entry = __dc_entry_new (priv, gfid);
+                        if (!entry)
+                                break;
+
+                        if (bytes < 0) {
+                                /* left over of an incomplete entry */
+                                dc_entry_wipe (priv, entry, _gf_true);
+                                list_del_init (&entry->hash);
+                                list_del_init (&entry->lru);
+                                priv->entry_count--;
+                                dc_entry_free (entry);
+                                continue;
+                        }
+
+                        entry->meta = meta;
+                        entry->meta_valid = _gf_true;
+                        entry->bytes = bytes;
+                        priv->cache_used += bytes;
+
+                        if (count == alloc) {
+                                alloc = alloc ? alloc * 2 : 1024;
+                                tmp = GF_REALLOC (items,
+                                                  alloc * sizeof (*items));
+                                if (!tmp)
+                                        break;
+                                items = tmp;
+                        }
+                        items[count].mtime = mtime;
+                        items[count].entry = entry;
+                        count++;
+                }
+                closedir (dirp);
+        }
+
+        if (items) {
+                qsort (items, count, sizeof (*items), dc_scan_cmp);
+                for (i = 0; i < count; i++)
+                        list_move_tail (&items[i].entry->lru, &priv->lru);
+                GF_FREE (items);
+        }
+
+        gf_log (this->name, GF_LOG_INFO,
+                "found %"PRIu64" cached files using %"PRIu64" bytes in %s",
+                priv->entry_count, priv->cache_used, priv->cache_dir);
+
+        return 0;
+}
+
+static int
+dc_set_mode (dc_priv_t *priv, char *mode)
+{
+        if (!strcmp (mode, "write-through"))
+                priv->mode = DC_WRITE_THROUGH;
+        else if (!strcmp (mode, "write-around"))
+                priv->mode = DC_WRITE_AROUND;
+        else
+                return -1;
+
+        return 0;
+}
+
+/*
+ * Take the cache directory for this process. A directory already used by
+ * another mount of the volume leaves the xlator as a pass-through.
+ */
+static void
+dc_cache_open (xlator_t *this, char *cache_dir)
+{
+        dc_priv_t *priv           = NULL;
+        char       path[PATH_MAX] = {0, };
+        int        ret            = -1;
+
+        priv = this->private;
+
+        ret = gf_asprintf (&priv->cache_dir, "%s/%s", cache_dir, this->name);
+        if (ret < 0) {
+                priv->cache_dir = NULL;
+                return;
+        }
+
+        ret = mkdir_p (priv->cache_dir, 0700, _gf_true);
+        if (ret) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "cannot create %s (%s), disk cache disabled",
+                        priv->cache_dir, strerror (errno));
+                return;
+        }
+
+        snprintf (path, sizeof (path), "%s/"DC_LOCK_FILE, priv->cache_dir);
+        priv->lock_fd = open (path, O_CREAT|O_RDWR, 0600);
+        if (priv->lock_fd == -1 || flock (priv->lock_fd, LOCK_EX|LOCK_NB)) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "%s is in use by another process, disk cache "
+                        "disabled", priv->cache_dir);
+                return;
+        }
+
+        if (dc_cache_scan (this)) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "cannot read %s (%s), disk cache disabled",
+                        priv->cache_dir, strerror (errno));
+                return;
+        }
+
+        priv->enabled = _gf_true;
+
+        if (priv->cache_used > priv->cache_size)
+                dc_cache_prune (this);
+}
+
+int32_t
+mem_acct_init (xlator_t *this)
+{
+        int ret = -1;
+
+        if (!this)
+                return ret;
+
+        ret = xlator_mem_acct_init (this, gf_dc_mt_end + 1);
+        if (ret != 0)
+                gf_log (this->name, GF_LOG_ERROR,
+                        "Memory accounting init failed");
+
+        return ret;
+}
+
+int
+reconfigure (xlator_t *this, dict_t *options)
+{
+        dc_priv_t    *priv  = NULL;
+        char         *mode  = NULL;
+        gf_boolean_t  prune = _gf_false;
+        int           ret   = -1;
+
+        priv = this->private;
+
+        GF_OPTION_RECONF ("cache-timeout", priv->cache_timeout, options,
+                          int32, out);
+
+        GF_OPTION_RECONF ("cache-mode", mode, options, str, out);
+        if (dc_set_mode (priv, mode)) {
+                gf_log (this->name, GF_LOG_ERROR, "invalid cache-mode %s",
+                        mode);
+                goto out;
+        }
+
+        GF_OPTION_RECONF ("cache-size", priv->cache_size, options, size,
+                          out);
+
+        LOCK (&priv->lock);
+        {
+                prune = priv->enabled &&
+                        (priv->cache_used > priv->cache_size);
+        }
+        UNLOCK (&priv->lock);
+
+        if (prune)
+                dc_cache_prune (this);
+
+        ret = 0;
+out:
+        return ret;
+}
+
+int
+init (xlator_t *this)
+{
+        dc_priv_t *priv      = NULL;
+        char      *cache_dir = NULL;
+        char      *mode      = NULL;
+        int        i         = 0;
+
+        GF_VALIDATE_OR_GOTO ("disk-cache", this, err);
+
+        if (!this->children || this->children->next) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "FATAL: disk-cache not configured with exactly one "
+                        "child");
+                goto err;
+        }
+
+        if (!this->parents) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "dangling volume. check volfile ");
+        }
+
+        priv = GF_CALLOC (1, sizeof (*priv), gf_dc_mt_dc_priv_t);
+        if (!priv)
+                goto err;
+
+        LOCK_INIT (&priv->lock);
+        INIT_LIST_HEAD (&priv->lru);
+        for (i = 0; i < DC_HASH_BUCKETS; i++)
+                INIT_LIST_HEAD (&priv->hash[i]);
+        priv->lock_fd = -1;
+        this->private = priv;
+
+        this->local_pool = mem_pool_new (dc_local_t, 64);
+        if (!this->local_pool) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "failed to create local_t's memory pool");
+                goto err;
+        }
+
+        GF_OPTION_INIT ("block-size", priv->block_size, size, err);
+        GF_OPTION_INIT ("cache-size", priv->cache_size, size, err);
+        GF_OPTION_INIT ("cache-timeout", priv->cache_timeout, int32, err);
+
+        GF_OPTION_INIT ("cache-mode", mode, str, err);
+        if (dc_set_mode (priv, mode)) {
+                gf_log (this->name, GF_LOG_ERROR, "invalid cache-mode %s",
+                        mode);
+                goto err;
+        }
+
+        GF_OPTION_INIT ("cache-dir", cache_dir, path, err);
+        dc_cache_open (this, cache_dir);
+
+        return 0;
+
+err:
+        if (this && this->local_pool) {
+                mem_pool_destroy (this->local_pool);
+                this->local_pool = NULL;
+        }
+        if (priv) {
+                if (priv->lock_fd != -1)
+                        close (priv->lock_fd);
+                GF_FREE (priv->cache_dir);
+                LOCK_DESTROY (&priv->lock);
+                GF_FREE (priv);
+        }
+        if (this)
+                this->private = NULL;
+
+        return -1;
+}
+
+void
+fini (xlator_t *this)
+{
+        dc_priv_t  *priv  = NULL;
+        dc_entry_t *entry = NULL;
+        dc_entry_t *tmp   = NULL;
+
+        GF_VALIDATE_OR_GOTO ("disk-cache", this, out);
+
+        priv = this->private;
+        if (!priv)
+                goto out;
+
+        this->private = NULL;
+
+        list_for_each_entry_safe (entry, tmp, &priv->lru, lru) {
+                list_del_init (&entry->lru);
+                list_del_init (&entry->hash);
+                dc_entry_free (entry);
+        }
+
+        if (priv->lock_fd != -1)
+                close (priv->lock_fd);
+        GF_FREE (priv->cache_dir);
+        LOCK_DESTROY (&priv->lock);
+        GF_FREE (priv);
+out:
+        return;
+}
+
+struct xlator_fops fops = {
+        .lookup      = dc_lookup,
+        .open        = dc_open,
+        .readv       = dc_readv,
+        .writev      = dc_writev,
+        .fstat       = dc_fstat,
+        .truncate    = dc_truncate,
+        .ftruncate   = dc_ftruncate,
+        .fallocate   = dc_fallocate,
+        .discard     = dc_discard,
+        .zerofill    = dc_zerofill,
+        .setattr     = dc_setattr,
+        .fsetattr    = dc_fsetattr,
+};
+
+struct xlator_cbks cbks = {
+        .forget      = dc_forget,
+};
+
+struct xlator_dumpops dumpops = {
+        .priv        = dc_priv_dump,
+};
+
+struct volume_options options[] = {
+        { .key = {"cache-dir"},
+          .type = GF_OPTION_TYPE_PATH,
+          .default_value = "/var/cache/glusterfs",
+          .description = "Local directory to keep the cached blocks in, "
+                         "below a subdirectory named after the xlator.",
+        },
+        { .key = {"cache-size"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .min = 0,
+          .max = 16 * GF_UNIT_TB,
+          .default_value = "10GB",
+          .description = "Maximum space the cached blocks may take.",
+        },
+        { .key = {"block-size"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .min = 4 * GF_UNIT_KB,
+          .max = 1 * GF_UNIT_MB,
+          .default_value = "128KB",
+          .description = "Unit in which file content is cached. Changing "
+                         "it drops the content cached with the old size.",
+        },
+        { .key = {"cache-mode"},
+          .type = GF_OPTION_TYPE_STR,
+          .default_value = "write-around",
+          .value = { "write-around", "write-through" },
+          .description = "write-around drops the cached blocks of a file "
+                         "when it is written, write-through updates them "
+                         "with the written data.",
+        },
+        { .key = {"cache-timeout"},
+          .type = GF_OPTION_TYPE_INT,
+          .min = 0,
+          .max = 60,
+          .default_value = "1",
+          .description = "Seconds the attributes of a file are trusted "
+                         "before a read revalidates them with the server.",
+        },
+        { .key = {NULL} },
+};
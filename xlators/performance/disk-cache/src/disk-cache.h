@@ -0,0 +1,123 @@
+/*
+  Copyright (c) 2012 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#ifndef __DISK_CACHE_H
+#define __DISK_CACHE_H
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include <pthread.h>
+
+#include "glusterfs.h"
+#include "logging.h"
+#include "dict.h"
+#include "xlator.h"
+#include "list.h"
+#include "iobuf.h"
+#include "defaults.h"
+#include "disk-cache-mem-types.h"
+
+/*
+ * On disk layout below <cache-dir>/<xlator name>:
+ *
+ *   <gfid[0] in hex>/<gfid>/meta     identity of the cached file version
+ *   <gfid[0] in hex>/<gfid>/<block>  content of block number <block> (hex)
+ *
+ * A block holds block-size bytes, only the last block of a file is shorter.
+ * Blocks are valid as long as meta matches the gfid, size, mtime and ctime
+ * of the file, so the cache survives remounts.
+ */
+
+#define DC_META_MAGIC           0x44434d31      /* "DCM1" */
+#define DC_HASH_BUCKETS         4096
+#define DC_LOCK_FILE            ".lock"
+
+typedef enum {
+        DC_WRITE_AROUND = 0,
+        DC_WRITE_THROUGH,
+} dc_mode_t;
+
+struct dc_meta {
+        uint32_t        magic;
+        uint32_t        block_size;
+        uuid_t          gfid;
+        uint64_t        size;
+        uint32_t        mtime;
+        uint32_t        mtime_nsec;
+        uint32_t        ctime;
+        uint32_t        ctime_nsec;
+};
+typedef struct dc_meta dc_meta_t;
+
+/* one file with content in the cache */
+struct dc_entry {
+        uuid_t            gfid;
+        dc_meta_t         meta;
+        gf_boolean_t      meta_valid;  /* meta exists on disk */
+        gf_boolean_t      evicted;     /* removed, free on last put */
+        uint64_t          bytes;       /* size of the blocks on disk */
+        int32_t           ref;
+        pthread_rwlock_t  rwlock;      /* write locked to change files */
+        struct list_head  hash;
+        struct list_head  lru;
+};
+typedef struct dc_entry dc_entry_t;
+
+/* inode ctx, the latest attributes seen for the file */
+struct dc_inode {
+        struct iatt     stbuf;
+        struct timeval  tv;            /* when stbuf was refreshed */
+        gf_lock_t       lock;
+};
+typedef struct dc_inode dc_inode_t;
+
+struct dc_local {
+        fd_t           *fd;
+        size_t          size;          /* as requested */
+        off_t           offset;
+        uint32_t        flags;
+        off_t           aligned_offset;
+        struct iovec   *vector;        /* write-through data */
+        int32_t         count;
+        struct iobref  *iobref;
+        dict_t         *xdata;
+};
+typedef struct dc_local dc_local_t;
+
+struct dc_priv {
+        char             *cache_dir;    /* <cache-dir>/<xlator name> */
+        int               lock_fd;
+        gf_boolean_t      enabled;
+        dc_mode_t         mode;
+        uint64_t          block_size;
+        uint64_t          cache_size;
+        uint64_t          cache_used;
+        int32_t           cache_timeout;
+        uint64_t          entry_count;
+        struct list_head  hash[DC_HASH_BUCKETS];
+        struct list_head  lru;          /* least recently used first */
+        gf_lock_t         lock;
+
+        /* statistics */
+        uint64_t          hits;
+        uint64_t          misses;
+        uint64_t          hit_bytes;
+        uint64_t          miss_bytes;
+        uint64_t          blocks_written;
+        uint64_t          invalidations;
+        uint64_t          evictions;
+        uint64_t          errors;
+};
+typedef struct dc_priv dc_priv_t;
+
+#endif /* __DISK_CACHE_H */
@@ -23,59 +23,267 @@
 #include <sys/time.h>
 #include <time.h>
 #include "locking.h"
+#ifdef GF_LINUX_HOST_OS
+#include <sched.h>
+#endif
 
 void *iot_worker (void *arg);
-int iot_workers_scale (iot_conf_t *conf);
-int __iot_workers_scale (iot_conf_t *conf);
+int iot_workers_scale (iot_conf_t *conf, int queue);
+int __iot_workers_scale (iot_conf_t *conf, int queue);
 struct volume_options options[];
 
+static uint64_t
+iot_tv_usec_since (struct timeval *then)
+{
+        struct timeval now = {0, };
+
+        gettimeofday (&now, NULL);
+
+        if ((now.tv_sec < then->tv_sec) ||
+            ((now.tv_sec == then->tv_sec) && (now.tv_usec < then->tv_usec)))
+                return 0;
+
+        return ((now.tv_sec - then->tv_sec) * 1000000ULL)
+                + now.tv_usec - then->tv_usec;
+}
+
+
+/* requests are queued fairly between the clients this tells apart */
+static uint64_t
+iot_client_key (iot_conf_t *conf, call_frame_t *frame)
+{
+        if (!conf->fair_by_uid && frame->root->trans)
+                return (uint64_t)(long) frame->root->trans;
+
+        return frame->root->uid;
+}
+
+
+static uint64_t
+iot_client_hash (uint64_t key)
+{
+        /* spread connection pointers and uids over the queues and slots */
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+
+        return key;
+}
+
+
 call_stub_t *
-__iot_dequeue (iot_conf_t *conf, int *pri)
+__iot_dequeue (iot_conf_t *conf, iot_queue_t *queue, int *pri)
 {
         call_stub_t  *stub = NULL;
+        iot_client_t *client = NULL;
+        uint64_t      wait = 0;
         int           i = 0;
 
         *pri = -1;
-        for (i = 0; i < IOT_PRI_MAX; i++) {
-                if (list_empty (&conf->reqs[i]) ||
-                   (conf->ac_iot_count[i] >= conf->ac_iot_limit[i]))
-                        continue;
-                stub = list_entry (conf->reqs[i].next, call_stub_t, list);
-                conf->ac_iot_count[i]++;
-                *pri = i;
-                break;
+        if (queue->queue_size == 0)
+                return NULL;
+
+        LOCK (&conf->ac_lock);
+        {
+                for (i = 0; i < IOT_PRI_MAX; i++) {
+                        if (list_empty (&queue->active[i]) ||
+                            (conf->ac_iot_count[i] >= conf->ac_iot_limit[i]))
+                                continue;
+                        conf->ac_iot_count[i]++;
+                        *pri = i;
+                        break;
+                }
         }
+        UNLOCK (&conf->ac_lock);
 
-        if (!stub)
+        if (*pri == -1)
                 return NULL;
 
-        conf->queue_size--;
-        conf->queue_sizes[*pri]--;
+        client = list_entry (queue->active[*pri].next, iot_client_t, active);
+        stub = list_entry (client->reqs.next, call_stub_t, list);
         list_del_init (&stub->list);
 
+        /* the client goes behind the others waiting in this class */
+        list_del_init (&client->active);
+        if (!list_empty (&client->reqs))
+                list_add_tail (&client->active, &queue->active[*pri]);
+
+        queue->queue_size--;
+        queue->queue_sizes[*pri]--;
+
+        wait = iot_tv_usec_since (&stub->queued);
+        client->dequeued++;
+        client->wait_usec += wait;
+        queue->dequeued[*pri]++;
+        queue->wait_usec[*pri] += wait;
+        if (wait > queue->max_wait_usec[*pri])
+                queue->max_wait_usec[*pri] = wait;
+
         return stub;
 }
 
 
 void
-__iot_enqueue (iot_conf_t *conf, call_stub_t *stub, int pri)
+__iot_enqueue (iot_queue_t *queue, call_stub_t *stub, int pri, uint64_t key,
+               int slot)
 {
+        iot_client_t *client = NULL;
+
         if (pri < 0 || pri >= IOT_PRI_MAX)
                 pri = IOT_PRI_MAX-1;
 
-        list_add_tail (&stub->list, &conf->reqs[pri]);
+        client = &queue->clients[pri][slot];
+        client->key = key;
+
+        gettimeofday (&stub->queued, NULL);
+        list_add_tail (&stub->list, &client->reqs);
+        if (list_empty (&client->active))
+                list_add_tail (&client->active, &queue->active[pri]);
 
-        conf->queue_size++;
-        conf->queue_sizes[pri]++;
+        queue->queue_size++;
+        queue->queue_sizes[pri]++;
 
         return;
 }
 
 
+void
+iot_pri_done (iot_conf_t *conf, int pri)
+{
+        if (pri == -1)
+                return;
+
+        LOCK (&conf->ac_lock);
+        {
+                conf->ac_iot_count[pri]--;
+        }
+        UNLOCK (&conf->ac_lock);
+}
+
+
+/* Unlocked peek: does another queue hold requests a worker could take? */
+int
+iot_queues_pending (iot_conf_t *conf, int home)
+{
+        iot_queue_t *queue = NULL;
+        int          i = 0;
+        int          pri = 0;
+
+        for (i = 0; i < conf->queue_count; i++) {
+                if (i == home)
+                        continue;
+
+                queue = &conf->queues[i];
+                for (pri = 0; pri < IOT_PRI_MAX; pri++) {
+                        if (queue->queue_sizes[pri] &&
+                            (conf->ac_iot_count[pri] <
+                             conf->ac_iot_limit[pri]))
+                                return 1;
+                }
+        }
+
+        return 0;
+}
+
+
+call_stub_t *
+iot_steal (iot_conf_t *conf, int home, int *pri)
+{
+        iot_queue_t *queue = NULL;
+        call_stub_t *stub = NULL;
+        int          i = 0;
+
+        *pri = -1;
+        for (i = 1; i < conf->queue_count; i++) {
+                queue = &conf->queues[(home + i) % conf->queue_count];
+                if (queue->queue_size == 0)
+                        continue;
+
+                pthread_mutex_lock (&queue->mutex);
+                {
+                        stub = __iot_dequeue (conf, queue, pri);
+                }
+                pthread_mutex_unlock (&queue->mutex);
+
+                if (stub)
+                        break;
+        }
+
+        return stub;
+}
+
+
+/* wake a sleeping worker of another queue to steal a new request. A worker
+ * checks the other queues and goes to sleep under the mutex of its own
+ * queue, so sleep_count is only looked at under that mutex: a worker about
+ * to sleep is then either seen sleeping or sees the new request. */
+int
+iot_wake_other (iot_conf_t *conf, int home)
+{
+        iot_queue_t *queue = NULL;
+        int          woken = 0;
+        int          i = 0;
+
+        for (i = 1; (i < conf->queue_count) && !woken; i++) {
+                queue = &conf->queues[(home + i) % conf->queue_count];
+
+                pthread_mutex_lock (&queue->mutex);
+                {
+                        if (queue->sleep_count) {
+                                pthread_cond_signal (&queue->cond);
+                                woken = 1;
+                        }
+                }
+                pthread_mutex_unlock (&queue->mutex);
+        }
+
+        return woken;
+}
+
+
+void
+iot_worker_set_affinity (iot_conf_t *conf, int queue)
+{
+#ifdef GF_LINUX_HOST_OS
+        cpu_set_t cpus;
+        long      ncpus = 0;
+        long      per_queue = 0;
+        long      first = 0;
+        long      i = 0;
+        int       ret = 0;
+
+        if (!conf->cpu_affinity)
+                return;
+
+        /* workers of a queue share a contiguous range of cpus, so with one
+         * queue per node they stay on it */
+        ncpus = sysconf (_SC_NPROCESSORS_ONLN);
+        if (ncpus <= 0)
+                return;
+
+        per_queue = max (ncpus / conf->queue_count, 1);
+        first = (queue * per_queue) % ncpus;
+
+        CPU_ZERO (&cpus);
+        for (i = 0; i < per_queue; i++)
+                CPU_SET ((first + i) % ncpus, &cpus);
+
+        ret = pthread_setaffinity_np (pthread_self (), sizeof (cpus), &cpus);
+        if (ret)
+                gf_log (conf->this->name, GF_LOG_WARNING,
+                        "cannot pin worker of queue %d to cpus %ld-%ld (%s)",
+                        queue, first, (first + per_queue - 1) % ncpus,
+                        strerror (ret));
+#endif
+}
+
+
 void *
 iot_worker (void *data)
 {
+        iot_worker_t     *worker = NULL;
         iot_conf_t       *conf = NULL;
+        iot_queue_t      *queue = NULL;
         xlator_t         *this = NULL;
         call_stub_t      *stub = NULL;
         struct timespec   sleep_till = {0, };
@@ -84,81 +292,112 @@ iot_worker (void *data)
         char              timeout = 0;
         char              bye = 0;
 
-        conf = data;
+        worker = data;
+        conf = worker->conf;
         this = conf->this;
         THIS = this;
+        queue = &conf->queues[worker->queue];
+
+        iot_worker_set_affinity (conf, worker->queue);
 
         for (;;) {
-                sleep_till.tv_sec = time (NULL) + conf->idle_time;
+                timeout = 0;
 
-                pthread_mutex_lock (&conf->mutex);
+                pthread_mutex_lock (&queue->mutex);
                 {
-                        if (pri != -1) {
-                                conf->ac_iot_count[pri]--;
-                                pri = -1;
-                        }
-                        while (conf->queue_size == 0) {
-                                conf->sleep_count++;
-
-                                ret = pthread_cond_timedwait (&conf->cond,
-                                                              &conf->mutex,
-                                                              &sleep_till);
-                                conf->sleep_count--;
-
-                                if (ret == ETIMEDOUT) {
-                                        timeout = 1;
-                                        break;
-                                }
-                        }
-
-                        if (timeout) {
-                                if (conf->curr_count > IOT_MIN_THREADS) {
-                                        conf->curr_count--;
-                                        bye = 1;
-                                        gf_log (conf->this->name, GF_LOG_DEBUG,
-                                                "timeout, terminated. conf->curr_count=%d",
-                                                conf->curr_count);
-                                } else {
-                                        timeout = 0;
+                        stub = __iot_dequeue (conf, queue, &pri);
+                }
+                pthread_mutex_unlock (&queue->mutex);
+
+                if (!stub)
+                        stub = iot_steal (conf, worker->queue, &pri);
+
+                if (!stub) {
+                        pthread_mutex_lock (&queue->mutex);
+                        {
+                                stub = __iot_dequeue (conf, queue, &pri);
+                                if (!stub &&
+                                    !iot_queues_pending (conf, worker->queue)) {
+                                        sleep_till.tv_sec = time (NULL)
+                                                + conf->idle_time;
+                                        queue->sleep_count++;
+                                        ret = pthread_cond_timedwait (
+                                                &queue->cond, &queue->mutex,
+                                                &sleep_till);
+                                        queue->sleep_count--;
+
+                                        if (ret == ETIMEDOUT)
+                                                timeout = 1;
                                 }
                         }
-
-                        stub = __iot_dequeue (conf, &pri);
+                        pthread_mutex_unlock (&queue->mutex);
                 }
-                pthread_mutex_unlock (&conf->mutex);
 
-                if (stub) /* guard against spurious wakeups */
+                if (stub) {
                         call_resume (stub);
+                        iot_pri_done (conf, pri);
+                        continue;
+                }
 
-                if (bye)
-                        break;
-        }
+                if (!timeout)
+                        continue;
 
-        if (pri != -1) {
                 pthread_mutex_lock (&conf->mutex);
                 {
-                        conf->ac_iot_count[pri]--;
+                        if (conf->curr_count > IOT_MIN_THREADS) {
+                                conf->curr_count--;
+                                bye = 1;
+                                gf_log (conf->this->name, GF_LOG_DEBUG,
+                                        "timeout, terminated. conf->curr_count=%d",
+                                        conf->curr_count);
+                        }
                 }
                 pthread_mutex_unlock (&conf->mutex);
+
+                if (bye)
+                        break;
         }
+
+        GF_FREE (worker);
         return NULL;
 }
 
 
 int
-do_iot_schedule (iot_conf_t *conf, call_stub_t *stub, int pri)
+do_iot_schedule (iot_conf_t *conf, call_stub_t *stub, int pri, uint64_t key)
 {
-        int   ret = 0;
+        iot_queue_t *queue = NULL;
+        uint64_t     hash = 0;
+        int          index = 0;
+        int          woken = 0;
+        int          need_more = 0;
+        int          ret = 0;
 
-        pthread_mutex_lock (&conf->mutex);
+        hash = iot_client_hash (key);
+        index = hash % conf->queue_count;
+        queue = &conf->queues[index];
+
+        pthread_mutex_lock (&queue->mutex);
         {
-                __iot_enqueue (conf, stub, pri);
+                __iot_enqueue (queue, stub, pri, key,
+                               (hash / conf->queue_count) % IOT_CLIENT_BUCKETS);
 
-                pthread_cond_signal (&conf->cond);
+                if (queue->sleep_count) {
+                        pthread_cond_signal (&queue->cond);
+                        woken = 1;
+                }
 
-                ret = __iot_workers_scale (conf);
+                need_more = (queue->queue_size > queue->sleep_count);
         }
-        pthread_mutex_unlock (&conf->mutex);
+        pthread_mutex_unlock (&queue->mutex);
+
+        if (!woken)
+                woken = iot_wake_other (conf, index);
+
+        /* the request is queued already, a worker that could not be
+         * started is not an error for it */
+        if (need_more && (conf->curr_count < conf->max_count))
+                iot_workers_scale (conf, index);
 
         return ret;
 }
@@ -210,6 +449,7 @@ iot_schedule (call_frame_t *frame, xlator_t *this, call_stub_t *stub)
         case GF_FOP_STATFS:
         case GF_FOP_READDIR:
         case GF_FOP_READDIRP:
+        case GF_FOP_SEEK:
                 pri = IOT_PRI_HI;
                 break;
 
@@ -247,6 +487,9 @@ iot_schedule (call_frame_t *frame, xlator_t *this, call_stub_t *stub)
         case GF_FOP_XATTROP:
         case GF_FOP_FXATTROP:
         case GF_FOP_RCHECKSUM:
+        case GF_FOP_FALLOCATE:
+        case GF_FOP_DISCARD:
+        case GF_FOP_ZEROFILL:
                 pri = IOT_PRI_LO;
                 break;
 
@@ -261,7 +504,7 @@ iot_schedule (call_frame_t *frame, xlator_t *this, call_stub_t *stub)
                 break;
         }
 out:
-        ret = do_iot_schedule (this->private, stub, pri);
+        ret = do_iot_schedule (conf, stub, pri, iot_client_key (conf, frame));
         gf_log (this->name, GF_LOG_DEBUG, "%s scheduled as %s fop",
                 gf_fop_list[stub->fop], iot_get_pri_meaning (pri));
         return ret;
@@ -426,6 +669,213 @@ out:
 }
 
 
+int
+iot_fallocate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                   int32_t op_ret, int32_t op_errno,
+                   struct iatt *preop, struct iatt *postop, dict_t *xdata)
+{
+        STACK_UNWIND_STRICT (fallocate, frame, op_ret, op_errno, preop, postop,
+                             xdata);
+        return 0;
+}
+
+
+int
+iot_fallocate_wrapper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                       int32_t keep_size, off_t offset, size_t len, dict_t *xdata)
+{
+        STACK_WIND (frame, iot_fallocate_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fallocate, fd, keep_size, offset, len,
+                    xdata);
+        return 0;
+}
+
+
+int
+iot_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+               int32_t keep_size, off_t offset, size_t len, dict_t *xdata)
+{
+        call_stub_t     *stub = NULL;
+        int              ret = -1;
+
+        stub = fop_fallocate_stub (frame, iot_fallocate_wrapper, fd, keep_size, offset, len,
+                                   xdata);
+        if (!stub) {
+                gf_log (this->name, GF_LOG_ERROR, "cannot create fallocate stub"
+                        "(out of memory)");
+                ret = -ENOMEM;
+                goto out;
+        }
+
+        ret = iot_schedule (frame, this, stub);
+
+out:
+        if (ret < 0) {
+                STACK_UNWIND_STRICT (fallocate, frame, -1, -ret, NULL, NULL,
+                                     NULL);
+                if (stub != NULL) {
+                        call_stub_destroy (stub);
+                }
+        }
+        return 0;
+}
+
+
+int
+iot_discard_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno,
+                 struct iatt *preop, struct iatt *postop, dict_t *xdata)
+{
+        STACK_UNWIND_STRICT (discard, frame, op_ret, op_errno, preop, postop,
+                             xdata);
+        return 0;
+}
+
+
+int
+iot_discard_wrapper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                     off_t offset, size_t len, dict_t *xdata)
+{
+        STACK_WIND (frame, iot_discard_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->discard, fd, offset, len,
+                    xdata);
+        return 0;
+}
+
+
+int
+iot_discard (call_frame_t *frame, xlator_t *this, fd_t *fd,
+             off_t offset, size_t len, dict_t *xdata)
+{
+        call_stub_t     *stub = NULL;
+        int              ret = -1;
+
+        stub = fop_discard_stub (frame, iot_discard_wrapper, fd, offset, len,
+                                 xdata);
+        if (!stub) {
+                gf_log (this->name, GF_LOG_ERROR, "cannot create discard stub"
+                        "(out of memory)");
+                ret = -ENOMEM;
+                goto out;
+        }
+
+        ret = iot_schedule (frame, this, stub);
+
+out:
+        if (ret < 0) {
+                STACK_UNWIND_STRICT (discard, frame, -1, -ret, NULL, NULL,
+                                     NULL);
+                if (stub != NULL) {
+                        call_stub_destroy (stub);
+                }
+        }
+        return 0;
+}
+
+
+int
+iot_zerofill_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno,
+                  struct iatt *preop, struct iatt *postop, dict_t *xdata)
+{
+        STACK_UNWIND_STRICT (zerofill, frame, op_ret, op_errno, preop, postop,
+                             xdata);
+        return 0;
+}
+
+
+int
+iot_zerofill_wrapper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                      off_t offset, off_t len, dict_t *xdata)
+{
+        STACK_WIND (frame, iot_zerofill_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->zerofill, fd, offset, len,
+                    xdata);
+        return 0;
+}
+
+
+int
+iot_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd,
+              off_t offset, off_t len, dict_t *xdata)
+{
+        call_stub_t     *stub = NULL;
+        int              ret = -1;
+
+        stub = fop_zerofill_stub (frame, iot_zerofill_wrapper, fd, offset, len,
+                                  xdata);
+        if (!stub) {
+                gf_log (this->name, GF_LOG_ERROR, "cannot create zerofill stub"
+                        "(out of memory)");
+                ret = -ENOMEM;
+                goto out;
+        }
+
+        ret = iot_schedule (frame, this, stub);
+
+out:
+        if (ret < 0) {
+                STACK_UNWIND_STRICT (zerofill, frame, -1, -ret, NULL, NULL,
+                                     NULL);
+                if (stub != NULL) {
+                        call_stub_destroy (stub);
+                }
+        }
+        return 0;
+}
+
+
+int
+iot_seek_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno,
+              off_t offset, dict_t *xdata)
+{
+        STACK_UNWIND_STRICT (seek, frame, op_ret, op_errno, offset,
+                             xdata);
+        return 0;
+}
+
+
+int
+iot_seek_wrapper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                  off_t offset, gf_seek_what_t what, dict_t *xdata)
+{
+        STACK_WIND (frame, iot_seek_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->seek, fd, offset, what,
+                    xdata);
+        return 0;
+}
+
+
+int
+iot_seek (call_frame_t *frame, xlator_t *this, fd_t *fd,
+          off_t offset, gf_seek_what_t what, dict_t *xdata)
+{
+        call_stub_t     *stub = NULL;
+        int              ret = -1;
+
+        stub = fop_seek_stub (frame, iot_seek_wrapper, fd, offset, what,
+                              xdata);
+        if (!stub) {
+                gf_log (this->name, GF_LOG_ERROR, "cannot create seek stub"
+                        "(out of memory)");
+                ret = -ENOMEM;
+                goto out;
+        }
+
+        ret = iot_schedule (frame, this, stub);
+
+out:
+        if (ret < 0) {
+                STACK_UNWIND_STRICT (seek, frame, -1, -ret, 0, NULL);
+                if (stub != NULL) {
+                        call_stub_destroy (stub);
+                }
+        }
+        return 0;
+}
+
+
 int
 iot_access_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                 int32_t op_ret, int32_t op_errno, dict_t *xdata)
@@ -2348,47 +2798,42 @@ out:
 
 
 int
-__iot_workers_scale (iot_conf_t *conf)
+__iot_workers_scale (iot_conf_t *conf, int queue)
 {
-        int       scale = 0;
-        int       diff = 0;
-        pthread_t thread;
-        int       ret = 0;
-        int       i = 0;
-
-        for (i = 0; i < IOT_PRI_MAX; i++)
-                scale += min (conf->queue_sizes[i], conf->ac_iot_limit[i]);
-
-        if (scale < IOT_MIN_THREADS)
-                scale = IOT_MIN_THREADS;
+        iot_worker_t *worker = NULL;
+        pthread_t     thread;
+        int           ret = 0;
 
-        if (scale > conf->max_count)
-                scale = conf->max_count;
+        /* one more worker per request no idle worker was left for, the
+         * new one serves the queue the request went to */
+        if (conf->curr_count >= conf->max_count)
+                return 0;
 
-        if (conf->curr_count < scale) {
-                diff = scale - conf->curr_count;
-        }
+        worker = GF_CALLOC (1, sizeof (*worker), gf_iot_mt_iot_worker_t);
+        if (!worker)
+                return -1;
 
-        while (diff) {
-                diff --;
+        worker->conf = conf;
+        worker->queue = queue;
 
-                ret = pthread_create (&thread, &conf->w_attr, iot_worker, conf);
-                if (ret == 0) {
-                        conf->curr_count++;
-                        gf_log (conf->this->name, GF_LOG_DEBUG,
-                                "scaled threads to %d (queue_size=%d/%d)",
-                                conf->curr_count, conf->queue_size, scale);
-                } else {
-                        break;
-                }
+        ret = pthread_create (&thread, &conf->w_attr, iot_worker, worker);
+        if (ret == 0) {
+                conf->curr_count++;
+                gf_log (conf->this->name, GF_LOG_DEBUG,
+                        "scaled threads to %d (queue %d, queue_size=%d)",
+                        conf->curr_count, queue,
+                        conf->queues[queue].queue_size);
+        } else {
+                GF_FREE (worker);
+                return -1;
         }
 
-        return diff;
+        return 0;
 }
 
 
 int
-iot_workers_scale (iot_conf_t *conf)
+iot_workers_scale (iot_conf_t *conf, int queue)
 {
         int     ret = -1;
 
@@ -2399,7 +2844,7 @@ iot_workers_scale (iot_conf_t *conf)
 
         pthread_mutex_lock (&conf->mutex);
         {
-                ret = __iot_workers_scale (conf);
+                ret = __iot_workers_scale (conf, queue);
         }
         pthread_mutex_unlock (&conf->mutex);
 
@@ -2453,11 +2898,72 @@ mem_acct_init (xlator_t *this)
         return ret;
 }
 
+void
+iot_queue_dump (iot_conf_t *conf, iot_queue_t *queue, int index)
+{
+        iot_client_t  *client = NULL;
+        char           key[GF_DUMP_MAX_BUF_LEN];
+        int            pri = 0;
+        int            slot = 0;
+
+        pthread_mutex_lock (&queue->mutex);
+        {
+                snprintf (key, sizeof (key), "queue[%d].sleep_count", index);
+                gf_proc_dump_write (key, "%d", queue->sleep_count);
+
+                for (pri = 0; pri < IOT_PRI_MAX; pri++) {
+                        snprintf (key, sizeof (key), "queue[%d].%s.queued",
+                                  index, iot_get_pri_meaning (pri));
+                        gf_proc_dump_write (key, "%d",
+                                            queue->queue_sizes[pri]);
+
+                        snprintf (key, sizeof (key), "queue[%d].%s.dequeued",
+                                  index, iot_get_pri_meaning (pri));
+                        gf_proc_dump_write (key, "%"PRIu64,
+                                            queue->dequeued[pri]);
+
+                        if (!queue->dequeued[pri])
+                                continue;
+
+                        snprintf (key, sizeof (key),
+                                  "queue[%d].%s.avg_wait_usec", index,
+                                  iot_get_pri_meaning (pri));
+                        gf_proc_dump_write (key, "%"PRIu64,
+                                            queue->wait_usec[pri] /
+                                            queue->dequeued[pri]);
+
+                        snprintf (key, sizeof (key),
+                                  "queue[%d].%s.max_wait_usec", index,
+                                  iot_get_pri_meaning (pri));
+                        gf_proc_dump_write (key, "%"PRIu64,
+                                            queue->max_wait_usec[pri]);
+
+                        for (slot = 0; slot < IOT_CLIENT_BUCKETS; slot++) {
+                                client = &queue->clients[pri][slot];
+                                if (!client->dequeued)
+                                        continue;
+
+                                snprintf (key, sizeof (key),
+                                          "queue[%d].%s.client[%d]", index,
+                                          iot_get_pri_meaning (pri), slot);
+                                gf_proc_dump_write (key,
+                                        "key=0x%"PRIx64", dequeued=%"PRIu64
+                                        ", avg_wait_usec=%"PRIu64,
+                                        client->key, client->dequeued,
+                                        client->wait_usec / client->dequeued);
+                        }
+                }
+        }
+        pthread_mutex_unlock (&queue->mutex);
+}
+
+
 int
 iot_priv_dump (xlator_t *this)
 {
         iot_conf_t     *conf   =   NULL;
         char           key_prefix[GF_DUMP_MAX_BUF_LEN];
+        int            i = 0;
 
         if (!this)
                 return 0;
@@ -2473,7 +2979,6 @@ iot_priv_dump (xlator_t *this)
 
         gf_proc_dump_write("maximum_threads_count", "%d", conf->max_count);
         gf_proc_dump_write("current_threads_count", "%d", conf->curr_count);
-        gf_proc_dump_write("sleep_count", "%d", conf->sleep_count);
         gf_proc_dump_write("idle_time", "%d", conf->idle_time);
         gf_proc_dump_write("stack_size", "%zd", conf->stack_size);
         gf_proc_dump_write("high_priority_threads", "%d",
@@ -2484,15 +2989,37 @@ iot_priv_dump (xlator_t *this)
                            conf->ac_iot_limit[IOT_PRI_LO]);
         gf_proc_dump_write("least_priority_threads", "%d",
                            conf->ac_iot_limit[IOT_PRI_LEAST]);
+        gf_proc_dump_write("queue_count", "%d", conf->queue_count);
+        gf_proc_dump_write("fairness_key", "%s",
+                           conf->fair_by_uid ? "uid" : "connection");
+        gf_proc_dump_write("cpu_affinity", "%d", conf->cpu_affinity);
+
+        for (i = 0; i < conf->queue_count; i++)
+                iot_queue_dump (conf, &conf->queues[i], i);
 
         return 0;
 }
 
+int
+iot_set_fairness_key (iot_conf_t *conf, char *key)
+{
+        if (strcmp (key, "uid") == 0)
+                conf->fair_by_uid = _gf_true;
+        else if (strcmp (key, "connection") == 0)
+                conf->fair_by_uid = _gf_false;
+        else
+                return -1;
+
+        return 0;
+}
+
+
 int
 reconfigure (xlator_t *this, dict_t *options)
 {
 	iot_conf_t      *conf = NULL;
 	int		 ret = -1;
+        char            *fairness_key = NULL;
 
         conf = this->private;
         if (!conf)
@@ -2516,6 +3043,16 @@ reconfigure (xlator_t *this, dict_t *options)
         GF_OPTION_RECONF ("enable-least-priority", conf->least_priority,
                           options, bool, out);
 
+        GF_OPTION_RECONF ("fairness-key", fairness_key, options, str, out);
+        if (iot_set_fairness_key (conf, fairness_key)) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "invalid fairness-key %s", fairness_key);
+                goto out;
+        }
+
+        GF_OPTION_RECONF ("cpu-affinity", conf->cpu_affinity, options, bool,
+                          out);
+
 	ret = 0;
 out:
 	return ret;
@@ -2525,9 +3062,13 @@ out:
 int
 init (xlator_t *this)
 {
-        iot_conf_t *conf = NULL;
-        int         ret  = -1;
-        int         i    = 0;
+        iot_conf_t  *conf  = NULL;
+        iot_queue_t *queue = NULL;
+        char        *fairness_key = NULL;
+        int          ret   = -1;
+        int          i     = 0;
+        int          j     = 0;
+        int          slot  = 0;
 
 	if (!this->children || this->children->next) {
 		gf_log ("io-threads", GF_LOG_ERROR,
@@ -2548,12 +3089,6 @@ init (xlator_t *this)
                 goto out;
         }
 
-        if ((ret = pthread_cond_init(&conf->cond, NULL)) != 0) {
-                gf_log (this->name, GF_LOG_ERROR,
-                        "pthread_cond_init failed (%d)", ret);
-                goto out;
-        }
-
         if ((ret = pthread_mutex_init(&conf->mutex, NULL)) != 0) {
                 gf_log (this->name, GF_LOG_ERROR,
                         "pthread_mutex_init failed (%d)", ret);
@@ -2580,13 +3115,54 @@ init (xlator_t *this)
         GF_OPTION_INIT ("enable-least-priority", conf->least_priority,
                         bool, out);
 
+        GF_OPTION_INIT ("fairness-key", fairness_key, str, out);
+        if (iot_set_fairness_key (conf, fairness_key)) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "invalid fairness-key %s", fairness_key);
+                ret = -1;
+                goto out;
+        }
+
+        GF_OPTION_INIT ("cpu-affinity", conf->cpu_affinity, bool, out);
+
+        GF_OPTION_INIT ("queue-count", conf->queue_count, int32, out);
+
         conf->this = this;
+        LOCK_INIT (&conf->ac_lock);
 
-        for (i = 0; i < IOT_PRI_MAX; i++) {
-                INIT_LIST_HEAD (&conf->reqs[i]);
+        conf->queues = GF_CALLOC (conf->queue_count, sizeof (*conf->queues),
+                                  gf_iot_mt_iot_queue_t);
+        if (conf->queues == NULL) {
+                gf_log (this->name, GF_LOG_ERROR, "out of memory");
+                ret = -1;
+                goto out;
         }
 
-	ret = iot_workers_scale (conf);
+        for (j = 0; j < conf->queue_count; j++) {
+                queue = &conf->queues[j];
+
+                if ((ret = pthread_cond_init(&queue->cond, NULL)) != 0) {
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "pthread_cond_init failed (%d)", ret);
+                        goto out;
+                }
+
+                if ((ret = pthread_mutex_init(&queue->mutex, NULL)) != 0) {
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "pthread_mutex_init failed (%d)", ret);
+                        goto out;
+                }
+
+                for (i = 0; i < IOT_PRI_MAX; i++) {
+                        INIT_LIST_HEAD (&queue->active[i]);
+                        for (slot = 0; slot < IOT_CLIENT_BUCKETS; slot++) {
+                                INIT_LIST_HEAD (&queue->clients[i][slot].reqs);
+                                INIT_LIST_HEAD (&queue->clients[i][slot].active);
+                        }
+                }
+        }
+
+	ret = iot_workers_scale (conf, 0);
 
         if (ret == -1) {
                 gf_log (this->name, GF_LOG_ERROR,
@@ -2597,8 +3173,10 @@ init (xlator_t *this)
 	this->private = conf;
         ret = 0;
 out:
-        if (ret)
+        if (ret && conf) {
+                GF_FREE (conf->queues);
                 GF_FREE (conf);
+        }
 
 	return ret;
 }
@@ -2609,6 +3187,8 @@ fini (xlator_t *this)
 {
 	iot_conf_t *conf = this->private;
 
+        if (conf)
+                GF_FREE (conf->queues);
 	GF_FREE (conf);
 
 	this->private = NULL;
@@ -2661,6 +3241,10 @@ struct xlator_fops fops = {
         .xattrop     = iot_xattrop,
 	.fxattrop    = iot_fxattrop,
         .rchecksum   = iot_rchecksum,
+        .fallocate   = iot_fallocate,
+        .discard     = iot_discard,
+        .zerofill    = iot_zerofill,
+        .seek        = iot_seek,
 };
 
 struct xlator_cbks cbks = {
@@ -2722,6 +3306,28 @@ struct volume_options options[] = {
          .max   = 0x7fffffff,
          .default_value = "120",
         },
+        { .key  = {"queue-count"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = IOT_MIN_QUEUES,
+          .max  = IOT_MAX_QUEUES,
+          .default_value = "4",
+          .description = "Number of request queues, each with its own lock. "
+                         "Workers serve their own queue and take requests "
+                         "from the others when it is empty."
+        },
+        { .key  = {"fairness-key"},
+          .type = GF_OPTION_TYPE_STR,
+          .default_value = "connection",
+          .value = { "connection", "uid" },
+          .description = "Serve the requests of a priority class round "
+                         "robin between client connections or user ids."
+        },
+        { .key  = {"cpu-affinity"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Pin the workers of each queue to their own range "
+                         "of cpus. Applies to workers started afterwards."
+        },
 	{ .key  = {NULL},
         },
 };
@@ -44,6 +44,13 @@ struct iot_conf;
 
 #define IOT_THREAD_STACK_SIZE   ((size_t)(1024*1024))
 
+#define IOT_MIN_QUEUES          1
+#define IOT_DEFAULT_QUEUES      4
+#define IOT_MAX_QUEUES          16
+
+/* clients are hashed into this many round robin slots per priority */
+#define IOT_CLIENT_BUCKETS      32
+
 
 typedef enum {
         IOT_PRI_HI = 0, /* low latency */
@@ -54,24 +61,61 @@ typedef enum {
 } iot_pri_t;
 
 
-struct iot_conf {
+/* requests of one client (or of the clients hashing to the same slot) in
+ * one priority class */
+struct iot_client {
+        struct list_head     reqs;
+        struct list_head     active;      /* in iot_queue.active when queued */
+        uint64_t             key;         /* connection or uid last seen */
+        uint64_t             dequeued;
+        uint64_t             wait_usec;   /* total time spent queued */
+};
+typedef struct iot_client iot_client_t;
+
+/* A queue group with its own lock. Requests of a client always go to the
+ * same group, workers serve their own group first and steal from the
+ * others when it is empty. Inside a priority class the clients with
+ * queued requests are served round robin. */
+struct iot_queue {
         pthread_mutex_t      mutex;
         pthread_cond_t       cond;
+        int32_t              sleep_count;
+        int32_t              queue_size;
+        int32_t              queue_sizes[IOT_PRI_MAX];
+
+        struct list_head     active[IOT_PRI_MAX];
+        iot_client_t         clients[IOT_PRI_MAX][IOT_CLIENT_BUCKETS];
+
+        uint64_t             dequeued[IOT_PRI_MAX];
+        uint64_t             wait_usec[IOT_PRI_MAX];
+        uint64_t             max_wait_usec[IOT_PRI_MAX];
+};
+typedef struct iot_queue iot_queue_t;
+
+struct iot_worker {
+        struct iot_conf     *conf;
+        int32_t              queue;       /* index of the home queue group */
+};
+typedef struct iot_worker iot_worker_t;
+
+struct iot_conf {
+        pthread_mutex_t      mutex;       /* protects the thread counts */
 
         int32_t              max_count;   /* configured maximum */
         int32_t              curr_count;  /* actual number of threads running */
-        int32_t              sleep_count;
 
         int32_t              idle_time;   /* in seconds */
 
-        struct list_head     reqs[IOT_PRI_MAX];
+        iot_queue_t         *queues;
+        int32_t              queue_count;
 
+        gf_lock_t            ac_lock;     /* protects ac_iot_count */
         int32_t              ac_iot_limit[IOT_PRI_MAX];
         int32_t              ac_iot_count[IOT_PRI_MAX];
-        int                  queue_sizes[IOT_PRI_MAX];
-        int                  queue_size;
         pthread_attr_t       w_attr;
         gf_boolean_t         least_priority; /*Enable/Disable least-priority */
+        gf_boolean_t         fair_by_uid;    /* else by connection */
+        gf_boolean_t         cpu_affinity;   /* pin workers of a group */
 
         xlator_t            *this;
         size_t              stack_size;
@@ -0,0 +1,1382 @@
+/*
+  Copyright (c) 2012 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/*
+ * performance/open-behind acknowledges open() locally and keeps the open
+ * call in the fd ctx. Reads and fstat on such an fd are served through an
+ * anonymous fd on the inode, which the server resolves by gfid, so a file
+ * which is opened, read and closed never costs an open/release round-trip
+ * to the bricks.
+ *
+ * The real open is wound the first time a fop needs an fd opened below
+ * (writes, locks, xattr and attribute changes on the fd), when the fd has
+ * been held longer than lazy-open-timeout, or before the file is unlinked
+ * or renamed over, since the anonymous fd can no longer be resolved after
+ * that. Fops which need the open are queued in the fd ctx until the open
+ * returns. A flush on an fd which was never opened below is not wound.
+ *
+ * With lazy-open off the open is wound right away in the background, which
+ * still saves the latency of the open to the application.
+ */
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include "open-behind.h"
+#include "statedump.h"
+
+static ob_fd_t *
+__ob_fd_ctx_get (xlator_t *this, fd_t *fd)
+{
+        uint64_t  value = 0;
+        int       ret   = -1;
+
+        ret = __fd_ctx_get (fd, this, &value);
+        if (ret)
+                return NULL;
+
+        return (ob_fd_t *)(long) value;
+}
+
+
+static ob_fd_t *
+ob_fd_new (void)
+{
+        ob_fd_t *ob_fd = NULL;
+
+        ob_fd = GF_CALLOC (1, sizeof (*ob_fd), gf_ob_mt_ob_fd_t);
+        if (!ob_fd)
+                return NULL;
+
+        INIT_LIST_HEAD (&ob_fd->list);
+
+        return ob_fd;
+}
+
+
+static void
+ob_fd_free (ob_fd_t *ob_fd)
+{
+        loc_wipe (&ob_fd->loc);
+
+        if (ob_fd->xdata)
+                dict_unref (ob_fd->xdata);
+
+        if (ob_fd->open_frame)
+                STACK_DESTROY (ob_fd->open_frame->root);
+
+        GF_FREE (ob_fd);
+}
+
+
+int
+ob_wake_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+             int32_t op_ret, int32_t op_errno, fd_t *fd_ret, dict_t *xdata)
+{
+        fd_t             *fd    = NULL;
+        ob_fd_t          *ob_fd = NULL;
+        call_stub_t      *stub  = NULL;
+        call_stub_t      *tmp   = NULL;
+        struct list_head  list;
+
+        INIT_LIST_HEAD (&list);
+
+        fd = frame->local;
+        frame->local = NULL;
+
+        LOCK (&fd->lock);
+        {
+                ob_fd = __ob_fd_ctx_get (this, fd);
+                list_splice_init (&ob_fd->list, &list);
+
+                if (op_ret < 0) {
+                        /* the fd stays unusable for fops needing it open */
+                        ob_fd->op_errno = op_errno;
+                } else {
+                        __fd_ctx_del (fd, this, NULL);
+                        ob_fd_free (ob_fd);
+                }
+        }
+        UNLOCK (&fd->lock);
+
+        if (op_ret < 0)
+                gf_log (this->name, GF_LOG_WARNING,
+                        "deferred open on gfid %s failed (%s)",
+                        uuid_utoa (fd->inode->gfid), strerror (op_errno));
+
+        /* the queued fops are re-entered and see the new state of the fd */
+        list_for_each_entry_safe (stub, tmp, &list, list) {
+                list_del_init (&stub->list);
+                call_resume (stub);
+        }
+
+        fd_unref (fd);
+
+        STACK_DESTROY (frame->root);
+
+        return 0;
+}
+
+
+/* wind the deferred open of @fd unless it already was */
+static void
+ob_fd_wake (xlator_t *this, fd_t *fd)
+{
+        ob_conf_t    *conf  = NULL;
+        ob_fd_t      *ob_fd = NULL;
+        call_frame_t *frame = NULL;
+
+        conf = this->private;
+
+        LOCK (&fd->lock);
+        {
+                ob_fd = __ob_fd_ctx_get (this, fd);
+                if (ob_fd) {
+                        frame = ob_fd->open_frame;
+                        ob_fd->open_frame = NULL;
+                }
+        }
+        UNLOCK (&fd->lock);
+
+        if (!frame)
+                return;
+
+        LOCK (&conf->lock);
+        {
+                conf->opens_wound++;
+        }
+        UNLOCK (&conf->lock);
+
+        frame->local = fd_ref (fd);
+
+        STACK_WIND (frame, ob_wake_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->open, &ob_fd->loc,
+                    ob_fd->flags, fd, ob_fd->xdata);
+}
+
+
+static ob_fd_state_t
+ob_fd_state (xlator_t *this, fd_t *fd, int32_t *op_errno)
+{
+        ob_fd_t       *ob_fd = NULL;
+        ob_fd_state_t  state = OB_FD_READY;
+
+        LOCK (&fd->lock);
+        {
+                ob_fd = __ob_fd_ctx_get (this, fd);
+                if (ob_fd) {
+                        if (ob_fd->op_errno) {
+                                *op_errno = ob_fd->op_errno;
+                                state = OB_FD_FAILED;
+                        } else {
+                                state = OB_FD_PENDING;
+                        }
+                }
+        }
+        UNLOCK (&fd->lock);
+
+        return state;
+}
+
+
+/* queue @stub behind the open of @fd and make sure that open is wound. The
+ * stub must re-enter the fop of this xlator, which then winds it or fails it
+ * depending on how the open went.
+ */
+static void
+ob_open_and_resume (xlator_t *this, fd_t *fd, call_stub_t *stub)
+{
+        ob_fd_t      *ob_fd  = NULL;
+        gf_boolean_t  queued = _gf_false;
+
+        LOCK (&fd->lock);
+        {
+                ob_fd = __ob_fd_ctx_get (this, fd);
+                if (ob_fd && !ob_fd->op_errno) {
+                        list_add_tail (&stub->list, &ob_fd->list);
+                        queued = _gf_true;
+                }
+        }
+        UNLOCK (&fd->lock);
+
+        if (!queued) {
+                /* the open returned in the meantime */
+                call_resume (stub);
+                return;
+        }
+
+        ob_fd_wake (this, fd);
+}
+
+
+/* an anonymous fd to serve a read-only fop with while the open of @fd is
+ * deferred, NULL when the fop has to go through @fd itself
+ */
+static fd_t *
+ob_anon_fd_get (xlator_t *this, fd_t *fd)
+{
+        ob_conf_t      *conf    = NULL;
+        ob_fd_t        *ob_fd   = NULL;
+        fd_t           *anon_fd = NULL;
+        gf_boolean_t    use     = _gf_false;
+        struct timeval  now     = {0, };
+
+        conf = this->private;
+
+        if (!conf->use_anonymous_fd)
+                return NULL;
+
+        gettimeofday (&now, NULL);
+
+        LOCK (&fd->lock);
+        {
+                ob_fd = __ob_fd_ctx_get (this, fd);
+                if (ob_fd && !ob_fd->op_errno)
+                        use = _gf_true;
+
+                /* held long enough, worth a real open */
+                if (use && conf->lazy_open_timeout &&
+                    (now.tv_sec - ob_fd->tv.tv_sec) >=
+                    conf->lazy_open_timeout)
+                        use = _gf_false;
+        }
+        UNLOCK (&fd->lock);
+
+        if (!use)
+                return NULL;
+
+        anon_fd = fd_anonymous (fd->inode);
+        if (!anon_fd)
+                return NULL;
+
+        LOCK (&conf->lock);
+        {
+                conf->anon_fops++;
+        }
+        UNLOCK (&conf->lock);
+
+        return anon_fd;
+}
+
+
+/* an fd on @inode whose open is still deferred, with a ref */
+static fd_t *
+ob_inode_pending_fd (xlator_t *this, inode_t *inode)
+{
+        fd_t    *iter  = NULL;
+        fd_t    *fd    = NULL;
+        ob_fd_t *ob_fd = NULL;
+
+        LOCK (&inode->lock);
+        {
+                list_for_each_entry (iter, &inode->fd_list, inode_list) {
+                        LOCK (&iter->lock);
+                        {
+                                ob_fd = __ob_fd_ctx_get (this, iter);
+                        }
+                        UNLOCK (&iter->lock);
+
+                        if (ob_fd && !ob_fd->op_errno) {
+                                fd = __fd_ref (iter);
+                                break;
+                        }
+                }
+        }
+        UNLOCK (&inode->lock);
+
+        return fd;
+}
+
+
+int
+ob_open (call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
+         fd_t *fd, dict_t *xdata)
+{
+        ob_conf_t    *conf  = NULL;
+        ob_fd_t      *ob_fd = NULL;
+        int           ret   = -1;
+
+        conf = this->private;
+
+        /* truncation has to happen now, and O_DIRECT must not be served
+           by an anonymous fd opened without it */
+        if (flags & (O_TRUNC | O_DIRECT))
+                goto wind;
+
+        ob_fd = ob_fd_new ();
+        if (!ob_fd)
+                goto wind;
+
+        ob_fd->open_frame = copy_frame (frame);
+        if (!ob_fd->open_frame)
+                goto wind;
+
+        ret = loc_copy (&ob_fd->loc, loc);
+        if (ret)
+                goto wind;
+
+        if (xdata)
+                ob_fd->xdata = dict_ref (xdata);
+        ob_fd->flags = flags;
+        gettimeofday (&ob_fd->tv, NULL);
+
+        ret = fd_ctx_set (fd, this, (uint64_t)(long) ob_fd);
+        if (ret)
+                goto wind;
+
+        LOCK (&conf->lock);
+        {
+                conf->opens_deferred++;
+        }
+        UNLOCK (&conf->lock);
+
+        fd_ref (fd);
+
+        STACK_UNWIND_STRICT (open, frame, 0, 0, fd, NULL);
+
+        if (!conf->lazy_open)
+                ob_fd_wake (this, fd);
+
+        fd_unref (fd);
+
+        return 0;
+
+wind:
+        if (ob_fd)
+                ob_fd_free (ob_fd);
+
+        STACK_WIND (frame, default_open_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->open, loc, flags, fd, xdata);
+        return 0;
+}
+
+
+int
+ob_readv_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, struct iovec *vector,
+              int32_t count, struct iatt *stbuf, struct iobref *iobref,
+              dict_t *xdata)
+{
+        fd_t *anon_fd = cookie;
+
+        STACK_UNWIND_STRICT (readv, frame, op_ret, op_errno, vector, count,
+                             stbuf, iobref, xdata);
+
+        fd_unref (anon_fd);
+        return 0;
+}
+
+
+int
+ob_readv (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+          off_t offset, uint32_t flags, dict_t *xdata)
+{
+        call_stub_t *stub     = NULL;
+        fd_t        *anon_fd  = NULL;
+        int32_t      op_errno = 0;
+
+        anon_fd = ob_anon_fd_get (this, fd);
+        if (anon_fd) {
+                STACK_WIND_COOKIE (frame, ob_readv_cbk, anon_fd,
+                                   FIRST_CHILD (this),
+                                   FIRST_CHILD (this)->fops->readv, anon_fd,
+                                   size, offset, flags, xdata);
+                return 0;
+        }
+
+        switch (ob_fd_state (this, fd, &op_errno)) {
+        case OB_FD_READY:
+                break;
+        case OB_FD_FAILED:
+                goto err;
+        case OB_FD_PENDING:
+                stub = fop_readv_stub (frame, ob_readv, fd, size, offset,
+                                       flags, xdata);
+                if (!stub) {
+                        op_errno = ENOMEM;
+                        goto err;
+                }
+                ob_open_and_resume (this, fd, stub);
+                return 0;
+        }
+
+        STACK_WIND (frame, default_readv_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->readv, fd, size, offset, flags,
+                    xdata);
+        return 0;
+err:
+        STACK_UNWIND_STRICT (readv, frame, -1, op_errno, NULL, 0, NULL, NULL,
+                             NULL);
+        return 0;
+}
+
+
+int
+ob_fstat_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, struct iatt *buf,
+              dict_t *xdata)
+{
+        fd_t *anon_fd = cookie;
+
+        STACK_UNWIND_STRICT (fstat, frame, op_ret, op_errno, buf, xdata);
+
+        fd_unref (anon_fd);
+        return 0;
+}
+
+
+int
+ob_fstat (call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
+{
+        call_stub_t *stub     = NULL;
+        fd_t        *anon_fd  = NULL;
+        int32_t      op_errno = 0;
+
+        anon_fd = ob_anon_fd_get (this, fd);
+        if (anon_fd) {
+                STACK_WIND_COOKIE (frame, ob_fstat_cbk, anon_fd,
+                                   FIRST_CHILD (this),
+                                   FIRST_CHILD (this)->fops->fstat, anon_fd,
+                                   xdata);
+                return 0;
+        }
+
+        switch (ob_fd_state (this, fd, &op_errno)) {
+        case OB_FD_READY:
+                break;
+        case OB_FD_FAILED:
+                goto err;
+        case OB_FD_PENDING:
+                stub = fop_fstat_stub (frame, ob_fstat, fd, xdata);
+                if (!stub) {
+                        op_errno = ENOMEM;
+                        goto err;
+                }
+                ob_open_and_resume (this, fd, stub);
+                return 0;
+        }
+
+        STACK_WIND (frame, default_fstat_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fstat, fd, xdata);
+        return 0;
+err:
+        STACK_UNWIND_STRICT (fstat, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+int
+ob_flush (call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
+{
+        ob_conf_t    *conf     = NULL;
+        ob_fd_t      *ob_fd    = NULL;
+        call_stub_t  *stub     = NULL;
+        int32_t       op_errno = 0;
+        gf_boolean_t  unwind   = _gf_false;
+
+        conf = this->private;
+
+        LOCK (&fd->lock);
+        {
+                ob_fd = __ob_fd_ctx_get (this, fd);
+                /* nothing below knows about this fd yet */
+                if (ob_fd && ob_fd->open_frame)
+                        unwind = _gf_true;
+        }
+        UNLOCK (&fd->lock);
+
+        if (unwind) {
+                LOCK (&conf->lock);
+                {
+                        conf->flushes_skipped++;
+                }
+                UNLOCK (&conf->lock);
+
+                STACK_UNWIND_STRICT (flush, frame, 0, 0, NULL);
+                return 0;
+        }
+
+        switch (ob_fd_state (this, fd, &op_errno)) {
+        case OB_FD_READY:
+                break;
+        case OB_FD_FAILED:
+                goto err;
+        case OB_FD_PENDING:
+                stub = fop_flush_stub (frame, ob_flush, fd, xdata);
+                if (!stub) {
+                        op_errno = ENOMEM;
+                        goto err;
+                }
+                ob_open_and_resume (this, fd, stub);
+                return 0;
+        }
+
+        STACK_WIND (frame, default_flush_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->flush, fd, xdata);
+        return 0;
+err:
+        STACK_UNWIND_STRICT (flush, frame, -1, op_errno, NULL);
+        return 0;
+}
+
+
+int
+ob_writev (call_frame_t *frame, xlator_t *this, fd_t *fd, struct iovec *iov,
+           int count, off_t offset, uint32_t flags, struct iobref *iobref,
+           dict_t *xdata)
+{
+        call_stub_t *stub     = NULL;
+        int32_t      op_errno = 0;
+
+        switch (ob_fd_state (this, fd, &op_errno)) {
+        case OB_FD_READY:
+                break;
+        case OB_FD_FAILED:
+                goto err;
+        case OB_FD_PENDING:
+                stub = fop_writev_stub (frame, ob_writev, fd, iov, count,
+                                        offset, flags, iobref, xdata);
+                if (!stub) {
+                        op_errno = ENOMEM;
+                        goto err;
+                }
+                ob_open_and_resume (this, fd, stub);
+                return 0;
+        }
+
+        STACK_WIND (frame, default_writev_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->writev, fd, iov, count, offset,
+                    flags, iobref, xdata);
+        return 0;
+err:
+        STACK_UNWIND_STRICT (writev, frame, -1, op_errno, NULL, NULL, NULL);
+        return 0;
+}
+
+
+int
+ob_fsync (call_frame_t *frame, xlator_t *this, fd_t *fd, int datasync,
+          dict_t *xdata)
+{
+        call_stub_t *stub     = NULL;
+        int32_t      op_errno = 0;
+
+        switch (ob_fd_state (this, fd, &op_errno)) {
+        case OB_FD_READY:
+                break;
+        case OB_FD_FAILED:
+                goto err;
+        case OB_FD_PENDING:
+                stub = fop_fsync_stub (frame, ob_fsync, fd, datasync, xdata);
+                if (!stub) {
+                        op_errno = ENOMEM;
+                        goto err;
+                }
+                ob_open_and_resume (this, fd, stub);
+                return 0;
+        }
+
+        STACK_WIND (frame, default_fsync_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fsync, fd, datasync, xdata);
+        return 0;
+err:
+        STACK_UNWIND_STRICT (fsync, frame, -1, op_errno, NULL, NULL, NULL);
+        return 0;
+}
+
+
+int
+ob_ftruncate (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+              dict_t *xdata)
+{
+        call_stub_t *stub     = NULL;
+        int32_t      op_errno = 0;
+
+        switch (ob_fd_state (this, fd, &op_errno)) {
+        case OB_FD_READY:
+                break;
+        case OB_FD_FAILED:
+                goto err;
+        case OB_FD_PENDING:
+                stub = fop_ftruncate_stub (frame, ob_ftruncate, fd, offset,
+                                           xdata);
+                if (!stub) {
+                        op_errno = ENOMEM;
+                        goto err;
+                }
+                ob_open_and_resume (this, fd, stub);
+                return 0;
+        }
+
+        STACK_WIND (frame, default_ftruncate_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->ftruncate, fd, offset, xdata);
+        return 0;
+err:
+        STACK_UNWIND_STRICT (ftruncate, frame, -1, op_errno, NULL, NULL,
+                             NULL);
+        return 0;
+}
+
+
+int
+ob_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+              int32_t keep_size, off_t offset, size_t len, dict_t *xdata)
+{
+        call_stub_t *stub     = NULL;
+        int32_t      op_errno = 0;
+
+        switch (ob_fd_state (this, fd, &op_errno)) {
+        case OB_FD_READY:
+                break;
+        case OB_FD_FAILED:
+                goto err;
+        case OB_FD_PENDING:
+                stub = fop_fallocate_stub (frame, ob_fallocate, fd,
+                                           keep_size, offset, len, xdata);
+                if (!stub) {
+                        op_errno = ENOMEM;
+                        goto err;
+                }
+                ob_open_and_resume (this, fd, stub);
+                return 0;
+        }
+
+        STACK_WIND (frame, default_fallocate_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fallocate, fd, keep_size,
+                    offset, len, xdata);
+        return 0;
+err:
+        STACK_UNWIND_STRICT (fallocate, frame, -1, op_errno, NULL, NULL,
+                             NULL);
+        return 0;
+}
+
+
+int
+ob_discard (call_frame_t *frame, xlator_t *this, fd_t *fd,
+            off_t offset, size_t len, dict_t *xdata)
+{
+        call_stub_t *stub     = NULL;
+        int32_t      op_errno = 0;
+
+        switch (ob_fd_state (this, fd, &op_errno)) {
+        case OB_FD_READY:
+                break;
+        case OB_FD_FAILED:
+                goto err;
+        case OB_FD_PENDING:
+                stub = fop_discard_stub (frame, ob_discard, fd, offset, len,
+                                         xdata);
+                if (!stub) {
+                        op_errno = ENOMEM;
+                        goto err;
+                }
+                ob_open_and_resume (this, fd, stub);
+                return 0;
+        }
+
+        STACK_WIND (frame, default_discard_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->discard, fd, offset, len,
+                    xdata);
+        return 0;
+err:
+        STACK_UNWIND_STRICT (discard, frame, -1, op_errno, NULL, NULL,
+                             NULL);
+        return 0;
+}
+
+
+int
+ob_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd,
+             off_t offset, off_t len, dict_t *xdata)
+{
+        call_stub_t *stub     = NULL;
+        int32_t      op_errno = 0;
+
+        switch (ob_fd_state (this, fd, &op_errno)) {
+        case OB_FD_READY:
+                break;
+        case OB_FD_FAILED:
+                goto err;
+        case OB_FD_PENDING:
+                stub = fop_zerofill_stub (frame, ob_zerofill, fd, offset, len,
+                                          xdata);
+                if (!stub) {
+                        op_errno = ENOMEM;
+                        goto err;
+                }
+                ob_open_and_resume (this, fd, stub);
+                return 0;
+        }
+
+        STACK_WIND (frame, default_zerofill_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->zerofill, fd, offset, len,
+                    xdata);
+        return 0;
+err:
+        STACK_UNWIND_STRICT (zerofill, frame, -1, op_errno, NULL, NULL,
+                             NULL);
+        return 0;
+}
+
+
+int
+ob_seek (call_frame_t *frame, xlator_t *this, fd_t *fd,
+         off_t offset, gf_seek_what_t what, dict_t *xdata)
+{
+        call_stub_t *stub     = NULL;
+        int32_t      op_errno = 0;
+
+        switch (ob_fd_state (this, fd, &op_errno)) {
+        case OB_FD_READY:
+                break;
+        case OB_FD_FAILED:
+                goto err;
+        case OB_FD_PENDING:
+                stub = fop_seek_stub (frame, ob_seek, fd, offset, what,
+                                      xdata);
+                if (!stub) {
+                        op_errno = ENOMEM;
+                        goto err;
+                }
+                ob_open_and_resume (this, fd, stub);
+                return 0;
+        }
+
+        STACK_WIND (frame, default_seek_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->seek, fd, offset, what,
+                    xdata);
+        return 0;
+err:
+        STACK_UNWIND_STRICT (seek, frame, -1, op_errno, 0, NULL);
+        return 0;
+}
+
+
+int
+ob_fsetattr (call_frame_t *frame, xlator_t *this, fd_t *fd,
+             struct iatt *stbuf, int32_t valid, dict_t *xdata)
+{
+        call_stub_t *stub     = NULL;
+        int32_t      op_errno = 0;
+
+        switch (ob_fd_state (this, fd, &op_errno)) {
+        case OB_FD_READY:
+                break;
+        case OB_FD_FAILED:
+                goto err;
+        case OB_FD_PENDING:
+                stub = fop_fsetattr_stub (frame, ob_fsetattr, fd, stbuf,
+                                          valid, xdata);
+                if (!stub) {
+                        op_errno = ENOMEM;
+                        goto err;
+                }
+                ob_open_and_resume (this, fd, stub);
+                return 0;
+        }
+
+        STACK_WIND (frame, default_fsetattr_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fsetattr, fd, stbuf, valid,
+                    xdata);
+        return 0;
+err:
+        STACK_UNWIND_STRICT (fsetattr, frame, -1, op_errno, NULL, NULL,
+                             NULL);
+        return 0;
+}
+
+
+int
+ob_fsetxattr (call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *dict,
+              int32_t flags, dict_t *xdata)
+{
+        call_stub_t *stub     = NULL;
+        int32_t      op_errno = 0;
+
+        switch (ob_fd_state (this, fd, &op_errno)) {
+        case OB_FD_READY:
+                break;
+        case OB_FD_FAILED:
+                goto err;
+        case OB_FD_PENDING:
+                stub = fop_fsetxattr_stub (frame, ob_fsetxattr, fd, dict,
+                                           flags, xdata);
+                if (!stub) {
+                        op_errno = ENOMEM;
+                        goto err;
+                }
+                ob_open_and_resume (this, fd, stub);
+                return 0;
+        }
+
+        STACK_WIND (frame, default_fsetxattr_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fsetxattr, fd, dict, flags,
+                    xdata);
+        return 0;
+err:
+        STACK_UNWIND_STRICT (fsetxattr, frame, -1, op_errno, NULL);
+        return 0;
+}
+
+
+int
+ob_fgetxattr (call_frame_t *frame, xlator_t *this, fd_t *fd,
+              const char *name, dict_t *xdata)
+{
+        call_stub_t *stub     = NULL;
+        int32_t      op_errno = 0;
+
+        switch (ob_fd_state (this, fd, &op_errno)) {
+        case OB_FD_READY:
+                break;
+        case OB_FD_FAILED:
+                goto err;
+        case OB_FD_PENDING:
+                stub = fop_fgetxattr_stub (frame, ob_fgetxattr, fd, name,
+                                           xdata);
+                if (!stub) {
+                        op_errno = ENOMEM;
+                        goto err;
+                }
+                ob_open_and_resume (this, fd, stub);
+                return 0;
+        }
+
+        STACK_WIND (frame, default_fgetxattr_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fgetxattr, fd, name, xdata);
+        return 0;
+err:
+        STACK_UNWIND_STRICT (fgetxattr, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+int
+ob_fremovexattr (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                 const char *name, dict_t *xdata)
+{
+        call_stub_t *stub     = NULL;
+        int32_t      op_errno = 0;
+
+        switch (ob_fd_state (this, fd, &op_errno)) {
+        case OB_FD_READY:
+                break;
+        case OB_FD_FAILED:
+                goto err;
+        case OB_FD_PENDING:
+                stub = fop_fremovexattr_stub (frame, ob_fremovexattr, fd,
+                                              name, xdata);
+                if (!stub) {
+                        op_errno = ENOMEM;
+                        goto err;
+                }
+                ob_open_and_resume (this, fd, stub);
+                return 0;
+        }
+
+        STACK_WIND (frame, default_fremovexattr_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fremovexattr, fd, name, xdata);
+        return 0;
+err:
+        STACK_UNWIND_STRICT (fremovexattr, frame, -1, op_errno, NULL);
+        return 0;
+}
+
+
+int
+ob_lk (call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t cmd,
+       struct gf_flock *flock, dict_t *xdata)
+{
+        call_stub_t *stub     = NULL;
+        int32_t      op_errno = 0;
+
+        switch (ob_fd_state (this, fd, &op_errno)) {
+        case OB_FD_READY:
+                break;
+        case OB_FD_FAILED:
+                goto err;
+        case OB_FD_PENDING:
+                stub = fop_lk_stub (frame, ob_lk, fd, cmd, flock, xdata);
+                if (!stub) {
+                        op_errno = ENOMEM;
+                        goto err;
+                }
+                ob_open_and_resume (this, fd, stub);
+                return 0;
+        }
+
+        STACK_WIND (frame, default_lk_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->lk, fd, cmd, flock, xdata);
+        return 0;
+err:
+        STACK_UNWIND_STRICT (lk, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+int
+ob_finodelk (call_frame_t *frame, xlator_t *this, const char *volume,
+             fd_t *fd, int32_t cmd, struct gf_flock *flock, dict_t *xdata)
+{
+        call_stub_t *stub     = NULL;
+        int32_t      op_errno = 0;
+
+        switch (ob_fd_state (this, fd, &op_errno)) {
+        case OB_FD_READY:
+                break;
+        case OB_FD_FAILED:
+                goto err;
+        case OB_FD_PENDING:
+                stub = fop_finodelk_stub (frame, ob_finodelk, volume, fd,
+                                          cmd, flock, xdata);
+                if (!stub) {
+                        op_errno = ENOMEM;
+                        goto err;
+                }
+                ob_open_and_resume (this, fd, stub);
+                return 0;
+        }
+
+        STACK_WIND (frame, default_finodelk_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->finodelk, volume, fd, cmd,
+                    flock, xdata);
+        return 0;
+err:
+        STACK_UNWIND_STRICT (finodelk, frame, -1, op_errno, NULL);
+        return 0;
+}
+
+
+int
+ob_fentrylk (call_frame_t *frame, xlator_t *this, const char *volume,
+             fd_t *fd, const char *basename, entrylk_cmd cmd,
+             entrylk_type type, dict_t *xdata)
+{
+        call_stub_t *stub     = NULL;
+        int32_t      op_errno = 0;
+
+        switch (ob_fd_state (this, fd, &op_errno)) {
+        case OB_FD_READY:
+                break;
+        case OB_FD_FAILED:
+                goto err;
+        case OB_FD_PENDING:
+                stub = fop_fentrylk_stub (frame, ob_fentrylk, volume, fd,
+                                          basename, cmd, type, xdata);
+                if (!stub) {
+                        op_errno = ENOMEM;
+                        goto err;
+                }
+                ob_open_and_resume (this, fd, stub);
+                return 0;
+        }
+
+        STACK_WIND (frame, default_fentrylk_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fentrylk, volume, fd, basename,
+                    cmd, type, xdata);
+        return 0;
+err:
+        STACK_UNWIND_STRICT (fentrylk, frame, -1, op_errno, NULL);
+        return 0;
+}
+
+
+int
+ob_fxattrop (call_frame_t *frame, xlator_t *this, fd_t *fd,
+             gf_xattrop_flags_t optype, dict_t *xattr, dict_t *xdata)
+{
+        call_stub_t *stub     = NULL;
+        int32_t      op_errno = 0;
+
+        switch (ob_fd_state (this, fd, &op_errno)) {
+        case OB_FD_READY:
+                break;
+        case OB_FD_FAILED:
+                goto err;
+        case OB_FD_PENDING:
+                stub = fop_fxattrop_stub (frame, ob_fxattrop, fd, optype,
+                                          xattr, xdata);
+                if (!stub) {
+                        op_errno = ENOMEM;
+                        goto err;
+                }
+                ob_open_and_resume (this, fd, stub);
+                return 0;
+        }
+
+        STACK_WIND (frame, default_fxattrop_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fxattrop, fd, optype, xattr,
+                    xdata);
+        return 0;
+err:
+        STACK_UNWIND_STRICT (fxattrop, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+int
+ob_rchecksum (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+              int32_t len, dict_t *xdata)
+{
+        call_stub_t *stub     = NULL;
+        int32_t      op_errno = 0;
+
+        switch (ob_fd_state (this, fd, &op_errno)) {
+        case OB_FD_READY:
+                break;
+        case OB_FD_FAILED:
+                goto err;
+        case OB_FD_PENDING:
+                stub = fop_rchecksum_stub (frame, ob_rchecksum, fd, offset,
+                                           len, xdata);
+                if (!stub) {
+                        op_errno = ENOMEM;
+                        goto err;
+                }
+                ob_open_and_resume (this, fd, stub);
+                return 0;
+        }
+
+        STACK_WIND (frame, default_rchecksum_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->rchecksum, fd, offset, len,
+                    xdata);
+        return 0;
+err:
+        STACK_UNWIND_STRICT (rchecksum, frame, -1, op_errno, 0, NULL, NULL);
+        return 0;
+}
+
+
+/* the gfid of an unlinked file no longer resolves on the bricks, so every
+   deferred open on it is wound first. The fop re-enters after each open. */
+int
+ob_unlink (call_frame_t *frame, xlator_t *this, loc_t *loc, int xflags,
+           dict_t *xdata)
+{
+        call_stub_t *stub = NULL;
+        fd_t        *fd   = NULL;
+
+        if (loc->inode)
+                fd = ob_inode_pending_fd (this, loc->inode);
+        if (!fd)
+                goto wind;
+
+        stub = fop_unlink_stub (frame, ob_unlink, loc, xflags, xdata);
+        if (!stub) {
+                fd_unref (fd);
+                STACK_UNWIND_STRICT (unlink, frame, -1, ENOMEM, NULL, NULL,
+                                     NULL);
+                return 0;
+        }
+
+        ob_open_and_resume (this, fd, stub);
+        fd_unref (fd);
+        return 0;
+
+wind:
+        STACK_WIND (frame, default_unlink_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->unlink, loc, xflags, xdata);
+        return 0;
+}
+
+
+int
+ob_rename (call_frame_t *frame, xlator_t *this, loc_t *oldloc,
+           loc_t *newloc, dict_t *xdata)
+{
+        call_stub_t *stub = NULL;
+        fd_t        *fd   = NULL;
+
+        /* only a file which is renamed over goes away */
+        if (newloc->inode)
+                fd = ob_inode_pending_fd (this, newloc->inode);
+        if (!fd)
+                goto wind;
+
+        stub = fop_rename_stub (frame, ob_rename, oldloc, newloc, xdata);
+        if (!stub) {
+                fd_unref (fd);
+                STACK_UNWIND_STRICT (rename, frame, -1, ENOMEM, NULL, NULL,
+                                     NULL, NULL, NULL, NULL);
+                return 0;
+        }
+
+        ob_open_and_resume (this, fd, stub);
+        fd_unref (fd);
+        return 0;
+
+wind:
+        STACK_WIND (frame, default_rename_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->rename, oldloc, newloc, xdata);
+        return 0;
+}
+
+
+int
+ob_release (xlator_t *this, fd_t *fd)
+{
+        ob_conf_t *conf  = NULL;
+        ob_fd_t   *ob_fd = NULL;
+        uint64_t   value = 0;
+
+        conf = this->private;
+
+        fd_ctx_del (fd, this, &value);
+        ob_fd = (ob_fd_t *)(long) value;
+        if (!ob_fd)
+                return 0;
+
+        if (ob_fd->open_frame) {
+                LOCK (&conf->lock);
+                {
+                        conf->opens_saved++;
+                }
+                UNLOCK (&conf->lock);
+        }
+
+        ob_fd_free (ob_fd);
+
+        return 0;
+}
+
+
+int
+ob_priv_dump (xlator_t *this)
+{
+        ob_conf_t *conf = NULL;
+        char       key_prefix[GF_DUMP_MAX_BUF_LEN];
+
+        conf = this->private;
+        if (!conf)
+                return -1;
+
+        gf_proc_dump_build_key (key_prefix, "xlator.performance.open-behind",
+                                "priv");
+        gf_proc_dump_add_section (key_prefix);
+
+        gf_proc_dump_write ("use_anonymous_fd", "%d", conf->use_anonymous_fd);
+        gf_proc_dump_write ("lazy_open", "%d", conf->lazy_open);
+        gf_proc_dump_write ("lazy_open_timeout", "%d",
+                            conf->lazy_open_timeout);
+
+        LOCK (&conf->lock);
+        {
+                gf_proc_dump_write ("opens_deferred", "%"PRIu64,
+                                    conf->opens_deferred);
+                gf_proc_dump_write ("opens_wound", "%"PRIu64,
+                                    conf->opens_wound);
+                gf_proc_dump_write ("opens_saved", "%"PRIu64,
+                                    conf->opens_saved);
+                gf_proc_dump_write ("anon_fops", "%"PRIu64, conf->anon_fops);
+                gf_proc_dump_write ("flushes_skipped", "%"PRIu64,
+                                    conf->flushes_skipped);
+        }
+        UNLOCK (&conf->lock);
+
+        return 0;
+}
+
+
+int
+ob_fdctx_dump (xlator_t *this, fd_t *fd)
+{
+        ob_fd_t *ob_fd = NULL;
+        char     key_prefix[GF_DUMP_MAX_BUF_LEN] = {0, };
+        int      ret   = 0;
+
+        ret = TRY_LOCK (&fd->lock);
+        if (ret)
+                return 0;
+
+        ob_fd = __ob_fd_ctx_get (this, fd);
+        if (!ob_fd) {
+                UNLOCK (&fd->lock);
+                return 0;
+        }
+
+        gf_proc_dump_build_key (key_prefix, "xlator.performance.open-behind",
+                                "file");
+        gf_proc_dump_add_section (key_prefix);
+
+        gf_proc_dump_write ("fd", "%p", fd);
+        gf_proc_dump_write ("path", "%s", ob_fd->loc.path);
+        gf_proc_dump_write ("flags", "%d", ob_fd->flags);
+        gf_proc_dump_write ("open_wound", "%s",
+                            ob_fd->open_frame ? "no" : "yes");
+        gf_proc_dump_write ("op_errno", "%d", ob_fd->op_errno);
+
+        UNLOCK (&fd->lock);
+
+        return 0;
+}
+
+
+int32_t
+mem_acct_init (xlator_t *this)
+{
+        int ret = -1;
+
+        if (!this)
+                goto out;
+
+        ret = xlator_mem_acct_init (this, gf_ob_mt_end + 1);
+
+        if (ret != 0)
+                gf_log (this->name, GF_LOG_ERROR, "Memory accounting init"
+                        "failed");
+
+out:
+        return ret;
+}
+
+
+int
+reconfigure (xlator_t *this, dict_t *options)
+{
+        ob_conf_t *conf = this->private;
+        int        ret  = -1;
+
+        GF_OPTION_RECONF ("use-anonymous-fd", conf->use_anonymous_fd, options,
+                          bool, out);
+        GF_OPTION_RECONF ("lazy-open", conf->lazy_open, options, bool, out);
+        GF_OPTION_RECONF ("lazy-open-timeout", conf->lazy_open_timeout,
+                          options, int32, out);
+
+        ret = 0;
+out:
+        return ret;
+}
+
+
+int
+init (xlator_t *this)
+{
+        ob_conf_t *conf = NULL;
+
+        GF_VALIDATE_OR_GOTO ("open-behind", this, err);
+
+        if (!this->children || this->children->next) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "FATAL: open-behind not configured with exactly one"
+                        " child");
+                goto err;
+        }
+
+        if (!this->parents) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "dangling volume. check volfile ");
+        }
+
+        conf = GF_CALLOC (1, sizeof (*conf), gf_ob_mt_ob_conf_t);
+        if (!conf)
+                goto err;
+
+        LOCK_INIT (&conf->lock);
+        this->private = conf;
+
+        GF_OPTION_INIT ("use-anonymous-fd", conf->use_anonymous_fd, bool,
+                        err);
+        GF_OPTION_INIT ("lazy-open", conf->lazy_open, bool, err);
+        GF_OPTION_INIT ("lazy-open-timeout", conf->lazy_open_timeout, int32,
+                        err);
+
+        return 0;
+
+err:
+        if (conf) {
+                LOCK_DESTROY (&conf->lock);
+                GF_FREE (conf);
+        }
+        if (this)
+                this->private = NULL;
+
+        return -1;
+}
+
+
+void
+fini (xlator_t *this)
+{
+        ob_conf_t *conf = NULL;
+
+        GF_VALIDATE_OR_GOTO ("open-behind", this, out);
+
+        conf = this->private;
+        if (!conf)
+                goto out;
+
+        this->private = NULL;
+        LOCK_DESTROY (&conf->lock);
+        GF_FREE (conf);
+out:
+        return;
+}
+
+
+struct xlator_fops fops = {
+        .open         = ob_open,
+        .readv        = ob_readv,
+        .fstat        = ob_fstat,
+        .flush        = ob_flush,
+        .writev       = ob_writev,
+        .fsync        = ob_fsync,
+        .ftruncate    = ob_ftruncate,
+        .fallocate    = ob_fallocate,
+        .discard      = ob_discard,
+        .zerofill     = ob_zerofill,
+        .seek         = ob_seek,
+        .fsetattr     = ob_fsetattr,
+        .fsetxattr    = ob_fsetxattr,
+        .fgetxattr    = ob_fgetxattr,
+        .fremovexattr = ob_fremovexattr,
+        .lk           = ob_lk,
+        .finodelk     = ob_finodelk,
+        .fentrylk     = ob_fentrylk,
+        .fxattrop     = ob_fxattrop,
+        .rchecksum    = ob_rchecksum,
+        .unlink       = ob_unlink,
+        .rename       = ob_rename,
+};
+
+struct xlator_cbks cbks = {
+        .release      = ob_release,
+};
+
+struct xlator_dumpops dumpops = {
+        .priv         = ob_priv_dump,
+        .fdctx        = ob_fdctx_dump,
+};
+
+struct volume_options options[] = {
+        { .key = {"use-anonymous-fd"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "on",
+          .description = "serve reads and fstat on an fd whose open is "
+                         "deferred through an anonymous fd",
+        },
+        { .key = {"lazy-open"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "on",
+          .description = "wind the open only when a fop needs it. When off "
+                         "the open is wound in the background right away",
+        },
+        { .key = {"lazy-open-timeout"},
+          .type = GF_OPTION_TYPE_INT,
+          .min = 0,
+          .max = 3600,
+          .default_value = "10",
+          .description = "seconds an fd can be held before its next read "
+                         "opens it for real, 0 never does",
+        },
+        { .key = {NULL} },
+};
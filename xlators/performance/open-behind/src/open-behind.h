@@ -0,0 +1,62 @@
+/*
+  Copyright (c) 2012 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#ifndef __OPEN_BEHIND_H
+#define __OPEN_BEHIND_H
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include "glusterfs.h"
+#include "logging.h"
+#include "dict.h"
+#include "xlator.h"
+#include "list.h"
+#include "call-stub.h"
+#include "defaults.h"
+#include "open-behind-mem-types.h"
+
+/* state of an fd as seen by the fops which need it really opened */
+typedef enum {
+        OB_FD_READY = 0,        /* opened below (or never deferred) */
+        OB_FD_PENDING,          /* open deferred or in flight */
+        OB_FD_FAILED,           /* the deferred open failed */
+} ob_fd_state_t;
+
+/* fd ctx, present only until the open has succeeded below */
+struct ob_fd {
+        call_frame_t     *open_frame;  /* set until the open is wound */
+        loc_t             loc;
+        dict_t           *xdata;
+        int32_t           flags;
+        int32_t           op_errno;    /* why the deferred open failed */
+        struct timeval    tv;          /* when the open was acknowledged */
+        struct list_head  list;        /* stubs waiting for the open */
+};
+typedef struct ob_fd ob_fd_t;
+
+struct ob_conf {
+        gf_boolean_t  use_anonymous_fd;
+        gf_boolean_t  lazy_open;
+        int32_t       lazy_open_timeout;
+
+        /* statistics */
+        gf_lock_t     lock;
+        uint64_t      opens_deferred;
+        uint64_t      opens_wound;
+        uint64_t      opens_saved;     /* released without ever opening */
+        uint64_t      anon_fops;
+        uint64_t      flushes_skipped;
+};
+typedef struct ob_conf ob_conf_t;
+
+#endif /* __OPEN_BEHIND_H */
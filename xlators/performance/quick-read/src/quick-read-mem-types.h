@@ -21,6 +21,7 @@ enum gf_qr_mem_types_ {
         gf_qr_mt_qr_priority_t,
         gf_qr_mt_qr_private_t,
         gf_qr_mt_qr_unlink_ctx_t,
+        gf_qr_mt_qr_inode_table_t,
         gf_qr_mt_end
 };
 #endif
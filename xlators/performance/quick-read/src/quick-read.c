@@ -209,13 +209,14 @@ out:
 }
 
 
-/* To be called with this-priv->table.lock held */
+/* To be called with the lock of the table inode maps to held */
 qr_inode_t *
 __qr_inode_alloc (xlator_t *this, char *path, inode_t *inode)
 {
-        qr_inode_t    *qr_inode = NULL;
-        qr_private_t  *priv     = NULL;
-        int            priority = 0;
+        qr_inode_t       *qr_inode = NULL;
+        qr_private_t     *priv     = NULL;
+        qr_inode_table_t *table    = NULL;
+        int               priority = 0;
 
         GF_VALIDATE_OR_GOTO ("quick-read", this, out);
         GF_VALIDATE_OR_GOTO (this->name, path, out);
@@ -233,10 +234,12 @@ __qr_inode_alloc (xlator_t *this, char *path, inode_t *inode)
         INIT_LIST_HEAD (&qr_inode->fd_list);
 
         priority = qr_get_priority (&priv->conf, path);
+        table = qr_inode_table_get (priv, inode);
 
-        list_add_tail (&qr_inode->lru, &priv->table.lru[priority]);
+        list_add_tail (&qr_inode->lru, &table->lru[priority]);
 
         qr_inode->inode = inode;
+        qr_inode->table = table;
         qr_inode->priority = priority;
 out:
         return qr_inode;
@@ -253,6 +256,7 @@ __qr_inode_free (qr_inode_t *qr_inode)
 
         if (qr_inode->xattr) {
                 dict_unref (qr_inode->xattr);
+                qr_inode->table->cache_used -= qr_inode->stbuf.ia_size;
         }
 
         list_del (&qr_inode->lru);
@@ -271,13 +275,12 @@ out:
         return;
 }
 
-/* To be called with priv->table.lock held */
+/* To be called with table->lock held */
 void
-__qr_cache_prune (xlator_t *this)
+__qr_cache_prune (xlator_t *this, qr_inode_table_t *table)
 {
         qr_private_t     *priv          = NULL;
         qr_conf_t        *conf          = NULL;
-        qr_inode_table_t *table         = NULL;
         qr_inode_t        *curr         = NULL, *next = NULL;
         int32_t           index         = 0;
         uint64_t          size_to_prune = 0;
@@ -286,11 +289,12 @@ __qr_cache_prune (xlator_t *this)
         GF_VALIDATE_OR_GOTO ("quick-read", this, out);
         priv = this->private;
         GF_VALIDATE_OR_GOTO (this->name, priv, out);
+        GF_VALIDATE_OR_GOTO (this->name, table, out);
 
-        table = &priv->table;
         conf = &priv->conf;
 
-        size_to_prune = table->cache_used - conf->cache_size;
+        size_to_prune = table->cache_used
+                - (conf->cache_size / priv->table_count);
 
         for (index=0; index < conf->max_pri; index++) {
                 list_for_each_entry_safe (curr, next, &table->lru[index], lru) {
@@ -298,97 +302,55 @@ __qr_cache_prune (xlator_t *this)
                         inode_ctx_del (curr->inode, this, NULL);
                         __qr_inode_free (curr);
                         if (size_pruned >= size_to_prune)
-                                goto done;
+                                goto out;
                 }
         }
 
-done:
-        table->cache_used -= size_pruned;
-
 out:
         return;
 }
 
 /* To be called with table->lock held */
 inline char
-__qr_need_cache_prune (qr_conf_t *conf, qr_inode_table_t *table)
+__qr_need_cache_prune (qr_private_t *priv, qr_inode_table_t *table)
 {
         char need_prune = 0;
 
-        GF_VALIDATE_OR_GOTO ("quick-read", conf, out);
+        GF_VALIDATE_OR_GOTO ("quick-read", priv, out);
         GF_VALIDATE_OR_GOTO ("quick-read", table, out);
 
-        need_prune = (table->cache_used > conf->cache_size);
+        need_prune = (table->cache_used
+                      > (priv->conf.cache_size / priv->table_count));
 
 out:
         return need_prune;
 }
 
 
-int32_t
-qr_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
-               int32_t op_ret, int32_t op_errno, inode_t *inode,
-               struct iatt *buf, dict_t *xdata, struct iatt *postparent)
+/*
+ * Cache the file content fetched along with a lookup or a readdirp entry.
+ * Returns -1 with op_errno set on failure.
+ */
+int
+qr_content_refresh (xlator_t *this, inode_t *inode, char *path,
+                    data_t *content, struct iatt *buf, int32_t *op_errno)
 {
-        data_t           *content  = NULL;
         qr_inode_t       *qr_inode = NULL;
         uint64_t          value    = 0;
         int               ret      = -1;
-        qr_conf_t        *conf     = NULL;
         qr_inode_table_t *table    = NULL;
         qr_private_t     *priv     = NULL;
-        qr_local_t       *local    = NULL;
-
-        GF_ASSERT (frame);
-
-        if ((op_ret == -1) || (xdata == NULL)) {
-                goto out;
-        }
-
-        if ((this == NULL) || (this->private == NULL)) {
-                gf_log (frame->this->name, GF_LOG_WARNING,
-                        (this == NULL) ? "xlator object (this) is NULL"
-                        : "quick-read configuration is not found");
-                op_ret = -1;
-                op_errno = EINVAL;
-                goto out;
-        }
 
         priv = this->private;
-        conf = &priv->conf;
-        table = &priv->table;
-
-        local = frame->local;
-
-        if (buf->ia_size > conf->max_file_size) {
-                goto out;
-        }
-
-        if (IA_ISDIR (buf->ia_type)) {
-                goto out;
-        }
-
-        if (inode == NULL) {
-                op_ret = -1;
-                op_errno = EINVAL;
-                gf_log (this->name, GF_LOG_WARNING,
-                        "lookup returned a NULL inode");
-                goto out;
-        }
-
-        content = dict_get (xdata, GF_CONTENT_KEY);
-        if (content == NULL) {
-                goto out;
-        }
+        table = qr_inode_table_get (priv, inode);
 
         LOCK (&table->lock);
         {
                 ret = inode_ctx_get (inode, this, &value);
                 if (ret == -1) {
-                        qr_inode = __qr_inode_alloc (this, local->path, inode);
+                        qr_inode = __qr_inode_alloc (this, path, inode);
                         if (qr_inode == NULL) {
-                                op_ret = -1;
-                                op_errno = ENOMEM;
+                                *op_errno = ENOMEM;
                                 goto unlock;
                         }
 
@@ -397,8 +359,7 @@ qr_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                         if (ret == -1) {
                                 __qr_inode_free (qr_inode);
                                 qr_inode = NULL;
-                                op_ret = -1;
-                                op_errno = EINVAL;
+                                *op_errno = EINVAL;
                                 gf_log (this->name, GF_LOG_WARNING,
                                         "cannot set quick-read context in "
                                         "inode (gfid:%s)",
@@ -408,8 +369,8 @@ qr_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                 } else {
                         qr_inode = (qr_inode_t *)(long)value;
                         if (qr_inode == NULL) {
-                                op_ret = -1;
-                                op_errno = EINVAL;
+                                ret = -1;
+                                *op_errno = EINVAL;
                                 gf_log (this->name, GF_LOG_WARNING,
                                         "cannot find quick-read context in "
                                         "inode (gfid:%s)",
@@ -431,30 +392,95 @@ qr_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 
 		qr_inode->xattr = dict_new();
 		if (!qr_inode->xattr) {
-			op_ret = -1;
-			op_errno = ENOMEM;
+                        ret = -1;
+			*op_errno = ENOMEM;
 			goto unlock;
 		}
 
 		if (dict_set(qr_inode->xattr, GF_CONTENT_KEY, content) < 0) {
-			op_ret = -1;
-			op_errno = ENOMEM;
+                        dict_unref (qr_inode->xattr);
+                        qr_inode->xattr = NULL;
+                        ret = -1;
+			*op_errno = ENOMEM;
 			goto unlock;
 		}
 
-		dict_del(xdata, GF_CONTENT_KEY);
-
                 qr_inode->stbuf = *buf;
                 table->cache_used += buf->ia_size;
 
                 gettimeofday (&qr_inode->tv, NULL);
-                if (__qr_need_cache_prune (conf, table)) {
-                        __qr_cache_prune (this);
+                if (__qr_need_cache_prune (priv, table)) {
+                        __qr_cache_prune (this, table);
                 }
         }
 unlock:
         UNLOCK (&table->lock);
 
+        return ret;
+}
+
+
+int32_t
+qr_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, inode_t *inode,
+               struct iatt *buf, dict_t *xdata, struct iatt *postparent)
+{
+        data_t           *content  = NULL;
+        int               ret      = -1;
+        qr_conf_t        *conf     = NULL;
+        qr_private_t     *priv     = NULL;
+        qr_local_t       *local    = NULL;
+
+        GF_ASSERT (frame);
+
+        if ((op_ret == -1) || (xdata == NULL)) {
+                goto out;
+        }
+
+        if ((this == NULL) || (this->private == NULL)) {
+                gf_log (frame->this->name, GF_LOG_WARNING,
+                        (this == NULL) ? "xlator object (this) is NULL"
+                        : "quick-read configuration is not found");
+                op_ret = -1;
+                op_errno = EINVAL;
+                goto out;
+        }
+
+        priv = this->private;
+        conf = &priv->conf;
+
+        local = frame->local;
+
+        if (buf->ia_size > conf->max_file_size) {
+                goto out;
+        }
+
+        if (IA_ISDIR (buf->ia_type)) {
+                goto out;
+        }
+
+        if (inode == NULL) {
+                op_ret = -1;
+                op_errno = EINVAL;
+                gf_log (this->name, GF_LOG_WARNING,
+                        "lookup returned a NULL inode");
+                goto out;
+        }
+
+        content = dict_get (xdata, GF_CONTENT_KEY);
+        if (content == NULL) {
+                goto out;
+        }
+
+        ret = qr_content_refresh (this, inode, local->path, content, buf,
+                                  &op_errno);
+        if (ret < 0) {
+                op_ret = -1;
+                goto out;
+        }
+
+        dict_del (xdata, GF_CONTENT_KEY);
+
 out:
         /*
          * FIXME: content size in dict can be greater than the size application
@@ -496,7 +522,7 @@ qr_lookup (call_frame_t *frame, xlator_t *this, loc_t *loc,
                 goto unwind;
         }
 
-        table = &priv->table;
+        table = qr_inode_table_get (priv, loc->inode);
 
         local = qr_local_new (this);
         GF_VALIDATE_OR_GOTO_WITH_ERROR (this->name, local, unwind, op_errno,
@@ -578,6 +604,183 @@ unwind:
 }
 
 
+int32_t
+qr_readdirp_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, gf_dirent_t *entries,
+                 dict_t *xdata)
+{
+        gf_dirent_t      *entry    = NULL;
+        data_t           *content  = NULL;
+        qr_private_t     *priv     = NULL;
+        qr_conf_t        *conf     = NULL;
+        qr_inode_table_t *table    = NULL;
+        uint64_t          max_size = 0;
+        int32_t           err      = 0;
+        int               ret      = -1;
+
+        if (op_ret <= 0) {
+                goto out;
+        }
+
+        priv = this->private;
+        conf = &priv->conf;
+
+        max_size = min (conf->max_file_size, conf->readdirp_max_file_size);
+
+        list_for_each_entry (entry, &entries->list, list) {
+                if ((entry->inode == NULL) || (entry->dict == NULL)) {
+                        continue;
+                }
+
+                content = dict_get (entry->dict, GF_CONTENT_KEY);
+                if (content == NULL) {
+                        continue;
+                }
+
+                if (IA_ISREG (entry->d_stat.ia_type)
+                    && (entry->d_stat.ia_size <= max_size)) {
+                        ret = qr_content_refresh (this, entry->inode,
+                                                  entry->d_name, content,
+                                                  &entry->d_stat, &err);
+                        if (ret == 0) {
+                                table = qr_inode_table_get (priv,
+                                                            entry->inode);
+                                LOCK (&table->lock);
+                                {
+                                        table->readdirp_cached++;
+                                }
+                                UNLOCK (&table->lock);
+                        }
+                }
+
+                /* content is not for the layers above */
+                dict_del (entry->dict, GF_CONTENT_KEY);
+        }
+
+out:
+        STACK_UNWIND_STRICT (readdirp, frame, op_ret, op_errno, entries,
+                             xdata);
+        return 0;
+}
+
+
+/*
+ * Ask for the content of small files along with readdirp, so that reading
+ * the files of a directory in listing order does not need a lookup and a
+ * read per file.
+ */
+int32_t
+qr_readdirp (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+             off_t offset, dict_t *xdata)
+{
+        qr_private_t *priv         = NULL;
+        qr_conf_t    *conf         = NULL;
+        dict_t       *new_req_dict = NULL;
+        uint64_t      max_size     = 0;
+        int32_t       op_errno     = ENOMEM;
+        int           ret          = -1;
+
+        priv = this->private;
+        conf = &priv->conf;
+
+        max_size = min (conf->max_file_size, conf->readdirp_max_file_size);
+
+        if (!conf->cache_on_readdirp || (max_size == 0)) {
+                goto wind;
+        }
+
+        if (xdata == NULL) {
+                new_req_dict = xdata = dict_new ();
+                if (xdata == NULL) {
+                        goto unwind;
+                }
+        }
+
+        if (dict_get (xdata, GF_CONTENT_KEY) == NULL) {
+                ret = dict_set_uint64 (xdata, GF_CONTENT_KEY, max_size);
+                if (ret < 0) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "cannot set key in request dict to request "
+                                "file content during readdirp");
+                }
+        }
+
+wind:
+        STACK_WIND (frame, qr_readdirp_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->readdirp, fd, size, offset,
+                    xdata);
+
+        if (new_req_dict) {
+                dict_unref (new_req_dict);
+        }
+
+        return 0;
+
+unwind:
+        STACK_UNWIND_STRICT (readdirp, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+int32_t
+qr_opendir_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, fd_t *fd, dict_t *xdata)
+{
+        STACK_UNWIND_STRICT (opendir, frame, op_ret, op_errno, fd, xdata);
+        return 0;
+}
+
+
+/*
+ * readdir-ahead prefetches with the keys requested in opendir, so pass the
+ * content request down already here.
+ */
+int32_t
+qr_opendir (call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd,
+            dict_t *xdata)
+{
+        qr_private_t *priv         = NULL;
+        qr_conf_t    *conf         = NULL;
+        dict_t       *new_req_dict = NULL;
+        uint64_t      max_size     = 0;
+        int           ret          = -1;
+
+        priv = this->private;
+        conf = &priv->conf;
+
+        max_size = min (conf->max_file_size, conf->readdirp_max_file_size);
+
+        if (!conf->cache_on_readdirp || (max_size == 0)) {
+                goto wind;
+        }
+
+        if (xdata == NULL) {
+                new_req_dict = xdata = dict_new ();
+                if (xdata == NULL) {
+                        goto wind;
+                }
+        }
+
+        if (dict_get (xdata, GF_CONTENT_KEY) == NULL) {
+                ret = dict_set_uint64 (xdata, GF_CONTENT_KEY, max_size);
+                if (ret < 0) {
+                        gf_log (this->name, GF_LOG_DEBUG,
+                                "cannot set key in opendir request dict");
+                }
+        }
+
+wind:
+        STACK_WIND (frame, qr_opendir_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->opendir, loc, fd, xdata);
+
+        if (new_req_dict) {
+                dict_unref (new_req_dict);
+        }
+
+        return 0;
+}
+
+
 int32_t
 qr_open_cbk (call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
              int32_t op_errno, fd_t *fd, dict_t *xdata)
@@ -596,7 +799,7 @@ qr_open_cbk (call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
         GF_ASSERT (frame);
 
         priv = this->private;
-        table = &priv->table;
+        table = qr_inode_table_get (priv, fd->inode);
 
         local = frame->local;
         if (local != NULL) {
@@ -695,7 +898,7 @@ qr_open (call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
         GF_VALIDATE_OR_GOTO (frame->this->name, fd, unwind);
 
         priv = this->private;
-        table = &priv->table;
+        table = qr_inode_table_get (priv, fd->inode);
 
         tmp_fd_ctx = qr_fd_ctx = GF_CALLOC (1, sizeof (*qr_fd_ctx),
                                             gf_qr_mt_qr_fd_ctx_t);
@@ -882,7 +1085,7 @@ qr_validate_cache_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         }
 
         priv = this->private;
-        table = &priv->table;
+        table = qr_inode_table_get (priv, local->fd->inode);
 
         LOCK (&table->lock);
         {
@@ -1155,7 +1358,7 @@ qr_readv (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
 
         priv = this->private;
         conf = &priv->conf;
-        table = &priv->table;
+        table = qr_inode_table_get (priv, fd->inode);
 
         local = frame->local;
 
@@ -1258,143 +1461,829 @@ qr_readv (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
                                        ((end - start)) ? (end - start) :
                                        iobuf_pool->default_page_size);
 
-                                memcpy (iobuf->ptr, content->data + start, len);
-                        }
+                                memcpy (iobuf->ptr, content->data + start, len);
+                        }
+
+                        iobref_add (iobref, iobuf);
+                        iobuf_unref (iobuf);
+
+                        vector[i].iov_base = iobuf->ptr;
+                        vector[i].iov_len = len;
+                }
+        }
+unlock:
+        UNLOCK (&table->lock);
+
+out:
+        if (content_cached || need_unwind) {
+                QR_STACK_UNWIND (readv, frame, op_ret, op_errno, vector,
+                                 count, &stbuf, iobref, NULL);
+
+        } else if (need_validation) {
+                stub = fop_readv_stub (frame, qr_readv, fd, size, offset,
+                                       read_flags, xdata);
+                if (stub == NULL) {
+                        op_ret = -1;
+                        op_errno = ENOMEM;
+                        goto out;
+                }
+
+                qr_validate_cache (frame, this, fd, stub);
+        } else {
+                if (qr_fd_ctx) {
+                        LOCK (&qr_fd_ctx->lock);
+                        {
+                                path = qr_fd_ctx->path;
+                                flags = qr_fd_ctx->flags;
+
+                                if (!(qr_fd_ctx->opened
+                                      || qr_fd_ctx->open_in_transit)) {
+                                        need_open = 1;
+                                        qr_fd_ctx->open_in_transit = 1;
+                                }
+
+                                if (qr_fd_ctx->opened) {
+                                        can_wind = 1;
+                                } else {
+                                        if (frame->local == NULL) {
+                                                frame->local
+                                                        = qr_local_new (this);
+                                                if (frame->local == NULL) {
+                                                        op_ret = -1;
+                                                        op_errno = ENOMEM;
+                                                        need_unwind = 1;
+                                                        qr_fd_ctx->open_in_transit = 0;
+                                                        goto fdctx_unlock;
+                                                }
+                                        }
+
+                                        stub = fop_readv_stub (frame,
+                                                               qr_readv_helper,
+                                                               fd, size,
+                                                               offset,
+                                                               read_flags, xdata);
+                                        if (stub == NULL) {
+                                                op_ret = -1;
+                                                op_errno = ENOMEM;
+                                                need_unwind = 1;
+                                                qr_fd_ctx->open_in_transit = 0;
+                                                goto fdctx_unlock;
+                                        }
+
+                                        list_add_tail (&stub->list,
+                                                       &qr_fd_ctx->waiting_ops);
+                                }
+                        }
+                fdctx_unlock:
+                        UNLOCK (&qr_fd_ctx->lock);
+
+                        if (op_ret == -1) {
+                                need_unwind = 1;
+                                goto out;
+                        }
+                } else {
+                        can_wind = 1;
+                }
+
+                if (need_open) {
+                        op_ret = qr_loc_fill (&loc, fd->inode, path);
+                        if (op_ret == -1) {
+                                qr_resume_pending_ops (qr_fd_ctx, -1, errno);
+                                goto ret;
+                        }
+
+                        open_frame = create_frame (this, this->ctx->pool);
+                        if (open_frame == NULL) {
+                                qr_resume_pending_ops (qr_fd_ctx, -1, ENOMEM);
+                                qr_loc_wipe (&loc);
+                                goto ret;
+                        }
+
+                        STACK_WIND (open_frame, qr_open_cbk, FIRST_CHILD(this),
+                                    FIRST_CHILD(this)->fops->open,
+                                    &loc, flags, fd, NULL);
+
+                        qr_loc_wipe (&loc);
+                } else if (can_wind) {
+                        STACK_WIND (frame, qr_readv_cbk, FIRST_CHILD (this),
+                                    FIRST_CHILD (this)->fops->readv, fd, size,
+                                    offset, read_flags, xdata);
+                }
+        }
+
+ret:
+        GF_FREE (vector);
+
+        if (iobref) {
+                iobref_unref (iobref);
+        }
+
+        return 0;
+}
+
+
+int32_t
+qr_writev_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+               struct iatt *postbuf, dict_t *xdata)
+{
+        GF_ASSERT (frame);
+        QR_STACK_UNWIND (writev, frame, op_ret, op_errno, prebuf, postbuf,
+                         xdata);
+        return 0;
+}
+
+
+int32_t
+qr_writev_helper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                  struct iovec *vector, int32_t count, off_t off,
+                  uint32_t flags, struct iobref *iobref, dict_t *xdata)
+{
+        qr_local_t  *local    = NULL;
+        qr_fd_ctx_t *fdctx    = NULL;
+        uint64_t     value    = 0;
+        int32_t      ret      = 0;
+        int32_t      op_errno = EINVAL;
+
+        GF_ASSERT (frame);
+
+        local = frame->local;
+        GF_VALIDATE_OR_GOTO (frame->this->name, local, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, this, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, fd, unwind);
+
+        if (local->op_ret < 0) {
+                op_errno = local->op_errno;
+
+                ret = fd_ctx_get (fd, this, &value);
+                if (ret == 0) {
+                        fdctx = (qr_fd_ctx_t *)(long) value;
+                }
+
+                gf_log (this->name, GF_LOG_WARNING,
+                        "open failed on path (%s) (%s), unwinding write call",
+                        fdctx ? fdctx->path : NULL, strerror (errno));
+                goto unwind;
+        }
+
+        STACK_WIND (frame, qr_writev_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->writev, fd, vector, count, off,
+                    flags, iobref, xdata);
+        return 0;
+
+unwind:
+        QR_STACK_UNWIND (writev, frame, -1, op_errno, NULL, NULL, NULL);
+        return 0;
+}
+
+
+int32_t
+qr_writev (call_frame_t *frame, xlator_t *this, fd_t *fd, struct iovec *vector,
+           int32_t count, off_t off, uint32_t wr_flags, struct iobref *iobref,
+           dict_t *xdata)
+{
+        uint64_t          value      = 0;
+        int               flags      = 0;
+        call_stub_t      *stub       = NULL;
+        char             *path       = NULL;
+        loc_t             loc        = {0, };
+        qr_inode_t       *qr_inode   = NULL;
+        qr_fd_ctx_t      *qr_fd_ctx  = NULL;
+        int32_t           op_ret     = -1, op_errno = -1, ret = -1;
+        char              can_wind   = 0, need_unwind = 0, need_open = 0;
+        qr_private_t     *priv       = NULL;
+        qr_inode_table_t *table      = NULL;
+        call_frame_t     *open_frame = NULL;
+
+        priv = this->private;
+        table = qr_inode_table_get (priv, fd->inode);
+
+        ret = fd_ctx_get (fd, this, &value);
+
+        if (ret == 0) {
+                qr_fd_ctx = (qr_fd_ctx_t *)(long) value;
+        }
+
+        LOCK (&table->lock);
+        {
+                ret = inode_ctx_get (fd->inode, this, &value);
+                if (ret == 0) {
+                        qr_inode = (qr_inode_t *)(long)value;
+                        if (qr_inode != NULL) {
+                                inode_ctx_del (fd->inode, this, NULL);
+                                __qr_inode_free (qr_inode);
+                        }
+                }
+        }
+        UNLOCK (&table->lock);
+
+        if (qr_fd_ctx) {
+                LOCK (&qr_fd_ctx->lock);
+                {
+                        path = qr_fd_ctx->path;
+                        flags = qr_fd_ctx->flags;
+
+                        if (!(qr_fd_ctx->opened
+                              || qr_fd_ctx->open_in_transit)) {
+                                need_open = 1;
+                                qr_fd_ctx->open_in_transit = 1;
+                        }
+
+                        if (qr_fd_ctx->opened) {
+                                can_wind = 1;
+                        } else {
+                                frame->local = qr_local_new (this);
+                                if (frame->local == NULL) {
+                                        op_ret = -1;
+                                        op_errno = ENOMEM;
+                                        need_unwind = 1;
+                                        qr_fd_ctx->open_in_transit = 0;
+                                        goto unlock;
+                                }
+
+                                stub = fop_writev_stub (frame, qr_writev_helper,
+                                                        fd, vector, count, off,
+                                                        wr_flags, iobref, xdata);
+                                if (stub == NULL) {
+                                        op_ret = -1;
+                                        op_errno = ENOMEM;
+                                        need_unwind = 1;
+                                        qr_fd_ctx->open_in_transit = 0;
+                                        goto unlock;
+                                }
+
+                                list_add_tail (&stub->list,
+                                               &qr_fd_ctx->waiting_ops);
+                        }
+                }
+        unlock:
+                UNLOCK (&qr_fd_ctx->lock);
+        } else {
+                can_wind = 1;
+        }
+
+        if (need_unwind) {
+                QR_STACK_UNWIND (writev, frame, op_ret, op_errno, NULL, NULL, NULL);
+        } else if (can_wind) {
+                STACK_WIND (frame, qr_writev_cbk, FIRST_CHILD (this),
+                            FIRST_CHILD (this)->fops->writev, fd, vector, count,
+                            off, wr_flags, iobref, xdata);
+        } else if (need_open) {
+                op_ret = qr_loc_fill (&loc, fd->inode, path);
+                if (op_ret == -1) {
+                        qr_resume_pending_ops (qr_fd_ctx, -1, errno);
+                        goto ret;
+                }
+
+                open_frame = create_frame (this, this->ctx->pool);
+                if (open_frame == NULL) {
+                        qr_resume_pending_ops (qr_fd_ctx, -1, ENOMEM);
+                        qr_loc_wipe (&loc);
+                        goto ret;
+                }
+
+                STACK_WIND (open_frame, qr_open_cbk, FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->open, &loc, flags, fd,
+                            NULL);
+
+                qr_loc_wipe (&loc);
+        }
+
+ret:
+        return 0;
+}
+
+
+int32_t
+qr_fallocate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                  struct iatt *postbuf, dict_t *xdata)
+{
+        GF_ASSERT (frame);
+        QR_STACK_UNWIND (fallocate, frame, op_ret, op_errno, prebuf, postbuf,
+                         xdata);
+        return 0;
+}
+
+
+int32_t
+qr_fallocate_helper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                     int32_t keep_size, off_t offset, size_t len,
+                     dict_t *xdata)
+{
+        qr_local_t  *local    = NULL;
+        qr_fd_ctx_t *fdctx    = NULL;
+        uint64_t     value    = 0;
+        int32_t      ret      = 0;
+        int32_t      op_errno = EINVAL;
+
+        GF_ASSERT (frame);
+
+        local = frame->local;
+        GF_VALIDATE_OR_GOTO (frame->this->name, local, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, this, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, fd, unwind);
+
+        if (local->op_ret < 0) {
+                op_errno = local->op_errno;
+
+                ret = fd_ctx_get (fd, this, &value);
+                if (ret == 0) {
+                        fdctx = (qr_fd_ctx_t *)(long) value;
+                }
+
+                gf_log (this->name, GF_LOG_WARNING,
+                        "open failed on path (%s) (%s), unwinding fallocate "
+                        "call",
+                        fdctx ? fdctx->path : NULL, strerror (errno));
+                goto unwind;
+        }
+
+        STACK_WIND (frame, qr_fallocate_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fallocate, fd, keep_size, offset,
+                    len, xdata);
+        return 0;
+
+unwind:
+        QR_STACK_UNWIND (fallocate, frame, -1, op_errno, NULL, NULL, NULL);
+        return 0;
+}
+
+
+int32_t
+qr_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t keep_size,
+              off_t offset, size_t len, dict_t *xdata)
+{
+        uint64_t          value      = 0;
+        int               flags      = 0;
+        call_stub_t      *stub       = NULL;
+        char             *path       = NULL;
+        loc_t             loc        = {0, };
+        qr_inode_t       *qr_inode   = NULL;
+        qr_fd_ctx_t      *qr_fd_ctx  = NULL;
+        int32_t           op_ret     = -1, op_errno = -1, ret = -1;
+        char              can_wind   = 0, need_unwind = 0, need_open = 0;
+        qr_private_t     *priv       = NULL;
+        qr_inode_table_t *table      = NULL;
+        call_frame_t     *open_frame = NULL;
+
+        priv = this->private;
+        table = qr_inode_table_get (priv, fd->inode);
+
+        LOCK (&table->lock);
+        {
+                ret = inode_ctx_get (fd->inode, this, &value);
+                if (ret == 0) {
+                        qr_inode = (qr_inode_t *)(long)value;
+                        if (qr_inode != NULL) {
+                                inode_ctx_del (fd->inode, this, NULL);
+                                __qr_inode_free (qr_inode);
+                        }
+                }
+        }
+        UNLOCK (&table->lock);
+
+        ret = fd_ctx_get (fd, this, &value);
+
+        if (ret == 0) {
+                qr_fd_ctx = (qr_fd_ctx_t *)(long) value;
+        }
+
+        if (qr_fd_ctx) {
+                LOCK (&qr_fd_ctx->lock);
+                {
+                        path = qr_fd_ctx->path;
+                        flags = qr_fd_ctx->flags;
+
+                        if (!(qr_fd_ctx->opened
+                              || qr_fd_ctx->open_in_transit)) {
+                                need_open = 1;
+                                qr_fd_ctx->open_in_transit = 1;
+                        }
+
+                        if (qr_fd_ctx->opened) {
+                                can_wind = 1;
+                        } else {
+                                frame->local = qr_local_new (this);
+                                if (frame->local == NULL) {
+                                        op_ret = -1;
+                                        op_errno = ENOMEM;
+                                        need_unwind = 1;
+                                        qr_fd_ctx->open_in_transit = 0;
+                                        goto unlock;
+                                }
+
+                                stub = fop_fallocate_stub (frame,
+                                                           qr_fallocate_helper,
+                                                           fd, keep_size,
+                                                           offset, len, xdata);
+                                if (stub == NULL) {
+                                        op_ret = -1;
+                                        op_errno = ENOMEM;
+                                        need_unwind = 1;
+                                        qr_fd_ctx->open_in_transit = 0;
+                                        goto unlock;
+                                }
+
+                                list_add_tail (&stub->list,
+                                               &qr_fd_ctx->waiting_ops);
+                        }
+                }
+        unlock:
+                UNLOCK (&qr_fd_ctx->lock);
+        } else {
+                can_wind = 1;
+        }
+
+        if (need_unwind) {
+                QR_STACK_UNWIND (fallocate, frame, op_ret, op_errno, NULL,
+                                 NULL, NULL);
+        } else if (can_wind) {
+                STACK_WIND (frame, qr_fallocate_cbk, FIRST_CHILD (this),
+                            FIRST_CHILD (this)->fops->fallocate, fd, keep_size,
+                            offset, len, xdata);
+        } else if (need_open) {
+                op_ret = qr_loc_fill (&loc, fd->inode, path);
+                if (op_ret == -1) {
+                        qr_resume_pending_ops (qr_fd_ctx, -1, errno);
+                        goto ret;
+                }
+
+                open_frame = create_frame (this, this->ctx->pool);
+                if (open_frame == NULL) {
+                        qr_resume_pending_ops (qr_fd_ctx, -1, ENOMEM);
+                        qr_loc_wipe (&loc);
+                        goto ret;
+                }
+
+                STACK_WIND (open_frame, qr_open_cbk, FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->open, &loc, flags, fd,
+                            NULL);
+
+                qr_loc_wipe (&loc);
+        }
+
+ret:
+        return 0;
+}
+
+
+int32_t
+qr_discard_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                struct iatt *postbuf, dict_t *xdata)
+{
+        GF_ASSERT (frame);
+        QR_STACK_UNWIND (discard, frame, op_ret, op_errno, prebuf, postbuf,
+                         xdata);
+        return 0;
+}
+
+
+int32_t
+qr_discard_helper (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+                   size_t len, dict_t *xdata)
+{
+        qr_local_t  *local    = NULL;
+        qr_fd_ctx_t *fdctx    = NULL;
+        uint64_t     value    = 0;
+        int32_t      ret      = 0;
+        int32_t      op_errno = EINVAL;
+
+        GF_ASSERT (frame);
+
+        local = frame->local;
+        GF_VALIDATE_OR_GOTO (frame->this->name, local, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, this, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, fd, unwind);
+
+        if (local->op_ret < 0) {
+                op_errno = local->op_errno;
+
+                ret = fd_ctx_get (fd, this, &value);
+                if (ret == 0) {
+                        fdctx = (qr_fd_ctx_t *)(long) value;
+                }
+
+                gf_log (this->name, GF_LOG_WARNING,
+                        "open failed on path (%s) (%s), unwinding discard "
+                        "call",
+                        fdctx ? fdctx->path : NULL, strerror (errno));
+                goto unwind;
+        }
+
+        STACK_WIND (frame, qr_discard_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->discard, fd, offset, len, xdata);
+        return 0;
+
+unwind:
+        QR_STACK_UNWIND (discard, frame, -1, op_errno, NULL, NULL, NULL);
+        return 0;
+}
+
+
+int32_t
+qr_discard (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+            size_t len, dict_t *xdata)
+{
+        uint64_t          value      = 0;
+        int               flags      = 0;
+        call_stub_t      *stub       = NULL;
+        char             *path       = NULL;
+        loc_t             loc        = {0, };
+        qr_inode_t       *qr_inode   = NULL;
+        qr_fd_ctx_t      *qr_fd_ctx  = NULL;
+        int32_t           op_ret     = -1, op_errno = -1, ret = -1;
+        char              can_wind   = 0, need_unwind = 0, need_open = 0;
+        qr_private_t     *priv       = NULL;
+        qr_inode_table_t *table      = NULL;
+        call_frame_t     *open_frame = NULL;
+
+        priv = this->private;
+        table = qr_inode_table_get (priv, fd->inode);
+
+        LOCK (&table->lock);
+        {
+                ret = inode_ctx_get (fd->inode, this, &value);
+                if (ret == 0) {
+                        qr_inode = (qr_inode_t *)(long)value;
+                        if (qr_inode != NULL) {
+                                inode_ctx_del (fd->inode, this, NULL);
+                                __qr_inode_free (qr_inode);
+                        }
+                }
+        }
+        UNLOCK (&table->lock);
+
+        ret = fd_ctx_get (fd, this, &value);
+
+        if (ret == 0) {
+                qr_fd_ctx = (qr_fd_ctx_t *)(long) value;
+        }
+
+        if (qr_fd_ctx) {
+                LOCK (&qr_fd_ctx->lock);
+                {
+                        path = qr_fd_ctx->path;
+                        flags = qr_fd_ctx->flags;
+
+                        if (!(qr_fd_ctx->opened
+                              || qr_fd_ctx->open_in_transit)) {
+                                need_open = 1;
+                                qr_fd_ctx->open_in_transit = 1;
+                        }
+
+                        if (qr_fd_ctx->opened) {
+                                can_wind = 1;
+                        } else {
+                                frame->local = qr_local_new (this);
+                                if (frame->local == NULL) {
+                                        op_ret = -1;
+                                        op_errno = ENOMEM;
+                                        need_unwind = 1;
+                                        qr_fd_ctx->open_in_transit = 0;
+                                        goto unlock;
+                                }
+
+                                stub = fop_discard_stub (frame,
+                                                         qr_discard_helper, fd,
+                                                         offset, len, xdata);
+                                if (stub == NULL) {
+                                        op_ret = -1;
+                                        op_errno = ENOMEM;
+                                        need_unwind = 1;
+                                        qr_fd_ctx->open_in_transit = 0;
+                                        goto unlock;
+                                }
+
+                                list_add_tail (&stub->list,
+                                               &qr_fd_ctx->waiting_ops);
+                        }
+                }
+        unlock:
+                UNLOCK (&qr_fd_ctx->lock);
+        } else {
+                can_wind = 1;
+        }
+
+        if (need_unwind) {
+                QR_STACK_UNWIND (discard, frame, op_ret, op_errno, NULL,
+                                 NULL, NULL);
+        } else if (can_wind) {
+                STACK_WIND (frame, qr_discard_cbk, FIRST_CHILD (this),
+                            FIRST_CHILD (this)->fops->discard, fd, offset, len,
+                            xdata);
+        } else if (need_open) {
+                op_ret = qr_loc_fill (&loc, fd->inode, path);
+                if (op_ret == -1) {
+                        qr_resume_pending_ops (qr_fd_ctx, -1, errno);
+                        goto ret;
+                }
+
+                open_frame = create_frame (this, this->ctx->pool);
+                if (open_frame == NULL) {
+                        qr_resume_pending_ops (qr_fd_ctx, -1, ENOMEM);
+                        qr_loc_wipe (&loc);
+                        goto ret;
+                }
+
+                STACK_WIND (open_frame, qr_open_cbk, FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->open, &loc, flags, fd,
+                            NULL);
+
+                qr_loc_wipe (&loc);
+        }
+
+ret:
+        return 0;
+}
+
+
+int32_t
+qr_zerofill_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                 struct iatt *postbuf, dict_t *xdata)
+{
+        GF_ASSERT (frame);
+        QR_STACK_UNWIND (zerofill, frame, op_ret, op_errno, prebuf, postbuf,
+                         xdata);
+        return 0;
+}
+
+
+int32_t
+qr_zerofill_helper (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+                    off_t len, dict_t *xdata)
+{
+        qr_local_t  *local    = NULL;
+        qr_fd_ctx_t *fdctx    = NULL;
+        uint64_t     value    = 0;
+        int32_t      ret      = 0;
+        int32_t      op_errno = EINVAL;
+
+        GF_ASSERT (frame);
+
+        local = frame->local;
+        GF_VALIDATE_OR_GOTO (frame->this->name, local, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, this, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, fd, unwind);
+
+        if (local->op_ret < 0) {
+                op_errno = local->op_errno;
+
+                ret = fd_ctx_get (fd, this, &value);
+                if (ret == 0) {
+                        fdctx = (qr_fd_ctx_t *)(long) value;
+                }
+
+                gf_log (this->name, GF_LOG_WARNING,
+                        "open failed on path (%s) (%s), unwinding zerofill "
+                        "call",
+                        fdctx ? fdctx->path : NULL, strerror (errno));
+                goto unwind;
+        }
+
+        STACK_WIND (frame, qr_zerofill_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->zerofill, fd, offset, len, xdata);
+        return 0;
+
+unwind:
+        QR_STACK_UNWIND (zerofill, frame, -1, op_errno, NULL, NULL, NULL);
+        return 0;
+}
+
+
+int32_t
+qr_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+             off_t len, dict_t *xdata)
+{
+        uint64_t          value      = 0;
+        int               flags      = 0;
+        call_stub_t      *stub       = NULL;
+        char             *path       = NULL;
+        loc_t             loc        = {0, };
+        qr_inode_t       *qr_inode   = NULL;
+        qr_fd_ctx_t      *qr_fd_ctx  = NULL;
+        int32_t           op_ret     = -1, op_errno = -1, ret = -1;
+        char              can_wind   = 0, need_unwind = 0, need_open = 0;
+        qr_private_t     *priv       = NULL;
+        qr_inode_table_t *table      = NULL;
+        call_frame_t     *open_frame = NULL;
 
-                        iobref_add (iobref, iobuf);
-                        iobuf_unref (iobuf);
+        priv = this->private;
+        table = qr_inode_table_get (priv, fd->inode);
 
-                        vector[i].iov_base = iobuf->ptr;
-                        vector[i].iov_len = len;
+        LOCK (&table->lock);
+        {
+                ret = inode_ctx_get (fd->inode, this, &value);
+                if (ret == 0) {
+                        qr_inode = (qr_inode_t *)(long)value;
+                        if (qr_inode != NULL) {
+                                inode_ctx_del (fd->inode, this, NULL);
+                                __qr_inode_free (qr_inode);
+                        }
                 }
         }
-unlock:
         UNLOCK (&table->lock);
 
-out:
-        if (content_cached || need_unwind) {
-                QR_STACK_UNWIND (readv, frame, op_ret, op_errno, vector,
-                                 count, &stbuf, iobref, NULL);
-
-        } else if (need_validation) {
-                stub = fop_readv_stub (frame, qr_readv, fd, size, offset,
-                                       read_flags, xdata);
-                if (stub == NULL) {
-                        op_ret = -1;
-                        op_errno = ENOMEM;
-                        goto out;
-                }
+        ret = fd_ctx_get (fd, this, &value);
 
-                qr_validate_cache (frame, this, fd, stub);
-        } else {
-                if (qr_fd_ctx) {
-                        LOCK (&qr_fd_ctx->lock);
-                        {
-                                path = qr_fd_ctx->path;
-                                flags = qr_fd_ctx->flags;
+        if (ret == 0) {
+                qr_fd_ctx = (qr_fd_ctx_t *)(long) value;
+        }
 
-                                if (!(qr_fd_ctx->opened
-                                      || qr_fd_ctx->open_in_transit)) {
-                                        need_open = 1;
-                                        qr_fd_ctx->open_in_transit = 1;
-                                }
+        if (qr_fd_ctx) {
+                LOCK (&qr_fd_ctx->lock);
+                {
+                        path = qr_fd_ctx->path;
+                        flags = qr_fd_ctx->flags;
 
-                                if (qr_fd_ctx->opened) {
-                                        can_wind = 1;
-                                } else {
-                                        if (frame->local == NULL) {
-                                                frame->local
-                                                        = qr_local_new (this);
-                                                if (frame->local == NULL) {
-                                                        op_ret = -1;
-                                                        op_errno = ENOMEM;
-                                                        need_unwind = 1;
-                                                        qr_fd_ctx->open_in_transit = 0;
-                                                        goto fdctx_unlock;
-                                                }
-                                        }
+                        if (!(qr_fd_ctx->opened
+                              || qr_fd_ctx->open_in_transit)) {
+                                need_open = 1;
+                                qr_fd_ctx->open_in_transit = 1;
+                        }
 
-                                        stub = fop_readv_stub (frame,
-                                                               qr_readv_helper,
-                                                               fd, size,
-                                                               offset,
-                                                               read_flags, xdata);
-                                        if (stub == NULL) {
-                                                op_ret = -1;
-                                                op_errno = ENOMEM;
-                                                need_unwind = 1;
-                                                qr_fd_ctx->open_in_transit = 0;
-                                                goto fdctx_unlock;
-                                        }
+                        if (qr_fd_ctx->opened) {
+                                can_wind = 1;
+                        } else {
+                                frame->local = qr_local_new (this);
+                                if (frame->local == NULL) {
+                                        op_ret = -1;
+                                        op_errno = ENOMEM;
+                                        need_unwind = 1;
+                                        qr_fd_ctx->open_in_transit = 0;
+                                        goto unlock;
+                                }
 
-                                        list_add_tail (&stub->list,
-                                                       &qr_fd_ctx->waiting_ops);
+                                stub = fop_zerofill_stub (frame,
+                                                          qr_zerofill_helper,
+                                                          fd, offset, len,
+                                                          xdata);
+                                if (stub == NULL) {
+                                        op_ret = -1;
+                                        op_errno = ENOMEM;
+                                        need_unwind = 1;
+                                        qr_fd_ctx->open_in_transit = 0;
+                                        goto unlock;
                                 }
-                        }
-                fdctx_unlock:
-                        UNLOCK (&qr_fd_ctx->lock);
 
-                        if (op_ret == -1) {
-                                need_unwind = 1;
-                                goto out;
+                                list_add_tail (&stub->list,
+                                               &qr_fd_ctx->waiting_ops);
                         }
-                } else {
-                        can_wind = 1;
                 }
+        unlock:
+                UNLOCK (&qr_fd_ctx->lock);
+        } else {
+                can_wind = 1;
+        }
 
-                if (need_open) {
-                        op_ret = qr_loc_fill (&loc, fd->inode, path);
-                        if (op_ret == -1) {
-                                qr_resume_pending_ops (qr_fd_ctx, -1, errno);
-                                goto ret;
-                        }
-
-                        open_frame = create_frame (this, this->ctx->pool);
-                        if (open_frame == NULL) {
-                                qr_resume_pending_ops (qr_fd_ctx, -1, ENOMEM);
-                                qr_loc_wipe (&loc);
-                                goto ret;
-                        }
-
-                        STACK_WIND (open_frame, qr_open_cbk, FIRST_CHILD(this),
-                                    FIRST_CHILD(this)->fops->open,
-                                    &loc, flags, fd, NULL);
+        if (need_unwind) {
+                QR_STACK_UNWIND (zerofill, frame, op_ret, op_errno, NULL,
+                                 NULL, NULL);
+        } else if (can_wind) {
+                STACK_WIND (frame, qr_zerofill_cbk, FIRST_CHILD (this),
+                            FIRST_CHILD (this)->fops->zerofill, fd, offset, len,
+                            xdata);
+        } else if (need_open) {
+                op_ret = qr_loc_fill (&loc, fd->inode, path);
+                if (op_ret == -1) {
+                        qr_resume_pending_ops (qr_fd_ctx, -1, errno);
+                        goto ret;
+                }
 
+                open_frame = create_frame (this, this->ctx->pool);
+                if (open_frame == NULL) {
+                        qr_resume_pending_ops (qr_fd_ctx, -1, ENOMEM);
                         qr_loc_wipe (&loc);
-                } else if (can_wind) {
-                        STACK_WIND (frame, qr_readv_cbk, FIRST_CHILD (this),
-                                    FIRST_CHILD (this)->fops->readv, fd, size,
-                                    offset, read_flags, xdata);
+                        goto ret;
                 }
-        }
 
-ret:
-        GF_FREE (vector);
+                STACK_WIND (open_frame, qr_open_cbk, FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->open, &loc, flags, fd,
+                            NULL);
 
-        if (iobref) {
-                iobref_unref (iobref);
+                qr_loc_wipe (&loc);
         }
 
+ret:
         return 0;
 }
 
 
 int32_t
-qr_writev_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
-               int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
-               struct iatt *postbuf, dict_t *xdata)
+qr_seek_cbk (call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
+             int32_t op_errno, off_t offset, dict_t *xdata)
 {
         GF_ASSERT (frame);
-        QR_STACK_UNWIND (writev, frame, op_ret, op_errno, prebuf, postbuf,
-                         xdata);
+        QR_STACK_UNWIND (seek, frame, op_ret, op_errno, offset, xdata);
         return 0;
 }
 
 
 int32_t
-qr_writev_helper (call_frame_t *frame, xlator_t *this, fd_t *fd,
-                  struct iovec *vector, int32_t count, off_t off,
-                  uint32_t flags, struct iobref *iobref, dict_t *xdata)
+qr_seek_helper (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+                gf_seek_what_t what, dict_t *xdata)
 {
         qr_local_t  *local    = NULL;
         qr_fd_ctx_t *fdctx    = NULL;
@@ -1418,62 +2307,41 @@ qr_writev_helper (call_frame_t *frame, xlator_t *this, fd_t *fd,
                 }
 
                 gf_log (this->name, GF_LOG_WARNING,
-                        "open failed on path (%s) (%s), unwinding write call",
+                        "open failed on path (%s) (%s), unwinding seek call",
                         fdctx ? fdctx->path : NULL, strerror (errno));
                 goto unwind;
         }
 
-        STACK_WIND (frame, qr_writev_cbk, FIRST_CHILD (this),
-                    FIRST_CHILD (this)->fops->writev, fd, vector, count, off,
-                    flags, iobref, xdata);
+        STACK_WIND (frame, qr_seek_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->seek, fd, offset, what, xdata);
         return 0;
 
 unwind:
-        QR_STACK_UNWIND (writev, frame, -1, op_errno, NULL, NULL, NULL);
+        QR_STACK_UNWIND (seek, frame, -1, op_errno, 0, NULL);
         return 0;
 }
 
 
 int32_t
-qr_writev (call_frame_t *frame, xlator_t *this, fd_t *fd, struct iovec *vector,
-           int32_t count, off_t off, uint32_t wr_flags, struct iobref *iobref,
-           dict_t *xdata)
+qr_seek (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+         gf_seek_what_t what, dict_t *xdata)
 {
         uint64_t          value      = 0;
         int               flags      = 0;
         call_stub_t      *stub       = NULL;
         char             *path       = NULL;
         loc_t             loc        = {0, };
-        qr_inode_t       *qr_inode   = NULL;
         qr_fd_ctx_t      *qr_fd_ctx  = NULL;
         int32_t           op_ret     = -1, op_errno = -1, ret = -1;
         char              can_wind   = 0, need_unwind = 0, need_open = 0;
-        qr_private_t     *priv       = NULL;
-        qr_inode_table_t *table      = NULL;
         call_frame_t     *open_frame = NULL;
 
-        priv = this->private;
-        table = &priv->table;
-
         ret = fd_ctx_get (fd, this, &value);
 
         if (ret == 0) {
                 qr_fd_ctx = (qr_fd_ctx_t *)(long) value;
         }
 
-        LOCK (&table->lock);
-        {
-                ret = inode_ctx_get (fd->inode, this, &value);
-                if (ret == 0) {
-                        qr_inode = (qr_inode_t *)(long)value;
-                        if (qr_inode != NULL) {
-                                inode_ctx_del (fd->inode, this, NULL);
-                                __qr_inode_free (qr_inode);
-                        }
-                }
-        }
-        UNLOCK (&table->lock);
-
         if (qr_fd_ctx) {
                 LOCK (&qr_fd_ctx->lock);
                 {
@@ -1498,9 +2366,8 @@ qr_writev (call_frame_t *frame, xlator_t *this, fd_t *fd, struct iovec *vector,
                                         goto unlock;
                                 }
 
-                                stub = fop_writev_stub (frame, qr_writev_helper,
-                                                        fd, vector, count, off,
-                                                        wr_flags, iobref, xdata);
+                                stub = fop_seek_stub (frame, qr_seek_helper, fd,
+                                                      offset, what, xdata);
                                 if (stub == NULL) {
                                         op_ret = -1;
                                         op_errno = ENOMEM;
@@ -1520,11 +2387,11 @@ qr_writev (call_frame_t *frame, xlator_t *this, fd_t *fd, struct iovec *vector,
         }
 
         if (need_unwind) {
-                QR_STACK_UNWIND (writev, frame, op_ret, op_errno, NULL, NULL, NULL);
+                QR_STACK_UNWIND (seek, frame, op_ret, op_errno, 0, NULL);
         } else if (can_wind) {
-                STACK_WIND (frame, qr_writev_cbk, FIRST_CHILD (this),
-                            FIRST_CHILD (this)->fops->writev, fd, vector, count,
-                            off, wr_flags, iobref, xdata);
+                STACK_WIND (frame, qr_seek_cbk, FIRST_CHILD (this),
+                            FIRST_CHILD (this)->fops->seek, fd, offset, what,
+                            xdata);
         } else if (need_open) {
                 op_ret = qr_loc_fill (&loc, fd->inode, path);
                 if (op_ret == -1) {
@@ -2821,7 +3688,7 @@ qr_ftruncate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         }
 
         priv = this->private;
-        table = &priv->table;
+        table = qr_inode_table_get (priv, local->fd->inode);
 
         LOCK (&table->lock);
         {
@@ -3397,18 +4264,20 @@ out:
 int32_t
 qr_forget (xlator_t *this, inode_t *inode)
 {
-        qr_inode_t   *qr_inode = NULL;
-        uint64_t      value     = 0;
-        int32_t       ret       = -1;
-        qr_private_t *priv      = NULL;
+        qr_inode_t       *qr_inode = NULL;
+        uint64_t          value    = 0;
+        int32_t           ret      = -1;
+        qr_private_t     *priv     = NULL;
+        qr_inode_table_t *table    = NULL;
 
         GF_VALIDATE_OR_GOTO ("quick-read", this, out);
         GF_VALIDATE_OR_GOTO (this->name, this->private, out);
         GF_VALIDATE_OR_GOTO (this->name, inode, out);
 
         priv = this->private;
+        table = qr_inode_table_get (priv, inode);
 
-        LOCK (&priv->table.lock);
+        LOCK (&table->lock);
         {
                 ret = inode_ctx_del (inode, this, &value);
                 if (ret == 0) {
@@ -3416,7 +4285,7 @@ qr_forget (xlator_t *this, inode_t *inode)
                         __qr_inode_free (qr_inode);
                 }
         }
-        UNLOCK (&priv->table.lock);
+        UNLOCK (&table->lock);
 
 out:
         return 0;
@@ -3542,9 +4411,11 @@ qr_priv_dump (xlator_t *this)
         qr_inode_table_t *table      = NULL;
         uint32_t          file_count = 0;
         uint32_t          i          = 0;
+        int32_t           j          = 0;
         qr_inode_t       *curr       = NULL;
         uint64_t          total_size = 0;
         char              key_prefix[GF_DUMP_MAX_BUF_LEN];
+        char              key[GF_DUMP_MAX_BUF_LEN];
 
         if (!this) {
                 return -1;
@@ -3558,9 +4429,6 @@ qr_priv_dump (xlator_t *this)
                 return -1;
         }
 
-        table = &priv->table;
-
-
         gf_proc_dump_build_key (key_prefix, "xlator.performance.quick-read",
                                 "priv");
 
@@ -3568,17 +4436,36 @@ qr_priv_dump (xlator_t *this)
 
         gf_proc_dump_write ("max_file_size", "%d", conf->max_file_size);
         gf_proc_dump_write ("cache_timeout", "%d", conf->cache_timeout);
+        gf_proc_dump_write ("cache_shards", "%d", priv->table_count);
 
-        if (!table) {
+        if (!priv->table) {
                 gf_log (this->name, GF_LOG_WARNING, "table is NULL");
                 goto out;
-        } else {
-                for (i = 0; i < conf->max_pri; i++) {
-                        list_for_each_entry (curr, &table->lru[i], lru) {
-                                file_count++;
-                                total_size += curr->stbuf.ia_size;
+        }
+
+        for (j = 0; j < priv->table_count; j++) {
+                table = &priv->table[j];
+
+                LOCK (&table->lock);
+                {
+                        for (i = 0; i < conf->max_pri; i++) {
+                                list_for_each_entry (curr, &table->lru[i],
+                                                     lru) {
+                                        file_count++;
+                                        total_size += curr->stbuf.ia_size;
+                                }
                         }
+
+                        snprintf (key, sizeof (key), "shard[%d].cache_used",
+                                  j);
+                        gf_proc_dump_write (key, "%"PRIu64,
+                                            table->cache_used);
+                        snprintf (key, sizeof (key),
+                                  "shard[%d].readdirp_cached", j);
+                        gf_proc_dump_write (key, "%"PRIu64,
+                                            table->readdirp_cached);
                 }
+                UNLOCK (&table->lock);
         }
 
         gf_proc_dump_write ("total_files_cached", "%d", file_count);
@@ -3666,6 +4553,12 @@ reconfigure (xlator_t *this, dict_t *options)
         GF_OPTION_RECONF ("cache-timeout", conf->cache_timeout, options, int32,
                           out);
 
+        GF_OPTION_RECONF ("cache-on-readdirp", conf->cache_on_readdirp,
+                          options, bool, out);
+
+        GF_OPTION_RECONF ("readdirp-max-file-size",
+                          conf->readdirp_max_file_size, options, size, out);
+
         GF_OPTION_RECONF ("cache-size", cache_size_new, options, size, out);
         if (!check_cache_size_ok (this, cache_size_new)) {
                 ret = -1;
@@ -3782,9 +4675,10 @@ out:
 int32_t
 init (xlator_t *this)
 {
-        int32_t       ret  = -1, i = 0;
-        qr_private_t *priv = NULL;
-        qr_conf_t    *conf = NULL;
+        int32_t           ret   = -1, i = 0, j = 0;
+        qr_private_t     *priv  = NULL;
+        qr_conf_t        *conf  = NULL;
+        qr_inode_table_t *table = NULL;
 
         if (!this->children || this->children->next) {
                 gf_log (this->name, GF_LOG_ERROR,
@@ -3804,9 +4698,10 @@ init (xlator_t *this)
                 goto out;
         }
 
-        LOCK_INIT (&priv->table.lock);
         conf = &priv->conf;
 
+        GF_OPTION_INIT ("cache-shards", priv->table_count, int32, out);
+
         GF_OPTION_INIT ("max-file-size", conf->max_file_size, size, out);
 
         GF_OPTION_INIT ("cache-timeout", conf->cache_timeout, int32, out);
@@ -3817,6 +4712,12 @@ init (xlator_t *this)
                 goto out;
         }
 
+        GF_OPTION_INIT ("cache-on-readdirp", conf->cache_on_readdirp, bool,
+                        out);
+
+        GF_OPTION_INIT ("readdirp-max-file-size",
+                        conf->readdirp_max_file_size, size, out);
+
         INIT_LIST_HEAD (&conf->priority_list);
         conf->max_pri = 1;
         if (dict_get (this->options, "priority")) {
@@ -3834,15 +4735,27 @@ init (xlator_t *this)
                 conf->max_pri ++;
         }
 
-        priv->table.lru = GF_CALLOC (conf->max_pri, sizeof (*priv->table.lru),
-                                     gf_common_mt_list_head);
-        if (priv->table.lru == NULL) {
+        priv->table = GF_CALLOC (priv->table_count, sizeof (*priv->table),
+                                 gf_qr_mt_qr_inode_table_t);
+        if (priv->table == NULL) {
                 ret = -1;
                 goto out;
         }
 
-        for (i = 0; i < conf->max_pri; i++) {
-                INIT_LIST_HEAD (&priv->table.lru[i]);
+        for (j = 0; j < priv->table_count; j++) {
+                table = &priv->table[j];
+
+                LOCK_INIT (&table->lock);
+                table->lru = GF_CALLOC (conf->max_pri, sizeof (*table->lru),
+                                        gf_common_mt_list_head);
+                if (table->lru == NULL) {
+                        ret = -1;
+                        goto out;
+                }
+
+                for (i = 0; i < conf->max_pri; i++) {
+                        INIT_LIST_HEAD (&table->lru[i]);
+                }
         }
 
         this->local_pool = mem_pool_new (qr_local_t, 64);
@@ -3858,6 +4771,12 @@ init (xlator_t *this)
         this->private = priv;
 out:
         if ((ret == -1) && priv) {
+                if (priv->table) {
+                        for (j = 0; j < priv->table_count; j++) {
+                                GF_FREE (priv->table[j].lru);
+                        }
+                        GF_FREE (priv->table);
+                }
                 GF_FREE (priv);
         }
 
@@ -3868,16 +4787,26 @@ out:
 void
 qr_inode_table_destroy (qr_private_t *priv)
 {
-        int        i    = 0;
-        qr_conf_t *conf = NULL;
+        int               i     = 0;
+        int               j     = 0;
+        qr_conf_t        *conf  = NULL;
+        qr_inode_table_t *table = NULL;
 
         conf = &priv->conf;
 
-        for (i = 0; i < conf->max_pri; i++) {
-                GF_ASSERT (list_empty (&priv->table.lru[i]));
+        for (j = 0; j < priv->table_count; j++) {
+                table = &priv->table[j];
+
+                for (i = 0; i < conf->max_pri; i++) {
+                        GF_ASSERT (list_empty (&table->lru[i]));
+                }
+
+                LOCK_DESTROY (&table->lock);
+                GF_FREE (table->lru);
         }
 
-        LOCK_DESTROY (&priv->table.lock);
+        GF_FREE (priv->table);
+        priv->table = NULL;
 
         return;
 }
@@ -3927,6 +4856,10 @@ struct xlator_fops fops = {
         .open        = qr_open,
         .readv       = qr_readv,
         .writev      = qr_writev,
+        .fallocate   = qr_fallocate,
+        .discard     = qr_discard,
+        .zerofill    = qr_zerofill,
+        .seek        = qr_seek,
         .fstat       = qr_fstat,
         .fsetxattr   = qr_fsetxattr,
         .fgetxattr   = qr_fgetxattr,
@@ -3938,6 +4871,8 @@ struct xlator_fops fops = {
         .lk          = qr_lk,
         .fsetattr    = qr_fsetattr,
         .unlink      = qr_unlink,
+        .readdirp    = qr_readdirp,
+        .opendir     = qr_opendir,
 };
 
 struct xlator_cbks cbks = {
@@ -3974,4 +4909,28 @@ struct volume_options options[] = {
           .max  = 1 * GF_UNIT_KB * 1000,
           .default_value = "64KB",
         },
+        { .key  = {"cache-shards"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 1,
+          .max  = 64,
+          .default_value = "8",
+          .description = "Number of independently locked partitions of the "
+                         "cache. Each gets an equal share of cache-size."
+        },
+        { .key  = {"cache-on-readdirp"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Fetch the content of small files along with "
+                         "readdirp, so that files read in directory order "
+                         "are served from the cache without a lookup each."
+        },
+        { .key  = {"readdirp-max-file-size"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .min  = 0,
+          .max  = 1 * GF_UNIT_KB * 1000,
+          .default_value = "8KB",
+          .description = "Files up to this size get their content fetched "
+                         "in readdirp when cache-on-readdirp is on. It is "
+                         "further capped by max-file-size."
+        },
 };
@@ -64,9 +64,12 @@ struct qr_local {
 };
 typedef struct qr_local qr_local_t;
 
+struct qr_inode_table;
+
 struct qr_inode {
         dict_t           *xattr;
         inode_t          *inode;
+        struct qr_inode_table *table;
         int               priority;
         struct iatt       stbuf;
         struct timeval    tv;
@@ -89,22 +92,39 @@ struct qr_conf {
         uint64_t         cache_size;
         int              max_pri;
         struct list_head priority_list;
+        gf_boolean_t     cache_on_readdirp;
+        uint64_t         readdirp_max_file_size;
 };
 typedef struct qr_conf qr_conf_t;
 
 struct qr_inode_table {
         uint64_t          cache_used;
+        uint64_t          readdirp_cached; /* files cached from readdirp */
         struct list_head *lru;
         gf_lock_t         lock;
 };
 typedef struct qr_inode_table qr_inode_table_t;
 
+/* the cache is split in table_count shards, each with its own lock, lru
+ * lists and an equal share of cache-size. An inode always maps to the same
+ * shard. */
 struct qr_private {
         qr_conf_t         conf;
-        qr_inode_table_t  table;
+        qr_inode_table_t *table;
+        int32_t           table_count;
 };
 typedef struct qr_private qr_private_t;
 
+static inline qr_inode_table_t *
+qr_inode_table_get (qr_private_t *priv, inode_t *inode)
+{
+        unsigned long index = 0;
+
+        index = ((unsigned long) inode / sizeof (inode_t));
+
+        return &priv->table[index % priv->table_count];
+}
+
 struct qr_unlink_ctx {
         struct list_head  list;
         qr_fd_ctx_t      *fdctx;
@@ -246,6 +246,9 @@ ra_page_fault (ra_file_t *file, call_frame_t *frame, off_t offset)
         GF_VALIDATE_OR_GOTO ("read-ahead", frame, out);
         GF_VALIDATE_OR_GOTO (frame->this->name, file, out);
 
+        if (ra_page_fill_hole (file, frame->this, offset) == 0)
+                goto out;
+
         fault_frame = copy_frame (frame);
         if (fault_frame == NULL) {
                 op_ret = -1;
@@ -293,6 +296,235 @@ out:
 }
 
 
+/* fills the page at offset with zeroes instead of reading it, when it lies
+   in the hole found by ra_hole_probe: 0 when it did */
+int
+ra_page_fill_hole (ra_file_t *file, xlator_t *this, off_t offset)
+{
+        ra_page_t     *page   = NULL;
+        ra_waitq_t    *waitq  = NULL;
+        struct iobuf  *iobuf  = NULL;
+        struct iobref *iobref = NULL;
+        struct iovec   vector = {0, };
+        int            ret    = -1;
+
+        ra_file_lock (file);
+        {
+                if (offset < file->hole_start ||
+                    offset + file->page_size > file->hole_end)
+                        goto unlock;
+
+                page = ra_page_get (file, offset);
+                if (!page)
+                        goto unlock;
+
+                iobuf = iobuf_get2 (this->ctx->iobuf_pool, file->page_size);
+                if (!iobuf)
+                        goto unlock;
+
+                iobref = iobref_new ();
+                if (!iobref)
+                        goto unlock;
+
+                iobref_add (iobref, iobuf);
+                memset (iobuf->ptr, 0, file->page_size);
+                vector.iov_base = iobuf->ptr;
+                vector.iov_len = file->page_size;
+
+                if (page->vector) {
+                        iobref_unref (page->iobref);
+                        GF_FREE (page->vector);
+                }
+
+                page->vector = iov_dup (&vector, 1);
+                if (page->vector == NULL) {
+                        iobref_unref (iobref);
+                        iobref = NULL;
+                        goto unlock;
+                }
+
+                page->count = 1;
+                page->iobref = iobref;
+                iobref = NULL;
+                page->ready = 1;
+                page->size = file->page_size;
+
+                waitq = ra_page_wakeup (page);
+                ret = 0;
+        }
+unlock:
+        ra_file_unlock (file);
+
+        if (iobref)
+                iobref_unref (iobref);
+        if (iobuf)
+                iobuf_unref (iobuf);
+
+        ra_waitq_return (waitq);
+
+        return ret;
+}
+
+
+static void
+ra_hole_probe_done (ra_file_t *file, call_frame_t *frame)
+{
+        ra_local_t *local = NULL;
+
+        local = frame->local;
+
+        ra_file_lock (file);
+        {
+                file->probing = 0;
+        }
+        ra_file_unlock (file);
+
+        fd_unref (local->fd);
+        mem_put (local);
+        frame->local = NULL;
+
+        STACK_DESTROY (frame->root);
+}
+
+
+int
+ra_hole_probe_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                   int32_t op_ret, int32_t op_errno, off_t offset,
+                   dict_t *xdata)
+{
+        ra_local_t   *local    = NULL;
+        ra_file_t    *file     = NULL;
+        uint64_t      tmp_file = 0;
+        off_t         probe    = 0;
+        off_t         size     = 0;
+        gf_seek_what_t what    = (long) cookie;
+
+        local = frame->local;
+        probe = local->pending_offset;
+
+        fd_ctx_get (local->fd, this, &tmp_file);
+        file = (ra_file_t *)(long)tmp_file;
+        if (!file) {
+                fd_unref (local->fd);
+                mem_put (local);
+                frame->local = NULL;
+                STACK_DESTROY (frame->root);
+                goto out;
+        }
+
+        ra_file_lock (file);
+        {
+                size = file->stbuf.ia_size;
+
+                /* written meanwhile: what was found may be data by now */
+                if (local->hole_gen != file->hole_gen)
+                        goto unlock;
+
+                if (op_ret == -1 && op_errno != ENXIO) {
+                        gf_log (this->name, GF_LOG_DEBUG,
+                                "seek failed (%s), holes are read",
+                                strerror (op_errno));
+                        if (op_errno == ENOSYS || op_errno == EOPNOTSUPP ||
+                            op_errno == EINVAL)
+                                file->no_seek = 1;
+                        file->probe_next = size;
+                        goto unlock;
+                }
+
+                if (what == GF_SEEK_HOLE) {
+                        /* no hole before where this data ends */
+                        file->probe_next = (op_ret == -1) ? size : offset;
+                        goto unlock;
+                }
+
+                if (op_ret == -1)
+                        /* ENXIO: no data past probe */
+                        offset = size;
+
+                if (offset > probe) {
+                        file->hole_start = probe;
+                        file->hole_end = min (offset, size);
+                        file->probe_next = offset;
+                        goto unlock;
+                }
+
+                /* probe was in data: where does it end */
+                ra_file_unlock (file);
+
+                STACK_WIND_COOKIE (frame, ra_hole_probe_cbk,
+                                   (void *)(long) GF_SEEK_HOLE,
+                                   FIRST_CHILD (this),
+                                   FIRST_CHILD (this)->fops->seek,
+                                   local->fd, probe, GF_SEEK_HOLE, NULL);
+                goto out;
+        }
+unlock:
+        ra_file_unlock (file);
+
+        ra_hole_probe_done (file, frame);
+out:
+        return 0;
+}
+
+
+/* finds out, in the background, where the hole at or after offset of a
+   sparse file lies, for ra_page_fill_hole */
+void
+ra_hole_probe (call_frame_t *frame, ra_file_t *file, off_t offset)
+{
+        call_frame_t *probe_frame = NULL;
+        ra_local_t   *probe_local = NULL;
+        uint32_t      hole_gen    = 0;
+
+        ra_file_lock (file);
+        {
+                /* not sparse, or no telling yet */
+                if (file->no_seek || file->probing || !file->stbuf.ia_size ||
+                    file->stbuf.ia_blocks * 512 >= file->stbuf.ia_size)
+                        goto unlock;
+
+                if (offset < file->probe_next ||
+                    offset >= file->stbuf.ia_size)
+                        goto unlock;
+
+                file->probing = 1;
+                hole_gen = file->hole_gen;
+        }
+        ra_file_unlock (file);
+
+        probe_frame = copy_frame (frame);
+        if (probe_frame == NULL)
+                goto err;
+
+        probe_local = mem_get0 (THIS->local_pool);
+        if (probe_local == NULL) {
+                STACK_DESTROY (probe_frame->root);
+                goto err;
+        }
+
+        probe_frame->local = probe_local;
+        probe_local->pending_offset = offset;
+        probe_local->hole_gen = hole_gen;
+        probe_local->fd = fd_ref (file->fd);
+
+        STACK_WIND_COOKIE (probe_frame, ra_hole_probe_cbk,
+                           (void *)(long) GF_SEEK_DATA,
+                           FIRST_CHILD (probe_frame->this),
+                           FIRST_CHILD (probe_frame->this)->fops->seek,
+                           file->fd, offset, GF_SEEK_DATA, NULL);
+        return;
+
+err:
+        ra_file_lock (file);
+        {
+                file->probing = 0;
+        }
+unlock:
+        ra_file_unlock (file);
+        return;
+}
+
+
 void
 ra_frame_fill (ra_page_t *page, call_frame_t *frame)
 {
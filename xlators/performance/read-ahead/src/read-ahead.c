@@ -309,6 +309,9 @@ read_ahead (call_frame_t *frame, ra_file_t *file)
 
         cap  = file->size ? file->size : ra_offset + ra_size;
 
+        /* holes ahead are zero filled rather than read, once found */
+        ra_hole_probe (frame, file, trav_offset);
+
         while (trav_offset < min(ra_offset + ra_size, cap)) {
                 fault = 0;
                 ra_file_lock (file);
@@ -674,6 +677,7 @@ ra_writev (call_frame_t *frame, xlator_t *this, fd_t *fd, struct iovec *vector,
         file = (ra_file_t *)(long)tmp_file;
         if (file) {
                 flush_region (frame, file, 0, file->pages.prev->offset+1, 1);
+                ra_file_hole_reset (file);
                 frame->local = file;
                 /* reset the read-ahead counters too */
                 file->expected = file->page_count = 0;
@@ -750,6 +754,7 @@ ra_truncate (call_frame_t *frame, xlator_t *this, loc_t *loc, off_t offset,
                          */
                         flush_region (frame, file, 0,
                                       file->pages.prev->offset + 1, 1);
+                        ra_file_hole_reset (file);
                 }
         }
         UNLOCK (&inode->lock);
@@ -845,6 +850,10 @@ ra_fdctx_dump (xlator_t *this, fd_t *fd)
         gf_proc_dump_write ("next-expected-offset-for-sequential-reads",
                             "%"PRId64, file->offset);
 
+        if (file->hole_end)
+                gf_proc_dump_write ("hole", "%"PRId64" - %"PRId64,
+                                    file->hole_start, file->hole_end);
+
         for (page = file->pages.next; page != &file->pages;
              page = page->next) {
                 sprintf (key, "page[%d]", i);
@@ -929,6 +938,7 @@ ra_ftruncate (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
                          */
                         flush_region (frame, file, 0,
                                       file->pages.prev->offset + 1, 1);
+                        ra_file_hole_reset (file);
                 }
         }
         UNLOCK (&inode->lock);
@@ -943,6 +953,171 @@ unwind:
 }
 
 
+int
+ra_fallocate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                  struct iatt *postbuf, dict_t *xdata)
+{
+        GF_ASSERT (frame);
+
+        STACK_UNWIND_STRICT (fallocate, frame, op_ret, op_errno, prebuf,
+                             postbuf, xdata);
+        return 0;
+}
+
+
+int
+ra_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+              int32_t keep_size, off_t offset, size_t len, dict_t *xdata)
+{
+        ra_file_t *file    = NULL;
+        fd_t      *iter_fd = NULL;
+        inode_t   *inode   = NULL;
+        uint64_t  tmp_file = 0;
+        int32_t   op_errno = EINVAL;
+
+        GF_ASSERT (frame);
+        GF_VALIDATE_OR_GOTO (frame->this->name, this, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, fd, unwind);
+
+        inode = fd->inode;
+
+        LOCK (&inode->lock);
+        {
+                list_for_each_entry (iter_fd, &inode->fd_list, inode_list) {
+                        fd_ctx_get (iter_fd, this, &tmp_file);
+                        file = (ra_file_t *)(long)tmp_file;
+                        if (!file)
+                                continue;
+                        /* changes the data like writing does */
+                        flush_region (frame, file, 0,
+                                      file->pages.prev->offset + 1, 1);
+                        ra_file_hole_reset (file);
+                }
+        }
+        UNLOCK (&inode->lock);
+
+        STACK_WIND (frame, ra_fallocate_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fallocate, fd, keep_size, offset, len,
+                    xdata);
+        return 0;
+
+unwind:
+        STACK_UNWIND_STRICT (fallocate, frame, -1, op_errno, NULL, NULL, NULL);
+        return 0;
+}
+
+
+int
+ra_discard_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                struct iatt *postbuf, dict_t *xdata)
+{
+        GF_ASSERT (frame);
+
+        STACK_UNWIND_STRICT (discard, frame, op_ret, op_errno, prebuf,
+                             postbuf, xdata);
+        return 0;
+}
+
+
+int
+ra_discard (call_frame_t *frame, xlator_t *this, fd_t *fd,
+            off_t offset, size_t len, dict_t *xdata)
+{
+        ra_file_t *file    = NULL;
+        fd_t      *iter_fd = NULL;
+        inode_t   *inode   = NULL;
+        uint64_t  tmp_file = 0;
+        int32_t   op_errno = EINVAL;
+
+        GF_ASSERT (frame);
+        GF_VALIDATE_OR_GOTO (frame->this->name, this, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, fd, unwind);
+
+        inode = fd->inode;
+
+        LOCK (&inode->lock);
+        {
+                list_for_each_entry (iter_fd, &inode->fd_list, inode_list) {
+                        fd_ctx_get (iter_fd, this, &tmp_file);
+                        file = (ra_file_t *)(long)tmp_file;
+                        if (!file)
+                                continue;
+                        /* changes the data like writing does */
+                        flush_region (frame, file, 0,
+                                      file->pages.prev->offset + 1, 1);
+                        ra_file_hole_reset (file);
+                }
+        }
+        UNLOCK (&inode->lock);
+
+        STACK_WIND (frame, ra_discard_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->discard, fd, offset, len,
+                    xdata);
+        return 0;
+
+unwind:
+        STACK_UNWIND_STRICT (discard, frame, -1, op_errno, NULL, NULL, NULL);
+        return 0;
+}
+
+
+int
+ra_zerofill_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                 struct iatt *postbuf, dict_t *xdata)
+{
+        GF_ASSERT (frame);
+
+        STACK_UNWIND_STRICT (zerofill, frame, op_ret, op_errno, prebuf,
+                             postbuf, xdata);
+        return 0;
+}
+
+
+int
+ra_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd,
+             off_t offset, off_t len, dict_t *xdata)
+{
+        ra_file_t *file    = NULL;
+        fd_t      *iter_fd = NULL;
+        inode_t   *inode   = NULL;
+        uint64_t  tmp_file = 0;
+        int32_t   op_errno = EINVAL;
+
+        GF_ASSERT (frame);
+        GF_VALIDATE_OR_GOTO (frame->this->name, this, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, fd, unwind);
+
+        inode = fd->inode;
+
+        LOCK (&inode->lock);
+        {
+                list_for_each_entry (iter_fd, &inode->fd_list, inode_list) {
+                        fd_ctx_get (iter_fd, this, &tmp_file);
+                        file = (ra_file_t *)(long)tmp_file;
+                        if (!file)
+                                continue;
+                        /* changes the data like writing does */
+                        flush_region (frame, file, 0,
+                                      file->pages.prev->offset + 1, 1);
+                        ra_file_hole_reset (file);
+                }
+        }
+        UNLOCK (&inode->lock);
+
+        STACK_WIND (frame, ra_zerofill_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->zerofill, fd, offset, len,
+                    xdata);
+        return 0;
+
+unwind:
+        STACK_UNWIND_STRICT (zerofill, frame, -1, op_errno, NULL, NULL, NULL);
+        return 0;
+}
+
+
 int
 ra_priv_dump (xlator_t *this)
 {
@@ -1119,6 +1294,9 @@ struct xlator_fops fops = {
         .truncate    = ra_truncate,
         .ftruncate   = ra_ftruncate,
         .fstat       = ra_fstat,
+        .fallocate   = ra_fallocate,
+        .discard     = ra_discard,
+        .zerofill    = ra_zerofill,
 };
 
 struct xlator_cbks cbks = {
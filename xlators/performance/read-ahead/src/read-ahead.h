@@ -57,6 +57,7 @@ struct ra_local {
         int32_t           op_errno;
         off_t             pending_offset;
         size_t            pending_size;
+        uint32_t          hole_gen;
         fd_t             *fd;
         int32_t           wait_count;
         pthread_mutex_t   local_lock;
@@ -95,6 +96,16 @@ struct ra_file {
         struct iatt        stbuf;
         uint64_t           page_size;
         uint32_t           page_count;
+
+        /* a hole [hole_start, hole_end) found by seek, its pages are zero
+           filled rather than read. Seeks are not sent below probe_next,
+           and hole_gen is bumped by the writes, which forget the hole. */
+        off_t              hole_start;
+        off_t              hole_end;
+        off_t              probe_next;
+        uint32_t           hole_gen;
+        char               probing;
+        char               no_seek;
 };
 
 
@@ -154,6 +165,12 @@ ra_frame_fill (ra_page_t *page,
 void
 ra_file_destroy (ra_file_t *file);
 
+int
+ra_page_fill_hole (ra_file_t *file, xlator_t *this, off_t offset);
+
+void
+ra_hole_probe (call_frame_t *frame, ra_file_t *file, off_t offset);
+
 static inline void
 ra_file_lock (ra_file_t *file)
 {
@@ -166,6 +183,18 @@ ra_file_unlock (ra_file_t *file)
         pthread_mutex_unlock (&file->file_lock);
 }
 
+static inline void
+ra_file_hole_reset (ra_file_t *file)
+{
+        ra_file_lock (file);
+        {
+                file->hole_start = file->hole_end = 0;
+                file->probe_next = 0;
+                file->hole_gen++;
+        }
+        ra_file_unlock (file);
+}
+
 static inline void
 ra_conf_lock (ra_conf_t *conf)
 {
@@ -0,0 +1,698 @@
+/*
+  Copyright (c) 2012 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/*
+ * performance/readdir-ahead preloads a local buffer with directory entries
+ * as soon as a directory is opened. Subsequent readdirp requests at the
+ * expected offset are served from the buffer, while a single background
+ * request keeps it topped up between the low and high watermarks.
+ *
+ * When loaded beneath each subvolume of cluster/distribute, the opendir
+ * fan-out of distribute starts the prefetch on all subvolumes in parallel,
+ * so the serial readdirp chain of distribute is served from memory rather
+ * than paying a network round-trip per subvolume.
+ *
+ * Offsets handed out are the ones returned by the child, so they remain
+ * stable and resumable. A request at any other offset (seekdir, rewinddir,
+ * NFS cookies) switches the fd to bypass mode and is wound as-is.
+ */
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include "glusterfs.h"
+#include "xlator.h"
+#include "call-stub.h"
+#include "statedump.h"
+#include "readdir-ahead.h"
+#include "readdir-ahead-mem-types.h"
+
+static int rda_fill_fd (call_frame_t *, xlator_t *, fd_t *);
+
+/*
+ * Get (or create) the fd context for storing prepopulated directory
+ * entries.
+ */
+static rda_fd_ctx_t *
+get_rda_fd_ctx (fd_t *fd, xlator_t *this)
+{
+        uint64_t      val = 0;
+        rda_fd_ctx_t *ctx = NULL;
+
+        LOCK (&fd->lock);
+        {
+                if (__fd_ctx_get (fd, this, &val) < 0) {
+                        ctx = GF_CALLOC (1, sizeof (rda_fd_ctx_t),
+                                         gf_rda_mt_rda_fd_ctx);
+                        if (!ctx)
+                                goto out;
+
+                        LOCK_INIT (&ctx->lock);
+                        INIT_LIST_HEAD (&ctx->entries.list);
+                        ctx->state = RDA_FD_NEW;
+
+                        if (__fd_ctx_set (fd, this, (uint64_t) (long) ctx)
+                            < 0) {
+                                LOCK_DESTROY (&ctx->lock);
+                                GF_FREE (ctx);
+                                ctx = NULL;
+                                goto out;
+                        }
+                } else {
+                        ctx = (rda_fd_ctx_t *) (long) val;
+                }
+        }
+out:
+        UNLOCK (&fd->lock);
+        return ctx;
+}
+
+static void
+rda_account (xlator_t *this, int64_t delta)
+{
+        rda_priv_t *priv = this->private;
+
+        LOCK (&priv->lock);
+        {
+                priv->rda_cache_size += delta;
+        }
+        UNLOCK (&priv->lock);
+}
+
+/*
+ * Drop every buffered entry. Called with ctx->lock held.
+ */
+static void
+__rda_purge_entries (xlator_t *this, rda_fd_ctx_t *ctx)
+{
+        gf_dirent_free (&ctx->entries);
+        INIT_LIST_HEAD (&ctx->entries.list);
+
+        rda_account (this, -(int64_t) ctx->cur_size);
+        ctx->cur_size = 0;
+}
+
+/*
+ * Move as many buffered entries as fit in request_size to the entries list
+ * handed in. At least one entry is returned if one is available. Called
+ * with ctx->lock held.
+ */
+static int
+__rda_fill_readdirp (xlator_t *this, gf_dirent_t *entries,
+                     size_t request_size, rda_fd_ctx_t *ctx)
+{
+        gf_dirent_t *dirent    = NULL;
+        gf_dirent_t *tmp       = NULL;
+        size_t       dirent_size = 0;
+        size_t       size      = 0;
+        int          count     = 0;
+
+        list_for_each_entry_safe (dirent, tmp, &ctx->entries.list, list) {
+                dirent_size = gf_dirent_size (dirent->d_name);
+                if (count && (size + dirent_size > request_size))
+                        break;
+
+                size += dirent_size;
+                list_del_init (&dirent->list);
+                ctx->cur_size -= dirent_size;
+                ctx->cur_offset = dirent->d_off;
+
+                list_add_tail (&dirent->list, &entries->list);
+                count++;
+        }
+
+        if (size)
+                rda_account (this, -(int64_t) size);
+
+        return count;
+}
+
+/*
+ * Serve a readdirp request out of the buffer. Returns the op_ret to unwind
+ * with; op_errno is set accordingly. Called with ctx->lock held.
+ */
+static int
+__rda_serve_readdirp (xlator_t *this, rda_fd_ctx_t *ctx, size_t size,
+                      gf_dirent_t *entries, int *op_errno)
+{
+        int ret = 0;
+
+        *op_errno = 0;
+        ret = __rda_fill_readdirp (this, entries, size, ctx);
+
+        if (!ret && (ctx->state & RDA_FD_ERROR)) {
+                ret = -1;
+                *op_errno = ctx->op_errno;
+        } else if (!ret && (ctx->state & RDA_FD_EOD)) {
+                *op_errno = ENOENT;
+        }
+
+        return ret;
+}
+
+/*
+ * Whether the background fill should (re)start after entries were consumed.
+ * Called with ctx->lock held.
+ */
+static gf_boolean_t
+__rda_should_fill (rda_priv_t *priv, rda_fd_ctx_t *ctx)
+{
+        if (ctx->state & (RDA_FD_RUNNING | RDA_FD_EOD | RDA_FD_ERROR |
+                          RDA_FD_BYPASS))
+                return _gf_false;
+
+        if (ctx->state & RDA_FD_NEW)
+                return _gf_true;
+
+        return (ctx->cur_size < priv->rda_low_wmark);
+}
+
+int32_t
+rda_readdirp (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+              off_t off, dict_t *xdata)
+{
+        rda_priv_t     *priv     = NULL;
+        rda_fd_ctx_t   *ctx      = NULL;
+        call_stub_t    *stub     = NULL;
+        gf_dirent_t     entries;
+        int             op_ret   = 0;
+        int             op_errno = 0;
+        gf_boolean_t    serve    = _gf_false;
+        gf_boolean_t    fill     = _gf_false;
+
+        priv = this->private;
+        INIT_LIST_HEAD (&entries.list);
+
+        ctx = get_rda_fd_ctx (fd, this);
+        if (!ctx)
+                goto wind;
+
+        LOCK (&ctx->lock);
+        {
+                /* bypassed, or a second concurrent reader on the fd */
+                if ((ctx->state & RDA_FD_BYPASS) || ctx->stub)
+                        goto unlock_wind;
+
+                /* the application seeked somewhere we have not prefetched
+                 * from, the buffer is of no use from here on. */
+                if (off != ctx->cur_offset) {
+                        ctx->state |= RDA_FD_BYPASS;
+                        __rda_purge_entries (this, ctx);
+                        priv->bypasses++;
+                        goto unlock_wind;
+                }
+
+                if (!list_empty (&ctx->entries.list) ||
+                    (ctx->state & (RDA_FD_EOD | RDA_FD_ERROR))) {
+                        op_ret = __rda_serve_readdirp (this, ctx, size,
+                                                       &entries, &op_errno);
+                        priv->hits++;
+                        serve = _gf_true;
+                } else {
+                        stub = fop_readdirp_stub (frame, NULL, fd, size, off,
+                                                  xdata);
+                        if (!stub)
+                                goto unlock_wind;
+
+                        ctx->stub = stub;
+                        priv->waits++;
+                }
+
+                fill = __rda_should_fill (priv, ctx);
+        }
+        UNLOCK (&ctx->lock);
+
+        if (serve) {
+                STACK_UNWIND_STRICT (readdirp, frame, op_ret, op_errno,
+                                     &entries, NULL);
+                gf_dirent_free (&entries);
+        }
+
+        if (fill && (rda_fill_fd (frame, this, fd) < 0) && stub) {
+                /* nobody is going to serve the request we queued */
+                LOCK (&ctx->lock);
+                {
+                        if (ctx->stub == stub) {
+                                ctx->stub = NULL;
+                                ctx->state |= RDA_FD_BYPASS;
+                                __rda_purge_entries (this, ctx);
+                        } else {
+                                stub = NULL;
+                        }
+                }
+                UNLOCK (&ctx->lock);
+
+                if (stub) {
+                        call_stub_destroy (stub);
+                        goto wind;
+                }
+        }
+
+        return 0;
+
+unlock_wind:
+        UNLOCK (&ctx->lock);
+wind:
+        STACK_WIND (frame, default_readdirp_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->readdirp, fd, size, off, xdata);
+        return 0;
+}
+
+static int32_t
+rda_fill_fd_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, gf_dirent_t *entries,
+                 dict_t *xdata)
+{
+        rda_priv_t     *priv        = NULL;
+        rda_local_t    *local       = NULL;
+        rda_fd_ctx_t   *ctx         = NULL;
+        gf_dirent_t    *dirent      = NULL;
+        gf_dirent_t    *tmp         = NULL;
+        call_stub_t    *stub        = NULL;
+        gf_dirent_t     serve_entries;
+        int             serve_ret   = 0;
+        int             serve_errno = 0;
+        size_t          fill_size   = 0;
+        gf_boolean_t    fill        = _gf_false;
+
+        priv = this->private;
+        local = frame->local;
+        ctx = local->ctx;
+        INIT_LIST_HEAD (&serve_entries.list);
+
+        LOCK (&ctx->lock);
+        {
+                ctx->state &= ~RDA_FD_RUNNING;
+
+                if (ctx->state & RDA_FD_BYPASS)
+                        goto unlock;
+
+                if (op_ret < 0) {
+                        ctx->state |= RDA_FD_ERROR;
+                        ctx->op_errno = op_errno;
+                } else if (op_ret == 0) {
+                        ctx->state |= RDA_FD_EOD;
+                }
+
+                if (op_ret > 0) {
+                        list_for_each_entry_safe (dirent, tmp, &entries->list,
+                                                  list) {
+                                list_del_init (&dirent->list);
+                                ctx->next_offset = dirent->d_off;
+                                fill_size += gf_dirent_size (dirent->d_name);
+                                list_add_tail (&dirent->list,
+                                               &ctx->entries.list);
+                        }
+                        ctx->cur_size += fill_size;
+                        rda_account (this, fill_size);
+                }
+
+                if (ctx->stub) {
+                        stub = ctx->stub;
+                        ctx->stub = NULL;
+                        serve_ret = __rda_serve_readdirp (this, ctx,
+                                                          stub->args.readdirp.size,
+                                                          &serve_entries,
+                                                          &serve_errno);
+                }
+
+                if (ctx->state & (RDA_FD_EOD | RDA_FD_ERROR))
+                        goto unlock;
+
+                if ((ctx->cur_size < priv->rda_high_wmark) &&
+                    (priv->rda_cache_size < priv->rda_cache_limit))
+                        fill = _gf_true;
+                else
+                        ctx->state |= RDA_FD_PLUGGED;
+        }
+unlock:
+        UNLOCK (&ctx->lock);
+
+        if (stub) {
+                STACK_UNWIND_STRICT (readdirp, stub->frame, serve_ret,
+                                     serve_errno, &serve_entries, NULL);
+                gf_dirent_free (&serve_entries);
+                call_stub_destroy (stub);
+        }
+
+        if (fill)
+                rda_fill_fd (frame, this, local->fd);
+
+        frame->local = NULL;
+        fd_unref (local->fd);
+        mem_put (local);
+        STACK_DESTROY (frame->root);
+
+        return 0;
+}
+
+/*
+ * Issue one background readdirp to top up the buffer of the fd. The
+ * request runs in its own stack copied from the frame passed in, so that
+ * it outlives the fop that triggered it.
+ */
+static int
+rda_fill_fd (call_frame_t *frame, xlator_t *this, fd_t *fd)
+{
+        rda_priv_t     *priv   = NULL;
+        rda_fd_ctx_t   *ctx    = NULL;
+        rda_local_t    *local  = NULL;
+        call_frame_t   *nframe = NULL;
+        off_t           offset = 0;
+        int             ret    = -1;
+
+        priv = this->private;
+
+        ctx = get_rda_fd_ctx (fd, this);
+        if (!ctx)
+                goto err;
+
+        nframe = copy_frame (frame);
+        if (!nframe)
+                goto err;
+
+        local = mem_get0 (this->local_pool);
+        if (!local)
+                goto err;
+
+        local->ctx = ctx;
+        local->fd = fd_ref (fd);
+        nframe->local = local;
+
+        LOCK (&ctx->lock);
+        {
+                if (ctx->state & (RDA_FD_RUNNING | RDA_FD_EOD | RDA_FD_ERROR |
+                                  RDA_FD_BYPASS)) {
+                        UNLOCK (&ctx->lock);
+                        ret = 0;
+                        goto err;
+                }
+
+                ctx->state &= ~(RDA_FD_NEW | RDA_FD_PLUGGED);
+                ctx->state |= RDA_FD_RUNNING;
+                offset = ctx->next_offset;
+                priv->fills++;
+        }
+        UNLOCK (&ctx->lock);
+
+        STACK_WIND (nframe, rda_fill_fd_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->readdirp, fd,
+                    priv->rda_req_size, offset, ctx->xattrs);
+
+        return 0;
+
+err:
+        if (nframe) {
+                nframe->local = NULL;
+                STACK_DESTROY (nframe->root);
+        }
+
+        if (local) {
+                fd_unref (local->fd);
+                mem_put (local);
+        }
+
+        return ret;
+}
+
+static int32_t
+rda_opendir_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, fd_t *fd, dict_t *xdata)
+{
+        rda_local_t  *local = NULL;
+        rda_fd_ctx_t *ctx   = NULL;
+
+        local = frame->local;
+        frame->local = NULL;
+
+        if (op_ret < 0)
+                goto unwind;
+
+        ctx = get_rda_fd_ctx (fd, this);
+        if (!ctx)
+                goto unwind;
+
+        /* remember the keys the parent asked for (e.g. the linkto xattr of
+         * distribute), every fill of this fd will fetch them. */
+        LOCK (&ctx->lock);
+        {
+                if (!ctx->xattrs && local && local->xattrs) {
+                        ctx->xattrs = local->xattrs;
+                        local->xattrs = NULL;
+                }
+        }
+        UNLOCK (&ctx->lock);
+
+        rda_fill_fd (frame, this, fd);
+
+unwind:
+        if (local) {
+                if (local->xattrs)
+                        dict_unref (local->xattrs);
+                mem_put (local);
+        }
+
+        STACK_UNWIND_STRICT (opendir, frame, op_ret, op_errno, fd, xdata);
+        return 0;
+}
+
+int32_t
+rda_opendir (call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd,
+             dict_t *xdata)
+{
+        rda_local_t *local = NULL;
+
+        local = mem_get0 (this->local_pool);
+        if (local) {
+                if (xdata)
+                        local->xattrs = dict_copy_with_ref (xdata, NULL);
+                frame->local = local;
+        }
+
+        STACK_WIND (frame, rda_opendir_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->opendir, loc, fd, xdata);
+        return 0;
+}
+
+int32_t
+rda_releasedir (xlator_t *this, fd_t *fd)
+{
+        uint64_t      val = 0;
+        rda_fd_ctx_t *ctx = NULL;
+
+        if (fd_ctx_del (fd, this, &val) < 0)
+                return -1;
+
+        ctx = (rda_fd_ctx_t *) (long) val;
+        if (!ctx)
+                return 0;
+
+        /* both a pending stub and an in-flight fill hold a ref on the fd,
+         * so neither can be around by now. */
+        __rda_purge_entries (this, ctx);
+
+        if (ctx->xattrs)
+                dict_unref (ctx->xattrs);
+
+        LOCK_DESTROY (&ctx->lock);
+        GF_FREE (ctx);
+
+        return 0;
+}
+
+int32_t
+rda_priv_dump (xlator_t *this)
+{
+        rda_priv_t *priv = NULL;
+        char        key_prefix[GF_DUMP_MAX_BUF_LEN];
+
+        if (!this)
+                return -1;
+
+        priv = this->private;
+        if (!priv)
+                return -1;
+
+        gf_proc_dump_build_key (key_prefix, "xlator.performance.readdir-ahead",
+                                "priv");
+        gf_proc_dump_add_section (key_prefix);
+
+        gf_proc_dump_write ("rda_req_size", "%"PRIu64, priv->rda_req_size);
+        gf_proc_dump_write ("rda_low_wmark", "%"PRIu64, priv->rda_low_wmark);
+        gf_proc_dump_write ("rda_high_wmark", "%"PRIu64,
+                            priv->rda_high_wmark);
+        gf_proc_dump_write ("rda_cache_limit", "%"PRIu64,
+                            priv->rda_cache_limit);
+        gf_proc_dump_write ("rda_cache_size", "%"PRIu64,
+                            priv->rda_cache_size);
+        gf_proc_dump_write ("fills", "%"PRIu64, priv->fills);
+        gf_proc_dump_write ("hits", "%"PRIu64, priv->hits);
+        gf_proc_dump_write ("waits", "%"PRIu64, priv->waits);
+        gf_proc_dump_write ("bypasses", "%"PRIu64, priv->bypasses);
+
+        return 0;
+}
+
+int32_t
+mem_acct_init (xlator_t *this)
+{
+        int ret = -1;
+
+        if (!this)
+                goto out;
+
+        ret = xlator_mem_acct_init (this, gf_rda_mt_end + 1);
+
+        if (ret != 0)
+                gf_log (this->name, GF_LOG_ERROR, "Memory accounting init"
+                        "failed");
+
+out:
+        return ret;
+}
+
+int
+reconfigure (xlator_t *this, dict_t *options)
+{
+        rda_priv_t *priv = this->private;
+        int         ret  = -1;
+
+        GF_OPTION_RECONF ("rda-request-size", priv->rda_req_size, options,
+                          size, out);
+        GF_OPTION_RECONF ("rda-low-wmark", priv->rda_low_wmark, options, size,
+                          out);
+        GF_OPTION_RECONF ("rda-high-wmark", priv->rda_high_wmark, options,
+                          size, out);
+        GF_OPTION_RECONF ("rda-cache-limit", priv->rda_cache_limit, options,
+                          size, out);
+
+        ret = 0;
+out:
+        return ret;
+}
+
+int
+init (xlator_t *this)
+{
+        rda_priv_t *priv = NULL;
+
+        GF_VALIDATE_OR_GOTO ("readdir-ahead", this, err);
+
+        if (!this->children || this->children->next) {
+                gf_log (this->name,  GF_LOG_ERROR,
+                        "FATAL: readdir-ahead not configured with exactly one"
+                        " child");
+                goto err;
+        }
+
+        if (!this->parents) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "dangling volume. check volfile ");
+        }
+
+        priv = GF_CALLOC (1, sizeof (rda_priv_t), gf_rda_mt_rda_priv);
+        if (!priv)
+                goto err;
+
+        LOCK_INIT (&priv->lock);
+        this->private = priv;
+
+        this->local_pool = mem_pool_new (rda_local_t, 32);
+        if (!this->local_pool) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "failed to create local_t's memory pool");
+                goto err;
+        }
+
+        GF_OPTION_INIT ("rda-request-size", priv->rda_req_size, size, err);
+        GF_OPTION_INIT ("rda-low-wmark", priv->rda_low_wmark, size, err);
+        GF_OPTION_INIT ("rda-high-wmark", priv->rda_high_wmark, size, err);
+        GF_OPTION_INIT ("rda-cache-limit", priv->rda_cache_limit, size, err);
+
+        return 0;
+
+err:
+        if (this && this->local_pool)
+                mem_pool_destroy (this->local_pool);
+        if (priv) {
+                LOCK_DESTROY (&priv->lock);
+                GF_FREE (priv);
+        }
+        if (this)
+                this->private = NULL;
+
+        return -1;
+}
+
+void
+fini (xlator_t *this)
+{
+        rda_priv_t *priv = NULL;
+
+        GF_VALIDATE_OR_GOTO ("readdir-ahead", this, out);
+
+        priv = this->private;
+        if (!priv)
+                goto out;
+
+        this->private = NULL;
+        LOCK_DESTROY (&priv->lock);
+        GF_FREE (priv);
+out:
+        return;
+}
+
+struct xlator_fops fops = {
+        .opendir     = rda_opendir,
+        .readdirp    = rda_readdirp,
+};
+
+struct xlator_cbks cbks = {
+        .releasedir  = rda_releasedir,
+};
+
+struct xlator_dumpops dumpops = {
+        .priv        = rda_priv_dump,
+};
+
+struct volume_options options[] = {
+        { .key = {"rda-request-size"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .min = 4096,
+          .max = 131072,
+          .default_value = "131072",
+          .description = "readdirp size for performing entry prefetch",
+        },
+        { .key = {"rda-low-wmark"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .min = 0,
+          .max = 10 * GF_UNIT_MB,
+          .default_value = "4096",
+          .description = "the value under which we plug",
+        },
+        { .key = {"rda-high-wmark"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .min = 0,
+          .max = 100 * GF_UNIT_MB,
+          .default_value = "128KB",
+          .description = "the value over which we plug",
+        },
+        { .key = {"rda-cache-limit"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .min = 0,
+          .max = 1 * GF_UNIT_GB,
+          .default_value = "10MB",
+          .description = "maximum size of cache consumed by readdir-ahead "
+                         "xlator across all open directories",
+        },
+        { .key = {NULL} },
+};
@@ -0,0 +1,72 @@
+/*
+  Copyright (c) 2012 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#ifndef __READDIR_AHEAD_H
+#define __READDIR_AHEAD_H
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include "glusterfs.h"
+#include "logging.h"
+#include "dict.h"
+#include "xlator.h"
+#include "list.h"
+#include "call-stub.h"
+#include "defaults.h"
+#include "readdir-ahead-mem-types.h"
+
+/* state flags of a directory fd */
+#define RDA_FD_NEW      (1 << 0)
+#define RDA_FD_RUNNING  (1 << 1)  /* a fill request is in flight */
+#define RDA_FD_EOD      (1 << 2)  /* child reported end of directory */
+#define RDA_FD_ERROR    (1 << 3)  /* child returned an error */
+#define RDA_FD_BYPASS   (1 << 4)  /* offset mismatch, wind everything */
+#define RDA_FD_PLUGGED  (1 << 5)  /* filling paused on memory limits */
+
+struct rda_fd_ctx {
+        off_t           cur_offset;   /* offset the application is at */
+        size_t          cur_size;     /* bytes held in entries */
+        off_t           next_offset;  /* offset of the next fill request */
+        uint32_t        state;
+        gf_lock_t       lock;
+        gf_dirent_t     entries;
+        call_stub_t    *stub;
+        int             op_errno;
+        dict_t         *xattrs;       /* keys to request with each fill */
+};
+typedef struct rda_fd_ctx rda_fd_ctx_t;
+
+struct rda_local {
+        rda_fd_ctx_t   *ctx;
+        fd_t           *fd;
+        dict_t         *xattrs;
+};
+typedef struct rda_local rda_local_t;
+
+struct rda_priv {
+        uint64_t        rda_req_size;
+        uint64_t        rda_low_wmark;
+        uint64_t        rda_high_wmark;
+        uint64_t        rda_cache_limit;
+        uint64_t        rda_cache_size;  /* bytes buffered across all fds */
+        gf_lock_t       lock;
+
+        /* statistics */
+        uint64_t        fills;
+        uint64_t        hits;
+        uint64_t        waits;
+        uint64_t        bypasses;
+};
+typedef struct rda_priv rda_priv_t;
+
+#endif /* __READDIR_AHEAD_H */
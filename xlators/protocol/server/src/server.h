@@ -182,6 +182,7 @@ struct _server_state {
 
         size_t            size;
         off_t             offset;
+        gf_seek_what_t    what;
         mode_t            mode;
         dev_t             dev;
         size_t            nr_count;
@@ -157,6 +157,13 @@ posix_aio_readv (call_frame_t *frame, xlator_t *this, fd_t *fd,
                 goto err;
         }
 
+        if (priv->scrub && posix_scrub_read (this, fd)) {
+                op_errno = EIO;
+                gf_log (this->name, GF_LOG_WARNING, "read of %s refused, "
+                        "it failed scrubbing", uuid_utoa (fd->inode->gfid));
+                goto err;
+        }
+
         iobuf = iobuf_get2 (this->ctx->iobuf_pool, size);
         if (!iobuf) {
                 op_errno = ENOMEM;
@@ -301,6 +308,9 @@ posix_aio_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
         }
         _fd = pfd->fd;
 
+        if (priv->scrub)
+                posix_scrub_write (this, pfd);
+
         paiocb = GF_CALLOC (1, sizeof (*paiocb), gf_posix_mt_paiocb);
         if (!paiocb) {
                 op_errno = ENOMEM;
@@ -25,6 +25,7 @@
 #include "posix.h"
 #include "xlator.h"
 #include "syscall.h"
+#include "statedump.h"
 
 
 #define HANDLE_PFX ".glusterfs"
@@ -70,6 +71,453 @@ posix_handle_relpath (xlator_t *this, uuid_t gfid, const char *basename,
 }
 
 
+#define POSIX_HANDLE_CACHE_BUCKETS 1024
+
+static int
+__posix_handle_cache_bucket (struct posix_handle_cache *cache, uuid_t gfid)
+{
+        /* gfids are random, their last bytes are as good as a hash */
+        return ((gfid[12] << 24) | (gfid[13] << 16) | (gfid[14] << 8) |
+                gfid[15]) % cache->nbuckets;
+}
+
+
+static struct posix_handle_cache_entry *
+__posix_handle_cache_find (struct posix_handle_cache *cache, uuid_t gfid)
+{
+        struct posix_handle_cache_entry *entry = NULL;
+        int                              idx   = 0;
+
+        idx = __posix_handle_cache_bucket (cache, gfid);
+
+        list_for_each_entry (entry, &cache->buckets[idx], hash) {
+                if (uuid_compare (entry->gfid, gfid) == 0)
+                        return entry;
+        }
+
+        return NULL;
+}
+
+
+static void
+posix_handle_cache_entry_destroy (struct posix_handle_cache_entry *entry)
+{
+        if (entry->fd != -1)
+                close (entry->fd);
+        GF_FREE (entry->path);
+        GF_FREE (entry);
+}
+
+
+/* takes @entry out of the cache, returns it if the caller has to destroy
+   it once out of the lock */
+static struct posix_handle_cache_entry *
+__posix_handle_cache_unlink (struct posix_handle_cache *cache,
+                             struct posix_handle_cache_entry *entry)
+{
+        list_del_init (&entry->hash);
+        list_del_init (&entry->lru);
+        cache->count--;
+        entry->unlinked = _gf_true;
+
+        return (entry->ref == 0) ? entry : NULL;
+}
+
+
+static void
+__posix_handle_cache_shrink (struct posix_handle_cache *cache,
+                             struct list_head *victims)
+{
+        struct posix_handle_cache_entry *entry = NULL;
+
+        while (cache->count > cache->size) {
+                entry = list_entry (cache->lru.prev,
+                                    struct posix_handle_cache_entry, lru);
+                cache->evictions++;
+                if (__posix_handle_cache_unlink (cache, entry))
+                        list_add (&entry->lru, victims);
+        }
+}
+
+
+static void
+posix_handle_cache_destroy_list (struct list_head *victims)
+{
+        struct posix_handle_cache_entry *entry = NULL;
+        struct posix_handle_cache_entry *tmp   = NULL;
+
+        list_for_each_entry_safe (entry, tmp, victims, lru) {
+                list_del_init (&entry->lru);
+                posix_handle_cache_entry_destroy (entry);
+        }
+}
+
+
+/* copies the resolved handle path of directory @gfid into @buf, returns
+   its length or -1 on a miss.  @gen_p gets the generation to hand back to
+   posix_handle_cache_set_path () after resolving a miss. */
+static int
+posix_handle_cache_get_path (xlator_t *this, uuid_t gfid, char *buf,
+                             size_t size, uint64_t *gen_p)
+{
+        struct posix_private            *priv  = NULL;
+        struct posix_handle_cache       *cache = NULL;
+        struct posix_handle_cache_entry *entry = NULL;
+        int                              len   = -1;
+
+        priv = this->private;
+        cache = priv->handle_cache;
+
+        LOCK (&cache->lock);
+        {
+                *gen_p = cache->generation;
+
+                entry = __posix_handle_cache_find (cache, gfid);
+                if (!entry || !entry->path) {
+                        cache->misses++;
+                        goto unlock;
+                }
+
+                len = strlen (entry->path);
+                if (len >= size) {
+                        len = -1;
+                        goto unlock;
+                }
+
+                memcpy (buf, entry->path, len + 1);
+                list_move (&entry->lru, &cache->lru);
+                cache->hits++;
+        }
+unlock:
+        UNLOCK (&cache->lock);
+
+        return len;
+}
+
+
+static void
+posix_handle_cache_set_path (xlator_t *this, uuid_t gfid, const char *path,
+                             int len, uint64_t gen)
+{
+        struct posix_private            *priv    = NULL;
+        struct posix_handle_cache       *cache   = NULL;
+        struct posix_handle_cache_entry *entry   = NULL;
+        char                            *copy    = NULL;
+        struct list_head                 victims;
+
+        priv = this->private;
+        cache = priv->handle_cache;
+
+        INIT_LIST_HEAD (&victims);
+
+        copy = GF_CALLOC (1, len + 1, gf_posix_mt_char);
+        if (!copy)
+                return;
+        memcpy (copy, path, len);
+
+        LOCK (&cache->lock);
+        {
+                /* a rename or rmdir ran while we resolved @path */
+                if (gen != cache->generation || !cache->size)
+                        goto unlock;
+
+                entry = __posix_handle_cache_find (cache, gfid);
+                if (entry) {
+                        GF_FREE (entry->path);
+                        entry->path = copy;
+                        copy = NULL;
+                        list_move (&entry->lru, &cache->lru);
+                        goto unlock;
+                }
+
+                entry = GF_CALLOC (1, sizeof (*entry),
+                                   gf_posix_mt_handle_cache_entry);
+                if (!entry)
+                        goto unlock;
+
+                INIT_LIST_HEAD (&entry->hash);
+                INIT_LIST_HEAD (&entry->lru);
+                uuid_copy (entry->gfid, gfid);
+                entry->path = copy;
+                entry->fd = -1;
+                copy = NULL;
+
+                list_add (&entry->hash,
+                          &cache->buckets[__posix_handle_cache_bucket (cache,
+                                                                       gfid)]);
+                list_add (&entry->lru, &cache->lru);
+                cache->count++;
+
+                __posix_handle_cache_shrink (cache, &victims);
+        }
+unlock:
+        UNLOCK (&cache->lock);
+
+        GF_FREE (copy);
+        posix_handle_cache_destroy_list (&victims);
+}
+
+
+/* returns the cache entry of directory @gfid with its directory fd open,
+   NULL if the directory is not cached.  Release with
+   posix_handle_cache_fd_put (). */
+struct posix_handle_cache_entry *
+posix_handle_cache_fd_get (xlator_t *this, uuid_t gfid)
+{
+        struct posix_private            *priv  = NULL;
+        struct posix_handle_cache       *cache = NULL;
+        struct posix_handle_cache_entry *entry = NULL;
+        char                            *path  = NULL;
+        int                              fd    = -1;
+
+        priv = this->private;
+        cache = priv->handle_cache;
+        if (!cache)
+                return NULL;
+
+        LOCK (&cache->lock);
+        {
+                entry = __posix_handle_cache_find (cache, gfid);
+                if (!entry) {
+                        cache->fd_misses++;
+                        goto unlock;
+                }
+
+                entry->ref++;
+                if (entry->fd != -1) {
+                        cache->fd_hits++;
+                        goto unlock;
+                }
+
+                cache->fd_misses++;
+                if (entry->path)
+                        path = gf_strdup (entry->path);
+        }
+unlock:
+        UNLOCK (&cache->lock);
+
+        if (!entry || entry->fd != -1)
+                return entry;
+
+        if (path) {
+                fd = open (path, O_RDONLY | O_DIRECTORY);
+                GF_FREE (path);
+        }
+
+        LOCK (&cache->lock);
+        {
+                if (entry->fd == -1) {
+                        entry->fd = fd;
+                        fd = -1;
+                }
+        }
+        UNLOCK (&cache->lock);
+
+        if (fd != -1)
+                close (fd);
+
+        if (entry->fd == -1) {
+                posix_handle_cache_fd_put (this, entry);
+                entry = NULL;
+        }
+
+        return entry;
+}
+
+
+void
+posix_handle_cache_fd_put (xlator_t *this,
+                           struct posix_handle_cache_entry *entry)
+{
+        struct posix_private      *priv    = NULL;
+        struct posix_handle_cache *cache   = NULL;
+        gf_boolean_t               destroy = _gf_false;
+
+        priv = this->private;
+        cache = priv->handle_cache;
+
+        LOCK (&cache->lock);
+        {
+                if (--entry->ref == 0 && entry->unlinked)
+                        destroy = _gf_true;
+        }
+        UNLOCK (&cache->lock);
+
+        if (destroy)
+                posix_handle_cache_entry_destroy (entry);
+}
+
+
+/* the directory is gone (rmdir, or moved to the landfill) */
+void
+posix_handle_cache_forget (xlator_t *this, uuid_t gfid)
+{
+        struct posix_private            *priv  = NULL;
+        struct posix_handle_cache       *cache = NULL;
+        struct posix_handle_cache_entry *entry = NULL;
+
+        priv = this->private;
+        cache = priv->handle_cache;
+        if (!cache)
+                return;
+
+        LOCK (&cache->lock);
+        {
+                cache->generation++;
+                entry = __posix_handle_cache_find (cache, gfid);
+                if (entry)
+                        entry = __posix_handle_cache_unlink (cache, entry);
+        }
+        UNLOCK (&cache->lock);
+
+        if (entry)
+                posix_handle_cache_entry_destroy (entry);
+}
+
+
+/* a directory was renamed: the resolved paths of its descendants may go
+   through its old name.  The directory fds stay valid across renames. */
+void
+posix_handle_cache_flush_paths (xlator_t *this)
+{
+        struct posix_private            *priv  = NULL;
+        struct posix_handle_cache       *cache = NULL;
+        struct posix_handle_cache_entry *entry = NULL;
+
+        priv = this->private;
+        cache = priv->handle_cache;
+        if (!cache)
+                return;
+
+        LOCK (&cache->lock);
+        {
+                cache->generation++;
+                list_for_each_entry (entry, &cache->lru, lru) {
+                        GF_FREE (entry->path);
+                        entry->path = NULL;
+                }
+        }
+        UNLOCK (&cache->lock);
+}
+
+
+int
+posix_handle_cache_init (xlator_t *this, int32_t size)
+{
+        struct posix_private      *priv  = NULL;
+        struct posix_handle_cache *cache = NULL;
+        int                        i     = 0;
+
+        priv = this->private;
+
+        if (!size)
+                return 0;
+
+        cache = GF_CALLOC (1, sizeof (*cache), gf_posix_mt_handle_cache);
+        if (!cache)
+                return -1;
+
+        cache->nbuckets = POSIX_HANDLE_CACHE_BUCKETS;
+        cache->buckets = GF_CALLOC (cache->nbuckets, sizeof (*cache->buckets),
+                                    gf_posix_mt_handle_cache);
+        if (!cache->buckets) {
+                GF_FREE (cache);
+                return -1;
+        }
+
+        for (i = 0; i < cache->nbuckets; i++)
+                INIT_LIST_HEAD (&cache->buckets[i]);
+        INIT_LIST_HEAD (&cache->lru);
+        LOCK_INIT (&cache->lock);
+        cache->size = size;
+
+        priv->handle_cache = cache;
+
+        return 0;
+}
+
+
+void
+posix_handle_cache_resize (xlator_t *this, int32_t size)
+{
+        struct posix_private      *priv  = NULL;
+        struct posix_handle_cache *cache = NULL;
+        struct list_head           victims;
+
+        priv = this->private;
+        cache = priv->handle_cache;
+
+        if (!cache) {
+                /* enabled at runtime */
+                posix_handle_cache_init (this, size);
+                return;
+        }
+
+        INIT_LIST_HEAD (&victims);
+
+        /* a size of 0 empties the cache, the structure stays around for
+           the handles that may be using it */
+        LOCK (&cache->lock);
+        {
+                cache->size = size;
+                __posix_handle_cache_shrink (cache, &victims);
+        }
+        UNLOCK (&cache->lock);
+
+        posix_handle_cache_destroy_list (&victims);
+}
+
+
+void
+posix_handle_cache_fini (xlator_t *this)
+{
+        struct posix_private      *priv  = NULL;
+        struct posix_handle_cache *cache = NULL;
+
+        priv = this->private;
+        cache = priv->handle_cache;
+        if (!cache)
+                return;
+
+        posix_handle_cache_resize (this, 0);
+
+        priv->handle_cache = NULL;
+        LOCK_DESTROY (&cache->lock);
+        GF_FREE (cache->buckets);
+        GF_FREE (cache);
+}
+
+
+void
+posix_handle_cache_dump (xlator_t *this)
+{
+        struct posix_private      *priv  = NULL;
+        struct posix_handle_cache *cache = NULL;
+
+        priv = this->private;
+        cache = priv->handle_cache;
+        if (!cache)
+                return;
+
+        LOCK (&cache->lock);
+        {
+                gf_proc_dump_write ("handle_cache.size", "%d", cache->size);
+                gf_proc_dump_write ("handle_cache.count", "%d", cache->count);
+                gf_proc_dump_write ("handle_cache.hits", "%"PRIu64,
+                                    cache->hits);
+                gf_proc_dump_write ("handle_cache.misses", "%"PRIu64,
+                                    cache->misses);
+                gf_proc_dump_write ("handle_cache.evictions", "%"PRIu64,
+                                    cache->evictions);
+                gf_proc_dump_write ("handle_cache.fd_hits", "%"PRIu64,
+                                    cache->fd_hits);
+                gf_proc_dump_write ("handle_cache.fd_misses", "%"PRIu64,
+                                    cache->fd_misses);
+        }
+        UNLOCK (&cache->lock);
+}
+
+
 /*
   TODO: explain how this pump fixes ELOOP
 */
@@ -176,6 +624,10 @@ posix_handle_path (xlator_t *this, uuid_t gfid, const char *basename,
         int                   pfx_len;
         int                   maxlen;
         char                 *buf;
+        char                 *cpath = NULL;
+        int                   clen = 0;
+        uint64_t              gen = 0;
+        gf_boolean_t          pumped = _gf_false;
 
         priv = this->private;
 
@@ -197,6 +649,20 @@ posix_handle_path (xlator_t *this, uuid_t gfid, const char *basename,
 
         pfx_len = priv->base_path_length + 1 + SLEN(HANDLE_PFX) + 1;
 
+        if (priv->handle_cache && priv->handle_cache->size) {
+                cpath = alloca (PATH_MAX);
+                clen = posix_handle_cache_get_path (this, gfid, cpath,
+                                                    PATH_MAX, &gen);
+                if (clen >= 0) {
+                        if (basename)
+                                len = snprintf (buf, maxlen, "%s/%s", cpath,
+                                                basename);
+                        else
+                                len = snprintf (buf, maxlen, "%s", cpath);
+                        goto out;
+                }
+        }
+
         if (basename) {
                 len = snprintf (buf, maxlen, "%s/%s", base_str, basename);
         } else {
@@ -210,16 +676,28 @@ posix_handle_path (xlator_t *this, uuid_t gfid, const char *basename,
 
         do {
                 errno = 0;
+                pumped = _gf_false;
                 ret = posix_handle_pump (this, buf, len, maxlen,
                                          base_str, base_len, pfx_len);
                 if (ret == -1)
                         break;
 
                 len = ret;
+                pumped = _gf_true;
 
                 ret = lstat (buf, &stat);
         } while ((ret == -1) && errno == ELOOP);
 
+        /* remember where the directory resolved to, a missing @basename
+           does not make that resolution any less valid */
+        if (cpath && pumped && (len < maxlen) &&
+            ((ret == 0) || (basename && errno == ENOENT))) {
+                clen = basename ? (len - strlen (basename) - 1) : len;
+                if ((clen > 0) && (!basename || buf[clen] == '/'))
+                        posix_handle_cache_set_path (this, gfid, buf, clen,
+                                                     gen);
+        }
+
 out:
         return len + 1;
 }
@@ -594,6 +1072,61 @@ posix_handle_hard (xlator_t *this, const char *oldpath, uuid_t gfid, struct stat
 }
 
 
+/* links the handle of @gfid to the inode open on @fd, which can still be an
+ * unnamed O_TMPFILE inode. The hash directories are only created the first
+ * time a handle goes in them. */
+int
+posix_handle_hard_fd (xlator_t *this, int fd, uuid_t gfid)
+{
+        struct posix_private *priv    = NULL;
+        char                 *newpath = NULL;
+        char                  fdpath[64];
+        int                   idx     = 0;
+        int                   ret     = -1;
+
+#ifdef HAVE_LINKAT
+        priv = this->private;
+
+        MAKE_HANDLE_PATH (newpath, this, gfid, NULL);
+        if (!newpath) {
+                errno = EINVAL;
+                return -1;
+        }
+
+        snprintf (fdpath, sizeof (fdpath), "/proc/self/fd/%d", fd);
+        idx = (gfid[0] << 8) | gfid[1];
+
+        if (!priv->handle_dirs || !priv->handle_dirs[idx]) {
+                ret = posix_handle_mkdir_hashes (this, newpath);
+                if (ret)
+                        return -1;
+                if (priv->handle_dirs)
+                        priv->handle_dirs[idx] = 1;
+        }
+
+        ret = linkat (AT_FDCWD, fdpath, AT_FDCWD, newpath, AT_SYMLINK_FOLLOW);
+        if (ret == -1 && errno == ENOENT) {
+                /* the hash directories were removed behind our back */
+                ret = posix_handle_mkdir_hashes (this, newpath);
+                if (ret)
+                        return -1;
+                ret = linkat (AT_FDCWD, fdpath, AT_FDCWD, newpath,
+                              AT_SYMLINK_FOLLOW);
+        }
+
+        if (ret) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "link %s -> %s failed (%s)",
+                        fdpath, newpath, strerror (errno));
+                return -1;
+        }
+#else
+        errno = ENOSYS;
+#endif
+        return ret;
+}
+
+
 int
 posix_handle_soft (xlator_t *this, const char *real_path, loc_t *loc,
                    uuid_t gfid, struct stat *oldbuf)
@@ -684,6 +1217,9 @@ posix_handle_unset_gfid (xlator_t *this, uuid_t gfid)
                 goto out;
         }
 
+        if (S_ISLNK (stat.st_mode))
+                posix_handle_cache_forget (this, gfid);
+
         ret = unlink (path);
         if (ret == -1) {
                 gf_log (this->name, GF_LOG_WARNING,
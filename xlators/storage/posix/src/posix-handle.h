@@ -19,6 +19,33 @@
 #include "xlator.h"
 
 
+/* gfid -> resolved handle path and directory fd, for directory handles */
+struct posix_handle_cache_entry {
+        struct list_head  hash;
+        struct list_head  lru;
+        uuid_t            gfid;
+        char             *path;     /* ELOOP-free path, NULL once dropped */
+        int               fd;       /* O_DIRECTORY fd, -1 until opened */
+        int               ref;
+        gf_boolean_t      unlinked; /* out of the cache, freed on last put */
+};
+
+struct posix_handle_cache {
+        gf_lock_t         lock;
+        struct list_head *buckets;
+        int               nbuckets;
+        struct list_head  lru;
+        int32_t           count;
+        int32_t           size;
+        uint64_t          generation; /* bumped on every invalidation */
+        uint64_t          hits;
+        uint64_t          misses;
+        uint64_t          evictions;
+        uint64_t          fd_hits;
+        uint64_t          fd_misses;
+};
+
+
 #define LOC_HAS_ABSPATH(loc) ((loc) && (loc->path) && (loc->path[0] == '/'))
 
 #define MAKE_REAL_PATH(var, this, path) do {                            \
@@ -133,6 +160,8 @@ posix_handle_unset (xlator_t *this, uuid_t gfid, const char *basename);
 
 int posix_handle_mkdir_hashes (xlator_t *this, const char *newpath);
 
+int posix_handle_hard_fd (xlator_t *this, int fd, uuid_t gfid);
+
 int posix_handle_init (xlator_t *this);
 
 int posix_create_link_if_gfid_exists (xlator_t *this, uuid_t gfid,
@@ -140,4 +169,22 @@ int posix_create_link_if_gfid_exists (xlator_t *this, uuid_t gfid,
 
 int
 posix_handle_trash_init (xlator_t *this);
+
+int posix_handle_cache_init (xlator_t *this, int32_t size);
+
+void posix_handle_cache_resize (xlator_t *this, int32_t size);
+
+void posix_handle_cache_fini (xlator_t *this);
+
+void posix_handle_cache_forget (xlator_t *this, uuid_t gfid);
+
+void posix_handle_cache_flush_paths (xlator_t *this);
+
+struct posix_handle_cache_entry *
+posix_handle_cache_fd_get (xlator_t *this, uuid_t gfid);
+
+void posix_handle_cache_fd_put (xlator_t *this,
+                                struct posix_handle_cache_entry *entry);
+
+void posix_handle_cache_dump (xlator_t *this);
 #endif /* !_POSIX_HANDLE_H */
@@ -52,6 +52,7 @@ typedef struct {
         dict_t      *xattr;
         struct iatt *stbuf;
         loc_t       *loc;
+        int          fd;        /* open fd of real_path, -1 if none */
 } posix_xattr_filler_t;
 
 char *marker_xattrs[] = {"trusted.glusterfs.quota.*",
@@ -132,7 +133,10 @@ _posix_xattr_get_set (dict_t *xattr_req,
                 /* file content request */
                 req_size = data_to_uint64 (data);
                 if (req_size >= filler->stbuf->ia_size) {
-                        _fd = open (filler->real_path, O_RDONLY);
+                        if (filler->fd != -1)
+                                _fd = dup (filler->fd);
+                        else
+                                _fd = open (filler->real_path, O_RDONLY);
                         if (_fd == -1) {
                                 gf_log (filler->this->name, GF_LOG_ERROR,
                                         "Opening file %s failed: %s",
@@ -146,7 +150,7 @@ _posix_xattr_get_set (dict_t *xattr_req,
                                 goto err;
                         }
 
-                        ret = read (_fd, databuf, filler->stbuf->ia_size);
+                        ret = pread (_fd, databuf, filler->stbuf->ia_size, 0);
                         if (ret == -1) {
                                 gf_log (filler->this->name, GF_LOG_ERROR,
                                         "Read on file %s failed: %s",
@@ -194,8 +198,16 @@ _posix_xattr_get_set (dict_t *xattr_req,
                                         "Failed to set dictionary value for %s",
                                         key);
                 }
+        } else if (posix_xattrop_cache_get (filler->this,
+                                            filler->stbuf->ia_gfid, key,
+                                            filler->xattr) > 0) {
+                /* newer than the backend while xattrops are cached */
         } else {
-                xattr_size = sys_lgetxattr (filler->real_path, key, NULL, 0);
+                if (filler->fd != -1)
+                        xattr_size = sys_fgetxattr (filler->fd, key, NULL, 0);
+                else
+                        xattr_size = sys_lgetxattr (filler->real_path, key,
+                                                    NULL, 0);
 
                 if (xattr_size > 0) {
                         value = GF_CALLOC (1, xattr_size + 1,
@@ -203,8 +215,13 @@ _posix_xattr_get_set (dict_t *xattr_req,
                         if (!value)
                                 return -1;
 
-                        xattr_size = sys_lgetxattr (filler->real_path, key, value,
-                                                    xattr_size);
+                        if (filler->fd != -1)
+                                xattr_size = sys_fgetxattr (filler->fd, key,
+                                                            value, xattr_size);
+                        else
+                                xattr_size = sys_lgetxattr (filler->real_path,
+                                                            key, value,
+                                                            xattr_size);
                         if (xattr_size <= 0) {
                                 gf_log (filler->this->name, GF_LOG_WARNING,
                                         "getxattr failed. path: %s, key: %s",
@@ -328,13 +345,24 @@ posix_istat (xlator_t *this, uuid_t gfid, const char *basename,
         struct iatt  stbuf = {0, };
         int          ret = 0;
         struct posix_private *priv = NULL;
+        struct posix_handle_cache_entry *dir = NULL;
 
 
         priv = this->private;
 
         MAKE_HANDLE_PATH (real_path, this, gfid, basename);
 
-        ret = lstat (real_path, &lstatbuf);
+        /* stat the entry relative to the cached fd of its directory */
+        if (basename)
+                dir = posix_handle_cache_fd_get (this, gfid);
+
+        if (dir) {
+                ret = fstatat (dir->fd, basename, &lstatbuf,
+                               AT_SYMLINK_NOFOLLOW);
+                posix_handle_cache_fd_put (this, dir);
+        } else {
+                ret = lstat (real_path, &lstatbuf);
+        }
 
         if (ret == -1) {
                 if (errno != ENOENT && errno != ELOOP)
@@ -434,6 +462,7 @@ posix_lookup_xattr_fill (xlator_t *this, const char *real_path, loc_t *loc,
         filler.xattr     = xattr;
         filler.stbuf     = buf;
         filler.loc       = loc;
+        filler.fd        = -1;
 
         dict_foreach (xattr_req, _posix_xattr_get_set, &filler);
 out:
@@ -441,6 +470,86 @@ out:
 }
 
 
+/* Stat one entry of the directory open at @dirfd and, in the same pass,
+ * fetch its gfid and the xattrs in @xattr_req.  Everything is done relative
+ * to @dirfd, and through a single openat() of the entry for the xattrs;
+ * @real_path is only used for special files, which cannot be opened without
+ * side effects, and for log messages.
+ */
+int
+posix_entry_at_fill (xlator_t *this, int dirfd, const char *name,
+                     const char *real_path, uuid_t gfid, loc_t *loc,
+                     dict_t *xattr_req, struct iatt *buf_p, dict_t **xattr_p)
+{
+        struct stat           lstatbuf = {0, };
+        struct iatt           stbuf    = {0, };
+        struct posix_private *priv     = NULL;
+        posix_xattr_filler_t  filler   = {0, };
+        dict_t               *xattr    = NULL;
+        int                   _fd      = -1;
+        int                   ret      = 0;
+
+        priv = this->private;
+
+        ret = fstatat (dirfd, name, &lstatbuf, AT_SYMLINK_NOFOLLOW);
+        if (ret == -1) {
+                if (errno != ENOENT)
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "lstat failed on %s (%s)",
+                                real_path, strerror (errno));
+                goto out;
+        }
+
+        if ((lstatbuf.st_ino == priv->handledir.st_ino) &&
+            (lstatbuf.st_dev == priv->handledir.st_dev)) {
+                errno = ENOENT;
+                return -1;
+        }
+
+        if (!S_ISDIR (lstatbuf.st_mode))
+                lstatbuf.st_nlink --;
+
+        iatt_from_stat (&stbuf, &lstatbuf);
+
+        if ((S_ISREG (lstatbuf.st_mode) || S_ISDIR (lstatbuf.st_mode)) &&
+            (xattr_req || !gfid || uuid_is_null (gfid)))
+                _fd = openat (dirfd, name,
+                              O_RDONLY | O_NOFOLLOW | O_NONBLOCK);
+
+        if (gfid && !uuid_is_null (gfid))
+                uuid_copy (stbuf.ia_gfid, gfid);
+        else if (_fd != -1)
+                posix_fill_gfid_fd (this, _fd, &stbuf);
+        else
+                posix_fill_gfid_path (this, real_path, &stbuf);
+
+        posix_fill_ino_from_gfid (this, &stbuf);
+
+        if (xattr_req && xattr_p) {
+                xattr = get_new_dict ();
+                if (xattr) {
+                        filler.this      = this;
+                        filler.real_path = real_path;
+                        filler.xattr     = xattr;
+                        filler.stbuf     = &stbuf;
+                        filler.loc       = loc;
+                        filler.fd        = _fd;
+
+                        dict_foreach (xattr_req, _posix_xattr_get_set,
+                                      &filler);
+                }
+                *xattr_p = xattr;
+        }
+
+        if (buf_p)
+                *buf_p = stbuf;
+out:
+        if (_fd != -1)
+                close (_fd);
+        return ret;
+}
+
+
 int
 posix_gfid_set (xlator_t *this, const char *path, loc_t *loc, dict_t *xattr_req)
 {
@@ -748,13 +857,31 @@ static int
 janitor_walker (const char *fpath, const struct stat *sb,
                 int typeflag, struct FTW *ftwbuf)
 {
-        struct iatt  stbuf        = {0, };
-        xlator_t     *this = NULL;
+        struct iatt           stbuf = {0, };
+        xlator_t             *this  = NULL;
+        struct posix_private *priv  = NULL;
 
         this = THIS;
+        priv = this->private;
+
+        if (posix_reclaim_owns (this, fpath, ftwbuf->level))
+                return 0;
+
         posix_pstat (this, NULL, fpath, &stbuf);
         switch (sb->st_mode & S_IFMT) {
         case S_IFREG:
+                if (stbuf.ia_nlink == 1)
+                        posix_handle_unset (this, stbuf.ia_gfid, NULL);
+                /* large files of removed directories are freed at the
+                   pace of the reclaimer */
+                if (priv->reclaim &&
+                    posix_reclaim_defer (this, fpath, NULL, &stbuf) == 0)
+                        break;
+                gf_log (THIS->name, GF_LOG_TRACE,
+                        "unlinking %s", fpath);
+                unlink (fpath);
+                break;
+
         case S_IFBLK:
         case S_IFLNK:
         case S_IFCHR:
@@ -893,6 +1020,436 @@ unlock:
         UNLOCK (&priv->lock);
 }
 
+static void *
+posix_readdirp_worker_proc (void *data)
+{
+        xlator_t                  *this = NULL;
+        struct posix_private      *priv = NULL;
+        struct posix_readdirp_job *job  = NULL;
+
+        this = data;
+        priv = this->private;
+
+        THIS = this;
+
+        for (;;) {
+                pthread_mutex_lock (&priv->readdirp_lock);
+                {
+                        while (list_empty (&priv->readdirp_jobs) &&
+                               !priv->readdirp_fini)
+                                pthread_cond_wait (&priv->readdirp_cond,
+                                                   &priv->readdirp_lock);
+
+                        if (list_empty (&priv->readdirp_jobs)) {
+                                pthread_mutex_unlock (&priv->readdirp_lock);
+                                break;
+                        }
+
+                        job = list_entry (priv->readdirp_jobs.next,
+                                          struct posix_readdirp_job, list);
+                        list_del_init (&job->list);
+                }
+                pthread_mutex_unlock (&priv->readdirp_lock);
+
+                posix_readdirp_fill_slice (this, job);
+
+                pthread_mutex_lock (&job->batch->lock);
+                {
+                        if (--job->batch->pending == 0)
+                                pthread_cond_signal (&job->batch->cond);
+                }
+                pthread_mutex_unlock (&job->batch->lock);
+        }
+
+        return NULL;
+}
+
+
+int
+posix_spawn_readdirp_workers (xlator_t *this)
+{
+        struct posix_private *priv = NULL;
+        int                   i    = 0;
+        int                   ret  = 0;
+
+        priv = this->private;
+
+        pthread_mutex_init (&priv->readdirp_lock, NULL);
+        pthread_cond_init (&priv->readdirp_cond, NULL);
+        INIT_LIST_HEAD (&priv->readdirp_jobs);
+
+        if (!priv->readdirp_threads)
+                goto out;
+
+        priv->readdirp_workers = GF_CALLOC (priv->readdirp_threads,
+                                            sizeof (pthread_t),
+                                            gf_posix_mt_pthread_t);
+        if (!priv->readdirp_workers) {
+                priv->readdirp_threads = 0;
+                ret = -1;
+                goto out;
+        }
+
+        for (i = 0; i < priv->readdirp_threads; i++) {
+                ret = pthread_create (&priv->readdirp_workers[i], NULL,
+                                      posix_readdirp_worker_proc, this);
+                if (ret != 0) {
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "spawning readdirp worker failed: %s",
+                                strerror (ret));
+                        /* keep the workers already running */
+                        priv->readdirp_threads = i;
+                        ret = -1;
+                        goto out;
+                }
+        }
+out:
+        return ret;
+}
+
+
+void
+posix_stop_readdirp_workers (xlator_t *this)
+{
+        struct posix_private *priv = NULL;
+        int                   i    = 0;
+
+        priv = this->private;
+
+        if (!priv->readdirp_workers)
+                return;
+
+        pthread_mutex_lock (&priv->readdirp_lock);
+        {
+                priv->readdirp_fini = _gf_true;
+                pthread_cond_broadcast (&priv->readdirp_cond);
+        }
+        pthread_mutex_unlock (&priv->readdirp_lock);
+
+        for (i = 0; i < priv->readdirp_threads; i++)
+                pthread_join (priv->readdirp_workers[i], NULL);
+
+        GF_FREE (priv->readdirp_workers);
+        priv->readdirp_workers = NULL;
+        priv->readdirp_threads = 0;
+}
+
+
+int
+posix_fsync_queue (call_frame_t *frame, xlator_t *this, fd_t *fd, int _fd,
+                   int datasync, struct iatt *preop)
+{
+        struct posix_private   *priv = NULL;
+        struct posix_fsync_req *req  = NULL;
+
+        priv = this->private;
+
+        req = GF_CALLOC (1, sizeof (*req), gf_posix_mt_fsync_req);
+        if (!req)
+                return -1;
+
+        INIT_LIST_HEAD (&req->list);
+        req->frame    = frame;
+        req->fd       = fd_ref (fd);
+        req->_fd      = _fd;
+        req->datasync = datasync;
+        req->preop    = *preop;
+
+        pthread_mutex_lock (&priv->fsync_lock);
+        {
+                list_add_tail (&req->list, &priv->fsyncs);
+                priv->fsync_queue_count++;
+                /* wake the fsyncer for the first request of a batch, and
+                   once more when the batch is full */
+                if (priv->fsync_queue_count == 1 ||
+                    priv->fsync_queue_count == POSIX_FSYNC_BATCH_MAX)
+                        pthread_cond_signal (&priv->fsync_cond);
+        }
+        pthread_mutex_unlock (&priv->fsync_lock);
+
+        return 0;
+}
+
+
+static int
+posix_fsync_one (xlator_t *this, int _fd, int datasync)
+{
+        int ret = -1;
+
+        if (datasync) {
+#ifdef HAVE_FDATASYNC
+                ret = fdatasync (_fd);
+#else
+                ret = fsync (_fd);
+#endif
+        } else {
+                ret = fsync (_fd);
+        }
+
+        if (ret == -1)
+                gf_log (this->name, GF_LOG_ERROR, "%s on fd %d failed: %s",
+                        datasync ? "fdatasync" : "fsync", _fd,
+                        strerror (errno));
+
+        return ret;
+}
+
+
+/* sync every request of the batch, with a single syncfs of the brick or
+   with one fsync per inode, the full fsync winning over fdatasync when
+   both were asked for */
+static void
+posix_fsync_batch_sync (xlator_t *this, struct list_head *batch)
+{
+        struct posix_private   *priv     = NULL;
+        struct posix_fsync_req *req      = NULL;
+        struct posix_fsync_req *tmp      = NULL;
+        int                     datasync = 0;
+        int                     ret      = -1;
+        int                     op_errno = 0;
+
+        priv = this->private;
+
+        list_for_each_entry (req, batch, list)
+                req->op_ret = 1;        /* not synced yet */
+
+#ifdef HAVE_SYNCFS
+        if (priv->batch_fsync_syncfs) {
+                req = list_entry (batch->next, struct posix_fsync_req, list);
+
+                ret = syncfs (req->_fd);
+                op_errno = errno;
+                priv->fsync_syscalls++;
+                if (ret == -1)
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "syncfs failed: %s", strerror (op_errno));
+
+                list_for_each_entry (req, batch, list) {
+                        req->op_ret = ret;
+                        req->op_errno = (ret == -1) ? op_errno : 0;
+                }
+                return;
+        }
+#endif
+
+        list_for_each_entry (req, batch, list) {
+                if (req->op_ret != 1)
+                        continue;
+
+                datasync = req->datasync;
+                for (tmp = req; &tmp->list != batch;
+                     tmp = list_entry (tmp->list.next,
+                                       struct posix_fsync_req, list)) {
+                        if (tmp->fd->inode == req->fd->inode)
+                                datasync = datasync && tmp->datasync;
+                }
+
+                ret = posix_fsync_one (this, req->_fd, datasync);
+                op_errno = errno;
+                priv->fsync_syscalls++;
+
+                for (tmp = req; &tmp->list != batch;
+                     tmp = list_entry (tmp->list.next,
+                                       struct posix_fsync_req, list)) {
+                        if (tmp->fd->inode != req->fd->inode)
+                                continue;
+                        tmp->op_ret = ret;
+                        tmp->op_errno = (ret == -1) ? op_errno : 0;
+                }
+        }
+}
+
+
+static void
+posix_fsync_batch (xlator_t *this, struct list_head *batch, int count,
+                   uint32_t window)
+{
+        struct posix_fsync_req *req    = NULL;
+        struct posix_fsync_req *tmp    = NULL;
+        struct iatt             postop = {0,};
+        dict_t                 *xdata  = NULL;
+
+        posix_fsync_batch_sync (this, batch);
+
+        xdata = dict_new ();
+        if (xdata) {
+                if (dict_set_uint32 (xdata, GLUSTERFS_FSYNC_BATCH_SIZE,
+                                     count) ||
+                    dict_set_uint32 (xdata, GLUSTERFS_FSYNC_BATCH_WINDOW,
+                                     window)) {
+                        dict_unref (xdata);
+                        xdata = NULL;
+                }
+        }
+
+        list_for_each_entry_safe (req, tmp, batch, list) {
+                list_del_init (&req->list);
+
+                memset (&postop, 0, sizeof (postop));
+                if (req->op_ret == 0 &&
+                    posix_fdstat (this, req->_fd, &postop) == -1) {
+                        req->op_ret = -1;
+                        req->op_errno = errno;
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "post-operation fstat failed on fd=%p: %s",
+                                req->fd, strerror (req->op_errno));
+                }
+
+                STACK_UNWIND_STRICT (fsync, req->frame, req->op_ret,
+                                     req->op_errno, &req->preop, &postop,
+                                     xdata);
+
+                fd_unref (req->fd);
+                GF_FREE (req);
+        }
+
+        if (xdata)
+                dict_unref (xdata);
+}
+
+
+static void *
+posix_fsyncer_proc (void *data)
+{
+        xlator_t             *this     = NULL;
+        struct posix_private *priv     = NULL;
+        struct list_head      batch;
+        struct timeval        start    = {0,};
+        struct timeval        end      = {0,};
+        struct timespec       deadline = {0,};
+        uint32_t              window   = 0;
+        uint32_t              waited   = 0;
+        uint32_t              limit    = 0;
+        int                   count    = 0;
+
+        this = data;
+        priv = this->private;
+
+        THIS = this;
+
+        INIT_LIST_HEAD (&batch);
+
+        for (;;) {
+                pthread_mutex_lock (&priv->fsync_lock);
+                {
+                        while (list_empty (&priv->fsyncs) &&
+                               !priv->fsyncer_fini)
+                                pthread_cond_wait (&priv->fsync_cond,
+                                                   &priv->fsync_lock);
+
+                        if (list_empty (&priv->fsyncs)) {
+                                pthread_mutex_unlock (&priv->fsync_lock);
+                                break;
+                        }
+
+                        /* let the fsyncs arriving within the window join
+                           the one which opened it */
+                        window = priv->batch_fsync_window;
+                        gettimeofday (&start, NULL);
+                        deadline.tv_sec = start.tv_sec +
+                                (start.tv_usec + window) / 1000000;
+                        deadline.tv_nsec =
+                                ((start.tv_usec + window) % 1000000) * 1000;
+
+                        while (window && !priv->fsyncer_fini &&
+                               priv->fsync_queue_count < POSIX_FSYNC_BATCH_MAX) {
+                                if (pthread_cond_timedwait (&priv->fsync_cond,
+                                                            &priv->fsync_lock,
+                                                            &deadline)
+                                    == ETIMEDOUT)
+                                        break;
+                        }
+
+                        list_splice_init (&priv->fsyncs, &batch);
+                        count = priv->fsync_queue_count;
+                        priv->fsync_queue_count = 0;
+
+                        gettimeofday (&end, NULL);
+                        waited = (end.tv_sec - start.tv_sec) * 1000000 +
+                                 (end.tv_usec - start.tv_usec);
+
+                        /* widen the window while fsyncs keep coming in
+                           together, narrow it back when they do not */
+                        limit = priv->batch_fsync_delay_usec;
+                        if (count > 1)
+                                window = max (window * 2, limit / 16);
+                        else
+                                window = max (window / 2, limit / 16);
+                        priv->batch_fsync_window = min (window, limit);
+
+                        priv->fsync_batches++;
+                        priv->fsync_batched += count;
+                }
+                pthread_mutex_unlock (&priv->fsync_lock);
+
+                posix_fsync_batch (this, &batch, count, waited);
+        }
+
+        return NULL;
+}
+
+
+int
+posix_spawn_fsyncer_thread (xlator_t *this)
+{
+        struct posix_private *priv = NULL;
+        int                   ret  = 0;
+
+        priv = this->private;
+
+        pthread_mutex_lock (&priv->fsync_lock);
+        {
+                /* a reconfigured delay bounds the window right away */
+                priv->batch_fsync_window = min (priv->batch_fsync_window,
+                                                priv->batch_fsync_delay_usec);
+                if (priv->fsyncer_present)
+                        goto unlock;
+
+                priv->batch_fsync_window = priv->batch_fsync_delay_usec / 16;
+
+                ret = pthread_create (&priv->fsyncer, NULL,
+                                      posix_fsyncer_proc, this);
+                if (ret != 0) {
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "spawning fsyncer thread failed: %s",
+                                strerror (ret));
+                        ret = -1;
+                        goto unlock;
+                }
+
+                priv->fsyncer_present = _gf_true;
+        }
+unlock:
+        pthread_mutex_unlock (&priv->fsync_lock);
+
+        return ret;
+}
+
+
+void
+posix_stop_fsyncer_thread (xlator_t *this)
+{
+        struct posix_private *priv = NULL;
+
+        priv = this->private;
+
+        if (!priv->fsyncer_present)
+                return;
+
+        /* the fsyncer syncs and acknowledges what is queued before
+           leaving */
+        pthread_mutex_lock (&priv->fsync_lock);
+        {
+                priv->fsyncer_fini = _gf_true;
+                pthread_cond_broadcast (&priv->fsync_cond);
+        }
+        pthread_mutex_unlock (&priv->fsync_lock);
+
+        pthread_join (priv->fsyncer, NULL);
+        priv->fsyncer_present = _gf_false;
+}
+
+
 int
 posix_acl_xattr_set (xlator_t *this, const char *path, dict_t *xattr_req)
 {
@@ -960,6 +1517,192 @@ out:
         return ret;
 }
 
+int
+posix_acl_xattr_fset (xlator_t *this, int fd, dict_t *xattr_req)
+{
+        int          ret = 0;
+        data_t      *data = NULL;
+
+        if (!xattr_req)
+                goto out;
+
+        data = dict_get (xattr_req, "system.posix_acl_access");
+        if (data) {
+                ret = sys_fsetxattr (fd, "system.posix_acl_access",
+                                     data->data, data->len, 0);
+                if (ret != 0)
+                        goto out;
+        }
+
+        data = dict_get (xattr_req, "system.posix_acl_default");
+        if (data) {
+                ret = sys_fsetxattr (fd, "system.posix_acl_default",
+                                     data->data, data->len, 0);
+                if (ret != 0)
+                        goto out;
+        }
+
+out:
+        return ret;
+}
+
+int
+posix_entry_create_fxattr_set (xlator_t *this, int fd, dict_t *dict)
+{
+        int ret = -1;
+
+        if (!dict)
+                goto out;
+
+        int _handle_keyvalue_pair (dict_t *d, char *k, data_t *v,
+                                   void *tmp)
+        {
+                if (!strcmp (GFID_XATTR_KEY, k) ||
+                    !strcmp ("gfid-req", k) ||
+                    !strcmp ("system.posix_acl_default", k) ||
+                    !strcmp ("system.posix_acl_access", k) ||
+                    ZR_FILE_CONTENT_REQUEST(k)) {
+                        return 0;
+                }
+
+                ret = posix_fhandle_pair (this, fd, k, v, XATTR_CREATE);
+                if (ret < 0) {
+                        errno = -ret;
+                        return -1;
+                }
+                return 0;
+        }
+
+        ret = dict_foreach (dict, _handle_keyvalue_pair, NULL);
+
+out:
+        return ret;
+}
+
+/* creates @real_path from an unnamed inode of its parent directory, which
+ * gets its gfid, handle, ACLs and xattrs before its name is linked in: a
+ * crash or a concurrent lookup never sees the entry half set up, and none
+ * of those updates goes through a path lookup. Returns the open fd, or -1
+ * with errno set. Nothing is left behind on failure, and but for EEXIST,
+ * which only comes from linking the name, the caller can create the file
+ * the regular way instead. */
+int
+posix_create_tmpfile (xlator_t *this, const char *par_path,
+                      const char *real_path, int flags, mode_t mode,
+                      uid_t uid, gid_t gid, dict_t *xdata)
+{
+        struct posix_private *priv     = NULL;
+        void                 *uuid_req = NULL;
+        char                 *handle   = NULL;
+        int                   _fd      = -1;
+        int                   ret      = -1;
+        int                   op_errno = EINVAL;
+
+#if defined(O_TMPFILE) && defined(HAVE_LINKAT)
+        priv = this->private;
+
+        /* without a gfid to link a handle to, or when the file would
+           have to be opened for writing regardless of the client flags */
+        if (!xdata || dict_get_ptr (xdata, "gfid-req", &uuid_req) ||
+            (flags & O_ACCMODE) == O_RDONLY)
+                goto out;
+
+        _fd = open (par_path, (flags & ~(O_CREAT | O_EXCL | O_TRUNC)) |
+                    O_TMPFILE, mode);
+        if (_fd == -1) {
+                op_errno = errno;
+                /* EISDIR from kernels which do not know O_TMPFILE */
+                if (op_errno == EOPNOTSUPP || op_errno == EISDIR) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "O_TMPFILE not supported on %s (%s), "
+                                "creating files the regular way",
+                                par_path, strerror (op_errno));
+                        priv->create_tmpfile = _gf_false;
+                }
+                goto out;
+        }
+
+        ret = sys_fsetxattr (_fd, GFID_XATTR_KEY, uuid_req, 16, XATTR_CREATE);
+        if (ret) {
+                op_errno = (errno == EEXIST) ? EAGAIN : errno;
+                gf_log (this->name, GF_LOG_WARNING,
+                        "setting GFID for %s failed (%s)", real_path,
+                        strerror (op_errno));
+                goto out;
+        }
+
+#ifndef HAVE_SET_FSID
+        ret = fchown (_fd, uid, gid);
+        if (ret) {
+                op_errno = errno;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "chown on %s failed: %s",
+                        real_path, strerror (op_errno));
+                goto out;
+        }
+#endif
+
+        ret = posix_acl_xattr_fset (this, _fd, xdata);
+        if (ret) {
+                op_errno = errno;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "setting ACLs on %s failed (%s)", real_path,
+                        strerror (op_errno));
+                goto out;
+        }
+
+        ret = posix_entry_create_fxattr_set (this, _fd, xdata);
+        if (ret) {
+                op_errno = errno;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "setting xattrs on %s failed (%s)", real_path,
+                        strerror (op_errno));
+                goto out;
+        }
+
+        ret = posix_handle_hard_fd (this, _fd, uuid_req);
+        if (ret) {
+                op_errno = errno;
+                /* EEXIST tells the caller the name exists, not a stale
+                   handle: let the regular path deal with the latter */
+                if (op_errno == EEXIST)
+                        op_errno = EAGAIN;
+                goto out;
+        }
+
+        /* the handle went in above, its path cannot fail here */
+        MAKE_HANDLE_PATH (handle, this, uuid_req, NULL);
+        ret = linkat (AT_FDCWD, handle, AT_FDCWD, real_path, 0);
+        if (ret) {
+                op_errno = errno;
+                unlink (handle);
+                /* lost a race with another create: without O_EXCL the
+                   regular path opens what the winner created */
+                if (op_errno == EEXIST && !(flags & O_EXCL))
+                        op_errno = EAGAIN;
+                else if (op_errno != EEXIST)
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "link %s -> %s failed (%s)", handle,
+                                real_path, strerror (op_errno));
+                goto out;
+        }
+
+        ret = 0;
+out:
+        if (ret) {
+                if (_fd != -1)
+                        close (_fd);
+                _fd = -1;
+                errno = op_errno;
+        }
+
+        return _fd;
+#else
+        errno = ENOSYS;
+        return -1;
+#endif
+}
+
 
 static int
 __posix_fd_ctx_get (fd_t *fd, xlator_t *this, struct posix_fd **pfd_p)
@@ -21,6 +21,17 @@ enum gf_posix_mem_types_ {
         gf_posix_mt_posix_dev_t,
         gf_posix_mt_trash_path,
 	gf_posix_mt_paiocb,
+        gf_posix_mt_pthread_t,
+        gf_posix_mt_handle_cache,
+        gf_posix_mt_handle_cache_entry,
+        gf_posix_mt_uring_req,
+        gf_posix_mt_fsync_req,
+        gf_posix_mt_xattrop_cache,
+        gf_posix_mt_xattrop_entry,
+        gf_posix_mt_scrub,
+        gf_posix_mt_scrub_gfid,
+        gf_posix_mt_reclaim,
+        gf_posix_mt_reclaim_file,
         gf_posix_mt_end
 };
 #endif
@@ -0,0 +1,586 @@
+/*
+   Copyright (c) 2012 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <alloca.h>
+
+#include "xlator.h"
+#include "glusterfs.h"
+#include "posix.h"
+#include "posix-reclaim.h"
+#include "syscall.h"
+#include "statedump.h"
+
+/*
+ * Reclaimer.
+ *
+ * Unlinking the last name of a large file makes the backend free all its
+ * extents before unlink returns, which holds the io-thread for as long.
+ * Instead, the file is renamed into the landfill under POSIX_RECLAIM_PFX
+ * and the unlink returns.  A pool of reclaimer threads then shrinks each
+ * file with ftruncate, POSIX_RECLAIM_STEP at a time and no faster than
+ * max_rate, and unlinks what is left.
+ *
+ * statfs counts the space held by the files still in the landfill as free,
+ * the way it would be had they been unlinked inline.  Files left over by a
+ * restart are found in the landfill and queued again at start.  The janitor
+ * leaves these files alone while the reclaimer runs, and hands it the large
+ * files of the directories moved to the landfill.
+ */
+
+static int
+posix_reclaim_queue (struct posix_reclaim *reclaim, const char *name,
+                     uint64_t bytes)
+{
+        struct posix_reclaim_file *file = NULL;
+
+        file = GF_CALLOC (1, sizeof (*file), gf_posix_mt_reclaim_file);
+        if (!file)
+                return -1;
+
+        strncpy (file->name, name, sizeof (file->name) - 1);
+        file->bytes = bytes;
+
+        pthread_mutex_lock (&reclaim->lock);
+        {
+                list_add_tail (&file->list, &reclaim->queue);
+                reclaim->queued++;
+                reclaim->pending_bytes += bytes;
+                pthread_cond_signal (&reclaim->cond);
+        }
+        pthread_mutex_unlock (&reclaim->lock);
+
+        return 0;
+}
+
+
+static uint64_t
+posix_reclaim_usec_since (struct timeval *start)
+{
+        struct timeval now = {0, };
+
+        gettimeofday (&now, NULL);
+        if (timercmp (&now, start, <))
+                return 0;
+
+        return (now.tv_sec - start->tv_sec) * 1000000ULL +
+                now.tv_usec - start->tv_usec;
+}
+
+
+/* account @freed bytes and wait until the bytes freed by all the threads
+   are back under max_rate; returns -1 when woken up by fini */
+static int
+posix_reclaim_throttle (struct posix_reclaim *reclaim, uint64_t freed)
+{
+        struct timeval  now      = {0, };
+        struct timespec deadline = {0, };
+        uint64_t        elapsed  = 0;
+        uint64_t        due      = 0;
+        int             ret      = 0;
+
+        pthread_mutex_lock (&reclaim->lock);
+        {
+                reclaim->rate_bytes += freed;
+                if (!reclaim->max_rate)
+                        goto unlock;
+
+                elapsed = posix_reclaim_usec_since (&reclaim->rate_start);
+                due = reclaim->rate_bytes * 1000000ULL /
+                        ((uint64_t) reclaim->max_rate * GF_UNIT_MB);
+                if (due <= elapsed) {
+                        if (elapsed >= 1000000) {
+                                gettimeofday (&reclaim->rate_start, NULL);
+                                reclaim->rate_bytes = 0;
+                        }
+                        goto unlock;
+                }
+
+                gettimeofday (&now, NULL);
+                due = due - elapsed + now.tv_usec;
+                deadline.tv_sec = now.tv_sec + due / 1000000;
+                deadline.tv_nsec = (due % 1000000) * 1000;
+
+                while (!reclaim->fini) {
+                        if (pthread_cond_timedwait (&reclaim->cond,
+                                                    &reclaim->lock, &deadline)
+                            == ETIMEDOUT)
+                                break;
+                }
+                reclaim->throttled_usec += posix_reclaim_usec_since (&now);
+        }
+unlock:
+        if (reclaim->fini)
+                ret = -1;
+        pthread_mutex_unlock (&reclaim->lock);
+
+        return ret;
+}
+
+
+static void
+posix_reclaim_freed (struct posix_reclaim *reclaim,
+                     struct posix_reclaim_file *file, uint64_t freed)
+{
+        if (freed > file->bytes)
+                freed = file->bytes;
+
+        pthread_mutex_lock (&reclaim->lock);
+        {
+                file->bytes -= freed;
+                reclaim->pending_bytes -= freed;
+                reclaim->reclaimed_bytes += freed;
+        }
+        pthread_mutex_unlock (&reclaim->lock);
+}
+
+
+static void
+posix_reclaim_file (xlator_t *this, struct posix_reclaim *reclaim,
+                    struct posix_reclaim_file *file)
+{
+        struct posix_private *priv   = NULL;
+        char                  path[PATH_MAX];
+        struct stat           before = {0, };
+        struct stat           after  = {0, };
+        off_t                 size   = 0;
+        uint64_t              freed  = 0;
+        int                   fd     = -1;
+
+        priv = this->private;
+
+        snprintf (path, sizeof (path), "%s/%s", priv->trash_path, file->name);
+
+        fd = open (path, O_WRONLY | O_NOFOLLOW);
+        if (fd == -1) {
+                if (errno != ENOENT)
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "open of %s failed: %s, unlinking it",
+                                path, strerror (errno));
+                goto unlink;
+        }
+
+        if (fstat (fd, &before) == -1)
+                goto unlink;
+        size = before.st_size;
+
+        while (size > 0) {
+                size = (size > POSIX_RECLAIM_STEP) ?
+                        size - POSIX_RECLAIM_STEP : 0;
+
+                if (ftruncate (fd, size) == -1) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "truncate of %s failed: %s, unlinking it",
+                                path, strerror (errno));
+                        break;
+                }
+
+                if (fstat (fd, &after) == -1)
+                        break;
+                freed = (before.st_blocks > after.st_blocks) ?
+                        (before.st_blocks - after.st_blocks) * 512ULL : 0;
+                before = after;
+
+                posix_reclaim_freed (reclaim, file, freed);
+
+                /* the rest is reclaimed after the restart */
+                if (posix_reclaim_throttle (reclaim, freed)) {
+                        close (fd);
+                        return;
+                }
+        }
+
+unlink:
+        if (fd != -1)
+                close (fd);
+
+        if (unlink (path) == -1 && errno != ENOENT)
+                gf_log (this->name, GF_LOG_WARNING, "unlink of %s failed: %s",
+                        path, strerror (errno));
+
+        posix_reclaim_freed (reclaim, file, file->bytes);
+
+        pthread_mutex_lock (&reclaim->lock);
+        {
+                reclaim->reclaimed++;
+        }
+        pthread_mutex_unlock (&reclaim->lock);
+}
+
+
+static void *
+posix_reclaimer (void *data)
+{
+        xlator_t                  *this    = NULL;
+        struct posix_private      *priv    = NULL;
+        struct posix_reclaim      *reclaim = NULL;
+        struct posix_reclaim_file *file    = NULL;
+
+        this = data;
+        priv = this->private;
+        reclaim = priv->reclaim;
+
+        THIS = this;
+
+        for (;;) {
+                file = NULL;
+                pthread_mutex_lock (&reclaim->lock);
+                {
+                        while (!reclaim->fini && list_empty (&reclaim->queue))
+                                pthread_cond_wait (&reclaim->cond,
+                                                   &reclaim->lock);
+                        if (!reclaim->fini) {
+                                file = list_entry (reclaim->queue.next,
+                                                   struct posix_reclaim_file,
+                                                   list);
+                                list_del_init (&file->list);
+                                reclaim->queued--;
+                                reclaim->active++;
+                        }
+                }
+                pthread_mutex_unlock (&reclaim->lock);
+
+                if (!file)
+                        break;
+
+                posix_reclaim_file (this, reclaim, file);
+
+                pthread_mutex_lock (&reclaim->lock);
+                {
+                        reclaim->active--;
+                }
+                pthread_mutex_unlock (&reclaim->lock);
+
+                GF_FREE (file);
+        }
+
+        return NULL;
+}
+
+
+/* queue what the previous run of the brick left in the landfill */
+static void
+posix_reclaim_scan (xlator_t *this, struct posix_reclaim *reclaim)
+{
+        struct posix_private *priv  = NULL;
+        DIR                  *dir   = NULL;
+        struct dirent        *entry = NULL;
+        struct stat           stbuf = {0, };
+        int                   count = 0;
+
+        priv = this->private;
+
+        dir = opendir (priv->trash_path);
+        if (!dir)
+                return;
+
+        while ((entry = readdir (dir))) {
+                if (strncmp (entry->d_name, POSIX_RECLAIM_PFX,
+                             strlen (POSIX_RECLAIM_PFX)) ||
+                    strlen (entry->d_name) >= POSIX_RECLAIM_NAME_MAX)
+                        continue;
+
+                if (fstatat (dirfd (dir), entry->d_name, &stbuf,
+                             AT_SYMLINK_NOFOLLOW) == -1 ||
+                    !S_ISREG (stbuf.st_mode))
+                        continue;
+
+                if (posix_reclaim_queue (reclaim, entry->d_name,
+                                         stbuf.st_blocks * 512ULL) == 0)
+                        count++;
+        }
+
+        closedir (dir);
+
+        if (count)
+                gf_log (this->name, GF_LOG_INFO, "%d unlinked files left "
+                        "to reclaim in %s", count, priv->trash_path);
+}
+
+
+static void
+posix_reclaim_free (struct posix_reclaim *reclaim)
+{
+        struct posix_reclaim_file *file = NULL;
+        struct posix_reclaim_file *tmp  = NULL;
+
+        list_for_each_entry_safe (file, tmp, &reclaim->queue, list) {
+                list_del (&file->list);
+                GF_FREE (file);
+        }
+
+        pthread_mutex_destroy (&reclaim->lock);
+        pthread_cond_destroy (&reclaim->cond);
+
+        GF_FREE (reclaim);
+}
+
+
+int
+posix_reclaim_init (xlator_t *this, gf_boolean_t enable, int threads,
+                    uint64_t min_size, uint32_t max_rate)
+{
+        struct posix_private *priv    = NULL;
+        struct posix_reclaim *reclaim = NULL;
+        int                   ret     = -1;
+        int                   i       = 0;
+
+        priv = this->private;
+
+        if (!enable)
+                return 0;
+
+        reclaim = GF_CALLOC (1, sizeof (*reclaim), gf_posix_mt_reclaim);
+        if (!reclaim)
+                goto out;
+
+        pthread_mutex_init (&reclaim->lock, NULL);
+        pthread_cond_init (&reclaim->cond, NULL);
+        INIT_LIST_HEAD (&reclaim->queue);
+        reclaim->min_size = min_size;
+        reclaim->max_rate = max_rate;
+        gettimeofday (&reclaim->rate_start, NULL);
+
+        posix_reclaim_scan (this, reclaim);
+
+        priv->reclaim = reclaim;
+
+        for (i = 0; i < threads && i < POSIX_RECLAIM_MAX_THREADS; i++) {
+                ret = pthread_create (&reclaim->threads[i], NULL,
+                                      posix_reclaimer, this);
+                if (ret != 0) {
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "spawning reclaimer failed: %s",
+                                strerror (ret));
+                        break;
+                }
+                reclaim->nthreads++;
+        }
+
+        if (!reclaim->nthreads) {
+                priv->reclaim = NULL;
+                ret = -1;
+                goto out;
+        }
+
+        ret = 0;
+        reclaim = NULL;
+out:
+        if (reclaim)
+                posix_reclaim_free (reclaim);
+
+        return ret;
+}
+
+
+void
+posix_reclaim_fini (xlator_t *this)
+{
+        struct posix_private *priv    = NULL;
+        struct posix_reclaim *reclaim = NULL;
+        int                   i       = 0;
+
+        priv = this->private;
+        reclaim = priv->reclaim;
+        if (!reclaim)
+                return;
+
+        pthread_mutex_lock (&reclaim->lock);
+        {
+                reclaim->fini = _gf_true;
+                pthread_cond_broadcast (&reclaim->cond);
+        }
+        pthread_mutex_unlock (&reclaim->lock);
+
+        for (i = 0; i < reclaim->nthreads; i++)
+                pthread_join (reclaim->threads[i], NULL);
+
+        /* what is left stays in the landfill for the next start */
+        priv->reclaim = NULL;
+        posix_reclaim_free (reclaim);
+}
+
+
+void
+posix_reclaim_reconf (xlator_t *this, uint64_t min_size, uint32_t max_rate)
+{
+        struct posix_private *priv    = NULL;
+        struct posix_reclaim *reclaim = NULL;
+
+        priv = this->private;
+        reclaim = priv->reclaim;
+        if (!reclaim)
+                return;
+
+        pthread_mutex_lock (&reclaim->lock);
+        {
+                reclaim->min_size = min_size;
+                reclaim->max_rate = max_rate;
+                pthread_cond_broadcast (&reclaim->cond);
+        }
+        pthread_mutex_unlock (&reclaim->lock);
+}
+
+
+/* move the file at @path, its last name, to the landfill for the reclaimer
+   to free; returns -1 when it is to be unlinked inline. A file still open
+   on the brick is, as its data has to outlive the name until the last
+   close, and the reclaimer would truncate it away. */
+int
+posix_reclaim_defer (xlator_t *this, const char *path, inode_t *inode,
+                     struct iatt *stbuf)
+{
+        struct posix_private *priv     = NULL;
+        struct posix_reclaim *reclaim  = NULL;
+        char                  name[POSIX_RECLAIM_NAME_MAX];
+        char                 *landfill = NULL;
+        uint64_t              bytes    = 0;
+        uint64_t              min_size = 0;
+        gf_boolean_t          busy     = _gf_false;
+
+        priv = this->private;
+        reclaim = priv->reclaim;
+
+        pthread_mutex_lock (&reclaim->lock);
+        {
+                min_size = reclaim->min_size;
+        }
+        pthread_mutex_unlock (&reclaim->lock);
+
+        bytes = stbuf->ia_blocks * 512ULL;
+        if (!IA_ISREG (stbuf->ia_type) || stbuf->ia_nlink > 1 ||
+            bytes < min_size || uuid_is_null (stbuf->ia_gfid))
+                return -1;
+
+        if (inode) {
+                LOCK (&inode->lock);
+                {
+                        busy = !list_empty (&inode->fd_list);
+                }
+                UNLOCK (&inode->lock);
+        }
+
+        if (busy)
+                return -1;
+
+        snprintf (name, sizeof (name), POSIX_RECLAIM_PFX"%s",
+                  uuid_utoa (stbuf->ia_gfid));
+
+        landfill = alloca (strlen (priv->trash_path) + 1 + strlen (name) + 1);
+        sprintf (landfill, "%s/%s", priv->trash_path, name);
+
+        if (rename (path, landfill) == -1) {
+                gf_log (this->name, GF_LOG_WARNING, "moving %s to the "
+                        "landfill failed: %s, unlinking it", path,
+                        strerror (errno));
+                return -1;
+        }
+
+        /* the file is gone from the namespace: failing to queue it only
+           delays the reclaim to the next start */
+        if (posix_reclaim_queue (reclaim, name, bytes) == 0) {
+                pthread_mutex_lock (&reclaim->lock);
+                {
+                        reclaim->deferred++;
+                }
+                pthread_mutex_unlock (&reclaim->lock);
+        }
+
+        return 0;
+}
+
+
+/* whether the janitor is to leave @path, at @level under the landfill,
+   to the reclaimer */
+gf_boolean_t
+posix_reclaim_owns (xlator_t *this, const char *path, int level)
+{
+        struct posix_private *priv = NULL;
+        const char           *base = NULL;
+
+        priv = this->private;
+        if (!priv->reclaim || level != 1)
+                return _gf_false;
+
+        base = strrchr (path, '/');
+        base = base ? base + 1 : path;
+
+        return (strncmp (base, POSIX_RECLAIM_PFX,
+                         strlen (POSIX_RECLAIM_PFX)) == 0);
+}
+
+
+uint64_t
+posix_reclaim_pending (xlator_t *this)
+{
+        struct posix_private *priv    = NULL;
+        struct posix_reclaim *reclaim = NULL;
+        uint64_t              pending = 0;
+
+        priv = this->private;
+        reclaim = priv->reclaim;
+        if (!reclaim)
+                return 0;
+
+        pthread_mutex_lock (&reclaim->lock);
+        {
+                pending = reclaim->pending_bytes;
+        }
+        pthread_mutex_unlock (&reclaim->lock);
+
+        return pending;
+}
+
+
+void
+posix_reclaim_dump (xlator_t *this)
+{
+        struct posix_private *priv    = NULL;
+        struct posix_reclaim *reclaim = NULL;
+
+        priv = this->private;
+        reclaim = priv->reclaim;
+        if (!reclaim)
+                return;
+
+        pthread_mutex_lock (&reclaim->lock);
+        {
+                gf_proc_dump_write ("reclaim.threads", "%d",
+                                    reclaim->nthreads);
+                gf_proc_dump_write ("reclaim.min_size", "%"PRIu64,
+                                    reclaim->min_size);
+                gf_proc_dump_write ("reclaim.max_rate", "%u MB/s",
+                                    reclaim->max_rate);
+                gf_proc_dump_write ("reclaim.queued", "%d",
+                                    reclaim->queued);
+                gf_proc_dump_write ("reclaim.active", "%d",
+                                    reclaim->active);
+                gf_proc_dump_write ("reclaim.pending_bytes", "%"PRIu64,
+                                    reclaim->pending_bytes);
+                gf_proc_dump_write ("reclaim.deferred", "%"PRIu64,
+                                    reclaim->deferred);
+                gf_proc_dump_write ("reclaim.reclaimed", "%"PRIu64,
+                                    reclaim->reclaimed);
+                gf_proc_dump_write ("reclaim.reclaimed_bytes", "%"PRIu64,
+                                    reclaim->reclaimed_bytes);
+                gf_proc_dump_write ("reclaim.throttled_usec", "%"PRIu64,
+                                    reclaim->throttled_usec);
+        }
+        pthread_mutex_unlock (&reclaim->lock);
+}
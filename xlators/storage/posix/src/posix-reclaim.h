@@ -0,0 +1,78 @@
+/*
+   Copyright (c) 2012 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+#ifndef _POSIX_RECLAIM_H
+#define _POSIX_RECLAIM_H
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include <pthread.h>
+
+#include "xlator.h"
+#include "glusterfs.h"
+
+/* Name prefix, in the landfill, of the files waiting to be reclaimed */
+#define POSIX_RECLAIM_PFX "reclaim-"
+
+/* Freed by one ftruncate of the reclaimer */
+#define POSIX_RECLAIM_STEP (64 * GF_UNIT_MB)
+
+#define POSIX_RECLAIM_MAX_THREADS 16
+
+#define POSIX_RECLAIM_NAME_MAX 64
+
+/* an unlinked file moved to the landfill */
+struct posix_reclaim_file {
+        struct list_head  list;
+        char              name[POSIX_RECLAIM_NAME_MAX]; /* in the landfill */
+        uint64_t          bytes;        /* allocated, not freed yet */
+};
+
+struct posix_reclaim {
+        pthread_mutex_t   lock;
+        pthread_cond_t    cond;
+        pthread_t         threads[POSIX_RECLAIM_MAX_THREADS];
+        int               nthreads;
+        gf_boolean_t      fini;
+
+        struct list_head  queue;
+        int               queued;
+        int               active;
+
+        /* allocated bytes of the files moved to the landfill and not freed
+           yet, counted as free by statfs */
+        uint64_t          pending_bytes;
+
+        uint64_t          min_size;     /* allocated size deferred */
+        uint32_t          max_rate;     /* MB/s freed, 0 for no cap */
+        struct timeval    rate_start;
+        uint64_t          rate_bytes;
+
+        uint64_t          deferred;
+        uint64_t          reclaimed;
+        uint64_t          reclaimed_bytes;
+        uint64_t          throttled_usec;
+};
+
+int posix_reclaim_init (xlator_t *this, gf_boolean_t enable, int threads,
+                        uint64_t min_size, uint32_t max_rate);
+void posix_reclaim_fini (xlator_t *this);
+void posix_reclaim_reconf (xlator_t *this, uint64_t min_size,
+                           uint32_t max_rate);
+int posix_reclaim_defer (xlator_t *this, const char *path, inode_t *inode,
+                         struct iatt *stbuf);
+gf_boolean_t posix_reclaim_owns (xlator_t *this, const char *path,
+                                 int level);
+uint64_t posix_reclaim_pending (xlator_t *this);
+void posix_reclaim_dump (xlator_t *this);
+
+#endif /* !_POSIX_RECLAIM_H */
@@ -0,0 +1,824 @@
+/*
+   Copyright (c) 2012 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <alloca.h>
+
+#include "xlator.h"
+#include "glusterfs.h"
+#include "defaults.h"
+#include "posix.h"
+#include "posix-handle.h"
+#include "posix-scrub.h"
+#include "checksum.h"
+#include "compat-errno.h"
+#include "syscall.h"
+#include "statedump.h"
+
+/*
+ * Scrubber.
+ *
+ * Every regular file carries its checksum in GF_SCRUB_SIGN_KEY, along with
+ * the size and mtime it had when the checksum was taken.  The first write
+ * through an fd removes the checksum, and the release of that fd queues the
+ * file to be signed again.  A background thread signs the queued files and,
+ * every scrub interval, crawls the handles under .glusterfs, signing the
+ * files which have no checksum and verifying the others.
+ *
+ * A file whose data no longer matches its checksum while its size and mtime
+ * still do was corrupted under the brick: it is marked with GF_SCRUB_BAD_KEY,
+ * reads of it fail with EIO and GF_EVENT_SCRUB_BAD goes up the graph with
+ * its gfid, for index to queue it for self-heal.  AFR does not heal from a
+ * copy marked bad, and signing the healed file clears the mark.
+ *
+ * The thread reads nothing until client reads and writes have stopped for
+ * idle_msec, and no faster than max_rate.
+ */
+
+static struct posix_scrub_gfid *
+__posix_scrub_find_bad (struct posix_scrub *scrub, uuid_t gfid)
+{
+        struct posix_scrub_gfid *entry = NULL;
+
+        list_for_each_entry (entry, &scrub->bad, list) {
+                if (uuid_compare (entry->gfid, gfid) == 0)
+                        return entry;
+        }
+
+        return NULL;
+}
+
+
+static void
+posix_scrub_set_bad (struct posix_scrub *scrub, uuid_t gfid,
+                     gf_boolean_t bad)
+{
+        struct posix_scrub_gfid *entry = NULL;
+        struct posix_scrub_gfid *new   = NULL;
+
+        if (bad) {
+                new = GF_CALLOC (1, sizeof (*new), gf_posix_mt_scrub_gfid);
+                if (!new)
+                        return;
+                uuid_copy (new->gfid, gfid);
+        }
+
+        pthread_mutex_lock (&scrub->lock);
+        {
+                entry = __posix_scrub_find_bad (scrub, gfid);
+                if (bad && !entry) {
+                        list_add_tail (&new->list, &scrub->bad);
+                        scrub->nbad++;
+                        new = NULL;
+                } else if (!bad && entry) {
+                        list_del (&entry->list);
+                        scrub->nbad--;
+                }
+        }
+        pthread_mutex_unlock (&scrub->lock);
+
+        if (!bad)
+                new = entry;
+        GF_FREE (new);
+}
+
+
+static void
+posix_scrub_queue (struct posix_scrub *scrub, uuid_t gfid)
+{
+        struct posix_scrub_gfid *entry = NULL;
+
+        entry = GF_CALLOC (1, sizeof (*entry), gf_posix_mt_scrub_gfid);
+        if (!entry)
+                return;
+        uuid_copy (entry->gfid, gfid);
+
+        pthread_mutex_lock (&scrub->lock);
+        {
+                /* an unsigned file is signed by the next pass anyway */
+                if (scrub->queued < POSIX_SCRUB_QUEUE_MAX) {
+                        list_add_tail (&entry->list, &scrub->queue);
+                        scrub->queued++;
+                        pthread_cond_signal (&scrub->cond);
+                        entry = NULL;
+                }
+        }
+        pthread_mutex_unlock (&scrub->lock);
+
+        GF_FREE (entry);
+}
+
+
+static uint64_t
+posix_scrub_usec_since (struct timeval *start)
+{
+        struct timeval now = {0, };
+
+        gettimeofday (&now, NULL);
+        if (timercmp (&now, start, <))
+                return 0;
+
+        return (now.tv_sec - start->tv_sec) * 1000000ULL +
+                now.tv_usec - start->tv_usec;
+}
+
+
+/* returns -1 when woken up by fini */
+static int
+posix_scrub_sleep (struct posix_scrub *scrub, uint64_t usec)
+{
+        struct timeval  now      = {0, };
+        struct timespec deadline = {0, };
+        int             ret      = 0;
+
+        gettimeofday (&now, NULL);
+        usec += now.tv_usec;
+        deadline.tv_sec = now.tv_sec + usec / 1000000;
+        deadline.tv_nsec = (usec % 1000000) * 1000;
+
+        pthread_mutex_lock (&scrub->lock);
+        {
+                while (!scrub->fini) {
+                        if (pthread_cond_timedwait (&scrub->cond,
+                                                    &scrub->lock, &deadline)
+                            == ETIMEDOUT)
+                                break;
+                }
+                if (scrub->fini)
+                        ret = -1;
+        }
+        pthread_mutex_unlock (&scrub->lock);
+
+        return ret;
+}
+
+
+/* wait until client I/O has been idle for idle_msec, then until what was
+   read so far is back under max_rate */
+static int
+posix_scrub_throttle (struct posix_scrub *scrub)
+{
+        struct timeval start   = {0, };
+        uint64_t       elapsed = 0;
+        uint64_t       due     = 0;
+        int            ret     = 0;
+
+        gettimeofday (&start, NULL);
+
+        while (scrub->idle_msec && scrub->io_stamp != scrub->io_seen) {
+                scrub->io_seen = scrub->io_stamp;
+                ret = posix_scrub_sleep (scrub, scrub->idle_msec * 1000ULL);
+                if (ret)
+                        goto out;
+                /* idle time is no credit for a burst */
+                gettimeofday (&scrub->rate_start, NULL);
+                scrub->rate_bytes = 0;
+        }
+
+        if (scrub->max_rate) {
+                elapsed = posix_scrub_usec_since (&scrub->rate_start);
+                due = scrub->rate_bytes * 1000000ULL /
+                        ((uint64_t) scrub->max_rate * GF_UNIT_MB);
+                if (due > elapsed) {
+                        ret = posix_scrub_sleep (scrub, due - elapsed);
+                        if (ret)
+                                goto out;
+                }
+                if (elapsed >= 1000000) {
+                        gettimeofday (&scrub->rate_start, NULL);
+                        scrub->rate_bytes = 0;
+                }
+        }
+
+out:
+        scrub->throttled_usec += posix_scrub_usec_since (&start);
+        return ret;
+}
+
+
+/* chained digest of the 1MB chunks of the file: the digest of a chunk is
+   folded into the running one, so a chunk moved around does not match */
+static int
+posix_scrub_checksum (xlator_t *this, struct posix_scrub *scrub, int fd,
+                      uint8_t *sum)
+{
+        uint8_t  acc[2 * GF_CHECKSUM_LENGTH] = {0, };
+        off_t    offset = 0;
+        ssize_t  len    = 0;
+
+        for (;;) {
+                if (posix_scrub_throttle (scrub))
+                        return -1;
+
+                len = pread (fd, scrub->buf, POSIX_SCRUB_CHUNK, offset);
+                if (len == -1) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "scrub read failed: %s", strerror (errno));
+                        return -1;
+                }
+                if (len == 0)
+                        break;
+
+                gf_rsync_fast_checksum ((unsigned char *) scrub->buf, len,
+                                        acc + GF_CHECKSUM_LENGTH);
+                gf_rsync_fast_checksum (acc, sizeof (acc), acc);
+
+                offset += len;
+                scrub->rate_bytes += len;
+                scrub->pass_bytes += len;
+        }
+
+        memcpy (sum, acc, GF_CHECKSUM_LENGTH);
+        return 0;
+}
+
+
+static gf_boolean_t
+posix_scrub_same (struct iatt *a, struct iatt *b)
+{
+        return (a->ia_size == b->ia_size && a->ia_mtime == b->ia_mtime &&
+                a->ia_mtime_nsec == b->ia_mtime_nsec);
+}
+
+
+static int
+posix_scrub_fstat (int fd, struct iatt *iatt)
+{
+        struct stat stbuf = {0, };
+
+        if (fstat (fd, &stbuf) == -1)
+                return -1;
+
+        iatt_from_stat (iatt, &stbuf);
+        return 0;
+}
+
+
+static void
+posix_scrub_sign_fd (xlator_t *this, struct posix_scrub *scrub, int fd,
+                     uuid_t gfid)
+{
+        struct posix_scrub_sign sign   = {0, };
+        struct iatt             before = {0, };
+        struct iatt             after  = {0, };
+
+        if (posix_scrub_fstat (fd, &before) == -1 ||
+            !IA_ISREG (before.ia_type))
+                return;
+
+        if (posix_scrub_checksum (this, scrub, fd, sign.sum))
+                return;
+
+        /* written meanwhile: the write dropped the checksum, and its
+           release queues the file again */
+        if (posix_scrub_fstat (fd, &after) == -1 ||
+            !posix_scrub_same (&before, &after))
+                return;
+
+        sign.version = POSIX_SCRUB_SIGN_VERSION;
+        sign.type = GF_CHECKSUM_MURMUR3;
+        sign.chunk = POSIX_SCRUB_CHUNK;
+        sign.size = after.ia_size;
+        sign.mtime = after.ia_mtime;
+        sign.mtime_nsec = after.ia_mtime_nsec;
+
+        if (sys_fsetxattr (fd, GF_SCRUB_SIGN_KEY, &sign, sizeof (sign),
+                           0) == -1) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "setting scrub checksum on %s failed: %s",
+                        uuid_utoa (gfid), strerror (errno));
+                return;
+        }
+
+        /* a healed copy is good again */
+        if (sys_fremovexattr (fd, GF_SCRUB_BAD_KEY) == 0)
+                gf_log (this->name, GF_LOG_INFO, "%s signed again, no "
+                        "longer marked bad", uuid_utoa (gfid));
+        posix_scrub_set_bad (scrub, gfid, _gf_false);
+
+        scrub->signed_files++;
+}
+
+
+static void
+posix_scrub_mismatch (xlator_t *this, struct posix_scrub *scrub, int fd,
+                      uuid_t gfid)
+{
+        gf_log (this->name, GF_LOG_ERROR, "checksum mismatch on %s, marking "
+                "it bad for self-heal", uuid_utoa (gfid));
+
+        if (sys_fsetxattr (fd, GF_SCRUB_BAD_KEY, "1", 1, 0) == -1)
+                gf_log (this->name, GF_LOG_WARNING,
+                        "marking %s bad failed: %s", uuid_utoa (gfid),
+                        strerror (errno));
+
+        posix_scrub_set_bad (scrub, gfid, _gf_true);
+        scrub->mismatches++;
+
+        default_notify (this, GF_EVENT_SCRUB_BAD, gfid);
+}
+
+
+static int
+posix_scrub_open (int dirfd, const char *path)
+{
+        int fd = -1;
+
+        fd = openat (dirfd, path, O_RDONLY | O_NOFOLLOW | O_NOATIME);
+        if (fd == -1 && errno == EPERM)
+                fd = openat (dirfd, path, O_RDONLY | O_NOFOLLOW);
+
+        return fd;
+}
+
+
+static void
+posix_scrub_verify (xlator_t *this, struct posix_scrub *scrub, int dirfd,
+                    const char *name, uuid_t gfid)
+{
+        struct posix_scrub_sign sign   = {0, };
+        uint8_t                 sum[GF_CHECKSUM_LENGTH];
+        struct iatt             before = {0, };
+        struct iatt             after  = {0, };
+        ssize_t                 size   = 0;
+        int                     fd     = -1;
+
+        fd = posix_scrub_open (dirfd, name);
+        if (fd == -1)
+                return;
+
+        if (posix_scrub_fstat (fd, &before) == -1 ||
+            !IA_ISREG (before.ia_type))
+                goto out;
+
+        scrub->pass_files++;
+
+        /* already reported, waiting for self-heal */
+        if (sys_fgetxattr (fd, GF_SCRUB_BAD_KEY, NULL, 0) >= 0) {
+                posix_scrub_set_bad (scrub, gfid, _gf_true);
+                goto out;
+        }
+
+        size = sys_fgetxattr (fd, GF_SCRUB_SIGN_KEY, &sign, sizeof (sign));
+        if (size != sizeof (sign) ||
+            sign.version != POSIX_SCRUB_SIGN_VERSION ||
+            sign.type != GF_CHECKSUM_MURMUR3 ||
+            sign.chunk != POSIX_SCRUB_CHUNK) {
+                posix_scrub_sign_fd (this, scrub, fd, gfid);
+                goto out;
+        }
+
+        /* changed without going through the brick */
+        if (sign.size != before.ia_size || sign.mtime != before.ia_mtime ||
+            sign.mtime_nsec != before.ia_mtime_nsec) {
+                scrub->stale++;
+                posix_scrub_sign_fd (this, scrub, fd, gfid);
+                goto out;
+        }
+
+        if (posix_scrub_checksum (this, scrub, fd, sum))
+                goto out;
+
+        if (posix_scrub_fstat (fd, &after) == -1 ||
+            !posix_scrub_same (&before, &after))
+                goto out;
+
+        if (memcmp (sum, sign.sum, sizeof (sum)) == 0)
+                scrub->verified++;
+        else
+                posix_scrub_mismatch (this, scrub, fd, gfid);
+
+out:
+        close (fd);
+}
+
+
+static void
+posix_scrub_sign_gfid (xlator_t *this, struct posix_scrub *scrub,
+                       uuid_t gfid)
+{
+        char *path = NULL;
+        int   fd   = -1;
+
+        MAKE_HANDLE_PATH (path, this, gfid, NULL);
+        if (!path)
+                return;
+
+        fd = posix_scrub_open (AT_FDCWD, path);
+        if (fd == -1)
+                return;
+
+        posix_scrub_sign_fd (this, scrub, fd, gfid);
+        close (fd);
+}
+
+
+static void
+posix_scrub_sign_queued (xlator_t *this, struct posix_scrub *scrub)
+{
+        struct posix_scrub_gfid *entry = NULL;
+
+        for (;;) {
+                entry = NULL;
+                pthread_mutex_lock (&scrub->lock);
+                {
+                        if (!scrub->fini && !list_empty (&scrub->queue)) {
+                                entry = list_entry (scrub->queue.next,
+                                                    struct posix_scrub_gfid,
+                                                    list);
+                                list_del (&entry->list);
+                                scrub->queued--;
+                        }
+                }
+                pthread_mutex_unlock (&scrub->lock);
+
+                if (!entry)
+                        break;
+
+                posix_scrub_sign_gfid (this, scrub, entry->gfid);
+                GF_FREE (entry);
+        }
+}
+
+
+static void
+posix_scrub_dir (xlator_t *this, struct posix_scrub *scrub, int index)
+{
+        struct posix_private *priv  = NULL;
+        char                  path[PATH_MAX];
+        DIR                  *dir   = NULL;
+        struct dirent        *entry = NULL;
+        uuid_t                gfid  = {0, };
+
+        priv = this->private;
+
+        snprintf (path, sizeof (path), "%s/%s/%02x/%02x", priv->base_path,
+                  GF_HIDDEN_PATH, index >> 8, index & 0xff);
+
+        dir = opendir (path);
+        if (!dir)
+                return;
+
+        while (!scrub->fini && (entry = readdir (dir))) {
+                if (strlen (entry->d_name) != 36 ||
+                    uuid_parse (entry->d_name, gfid))
+                        continue;
+
+                posix_scrub_verify (this, scrub, dirfd (dir), entry->d_name,
+                                    gfid);
+
+                if (scrub->queued)
+                        posix_scrub_sign_queued (this, scrub);
+        }
+
+        closedir (dir);
+}
+
+
+static void
+posix_scrub_pass (xlator_t *this, struct posix_scrub *scrub)
+{
+        gf_log (this->name, GF_LOG_INFO, "scrub pass %"PRIu64" starting",
+                scrub->passes + 1);
+
+        pthread_mutex_lock (&scrub->lock);
+        {
+                scrub->pass_running = _gf_true;
+                scrub->pass_dir = 0;
+                scrub->pass_start = time (NULL);
+                scrub->pass_files = 0;
+                scrub->pass_bytes = 0;
+        }
+        pthread_mutex_unlock (&scrub->lock);
+
+        for (; scrub->pass_dir < POSIX_SCRUB_DIRS; scrub->pass_dir++) {
+                posix_scrub_dir (this, scrub, scrub->pass_dir);
+                if (scrub->fini)
+                        return;
+        }
+
+        pthread_mutex_lock (&scrub->lock);
+        {
+                scrub->pass_running = _gf_false;
+                scrub->last_pass_end = time (NULL);
+                scrub->passes++;
+        }
+        pthread_mutex_unlock (&scrub->lock);
+
+        gf_log (this->name, GF_LOG_INFO, "scrub pass %"PRIu64" done: %"
+                PRIu64" files, %"PRIu64" bytes in %ld seconds, %"PRIu64
+                " mismatches so far", scrub->passes, scrub->pass_files,
+                scrub->pass_bytes,
+                (long) (scrub->last_pass_end - scrub->pass_start),
+                scrub->mismatches);
+}
+
+
+static void *
+posix_scrubber (void *data)
+{
+        xlator_t             *this     = NULL;
+        struct posix_private *priv     = NULL;
+        struct posix_scrub   *scrub    = NULL;
+        struct timespec       deadline = {0, };
+        gf_boolean_t          fini     = _gf_false;
+        gf_boolean_t          pass     = _gf_false;
+
+        this = data;
+        priv = this->private;
+        scrub = priv->scrub;
+
+        THIS = this;
+
+        for (;;) {
+                pthread_mutex_lock (&scrub->lock);
+                {
+                        /* the first pass starts with the brick */
+                        for (;;) {
+                                deadline.tv_sec = scrub->last_pass_end +
+                                        scrub->interval;
+                                pass = (!scrub->passes ||
+                                        time (NULL) >= deadline.tv_sec);
+                                if (scrub->fini || scrub->queued || pass)
+                                        break;
+                                pthread_cond_timedwait (&scrub->cond,
+                                                        &scrub->lock,
+                                                        &deadline);
+                        }
+                        fini = scrub->fini;
+                }
+                pthread_mutex_unlock (&scrub->lock);
+
+                if (fini)
+                        break;
+
+                posix_scrub_sign_queued (this, scrub);
+                if (pass)
+                        posix_scrub_pass (this, scrub);
+        }
+
+        return NULL;
+}
+
+
+static void
+posix_scrub_free (struct posix_scrub *scrub)
+{
+        struct posix_scrub_gfid *entry = NULL;
+        struct posix_scrub_gfid *tmp   = NULL;
+
+        list_for_each_entry_safe (entry, tmp, &scrub->queue, list) {
+                list_del (&entry->list);
+                GF_FREE (entry);
+        }
+        list_for_each_entry_safe (entry, tmp, &scrub->bad, list) {
+                list_del (&entry->list);
+                GF_FREE (entry);
+        }
+
+        pthread_mutex_destroy (&scrub->lock);
+        pthread_cond_destroy (&scrub->cond);
+
+        GF_FREE (scrub->buf);
+        GF_FREE (scrub);
+}
+
+
+int
+posix_scrub_init (xlator_t *this, gf_boolean_t enable, uint32_t max_rate,
+                  uint32_t idle_msec, uint32_t interval)
+{
+        struct posix_private *priv  = NULL;
+        struct posix_scrub   *scrub = NULL;
+        int                   ret   = -1;
+
+        priv = this->private;
+
+        if (!enable)
+                return 0;
+
+        scrub = GF_CALLOC (1, sizeof (*scrub), gf_posix_mt_scrub);
+        if (!scrub)
+                goto out;
+
+        pthread_mutex_init (&scrub->lock, NULL);
+        pthread_cond_init (&scrub->cond, NULL);
+        INIT_LIST_HEAD (&scrub->queue);
+        INIT_LIST_HEAD (&scrub->bad);
+        scrub->max_rate = max_rate;
+        scrub->idle_msec = idle_msec;
+        scrub->interval = interval;
+        gettimeofday (&scrub->rate_start, NULL);
+
+        scrub->buf = GF_MALLOC (POSIX_SCRUB_CHUNK, gf_posix_mt_char);
+        if (!scrub->buf)
+                goto out;
+
+        priv->scrub = scrub;
+
+        ret = pthread_create (&scrub->thread, NULL, posix_scrubber, this);
+        if (ret != 0) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "spawning scrubber failed: %s", strerror (ret));
+                priv->scrub = NULL;
+                ret = -1;
+                goto out;
+        }
+        scrub->thread_present = _gf_true;
+        scrub = NULL;
+out:
+        if (scrub)
+                posix_scrub_free (scrub);
+
+        return ret;
+}
+
+
+void
+posix_scrub_fini (xlator_t *this)
+{
+        struct posix_private *priv  = NULL;
+        struct posix_scrub   *scrub = NULL;
+
+        priv = this->private;
+        scrub = priv->scrub;
+        if (!scrub)
+                return;
+
+        pthread_mutex_lock (&scrub->lock);
+        {
+                scrub->fini = _gf_true;
+                pthread_cond_signal (&scrub->cond);
+        }
+        pthread_mutex_unlock (&scrub->lock);
+
+        if (scrub->thread_present)
+                pthread_join (scrub->thread, NULL);
+
+        priv->scrub = NULL;
+        posix_scrub_free (scrub);
+}
+
+
+void
+posix_scrub_reconf (xlator_t *this, uint32_t max_rate, uint32_t idle_msec,
+                    uint32_t interval)
+{
+        struct posix_private *priv  = NULL;
+        struct posix_scrub   *scrub = NULL;
+
+        priv = this->private;
+        scrub = priv->scrub;
+        if (!scrub)
+                return;
+
+        pthread_mutex_lock (&scrub->lock);
+        {
+                scrub->max_rate = max_rate;
+                scrub->idle_msec = idle_msec;
+                scrub->interval = interval;
+                pthread_cond_signal (&scrub->cond);
+        }
+        pthread_mutex_unlock (&scrub->lock);
+}
+
+
+/* a read of a file marked bad fails instead of returning corrupted data */
+int
+posix_scrub_read (xlator_t *this, fd_t *fd)
+{
+        struct posix_private *priv  = NULL;
+        struct posix_scrub   *scrub = NULL;
+        int                   ret   = 0;
+
+        priv = this->private;
+        scrub = priv->scrub;
+
+        scrub->io_stamp++;
+
+        if (!scrub->nbad || !fd->inode)
+                return 0;
+
+        pthread_mutex_lock (&scrub->lock);
+        {
+                if (__posix_scrub_find_bad (scrub, fd->inode->gfid))
+                        ret = -1;
+        }
+        pthread_mutex_unlock (&scrub->lock);
+
+        return ret;
+}
+
+
+/* the checksum goes before the data changes, and comes back at release */
+void
+posix_scrub_write (xlator_t *this, struct posix_fd *pfd)
+{
+        struct posix_private *priv  = NULL;
+
+        priv = this->private;
+
+        priv->scrub->io_stamp++;
+
+        if (pfd->scrub_dirty)
+                return;
+
+        pfd->scrub_dirty = 1;
+        sys_fremovexattr (pfd->fd, GF_SCRUB_SIGN_KEY);
+}
+
+
+void
+posix_scrub_release (xlator_t *this, fd_t *fd, struct posix_fd *pfd)
+{
+        struct posix_private *priv  = NULL;
+
+        priv = this->private;
+
+        if (!pfd->scrub_dirty || !fd->inode || uuid_is_null (fd->inode->gfid))
+                return;
+
+        posix_scrub_queue (priv->scrub, fd->inode->gfid);
+}
+
+
+void
+posix_scrub_truncate (xlator_t *this, uuid_t gfid, const char *real_path)
+{
+        struct posix_private *priv  = NULL;
+
+        priv = this->private;
+
+        sys_lremovexattr (real_path, GF_SCRUB_SIGN_KEY);
+        if (gfid && !uuid_is_null (gfid))
+                posix_scrub_queue (priv->scrub, gfid);
+}
+
+
+void
+posix_scrub_dump (xlator_t *this)
+{
+        struct posix_private *priv  = NULL;
+        struct posix_scrub   *scrub = NULL;
+
+        priv = this->private;
+        scrub = priv->scrub;
+        if (!scrub)
+                return;
+
+        pthread_mutex_lock (&scrub->lock);
+        {
+                gf_proc_dump_write ("scrub.max_rate", "%u MB/s",
+                                    scrub->max_rate);
+                gf_proc_dump_write ("scrub.idle_msec", "%u",
+                                    scrub->idle_msec);
+                gf_proc_dump_write ("scrub.interval", "%u",
+                                    scrub->interval);
+                gf_proc_dump_write ("scrub.pass_running", "%d",
+                                    scrub->pass_running);
+                if (scrub->pass_running) {
+                        gf_proc_dump_write ("scrub.pass_progress", "%d%%",
+                                            scrub->pass_dir * 100 /
+                                            POSIX_SCRUB_DIRS);
+                        gf_proc_dump_write ("scrub.pass_start", "%ld",
+                                            (long) scrub->pass_start);
+                }
+                gf_proc_dump_write ("scrub.pass_files", "%"PRIu64,
+                                    scrub->pass_files);
+                gf_proc_dump_write ("scrub.pass_bytes", "%"PRIu64,
+                                    scrub->pass_bytes);
+                gf_proc_dump_write ("scrub.last_pass_end", "%ld",
+                                    (long) scrub->last_pass_end);
+                gf_proc_dump_write ("scrub.passes", "%"PRIu64,
+                                    scrub->passes);
+                gf_proc_dump_write ("scrub.queued", "%d", scrub->queued);
+                gf_proc_dump_write ("scrub.signed", "%"PRIu64,
+                                    scrub->signed_files);
+                gf_proc_dump_write ("scrub.verified", "%"PRIu64,
+                                    scrub->verified);
+                gf_proc_dump_write ("scrub.stale", "%"PRIu64,
+                                    scrub->stale);
+                gf_proc_dump_write ("scrub.mismatches", "%"PRIu64,
+                                    scrub->mismatches);
+                gf_proc_dump_write ("scrub.bad", "%d", scrub->nbad);
+                gf_proc_dump_write ("scrub.throttled_usec", "%"PRIu64,
+                                    scrub->throttled_usec);
+        }
+        pthread_mutex_unlock (&scrub->lock);
+}
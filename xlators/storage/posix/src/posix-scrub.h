@@ -0,0 +1,108 @@
+/*
+   Copyright (c) 2012 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+#ifndef _POSIX_SCRUB_H
+#define _POSIX_SCRUB_H
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include <pthread.h>
+
+#include "xlator.h"
+#include "glusterfs.h"
+#include "checksum.h"
+
+/* Files are read and checksummed this much at a time */
+#define POSIX_SCRUB_CHUNK (1 * GF_UNIT_MB)
+
+/* Handle directories .glusterfs/xx/yy crawled by a pass */
+#define POSIX_SCRUB_DIRS 65536
+
+/* Files queued for signing after writes, beyond that the pass signs them */
+#define POSIX_SCRUB_QUEUE_MAX 65536
+
+#define POSIX_SCRUB_SIGN_VERSION 1
+
+struct posix_fd;
+
+/* value of GF_SCRUB_SIGN_KEY: the checksum of the file, and what the file
+   looked like when it was taken. A file whose size or mtime differ was
+   changed by something the brick did not see, and is signed again. */
+struct posix_scrub_sign {
+        uint32_t  version;
+        uint32_t  type;         /* GF_CHECKSUM_* of the chunks */
+        uint32_t  chunk;
+        uint64_t  size;
+        int64_t   mtime;
+        int64_t   mtime_nsec;
+        uint8_t   sum[GF_CHECKSUM_LENGTH];
+} __attribute__ ((packed));
+
+/* a file to sign after writes, or found corrupted */
+struct posix_scrub_gfid {
+        struct list_head  list;
+        uuid_t            gfid;
+};
+
+struct posix_scrub {
+        pthread_mutex_t   lock;
+        pthread_cond_t    cond;
+        pthread_t         thread;
+        gf_boolean_t      thread_present;
+        gf_boolean_t      fini;
+
+        struct list_head  queue;        /* to sign */
+        int               queued;
+        struct list_head  bad;          /* reads fail with EIO */
+        int               nbad;
+
+        /* bumped by client reads and writes, without the lock: the
+           scrubber only reads while it stays put for idle_msec */
+        uint64_t          io_stamp;
+        uint64_t          io_seen;
+
+        uint32_t          max_rate;     /* MB/s, 0 for no cap */
+        uint32_t          idle_msec;
+        uint32_t          interval;     /* seconds between passes */
+
+        struct timeval    rate_start;
+        uint64_t          rate_bytes;
+        char             *buf;
+
+        /* progress of the pass under way, and totals */
+        gf_boolean_t      pass_running;
+        int               pass_dir;
+        time_t            pass_start;
+        time_t            last_pass_end;
+        uint64_t          pass_files;
+        uint64_t          pass_bytes;
+        uint64_t          passes;
+        uint64_t          signed_files;
+        uint64_t          verified;
+        uint64_t          stale;
+        uint64_t          mismatches;
+        uint64_t          throttled_usec;
+};
+
+int posix_scrub_init (xlator_t *this, gf_boolean_t enable, uint32_t max_rate,
+                      uint32_t idle_msec, uint32_t interval);
+void posix_scrub_fini (xlator_t *this);
+void posix_scrub_reconf (xlator_t *this, uint32_t max_rate,
+                         uint32_t idle_msec, uint32_t interval);
+int posix_scrub_read (xlator_t *this, fd_t *fd);
+void posix_scrub_write (xlator_t *this, struct posix_fd *pfd);
+void posix_scrub_release (xlator_t *this, fd_t *fd, struct posix_fd *pfd);
+void posix_scrub_truncate (xlator_t *this, uuid_t gfid,
+                           const char *real_path);
+void posix_scrub_dump (xlator_t *this);
+
+#endif /* !_POSIX_SCRUB_H */
@@ -0,0 +1,1224 @@
+/*
+   Copyright (c) 2012 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include "xlator.h"
+#include "glusterfs.h"
+#include "posix.h"
+#include "posix-aio.h"
+#include "statedump.h"
+#include <sys/uio.h>
+#include <sys/sysmacros.h>
+#include <sched.h>
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+
+/*
+ * io_uring engine.
+ *
+ * Fops queue a request and return.  The first thread to queue into an
+ * empty queue becomes the submitter: it turns everything queued meanwhile
+ * into sqes and submits them with a single io_uring_enter, until the queue
+ * is found empty.  Only the submitter touches the submission ring and the
+ * table of fixed buffers.  posix_uring_thread reaps the completion ring in
+ * batches, under uring_lock since a submitter short of room in the ring
+ * reaps too.  Unlike the Linux AIO engine, buffered I/O is asynchronous
+ * too.
+ */
+
+struct posix_uring_req {
+        struct list_head  list;
+        call_frame_t     *frame;
+        int               op;
+        int               fd;
+        fd_t             *fdobj;     /* open */
+        int               flags;     /* open */
+        char             *path;      /* open */
+        off_t             offset;
+        size_t            size;
+        struct iovec     *vector;    /* writev */
+        int               count;     /* writev */
+        struct iobuf     *iobuf;     /* readv */
+        struct iobref    *iobref;    /* writev */
+        int               buf_index; /* registered arena of iobuf, or -1 */
+        struct io_uring_sqe *sqe;    /* until submitted */
+        int               datasync;  /* fsync */
+        struct iatt       prebuf;
+        struct statx      stx;       /* fstat */
+};
+
+
+static int
+posix_uring_fixed_index (struct posix_private *priv, struct iobuf *iobuf)
+{
+        int i = 0;
+
+        for (i = 0; i < priv->uring_nr_fixed; i++) {
+                if (priv->uring_fixed[i] == iobuf->iobuf_arena)
+                        return i;
+        }
+
+        return -1;
+}
+
+
+static void
+posix_uring_prep (struct posix_private *priv, struct posix_uring_req *req,
+                  struct io_uring_sqe *sqe)
+{
+        switch (req->op) {
+        case GF_FOP_READ:
+                if (priv->uring_nr_fixed)
+                        req->buf_index = posix_uring_fixed_index (priv,
+                                                                  req->iobuf);
+                if (req->buf_index != -1)
+                        io_uring_prep_read_fixed (sqe, req->fd,
+                                                  iobuf_ptr (req->iobuf),
+                                                  req->size, req->offset,
+                                                  req->buf_index);
+                else
+                        io_uring_prep_read (sqe, req->fd,
+                                            iobuf_ptr (req->iobuf),
+                                            req->size, req->offset);
+                break;
+        case GF_FOP_WRITE:
+                io_uring_prep_writev (sqe, req->fd, req->vector, req->count,
+                                      req->offset);
+                break;
+        case GF_FOP_FSYNC:
+                io_uring_prep_fsync (sqe, req->fd,
+                                     req->datasync ? IORING_FSYNC_DATASYNC : 0);
+                break;
+        case GF_FOP_FSTAT:
+                io_uring_prep_statx (sqe, req->fd, "", AT_EMPTY_PATH,
+                                     STATX_BASIC_STATS, &req->stx);
+                break;
+        case GF_FOP_OPEN:
+                io_uring_prep_openat (sqe, AT_FDCWD, req->path, req->flags, 0);
+                break;
+        }
+
+        io_uring_sqe_set_data (sqe, req);
+        req->sqe = sqe;
+}
+
+
+static void
+posix_uring_statx_to_iatt (xlator_t *this, int fd, struct statx *stx,
+                           struct iatt *iatt)
+{
+        struct stat stbuf = {0, };
+
+        stbuf.st_dev = makedev (stx->stx_dev_major, stx->stx_dev_minor);
+        stbuf.st_ino = stx->stx_ino;
+        stbuf.st_mode = stx->stx_mode;
+        stbuf.st_nlink = stx->stx_nlink;
+        stbuf.st_uid = stx->stx_uid;
+        stbuf.st_gid = stx->stx_gid;
+        stbuf.st_rdev = makedev (stx->stx_rdev_major, stx->stx_rdev_minor);
+        stbuf.st_size = stx->stx_size;
+        stbuf.st_blksize = stx->stx_blksize;
+        stbuf.st_blocks = stx->stx_blocks;
+        stbuf.st_atim.tv_sec = stx->stx_atime.tv_sec;
+        stbuf.st_atim.tv_nsec = stx->stx_atime.tv_nsec;
+        stbuf.st_mtim.tv_sec = stx->stx_mtime.tv_sec;
+        stbuf.st_mtim.tv_nsec = stx->stx_mtime.tv_nsec;
+        stbuf.st_ctim.tv_sec = stx->stx_ctime.tv_sec;
+        stbuf.st_ctim.tv_nsec = stx->stx_ctime.tv_nsec;
+
+        if (stbuf.st_nlink && !S_ISDIR (stbuf.st_mode))
+                stbuf.st_nlink--;
+
+        iatt_from_stat (iatt, &stbuf);
+
+        if (posix_fill_gfid_fd (this, fd, iatt))
+                gf_log (this->name, GF_LOG_DEBUG, "failed to get gfid");
+
+        posix_fill_ino_from_gfid (this, iatt);
+}
+
+
+static void
+posix_uring_readv_complete (xlator_t *this, struct posix_uring_req *req,
+                            int res)
+{
+        struct posix_private *priv     = NULL;
+        struct iatt           postbuf  = {0,};
+        struct iovec          iov      = {0,};
+        struct iobref        *iobref   = NULL;
+        int                   op_ret   = -1;
+        int                   op_errno = 0;
+
+        priv = this->private;
+
+        if (res < 0) {
+                op_errno = -res;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "readv(uring) failed fd=%d,size=%lu,offset=%llu (%s)",
+                        req->fd, (unsigned long) req->size,
+                        (unsigned long long) req->offset, strerror (op_errno));
+                goto out;
+        }
+
+        if (posix_fdstat (this, req->fd, &postbuf) != 0) {
+                op_errno = errno;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "fstat failed on fd=%d: %s", req->fd,
+                        strerror (op_errno));
+                goto out;
+        }
+
+        iobref = iobref_new ();
+        if (!iobref) {
+                op_errno = ENOMEM;
+                goto out;
+        }
+
+        iobref_add (iobref, req->iobuf);
+
+        op_ret = res;
+        iov.iov_base = iobuf_ptr (req->iobuf);
+        iov.iov_len = op_ret;
+
+        /* Hack to notify higher layers of EOF. */
+        if (postbuf.ia_size == 0)
+                op_errno = ENOENT;
+        else if ((req->offset + iov.iov_len) == postbuf.ia_size)
+                op_errno = ENOENT;
+        else if (req->offset > postbuf.ia_size)
+                op_errno = ENOENT;
+
+        LOCK (&priv->lock);
+        {
+                priv->read_value += op_ret;
+        }
+        UNLOCK (&priv->lock);
+
+out:
+        STACK_UNWIND_STRICT (readv, req->frame, op_ret, op_errno, &iov, 1,
+                             &postbuf, iobref, NULL);
+        if (iobref)
+                iobref_unref (iobref);
+}
+
+
+static void
+posix_uring_writev_complete (xlator_t *this, struct posix_uring_req *req,
+                             int res)
+{
+        struct posix_private *priv     = NULL;
+        struct iatt           postbuf  = {0,};
+        int                   op_ret   = -1;
+        int                   op_errno = 0;
+
+        priv = this->private;
+
+        if (res < 0) {
+                op_errno = -res;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "writev(uring) failed fd=%d,offset=%llu (%s)",
+                        req->fd, (unsigned long long) req->offset,
+                        strerror (op_errno));
+                goto out;
+        }
+
+        if (posix_fdstat (this, req->fd, &postbuf) != 0) {
+                op_errno = errno;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "fstat failed on fd=%d: %s", req->fd,
+                        strerror (op_errno));
+                goto out;
+        }
+
+        op_ret = res;
+
+        LOCK (&priv->lock);
+        {
+                priv->write_value += op_ret;
+        }
+        UNLOCK (&priv->lock);
+
+out:
+        STACK_UNWIND_STRICT (writev, req->frame, op_ret, op_errno,
+                             &req->prebuf, &postbuf, NULL);
+}
+
+
+static void
+posix_uring_fsync_complete (xlator_t *this, struct posix_uring_req *req,
+                            int res)
+{
+        struct iatt postbuf  = {0,};
+        int         op_ret   = -1;
+        int         op_errno = 0;
+
+        if (res < 0) {
+                op_errno = -res;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "%s(uring) on fd=%d failed: %s",
+                        req->datasync ? "fdatasync" : "fsync", req->fd,
+                        strerror (op_errno));
+                goto out;
+        }
+
+        if (posix_fdstat (this, req->fd, &postbuf) != 0) {
+                op_errno = errno;
+                gf_log (this->name, GF_LOG_WARNING,
+                        "post-operation fstat failed on fd=%d: %s", req->fd,
+                        strerror (op_errno));
+                goto out;
+        }
+
+        op_ret = 0;
+out:
+        STACK_UNWIND_STRICT (fsync, req->frame, op_ret, op_errno,
+                             &req->prebuf, &postbuf, NULL);
+}
+
+
+static void
+posix_uring_fstat_complete (xlator_t *this, struct posix_uring_req *req,
+                            int res)
+{
+        struct iatt buf      = {0,};
+        int         op_ret   = -1;
+        int         op_errno = 0;
+
+        if (res < 0) {
+                op_errno = -res;
+                gf_log (this->name, GF_LOG_ERROR, "fstat failed on fd=%d: %s",
+                        req->fd, strerror (op_errno));
+                goto out;
+        }
+
+        posix_uring_statx_to_iatt (this, req->fd, &req->stx, &buf);
+        op_ret = 0;
+out:
+        STACK_UNWIND_STRICT (fstat, req->frame, op_ret, op_errno, &buf, NULL);
+}
+
+
+static void
+posix_uring_open_complete (xlator_t *this, struct posix_uring_req *req,
+                           int res)
+{
+        struct posix_private *priv     = NULL;
+        struct posix_fd      *pfd      = NULL;
+        int                   op_ret   = -1;
+        int                   op_errno = 0;
+
+        priv = this->private;
+
+        if (res < 0) {
+                op_errno = -res;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "open on %s: %s", req->path, strerror (op_errno));
+                goto out;
+        }
+
+        pfd = GF_CALLOC (1, sizeof (*pfd), gf_posix_mt_posix_fd);
+        if (!pfd) {
+                op_errno = ENOMEM;
+                close (res);
+                goto out;
+        }
+
+        pfd->flags = req->flags;
+        pfd->fd    = res;
+
+        if (priv->scrub && (req->flags & O_TRUNC))
+                posix_scrub_write (this, pfd);
+
+        if (fd_ctx_set (req->fdobj, this, (uint64_t)(long)pfd)) {
+                op_errno = ENOMEM;
+                gf_log (this->name, GF_LOG_WARNING,
+                        "failed to set the fd context path=%s fd=%p",
+                        req->path, req->fdobj);
+                close (res);
+                GF_FREE (pfd);
+                goto out;
+        }
+
+        LOCK (&priv->lock);
+        {
+                priv->nr_files++;
+        }
+        UNLOCK (&priv->lock);
+
+        op_ret = 0;
+out:
+        STACK_UNWIND_STRICT (open, req->frame, op_ret, op_errno, req->fdobj,
+                             NULL);
+}
+
+
+static void
+posix_uring_complete (xlator_t *this, struct posix_uring_req *req, int res)
+{
+        switch (req->op) {
+        case GF_FOP_READ:
+                posix_uring_readv_complete (this, req, res);
+                break;
+        case GF_FOP_WRITE:
+                posix_uring_writev_complete (this, req, res);
+                break;
+        case GF_FOP_FSYNC:
+                posix_uring_fsync_complete (this, req, res);
+                break;
+        case GF_FOP_FSTAT:
+                posix_uring_fstat_complete (this, req, res);
+                break;
+        case GF_FOP_OPEN:
+                posix_uring_open_complete (this, req, res);
+                break;
+        default:
+                gf_log (this->name, GF_LOG_ERROR,
+                        "unknown op %d found in uring request", req->op);
+                break;
+        }
+
+        if (req->iobuf)
+                iobuf_unref (req->iobuf);
+        if (req->iobref)
+                iobref_unref (req->iobref);
+        GF_FREE (req->vector);
+        GF_FREE (req->path);
+        GF_FREE (req);
+}
+
+
+/* reaps up to POSIX_URING_MAX_REAP completions, without waiting. The
+   requests are unwound after uring_lock is dropped. */
+static int
+posix_uring_reap (xlator_t *this)
+{
+        struct posix_private   *priv  = NULL;
+        struct io_uring_cqe    *cqes[POSIX_URING_MAX_REAP];
+        struct posix_uring_req *reqs[POSIX_URING_MAX_REAP];
+        int                     res[POSIX_URING_MAX_REAP];
+        int                     count = 0;
+        int                     i     = 0;
+
+        priv = this->private;
+
+        LOCK (&priv->uring_lock);
+        {
+                count = io_uring_peek_batch_cqe (&priv->ring, cqes,
+                                                 POSIX_URING_MAX_REAP);
+                for (i = 0; i < count; i++) {
+                        reqs[i] = io_uring_cqe_get_data (cqes[i]);
+                        res[i] = cqes[i]->res;
+                }
+
+                io_uring_cq_advance (&priv->ring, count);
+
+                if (count) {
+                        priv->uring_reaps++;
+                        priv->uring_reaped += count;
+                }
+        }
+        UNLOCK (&priv->uring_lock);
+
+        /* requests of a failed submit were turned into nops */
+        for (i = 0; i < count; i++) {
+                if (reqs[i])
+                        posix_uring_complete (this, reqs[i], res[i]);
+        }
+
+        return count;
+}
+
+
+static int
+posix_uring_submit (xlator_t *this)
+{
+        struct posix_private *priv = NULL;
+        int                   ret  = 0;
+
+        priv = this->private;
+
+        for (;;) {
+                ret = io_uring_submit (&priv->ring);
+                if (ret == -EINTR)
+                        continue;
+                if (ret != -EAGAIN && ret != -EBUSY)
+                        break;
+
+                /* the completion ring is full: make room, or let the
+                   reaper thread do it */
+                if (!posix_uring_reap (this))
+                        sched_yield ();
+        }
+
+        if (ret < 0) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "io_uring_submit() returned %d", ret);
+                return ret;
+        }
+
+        LOCK (&priv->uring_lock);
+        {
+                priv->uring_submits++;
+                priv->uring_submitted += ret;
+        }
+        UNLOCK (&priv->uring_lock);
+
+        return ret;
+}
+
+
+/* the sqes of @prepped were not taken by the kernel. They stay in the
+   ring and go with the next submit, as nops which complete nothing. */
+static void
+posix_uring_fail (xlator_t *this, struct list_head *prepped, int error)
+{
+        struct posix_uring_req *req = NULL;
+        struct posix_uring_req *tmp = NULL;
+
+        list_for_each_entry_safe (req, tmp, prepped, list) {
+                list_del_init (&req->list);
+
+                io_uring_prep_nop (req->sqe);
+                io_uring_sqe_set_data (req->sqe, NULL);
+
+                posix_uring_complete (this, req, error);
+        }
+}
+
+
+/* hands @prepped to the kernel. Once submitted, the requests belong to the
+   reaper, which may have freed them by the time this returns. */
+static void
+posix_uring_flush (xlator_t *this, struct list_head *prepped)
+{
+        int ret = 0;
+
+        if (list_empty (prepped))
+                return;
+
+        ret = posix_uring_submit (this);
+        if (ret < 0) {
+                posix_uring_fail (this, prepped, ret);
+                return;
+        }
+
+        INIT_LIST_HEAD (prepped);
+}
+
+
+static void posix_uring_apply_fixed (xlator_t *this);
+
+/* run by the submitter until the queue is found empty */
+static void
+posix_uring_drain (xlator_t *this)
+{
+        struct posix_private   *priv  = NULL;
+        struct posix_uring_req *req   = NULL;
+        struct posix_uring_req *tmp   = NULL;
+        struct io_uring_sqe    *sqe   = NULL;
+        gf_boolean_t            fixed = _gf_false;
+        struct list_head        batch;
+        struct list_head        prepped;
+
+        priv = this->private;
+
+        INIT_LIST_HEAD (&batch);
+        INIT_LIST_HEAD (&prepped);
+
+        for (;;) {
+                LOCK (&priv->uring_lock);
+                {
+                        list_splice_init (&priv->uring_queue, &batch);
+                        fixed = priv->uring_fixed_changed;
+                        priv->uring_fixed_changed = _gf_false;
+                        if (list_empty (&batch) && !fixed)
+                                priv->uring_submitting = _gf_false;
+                }
+                UNLOCK (&priv->uring_lock);
+
+                if (fixed)
+                        posix_uring_apply_fixed (this);
+
+                if (list_empty (&batch)) {
+                        if (fixed)
+                                continue;
+                        break;
+                }
+
+                list_for_each_entry_safe (req, tmp, &batch, list) {
+                        list_del_init (&req->list);
+
+                        sqe = io_uring_get_sqe (&priv->ring);
+                        if (!sqe) {
+                                /* ring full, hand what we have to the
+                                   kernel and retry */
+                                posix_uring_flush (this, &prepped);
+                                sqe = io_uring_get_sqe (&priv->ring);
+                        }
+
+                        if (!sqe) {
+                                posix_uring_complete (this, req, -EAGAIN);
+                                continue;
+                        }
+
+                        posix_uring_prep (priv, req, sqe);
+                        list_add_tail (&req->list, &prepped);
+                }
+
+                posix_uring_flush (this, &prepped);
+        }
+}
+
+
+static void
+posix_uring_queue (xlator_t *this, struct posix_uring_req *req)
+{
+        struct posix_private *priv   = NULL;
+        gf_boolean_t          leader = _gf_false;
+
+        priv = this->private;
+
+        LOCK (&priv->uring_lock);
+        {
+                list_add_tail (&req->list, &priv->uring_queue);
+                if (!priv->uring_submitting) {
+                        priv->uring_submitting = _gf_true;
+                        leader = _gf_true;
+                }
+        }
+        UNLOCK (&priv->uring_lock);
+
+        if (leader)
+                posix_uring_drain (this);
+}
+
+
+static void *
+posix_uring_thread (void *data)
+{
+        xlator_t             *this = NULL;
+        struct posix_private *priv = NULL;
+        struct io_uring_cqe  *cqe  = NULL;
+        int                   ret  = 0;
+
+        this = data;
+        THIS = this;
+        priv = this->private;
+
+        for (;;) {
+                ret = io_uring_wait_cqe (&priv->ring, &cqe);
+                if (ret < 0) {
+                        if (ret == -EINTR || ret == -EAGAIN)
+                                continue;
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "io_uring_wait_cqe() returned %d", ret);
+                        break;
+                }
+
+                posix_uring_reap (this);
+        }
+
+        return NULL;
+}
+
+
+static struct posix_uring_req *
+posix_uring_req_new (call_frame_t *frame, int op, int fd)
+{
+        struct posix_uring_req *req = NULL;
+
+        req = GF_CALLOC (1, sizeof (*req), gf_posix_mt_uring_req);
+        if (!req)
+                return NULL;
+
+        INIT_LIST_HEAD (&req->list);
+        req->frame = frame;
+        req->op = op;
+        req->fd = fd;
+        req->buf_index = -1;
+
+        return req;
+}
+
+
+int
+posix_uring_readv (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                   size_t size, off_t offset, uint32_t flags, dict_t *xdata)
+{
+        struct posix_private   *priv     = NULL;
+        struct posix_fd        *pfd      = NULL;
+        struct posix_uring_req *req      = NULL;
+        struct iobuf           *iobuf    = NULL;
+        int32_t                 op_errno = EINVAL;
+        int                     ret      = -1;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        priv = this->private;
+
+        ret = posix_fd_ctx_get (fd, this, &pfd);
+        if (ret < 0) {
+                op_errno = -ret;
+                gf_log (this->name, GF_LOG_WARNING,
+                        "pfd is NULL from fd=%p", fd);
+                goto err;
+        }
+
+        if (!size) {
+                op_errno = EINVAL;
+                gf_log (this->name, GF_LOG_WARNING, "size=%"GF_PRI_SIZET, size);
+                goto err;
+        }
+
+        if (priv->scrub && posix_scrub_read (this, fd)) {
+                op_errno = EIO;
+                gf_log (this->name, GF_LOG_WARNING, "read of %s refused, "
+                        "it failed scrubbing", uuid_utoa (fd->inode->gfid));
+                goto err;
+        }
+
+        iobuf = iobuf_get2 (this->ctx->iobuf_pool, size);
+        if (!iobuf) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+
+        req = posix_uring_req_new (frame, GF_FOP_READ, pfd->fd);
+        if (!req) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+
+        req->iobuf = iobuf;
+        req->size = size;
+        req->offset = offset;
+
+        posix_uring_queue (this, req);
+
+        return 0;
+err:
+        STACK_UNWIND_STRICT (readv, frame, -1, op_errno, 0, 0, 0, 0, 0);
+        if (iobuf)
+                iobuf_unref (iobuf);
+
+        return 0;
+}
+
+
+int
+posix_uring_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                    struct iovec *iov, int count, off_t offset, uint32_t flags,
+                    struct iobref *iobref, dict_t *xdata)
+{
+        struct posix_private   *priv     = NULL;
+        struct posix_fd        *pfd      = NULL;
+        struct posix_uring_req *req      = NULL;
+        int32_t                 op_errno = EINVAL;
+        int                     ret      = -1;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        priv = this->private;
+
+        ret = posix_fd_ctx_get (fd, this, &pfd);
+        if (ret < 0) {
+                op_errno = -ret;
+                gf_log (this->name, GF_LOG_WARNING,
+                        "pfd is NULL from fd=%p", fd);
+                goto err;
+        }
+
+        req = posix_uring_req_new (frame, GF_FOP_WRITE, pfd->fd);
+        if (!req) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+
+        ret = posix_fdstat (this, pfd->fd, &req->prebuf);
+        if (ret != 0) {
+                op_errno = errno;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "fstat failed on fd=%p: %s", fd,
+                        strerror (op_errno));
+                goto err;
+        }
+
+        if (priv->scrub)
+                posix_scrub_write (this, pfd);
+
+        /* the caller may free @iov once we return, the request is
+           submitted later by whichever thread leads the batch */
+        req->vector = iov_dup (iov, count);
+        if (!req->vector) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+
+        req->count = count;
+        req->offset = offset;
+        req->iobref = iobref_ref (iobref);
+
+        posix_uring_queue (this, req);
+
+        return 0;
+err:
+        STACK_UNWIND_STRICT (writev, frame, -1, op_errno, 0, 0, 0);
+        GF_FREE (req);
+
+        return 0;
+}
+
+
+int
+posix_uring_fsync (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                   int32_t datasync, dict_t *xdata)
+{
+        struct posix_private   *priv     = NULL;
+        struct posix_fd        *pfd      = NULL;
+        struct posix_uring_req *req      = NULL;
+        int32_t                 op_errno = EINVAL;
+        int                     ret      = -1;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        /* group commit takes precedence, the batch is synced at once */
+        priv = this->private;
+        if (priv->batch_fsync_delay_usec)
+                return posix_fsync (frame, this, fd, datasync, xdata);
+
+        ret = posix_fd_ctx_get (fd, this, &pfd);
+        if (ret < 0) {
+                op_errno = -ret;
+                gf_log (this->name, GF_LOG_WARNING,
+                        "pfd not found in fd's ctx");
+                goto err;
+        }
+
+        req = posix_uring_req_new (frame, GF_FOP_FSYNC, pfd->fd);
+        if (!req) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+
+        ret = posix_fdstat (this, pfd->fd, &req->prebuf);
+        if (ret != 0) {
+                op_errno = errno;
+                gf_log (this->name, GF_LOG_WARNING,
+                        "pre-operation fstat failed on fd=%p: %s", fd,
+                        strerror (op_errno));
+                goto err;
+        }
+
+        req->datasync = datasync;
+
+        posix_uring_queue (this, req);
+
+        return 0;
+err:
+        STACK_UNWIND_STRICT (fsync, frame, -1, op_errno, 0, 0, 0);
+        GF_FREE (req);
+
+        return 0;
+}
+
+
+int
+posix_uring_fstat (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                   dict_t *xdata)
+{
+        struct posix_fd        *pfd      = NULL;
+        struct posix_uring_req *req      = NULL;
+        int32_t                 op_errno = EINVAL;
+        int                     ret      = -1;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        ret = posix_fd_ctx_get (fd, this, &pfd);
+        if (ret < 0) {
+                op_errno = -ret;
+                gf_log (this->name, GF_LOG_WARNING,
+                        "pfd is NULL, fd=%p", fd);
+                goto err;
+        }
+
+        req = posix_uring_req_new (frame, GF_FOP_FSTAT, pfd->fd);
+        if (!req) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+
+        posix_uring_queue (this, req);
+
+        return 0;
+err:
+        STACK_UNWIND_STRICT (fstat, frame, -1, op_errno, 0, NULL);
+
+        return 0;
+}
+
+
+int
+posix_uring_open (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                  int32_t flags, fd_t *fd, dict_t *xdata)
+{
+        struct posix_private   *priv      = NULL;
+        struct posix_uring_req *req       = NULL;
+        char                   *real_path = NULL;
+        struct iatt             stbuf     = {0, };
+        int32_t                 op_ret    = -1;
+        int32_t                 op_errno  = EINVAL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        priv = this->private;
+
+        /* the ring opens with the credentials of the brick; the permission
+           checks of other users need the synchronous open under their
+           fsuid/fsgid */
+        if (frame->root->uid != 0 || frame->root->gid != 0)
+                return posix_open (frame, this, loc, flags, fd, xdata);
+
+        MAKE_INODE_HANDLE (real_path, this, loc, &stbuf);
+        if (!real_path) {
+                op_errno = ESTALE;
+                goto err;
+        }
+
+        if (op_ret == -1 && errno == ENOENT) {
+                op_errno = ENOENT;
+                goto err;
+        }
+
+        if (priv->o_direct)
+                flags |= O_DIRECT;
+
+        req = posix_uring_req_new (frame, GF_FOP_OPEN, -1);
+        if (!req) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+
+        req->path = gf_strdup (real_path);
+        if (!req->path) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+
+        req->flags = flags;
+        req->fdobj = fd;
+
+        posix_uring_queue (this, req);
+
+        return 0;
+err:
+        STACK_UNWIND_STRICT (open, frame, -1, op_errno, fd, NULL);
+        if (req)
+                GF_FREE (req->path);
+        GF_FREE (req);
+
+        return 0;
+}
+
+
+static int
+posix_uring_pin_arena (struct iobuf_arena *iobuf_arena, void *data)
+{
+        struct posix_private *priv = data;
+
+        if (priv->uring_nr_fixed == POSIX_URING_MAX_FIXED)
+                return -1;
+
+        priv->uring_fixed[priv->uring_nr_fixed++] = iobuf_arena;
+
+        return 0;
+}
+
+
+static void
+posix_uring_unpin_arenas (struct posix_private *priv)
+{
+        struct iobuf_arena *arenas[POSIX_URING_MAX_FIXED];
+        int                 count = 0;
+        int                 i     = 0;
+
+        LOCK (&priv->uring_lock);
+        {
+                count = priv->uring_nr_fixed;
+                memcpy (arenas, priv->uring_fixed, count * sizeof (*arenas));
+                priv->uring_nr_fixed = 0;
+        }
+        UNLOCK (&priv->uring_lock);
+
+        for (i = 0; i < count; i++)
+                iobuf_arena_unpin (arenas[i]);
+}
+
+
+/* registers the arenas the iobuf pool has at this point as fixed buffers,
+   reads into their iobufs skip the page pinning of every request. Run by
+   the submitter only, which looks the arenas up when it preps reads. */
+static void
+posix_uring_register_arenas (xlator_t *this)
+{
+        struct posix_private *priv = NULL;
+        struct iovec          iovs[POSIX_URING_MAX_FIXED];
+        int                   ret  = 0;
+        int                   i    = 0;
+
+        priv = this->private;
+
+        iobuf_pool_pin_arenas (this->ctx->iobuf_pool, posix_uring_pin_arena,
+                               priv);
+        if (!priv->uring_nr_fixed)
+                return;
+
+        for (i = 0; i < priv->uring_nr_fixed; i++) {
+                iovs[i].iov_base = priv->uring_fixed[i]->mem_base;
+                iovs[i].iov_len = priv->uring_fixed[i]->arena_size;
+        }
+
+        ret = io_uring_register_buffers (&priv->ring, iovs,
+                                         priv->uring_nr_fixed);
+        if (ret < 0) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "registering %d iobuf arenas failed (%s), "
+                        "continuing without fixed buffers",
+                        priv->uring_nr_fixed, strerror (-ret));
+                posix_uring_unpin_arenas (priv);
+                return;
+        }
+
+        gf_log (this->name, GF_LOG_INFO,
+                "registered %d iobuf arenas as fixed buffers",
+                priv->uring_nr_fixed);
+}
+
+
+static void
+posix_uring_unregister_arenas (xlator_t *this)
+{
+        struct posix_private *priv = NULL;
+
+        priv = this->private;
+
+        if (!priv->uring_nr_fixed)
+                return;
+
+        /* reads in flight keep the kernel's reference to the table */
+        io_uring_unregister_buffers (&priv->ring);
+        posix_uring_unpin_arenas (priv);
+}
+
+
+static void
+posix_uring_apply_fixed (xlator_t *this)
+{
+        struct posix_private *priv = NULL;
+
+        priv = this->private;
+
+        if (priv->uring_fixed_buffers && !priv->uring_nr_fixed)
+                posix_uring_register_arenas (this);
+        else if (!priv->uring_fixed_buffers && priv->uring_nr_fixed)
+                posix_uring_unregister_arenas (this);
+}
+
+
+/* the fixed buffers change between two batches of the submitter, or right
+   away if there is none */
+static void
+posix_uring_update_fixed (xlator_t *this)
+{
+        struct posix_private *priv   = NULL;
+        gf_boolean_t          leader = _gf_false;
+
+        priv = this->private;
+
+        LOCK (&priv->uring_lock);
+        {
+                priv->uring_fixed_changed = _gf_true;
+                if (!priv->uring_submitting) {
+                        priv->uring_submitting = _gf_true;
+                        leader = _gf_true;
+                }
+        }
+        UNLOCK (&priv->uring_lock);
+
+        if (leader)
+                posix_uring_drain (this);
+}
+
+
+static void
+posix_uring_set_fops (xlator_t *this)
+{
+        this->fops->readv  = posix_uring_readv;
+        this->fops->writev = posix_uring_writev;
+        this->fops->fsync  = posix_uring_fsync;
+        this->fops->fstat  = posix_uring_fstat;
+        this->fops->open   = posix_uring_open;
+}
+
+
+static int
+posix_uring_init (xlator_t *this)
+{
+        struct posix_private *priv = NULL;
+        int                   ret  = 0;
+
+        priv = this->private;
+
+        LOCK_INIT (&priv->uring_lock);
+        INIT_LIST_HEAD (&priv->uring_queue);
+
+        ret = io_uring_queue_init (POSIX_URING_ENTRIES, &priv->ring, 0);
+        if (ret == -ENOSYS) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "io_uring not availble at run-time."
+                        " Continuing with synchronous IO");
+                ret = -1;
+                goto out;
+        }
+
+        if (ret < 0) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "io_uring_queue_init() failed: %s", strerror (-ret));
+                ret = -1;
+                goto out;
+        }
+
+        ret = pthread_create (&priv->uring_thread, NULL,
+                              posix_uring_thread, this);
+        if (ret != 0) {
+                io_uring_queue_exit (&priv->ring);
+                ret = -1;
+                goto out;
+        }
+out:
+        return ret;
+}
+
+
+int
+posix_uring_on (xlator_t *this)
+{
+        struct posix_private *priv = NULL;
+        int                   ret  = 0;
+
+        priv = this->private;
+
+        if (!priv->uring_init_done) {
+                ret = posix_uring_init (this);
+                if (ret == 0)
+                        priv->uring_capable = _gf_true;
+                else
+                        priv->uring_capable = _gf_false;
+                priv->uring_init_done = _gf_true;
+        }
+
+        if (!priv->uring_capable)
+                goto out;
+
+        posix_uring_update_fixed (this);
+
+        posix_uring_set_fops (this);
+out:
+        return ret;
+}
+
+
+int
+posix_uring_off (xlator_t *this)
+{
+        struct posix_private *priv = NULL;
+
+        priv = this->private;
+
+        this->fops->readv  = posix_readv;
+        this->fops->writev = posix_writev;
+        this->fops->fsync  = posix_fsync;
+        this->fops->fstat  = posix_fstat;
+        this->fops->open   = posix_open;
+
+        /* Linux AIO takes readv and writev back if it is on */
+        if (priv->aio_configured)
+                posix_aio_on (this);
+
+        return 0;
+}
+
+
+void
+posix_uring_dump (xlator_t *this)
+{
+        struct posix_private *priv = NULL;
+
+        priv = this->private;
+
+        if (!priv->uring_capable)
+                return;
+
+        LOCK (&priv->uring_lock);
+        {
+                gf_proc_dump_write ("uring.fixed_arenas", "%d",
+                                    priv->uring_nr_fixed);
+                gf_proc_dump_write ("uring.submits", "%"PRIu64,
+                                    priv->uring_submits);
+                gf_proc_dump_write ("uring.submitted", "%"PRIu64,
+                                    priv->uring_submitted);
+                gf_proc_dump_write ("uring.reaps", "%"PRIu64,
+                                    priv->uring_reaps);
+                gf_proc_dump_write ("uring.reaped", "%"PRIu64,
+                                    priv->uring_reaped);
+        }
+        UNLOCK (&priv->uring_lock);
+}
+
+
+#else
+
+
+int
+posix_uring_on (xlator_t *this)
+{
+        gf_log (this->name, GF_LOG_INFO,
+                "io_uring not availble at build-time."
+                " Continuing with synchronous IO");
+        return 0;
+}
+
+int
+posix_uring_off (xlator_t *this)
+{
+        return 0;
+}
+
+void
+posix_uring_dump (xlator_t *this)
+{
+        return;
+}
+
+#endif
@@ -0,0 +1,45 @@
+/*
+   Copyright (c) 2012 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+#ifndef _POSIX_URING_H
+#define _POSIX_URING_H
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include "xlator.h"
+#include "glusterfs.h"
+
+/* Number of submission queue entries of the ring. The completion queue
+   is twice as large, so completions seldom overflow it */
+#define POSIX_URING_ENTRIES 256
+
+/* Maximum number of completions to reap per wakeup of the reaper thread */
+#define POSIX_URING_MAX_REAP 32
+
+/* Maximum number of iobuf arenas registered as fixed buffers */
+#define POSIX_URING_MAX_FIXED 64
+
+
+int posix_uring_on (xlator_t *this);
+int posix_uring_off (xlator_t *this);
+void posix_uring_dump (xlator_t *this);
+
+int32_t posix_fsync (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                     int32_t datasync, dict_t *xdata);
+
+int32_t posix_fstat (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                     dict_t *xdata);
+
+int32_t posix_open (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                    int32_t flags, fd_t *fd, dict_t *xdata);
+
+#endif /* !_POSIX_URING_H */
@@ -0,0 +1,1184 @@
+/*
+   Copyright (c) 2012 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <alloca.h>
+
+#include "xlator.h"
+#include "glusterfs.h"
+#include "posix.h"
+#include "posix-handle.h"
+#include "posix-xattrop.h"
+#include "checksum.h"
+#include "compat-errno.h"
+#include "syscall.h"
+#include "statedump.h"
+
+/*
+ * xattrop cache.
+ *
+ * The values of the keys changed through xattrop (the AFR changelog, the
+ * marker and quota sizes) are kept in memory once read.  An xattrop applies
+ * the operation to the cached value and appends the new value to a journal
+ * in the handle directory instead of a getxattr and a setxattr round trip;
+ * concurrent xattrops share one journal write.  Records carry absolute
+ * values, so replaying a journal is idempotent and the last record of a key
+ * wins.
+ *
+ * A checkpoint, every flush interval or once the journal is large, starts a
+ * new journal, writes the dirty values back to their xattrs, syncs the
+ * filesystem and removes the old journal.  At start, leftover journals are
+ * replayed into the xattrs before the brick serves anything.
+ *
+ * Getxattr, fgetxattr and lookup return the cached values.  Setxattr and
+ * removexattr of a cached key write it back and journal a forget record
+ * first, so that a replay never overwrites what they did.
+ */
+
+
+static int
+__posix_xattrop_bucket (struct posix_xattrop_cache *cache, uuid_t gfid)
+{
+        /* gfids are random, their last bytes are as good as a hash */
+        return ((gfid[12] << 24) | (gfid[13] << 16) | (gfid[14] << 8) |
+                gfid[15]) % cache->nbuckets;
+}
+
+
+static struct posix_xattrop_entry *
+__posix_xattrop_find (struct posix_xattrop_bucket *bucket, uuid_t gfid,
+                      const char *key)
+{
+        struct posix_xattrop_entry *entry = NULL;
+
+        list_for_each_entry (entry, &bucket->entries, hash) {
+                if (uuid_compare (entry->gfid, gfid) == 0 &&
+                    strcmp (entry->key, key) == 0)
+                        return entry;
+        }
+
+        return NULL;
+}
+
+
+static void
+posix_xattrop_entry_free (struct posix_xattrop_entry *entry)
+{
+        list_del_init (&entry->hash);
+        GF_FREE (entry->key);
+        GF_FREE (entry->value);
+        GF_FREE (entry);
+}
+
+
+static struct posix_xattrop_entry *
+posix_xattrop_entry_new (uuid_t gfid, const char *key, char *value, int len)
+{
+        struct posix_xattrop_entry *entry = NULL;
+
+        entry = GF_CALLOC (1, sizeof (*entry), gf_posix_mt_xattrop_entry);
+        if (!entry)
+                return NULL;
+
+        INIT_LIST_HEAD (&entry->hash);
+        uuid_copy (entry->gfid, gfid);
+        entry->key = gf_strdup (key);
+        entry->value = GF_CALLOC (1, len ? len : 1, gf_posix_mt_char);
+        if (!entry->key || !entry->value) {
+                posix_xattrop_entry_free (entry);
+                return NULL;
+        }
+
+        if (value)
+                memcpy (entry->value, value, len);
+        entry->len = len;
+
+        return entry;
+}
+
+
+/* write @value to the backend xattr of @gfid, through the handle */
+static int
+posix_xattrop_writeback (xlator_t *this, uuid_t gfid, const char *key,
+                         char *value, int len)
+{
+        char *path = NULL;
+
+        MAKE_HANDLE_PATH (path, this, gfid, NULL);
+        if (!path) {
+                errno = ENOENT;
+                return -1;
+        }
+
+        return sys_lsetxattr (path, key, value, len, 0);
+}
+
+
+/* Journal */
+
+static void
+__posix_xattrop_journal_write (xlator_t *this,
+                               struct posix_xattrop_cache *cache)
+{
+        char     *buf  = NULL;
+        size_t    len  = 0;
+        size_t    done = 0;
+        off_t     off  = 0;
+        uint64_t  upto = 0;
+        ssize_t   ret  = 0;
+        int       fd   = -1;
+
+        buf  = cache->jbuf;
+        len  = cache->jbuf_len;
+        upto = cache->jseq;
+        fd   = cache->jfd;
+        off  = cache->jsize;
+
+        cache->jbuf = NULL;
+        cache->jbuf_len = cache->jbuf_size = 0;
+        cache->jwriting = _gf_true;
+
+        pthread_mutex_unlock (&cache->jlock);
+        {
+                while (done < len) {
+                        ret = pwrite (fd, buf + done, len - done,
+                                      off + done);
+                        if (ret == -1 && errno == EINTR)
+                                continue;
+                        if (ret <= 0)
+                                break;
+                        done += ret;
+                }
+        }
+        pthread_mutex_lock (&cache->jlock);
+
+        if (done == len) {
+                cache->jsize += len;
+                cache->jseq_done = upto;
+                cache->jwrites++;
+                if (cache->jsize >= POSIX_XATTROP_JOURNAL_MAX)
+                        pthread_cond_signal (&cache->fcond);
+        } else {
+                cache->jerrno = (ret == -1) ? errno : ENOSPC;
+                gf_log (this->name, GF_LOG_ERROR, "writing the xattrop "
+                        "journal %s failed (%s), writing xattrops through "
+                        "until the next checkpoint", cache->jpath,
+                        strerror (cache->jerrno));
+                /* a torn record would hide the ones appended after it */
+                if (ftruncate (fd, off) == -1)
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "truncating %s failed: %s", cache->jpath,
+                                strerror (errno));
+        }
+
+        cache->jwriting = _gf_false;
+        pthread_cond_broadcast (&cache->jcond);
+
+        GF_FREE (buf);
+}
+
+
+/* queue a record, called under the lock of the bucket of @gfid so that the
+   records of a key are in the order of its updates */
+static int
+__posix_xattrop_journal_add (struct posix_xattrop_cache *cache, int type,
+                             uuid_t gfid, const char *key, char *value,
+                             int len, uint64_t *seq, uint64_t *gen)
+{
+        struct posix_xattrop_rec *rec     = NULL;
+        char                     *buf     = NULL;
+        size_t                    keylen  = 0;
+        size_t                    reclen  = 0;
+        size_t                    size    = 0;
+        int                       ret     = -1;
+
+        keylen = strlen (key) + 1;
+        reclen = sizeof (*rec) + keylen + len;
+
+        pthread_mutex_lock (&cache->jlock);
+        {
+                if (cache->jerrno) {
+                        errno = cache->jerrno;
+                        goto unlock;
+                }
+
+                if (cache->jbuf_len + reclen > cache->jbuf_size) {
+                        size = max (cache->jbuf_size * 2,
+                                    cache->jbuf_len + reclen);
+                        if (cache->jbuf)
+                                buf = GF_REALLOC (cache->jbuf, size);
+                        else
+                                buf = GF_MALLOC (size, gf_posix_mt_char);
+                        if (!buf) {
+                                errno = ENOMEM;
+                                goto unlock;
+                        }
+                        cache->jbuf = buf;
+                        cache->jbuf_size = size;
+                }
+
+                rec = (struct posix_xattrop_rec *)(cache->jbuf +
+                                                   cache->jbuf_len);
+                rec->magic  = POSIX_XATTROP_REC_MAGIC;
+                memcpy (rec->gfid, gfid, sizeof (rec->gfid));
+                rec->type   = type;
+                rec->keylen = keylen;
+                rec->len    = len;
+                memcpy ((char *)(rec + 1), key, keylen);
+                if (len)
+                        memcpy ((char *)(rec + 1) + keylen, value, len);
+                rec->csum = gf_rsync_weak_checksum ((unsigned char *)rec +
+                                                    2 * sizeof (uint32_t),
+                                                    reclen -
+                                                    2 * sizeof (uint32_t));
+
+                cache->jbuf_len += reclen;
+                cache->jrecords++;
+                *seq = ++cache->jseq;
+                if (gen)
+                        *gen = cache->jgen;
+                ret = 0;
+        }
+unlock:
+        pthread_mutex_unlock (&cache->jlock);
+
+        return ret;
+}
+
+
+/* wait for record @seq to be written, writing the queued records when
+   nobody is */
+static int
+posix_xattrop_journal_wait (xlator_t *this, struct posix_xattrop_cache *cache,
+                            uint64_t seq)
+{
+        int ret = 0;
+
+        pthread_mutex_lock (&cache->jlock);
+        {
+                while (cache->jseq_done < seq && !cache->jerrno) {
+                        if (cache->jwriting)
+                                pthread_cond_wait (&cache->jcond,
+                                                   &cache->jlock);
+                        else
+                                __posix_xattrop_journal_write (this, cache);
+                }
+
+                if (cache->jseq_done < seq) {
+                        errno = cache->jerrno;
+                        ret = -1;
+                }
+        }
+        pthread_mutex_unlock (&cache->jlock);
+
+        return ret;
+}
+
+
+/* Replay */
+
+static int
+posix_xattrop_journal_replay (xlator_t *this,
+                              struct posix_xattrop_cache *cache,
+                              const char *path)
+{
+        struct posix_xattrop_rec    *rec    = NULL;
+        struct posix_xattrop_entry  *entry  = NULL;
+        struct posix_xattrop_bucket *bucket = NULL;
+        struct stat                  stbuf  = {0, };
+        char                        *buf    = NULL;
+        char                        *key    = NULL;
+        size_t                       off    = 0;
+        size_t                       reclen = 0;
+        ssize_t                      ret    = 0;
+        int                          count  = 0;
+        int                          fd     = -1;
+
+        fd = open (path, O_RDONLY);
+        if (fd == -1) {
+                if (errno == ENOENT)
+                        return 0;
+                gf_log (this->name, GF_LOG_ERROR, "opening %s failed: %s",
+                        path, strerror (errno));
+                return -1;
+        }
+
+        if (fstat (fd, &stbuf) == -1 || !stbuf.st_size)
+                goto out;
+
+        buf = GF_MALLOC (stbuf.st_size, gf_posix_mt_char);
+        if (!buf) {
+                count = -1;
+                goto out;
+        }
+
+        ret = pread (fd, buf, stbuf.st_size, 0);
+        if (ret != stbuf.st_size) {
+                gf_log (this->name, GF_LOG_ERROR, "reading %s failed: %s",
+                        path, (ret == -1) ? strerror (errno) : "short read");
+                count = -1;
+                goto out;
+        }
+
+        while (off + sizeof (*rec) <= stbuf.st_size) {
+                rec = (struct posix_xattrop_rec *)(buf + off);
+                reclen = sizeof (*rec) + rec->keylen + rec->len;
+                if (rec->magic != POSIX_XATTROP_REC_MAGIC || !rec->keylen ||
+                    off + reclen > stbuf.st_size)
+                        break;
+                if (rec->csum !=
+                    gf_rsync_weak_checksum ((unsigned char *)rec +
+                                            2 * sizeof (uint32_t),
+                                            reclen - 2 * sizeof (uint32_t)))
+                        break;
+
+                key = (char *)(rec + 1);
+                if (key[rec->keylen - 1] != '\0')
+                        break;
+
+                bucket = &cache->buckets[__posix_xattrop_bucket (cache,
+                                                                 rec->gfid)];
+                entry = __posix_xattrop_find (bucket, rec->gfid, key);
+                if (entry)
+                        posix_xattrop_entry_free (entry);
+
+                if (rec->type == POSIX_XATTROP_REC_SET) {
+                        entry = posix_xattrop_entry_new (rec->gfid, key,
+                                                         key + rec->keylen,
+                                                         rec->len);
+                        if (!entry) {
+                                count = -1;
+                                goto out;
+                        }
+                        entry->dirty = _gf_true;
+                        list_add (&entry->hash, &bucket->entries);
+                }
+
+                off += reclen;
+                count++;
+        }
+
+        if (off != stbuf.st_size)
+                gf_log (this->name, GF_LOG_WARNING, "%s: ignoring %"PRIu64
+                        " bytes of torn records at its end", path,
+                        (uint64_t)(stbuf.st_size - off));
+out:
+        if (count > 0)
+                gf_log (this->name, GF_LOG_INFO, "replayed %d xattrop "
+                        "records from %s", count, path);
+        GF_FREE (buf);
+        close (fd);
+
+        return count;
+}
+
+
+/* Checkpoint */
+
+/* write the dirty values back; those which cannot be are journaled again
+   in the current journal */
+static int
+posix_xattrop_writeback_all (xlator_t *this,
+                             struct posix_xattrop_cache *cache, uint64_t *seq)
+{
+        struct posix_xattrop_bucket *bucket = NULL;
+        struct posix_xattrop_entry  *entry  = NULL;
+        int                          failed = 0;
+        int                          i      = 0;
+
+        for (i = 0; i < cache->nbuckets; i++) {
+                bucket = &cache->buckets[i];
+
+                pthread_mutex_lock (&bucket->lock);
+                list_for_each_entry (entry, &bucket->entries, hash) {
+                        if (!entry->dirty)
+                                continue;
+
+                        if (posix_xattrop_writeback (this, entry->gfid,
+                                                     entry->key, entry->value,
+                                                     entry->len) == 0 ||
+                            errno == ENOENT) {
+                                /* a file gone meanwhile has nothing left
+                                   to write back to */
+                                entry->dirty = _gf_false;
+                                continue;
+                        }
+
+                        gf_log (this->name, GF_LOG_WARNING, "writing back %s "
+                                "of %s failed: %s", entry->key,
+                                uuid_utoa (entry->gfid), strerror (errno));
+                        if (__posix_xattrop_journal_add (cache,
+                                                         POSIX_XATTROP_REC_SET,
+                                                         entry->gfid,
+                                                         entry->key,
+                                                         entry->value,
+                                                         entry->len, seq,
+                                                         &entry->jgen))
+                                failed++;
+                }
+                pthread_mutex_unlock (&bucket->lock);
+        }
+
+        return failed ? -1 : 0;
+}
+
+
+/* drop clean values beyond the cache limit, only those whose records were
+   all in journals before @gen, which are gone: nothing can replay them */
+static void
+posix_xattrop_prune (struct posix_xattrop_cache *cache, uint64_t gen)
+{
+        struct posix_xattrop_bucket *bucket = NULL;
+        struct posix_xattrop_entry  *entry  = NULL;
+        struct posix_xattrop_entry  *tmp    = NULL;
+        int                          count  = 0;
+        int                          i      = 0;
+
+        for (i = 0; i < cache->nbuckets; i++) {
+                bucket = &cache->buckets[i];
+
+                pthread_mutex_lock (&bucket->lock);
+                list_for_each_entry_safe (entry, tmp, &bucket->entries,
+                                          hash) {
+                        if (!entry->dirty && entry->jgen < gen &&
+                            count >= POSIX_XATTROP_MAX_ENTRIES) {
+                                posix_xattrop_entry_free (entry);
+                                continue;
+                        }
+                        count++;
+                }
+                pthread_mutex_unlock (&bucket->lock);
+        }
+
+        pthread_mutex_lock (&cache->jlock);
+        {
+                cache->count = count;
+        }
+        pthread_mutex_unlock (&cache->jlock);
+}
+
+
+static void
+posix_xattrop_sync (xlator_t *this, int fd)
+{
+#ifdef HAVE_SYNCFS
+        if (fd != -1 && syncfs (fd) == 0)
+                return;
+#endif
+        sync ();
+}
+
+
+static void
+posix_xattrop_checkpoint (xlator_t *this, struct posix_xattrop_cache *cache,
+                          gf_boolean_t final)
+{
+        uint64_t  gen    = 0;
+        uint64_t  seq    = 0;
+        int       oldfd  = -1;
+        int       newfd  = -1;
+        int       error  = ESHUTDOWN;
+        int       ret    = 0;
+
+        pthread_mutex_lock (&cache->ckpt_lock);
+
+        /* the old journal of a checkpoint which could not write every
+           value back still covers those: write them back again, and
+           leave both journals be until that succeeds, as a rename would
+           drop its records */
+        if (cache->jold_kept) {
+                ret = posix_xattrop_writeback_all (this, cache, &seq);
+                if (seq && posix_xattrop_journal_wait (this, cache,
+                                                       seq) == -1)
+                        ret = -1;
+                if (ret) {
+                        gf_log (this->name, GF_LOG_WARNING, "writing back "
+                                "xattrops failed again, keeping %s",
+                                cache->jpath_old);
+                        goto unlock;
+                }
+
+                posix_xattrop_sync (this, cache->jfd);
+                if (unlink (cache->jpath_old) == -1 && errno != ENOENT) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "removing %s failed: %s", cache->jpath_old,
+                                strerror (errno));
+                        goto unlock;
+                }
+                cache->jold_kept = _gf_false;
+                seq = 0;
+        }
+
+        /* switch to a new journal, the old one goes once the values it
+           holds are written back */
+        pthread_mutex_lock (&cache->jlock);
+        {
+                while (cache->jwriting || cache->jbuf_len) {
+                        if (cache->jwriting)
+                                pthread_cond_wait (&cache->jcond,
+                                                   &cache->jlock);
+                        else if (cache->jerrno)
+                                break;
+                        else
+                                __posix_xattrop_journal_write (this, cache);
+                }
+
+                if (rename (cache->jpath, cache->jpath_old) == -1 &&
+                    errno != ENOENT)
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "renaming %s failed: %s", cache->jpath,
+                                strerror (errno));
+
+                if (!final) {
+                        newfd = open (cache->jpath,
+                                      O_CREAT | O_TRUNC | O_WRONLY, 0600);
+                        if (newfd == -1) {
+                                error = errno;
+                                gf_log (this->name, GF_LOG_ERROR,
+                                        "creating %s failed: %s, writing "
+                                        "xattrops through", cache->jpath,
+                                        strerror (error));
+                        }
+                }
+
+                oldfd = cache->jfd;
+                gen = cache->jgen++;
+
+                cache->jfd = newfd;
+                cache->jsize = 0;
+                GF_FREE (cache->jbuf);
+                cache->jbuf = NULL;
+                cache->jbuf_len = cache->jbuf_size = 0;
+                cache->jseq_done = cache->jseq;
+                cache->jerrno = (newfd == -1) ? error : 0;
+                cache->checkpoints++;
+                pthread_cond_broadcast (&cache->jcond);
+        }
+        pthread_mutex_unlock (&cache->jlock);
+
+        ret = posix_xattrop_writeback_all (this, cache, &seq);
+        if (seq && posix_xattrop_journal_wait (this, cache, seq) == -1)
+                ret = -1;
+
+        posix_xattrop_sync (this, oldfd);
+        if (oldfd != -1)
+                close (oldfd);
+
+        /* values which could not be written back nor journaled again
+           stay covered by the old journal */
+        if (ret == 0) {
+                if (unlink (cache->jpath_old) == -1 && errno != ENOENT) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "removing %s failed: %s", cache->jpath_old,
+                                strerror (errno));
+                        cache->jold_kept = _gf_true;
+                } else {
+                        posix_xattrop_prune (cache, gen + 1);
+                }
+        } else {
+                cache->jold_kept = _gf_true;
+        }
+
+unlock:
+        pthread_mutex_unlock (&cache->ckpt_lock);
+}
+
+
+static void *
+posix_xattrop_flusher (void *data)
+{
+        xlator_t                   *this     = NULL;
+        struct posix_private       *priv     = NULL;
+        struct posix_xattrop_cache *cache    = NULL;
+        struct timeval              now      = {0, };
+        struct timespec             deadline = {0, };
+        gf_boolean_t                fini     = _gf_false;
+
+        this = data;
+        priv = this->private;
+        cache = priv->xattrop_cache;
+
+        THIS = this;
+
+        for (;;) {
+                pthread_mutex_lock (&cache->jlock);
+                {
+                        gettimeofday (&now, NULL);
+                        deadline.tv_sec = now.tv_sec + cache->interval;
+                        deadline.tv_nsec = now.tv_usec * 1000;
+
+                        while (!cache->fini &&
+                               cache->jsize < POSIX_XATTROP_JOURNAL_MAX) {
+                                if (pthread_cond_timedwait (&cache->fcond,
+                                                            &cache->jlock,
+                                                            &deadline)
+                                    == ETIMEDOUT)
+                                        break;
+                        }
+                        fini = cache->fini;
+                }
+                pthread_mutex_unlock (&cache->jlock);
+
+                if (fini)
+                        break;
+
+                posix_xattrop_checkpoint (this, cache, _gf_false);
+        }
+
+        return NULL;
+}
+
+
+static void
+posix_xattrop_cache_free (struct posix_xattrop_cache *cache)
+{
+        struct posix_xattrop_entry *entry = NULL;
+        struct posix_xattrop_entry *tmp   = NULL;
+        int                         i     = 0;
+
+        if (cache->buckets) {
+                for (i = 0; i < cache->nbuckets; i++) {
+                        list_for_each_entry_safe (entry, tmp,
+                                                  &cache->buckets[i].entries,
+                                                  hash)
+                                posix_xattrop_entry_free (entry);
+                        pthread_mutex_destroy (&cache->buckets[i].lock);
+                }
+                GF_FREE (cache->buckets);
+        }
+
+        pthread_mutex_destroy (&cache->jlock);
+        pthread_cond_destroy (&cache->jcond);
+        pthread_mutex_destroy (&cache->ckpt_lock);
+        pthread_cond_destroy (&cache->fcond);
+
+        GF_FREE (cache->jbuf);
+        GF_FREE (cache->jpath);
+        GF_FREE (cache->jpath_old);
+        GF_FREE (cache);
+}
+
+
+int
+posix_xattrop_cache_init (xlator_t *this, gf_boolean_t enable,
+                          uint32_t interval)
+{
+        struct posix_private       *priv     = NULL;
+        struct posix_xattrop_cache *cache    = NULL;
+        uint64_t                    seq      = 0;
+        int                         replayed = 0;
+        int                         ret      = -1;
+        int                         dirfd    = -1;
+        int                         i        = 0;
+
+        priv = this->private;
+
+        cache = GF_CALLOC (1, sizeof (*cache), gf_posix_mt_xattrop_cache);
+        if (!cache)
+                goto out;
+
+        pthread_mutex_init (&cache->jlock, NULL);
+        pthread_cond_init (&cache->jcond, NULL);
+        pthread_mutex_init (&cache->ckpt_lock, NULL);
+        pthread_cond_init (&cache->fcond, NULL);
+        cache->jfd = -1;
+        cache->interval = interval;
+
+        cache->nbuckets = POSIX_XATTROP_BUCKETS;
+        cache->buckets = GF_CALLOC (cache->nbuckets, sizeof (*cache->buckets),
+                                    gf_posix_mt_xattrop_cache);
+        if (!cache->buckets)
+                goto out;
+
+        for (i = 0; i < cache->nbuckets; i++) {
+                pthread_mutex_init (&cache->buckets[i].lock, NULL);
+                INIT_LIST_HEAD (&cache->buckets[i].entries);
+        }
+
+        if (gf_asprintf (&cache->jpath, "%s/%s/%s", priv->base_path,
+                         GF_HIDDEN_PATH, POSIX_XATTROP_JOURNAL) == -1 ||
+            gf_asprintf (&cache->jpath_old, "%s/%s/%s", priv->base_path,
+                         GF_HIDDEN_PATH, POSIX_XATTROP_JOURNAL_OLD) == -1)
+                goto out;
+
+        /* whatever a crash left in the journals goes to the xattrs before
+           anything is served, the older journal first */
+        ret = posix_xattrop_journal_replay (this, cache, cache->jpath_old);
+        if (ret >= 0) {
+                replayed += ret;
+                ret = posix_xattrop_journal_replay (this, cache,
+                                                    cache->jpath);
+        }
+        if (ret < 0) {
+                gf_log (this->name, GF_LOG_ERROR, "replaying the xattrop "
+                        "journals failed, keeping them for the next start");
+                ret = -1;
+                goto out;
+        }
+        replayed += ret;
+
+        if (replayed) {
+                /* no journal to journal failures into: keep the old ones */
+                cache->jerrno = ESHUTDOWN;
+                ret = posix_xattrop_writeback_all (this, cache, &seq);
+                if (ret) {
+                        gf_log (this->name, GF_LOG_ERROR, "writing back the "
+                                "replayed xattrops failed, keeping the "
+                                "journals for the next start");
+                        goto out;
+                }
+                cache->jerrno = 0;
+
+                dirfd = open (priv->base_path, O_RDONLY | O_DIRECTORY);
+                posix_xattrop_sync (this, dirfd);
+                if (dirfd != -1)
+                        close (dirfd);
+        }
+
+        unlink (cache->jpath_old);
+        unlink (cache->jpath);
+
+        ret = 0;
+        if (!enable)
+                goto out;
+
+        cache->jgen = 1;
+        cache->jfd = open (cache->jpath, O_CREAT | O_TRUNC | O_WRONLY, 0600);
+        if (cache->jfd == -1) {
+                gf_log (this->name, GF_LOG_ERROR, "creating %s failed: %s",
+                        cache->jpath, strerror (errno));
+                ret = -1;
+                goto out;
+        }
+
+        priv->xattrop_cache = cache;
+
+        ret = pthread_create (&cache->flusher, NULL, posix_xattrop_flusher,
+                              this);
+        if (ret != 0) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "spawning xattrop flusher failed: %s",
+                        strerror (ret));
+                priv->xattrop_cache = NULL;
+                close (cache->jfd);
+                unlink (cache->jpath);
+                ret = -1;
+                goto out;
+        }
+        cache->flusher_present = _gf_true;
+        cache = NULL;
+out:
+        if (cache)
+                posix_xattrop_cache_free (cache);
+
+        return ret;
+}
+
+
+void
+posix_xattrop_cache_fini (xlator_t *this)
+{
+        struct posix_private       *priv  = NULL;
+        struct posix_xattrop_cache *cache = NULL;
+
+        priv = this->private;
+        cache = priv->xattrop_cache;
+        if (!cache)
+                return;
+
+        pthread_mutex_lock (&cache->jlock);
+        {
+                cache->fini = _gf_true;
+                pthread_cond_signal (&cache->fcond);
+        }
+        pthread_mutex_unlock (&cache->jlock);
+
+        if (cache->flusher_present)
+                pthread_join (cache->flusher, NULL);
+
+        /* everything goes back to the xattrs, no journal is left */
+        posix_xattrop_checkpoint (this, cache, _gf_true);
+
+        priv->xattrop_cache = NULL;
+        posix_xattrop_cache_free (cache);
+}
+
+
+void
+posix_xattrop_cache_set_interval (xlator_t *this, uint32_t interval)
+{
+        struct posix_private       *priv  = NULL;
+        struct posix_xattrop_cache *cache = NULL;
+
+        priv = this->private;
+        cache = priv->xattrop_cache;
+        if (!cache)
+                return;
+
+        pthread_mutex_lock (&cache->jlock);
+        {
+                cache->interval = interval;
+                pthread_cond_signal (&cache->fcond);
+        }
+        pthread_mutex_unlock (&cache->jlock);
+}
+
+
+/* the gfid the cache keys the xattrs of @loc on, the same the fd based
+   fops use: that of the inode, else the one of the loc. NULL when neither
+   is known, and the xattrs go to the backend uncached. */
+unsigned char *
+posix_xattrop_loc_gfid (loc_t *loc)
+{
+        if (!loc)
+                return NULL;
+
+        if (loc->inode && !uuid_is_null (loc->inode->gfid))
+                return loc->inode->gfid;
+
+        if (!uuid_is_null (loc->gfid))
+                return loc->gfid;
+
+        return NULL;
+}
+
+
+/* apply @optype with @data to the cached value of @key, reading it from
+   the backend the first time, and return the new value in @array */
+int
+posix_xattrop_cache_op (xlator_t *this, uuid_t gfid, const char *real_path,
+                        int fd, char *key, gf_xattrop_flags_t optype,
+                        char *data, int len, char *array)
+{
+        struct posix_private        *priv     = NULL;
+        struct posix_xattrop_cache  *cache    = NULL;
+        struct posix_xattrop_bucket *bucket   = NULL;
+        struct posix_xattrop_entry  *entry    = NULL;
+        char                        *value    = NULL;
+        char                        *path     = NULL;
+        ssize_t                      size     = 0;
+        uint64_t                     seq      = 0;
+        int                          journaled = 0;
+        gf_boolean_t                 through  = _gf_false;
+        int                          ret      = -1;
+
+        priv = this->private;
+        cache = priv->xattrop_cache;
+
+        bucket = &cache->buckets[__posix_xattrop_bucket (cache, gfid)];
+
+        pthread_mutex_lock (&bucket->lock);
+        {
+                entry = __posix_xattrop_find (bucket, gfid, key);
+                if (entry) {
+                        bucket->hits++;
+                } else {
+                        bucket->misses++;
+
+                        memset (array, 0, len);
+                        if (fd != -1)
+                                size = sys_fgetxattr (fd, key, array, len);
+                        else if (real_path)
+                                size = sys_lgetxattr (real_path, key, array,
+                                                      len);
+                        else {
+                                MAKE_HANDLE_PATH (path, this, gfid, NULL);
+                                size = sys_lgetxattr (path, key, array, len);
+                        }
+                        if (size == -1 && errno != ENODATA &&
+                            errno != ENOATTR) {
+                                gf_log (this->name, GF_LOG_ERROR,
+                                        "getxattr failed on %s while doing "
+                                        "xattrop: Key:%s (%s)",
+                                        uuid_utoa (gfid), key,
+                                        strerror (errno));
+                                goto unlock;
+                        }
+
+                        entry = posix_xattrop_entry_new (gfid, key, array,
+                                                         len);
+                        if (!entry) {
+                                errno = ENOMEM;
+                                goto unlock;
+                        }
+                        list_add (&entry->hash, &bucket->entries);
+                }
+
+                if (entry->len > len) {
+                        /* as the getxattr into a @len buffer would */
+                        gf_log (this->name, GF_LOG_ERROR, "xattrop of %s on "
+                                "%s: value of %d bytes, %d given", key,
+                                uuid_utoa (gfid), entry->len, len);
+                        errno = ERANGE;
+                        goto unlock;
+                }
+
+                if (entry->len < len) {
+                        value = GF_REALLOC (entry->value, len);
+                        if (!value) {
+                                errno = ENOMEM;
+                                goto unlock;
+                        }
+                        memset (value + entry->len, 0, len - entry->len);
+                        entry->value = value;
+                        entry->len = len;
+                }
+
+                memcpy (array, entry->value, len);
+                if (posix_xattrop_apply (optype, array, data, len) == -1) {
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "Unknown xattrop type (%d) on %s", optype,
+                                uuid_utoa (gfid));
+                        errno = EINVAL;
+                        goto unlock;
+                }
+                memcpy (entry->value, array, len);
+                entry->dirty = _gf_true;
+
+                journaled = !__posix_xattrop_journal_add (cache,
+                                                          POSIX_XATTROP_REC_SET,
+                                                          gfid, key, array,
+                                                          len, &seq,
+                                                          &entry->jgen);
+                if (!journaled) {
+                        /* no journal, the xattr itself has to be right */
+                        through = _gf_true;
+                        if (fd != -1)
+                                ret = sys_fsetxattr (fd, key, array, len, 0);
+                        else
+                                ret = posix_xattrop_writeback (this, gfid,
+                                                               key, array,
+                                                               len);
+                        goto unlock;
+                }
+
+                ret = 0;
+        }
+unlock:
+        pthread_mutex_unlock (&bucket->lock);
+
+        if (journaled && posix_xattrop_journal_wait (this, cache, seq) == -1) {
+                /* the journal broke under this batch, write through */
+                through = _gf_true;
+                if (fd != -1)
+                        ret = sys_fsetxattr (fd, key, array, len, 0);
+                else
+                        ret = posix_xattrop_writeback (this, gfid, key,
+                                                       array, len);
+        }
+
+        if (through && ret == -1)
+                gf_log (this->name, GF_LOG_ERROR, "setxattr failed on %s "
+                        "while doing xattrop: key=%s (%s)", uuid_utoa (gfid),
+                        key, strerror (errno));
+
+        return ret;
+}
+
+
+/* set the cached value of @key in @dict, returns its length, or 0 when it
+   is not cached */
+int
+posix_xattrop_cache_get (xlator_t *this, uuid_t gfid, const char *key,
+                         dict_t *dict)
+{
+        struct posix_private        *priv   = NULL;
+        struct posix_xattrop_cache  *cache  = NULL;
+        struct posix_xattrop_bucket *bucket = NULL;
+        struct posix_xattrop_entry  *entry  = NULL;
+        char                        *value  = NULL;
+        int                          len    = 0;
+
+        priv = this->private;
+        cache = priv->xattrop_cache;
+        if (!cache || !gfid || uuid_is_null (gfid))
+                return 0;
+
+        bucket = &cache->buckets[__posix_xattrop_bucket (cache, gfid)];
+
+        pthread_mutex_lock (&bucket->lock);
+        {
+                entry = __posix_xattrop_find (bucket, gfid, key);
+                if (entry) {
+                        value = GF_CALLOC (1, entry->len + 1,
+                                           gf_posix_mt_char);
+                        if (value) {
+                                memcpy (value, entry->value, entry->len);
+                                len = entry->len;
+                        }
+                }
+        }
+        pthread_mutex_unlock (&bucket->lock);
+
+        if (!value)
+                return 0;
+
+        if (dict_set_dynptr (dict, (char *)key, value, len) < 0) {
+                GF_FREE (value);
+                return 0;
+        }
+
+        return len;
+}
+
+
+/* set every cached value of @gfid in @dict, over what the backend had */
+void
+posix_xattrop_cache_fill (xlator_t *this, uuid_t gfid, dict_t *dict)
+{
+        struct posix_private        *priv   = NULL;
+        struct posix_xattrop_cache  *cache  = NULL;
+        struct posix_xattrop_bucket *bucket = NULL;
+        struct posix_xattrop_entry  *entry  = NULL;
+        char                        *value  = NULL;
+
+        priv = this->private;
+        cache = priv->xattrop_cache;
+        if (!cache || !gfid || uuid_is_null (gfid))
+                return;
+
+        bucket = &cache->buckets[__posix_xattrop_bucket (cache, gfid)];
+
+        pthread_mutex_lock (&bucket->lock);
+        {
+                list_for_each_entry (entry, &bucket->entries, hash) {
+                        if (uuid_compare (entry->gfid, gfid) != 0)
+                                continue;
+
+                        value = GF_CALLOC (1, entry->len + 1,
+                                           gf_posix_mt_char);
+                        if (!value)
+                                break;
+                        memcpy (value, entry->value, entry->len);
+                        if (dict_set_dynptr (dict, entry->key, value,
+                                             entry->len) < 0)
+                                GF_FREE (value);
+                }
+        }
+        pthread_mutex_unlock (&bucket->lock);
+}
+
+
+/* drop @key of @gfid before it is set or removed by other means: its
+   value goes to the backend, and a forget record keeps a replay from
+   bringing it back over the new one */
+int
+posix_xattrop_cache_forget (xlator_t *this, uuid_t gfid, const char *key)
+{
+        struct posix_private        *priv   = NULL;
+        struct posix_xattrop_cache  *cache  = NULL;
+        struct posix_xattrop_bucket *bucket = NULL;
+        struct posix_xattrop_entry  *entry  = NULL;
+        uint64_t                     seq    = 0;
+        int                          ret    = 0;
+
+        priv = this->private;
+        cache = priv->xattrop_cache;
+        if (!cache || !gfid || uuid_is_null (gfid))
+                return 0;
+
+        bucket = &cache->buckets[__posix_xattrop_bucket (cache, gfid)];
+
+        pthread_mutex_lock (&bucket->lock);
+        {
+                entry = __posix_xattrop_find (bucket, gfid, key);
+                if (!entry)
+                        goto unlock;
+
+                if (entry->dirty) {
+                        ret = posix_xattrop_writeback (this, gfid, key,
+                                                       entry->value,
+                                                       entry->len);
+                        if (ret == -1)
+                                goto unlock;
+                        entry->dirty = _gf_false;
+                }
+
+                /* without a journal nothing can be replayed over it */
+                __posix_xattrop_journal_add (cache, POSIX_XATTROP_REC_FORGET,
+                                             gfid, key, NULL, 0, &seq, NULL);
+
+                posix_xattrop_entry_free (entry);
+        }
+unlock:
+        pthread_mutex_unlock (&bucket->lock);
+
+        if (ret == -1) {
+                gf_log (this->name, GF_LOG_ERROR, "writing back %s of %s "
+                        "failed: %s", key, uuid_utoa (gfid), strerror (errno));
+                return -1;
+        }
+
+        if (seq && posix_xattrop_journal_wait (this, cache, seq) == -1) {
+                /* the value is on the backend, but a replay of the journal
+                   could bring an older one back */
+                gf_log (this->name, GF_LOG_ERROR, "journaling the forget of "
+                        "%s of %s failed: %s", key, uuid_utoa (gfid),
+                        strerror (errno));
+                return -1;
+        }
+
+        return 0;
+}
+
+
+void
+posix_xattrop_cache_dump (xlator_t *this)
+{
+        struct posix_private       *priv   = NULL;
+        struct posix_xattrop_cache *cache  = NULL;
+        uint64_t                    hits   = 0;
+        uint64_t                    misses = 0;
+        int                         i      = 0;
+
+        priv = this->private;
+        cache = priv->xattrop_cache;
+        if (!cache)
+                return;
+
+        for (i = 0; i < cache->nbuckets; i++) {
+                pthread_mutex_lock (&cache->buckets[i].lock);
+                {
+                        hits += cache->buckets[i].hits;
+                        misses += cache->buckets[i].misses;
+                }
+                pthread_mutex_unlock (&cache->buckets[i].lock);
+        }
+
+        gf_proc_dump_write ("xattrop_cache.hits", "%"PRIu64, hits);
+        gf_proc_dump_write ("xattrop_cache.misses", "%"PRIu64, misses);
+
+        pthread_mutex_lock (&cache->jlock);
+        {
+                gf_proc_dump_write ("xattrop_cache.count", "%d",
+                                    cache->count);
+                gf_proc_dump_write ("xattrop_cache.interval", "%u",
+                                    cache->interval);
+                gf_proc_dump_write ("xattrop_cache.checkpoints", "%"PRIu64,
+                                    cache->checkpoints);
+                gf_proc_dump_write ("xattrop_journal.size", "%"PRIu64,
+                                    (uint64_t) cache->jsize);
+                gf_proc_dump_write ("xattrop_journal.records", "%"PRIu64,
+                                    cache->jrecords);
+                gf_proc_dump_write ("xattrop_journal.writes", "%"PRIu64,
+                                    cache->jwrites);
+                gf_proc_dump_write ("xattrop_journal.errno", "%d",
+                                    cache->jerrno);
+        }
+        pthread_mutex_unlock (&cache->jlock);
+}
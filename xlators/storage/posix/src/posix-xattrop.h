@@ -0,0 +1,125 @@
+/*
+   Copyright (c) 2012 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+#ifndef _POSIX_XATTROP_H
+#define _POSIX_XATTROP_H
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include <pthread.h>
+
+#include "xlator.h"
+#include "glusterfs.h"
+
+/* Buckets of the gfid hash of cached xattrop values */
+#define POSIX_XATTROP_BUCKETS 4096
+
+/* Clean values kept in memory across checkpoints, beyond that they are
+   dropped and read back from the backend on their next xattrop */
+#define POSIX_XATTROP_MAX_ENTRIES 65536
+
+/* Journal size which triggers a checkpoint before the flush interval */
+#define POSIX_XATTROP_JOURNAL_MAX (16 * GF_UNIT_MB)
+
+/* Journal files, in the handle directory of the brick */
+#define POSIX_XATTROP_JOURNAL     "xattrop-journal"
+#define POSIX_XATTROP_JOURNAL_OLD "xattrop-journal.old"
+
+#define POSIX_XATTROP_REC_MAGIC   0x58415452  /* "XATR" */
+#define POSIX_XATTROP_REC_SET     1
+#define POSIX_XATTROP_REC_FORGET  2
+
+/* journal record, followed by the key with its NUL and the value */
+struct posix_xattrop_rec {
+        uint32_t  magic;
+        uint32_t  csum;         /* of the rest of the record */
+        uint8_t   gfid[16];
+        uint16_t  type;
+        uint16_t  keylen;
+        uint32_t  len;
+} __attribute__ ((packed));
+
+struct posix_xattrop_entry {
+        struct list_head  hash;
+        uuid_t            gfid;
+        char             *key;
+        char             *value;
+        int               len;
+        gf_boolean_t      dirty;  /* newer than the backend xattr */
+        uint64_t          jgen;   /* journal holding its last record */
+};
+
+/* a mutex rather than a spinlock: misses read the backend xattr, and
+   checkpoints write the dirty values back, under it */
+struct posix_xattrop_bucket {
+        pthread_mutex_t   lock;
+        struct list_head  entries;
+        uint64_t          hits;
+        uint64_t          misses;
+};
+
+struct posix_xattrop_cache {
+        struct posix_xattrop_bucket *buckets;
+        int                          nbuckets;
+        int                          count;        /* at last checkpoint */
+
+        /* journal; records are queued under the lock of their bucket and
+           written in batches by whichever waiter finds nobody writing */
+        pthread_mutex_t   jlock;
+        pthread_cond_t    jcond;
+        int               jfd;
+        char             *jpath;
+        char             *jpath_old;
+        uint64_t          jgen;
+        off_t             jsize;
+        char             *jbuf;
+        size_t            jbuf_len;
+        size_t            jbuf_size;
+        uint64_t          jseq;         /* last record queued */
+        uint64_t          jseq_done;    /* last record written */
+        gf_boolean_t      jwriting;
+        int               jerrno;       /* journal unusable, write through */
+        uint64_t          jwrites;
+        uint64_t          jrecords;
+
+        /* checkpoints write the dirty values back to the backend and drop
+           the journal which held them */
+        pthread_mutex_t   ckpt_lock;
+        pthread_cond_t    fcond;
+        pthread_t         flusher;
+        gf_boolean_t      flusher_present;
+        gf_boolean_t      jold_kept;    /* old journal left by a failure */
+        gf_boolean_t      fini;
+        uint32_t          interval;
+        uint64_t          checkpoints;
+};
+
+int posix_xattrop_cache_init (xlator_t *this, gf_boolean_t enable,
+                              uint32_t interval);
+void posix_xattrop_cache_fini (xlator_t *this);
+void posix_xattrop_cache_set_interval (xlator_t *this, uint32_t interval);
+int posix_xattrop_cache_op (xlator_t *this, uuid_t gfid,
+                            const char *real_path, int fd, char *key,
+                            gf_xattrop_flags_t optype, char *data, int len,
+                            char *array);
+int posix_xattrop_cache_get (xlator_t *this, uuid_t gfid, const char *key,
+                             dict_t *dict);
+void posix_xattrop_cache_fill (xlator_t *this, uuid_t gfid, dict_t *dict);
+int posix_xattrop_cache_forget (xlator_t *this, uuid_t gfid,
+                                const char *key);
+void posix_xattrop_cache_dump (xlator_t *this);
+unsigned char *posix_xattrop_loc_gfid (loc_t *loc);
+
+int posix_xattrop_apply (gf_xattrop_flags_t optype, char *array, char *data,
+                         int len);
+
+#endif /* !_POSIX_XATTROP_H */
@@ -76,6 +76,20 @@ extern char *marker_xattrs[];
 
 #endif
 
+/* linux/falloc.h, for the libcs that do not pull it in */
+#ifndef FALLOC_FL_KEEP_SIZE
+#define FALLOC_FL_KEEP_SIZE  0x01
+#endif
+#ifndef FALLOC_FL_PUNCH_HOLE
+#define FALLOC_FL_PUNCH_HOLE 0x02
+#endif
+#ifndef FALLOC_FL_ZERO_RANGE
+#define FALLOC_FL_ZERO_RANGE 0x10
+#endif
+
+/* Zeroes written at a time where FALLOC_FL_ZERO_RANGE is not supported */
+#define POSIX_ZEROFILL_CHUNK (128 * GF_UNIT_KB)
+
 int
 posix_forget (xlator_t *this, inode_t *inode)
 {
@@ -1056,6 +1070,11 @@ posix_unlink (call_frame_t *frame, xlator_t *this,
                 posix_handle_unset (this, stbuf.ia_gfid, NULL);
 
         priv = this->private;
+        /* a large file is moved aside and freed by the reclaimer */
+        if (priv->reclaim &&
+            posix_reclaim_defer (this, real_path, loc->inode, &stbuf) == 0)
+                goto unlinked;
+
         if (priv->background_unlink) {
                 if (IA_ISREG (loc->inode->ia_type)) {
                         fd = open (real_path, O_RDONLY);
@@ -1079,6 +1098,7 @@ posix_unlink (call_frame_t *frame, xlator_t *this,
                 goto out;
         }
 
+unlinked:
         op_ret = posix_pstat (this, loc->pargfid, par_path, &postparent);
         if (op_ret == -1) {
                 op_errno = errno;
@@ -1438,6 +1458,7 @@ posix_rename (call_frame_t *frame, xlator_t *this,
                 posix_handle_unset (this, victim, NULL);
 
         if (IA_ISDIR (oldloc->inode->ia_type)) {
+                posix_handle_cache_flush_paths (this);
                 posix_handle_soft (this, real_newpath, newloc,
                                    oldloc->inode->gfid, NULL);
         }
@@ -1613,6 +1634,9 @@ posix_truncate (call_frame_t *frame, xlator_t *this, loc_t *loc, off_t offset,
                 goto out;
         }
 
+        if (priv->scrub)
+                posix_scrub_truncate (this, loc->gfid, real_path);
+
         op_ret = truncate (real_path, offset);
         if (op_ret == -1) {
                 op_errno = errno;
@@ -1657,6 +1681,7 @@ posix_create (call_frame_t *frame, xlator_t *this,
         struct posix_fd *      pfd         = NULL;
         struct posix_private * priv        = NULL;
         char                   was_present = 1;
+        char                   tmpfile     = 0;
 
         gid_t                  gid         = 0;
         struct iatt            preparent = {0,};
@@ -1707,6 +1732,31 @@ posix_create (call_frame_t *frame, xlator_t *this,
         if (priv->o_direct)
                 _flags |= O_DIRECT;
 
+        if (priv->create_tmpfile && !was_present) {
+                _fd = posix_create_tmpfile (this, par_path, real_path, _flags,
+                                            mode, frame->root->uid, gid,
+                                            xdata);
+                if (_fd != -1) {
+                        tmpfile = 1;
+                        goto created;
+                }
+
+                if (errno == EEXIST) {
+                        op_errno = errno;
+                        op_ret = -1;
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "open on %s failed: %s", real_path,
+                                strerror (op_errno));
+                        goto out;
+                }
+
+                LOCK (&priv->lock);
+                {
+                        priv->tmpfile_fallbacks++;
+                }
+                UNLOCK (&priv->lock);
+        }
+
         _fd = open (real_path, _flags, mode);
 
         if (_fd == -1) {
@@ -1748,6 +1798,7 @@ posix_create (call_frame_t *frame, xlator_t *this,
                         strerror (errno));
         }
 
+created:
         op_ret = posix_fdstat (this, _fd, &stbuf);
         if (op_ret == -1) {
                 op_errno = errno;
@@ -1775,6 +1826,9 @@ posix_create (call_frame_t *frame, xlator_t *this,
         pfd->flags = flags;
         pfd->fd    = _fd;
 
+        if (priv->scrub && was_present && (flags & O_TRUNC))
+                posix_scrub_write (this, pfd);
+
         op_ret = fd_ctx_set (fd, this, (uint64_t)(long)pfd);
         if (op_ret)
                 gf_log (this->name, GF_LOG_WARNING,
@@ -1784,6 +1838,8 @@ posix_create (call_frame_t *frame, xlator_t *this,
         LOCK (&priv->lock);
         {
                 priv->nr_files++;
+                if (tmpfile)
+                        priv->tmpfile_creates++;
         }
         UNLOCK (&priv->lock);
 
@@ -1856,6 +1912,9 @@ posix_open (call_frame_t *frame, xlator_t *this,
         pfd->flags = flags;
         pfd->fd    = _fd;
 
+        if (priv->scrub && (flags & O_TRUNC))
+                posix_scrub_write (this, pfd);
+
         op_ret = fd_ctx_set (fd, this, (uint64_t)(long)pfd);
         if (op_ret)
                 gf_log (this->name, GF_LOG_WARNING,
@@ -1921,6 +1980,13 @@ posix_readv (call_frame_t *frame, xlator_t *this,
                 goto out;
         }
 
+        if (priv->scrub && posix_scrub_read (this, fd)) {
+                op_errno = EIO;
+                gf_log (this->name, GF_LOG_WARNING, "read of %s refused, "
+                        "it failed scrubbing", uuid_utoa (fd->inode->gfid));
+                goto out;
+        }
+
         iobuf = iobuf_get2 (this->ctx->iobuf_pool, size);
         if (!iobuf) {
                 op_errno = ENOMEM;
@@ -2111,6 +2177,9 @@ posix_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
                 goto out;
         }
 
+        if (priv->scrub)
+                posix_scrub_write (this, pfd);
+
         op_ret = __posix_writev (_fd, vector, count, offset,
                                  (pfd->flags & O_DIRECT));
         if (op_ret < 0) {
@@ -2167,6 +2236,7 @@ posix_statfs (call_frame_t *frame, xlator_t *this,
         int32_t                op_errno  = 0;
         struct statvfs         buf       = {0, };
         struct posix_private * priv      = NULL;
+        uint64_t               reclaim   = 0;
 
         VALIDATE_OR_GOTO (frame, out);
         VALIDATE_OR_GOTO (this, out);
@@ -2187,6 +2257,14 @@ posix_statfs (call_frame_t *frame, xlator_t *this,
                 goto out;
         }
 
+        /* space the reclaimer has yet to free is free already */
+        reclaim = posix_reclaim_pending (this) / (buf.f_frsize ?
+                                                  buf.f_frsize : 512);
+        if (reclaim) {
+                buf.f_bfree = min (buf.f_bfree + reclaim, buf.f_blocks);
+                buf.f_bavail = min (buf.f_bavail + reclaim, buf.f_blocks);
+        }
+
         if (!priv->export_statfs) {
                 buf.f_blocks = 0;
                 buf.f_bfree  = 0;
@@ -2261,6 +2339,9 @@ posix_release (xlator_t *this, fd_t *fd)
                         pfd->dir, fd);
         }
 
+        if (priv->scrub)
+                posix_scrub_release (this, fd, pfd);
+
         pthread_mutex_lock (&priv->janitor_lock);
         {
                 INIT_LIST_HEAD (&pfd->list);
@@ -2291,6 +2372,7 @@ posix_fsync (call_frame_t *frame, xlator_t *this,
         int               ret      = -1;
         struct iatt       preop = {0,};
         struct iatt       postop = {0,};
+        struct posix_private *priv = NULL;
 
         DECLARE_OLD_FS_ID_VAR;
 
@@ -2325,6 +2407,16 @@ posix_fsync (call_frame_t *frame, xlator_t *this,
                 goto out;
         }
 
+        priv = this->private;
+        if (priv->batch_fsync_delay_usec && priv->fsyncer_present) {
+                /* acknowledged by the fsyncer, once its batch is synced */
+                if (posix_fsync_queue (frame, this, fd, _fd, datasync,
+                                       &preop) == 0) {
+                        SET_TO_OLD_FS_ID ();
+                        return 0;
+                }
+        }
+
         if (datasync) {
                 ;
 #ifdef HAVE_FDATASYNC
@@ -2376,6 +2468,7 @@ posix_setxattr (call_frame_t *frame, xlator_t *this,
         int32_t       op_errno                = 0;
         char *        real_path               = NULL;
         int           ret                     = -1;
+        unsigned char *xgfid                  = NULL;
 
         DECLARE_OLD_FS_ID_VAR;
         SET_FS_ID (frame->root->uid, frame->root->gid);
@@ -2386,6 +2479,7 @@ posix_setxattr (call_frame_t *frame, xlator_t *this,
         VALIDATE_OR_GOTO (dict, out);
 
         MAKE_INODE_HANDLE (real_path, this, loc, NULL);
+        xgfid = posix_xattrop_loc_gfid (loc);
 
         op_ret = -1;
         dict_del (dict, GFID_XATTR_KEY);
@@ -2394,6 +2488,10 @@ posix_setxattr (call_frame_t *frame, xlator_t *this,
         int _handle_every_keyvalue_pair (dict_t *d, char *k, data_t *v,
                                          void *tmp)
         {
+                if (posix_xattrop_cache_forget (this, xgfid, k) == -1) {
+                        op_errno = errno;
+                        return -1;
+                }
                 ret = posix_handle_pair (this, real_path, k, v, flags);
                 if (ret < 0) {
                         op_errno = -ret;
@@ -2436,6 +2534,7 @@ posix_getxattr (call_frame_t *frame, xlator_t *this,
         char                 *path           = NULL;
         char                 *rpath          = NULL;
         char                 *dyn_rpath      = NULL;
+        unsigned char        *xgfid          = NULL;
 
         DECLARE_OLD_FS_ID_VAR;
 
@@ -2445,6 +2544,7 @@ posix_getxattr (call_frame_t *frame, xlator_t *this,
 
         SET_FS_ID (frame->root->uid, frame->root->gid);
         MAKE_INODE_HANDLE (real_path, this, loc, NULL);
+        xgfid = posix_xattrop_loc_gfid (loc);
 
         op_ret = -1;
         priv = this->private;
@@ -2557,6 +2657,11 @@ posix_getxattr (call_frame_t *frame, xlator_t *this,
         if (name) {
                 strcpy (key, name);
 
+                /* newer than the backend while xattrops are cached */
+                size = posix_xattrop_cache_get (this, xgfid, key, dict);
+                if (size > 0)
+                        goto done;
+
                 size = sys_lgetxattr (real_path, key, NULL, 0);
                 if (size <= 0) {
                         op_errno = errno;
@@ -2681,6 +2786,8 @@ posix_getxattr (call_frame_t *frame, xlator_t *this,
 
         } /* while (remaining_size > 0) */
 
+        posix_xattrop_cache_fill (this, xgfid, dict);
+
 done:
         op_ret = size;
 
@@ -2753,6 +2860,12 @@ posix_fgetxattr (call_frame_t *frame, xlator_t *this,
         if (name) {
                 strcpy (key, name);
 
+                /* newer than the backend while xattrops are cached */
+                size = posix_xattrop_cache_get (this, fd->inode->gfid, key,
+                                                dict);
+                if (size > 0)
+                        goto done;
+
                 size = sys_fgetxattr (_fd, key, NULL, 0);
                 if (size <= 0) {
                         op_errno = errno;
@@ -2865,6 +2978,8 @@ posix_fgetxattr (call_frame_t *frame, xlator_t *this,
 
         } /* while (remaining_size > 0) */
 
+        posix_xattrop_cache_fill (this, fd->inode->gfid, dict);
+
 done:
         op_ret = size;
 
@@ -2917,6 +3032,11 @@ posix_fsetxattr (call_frame_t *frame, xlator_t *this,
         int _handle_every_keyvalue_pair (dict_t *d, char *k, data_t *v,
                                          void *tmp)
         {
+                if (posix_xattrop_cache_forget (this, fd->inode->gfid,
+                                                k) == -1) {
+                        op_errno = errno;
+                        return -1;
+                }
                 ret = posix_fhandle_pair (this, _fd, k, v, flags);
                 if (ret < 0) {
                         op_errno = -ret;
@@ -2942,10 +3062,12 @@ posix_removexattr (call_frame_t *frame, xlator_t *this,
         int32_t op_ret    = -1;
         int32_t op_errno  = 0;
         char *  real_path = NULL;
+        unsigned char *xgfid = NULL;
 
         DECLARE_OLD_FS_ID_VAR;
 
         MAKE_INODE_HANDLE (real_path, this, loc, NULL);
+        xgfid = posix_xattrop_loc_gfid (loc);
 
         if (!strcmp (GFID_XATTR_KEY, name)) {
                 gf_log (this->name, GF_LOG_WARNING, "Remove xattr called"
@@ -2957,6 +3079,12 @@ posix_removexattr (call_frame_t *frame, xlator_t *this,
 
         SET_FS_ID (frame->root->uid, frame->root->gid);
 
+        op_ret = posix_xattrop_cache_forget (this, xgfid, name);
+        if (op_ret == -1) {
+                op_errno = errno;
+                goto out;
+        }
+
         op_ret = sys_lremovexattr (real_path, name);
         if (op_ret == -1) {
                 op_errno = errno;
@@ -3007,6 +3135,12 @@ posix_fremovexattr (call_frame_t *frame, xlator_t *this,
 
         SET_FS_ID (frame->root->uid, frame->root->gid);
 
+        op_ret = posix_xattrop_cache_forget (this, fd->inode->gfid, name);
+        if (op_ret == -1) {
+                op_errno = errno;
+                goto out;
+        }
+
         op_ret = sys_fremovexattr (_fd, name);
         if (op_ret == -1) {
                 op_errno = errno;
@@ -3115,6 +3249,37 @@ __add_long_array (int64_t *dest, int64_t *src, int count)
         }
 }
 
+/* apply @optype with @data to the current value in @array */
+int
+posix_xattrop_apply (gf_xattrop_flags_t optype, char *array, char *data,
+                     int len)
+{
+        switch (optype) {
+
+        case GF_XATTROP_ADD_ARRAY:
+                __add_array ((int32_t *) array, (int32_t *) data, len / 4);
+                break;
+
+        case GF_XATTROP_ADD_ARRAY64:
+                __add_long_array ((int64_t *) array, (int64_t *) data,
+                                  len / 8);
+                break;
+
+        case GF_XATTROP_OR_ARRAY:
+                __or_array ((int32_t *) array, (int32_t *) data, len / 4);
+                break;
+
+        case GF_XATTROP_AND_ARRAY:
+                __and_array ((int32_t *) array, (int32_t *) data, len / 4);
+                break;
+
+        default:
+                return -1;
+        }
+
+        return 0;
+}
+
 /**
  * xattrop - xattr operations - for internal use by GlusterFS
  * @optype: ADD_ARRAY:
@@ -3140,11 +3305,15 @@ do_xattrop (call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd,
 
         char *    path  = NULL;
         inode_t * inode = NULL;
+        struct posix_private *priv = NULL;
+        unsigned char        *gfid = NULL;
 
         VALIDATE_OR_GOTO (frame, out);
         VALIDATE_OR_GOTO (xattr, out);
         VALIDATE_OR_GOTO (this, out);
 
+        priv = this->private;
+
         if (fd) {
                 ret = posix_fd_ctx_get (fd, this, &pfd);
                 if (ret < 0) {
@@ -3164,8 +3333,10 @@ do_xattrop (call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd,
         if (real_path) {
                 path  = gf_strdup (real_path);
                 inode = loc->inode;
+                gfid  = posix_xattrop_loc_gfid (loc);
         } else if (fd) {
                 inode = fd->inode;
+                gfid  = fd->inode->gfid;
         }
 
         int _handle_every_keyvalue_pair (dict_t *d, char *k, data_t *v,
@@ -3175,6 +3346,20 @@ do_xattrop (call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd,
                 count = v->len;
                 array = GF_CALLOC (count, sizeof (char), gf_posix_mt_char);
 
+                if (priv->xattrop_cache && gfid && !uuid_is_null (gfid)) {
+                        /* counted in memory, persisted through the journal */
+                        size = posix_xattrop_cache_op (this, gfid,
+                                                       real_path, _fd, k,
+                                                       optype, v->data,
+                                                       v->len, array);
+                        if (size == -1) {
+                                op_ret = -1;
+                                op_errno = errno;
+                                goto out;
+                        }
+                        goto cached;
+                }
+
                 LOCK (&inode->lock);
                 {
                         if (loc) {
@@ -3212,31 +3397,8 @@ do_xattrop (call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd,
                                 goto unlock;
                         }
 
-                        switch (optype) {
-
-                        case GF_XATTROP_ADD_ARRAY:
-                                __add_array ((int32_t *) array, (int32_t *) v->data,
-                                             v->len / 4);
-                                break;
-
-                        case GF_XATTROP_ADD_ARRAY64:
-                                __add_long_array ((int64_t *) array, (int64_t *) v->data,
-                                                  v->len / 8);
-                                break;
-
-                        case GF_XATTROP_OR_ARRAY:
-                                __or_array ((int32_t *) array,
-                                            (int32_t *) v->data,
-                                            v->len / 4);
-                                break;
-
-                        case GF_XATTROP_AND_ARRAY:
-                                __and_array ((int32_t *) array,
-                                             (int32_t *) v->data,
-                                             v->len / 4);
-                                break;
-
-                        default:
+                        if (posix_xattrop_apply (optype, array, v->data,
+                                                 v->len) == -1) {
                                 gf_log (this->name, GF_LOG_ERROR,
                                         "Unknown xattrop type (%d) on %s. Please send "
                                         "a bug report to gluster-devel@nongnu.org",
@@ -3260,6 +3422,7 @@ do_xattrop (call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd,
                 if (op_ret == -1)
                         goto out;
 
+        cached:
                 op_errno = errno;
                 if (size == -1) {
                         if (loc)
@@ -3408,6 +3571,9 @@ posix_ftruncate (call_frame_t *frame, xlator_t *this,
                 goto out;
         }
 
+        if (priv->scrub)
+                posix_scrub_write (this, pfd);
+
         op_ret = ftruncate (_fd, offset);
 
         if (op_ret == -1) {
@@ -3439,6 +3605,287 @@ out:
 }
 
 
+/* zeroes [offset, offset + len) the way writes of zeroes would, for the
+   filesystems without FALLOC_FL_ZERO_RANGE: the range is deallocated
+   and allocated again when the filesystem can punch holes, else zeroes
+   are written */
+static int
+posix_zerofill_fallback (int fd, off_t offset, off_t len)
+{
+        char  *zeroes = NULL;
+        off_t  done   = 0;
+        size_t size   = 0;
+        int    ret    = -1;
+
+        ret = sys_fallocate (fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                             offset, len);
+        if (ret == 0) {
+                ret = sys_fallocate (fd, 0, offset, len);
+                if (ret == 0 || (errno != EOPNOTSUPP && errno != ENOSYS))
+                        return ret;
+        }
+
+        zeroes = GF_CALLOC (1, POSIX_ZEROFILL_CHUNK, gf_common_mt_char);
+        if (!zeroes) {
+                errno = ENOMEM;
+                return -1;
+        }
+
+        for (done = 0; done < len; done += ret) {
+                size = min (len - done, POSIX_ZEROFILL_CHUNK);
+                ret = pwrite (fd, zeroes, size, offset + done);
+                if (ret <= 0) {
+                        if (ret == 0)
+                                errno = EIO;
+                        ret = -1;
+                        goto out;
+                }
+        }
+
+        ret = 0;
+out:
+        GF_FREE (zeroes);
+        return ret;
+}
+
+
+/* fallocate, discard and zerofill: mode is that of fallocate (2), with
+   FALLOC_FL_ZERO_RANGE falling back to posix_zerofill_fallback */
+static int32_t
+posix_do_fallocate (xlator_t *this, fd_t *fd, int mode, off_t offset,
+                    off_t len, struct iatt *preop, struct iatt *postop)
+{
+        struct posix_fd      *pfd  = NULL;
+        struct posix_private *priv = NULL;
+        int                   _fd  = -1;
+        int                   ret  = -1;
+
+        priv = this->private;
+
+        if (offset < 0 || len <= 0)
+                return -EINVAL;
+
+        ret = posix_fd_ctx_get (fd, this, &pfd);
+        if (ret < 0) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "pfd is NULL, fd=%p", fd);
+                return ret;
+        }
+
+        _fd = pfd->fd;
+
+        ret = posix_fdstat (this, _fd, preop);
+        if (ret == -1) {
+                ret = -errno;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "pre-operation fstat failed on fd=%p: %s", fd,
+                        strerror (errno));
+                return ret;
+        }
+
+        if (priv->scrub)
+                posix_scrub_write (this, pfd);
+
+        ret = sys_fallocate (_fd, mode, offset, len);
+        if (ret == -1 && mode == FALLOC_FL_ZERO_RANGE &&
+            (errno == EOPNOTSUPP || errno == ENOSYS))
+                ret = posix_zerofill_fallback (_fd, offset, len);
+        if (ret == -1) {
+                ret = -errno;
+                gf_log (this->name, (ret == -EOPNOTSUPP || ret == -ENOSYS) ?
+                        GF_LOG_DEBUG : GF_LOG_ERROR,
+                        "fallocate (mode %d) failed on fd=%p (%"PRId64
+                        ", %"PRId64"): %s", mode, fd, offset, len,
+                        strerror (-ret));
+                return ret;
+        }
+
+        ret = posix_fdstat (this, _fd, postop);
+        if (ret == -1) {
+                ret = -errno;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "post-operation fstat failed on fd=%p: %s",
+                        fd, strerror (errno));
+                return ret;
+        }
+
+        return 0;
+}
+
+
+int32_t
+posix_glfallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                   int32_t keep_size, off_t offset, size_t len,
+                   dict_t *xdata)
+{
+        int32_t     ret      = -1;
+        int32_t     op_ret   = -1;
+        int32_t     op_errno = 0;
+        struct iatt preop    = {0,};
+        struct iatt postop   = {0,};
+
+        DECLARE_OLD_FS_ID_VAR;
+        SET_FS_ID (frame->root->uid, frame->root->gid);
+
+        VALIDATE_OR_GOTO (frame, out);
+        VALIDATE_OR_GOTO (this, out);
+        VALIDATE_OR_GOTO (fd, out);
+
+        /* not posix_fallocate, taken by libc */
+        ret = posix_do_fallocate (this, fd,
+                                  keep_size ? FALLOC_FL_KEEP_SIZE : 0,
+                                  offset, len, &preop, &postop);
+        if (ret < 0) {
+                op_errno = -ret;
+                goto out;
+        }
+
+        op_ret = 0;
+out:
+        SET_TO_OLD_FS_ID ();
+
+        STACK_UNWIND_STRICT (fallocate, frame, op_ret, op_errno, &preop,
+                             &postop, NULL);
+
+        return 0;
+}
+
+
+int32_t
+posix_discard (call_frame_t *frame, xlator_t *this, fd_t *fd,
+               off_t offset, size_t len, dict_t *xdata)
+{
+        int32_t     ret      = -1;
+        int32_t     op_ret   = -1;
+        int32_t     op_errno = 0;
+        struct iatt preop    = {0,};
+        struct iatt postop   = {0,};
+
+        DECLARE_OLD_FS_ID_VAR;
+        SET_FS_ID (frame->root->uid, frame->root->gid);
+
+        VALIDATE_OR_GOTO (frame, out);
+        VALIDATE_OR_GOTO (this, out);
+        VALIDATE_OR_GOTO (fd, out);
+
+        ret = posix_do_fallocate (this, fd,
+                                  FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                                  offset, len, &preop, &postop);
+        if (ret < 0) {
+                op_errno = -ret;
+                goto out;
+        }
+
+        op_ret = 0;
+out:
+        SET_TO_OLD_FS_ID ();
+
+        STACK_UNWIND_STRICT (discard, frame, op_ret, op_errno, &preop,
+                             &postop, NULL);
+
+        return 0;
+}
+
+
+int32_t
+posix_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                off_t offset, off_t len, dict_t *xdata)
+{
+        int32_t     ret      = -1;
+        int32_t     op_ret   = -1;
+        int32_t     op_errno = 0;
+        struct iatt preop    = {0,};
+        struct iatt postop   = {0,};
+
+        DECLARE_OLD_FS_ID_VAR;
+        SET_FS_ID (frame->root->uid, frame->root->gid);
+
+        VALIDATE_OR_GOTO (frame, out);
+        VALIDATE_OR_GOTO (this, out);
+        VALIDATE_OR_GOTO (fd, out);
+
+        ret = posix_do_fallocate (this, fd, FALLOC_FL_ZERO_RANGE,
+                                  offset, len, &preop, &postop);
+        if (ret < 0) {
+                op_errno = -ret;
+                goto out;
+        }
+
+        op_ret = 0;
+out:
+        SET_TO_OLD_FS_ID ();
+
+        STACK_UNWIND_STRICT (zerofill, frame, op_ret, op_errno, &preop,
+                             &postop, NULL);
+
+        return 0;
+}
+
+
+int32_t
+posix_seek (call_frame_t *frame, xlator_t *this, fd_t *fd,
+            off_t offset, gf_seek_what_t what, dict_t *xdata)
+{
+        struct posix_fd *pfd      = NULL;
+        int32_t          op_ret   = -1;
+        int32_t          op_errno = 0;
+        int              whence   = 0;
+        int              ret      = -1;
+        off_t            off      = -1;
+
+        DECLARE_OLD_FS_ID_VAR;
+        SET_FS_ID (frame->root->uid, frame->root->gid);
+
+        VALIDATE_OR_GOTO (frame, out);
+        VALIDATE_OR_GOTO (this, out);
+        VALIDATE_OR_GOTO (fd, out);
+
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+        switch (what) {
+        case GF_SEEK_DATA:
+                whence = SEEK_DATA;
+                break;
+        case GF_SEEK_HOLE:
+                whence = SEEK_HOLE;
+                break;
+        default:
+                op_errno = EINVAL;
+                goto out;
+        }
+
+        ret = posix_fd_ctx_get (fd, this, &pfd);
+        if (ret < 0) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "pfd is NULL, fd=%p", fd);
+                op_errno = -ret;
+                goto out;
+        }
+
+        /* the offset of the fd is not that of any client, moving it is
+           harmless: reads and writes are positional */
+        off = lseek (pfd->fd, offset, whence);
+        if (off == -1) {
+                op_errno = errno;
+                if (op_errno != ENXIO)
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "seek (%d) failed on fd=%p (%"PRId64"): %s",
+                                whence, fd, offset, strerror (op_errno));
+                goto out;
+        }
+
+        op_ret = 0;
+#else
+        op_errno = ENOSYS;
+#endif
+out:
+        SET_TO_OLD_FS_ID ();
+
+        STACK_UNWIND_STRICT (seek, frame, op_ret, op_errno, off, NULL);
+
+        return 0;
+}
+
+
 int32_t
 posix_fstat (call_frame_t *frame, xlator_t *this,
              fd_t *fd, dict_t *xdata)
@@ -3682,77 +4129,144 @@ out:
         return count;
 }
 
-dict_t *
-posix_entry_xattr_fill (xlator_t *this, inode_t *inode,
-                        fd_t *fd, char *name, dict_t *dict,
-                        struct iatt *stbuf)
+/* Entries below this count are filled by the calling thread alone, the
+ * hand-off to the readdirp workers would cost more than it saves. */
+#define POSIX_READDIRP_PARALLEL_MIN 64
+
+void
+posix_readdirp_fill_slice (xlator_t *this, struct posix_readdirp_job *job)
 {
-        loc_t  tmp_loc    = {0,};
-        char  *entry_path = NULL;
+        struct posix_readdirp_batch *batch  = NULL;
+        gf_dirent_t                 *entry  = NULL;
+        inode_table_t               *itable = NULL;
+        inode_t                     *inode  = NULL;
+        char                        *hpath  = NULL;
+        struct iatt                  stbuf  = {0, };
+        loc_t                        tmp_loc = {0, };
+        uuid_t                       gfid;
+        int                          i      = 0;
+
+        batch = job->batch;
+        itable = batch->fd->inode->table;
+
+        hpath = alloca (batch->hlen + 256); /* NAME_MAX */
+        memcpy (hpath, batch->hpath, batch->hlen);
+        hpath[batch->hlen] = '/';
+
+        for (i = job->start; i < job->end; i++) {
+                entry = batch->entries[i];
+
+                memset (gfid, 0, 16);
+                memset (&stbuf, 0, sizeof (stbuf));
+                inode = inode_grep (itable, batch->fd->inode, entry->d_name);
+                if (inode)
+                        uuid_copy (gfid, inode->gfid);
+
+                strcpy (&hpath[batch->hlen + 1], entry->d_name);
 
-        /* if we don't send the 'loc', open-fd-count be a problem. */
-        tmp_loc.inode = inode;
+                /* if we don't send the 'loc', open-fd-count be a problem. */
+                tmp_loc.inode = inode;
 
-        MAKE_HANDLE_PATH (entry_path, this, fd->inode->gfid, name);
+                posix_entry_at_fill (this, batch->dirfd, entry->d_name, hpath,
+                                     gfid, &tmp_loc, batch->dict, &stbuf,
+                                     &entry->dict);
 
-        return posix_lookup_xattr_fill (this, entry_path,
-                                        &tmp_loc, dict, stbuf);
+                if (!inode)
+                        inode = inode_find (itable, stbuf.ia_gfid);
 
+                if (!inode)
+                        inode = inode_new (itable);
+
+                entry->inode = inode;
+
+                if (entry->dict)
+                        dict_ref (entry->dict);
+
+                entry->d_stat = stbuf;
+                if (stbuf.ia_ino)
+                        entry->d_ino = stbuf.ia_ino;
+                inode = NULL;
+        }
 }
 
 
 int
-posix_readdirp_fill (xlator_t *this, fd_t *fd, gf_dirent_t *entries, dict_t *dict)
+posix_readdirp_fill (xlator_t *this, fd_t *fd, DIR *dir, gf_dirent_t *entries,
+                     dict_t *dict)
 {
-        gf_dirent_t     *entry    = NULL;
-        inode_table_t   *itable   = NULL;
-	inode_t         *inode    = NULL;
-	char            *hpath    = NULL;
-	int              len      = 0;
-        struct iatt      stbuf    = {0, };
-	uuid_t           gfid;
+        struct posix_private        *priv    = NULL;
+        struct posix_readdirp_batch  batch   = {0, };
+        struct posix_readdirp_job   *jobs    = NULL;
+        gf_dirent_t                 *entry   = NULL;
+        char                        *hpath   = NULL;
+        int                          len     = 0;
+        int                          count   = 0;
+        int                          slices  = 1;
+        int                          i       = 0;
+
+        priv = this->private;
 
+        list_for_each_entry (entry, &entries->list, list)
+                count++;
 
-        itable = fd->inode->table;
+        if (!count)
+                return 0;
 
 	len = posix_handle_path (this, fd->inode->gfid, NULL, NULL, 0);
-	hpath = alloca (len + 256); /* NAME_MAX */
+	hpath = alloca (len);
 	posix_handle_path (this, fd->inode->gfid, NULL, hpath, len);
-	len = strlen (hpath);
-	hpath[len] = '/';
 
-        list_for_each_entry (entry, &entries->list, list) {
-		memset (gfid, 0, 16);
-		inode = inode_grep (fd->inode->table, fd->inode,
-				    entry->d_name);
-		if (inode)
-			uuid_copy (gfid, inode->gfid);
+        batch.fd = fd;
+        batch.dirfd = dirfd (dir);
+        batch.hpath = hpath;
+        batch.hlen = strlen (hpath);
+        batch.dict = dict;
+        batch.entries = alloca (count * sizeof (gf_dirent_t *));
 
-		strcpy (&hpath[len+1], entry->d_name);
+        list_for_each_entry (entry, &entries->list, list)
+                batch.entries[i++] = entry;
 
-                posix_pstat (this, gfid, hpath, &stbuf);
+        if (priv->readdirp_threads && count >= POSIX_READDIRP_PARALLEL_MIN)
+                slices = min (priv->readdirp_threads + 1,
+                              count / (POSIX_READDIRP_PARALLEL_MIN / 2));
 
-		if (!inode)
-			inode = inode_find (itable, stbuf.ia_gfid);
+        jobs = alloca (slices * sizeof (*jobs));
+        for (i = 0; i < slices; i++) {
+                INIT_LIST_HEAD (&jobs[i].list);
+                jobs[i].batch = &batch;
+                jobs[i].start = (count * i) / slices;
+                jobs[i].end = (count * (i + 1)) / slices;
+        }
 
-		if (!inode)
-			inode = inode_new (itable);
+        if (slices == 1) {
+                posix_readdirp_fill_slice (this, &jobs[0]);
+                return 0;
+        }
 
-		entry->inode = inode;
+        pthread_mutex_init (&batch.lock, NULL);
+        pthread_cond_init (&batch.cond, NULL);
+        batch.pending = slices - 1;
 
-                if (dict) {
-                        entry->dict =
-                                posix_entry_xattr_fill (this, entry->inode,
-                                                        fd, entry->d_name,
-                                                        dict, &stbuf);
-                        dict_ref (entry->dict);
-                }
+        pthread_mutex_lock (&priv->readdirp_lock);
+        {
+                for (i = 1; i < slices; i++)
+                        list_add_tail (&jobs[i].list, &priv->readdirp_jobs);
+                pthread_cond_broadcast (&priv->readdirp_cond);
+        }
+        pthread_mutex_unlock (&priv->readdirp_lock);
 
-                entry->d_stat = stbuf;
-                if (stbuf.ia_ino)
-                        entry->d_ino = stbuf.ia_ino;
-		inode = NULL;
+        /* the first slice is ours */
+        posix_readdirp_fill_slice (this, &jobs[0]);
+
+        pthread_mutex_lock (&batch.lock);
+        {
+                while (batch.pending)
+                        pthread_cond_wait (&batch.cond, &batch.lock);
         }
+        pthread_mutex_unlock (&batch.lock);
+
+        pthread_mutex_destroy (&batch.lock);
+        pthread_cond_destroy (&batch.cond);
 
 	return 0;
 }
@@ -3810,7 +4324,7 @@ posix_do_readdir (call_frame_t *frame, xlator_t *this,
         if (whichop != GF_FOP_READDIRP)
                 goto out;
 
-	posix_readdirp_fill (this, fd, &entries, dict);
+	posix_readdirp_fill (this, fd, dir, &entries, dict);
 
 out:
         STACK_UNWIND_STRICT (readdir, frame, op_ret, op_errno, &entries, NULL);
@@ -3861,6 +4375,35 @@ posix_priv (xlator_t *this)
         gf_proc_dump_write("max_read","%d", priv->read_value);
         gf_proc_dump_write("max_write","%d", priv->write_value);
         gf_proc_dump_write("nr_files","%ld", priv->nr_files);
+        gf_proc_dump_write("readdirp_threads","%d", priv->readdirp_threads);
+        gf_proc_dump_write("batch_fsync_delay_usec","%u",
+                           priv->batch_fsync_delay_usec);
+        if (priv->fsyncer_present) {
+                pthread_mutex_lock (&priv->fsync_lock);
+                {
+                        gf_proc_dump_write("batch_fsync_window","%u",
+                                           priv->batch_fsync_window);
+                        gf_proc_dump_write("fsync_queue_count","%d",
+                                           priv->fsync_queue_count);
+                        gf_proc_dump_write("fsync_batches","%"PRIu64,
+                                           priv->fsync_batches);
+                        gf_proc_dump_write("fsync_batched","%"PRIu64,
+                                           priv->fsync_batched);
+                        gf_proc_dump_write("fsync_syscalls","%"PRIu64,
+                                           priv->fsync_syscalls);
+                }
+                pthread_mutex_unlock (&priv->fsync_lock);
+        }
+        gf_proc_dump_write("create_tmpfile","%d", priv->create_tmpfile);
+        gf_proc_dump_write("tmpfile_creates","%"PRIu64,
+                           priv->tmpfile_creates);
+        gf_proc_dump_write("tmpfile_fallbacks","%"PRIu64,
+                           priv->tmpfile_fallbacks);
+        posix_handle_cache_dump (this);
+        posix_uring_dump (this);
+        posix_xattrop_cache_dump (this);
+        posix_scrub_dump (this);
+        posix_reclaim_dump (this);
 
         return 0;
 }
@@ -3884,6 +4427,12 @@ posix_rchecksum (call_frame_t *frame, xlator_t *this,
         int              ret           = 0;
         int32_t          weak_checksum = 0;
         unsigned char    strong_checksum[MD5_DIGEST_LENGTH];
+        int32_t          block_size    = 0;
+        int32_t          blocks        = 0;
+        int32_t          i             = 0;
+        unsigned char   *digests       = NULL;
+        dict_t          *rsp_xdata     = NULL;
+        int32_t          type          = GF_CHECKSUM_MD5;
 
         VALIDATE_OR_GOTO (frame, out);
         VALIDATE_OR_GOTO (this, out);
@@ -3918,14 +4467,66 @@ posix_rchecksum (call_frame_t *frame, xlator_t *this,
         }
 
         weak_checksum = gf_rsync_weak_checksum ((unsigned char *) buf, (size_t) len);
-        gf_rsync_strong_checksum ((unsigned char *) buf, (size_t) len, (unsigned char *) strong_checksum);
+
+        if (xdata && !dict_get_int32 (xdata, GF_RCHECKSUM_STRONG_TYPE,
+                                      &type) && type == GF_CHECKSUM_MURMUR3) {
+                rsp_xdata = dict_new ();
+                if (!rsp_xdata ||
+                    dict_set_int32 (rsp_xdata, GF_RCHECKSUM_STRONG_TYPE,
+                                    type)) {
+                        op_errno = ENOMEM;
+                        goto out;
+                }
+        } else {
+                type = GF_CHECKSUM_MD5;
+        }
+
+        /* self-heal asks for the digest of every block of a window in
+           one call, instead of one call per block; it has no use for the
+           digest of the whole window then */
+        if (xdata && !dict_get_int32 (xdata, GF_RCHECKSUM_BLOCK_SIZE,
+                                      &block_size) && block_size > 0) {
+                blocks = (len + block_size - 1) / block_size;
+                digests = GF_CALLOC (blocks, GF_CHECKSUM_LENGTH,
+                                     gf_posix_mt_char);
+                if (!rsp_xdata)
+                        rsp_xdata = dict_new ();
+                if (!digests || !rsp_xdata) {
+                        op_errno = ENOMEM;
+                        goto out;
+                }
+
+                for (i = 0; i < blocks; i++)
+                        gf_rsync_checksum_by_type (type,
+                                                   (unsigned char *) buf +
+                                                   i * block_size,
+                                                   min (block_size,
+                                                        len - i * block_size),
+                                                   digests +
+                                                   i * GF_CHECKSUM_LENGTH);
+
+                ret = dict_set_bin (rsp_xdata, GF_RCHECKSUM_BLOCK_DIGESTS,
+                                    digests, blocks * GF_CHECKSUM_LENGTH);
+                if (ret) {
+                        op_errno = -ret;
+                        goto out;
+                }
+                digests = NULL;
+        } else {
+                gf_rsync_checksum_by_type (type, (unsigned char *) buf,
+                                           (size_t) len,
+                                           (unsigned char *) strong_checksum);
+        }
 
         op_ret = 0;
 out:
         STACK_UNWIND_STRICT (rchecksum, frame, op_ret, op_errno,
-                             weak_checksum, strong_checksum, NULL);
+                             weak_checksum, strong_checksum, rsp_xdata);
 
         GF_FREE (buf);
+        GF_FREE (digests);
+        if (rsp_xdata)
+                dict_unref (rsp_xdata);
 
         return 0;
 }
@@ -3998,6 +4599,13 @@ reconfigure (xlator_t *this, dict_t *options)
 	struct posix_private *priv = NULL;
         uid_t                 uid = -1;
         gid_t                 gid = -1;
+        int32_t               size = 0;
+        char                 *mode = NULL;
+        uint32_t              interval = 0;
+        uint32_t              scrub_rate = 0;
+        uint32_t              scrub_idle = 0;
+        uint64_t              reclaim_size = 0;
+        uint32_t              reclaim_rate = 0;
 
 	priv = this->private;
 
@@ -4013,6 +4621,47 @@ reconfigure (xlator_t *this, dict_t *options)
 	else
 		posix_aio_off (this);
 
+        GF_OPTION_RECONF ("io-uring-fixed-buffers", priv->uring_fixed_buffers,
+                          options, bool, out);
+        GF_OPTION_RECONF ("io-uring", priv->uring_configured,
+                          options, bool, out);
+
+        if (priv->uring_configured)
+                posix_uring_on (this);
+        else
+                posix_uring_off (this);
+
+        GF_OPTION_RECONF ("handle-cache-size", size, options, int32, out);
+        posix_handle_cache_resize (this, size);
+
+        GF_OPTION_RECONF ("xattrop-flush-interval", interval, options,
+                          uint32, out);
+        posix_xattrop_cache_set_interval (this, interval);
+
+        GF_OPTION_RECONF ("create-tmpfile", priv->create_tmpfile,
+                          options, bool, out);
+
+        GF_OPTION_RECONF ("scrub-max-rate", scrub_rate, options, uint32, out);
+        GF_OPTION_RECONF ("scrub-idle-msec", scrub_idle, options, uint32,
+                          out);
+        GF_OPTION_RECONF ("scrub-interval", interval, options, uint32, out);
+        posix_scrub_reconf (this, scrub_rate, scrub_idle, interval);
+
+        GF_OPTION_RECONF ("reclaim-min-size", reclaim_size, options, size,
+                          out);
+        GF_OPTION_RECONF ("reclaim-max-rate", reclaim_rate, options, uint32,
+                          out);
+        posix_reclaim_reconf (this, reclaim_size, reclaim_rate);
+
+        GF_OPTION_RECONF ("batch-fsync-mode", mode, options, str, out);
+        priv->batch_fsync_syncfs = (strcmp (mode, "syncfs") == 0);
+
+        GF_OPTION_RECONF ("batch-fsync-delay-usec",
+                          priv->batch_fsync_delay_usec, options, uint32, out);
+        if (priv->batch_fsync_delay_usec &&
+            posix_spawn_fsyncer_thread (this) == -1)
+                priv->batch_fsync_delay_usec = 0;
+
 	ret = 0;
 out:
 	return ret;
@@ -4042,6 +4691,18 @@ init (xlator_t *this)
         char                 *guuid         = NULL;
         uid_t                 uid           = -1;
         gid_t                 gid           = -1;
+        int32_t               handle_cache_size = 0;
+        char                 *fsync_mode        = NULL;
+        gf_boolean_t          xattrop_cache     = _gf_false;
+        uint32_t              xattrop_interval  = 0;
+        gf_boolean_t          scrub             = _gf_false;
+        uint32_t              scrub_rate        = 0;
+        uint32_t              scrub_idle        = 0;
+        uint32_t              scrub_interval    = 0;
+        gf_boolean_t          reclaim           = _gf_false;
+        int32_t               reclaim_threads   = 0;
+        uint64_t              reclaim_size      = 0;
+        uint32_t              reclaim_rate      = 0;
 
         dir_data = dict_get (this->options, "directory");
 
@@ -4377,11 +5038,92 @@ init (xlator_t *this)
 		}
 	}
 
+        GF_OPTION_INIT ("io-uring-fixed-buffers",
+                        _private->uring_fixed_buffers, bool, out);
+        GF_OPTION_INIT ("io-uring", _private->uring_configured, bool, out);
+
+        if (_private->uring_configured &&
+            posix_uring_on (this) == -1)
+                gf_log (this->name, GF_LOG_WARNING,
+                        "io_uring setup failed, continuing without it");
+
         pthread_mutex_init (&_private->janitor_lock, NULL);
         pthread_cond_init (&_private->janitor_cond, NULL);
         INIT_LIST_HEAD (&_private->janitor_fds);
 
         posix_spawn_janitor_thread (this);
+
+        GF_OPTION_INIT ("handle-cache-size", handle_cache_size, int32, out);
+        if (posix_handle_cache_init (this, handle_cache_size) == -1)
+                gf_log (this->name, GF_LOG_WARNING,
+                        "handle cache setup failed, running without it");
+
+        GF_OPTION_INIT ("readdirp-threads", _private->readdirp_threads,
+                        int32, out);
+
+        if (posix_spawn_readdirp_workers (this) == -1)
+                gf_log (this->name, GF_LOG_WARNING,
+                        "readdirp running with %d workers",
+                        _private->readdirp_threads);
+
+        pthread_mutex_init (&_private->fsync_lock, NULL);
+        pthread_cond_init (&_private->fsync_cond, NULL);
+        INIT_LIST_HEAD (&_private->fsyncs);
+
+        GF_OPTION_INIT ("batch-fsync-mode", fsync_mode, str, out);
+        _private->batch_fsync_syncfs = (strcmp (fsync_mode, "syncfs") == 0);
+
+        GF_OPTION_INIT ("batch-fsync-delay-usec",
+                        _private->batch_fsync_delay_usec, uint32, out);
+        if (_private->batch_fsync_delay_usec &&
+            posix_spawn_fsyncer_thread (this) == -1) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "fsyncs will not be batched");
+                _private->batch_fsync_delay_usec = 0;
+        }
+
+        _private->handle_dirs = GF_CALLOC (POSIX_HANDLE_DIRS, 1,
+                                           gf_posix_mt_char);
+        if (!_private->handle_dirs) {
+                ret = -1;
+                goto out;
+        }
+        GF_OPTION_INIT ("create-tmpfile", _private->create_tmpfile, bool, out);
+
+        /* replays what a crash left in the xattrop journal even when the
+           cache is off now */
+        GF_OPTION_INIT ("xattrop-cache", xattrop_cache, bool, out);
+        GF_OPTION_INIT ("xattrop-flush-interval", xattrop_interval,
+                        uint32, out);
+        if (posix_xattrop_cache_init (this, xattrop_cache,
+                                      xattrop_interval) == -1) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "xattrop journal setup failed");
+                ret = -1;
+                goto out;
+        }
+
+        GF_OPTION_INIT ("scrub", scrub, bool, out);
+        GF_OPTION_INIT ("scrub-max-rate", scrub_rate, uint32, out);
+        GF_OPTION_INIT ("scrub-idle-msec", scrub_idle, uint32, out);
+        GF_OPTION_INIT ("scrub-interval", scrub_interval, uint32, out);
+        if (posix_scrub_init (this, scrub, scrub_rate, scrub_idle,
+                              scrub_interval) == -1) {
+                gf_log (this->name, GF_LOG_ERROR, "scrubber setup failed");
+                ret = -1;
+                goto out;
+        }
+
+        GF_OPTION_INIT ("reclaim", reclaim, bool, out);
+        GF_OPTION_INIT ("reclaim-threads", reclaim_threads, int32, out);
+        GF_OPTION_INIT ("reclaim-min-size", reclaim_size, size, out);
+        GF_OPTION_INIT ("reclaim-max-rate", reclaim_rate, uint32, out);
+        if (posix_reclaim_init (this, reclaim, reclaim_threads, reclaim_size,
+                                reclaim_rate) == -1) {
+                gf_log (this->name, GF_LOG_ERROR, "reclaimer setup failed");
+                ret = -1;
+                goto out;
+        }
 out:
         return ret;
 }
@@ -4392,6 +5134,13 @@ fini (xlator_t *this)
         struct posix_private *priv = this->private;
         if (!priv)
                 return;
+        posix_stop_fsyncer_thread (this);
+        posix_scrub_fini (this);
+        posix_reclaim_fini (this);
+        posix_xattrop_cache_fini (this);
+        posix_stop_readdirp_workers (this);
+        posix_handle_cache_fini (this);
+        GF_FREE (priv->handle_dirs);
         this->private = NULL;
         /*unlock brick dir*/
         if (priv->mount_lock)
@@ -4447,6 +5196,10 @@ struct xlator_fops fops = {
         .fxattrop    = posix_fxattrop,
         .setattr     = posix_setattr,
         .fsetattr    = posix_fsetattr,
+        .fallocate   = posix_glfallocate,
+        .discard     = posix_discard,
+        .zerofill    = posix_zerofill,
+        .seek        = posix_seek,
 };
 
 struct xlator_cbks cbks = {
@@ -4480,6 +5233,22 @@ struct volume_options options[] = {
 	  .default_value = "off",
           .description = "Support for native Linux AIO"
 	},
+	{
+	  .key  = {"io-uring"},
+	  .type = GF_OPTION_TYPE_BOOL,
+	  .default_value = "off",
+          .description = "Asynchronous reads, writes, fsyncs, fstats and "
+                         "opens through io_uring, buffered as well as "
+                         "direct. Takes precedence over linux-aio."
+	},
+	{
+	  .key  = {"io-uring-fixed-buffers"},
+	  .type = GF_OPTION_TYPE_BOOL,
+	  .default_value = "off",
+          .description = "Register the iobuf arenas with io_uring, reads "
+                         "into them skip the pinning of their pages. The "
+                         "registered memory counts against RLIMIT_MEMLOCK."
+	},
         {
           .key = {"brick-uid"},
           .type = GF_OPTION_TYPE_INT,
@@ -4490,5 +5259,136 @@ struct volume_options options[] = {
           .type = GF_OPTION_TYPE_INT,
           .description = "Support for setting gid of brick's root"
         },
+        { .key  = {"handle-cache-size"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 0,
+          .max  = 1048576,
+          .default_value = "4096",
+          .description = "Number of directory gfid handles whose resolved "
+                         "path and directory fd are kept in memory, saving "
+                         "the walk of the handle symlinks on every access "
+                         "by gfid. Each entry holds a file descriptor. 0 "
+                         "disables the cache."
+        },
+        { .key  = {"readdirp-threads"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 0,
+          .max  = 16,
+          .default_value = "4",
+          .description = "Number of threads filling the stat and xattrs of "
+                         "large readdirp batches along with the thread "
+                         "serving the readdirp. 0 fills every batch in the "
+                         "serving thread. Takes effect on brick restart."
+        },
+        { .key  = {"batch-fsync-delay-usec"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 0,
+          .max  = 1000000,
+          .default_value = "0",
+          .description = "Longest time an fsync waits for others to be "
+                         "synced together with it. The actual window adapts "
+                         "between a sixteenth of it and it, following how "
+                         "many fsyncs arrive together. 0 syncs every fsync "
+                         "on its own."
+        },
+        { .key  = {"xattrop-cache"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Keep the values changed by xattrop in memory and "
+                         "persist them through a journal in the handle "
+                         "directory, written back to the xattrs at every "
+                         "flush interval. Takes effect on brick restart."
+        },
+        { .key  = {"xattrop-flush-interval"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 1,
+          .max  = 3600,
+          .default_value = "5",
+          .description = "Seconds between two write backs of the cached "
+                         "xattrop values, bounding the journal to replay "
+                         "after a crash."
+        },
+        { .key  = {"batch-fsync-mode"},
+          .type = GF_OPTION_TYPE_STR,
+          .default_value = "fsync",
+          .value = { "fsync", "syncfs" },
+          .description = "fsync syncs each file of a batch once, syncfs "
+                         "syncs the whole brick filesystem once per batch."
+        },
+        { .key  = {"create-tmpfile"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Create files as unnamed O_TMPFILE inodes which "
+                         "get their gfid, handle and xattrs before their "
+                         "name is linked in. Falls back to the regular "
+                         "create where the backend does not support it."
+        },
+        { .key  = {"scrub"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Keep a checksum of every file in an xattr, taken "
+                         "when it is closed after writes, and verify the "
+                         "files in the background. Copies which fail are "
+                         "queued for self-heal and their reads fail with "
+                         "EIO. Takes effect on brick restart."
+        },
+        { .key  = {"scrub-max-rate"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 0,
+          .max  = 65536,
+          .default_value = "8",
+          .description = "MB per second read by the scrubber at most, 0 "
+                         "for no cap."
+        },
+        { .key  = {"scrub-idle-msec"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 0,
+          .max  = 60000,
+          .default_value = "200",
+          .description = "Milliseconds without client reads or writes on "
+                         "the brick before the scrubber reads, 0 to read "
+                         "regardless of client I/O."
+        },
+        { .key  = {"scrub-interval"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 60,
+          .max  = 31536000,
+          .default_value = "86400",
+          .description = "Seconds from the end of a scrub pass to the start "
+                         "of the next one."
+        },
+        { .key  = {"reclaim"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Move large files to the landfill on unlink and "
+                         "free their space from background threads, so the "
+                         "unlink does not wait for the backend to free "
+                         "their extents. Files still open on the brick are "
+                         "unlinked inline. Takes effect on brick restart."
+        },
+        { .key  = {"reclaim-threads"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 1,
+          .max  = POSIX_RECLAIM_MAX_THREADS,
+          .default_value = "2",
+          .description = "Threads freeing the space of unlinked files. "
+                         "Takes effect on brick restart."
+        },
+        { .key  = {"reclaim-min-size"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .min  = 0,
+          .max  = 1 * GF_UNIT_PB,
+          .default_value = "64MB",
+          .description = "Space allocated to a file from which its unlink "
+                         "is left to the reclaimer."
+        },
+        { .key  = {"reclaim-max-rate"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 0,
+          .max  = 1048576,
+          .default_value = "512",
+          .description = "MB per second freed by the reclaimer threads "
+                         "together at most, 0 for no cap."
+        },
         { .key  = {NULL} }
 };
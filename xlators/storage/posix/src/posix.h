@@ -49,6 +49,14 @@
 #include "posix-aio.h"
 #endif
 
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+#include "posix-uring.h"
+#include "posix-xattrop.h"
+#include "posix-scrub.h"
+#include "posix-reclaim.h"
+
 /**
  * posix_fd - internal structure common to file and directory fd's
  */
@@ -59,6 +67,7 @@ struct posix_fd {
 	DIR *   dir;     /* handle returned by the kernel */
         int     flushwrites;
         int     odirect;
+        int     scrub_dirty; /* checksum dropped by a write */
         struct list_head list; /* to add to the janitor list */
 };
 
@@ -115,6 +124,9 @@ struct posix_private {
 
         struct stat     handledir;
 
+/* resolved paths and fds of directory handles, NULL when disabled */
+        struct posix_handle_cache *handle_cache;
+
 /* uuid of glusterd that swapned the brick process */
         uuid_t glusterd_uuid;
 
@@ -125,6 +137,104 @@ struct posix_private {
         io_context_t    ctxp;
         pthread_t       aiothread;
 #endif
+
+	gf_boolean_t    uring_configured;
+	gf_boolean_t    uring_init_done;
+	gf_boolean_t    uring_capable;
+	gf_boolean_t    uring_fixed_buffers;
+#ifdef HAVE_LIBURING
+        struct io_uring     ring;
+        pthread_t           uring_thread;
+        gf_lock_t           uring_lock;    /* queue, completions, counters */
+        struct list_head    uring_queue;   /* requests not in the ring yet */
+        gf_boolean_t        uring_submitting;
+        gf_boolean_t        uring_fixed_changed; /* for the submitter */
+        struct iobuf_arena *uring_fixed[POSIX_URING_MAX_FIXED];
+        int                 uring_nr_fixed;
+        uint64_t            uring_submits;   /* io_uring_enter calls */
+        uint64_t            uring_submitted; /* sqes handed to the kernel */
+        uint64_t            uring_reaps;
+        uint64_t            uring_reaped;
+#endif
+
+/* workers which fill the stat and xattrs of large readdirp batches */
+        int32_t           readdirp_threads;
+        pthread_t        *readdirp_workers;
+        pthread_mutex_t   readdirp_lock;
+        pthread_cond_t    readdirp_cond;
+        struct list_head  readdirp_jobs;
+        gf_boolean_t      readdirp_fini;
+
+/* group commit of fsyncs, disabled while batch_fsync_delay_usec is 0 */
+        uint32_t          batch_fsync_delay_usec;
+        gf_boolean_t      batch_fsync_syncfs;  /* one syncfs per batch */
+        uint32_t          batch_fsync_window;  /* adaptive, in usec */
+        pthread_t         fsyncer;
+        gf_boolean_t      fsyncer_present;
+        gf_boolean_t      fsyncer_fini;
+        pthread_mutex_t   fsync_lock;
+        pthread_cond_t    fsync_cond;
+        struct list_head  fsyncs;
+        int               fsync_queue_count;
+        uint64_t          fsync_batches;
+        uint64_t          fsync_batched;       /* requests in all batches */
+        uint64_t          fsync_syscalls;
+
+/* xattrop values kept in memory and journaled, NULL when disabled */
+        struct posix_xattrop_cache *xattrop_cache;
+
+/* creates through an unnamed O_TMPFILE inode, linked in once its gfid,
+   handle and xattrs are set */
+        gf_boolean_t      create_tmpfile;
+        char             *handle_dirs;       /* .glusterfs/xx/yy known to exist */
+        uint64_t          tmpfile_creates;
+        uint64_t          tmpfile_fallbacks;
+
+/* background checksumming of the files, NULL when disabled */
+        struct posix_scrub *scrub;
+
+/* unlinks of large files handed over to the reclaimer threads, NULL when
+   disabled */
+        struct posix_reclaim *reclaim;
+};
+
+/* one flag per .glusterfs/xx/yy handle directory */
+#define POSIX_HANDLE_DIRS 65536
+
+/* upper bound of the fsyncs synced together by the fsyncer */
+#define POSIX_FSYNC_BATCH_MAX 256
+
+/* an fsync waiting for the next batch of the fsyncer */
+struct posix_fsync_req {
+        struct list_head  list;
+        call_frame_t     *frame;
+        fd_t             *fd;
+        int               _fd;
+        int               datasync;
+        struct iatt       preop;
+        int32_t           op_ret;
+        int32_t           op_errno;
+};
+
+/* a readdirp batch, split in slices filled by the readdirp workers and
+ * by the thread which issued the readdirp */
+struct posix_readdirp_batch {
+        fd_t             *fd;
+        int               dirfd;
+        const char       *hpath;     /* handle path of the directory */
+        int               hlen;
+        gf_dirent_t     **entries;
+        dict_t           *dict;
+        int               pending;   /* slices not yet filled */
+        pthread_mutex_t   lock;
+        pthread_cond_t    cond;
+};
+
+struct posix_readdirp_job {
+        struct list_head             list;
+        struct posix_readdirp_batch *batch;
+        int                          start;
+        int                          end;
 };
 
 #define POSIX_BASE_PATH(this) (((struct posix_private *)this->private)->base_path)
@@ -141,11 +251,23 @@ int posix_pstat (xlator_t *this, uuid_t gfid, const char *real_path,
                  struct iatt *iatt);
 dict_t *posix_lookup_xattr_fill (xlator_t *this, const char *path,
                                  loc_t *loc, dict_t *xattr, struct iatt *buf);
+int posix_entry_at_fill (xlator_t *this, int dirfd, const char *name,
+                         const char *real_path, uuid_t gfid, loc_t *loc,
+                         dict_t *xattr_req, struct iatt *buf_p,
+                         dict_t **xattr_p);
 int posix_handle_pair (xlator_t *this, const char *real_path, char *key,
                        data_t *value, int flags);
 int posix_fhandle_pair (xlator_t *this, int fd, char *key, data_t *value,
                         int flags);
 void posix_spawn_janitor_thread (xlator_t *this);
+int posix_spawn_readdirp_workers (xlator_t *this);
+void posix_stop_readdirp_workers (xlator_t *this);
+void posix_readdirp_fill_slice (xlator_t *this,
+                                struct posix_readdirp_job *job);
+int posix_spawn_fsyncer_thread (xlator_t *this);
+void posix_stop_fsyncer_thread (xlator_t *this);
+int posix_fsync_queue (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                       int _fd, int datasync, struct iatt *preop);
 int posix_get_file_contents (xlator_t *this, uuid_t pargfid,
                              const char *name, char **contents);
 int posix_set_file_contents (xlator_t *this, const char *path, char *key,
@@ -154,11 +276,17 @@ int posix_acl_xattr_set (xlator_t *this, const char *path, dict_t *xattr_req);
 int posix_gfid_heal (xlator_t *this, const char *path, dict_t *xattr_req);
 int posix_entry_create_xattr_set (xlator_t *this, const char *path,
                                   dict_t *dict);
+int posix_acl_xattr_fset (xlator_t *this, int fd, dict_t *xattr_req);
+int posix_entry_create_fxattr_set (xlator_t *this, int fd, dict_t *dict);
+int posix_create_tmpfile (xlator_t *this, const char *par_path,
+                          const char *real_path, int flags, mode_t mode,
+                          uid_t uid, gid_t gid, dict_t *xdata);
 
 int posix_fd_ctx_get (fd_t *fd, xlator_t *this, struct posix_fd **pfd);
 int posix_fd_ctx_get_off (fd_t *fd, xlator_t *this, struct posix_fd **pfd,
                           off_t off);
 void posix_fill_ino_from_gfid (xlator_t *this, struct iatt *buf);
+int posix_fill_gfid_fd (xlator_t *this, int fd, struct iatt *iatt);
 
 gf_boolean_t posix_special_xattr (char **pattern, char *key);
 #endif /* _POSIX_H */